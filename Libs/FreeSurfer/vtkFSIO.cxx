@@ -18,6 +18,9 @@
 // VTK includes
 #include <vtkByteSwap.h>
 
+// STD includes
+#include <vector>
+
 //------------------------------------------------------------------------------
 int vtkFSIO::ReadShort (FILE* iFile, short& oShort) {
 
@@ -157,6 +160,67 @@ int vtkFSIO::ReadFloatZ (gzFile iFile, float& oFloat) {
   return result;
 }
 
+//------------------------------------------------------------------------------
+int vtkFSIO::ReadShortBlock (FILE* iFile, short* oShorts, int iCount) {
+
+  if (iCount <= 0) {
+    return 0;
+  }
+
+  // Read all the shorts at once, then swap the whole range.
+  int result = static_cast<int>(fread (oShorts, sizeof(short), iCount, iFile));
+  vtkByteSwap::Swap2BERange (oShorts, result);
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+int vtkFSIO::ReadIntBlock (FILE* iFile, int* oInts, int iCount) {
+
+  if (iCount <= 0) {
+    return 0;
+  }
+
+  // Read all the ints at once, then swap the whole range.
+  int result = static_cast<int>(fread (oInts, sizeof(int), iCount, iFile));
+  vtkByteSwap::Swap4BERange (oInts, result);
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+int vtkFSIO::ReadInt3Block (FILE* iFile, int* oInts, int iCount) {
+
+  if (iCount <= 0) {
+    return 0;
+  }
+
+  // Read all the three byte ints at once and assemble them from their
+  // big endian bytes, this does not depend on the host byte order.
+  std::vector<unsigned char> bytes (3 * static_cast<size_t>(iCount));
+  int result = static_cast<int>(fread (&bytes[0], 3, iCount, iFile));
+  const unsigned char* b = &bytes[0];
+  for (int i = 0; i < result; i++, b += 3) {
+    oInts[i] = (b[0] << 16) | (b[1] << 8) | b[2];
+  }
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+int vtkFSIO::ReadFloatBlock (FILE* iFile, float* oFloats, int iCount) {
+
+  if (iCount <= 0) {
+    return 0;
+  }
+
+  // Read all the floats at once, then swap the whole range.
+  int result = static_cast<int>(fread (oFloats, sizeof(float), iCount, iFile));
+  vtkByteSwap::Swap4BERange (oFloats, result);
+
+  return result;
+}
+
 //------------------------------------------------------------------------------
 // Utility methods for writing test files
 
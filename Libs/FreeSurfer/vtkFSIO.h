@@ -43,6 +43,13 @@ namespace vtkFSIO {
   int VTK_FreeSurfer_EXPORT ReadInt2Z (gzFile iFile, int& oInt);
   int VTK_FreeSurfer_EXPORT ReadFloatZ (gzFile iFile, float& oFloat);
 
+  /// Read a block of iCount big endian values with a single fread and
+  /// swap them in place. Return the number of values read.
+  int VTK_FreeSurfer_EXPORT ReadShortBlock (FILE* iFile, short* oShorts, int iCount);
+  int VTK_FreeSurfer_EXPORT ReadIntBlock (FILE* iFile, int* oInts, int iCount);
+  int VTK_FreeSurfer_EXPORT ReadInt3Block (FILE* iFile, int* oInts, int iCount);
+  int VTK_FreeSurfer_EXPORT ReadFloatBlock (FILE* iFile, float* oFloats, int iCount);
+
   /// For testing purposes
   int VTK_FreeSurfer_EXPORT WriteInt (FILE* iFile, int iInt);
   int VTK_FreeSurfer_EXPORT WriteInt3 (FILE* iFile, int iInt);
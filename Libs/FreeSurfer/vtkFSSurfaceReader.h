@@ -24,10 +24,6 @@
 /// Prints debugging info.
 #define FS_DEBUG 0
 
-/// This code can calc normals but it doesn't seem to do so very well
-/// (bug?) and vtkPolyDataNormals does it anyway.
-#define FS_CALC_NORMALS 0
-
 class vtkInformation;
 class vtkInformationVector;
 class vtkPolyData;
@@ -84,22 +80,4 @@ private:
   void operator=(const vtkFSSurfaceReader&);  /// Not implemented.
 };
 
-
-/// If we're going to try to do normals, we need to keep some
-/// connectivity information for the verts and faces. Use these
-/// structures.
-#if FS_CALC_NORMALS
-typedef struct {
-  int numFaces;
-  int faces[FS_MAX_NUM_FACES_PER_VERTEX];
-  int indicesInFace[FS_MAX_NUM_FACES_PER_VERTEX];
-  float x, y, z;
-  float nx, ny, nz;
-} Vertex;
-
-typedef struct {
-  int vertices[FS_NUM_SIDES_IN_FACE];
-} Face;
-#endif
-
 #endif
@@ -21,6 +21,9 @@
 #include <vtkFloatArray.h>
 #include <vtkObjectFactory.h>
 
+// STD includes
+#include <vector>
+
 //-------------------------------------------------------------------------
 vtkStandardNewMacro(vtkFSSurfaceScalarReader);
 
@@ -56,8 +59,7 @@ int vtkFSSurfaceScalarReader::ReadFSScalars()
   int numFaces = 0;
   int numValuesPerPoint = 0;
   int vIndex;
-  int ivalue;
-  float fvalue;
+  int read;
   float *FSscalars;
   vtkFloatArray *output = this->Scalars;
 
@@ -130,56 +132,52 @@ int vtkFSSurfaceScalarReader::ReadFSScalars()
     numValues = magicNumber;
   }
 
-  if (numValues <= 0) {
-    vtkErrorMacro (<< "vtkFSSurfaceScalarReader.cxx Execute: Number of vertices is 0 or negative, can't process file.");
-      return 0;
+  if (numValues < 0) {
+    vtkErrorMacro (<< "vtkFSSurfaceScalarReader.cxx Execute: Number of vertices is negative, can't process file.");
+    fclose (scalarFile);
+    return 0;
   }
 
-  // Make our float array.
-  FSscalars = (float*) calloc (numValues, sizeof(float));
-
-  // For each value, if it's a new style file read a float, otherwise
-  // read a two byte int and divide it by 100. Add this value to the
-  // array.
-  for (vIndex = 0; vIndex < numValues; vIndex ++ ) {
+  // Nothing to read, malloc(0) may return NULL that is not an
+  // allocation failure.
+  if (numValues == 0) {
+    fclose (scalarFile);
+    output->SetNumberOfTuples (0);
+    return 1;
+  }
 
-    if (feof(scalarFile)) {
-      vtkErrorMacro (<< "vtkFSSurfaceScalarReader.cxx Execute: Unexpected EOF after " << vIndex << " values read.");
-      return 0;
-    }
+  // Make our float array.
+  FSscalars = (float*) malloc (numValues * sizeof(float));
+  if (FSscalars == NULL) {
+    vtkErrorMacro (<< "vtkFSSurfaceScalarReader.cxx Execute: error allocating " << numValues << " floats.");
+    fclose (scalarFile);
+    return 0;
+  }
 
-    if (this->FS_NEW_SCALAR_MAGIC_NUMBER == magicNumber) {
-      size_t retval = fread (&fvalue, sizeof(float), 1, scalarFile);
-      if (retval == 1)
-        {
-        vtkByteSwap::Swap4BE (&fvalue);
-        }
-      else
-        {
-        vtkErrorMacro("Error reading fvalue from file " << this->FileName);
-        }
-
-    } else {
-      vtkFSIO::ReadInt2 (scalarFile, ivalue);
-      fvalue = ivalue / 100.0;
+  // Read all the values at once. If it's a new style file they are
+  // floats, otherwise they are two byte ints to divide by 100.
+  if (this->FS_NEW_SCALAR_MAGIC_NUMBER == magicNumber) {
+    read = vtkFSIO::ReadFloatBlock (scalarFile, FSscalars, numValues);
+  } else {
+    std::vector<short> svalues (numValues);
+    read = svalues.empty() ? 0 : vtkFSIO::ReadShortBlock (scalarFile, &svalues[0], numValues);
+    for (vIndex = 0; vIndex < read; vIndex ++ ) {
+      FSscalars[vIndex] = svalues[vIndex] / 100.0;
     }
+  }
 
-    FSscalars[vIndex] = fvalue;
-
-    if (numValues < 10000 ||
-        (vIndex % 100) == 0)
-    {
-        this->UpdateProgress(1.0*vIndex/numValues);
-    }
+  // Close the file.
+  fclose (scalarFile);
 
+  if (read != numValues) {
+    vtkErrorMacro (<< "vtkFSSurfaceScalarReader.cxx Execute: Unexpected EOF after " << read << " values read.");
+    free (FSscalars);
+    return 0;
   }
 
   this->SetProgressText("");
   this->UpdateProgress(0.0);
 
-  // Close the file.
-  fclose (scalarFile);
-
   // Set the array in our output.
   output->SetArray (FSscalars, numValues, 0);
 
@@ -17,9 +17,14 @@
 #include "vtkFSSurfaceWFileReader.h"
 
 // VTK includes
+#include <vtkByteSwap.h>
 #include <vtkFloatArray.h>
 #include <vtkObjectFactory.h>
 
+// STD includes
+#include <cstring>
+#include <vector>
+
 //-------------------------------------------------------------------------
 vtkStandardNewMacro(vtkFSSurfaceWFileReader);
 
@@ -99,6 +104,7 @@ int vtkFSSurfaceWFileReader::ReadWFile()
   if (numValues < 0)
     {
     vtkErrorMacro (<< "vtkFSSurfaceWFileReader.cxx Execute: Number of vertices is 0 or negative, can't process file.");
+    fclose (wFile);
     return this->FS_ERROR_W_NUM_VALUES;
     }
 
@@ -120,29 +126,42 @@ int vtkFSSurfaceWFileReader::ReadWFile()
   if (FSscalars == NULL)
     {
     vtkErrorMacro(<<"vtkFSSurfaceWFileReader: error allocating " << this->NumberOfVertices << " floats!");
+    fclose (wFile);
     return this->FS_ERROR_W_ALLOC;
     }
 
-  // For each value in the wfile...
-  for (vIndex = 0; vIndex < numValues; vIndex ++ )
+  // Read all the index/value pairs at once. The wfile is weird in
+  // that there is a 3 byte int index and a float value for every
+  // value. I guess this means that the wfile could have fewer values
+  // than the number of vertices in the surface, but I've never seen
+  // this happen in practice. Additionally, these are usually written
+  // with indices from 0->nvertices, so this index value isn't even
+  // really needed.
+  const size_t pairSize = 3 + sizeof(float);
+  std::vector<unsigned char> pairs (pairSize * numValues);
+  size_t numPairsRead = 0;
+  if (numValues > 0)
     {
+    numPairsRead = fread (&pairs[0], pairSize, numValues, wFile);
+    }
 
-    // Check for eof.
-    if (feof(wFile))
-      {
-      vtkErrorMacro (<< "vtkFSSurfaceWFileReader.cxx Execute: Unexpected EOF after " << vIndex << " values read. Tried to read " << numValues);
-      return this->FS_ERROR_W_EOF;
-      }
+  // Close the file.
+  fclose (wFile);
+
+  if (numPairsRead != static_cast<size_t>(numValues))
+    {
+    vtkErrorMacro (<< "vtkFSSurfaceWFileReader.cxx Execute: Unexpected EOF after " << numPairsRead << " values read. Tried to read " << numValues);
+    free (FSscalars);
+    return this->FS_ERROR_W_EOF;
+    }
 
-    // Read the 3 byte int index and float value. The wfile is weird
-    // in that there is an index/value pair for every value. I guess
-    // this means that the wfile could have fewer values than the
-    // number of vertices in the surface, but I've never seen this
-    // happen in practice. Additionally, these are usually written
-    // with indices from 0->nvertices, so this index value isn't even
-    // really needed.
-    vtkFSIO::ReadInt3 (wFile, vIndexFromFile);
-    vtkFSIO::ReadFloat (wFile, fvalue);
+  // For each value in the wfile...
+  const unsigned char* pair = pairs.empty() ? NULL : &pairs[0];
+  for (vIndex = 0; vIndex < numValues; vIndex ++, pair += pairSize )
+    {
+    vIndexFromFile = (pair[0] << 16) | (pair[1] << 8) | pair[2];
+    memcpy (&fvalue, pair + 3, sizeof(float));
+    vtkByteSwap::Swap4BE (&fvalue);
 
     // Make sure the index is in bounds. If not, print a warning and
     // try to do the next value. If this happens, there is probably a
@@ -159,20 +178,11 @@ int vtkFSSurfaceWFileReader::ReadWFile()
     // Set the value in the scalars array based on the index we read
     // in, not the index in our for loop.
     FSscalars[vIndexFromFile] = fvalue;
-
-    if (numValues < 10000 ||
-        (vIndex % 100) == 0)
-      {
-      this->UpdateProgress(1.0*vIndex/numValues);
-      }
     }
 
   this->SetProgressText("");
   this->UpdateProgress(0.0);
 
-  // Close the file.
-  fclose (wFile);
-
   // Set the array in our output.
   //output->SetArray (FSscalars, numValues, 0);
   output->SetArray(FSscalars, this->NumberOfVertices, 0);
@@ -0,0 +1,246 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLSegmentationNode.h"
+#include "vtkMRMLSegmentationStorageNode.h"
+
+// Segmentations includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <sstream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Add a segment that contains a box in a 20x20x20 labelmap
+void AddBoxSegment(vtkSegmentation* segmentation, const std::string& segmentId, int boxExtent[6])
+{
+  vtkNew<vtkOrientedImageData> labelmap;
+  labelmap->SetExtent(0, 19, 0, 19, 0, 19);
+  labelmap->SetSpacing(1.5, 1.0, 2.0);
+  labelmap->SetOrigin(10.0, -20.0, 5.0);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkOrientedImageDataResample::FillImage(labelmap.GetPointer(), 0);
+  vtkOrientedImageDataResample::FillImage(labelmap.GetPointer(), 1, boxExtent);
+  vtkNew<vtkSegment> segment;
+  segment->SetName(segmentId.c_str());
+  segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), labelmap.GetPointer());
+  segmentation->AddSegment(segment.GetPointer(), segmentId);
+}
+
+//----------------------------------------------------------------------------
+// Add a segment whose labelmap contains a single voxel, in the same geometry as the box segments
+void AddVoxelSegment(vtkSegmentation* segmentation, const std::string& segmentId, int voxelExtent[6])
+{
+  vtkNew<vtkOrientedImageData> labelmap;
+  labelmap->SetExtent(voxelExtent);
+  labelmap->SetSpacing(1.5, 1.0, 2.0);
+  labelmap->SetOrigin(10.0, -20.0, 5.0);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkOrientedImageDataResample::FillImage(labelmap.GetPointer(), 1);
+  vtkNew<vtkSegment> segment;
+  segment->SetName(segmentId.c_str());
+  segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), labelmap.GetPointer());
+  segmentation->AddSegment(segment.GetPointer(), segmentId);
+}
+
+//----------------------------------------------------------------------------
+// Check that the segment read from file contains exactly the voxels of the box
+int CheckBoxSegment(vtkSegmentation* segmentation, const std::string& segmentId, int boxExtent[6])
+{
+  vtkNew<vtkOrientedImageData> labelmap;
+  CHECK_BOOL(segmentation->GetBinaryLabelmapRepresentation(segmentId, labelmap.GetPointer()), true);
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  labelmap->GetExtent(extent);
+  int numberOfVoxelsInBox = 0;
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        bool inBox = (i >= boxExtent[0] && i <= boxExtent[1] && j >= boxExtent[2] && j <= boxExtent[3]
+          && k >= boxExtent[4] && k <= boxExtent[5]);
+        int value = static_cast<int>(labelmap->GetScalarComponentAsDouble(i, j, k, 0));
+        if (value != (inBox ? 1 : 0))
+          {
+          std::cerr << "Segment " << segmentId << ": unexpected value " << value << " at (" << i << ", " << j << ", " << k << ")" << std::endl;
+          return EXIT_FAILURE;
+          }
+        if (inBox)
+          {
+          numberOfVoxelsInBox++;
+          }
+        }
+      }
+    }
+  int expectedNumberOfVoxelsInBox = (boxExtent[1] - boxExtent[0] + 1) * (boxExtent[3] - boxExtent[2] + 1) * (boxExtent[5] - boxExtent[4] + 1);
+  CHECK_INT(numberOfVoxelsInBox, expectedNumberOfVoxelsInBox);
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestWriteReadOverlappingSegments(const char* tempDir, bool collapseLabelmaps)
+{
+  // Segment_1 and Segment_2 overlap, Segment_3 does not overlap any of them
+  int box1[6] = { 2, 8, 2, 8, 2, 8 };
+  int box2[6] = { 6, 12, 5, 10, 4, 9 };
+  int box3[6] = { 14, 17, 14, 18, 12, 16 };
+
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetRootDirectory(tempDir);
+  vtkNew<vtkMRMLSegmentationNode> segmentationNode;
+  CHECK_NOT_NULL(scene->AddNode(segmentationNode.GetPointer()));
+  vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
+  segmentation->SetMasterRepresentationName(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName());
+  AddBoxSegment(segmentation, "Segment_1", box1);
+  AddBoxSegment(segmentation, "Segment_2", box2);
+  AddBoxSegment(segmentation, "Segment_3", box3);
+
+  vtkNew<vtkMRMLSegmentationStorageNode> storageNode;
+  CHECK_NOT_NULL(scene->AddNode(storageNode.GetPointer()));
+  std::string fileName = std::string(tempDir) + (collapseLabelmaps
+    ? "/vtkMRMLSegmentationStorageNodeTest1_collapsed.seg.nrrd" : "/vtkMRMLSegmentationStorageNodeTest1.seg.nrrd");
+  storageNode->SetFileName(fileName.c_str());
+  storageNode->SetCollapseLabelmaps(collapseLabelmaps);
+  CHECK_BOOL(storageNode->WriteData(segmentationNode.GetPointer()), true);
+
+  // Read into a new segmentation node, segmentation must be empty for reading
+  vtkNew<vtkMRMLSegmentationNode> readSegmentationNode;
+  CHECK_NOT_NULL(scene->AddNode(readSegmentationNode.GetPointer()));
+  CHECK_BOOL(storageNode->ReadData(readSegmentationNode.GetPointer()), true);
+  vtkSegmentation* readSegmentation = readSegmentationNode->GetSegmentation();
+  CHECK_INT(readSegmentation->GetNumberOfSegments(), 3);
+  CHECK_EXIT_SUCCESS(CheckBoxSegment(readSegmentation, "Segment_1", box1));
+  CHECK_EXIT_SUCCESS(CheckBoxSegment(readSegmentation, "Segment_2", box2));
+  CHECK_EXIT_SUCCESS(CheckBoxSegment(readSegmentation, "Segment_3", box3));
+
+  if (collapseLabelmaps)
+    {
+    // Non-overlapping segments share a layer, overlapping segment is written to a separate layer
+    CHECK_INT(readSegmentation->GetNumberOfLayers(), 2);
+    CHECK_INT(readSegmentation->GetLayerIndex("Segment_1"), readSegmentation->GetLayerIndex("Segment_3"));
+    CHECK_BOOL(readSegmentation->GetLayerIndex("Segment_1") != readSegmentation->GetLayerIndex("Segment_2"), true);
+    }
+  else
+    {
+    // Each segment is written to a separate volume
+    CHECK_INT(readSegmentation->GetNumberOfLayers(), 3);
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+// More non-overlapping segments than label values that fit in an unsigned char layer
+int TestWriteReadManySegments(const char* tempDir)
+{
+  const int numberOfSegments = 300;
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetRootDirectory(tempDir);
+  vtkNew<vtkMRMLSegmentationNode> segmentationNode;
+  CHECK_NOT_NULL(scene->AddNode(segmentationNode.GetPointer()));
+  vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
+  segmentation->SetMasterRepresentationName(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName());
+  for (int segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+    {
+    int voxelExtent[6] = { segmentIndex % 20, segmentIndex % 20, segmentIndex / 20, segmentIndex / 20, 0, 0 };
+    std::stringstream segmentId;
+    segmentId << "Voxel_" << segmentIndex;
+    AddVoxelSegment(segmentation, segmentId.str(), voxelExtent);
+    }
+
+  vtkNew<vtkMRMLSegmentationStorageNode> storageNode;
+  CHECK_NOT_NULL(scene->AddNode(storageNode.GetPointer()));
+  std::string fileName = std::string(tempDir) + "/vtkMRMLSegmentationStorageNodeTest1_many.seg.nrrd";
+  storageNode->SetFileName(fileName.c_str());
+  storageNode->SetCollapseLabelmaps(true);
+  CHECK_BOOL(storageNode->WriteData(segmentationNode.GetPointer()), true);
+
+  vtkNew<vtkMRMLSegmentationNode> readSegmentationNode;
+  CHECK_NOT_NULL(scene->AddNode(readSegmentationNode.GetPointer()));
+  CHECK_BOOL(storageNode->ReadData(readSegmentationNode.GetPointer()), true);
+  vtkSegmentation* readSegmentation = readSegmentationNode->GetSegmentation();
+  CHECK_INT(readSegmentation->GetNumberOfSegments(), numberOfSegments);
+  for (int segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+    {
+    int voxelExtent[6] = { segmentIndex % 20, segmentIndex % 20, segmentIndex / 20, segmentIndex / 20, 0, 0 };
+    std::stringstream segmentId;
+    segmentId << "Voxel_" << segmentIndex;
+    CHECK_EXIT_SUCCESS(CheckBoxSegment(readSegmentation, segmentId.str(), voxelExtent));
+    }
+
+  // The first 255 segments fill the first layer, the rest goes to a second layer
+  CHECK_INT(readSegmentation->GetNumberOfLayers(), 2);
+  CHECK_INT(readSegmentation->GetLayerIndex("Voxel_0"), readSegmentation->GetLayerIndex("Voxel_254"));
+  CHECK_INT(readSegmentation->GetLayerIndex("Voxel_255"), readSegmentation->GetLayerIndex("Voxel_299"));
+  CHECK_BOOL(readSegmentation->GetLayerIndex("Voxel_0") != readSegmentation->GetLayerIndex("Voxel_255"), true);
+
+  // Each layer is cropped to the extents of its segments
+  int expectedLayerExtents[2][6] = { { 0, 19, 0, 12, 0, 0 }, { 0, 19, 12, 14, 0, 0 } };
+  const char* layerSegmentIds[2] = { "Voxel_0", "Voxel_255" };
+  for (int layer = 0; layer < 2; ++layer)
+    {
+    vtkOrientedImageData* layerLabelmap = vtkOrientedImageData::SafeDownCast(
+      readSegmentation->GetSegment(layerSegmentIds[layer])->GetRepresentation(
+      vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
+    CHECK_NOT_NULL(layerLabelmap);
+    int* layerExtent = layerLabelmap->GetExtent();
+    for (int i = 0; i < 6; i++)
+      {
+      CHECK_INT(layerExtent[i], expectedLayerExtents[layer][i]);
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkMRMLSegmentationStorageNodeTest1(int argc, char * argv[] )
+{
+  if (argc != 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkMRMLSegmentationStorageNode> node1;
+  EXERCISE_ALL_BASIC_MRML_METHODS(node1.GetPointer());
+
+  // Labelmaps are not collapsed by default, so that files can be read by applications that do not know about layers
+  CHECK_BOOL(node1->GetCollapseLabelmaps(), false);
+
+  const char* tempDir = argv[1];
+  CHECK_EXIT_SUCCESS(TestWriteReadOverlappingSegments(tempDir, false));
+  CHECK_EXIT_SUCCESS(TestWriteReadOverlappingSegments(tempDir, true));
+  CHECK_EXIT_SUCCESS(TestWriteReadManySegments(tempDir));
+
+  return EXIT_SUCCESS;
+}
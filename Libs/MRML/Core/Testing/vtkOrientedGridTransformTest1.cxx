@@ -22,6 +22,7 @@
 #include "vtkImageData.h"
 #include "vtkMatrix4x4.h"
 #include "vtkNew.h"
+#include "vtkPoints.h"
 
 typedef double itkVectorComponentType;
 typedef itk::Vector<itkVectorComponentType, 3> itkVectorPixelType;
@@ -324,6 +325,7 @@ int vtkOrientedGridTransformTest1(int , char * [] )
   int numberOfSingleDoubleVtkPointMismatches=0;
   int numberOfDerivativeMismatches=0;
   int numberOfInverseMismatches=0;
+  int numberOfBatchInverseMismatches=0;
 
   // We take samples in the grid region (first node + 2 < node < last node - 1)
   // because the boundaries are handled differently in ITK and VTK (in ITK there is an
@@ -418,13 +420,61 @@ int vtkOrientedGridTransformTest1(int , char * [] )
       }
     }
 
+  // Verify batch inverse transform (computed on multiple threads, with warm start)
+  vtkNew<vtkPoints> inputPoints;
+  for (double k=startK+incK; k<=endK-incK; k+=incK)
+    {
+    for (double j=startJ+incJ; j<=endJ-incJ; j+=incJ)
+      {
+      for (double i=startI+incI; i<=endI-incI; i+=incI)
+        {
+        double inputPoint[3];
+        inputPoint[0] = origin[0]+direction[0][0]*spacing[0]*i+direction[0][1]*spacing[1]*j+direction[0][2]*spacing[2]*k;
+        inputPoint[1] = origin[1]+direction[1][0]*spacing[0]*i+direction[1][1]*spacing[1]*j+direction[1][2]*spacing[2]*k;
+        inputPoint[2] = origin[2]+direction[2][0]*spacing[0]*i+direction[2][1]*spacing[1]*j+direction[2][2]*spacing[2]*k;
+        inputPoints->InsertNextPoint(inputPoint);
+        }
+      }
+    }
+  vtkNew<vtkPoints> transformedPoints;
+  gridVtk->TransformPoints(inputPoints.GetPointer(), transformedPoints.GetPointer());
+  vtkNew<vtkPoints> inversePoints;
+  gridVtk->Inverse();
+  gridVtk->TransformPoints(transformedPoints.GetPointer(), inversePoints.GetPointer());
+  gridVtk->Inverse();
+  CHECK_INT(static_cast<int>(inversePoints->GetNumberOfPoints()), static_cast<int>(inputPoints->GetNumberOfPoints()));
+  for (vtkIdType pointIndex = 0; pointIndex < inputPoints->GetNumberOfPoints(); pointIndex++)
+    {
+    itk::Point<double,3> inputPointVtk( inputPoints->GetPoint(pointIndex) );
+    itk::Point<double,3> inversePointVtk( inversePoints->GetPoint(pointIndex) );
+    if ( inputPointVtk.EuclideanDistanceTo( inversePointVtk ) > gridVtk->GetInverseTolerance()*1.10 )
+      {
+      std::cout << "ERROR: Point transformed by forward and batch inverse transform does not match the original point "
+        << inputPointVtk << " (inverse: " << inversePointVtk << ")" << std::endl;
+      numberOfBatchInverseMismatches++;
+      }
+    }
+
+  // Verify cached inverse grid: the residual error is reported at the grid points
+  gridVtk->UseCachedInverseGridOn();
+  gridVtk->Update();
+  CHECK_NOT_NULL(gridVtk->GetCachedInverseGrid());
+  std::cout << "Cached inverse grid error: maximum = " << gridVtk->GetInverseGridMaximumError()
+    << ", mean = " << gridVtk->GetInverseGridMeanError() << std::endl;
+  CHECK_BOOL(gridVtk->GetInverseGridMeanError() <= gridVtk->GetInverseGridMaximumError(), true);
+  gridVtk->UseCachedInverseGridOff();
+  gridVtk->Update();
+  CHECK_NULL(gridVtk->GetCachedInverseGrid());
+
   std::cout << "Number of points tested: " << numberOfPointsTested << std::endl;
   std::cout << "Number of ITK/VTK mismatches: " << numberOfItkVtkPointMismatches << std::endl;
   std::cout << "Number of single/double precision mismatches: " << numberOfSingleDoubleVtkPointMismatches << std::endl;
   std::cout << "Number of derivative mismatches: " << numberOfDerivativeMismatches << std::endl;
   std::cout << "Number of inverse mismatches: " << numberOfInverseMismatches << std::endl;
+  std::cout << "Number of batch inverse mismatches: " << numberOfBatchInverseMismatches << std::endl;
 
-  if (numberOfItkVtkPointMismatches==0 && numberOfDerivativeMismatches==0 && numberOfInverseMismatches==0)
+  if (numberOfItkVtkPointMismatches==0 && numberOfDerivativeMismatches==0 && numberOfInverseMismatches==0
+    && numberOfBatchInverseMismatches==0)
     {
     std::cout << "Test result: PASSED" << std::endl;
     return EXIT_SUCCESS;
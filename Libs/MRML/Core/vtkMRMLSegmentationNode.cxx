@@ -560,8 +560,14 @@ bool vtkMRMLSegmentationNode::GenerateMergedLabelmap(
       }
 
     // Get binary labelmap from segment
-    vtkOrientedImageData* representationBinaryLabelmap = vtkOrientedImageData::SafeDownCast(
+    vtkSmartPointer<vtkOrientedImageData> representationBinaryLabelmap = vtkOrientedImageData::SafeDownCast(
       currentSegment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) );
+    if (this->Segmentation->IsLayerBinaryLabelmap(currentSegment))
+      {
+      // Labelmap is shared with other segments, only merge the voxels of this segment
+      representationBinaryLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      this->Segmentation->GetBinaryLabelmapRepresentation(currentSegmentId, representationBinaryLabelmap);
+      }
     // If binary labelmap is empty then skip
     if (representationBinaryLabelmap->IsEmpty())
       {
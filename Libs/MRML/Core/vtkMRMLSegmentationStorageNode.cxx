@@ -75,6 +75,8 @@ static const std::string KEY_SEGMENT_NAME = "Name";
 static const std::string KEY_SEGMENT_COLOR = "Color";
 static const std::string KEY_SEGMENT_TAGS = "Tags";
 static const std::string KEY_SEGMENT_EXTENT = "Extent";
+static const std::string KEY_SEGMENT_LAYER = "Layer";
+static const std::string KEY_SEGMENT_LABEL_VALUE = "LabelValue";
 static const std::string KEY_SEGMENTATION_MASTER_REPRESENTATION = "MasterRepresentation";
 static const std::string KEY_SEGMENTATION_CONVERSION_PARAMETERS = "ConversionParameters";
 static const std::string KEY_SEGMENTATION_EXTENT = "Extent"; // Deprecated, kept only for being able to read legacy files.
@@ -82,11 +84,59 @@ static const std::string KEY_SEGMENTATION_REFERENCE_IMAGE_EXTENT_OFFSET = "Refer
 static const std::string KEY_SEGMENTATION_CONTAINED_REPRESENTATION_NAMES = "ContainedRepresentationNames";
 
 static const int SINGLE_SEGMENT_INDEX = -1; // used as segment index when there is only a single segment
+
+//----------------------------------------------------------------------------
+// Returns true if there is a voxel within the extent that is non-zero in both images.
+// Both images are expected to be unsigned char and to have the same extent.
+static bool HasOverlap(vtkImageData* layer, vtkImageData* labelmap, int extent[6])
+{
+  int rowLength = extent[1] - extent[0] + 1;
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      unsigned char* layerPtr = static_cast<unsigned char*>(layer->GetScalarPointer(extent[0], j, k));
+      unsigned char* labelmapPtr = static_cast<unsigned char*>(labelmap->GetScalarPointer(extent[0], j, k));
+      for (int i = 0; i < rowLength; ++i)
+        {
+        if (layerPtr[i] && labelmapPtr[i])
+          {
+          return true;
+          }
+        }
+      }
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+// Set label value in the layer where the labelmap is non-zero (within the extent)
+static void AddToLayer(vtkImageData* layer, vtkImageData* labelmap, int extent[6], int labelValue)
+{
+  int rowLength = extent[1] - extent[0] + 1;
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      unsigned char* layerPtr = static_cast<unsigned char*>(layer->GetScalarPointer(extent[0], j, k));
+      unsigned char* labelmapPtr = static_cast<unsigned char*>(labelmap->GetScalarPointer(extent[0], j, k));
+      for (int i = 0; i < rowLength; ++i)
+        {
+        if (labelmapPtr[i])
+          {
+          layerPtr[i] = static_cast<unsigned char>(labelValue);
+          }
+        }
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLSegmentationStorageNode);
 
 //----------------------------------------------------------------------------
 vtkMRMLSegmentationStorageNode::vtkMRMLSegmentationStorageNode()
+  : CollapseLabelmaps(false)
 {
 }
 
@@ -99,6 +149,7 @@ vtkMRMLSegmentationStorageNode::~vtkMRMLSegmentationStorageNode()
 void vtkMRMLSegmentationStorageNode::PrintSelf(ostream& os, vtkIndent indent)
 {
   vtkMRMLStorageNode::PrintSelf(os,indent);
+  os << indent << "CollapseLabelmaps:   " << (this->CollapseLabelmaps ? "true" : "false") << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -108,6 +159,18 @@ void vtkMRMLSegmentationStorageNode::ReadXMLAttributes(const char** atts)
 
   Superclass::ReadXMLAttributes(atts);
 
+  const char* attName;
+  const char* attValue;
+  while (*atts != NULL)
+    {
+    attName = *(atts++);
+    attValue = *(atts++);
+    if (!strcmp(attName, "collapseLabelmaps"))
+      {
+      this->CollapseLabelmaps = (strcmp(attValue, "true") ? false : true);
+      }
+    }
+
   this->EndModify(disabledModify);
 }
 
@@ -116,6 +179,7 @@ void vtkMRMLSegmentationStorageNode::WriteXML(ostream& of, int nIndent)
 {
   Superclass::WriteXML(of, nIndent);
   vtkIndent indent(nIndent);
+  of << indent << " collapseLabelmaps=\"" << (this->CollapseLabelmaps ? "true" : "false") << "\"";
 }
 
 //----------------------------------------------------------------------------
@@ -126,6 +190,11 @@ void vtkMRMLSegmentationStorageNode::Copy(vtkMRMLNode *anode)
   int disabledModify = this->StartModify();
 
   Superclass::Copy(anode);
+  vtkMRMLSegmentationStorageNode* node = vtkMRMLSegmentationStorageNode::SafeDownCast(anode);
+  if (node)
+    {
+    this->SetCollapseLabelmaps(node->GetCollapseLabelmaps());
+    }
 
   this->EndModify(disabledModify);
 }
@@ -608,9 +677,120 @@ int vtkMRMLSegmentationStorageNode::ReadBinaryLabelmapRepresentation(vtkMRMLSegm
     containedRepresentationNames = reader->GetHeaderValue(GetSegmentationMetaDataKey(KEY_SEGMENTATION_CONTAINED_REPRESENTATION_NAMES).c_str());
     }
 
+  // If labelmaps are collapsed then each frame is a layer shared by the segments that have
+  // their layer index specified, otherwise each frame contains the labelmap of one segment
+  int numberOfSegments = numberOfFrames;
+  bool layered = false;
+  std::string layerKeySuffix = "_" + KEY_SEGMENT_LAYER;
+  for (kit = keys.begin(); kit != keys.end(); ++kit)
+    {
+    if (kit->size() > layerKeySuffix.size() && kit->compare(0, 7, "Segment") == 0
+      && kit->compare(kit->size() - layerKeySuffix.size(), layerKeySuffix.size(), layerKeySuffix) == 0)
+      {
+      if (!layered)
+        {
+        layered = true;
+        numberOfSegments = 0;
+        }
+      ++numberOfSegments;
+      }
+    }
+  std::vector< vtkSmartPointer<vtkOrientedImageData> > layers(numberOfFrames);
+  // Each segment has at least one key in the header, therefore segment indices are smaller than the number of keys
+  int maximumSegmentIndex = (layered ? static_cast<int>(keys.size()) : numberOfFrames);
+
+  // A layer is cropped to the union of the extents of its segments, the same way as a segment
+  // that is stored in its own frame is cropped to its extent
+  std::vector<int> layerExtents;
+  if (layered)
+    {
+    layerExtents.resize(6 * numberOfFrames);
+    for (int layer = 0; layer < numberOfFrames; ++layer)
+      {
+      int* layerExtent = &layerExtents[6 * layer];
+      layerExtent[0] = 0;
+      layerExtent[1] = -1;
+      layerExtent[2] = 0;
+      layerExtent[3] = -1;
+      layerExtent[4] = 0;
+      layerExtent[5] = -1;
+      }
+    for (int segmentIndex = 0; segmentIndex < maximumSegmentIndex; ++segmentIndex)
+      {
+      const char* layerValue = reader->GetHeaderValue(GetSegmentMetaDataKey(segmentIndex, KEY_SEGMENT_LAYER).c_str());
+      if (!layerValue)
+        {
+        continue;
+        }
+      int layer = -1;
+      std::stringstream ssLayerValue(layerValue);
+      ssLayerValue >> layer;
+      if (layer < 0 || layer >= numberOfFrames)
+        {
+        continue;
+        }
+      int segmentExtent[6] = { 0, -1, 0, -1, 0, -1 };
+      const char* extentValue = reader->GetHeaderValue(GetSegmentMetaDataKey(segmentIndex, KEY_SEGMENT_EXTENT).c_str());
+      if (extentValue)
+        {
+        GetImageExtentFromString(segmentExtent, extentValue);
+        }
+      else
+        {
+        vtkWarningMacro("Segment extent is missing for segment " << segmentIndex);
+        for (int i = 0; i < 6; i++)
+          {
+          segmentExtent[i] = imageExtentInFile[i];
+          }
+        }
+      if (segmentExtent[0] > segmentExtent[1] || segmentExtent[2] > segmentExtent[3] || segmentExtent[4] > segmentExtent[5])
+        {
+        // empty segment
+        continue;
+        }
+      int* layerExtent = &layerExtents[6 * layer];
+      bool emptyLayer = (layerExtent[0] > layerExtent[1]);
+      for (int i = 0; i < 3; i++)
+        {
+        segmentExtent[i * 2] += referenceImageExtentOffset[i];
+        segmentExtent[i * 2 + 1] += referenceImageExtentOffset[i];
+        layerExtent[i * 2] = emptyLayer ? segmentExtent[i * 2] : std::min(layerExtent[i * 2], segmentExtent[i * 2]);
+        layerExtent[i * 2 + 1] = emptyLayer ? segmentExtent[i * 2 + 1] : std::max(layerExtent[i * 2 + 1], segmentExtent[i * 2 + 1]);
+        }
+      }
+    }
+
   // Read segment binary labelmaps
-  for (int segmentIndex = 0; segmentIndex < numberOfFrames; ++segmentIndex)
+  int numberOfReadSegments = 0;
+  for (int segmentIndex = 0; numberOfReadSegments < numberOfSegments && segmentIndex < maximumSegmentIndex; ++segmentIndex)
     {
+    int layer = segmentIndex;
+    int labelValue = 1;
+    if (layered)
+      {
+      const char* layerValue = reader->GetHeaderValue(GetSegmentMetaDataKey(segmentIndex, KEY_SEGMENT_LAYER).c_str());
+      if (!layerValue)
+        {
+        // Segment was not written to file
+        continue;
+        }
+      std::stringstream ssLayerValue(layerValue);
+      ssLayerValue >> layer;
+      const char* labelValueStr = reader->GetHeaderValue(GetSegmentMetaDataKey(segmentIndex, KEY_SEGMENT_LABEL_VALUE).c_str());
+      if (labelValueStr)
+        {
+        std::stringstream ssLabelValue(labelValueStr);
+        ssLabelValue >> labelValue;
+        }
+      if (layer < 0 || layer >= numberOfFrames)
+        {
+        vtkErrorMacro("ReadBinaryLabelmapRepresentation: Invalid layer " << layer << " for segment " << segmentIndex);
+        ++numberOfReadSegments;
+        continue;
+        }
+      }
+    ++numberOfReadSegments;
+
     // Create segment
     vtkSmartPointer<vtkSegment> currentSegment = vtkSmartPointer<vtkSegment>::New();
 
@@ -661,6 +841,39 @@ int vtkMRMLSegmentationStorageNode::ReadBinaryLabelmapRepresentation(vtkMRMLSegm
       this->SetSegmentTagsFromString(currentSegment, headerValue);
       }
 
+    if (layered)
+      {
+      // Segments of the same layer share the labelmap, the layer is extracted from the file once
+      if (!layers[layer])
+        {
+        layers[layer] = vtkSmartPointer<vtkOrientedImageData>::New();
+        int* layerExtent = &layerExtents[6 * layer];
+        if (layerExtent[0] <= layerExtent[1])
+          {
+          // non-empty layer
+          extractComponents->SetComponents(layer);
+          padder->SetOutputWholeExtent(layerExtent);
+          padder->Update();
+          layers[layer]->DeepCopy(padder->GetOutput());
+          }
+        else
+          {
+          // all segments of the layer are empty
+          layers[layer]->SetExtent(layerExtent);
+          layers[layer]->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+          }
+        layers[layer]->SetImageToWorldMatrix(imageToWorldMatrix.GetPointer());
+        }
+      currentSegment->SetLabelValue(labelValue);
+      currentSegment->AddRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), layers[layer]);
+      if (segmentation->GetSegment(currentSegmentID) != NULL)
+        {
+        vtkErrorMacro("Segment by ID " << currentSegmentID << " already exists in segmentation.");
+        }
+      segmentation->AddSegment(currentSegment, currentSegmentID);
+      continue;
+      }
+
     // Create binary labelmap volume
     vtkSmartPointer<vtkOrientedImageData> currentBinaryLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
 
@@ -690,7 +903,7 @@ int vtkMRMLSegmentationStorageNode::ReadBinaryLabelmapRepresentation(vtkMRMLSegm
       && currentSegmentExtent[4] <= currentSegmentExtent[5])
       {
       // non-empty segment
-      extractComponents->SetComponents(segmentIndex);
+      extractComponents->SetComponents(layer);
       padder->SetOutputWholeExtent(currentSegmentExtent);
       padder->Update();
       currentBinaryLabelmap->DeepCopy(padder->GetOutput());
@@ -991,6 +1204,16 @@ int vtkMRMLSegmentationStorageNode::WriteBinaryLabelmapRepresentation(vtkMRMLSeg
 
   vtkNew<vtkImageAppendComponents> appender;
 
+  // Label values can only represent binary labelmaps, other image data (such as fractional labelmaps)
+  // is always written as one volume per segment
+  bool collapseLabelmaps = this->CollapseLabelmaps && segmentation->GetMasterRepresentationName() ==
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName();
+
+  // Label volumes written to file if labelmaps are collapsed.
+  // Segments are resampled and placed into the layers one by one so that only the layers are kept in memory.
+  std::vector< vtkSmartPointer<vtkOrientedImageData> > layers;
+  std::vector<int> layerNextLabelValues;
+
   // Dimensions of the output 4D NRRD file: (i, j, k, segment)
   unsigned int segmentIndex = 0;
   std::vector< std::string > segmentIDs;
@@ -1008,6 +1231,12 @@ int vtkMRMLSegmentationStorageNode::WriteBinaryLabelmapRepresentation(vtkMRMLSeg
       vtkErrorMacro("WriteBinaryLabelmapRepresentation: Failed to retrieve master representation from segment " << currentSegmentID);
       continue;
       }
+    if (segmentation->IsLayerBinaryLabelmap(currentSegment))
+      {
+      // Labelmap is a layer shared with other segments, only write the voxels of this segment
+      currentBinaryLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      segmentation->GetBinaryLabelmapRepresentation(currentSegmentID, currentBinaryLabelmap);
+      }
 
     int currentBinaryLabelmapExtent[6] = { 0, -1, 0, -1, 0, -1 };
     currentBinaryLabelmap->GetExtent(currentBinaryLabelmapExtent);
@@ -1070,9 +1299,58 @@ int vtkMRMLSegmentationStorageNode::WriteBinaryLabelmapRepresentation(vtkMRMLSeg
     writer->SetAttribute(GetSegmentMetaDataKey(segmentIndex, KEY_SEGMENT_EXTENT).c_str(), GetImageExtentAsString(currentBinaryLabelmapExtent));
     writer->SetAttribute(GetSegmentMetaDataKey(segmentIndex, KEY_SEGMENT_TAGS).c_str(), GetSegmentTagsAsString(currentSegment));
 
-    appender->AddInputData(currentBinaryLabelmap);
+    if (!collapseLabelmaps)
+      {
+      appender->AddInputData(currentBinaryLabelmap);
+      continue;
+      }
+
+    // Find the first layer that the segment does not overlap with and that has a free label value
+    for (int i = 0; i < 3; i++)
+      {
+      currentBinaryLabelmapExtent[i * 2] += referenceImageExtentOffset[i];
+      currentBinaryLabelmapExtent[i * 2 + 1] += referenceImageExtentOffset[i];
+      }
+    bool emptySegment = (currentBinaryLabelmap == commonGeometryImage.GetPointer());
+    unsigned int layerIndex = 0;
+    for (; layerIndex < layers.size(); ++layerIndex)
+      {
+      if (layerNextLabelValues[layerIndex] > VTK_UNSIGNED_CHAR_MAX)
+        {
+        // Layers are unsigned char, all label values of this layer are used
+        continue;
+        }
+      if (emptySegment || !HasOverlap(layers[layerIndex], currentBinaryLabelmap, currentBinaryLabelmapExtent))
+        {
+        break;
+        }
+      }
+    if (layerIndex == layers.size())
+      {
+      vtkSmartPointer<vtkOrientedImageData> layer = vtkSmartPointer<vtkOrientedImageData>::New();
+      layer->DeepCopy(commonGeometryImage);
+      layers.push_back(layer);
+      layerNextLabelValues.push_back(1);
+      }
+    int labelValue = layerNextLabelValues[layerIndex]++;
+    if (!emptySegment)
+      {
+      AddToLayer(layers[layerIndex], currentBinaryLabelmap, currentBinaryLabelmapExtent, labelValue);
+      }
+
+    std::stringstream ssLayer;
+    ssLayer << layerIndex;
+    writer->SetAttribute(GetSegmentMetaDataKey(segmentIndex, KEY_SEGMENT_LAYER).c_str(), ssLayer.str());
+    std::stringstream ssLabelValue;
+    ssLabelValue << labelValue;
+    writer->SetAttribute(GetSegmentMetaDataKey(segmentIndex, KEY_SEGMENT_LABEL_VALUE).c_str(), ssLabelValue.str());
     } // For each segment
 
+  // Each layer is written as one component of the nrrd file
+  for (std::vector< vtkSmartPointer<vtkOrientedImageData> >::iterator layerIt = layers.begin(); layerIt != layers.end(); ++layerIt)
+    {
+    appender->AddInputData(*layerIt);
+    }
 
   appender->Update();
 
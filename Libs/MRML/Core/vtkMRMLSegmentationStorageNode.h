@@ -86,6 +86,15 @@ public:
   /// Reset supported write file types. Called when master representation is changed
   void ResetSupportedWriteFileTypes();
 
+  /// If enabled then binary labelmap segments that do not overlap are written into
+  /// a shared 3D label volume (layer) in the nrrd file, each segment identified by its label value.
+  /// Overlapping segments are written into additional layers. Files written this way can only be
+  /// read by applications that know about layers, therefore it is disabled by default and then
+  /// one binary volume is written for each segment. Ignored if master representation is not binary labelmap.
+  vtkGetMacro(CollapseLabelmaps, bool);
+  vtkSetMacro(CollapseLabelmaps, bool);
+  vtkBooleanMacro(CollapseLabelmaps, bool);
+
 protected:
   /// Initialize all the supported read file types
   virtual void InitializeSupportedReadFileTypes();
@@ -143,6 +152,9 @@ protected:
   static std::string GetSegmentColorAsString(vtkMRMLSegmentationNode* segmentationNode, const std::string& segmentId);
   static void GetSegmentColorFromString(double color[3], std::string colorString);
 
+protected:
+  bool CollapseLabelmaps;
+
 protected:
   vtkMRMLSegmentationStorageNode();
   ~vtkMRMLSegmentationStorageNode();
@@ -9,10 +9,15 @@
 
 #include "vtkOrientedGridTransform.h"
 
+#include "vtkImageData.h"
 #include "vtkMath.h"
 #include "vtkMatrix4x4.h"
 #include "vtkNew.h"
 #include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkSMPThreadLocal.h"
+#include "vtkSMPTools.h"
 
 vtkStandardNewMacro(vtkOrientedGridTransform);
 
@@ -24,6 +29,13 @@ vtkOrientedGridTransform::vtkOrientedGridTransform()
   this->GridDirectionMatrix = NULL;
   this->GridIndexToOutputTransformMatrixCached = vtkMatrix4x4::New();
   this->OutputToGridIndexTransformMatrixCached = vtkMatrix4x4::New();
+  this->UseCachedInverseGrid = 0;
+  this->CachedInverseGrid = NULL;
+  this->CachedInverseGridIncrements[0] = 0;
+  this->CachedInverseGridIncrements[1] = 0;
+  this->CachedInverseGridIncrements[2] = 0;
+  this->InverseGridMaximumError = 0.0;
+  this->InverseGridMeanError = 0.0;
 }
 
 //----------------------------------------------------------------------------
@@ -40,6 +52,11 @@ vtkOrientedGridTransform::~vtkOrientedGridTransform()
     this->OutputToGridIndexTransformMatrixCached->Delete();
     this->OutputToGridIndexTransformMatrixCached = NULL;
     }
+  if (this->CachedInverseGrid)
+    {
+    this->CachedInverseGrid->Delete();
+    this->CachedInverseGrid = NULL;
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -52,6 +69,9 @@ void vtkOrientedGridTransform::PrintSelf(ostream& os, vtkIndent indent)
     {
     this->GridDirectionMatrix->PrintSelf(os,indent.GetNextIndent());
     }
+  os << indent << "UseCachedInverseGrid: " << this->UseCachedInverseGrid << "\n";
+  os << indent << "InverseGridMaximumError: " << this->InverseGridMaximumError << "\n";
+  os << indent << "InverseGridMeanError: " << this->InverseGridMeanError << "\n";
 }
 
 //------------------------------------------------------------------------
@@ -177,12 +197,48 @@ void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3
                                                   double outPoint[3],
                                                   double derivative[3][3])
 {
+  if (this->GridPointer != NULL && this->CachedInverseGrid != NULL)
+    {
+    // interpolate the precomputed inverse displacement grid
+    double point[3];
+    double displacement[3];
+    vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, point);
+    this->InterpolationFunction(point, displacement, NULL,
+                                this->CachedInverseGrid->GetScalarPointer(), VTK_DOUBLE,
+                                this->GridExtent, this->CachedInverseGridIncrements);
+    outPoint[0] = inPoint[0] + displacement[0];
+    outPoint[1] = inPoint[1] + displacement[1];
+    outPoint[2] = inPoint[2] + displacement[2];
+
+    // derivative is computed at the inverse point, as in the Newton iteration
+    double forwardPoint[3];
+    this->ForwardTransformDerivative(outPoint, forwardPoint, derivative);
+    return;
+    }
+
   if (this->GridDirectionMatrix == NULL || this->GridPointer == NULL)
     {
     this->Superclass::InverseTransformDerivative(inPoint,outPoint,derivative);
     return;
     }
 
+  double residualSquared = 0.0;
+  if (!this->InverseTransformPointNewton(inPoint, NULL, outPoint, derivative, residualSquared))
+    {
+    vtkWarningMacro("InverseTransformPoint: no convergence (" <<
+                    inPoint[0] << ", " << inPoint[1] << ", " << inPoint[2] <<
+                    ") error = " << sqrt(residualSquared) << " after " <<
+                    this->InverseIterations << " iterations.");
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::InverseTransformPointNewton(const double inPoint[3],
+                                                  const double* initialGuess,
+                                                  double outPoint[3],
+                                                  double derivative[3][3],
+                                                  double &residualSquared)
+{
   void *gridPtr = this->GridPointer;
   int gridType = this->GridScalarType;
 
@@ -193,30 +249,38 @@ void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3
   double scale = this->DisplacementScale;
 
   double point[3], inverse[3], lastInverse[3], inverse_IJK[3];
-  double deltaP[3], deltaI[3];
+  double deltaP[3], deltaI[3] = {0.0, 0.0, 0.0};
 
   double functionValue = 0;
   double functionDerivative = 0;
   double lastFunctionValue = VTK_DOUBLE_MAX;
 
-  double errorSquared = 0.0;
   double toleranceSquared = this->InverseTolerance;
   toleranceSquared *= toleranceSquared;
 
   double f = 1.0;
   double a;
 
-  // convert the inPoint to i,j,k indices plus fractions
-  vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, point);
+  if (initialGuess)
+    {
+    inverse[0] = initialGuess[0];
+    inverse[1] = initialGuess[1];
+    inverse[2] = initialGuess[2];
+    }
+  else
+    {
+    // convert the inPoint to i,j,k indices plus fractions
+    vtkLinearTransformPoint(this->OutputToGridIndexTransformMatrixCached->Element, inPoint, point);
 
-  // first guess at inverse point, just subtract displacement
-  // (the inverse point is given in i,j,k indices plus fractions)
-  this->InterpolationFunction(point, deltaP, NULL,
-                              gridPtr, gridType, extent, increments);
+    // first guess at inverse point, just subtract displacement
+    // (the inverse point is given in i,j,k indices plus fractions)
+    this->InterpolationFunction(point, deltaP, NULL,
+                                gridPtr, gridType, extent, increments);
 
-  inverse[0] = inPoint[0] - (deltaP[0]*scale + shift);
-  inverse[1] = inPoint[1] - (deltaP[1]*scale + shift);
-  inverse[2] = inPoint[2] - (deltaP[2]*scale + shift);
+    inverse[0] = inPoint[0] - (deltaP[0]*scale + shift);
+    inverse[1] = inPoint[1] - (deltaP[1]*scale + shift);
+    inverse[2] = inPoint[2] - (deltaP[2]*scale + shift);
+    }
   lastInverse[0] = inverse[0];
   lastInverse[1] = inverse[1];
   lastInverse[2] = inverse[2];
@@ -260,9 +324,9 @@ void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3
       vtkMath::LinearSolve3x3(derivative,deltaP,deltaI);
 
       // get the error value in the output coord space
-      errorSquared = (deltaI[0]*deltaI[0] +
-                      deltaI[1]*deltaI[1] +
-                      deltaI[2]*deltaI[2]);
+      double errorSquared = (deltaI[0]*deltaI[0] +
+                             deltaI[1]*deltaI[1] +
+                             deltaI[2]*deltaI[2]);
 
       // break if less than tolerance in both coordinate systems
       if (errorSquared < toleranceSquared &&
@@ -313,25 +377,303 @@ void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3
     inverse[2] = lastInverse[2] - f*deltaI[2];
     }
 
-  vtkDebugMacro("Inverse Iterations: " << (i+1));
-
-  if (i >= n)
+  bool converged = (i < n);
+  if (converged)
+    {
+    residualSquared = functionValue;
+    }
+  else
     {
     // didn't converge: back up to last good result
     inverse[0] = lastInverse[0];
     inverse[1] = lastInverse[1];
     inverse[2] = lastInverse[2];
-
-    vtkWarningMacro("InverseTransformPoint: no convergence (" <<
-                    inPoint[0] << ", " << inPoint[1] << ", " << inPoint[2] <<
-                    ") error = " << sqrt(errorSquared) << " after " <<
-                    i << " iterations.");
+    residualSquared = lastFunctionValue;
     }
 
   // convert point
   outPoint[0] = inverse[0];
   outPoint[1] = inverse[1];
   outPoint[2] = inverse[2];
+
+  return converged;
+}
+
+//----------------------------------------------------------------------------
+// Computes inverse of a list of points. Each point in a chunk is started
+// from the displacement of the previous point.
+class vtkOrientedGridTransformInversePointsFunctor
+{
+public:
+  vtkOrientedGridTransform* Transform;
+  vtkPoints* InputPoints;
+  vtkPoints* OutputPoints;
+  vtkIdType OutputOffset;
+  vtkSMPThreadLocal<vtkIdType> NumberOfNotConvergedPoints;
+
+  void Initialize()
+    {
+    this->NumberOfNotConvergedPoints.Local() = 0;
+    }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+    {
+    vtkIdType& numberOfNotConvergedPoints = this->NumberOfNotConvergedPoints.Local();
+    double inPoint[3];
+    double outPoint[3];
+    double guess[3];
+    double derivative[3][3];
+    double residualSquared = 0.0;
+    double lastDisplacement[3] = {0.0, 0.0, 0.0};
+    bool lastDisplacementValid = false;
+    for (vtkIdType pointIndex = begin; pointIndex < end; pointIndex++)
+      {
+      this->InputPoints->GetPoint(pointIndex, inPoint);
+      bool converged = false;
+      if (lastDisplacementValid)
+        {
+        guess[0] = inPoint[0] + lastDisplacement[0];
+        guess[1] = inPoint[1] + lastDisplacement[1];
+        guess[2] = inPoint[2] + lastDisplacement[2];
+        converged = this->Transform->InverseTransformPointNewton(inPoint, guess, outPoint, derivative, residualSquared);
+        }
+      if (!converged)
+        {
+        // no previous solution or it was not a good starting point
+        converged = this->Transform->InverseTransformPointNewton(inPoint, NULL, outPoint, derivative, residualSquared);
+        }
+      if (converged)
+        {
+        lastDisplacement[0] = outPoint[0] - inPoint[0];
+        lastDisplacement[1] = outPoint[1] - inPoint[1];
+        lastDisplacement[2] = outPoint[2] - inPoint[2];
+        }
+      else
+        {
+        numberOfNotConvergedPoints++;
+        }
+      lastDisplacementValid = converged;
+      this->OutputPoints->SetPoint(this->OutputOffset + pointIndex, outPoint);
+      }
+    }
+
+  void Reduce()
+    {
+    }
+};
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::TransformPoints(vtkPoints *inPts, vtkPoints *outPts)
+{
+  this->Update();
+  if (!this->InverseFlag || this->GridPointer == NULL || this->CachedInverseGrid != NULL
+    || inPts == NULL || outPts == NULL)
+    {
+    // forward transform and cached inverse are fast, no need for threading
+    this->Superclass::TransformPoints(inPts, outPts);
+    return;
+    }
+
+  vtkIdType numberOfPoints = inPts->GetNumberOfPoints();
+  vtkIdType outputOffset = outPts->GetNumberOfPoints();
+  outPts->SetNumberOfPoints(outputOffset + numberOfPoints);
+
+  vtkOrientedGridTransformInversePointsFunctor functor;
+  functor.Transform = this;
+  functor.InputPoints = inPts;
+  functor.OutputPoints = outPts;
+  functor.OutputOffset = outputOffset;
+  vtkSMPTools::For(0, numberOfPoints, functor);
+  outPts->Modified();
+
+  vtkIdType numberOfNotConvergedPoints = 0;
+  for (vtkSMPThreadLocal<vtkIdType>::iterator it = functor.NumberOfNotConvergedPoints.begin();
+    it != functor.NumberOfNotConvergedPoints.end(); ++it)
+    {
+    numberOfNotConvergedPoints += *it;
+    }
+  if (numberOfNotConvergedPoints > 0)
+    {
+    vtkWarningMacro("TransformPoints: inverse computation did not converge for "
+      << numberOfNotConvergedPoints << " of " << numberOfPoints << " points");
+    }
+}
+
+//----------------------------------------------------------------------------
+// Computes inverse displacement of grid points, slice by slice.
+// Each grid point is started from the solution of the previous
+// point in the row (or the first point of the previous row).
+class vtkOrientedGridTransformInverseGridFunctor
+{
+public:
+  vtkOrientedGridTransform* Transform;
+  double* InverseGridPtr;
+  int Extent[6];
+  vtkIdType Increments[3];
+  double GridIndexToOutput[4][4];
+
+  vtkSMPThreadLocal<double> MaximumError;
+  vtkSMPThreadLocal<double> SumError;
+  vtkSMPThreadLocal<vtkIdType> NumberOfNotConvergedPoints;
+
+  void Initialize()
+    {
+    this->MaximumError.Local() = 0.0;
+    this->SumError.Local() = 0.0;
+    this->NumberOfNotConvergedPoints.Local() = 0;
+    }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+    {
+    double& maximumError = this->MaximumError.Local();
+    double& sumError = this->SumError.Local();
+    vtkIdType& numberOfNotConvergedPoints = this->NumberOfNotConvergedPoints.Local();
+
+    double index[3];
+    double gridPoint[3];
+    double inversePoint[3];
+    double guess[3];
+    double derivative[3][3];
+    double residualSquared = 0.0;
+    for (vtkIdType k = begin; k < end; k++)
+      {
+      index[2] = static_cast<double>(k);
+      double* rowStartPtr = NULL;
+      for (int j = this->Extent[2]; j <= this->Extent[3]; j++)
+        {
+        index[1] = static_cast<double>(j);
+        double* voxelPtr = this->InverseGridPtr
+          + (k - this->Extent[4]) * this->Increments[2] + (j - this->Extent[2]) * this->Increments[1];
+        // warm start from the first point of the previous row
+        double* neighborPtr = rowStartPtr;
+        rowStartPtr = voxelPtr;
+        for (int i = this->Extent[0]; i <= this->Extent[1]; i++, voxelPtr += 3)
+          {
+          index[0] = static_cast<double>(i);
+          vtkLinearTransformPoint(this->GridIndexToOutput, index, gridPoint);
+          bool converged = false;
+          if (neighborPtr)
+            {
+            guess[0] = gridPoint[0] + neighborPtr[0];
+            guess[1] = gridPoint[1] + neighborPtr[1];
+            guess[2] = gridPoint[2] + neighborPtr[2];
+            converged = this->Transform->InverseTransformPointNewton(gridPoint, guess, inversePoint, derivative, residualSquared);
+            }
+          if (!converged)
+            {
+            converged = this->Transform->InverseTransformPointNewton(gridPoint, NULL, inversePoint, derivative, residualSquared);
+            }
+          if (!converged)
+            {
+            numberOfNotConvergedPoints++;
+            }
+          voxelPtr[0] = inversePoint[0] - gridPoint[0];
+          voxelPtr[1] = inversePoint[1] - gridPoint[1];
+          voxelPtr[2] = inversePoint[2] - gridPoint[2];
+          double error = sqrt(residualSquared);
+          sumError += error;
+          if (error > maximumError)
+            {
+            maximumError = error;
+            }
+          // next point in the row is started from this point
+          neighborPtr = voxelPtr;
+          }
+        }
+      }
+    }
+
+  void Reduce()
+    {
+    }
+};
+
+//----------------------------------------------------------------------------
+int vtkOrientedGridTransform::ComputeInverseGrid(vtkImageData* inverseGrid, vtkMatrix4x4* gridDirectionMatrix/*=NULL*/)
+{
+  this->Update();
+  return this->ComputeInverseGridInternal(inverseGrid, gridDirectionMatrix);
+}
+
+//----------------------------------------------------------------------------
+int vtkOrientedGridTransform::ComputeInverseGridInternal(vtkImageData* inverseGrid, vtkMatrix4x4* gridDirectionMatrix)
+{
+  this->InverseGridMaximumError = 0.0;
+  this->InverseGridMeanError = 0.0;
+  if (inverseGrid == NULL)
+    {
+    vtkErrorMacro("ComputeInverseGrid: invalid output grid");
+    return 0;
+    }
+  if (this->GridPointer == NULL)
+    {
+    vtkErrorMacro("ComputeInverseGrid: displacement grid is not set");
+    return 0;
+    }
+
+  vtkOrientedGridTransformInverseGridFunctor functor;
+  functor.Transform = this;
+  inverseGrid->GetExtent(functor.Extent);
+  if (functor.Extent[0] > functor.Extent[1] || functor.Extent[2] > functor.Extent[3] || functor.Extent[4] > functor.Extent[5])
+    {
+    // empty grid
+    return 0;
+    }
+  if (inverseGrid->GetPointData()->GetScalars() == NULL
+    || inverseGrid->GetScalarType() != VTK_DOUBLE
+    || inverseGrid->GetNumberOfScalarComponents() != 3)
+    {
+    inverseGrid->AllocateScalars(VTK_DOUBLE, 3);
+    }
+  inverseGrid->GetIncrements(functor.Increments);
+  functor.InverseGridPtr = static_cast<double*>(inverseGrid->GetScalarPointer());
+
+  double origin[3];
+  double spacing[3];
+  inverseGrid->GetOrigin(origin);
+  inverseGrid->GetSpacing(spacing);
+  for (int row = 0; row < 4; row++)
+    {
+    for (int col = 0; col < 4; col++)
+      {
+      functor.GridIndexToOutput[row][col] = (row == col ? 1.0 : 0.0);
+      }
+    }
+  for (int row = 0; row < 3; row++)
+    {
+    for (int col = 0; col < 3; col++)
+      {
+      double direction = (gridDirectionMatrix ? gridDirectionMatrix->GetElement(row, col) : (row == col ? 1.0 : 0.0));
+      functor.GridIndexToOutput[row][col] = spacing[col] * direction;
+      }
+    functor.GridIndexToOutput[row][3] = origin[row];
+    }
+
+  vtkSMPTools::For(functor.Extent[4], functor.Extent[5] + 1, functor);
+  inverseGrid->Modified();
+
+  double sumError = 0.0;
+  vtkIdType numberOfNotConvergedPoints = 0;
+  for (vtkSMPThreadLocal<double>::iterator it = functor.MaximumError.begin(); it != functor.MaximumError.end(); ++it)
+    {
+    if (*it > this->InverseGridMaximumError)
+      {
+      this->InverseGridMaximumError = *it;
+      }
+    }
+  for (vtkSMPThreadLocal<double>::iterator it = functor.SumError.begin(); it != functor.SumError.end(); ++it)
+    {
+    sumError += *it;
+    }
+  for (vtkSMPThreadLocal<vtkIdType>::iterator it = functor.NumberOfNotConvergedPoints.begin();
+    it != functor.NumberOfNotConvergedPoints.end(); ++it)
+    {
+    numberOfNotConvergedPoints += *it;
+    }
+  vtkIdType numberOfPoints = inverseGrid->GetNumberOfPoints();
+  this->InverseGridMeanError = (numberOfPoints > 0 ? sumError / numberOfPoints : 0.0);
+
+  return static_cast<int>(numberOfNotConvergedPoints);
 }
 
 //----------------------------------------------------------------------------
@@ -340,8 +682,9 @@ void vtkOrientedGridTransform::InternalDeepCopy(vtkAbstractTransform *transform)
   vtkOrientedGridTransform *gridTransform = (vtkOrientedGridTransform *)transform;
 
   this->SetGridDirectionMatrix(gridTransform->GetGridDirectionMatrix());
+  this->SetUseCachedInverseGrid(gridTransform->GetUseCachedInverseGrid());
 
-  // Cached matrices will be recomputed automatically in InternalUpdate()
+  // Cached matrices and inverse grid will be recomputed automatically in InternalUpdate()
   // therefore we do not need to copy them.
 
   this->Superclass::InternalDeepCopy(transform);
@@ -377,6 +720,35 @@ void vtkOrientedGridTransform::InternalUpdate()
   // Compute Output to GridIndex transform
   vtkMatrix4x4::Invert(this->GridIndexToOutputTransformMatrixCached, this->OutputToGridIndexTransformMatrixCached);
 
+  // Compute explicit inverse displacement grid on the geometry of the displacement grid
+  if (!this->UseCachedInverseGrid || this->GridPointer == NULL)
+    {
+    if (this->CachedInverseGrid)
+      {
+      this->CachedInverseGrid->Delete();
+      this->CachedInverseGrid = NULL;
+      }
+    return;
+    }
+  // Make sure the inverse is computed by Newton iteration while the cache is being filled
+  vtkImageData* cachedInverseGrid = this->CachedInverseGrid;
+  this->CachedInverseGrid = NULL;
+  if (cachedInverseGrid == NULL)
+    {
+    cachedInverseGrid = vtkImageData::New();
+    }
+  cachedInverseGrid->SetOrigin(this->GridOrigin);
+  cachedInverseGrid->SetSpacing(this->GridSpacing);
+  cachedInverseGrid->SetExtent(this->GridExtent);
+  cachedInverseGrid->AllocateScalars(VTK_DOUBLE, 3);
+  int numberOfNotConvergedPoints = this->ComputeInverseGridInternal(cachedInverseGrid, this->GridDirectionMatrix);
+  if (numberOfNotConvergedPoints > 0)
+    {
+    vtkWarningMacro("InternalUpdate: inverse grid computation did not converge at " << numberOfNotConvergedPoints
+      << " grid points (maximum error = " << this->InverseGridMaximumError << ")");
+    }
+  cachedInverseGrid->GetIncrements(this->CachedInverseGridIncrements);
+  this->CachedInverseGrid = cachedInverseGrid;
 }
 
 //----------------------------------------------------------------------------
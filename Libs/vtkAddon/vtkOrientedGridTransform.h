@@ -20,6 +20,9 @@
 
 #include "vtkGridTransform.h"
 
+class vtkImageData;
+class vtkPoints;
+
 class VTK_ADDON_EXPORT vtkOrientedGridTransform : public vtkGridTransform
 {
 public:
@@ -39,6 +42,49 @@ public:
   // Make another transform of the same type.
   vtkAbstractTransform *MakeTransform();
 
+  // Description:
+  // Apply the transformation to a series of points, and append the
+  // results to outPts. If the transform is inverted then the Newton
+  // iterations of the points are computed on multiple threads and each
+  // iteration is started from the displacement found for the previous point
+  // (which usually requires much fewer iterations for spatially coherent points).
+  virtual void TransformPoints(vtkPoints *inPts, vtkPoints *outPts);
+
+  // Description:
+  // Compute the inverse of the displacement field at the points of a regular grid.
+  // The grid geometry is defined by the origin, spacing, and extent of inverseGrid
+  // and the optional gridDirectionMatrix (axis directions, NULL means identity).
+  // The inverse displacement vectors (inverse point minus grid point) are stored
+  // in inverseGrid as 3-component double scalars.
+  // Grid points are processed on multiple threads and the Newton iteration of each
+  // grid point is started from the solution of its already computed neighbor.
+  // The residual error of the result is available in InverseGridMaximumError
+  // and InverseGridMeanError.
+  // Returns the number of grid points where the iteration did not converge.
+  virtual int ComputeInverseGrid(vtkImageData* inverseGrid, vtkMatrix4x4* gridDirectionMatrix=NULL);
+
+  // Description:
+  // If enabled then an explicit inverse displacement grid is computed when the
+  // transform is updated (on the same geometry as the displacement grid) and the
+  // inverse transform interpolates this grid instead of running a Newton iteration
+  // for each point. This is much faster but less accurate: the residual error at the
+  // grid points is reported in InverseGridMaximumError and InverseGridMeanError.
+  // Disabled by default.
+  vtkSetMacro(UseCachedInverseGrid, int);
+  vtkGetMacro(UseCachedInverseGrid, int);
+  vtkBooleanMacro(UseCachedInverseGrid, int);
+
+  // Description:
+  // Explicit inverse displacement grid, computed if UseCachedInverseGrid is enabled.
+  vtkGetObjectMacro(CachedInverseGrid, vtkImageData);
+
+  // Description:
+  // Maximum and mean distance between the grid points and the forward transformed
+  // inverse points, computed by the last ComputeInverseGrid call (or by the
+  // last update of the cached inverse grid).
+  vtkGetMacro(InverseGridMaximumError, double);
+  vtkGetMacro(InverseGridMeanError, double);
+
 protected:
   vtkOrientedGridTransform();
   ~vtkOrientedGridTransform();
@@ -68,6 +114,22 @@ protected:
   void InverseTransformDerivative(const double in[3], double out[3],
                                   double derivative[3][3]);
 
+  // Description:
+  // Find the inverse of a point using Newton's method.
+  // If initialGuess is NULL then the iteration is started from the point
+  // minus its displacement. residualSquared is set to the squared distance
+  // between inPoint and the forward transformed outPoint.
+  // Returns false if the iteration did not converge.
+  // This method does not modify the transform, therefore it can be called
+  // from multiple threads after the transform is updated.
+  bool InverseTransformPointNewton(const double inPoint[3], const double* initialGuess,
+                                   double outPoint[3], double derivative[3][3],
+                                   double &residualSquared);
+
+  // Description:
+  // Compute the inverse displacement grid without updating the transform.
+  int ComputeInverseGridInternal(vtkImageData* inverseGrid, vtkMatrix4x4* gridDirectionMatrix);
+
   // Description:
   // Grid axis direction vectors (i, j, k) in the output space
   vtkMatrix4x4* GridDirectionMatrix;
@@ -78,9 +140,18 @@ protected:
   vtkMatrix4x4* GridIndexToOutputTransformMatrixCached;
   vtkMatrix4x4* OutputToGridIndexTransformMatrixCached;
 
+  int UseCachedInverseGrid;
+  vtkImageData* CachedInverseGrid;
+  vtkIdType CachedInverseGridIncrements[3];
+  double InverseGridMaximumError;
+  double InverseGridMeanError;
+
 private:
   vtkOrientedGridTransform(const vtkOrientedGridTransform&);  // Not implemented.
   void operator=(const vtkOrientedGridTransform&);  // Not implemented.
+
+  friend class vtkOrientedGridTransformInversePointsFunctor;
+  friend class vtkOrientedGridTransformInverseGridFunctor;
 };
 
 #endif
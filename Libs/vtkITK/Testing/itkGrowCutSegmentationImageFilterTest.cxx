@@ -0,0 +1,156 @@
+#include "itkGrowCutSegmentationImageFilter.h"
+
+// ITK includes
+#include <itkImage.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+// STD includes
+#include <iostream>
+
+typedef itk::Image<short, 3> InputImageType;
+typedef itk::Image<short, 3> LabelImageType;
+typedef itk::Image<float, 3> WeightImageType;
+typedef itk::GrowCutSegmentationImageFilter<InputImageType, LabelImageType> FilterType;
+
+const int ImageSize = 24;
+
+//----------------------------------------------------------------------------
+// Two regions of different intensity separated at i = 12, with some noise
+InputImageType::Pointer CreateInputImage()
+{
+  InputImageType::SizeType size;
+  size.Fill(ImageSize);
+  InputImageType::Pointer image = InputImageType::New();
+  image->SetRegions(size);
+  image->Allocate();
+
+  unsigned int seed = 1234;
+  itk::ImageRegionIteratorWithIndex<InputImageType> it(image, image->GetBufferedRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    // linear congruential generator, so that the test does not depend on the platform
+    seed = seed * 1103515245 + 12345;
+    int noise = static_cast<int>((seed >> 16) % 7) - 3;
+    it.Set((it.GetIndex()[0] < 12 ? 100 : 200) + noise);
+    }
+  return image;
+}
+
+//----------------------------------------------------------------------------
+// Label 1 seeds in the plane i = 4, label 2 seeds in the plane i = 19
+void CreateSeedImages(LabelImageType::Pointer& labelImage, WeightImageType::Pointer& strengthImage)
+{
+  LabelImageType::SizeType size;
+  size.Fill(ImageSize);
+  labelImage = LabelImageType::New();
+  labelImage->SetRegions(size);
+  labelImage->Allocate();
+  labelImage->FillBuffer(0);
+  strengthImage = WeightImageType::New();
+  strengthImage->SetRegions(size);
+  strengthImage->Allocate();
+  strengthImage->FillBuffer(0.0);
+
+  itk::ImageRegionIteratorWithIndex<LabelImageType> label(labelImage, labelImage->GetBufferedRegion());
+  itk::ImageRegionIteratorWithIndex<WeightImageType> strength(strengthImage, strengthImage->GetBufferedRegion());
+  for (label.GoToBegin(), strength.GoToBegin(); !label.IsAtEnd(); ++label, ++strength)
+    {
+    LabelImageType::IndexType index = label.GetIndex();
+    if (index[1] < 4 || index[1] > 19 || index[2] < 4 || index[2] > 19)
+      {
+      continue;
+      }
+    if (index[0] == 4 || index[0] == 19)
+      {
+      label.Set(index[0] == 4 ? 1 : 2);
+      strength.Set(1.0);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+LabelImageType::Pointer Segment(bool useActiveSet)
+{
+  InputImageType::Pointer inputImage = CreateInputImage();
+  LabelImageType::Pointer labelImage;
+  WeightImageType::Pointer strengthImage;
+  CreateSeedImages(labelImage, strengthImage);
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(inputImage);
+  filter->SetLabelImage(labelImage);
+  filter->SetStrengthImage(strengthImage);
+  filter->SetSeedStrength(1.0);
+  filter->SetObjectRadius(ImageSize);
+  filter->SetUseActiveSet(useActiveSet);
+  filter->Update();
+
+  LabelImageType::Pointer output = filter->GetOutput();
+  output->DisconnectPipeline();
+  return output;
+}
+
+//----------------------------------------------------------------------------
+int CheckSegmentation(LabelImageType* output, const char* modeName)
+{
+  // away from the boundary between the regions, each region gets the label of its seeds
+  itk::ImageRegionIteratorWithIndex<LabelImageType> it(output, output->GetBufferedRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    int i = it.GetIndex()[0];
+    int expectedLabel = (i <= 9 ? 1 : (i >= 14 ? 2 : -1));
+    if (expectedLabel >= 0 && it.Get() != expectedLabel)
+      {
+      std::cerr << modeName << ": label at " << it.GetIndex() << " is " << it.Get()
+                << ", expected " << expectedLabel << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int main(int, char*[])
+{
+  LabelImageType::Pointer fullRegionOutput;
+  LabelImageType::Pointer activeSetOutput;
+  try
+    {
+    fullRegionOutput = Segment(false);
+    activeSetOutput = Segment(true);
+    }
+  catch (itk::ExceptionObject& e)
+    {
+    std::cerr << "Segmentation failed: " << e << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (CheckSegmentation(fullRegionOutput, "Full region") != EXIT_SUCCESS
+    || CheckSegmentation(activeSetOutput, "Active set") != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // The active set reads the values of the previous iteration, the full region iterations
+  // update in place. Only a few voxels along the boundary between labels may differ.
+  itk::ImageRegionConstIterator<LabelImageType> fullRegionIt(fullRegionOutput, fullRegionOutput->GetBufferedRegion());
+  itk::ImageRegionConstIterator<LabelImageType> activeSetIt(activeSetOutput, activeSetOutput->GetBufferedRegion());
+  unsigned int numberOfDifferences = 0;
+  for (fullRegionIt.GoToBegin(), activeSetIt.GoToBegin(); !fullRegionIt.IsAtEnd(); ++fullRegionIt, ++activeSetIt)
+    {
+    if (fullRegionIt.Get() != activeSetIt.Get())
+      {
+      numberOfDifferences++;
+      }
+    }
+  const unsigned int maximumNumberOfDifferences = ImageSize * ImageSize * ImageSize / 100;
+  if (numberOfDifferences > maximumNumberOfDifferences)
+    {
+    std::cerr << "Active set and full region results differ at " << numberOfDifferences
+              << " voxels, expected at most " << maximumNumberOfDifferences << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
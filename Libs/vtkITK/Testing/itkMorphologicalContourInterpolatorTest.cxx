@@ -0,0 +1,162 @@
+#include "itkMorphologicalContourInterpolator.h"
+
+// ITK includes
+#include <itkImage.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+// STD includes
+#include <iostream>
+#include <vector>
+
+typedef itk::Image<unsigned char, 3> ImageType;
+
+//----------------------------------------------------------------------------
+// Image with two parallel labeled slices: a small disk and a larger disk around the same center
+ImageType::Pointer CreateTwoSliceImage(int firstSlice, double firstRadius, int secondSlice, double secondRadius)
+{
+  ImageType::SizeType size;
+  size[0] = 32;
+  size[1] = 32;
+  size[2] = 16;
+  ImageType::RegionType region;
+  region.SetSize(size);
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(region);
+  image->Allocate();
+  image->FillBuffer(0);
+
+  itk::ImageRegionIteratorWithIndex<ImageType> it(image, region);
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    ImageType::IndexType index = it.GetIndex();
+    double dx = index[0] - 15.3;
+    double dy = index[1] - 16.1;
+    double radius = 0.0;
+    if (index[2] == firstSlice)
+      {
+      radius = firstRadius;
+      }
+    else if (index[2] == secondSlice)
+      {
+      radius = secondRadius;
+      }
+    if (dx * dx + dy * dy <= radius * radius)
+      {
+      it.Set(1);
+      }
+    }
+  return image;
+}
+
+//----------------------------------------------------------------------------
+ImageType::Pointer Interpolate(ImageType* input, bool useDistanceFieldBlending)
+{
+  typedef itk::MorphologicalContourInterpolator<ImageType> InterpolatorType;
+  InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  interpolator->SetInput(input);
+  interpolator->SetAxis(2);
+  interpolator->SetUseDistanceFieldBlending(useDistanceFieldBlending);
+  interpolator->Update();
+  ImageType::Pointer output = interpolator->GetOutput();
+  output->DisconnectPipeline();
+  return output;
+}
+
+//----------------------------------------------------------------------------
+std::vector<int> GetSliceAreas(ImageType* image)
+{
+  std::vector<int> areas(image->GetLargestPossibleRegion().GetSize()[2], 0);
+  itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (it.Get() == 1)
+      {
+      areas[it.GetIndex()[2]]++;
+      }
+    }
+  return areas;
+}
+
+//----------------------------------------------------------------------------
+// Both interpolation modes must keep the labeled slices, fill every slice in between
+// with an area between the areas of the labeled slices, and must not label anything outside.
+int CheckInterpolatedImage(ImageType* input, ImageType* output, int firstSlice, int secondSlice, const char* modeName)
+{
+  std::vector<int> inputAreas = GetSliceAreas(input);
+  std::vector<int> outputAreas = GetSliceAreas(output);
+  for (int slice = 0; slice < static_cast<int>(outputAreas.size()); slice++)
+    {
+    if (slice == firstSlice || slice == secondSlice)
+      {
+      if (outputAreas[slice] != inputAreas[slice])
+        {
+        std::cerr << modeName << ": labeled slice " << slice << " is modified" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    else if (slice > firstSlice && slice < secondSlice)
+      {
+      if (outputAreas[slice] < inputAreas[firstSlice] || outputAreas[slice] > inputAreas[secondSlice])
+        {
+        std::cerr << modeName << ": area of slice " << slice << " is " << outputAreas[slice]
+          << ", expected between " << inputAreas[firstSlice] << " and " << inputAreas[secondSlice] << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    else if (outputAreas[slice] != 0)
+      {
+      std::cerr << modeName << ": slice " << slice << " outside of the labeled slices is not empty" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int main(int, char*[])
+{
+  const int firstSlice = 3;
+  const int secondSlice = 12;
+  ImageType::Pointer input = CreateTwoSliceImage(firstSlice, 4.0, secondSlice, 10.0);
+
+  ImageType::Pointer morphologicalOutput = Interpolate(input, false);
+  if (CheckInterpolatedImage(input, morphologicalOutput, firstSlice, secondSlice, "Morphological interpolation") != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  ImageType::Pointer blendingOutput = Interpolate(input, true);
+  if (CheckInterpolatedImage(input, blendingOutput, firstSlice, secondSlice, "Distance field blending") != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // The two modes are different algorithms, but their results must be similar
+  int numberOfVoxelsInBoth = 0;
+  int numberOfVoxelsInEither = 0;
+  itk::ImageRegionConstIterator<ImageType> morphologicalIt(morphologicalOutput, morphologicalOutput->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<ImageType> blendingIt(blendingOutput, blendingOutput->GetLargestPossibleRegion());
+  for (; !morphologicalIt.IsAtEnd(); ++morphologicalIt, ++blendingIt)
+    {
+    bool inMorphological = (morphologicalIt.Get() == 1);
+    bool inBlending = (blendingIt.Get() == 1);
+    if (inMorphological && inBlending)
+      {
+      numberOfVoxelsInBoth++;
+      }
+    if (inMorphological || inBlending)
+      {
+      numberOfVoxelsInEither++;
+      }
+    }
+  double jaccardIndex = double(numberOfVoxelsInBoth) / double(numberOfVoxelsInEither);
+  std::cout << "Jaccard index of morphological and distance field blending results: " << jaccardIndex << std::endl;
+  if (jaccardIndex < 0.8)
+    {
+    std::cerr << "Results of the two interpolation modes differ too much" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
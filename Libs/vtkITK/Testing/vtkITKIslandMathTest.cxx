@@ -0,0 +1,199 @@
+#include "vtkITKIslandMath.h"
+
+// ITK includes
+#include <itkConnectedComponentImageFilter.h>
+#include <itkImage.h>
+#include <itkRelabelComponentImageFilter.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+typedef itk::Image<short, 3> ImageType;
+
+//----------------------------------------------------------------------------
+// Random binary image, with many islands of the same size to check the order of islands
+void CreateInputImage(vtkImageData* image)
+{
+  image->SetExtent(2, 25, -3, 14, 1, 12);
+  image->AllocateScalars(VTK_SHORT, 1);
+  short* ptr = static_cast<short*>(image->GetScalarPointer());
+  unsigned int seed = 1234;
+  for (vtkIdType i = 0; i < image->GetNumberOfPoints(); i++)
+    {
+    // linear congruential generator, so that the test does not depend on the platform
+    seed = seed * 1103515245 + 12345;
+    ptr[i] = ((seed >> 16) % 100 < 30 ? 1 : 0);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Reference labeling: islands sorted by decreasing size by itk::RelabelComponentImageFilter
+ImageType::Pointer ComputeReferenceLabels(vtkImageData* image, vtkIdType minimumSize, std::vector<vtkIdType>& sizes)
+{
+  int dims[3] = { 0, 0, 0 };
+  image->GetDimensions(dims);
+  ImageType::SizeType size;
+  for (int i = 0; i < 3; i++)
+    {
+    size[i] = dims[i];
+    }
+  ImageType::Pointer inputImage = ImageType::New();
+  inputImage->SetRegions(size);
+  inputImage->Allocate();
+  std::copy(static_cast<short*>(image->GetScalarPointer()),
+    static_cast<short*>(image->GetScalarPointer()) + image->GetNumberOfPoints(), inputImage->GetBufferPointer());
+
+  typedef itk::ConnectedComponentImageFilter<ImageType, ImageType> ConnectedComponentType;
+  ConnectedComponentType::Pointer connectedComponents = ConnectedComponentType::New();
+  connectedComponents->SetInput(inputImage);
+  connectedComponents->SetFullyConnected(false);
+
+  typedef itk::RelabelComponentImageFilter<ImageType, ImageType> RelabelType;
+  RelabelType::Pointer relabel = RelabelType::New();
+  relabel->SetInput(connectedComponents->GetOutput());
+  relabel->SetMinimumObjectSize(minimumSize);
+  relabel->Update();
+
+  sizes.clear();
+  for (unsigned long i = 0; i < relabel->GetNumberOfObjects(); i++)
+    {
+    sizes.push_back(static_cast<vtkIdType>(relabel->GetSizeOfObjectsInPixels()[i]));
+    }
+  return relabel->GetOutput();
+}
+
+//----------------------------------------------------------------------------
+// Compares output labels with the reference labels, referenceToOutput maps a reference label to the expected output label
+int CheckIslands(vtkITKIslandMath* islandMath, ImageType* referenceLabels,
+  const std::vector<int>& referenceToOutput, const std::vector<vtkIdType>& expectedSizes, const char* name)
+{
+  if (islandMath->GetNumberOfIslands() != expectedSizes.size())
+    {
+    std::cerr << name << ": number of islands is " << islandMath->GetNumberOfIslands()
+              << ", expected " << expectedSizes.size() << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (unsigned long island = 1; island <= expectedSizes.size(); island++)
+    {
+    if (islandMath->GetIslandSize(island) != expectedSizes[island - 1])
+      {
+      std::cerr << name << ": size of island " << island << " is " << islandMath->GetIslandSize(island)
+                << ", expected " << expectedSizes[island - 1] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  vtkImageData* output = islandMath->GetOutput();
+  int* extent = output->GetExtent();
+  const short* outputPtr = static_cast<short*>(output->GetScalarPointer());
+  const short* referencePtr = referenceLabels->GetBufferPointer();
+  std::vector<int> expectedExtents;
+  for (size_t island = 0; island < expectedSizes.size(); island++)
+    {
+    int emptyExtent[6] = { VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN };
+    expectedExtents.insert(expectedExtents.end(), emptyExtent, emptyExtent + 6);
+    }
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++, outputPtr++, referencePtr++)
+        {
+        int expectedLabel = referenceToOutput[*referencePtr];
+        if (*outputPtr != expectedLabel)
+          {
+          std::cerr << name << ": label at (" << i << ", " << j << ", " << k << ") is " << *outputPtr
+                    << ", expected " << expectedLabel << std::endl;
+          return EXIT_FAILURE;
+          }
+        if (expectedLabel == 0)
+          {
+          continue;
+          }
+        int* islandExtent = &expectedExtents[(expectedLabel - 1) * 6];
+        int ijk[3] = { i, j, k };
+        for (int axis = 0; axis < 3; axis++)
+          {
+          islandExtent[axis * 2] = std::min(islandExtent[axis * 2], ijk[axis]);
+          islandExtent[axis * 2 + 1] = std::max(islandExtent[axis * 2 + 1], ijk[axis]);
+          }
+        }
+      }
+    }
+
+  for (unsigned long island = 1; island <= expectedSizes.size(); island++)
+    {
+    int islandExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    islandMath->GetIslandExtent(island, islandExtent);
+    if (!std::equal(islandExtent, islandExtent + 6, expectedExtents.begin() + (island - 1) * 6))
+      {
+      std::cerr << name << ": extent of island " << island << " is incorrect" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int main(int, char*[])
+{
+  vtkNew<vtkImageData> image;
+  CreateInputImage(image.GetPointer());
+  const vtkIdType minimumSize = 2;
+
+  std::vector<vtkIdType> referenceSizes;
+  ImageType::Pointer referenceLabels = ComputeReferenceLabels(image.GetPointer(), minimumSize, referenceSizes);
+  // Test is only meaningful if there are islands of the same size
+  if (referenceSizes.size() < 10
+    || std::adjacent_find(referenceSizes.begin(), referenceSizes.end()) == referenceSizes.end())
+    {
+    std::cerr << "Input image does not have enough islands of the same size" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Minimum size only: same labels and sizes as itk::RelabelComponentImageFilter
+  vtkNew<vtkITKIslandMath> islandMath;
+  islandMath->SetInputData(image.GetPointer());
+  islandMath->SetFullyConnected(0);
+  islandMath->SetMinimumSize(minimumSize);
+  islandMath->Update();
+  std::vector<int> referenceToOutput(referenceSizes.size() + 1);
+  for (size_t label = 0; label <= referenceSizes.size(); label++)
+    {
+    referenceToOutput[label] = static_cast<int>(label);
+    }
+  if (CheckIslands(islandMath.GetPointer(), referenceLabels, referenceToOutput, referenceSizes, "Minimum size") != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Maximum size: the largest islands are removed, the others keep their order
+  const vtkIdType maximumSize = referenceSizes[2] - 1;
+  islandMath->SetMaximumSize(maximumSize);
+  islandMath->Update();
+  std::vector<vtkIdType> expectedSizes;
+  referenceToOutput.assign(referenceSizes.size() + 1, 0);
+  for (size_t label = 1; label <= referenceSizes.size(); label++)
+    {
+    if (referenceSizes[label - 1] <= maximumSize)
+      {
+      expectedSizes.push_back(referenceSizes[label - 1]);
+      referenceToOutput[label] = static_cast<int>(expectedSizes.size());
+      }
+    }
+  if (expectedSizes.size() + 3 > referenceSizes.size()
+    || CheckIslands(islandMath.GetPointer(), referenceLabels, referenceToOutput, expectedSizes, "Maximum size") != EXIT_SUCCESS)
+    {
+    std::cerr << "Maximum size check failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
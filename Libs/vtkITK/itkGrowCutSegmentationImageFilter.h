@@ -3,6 +3,8 @@
 
 #include "itkImage.h"
 #include "itkImageToImageFilter.h"
+#include "itkIterationReporter.h"
+#include "itkMultiThreader.h"
 #include "itkSimpleDataObjectDecorator.h"
 #include "itkVectorContainer.h"
 //#include "itkCommand.h"
@@ -262,6 +264,25 @@ template<class TInputImage,
   itkGetConstMacro(SetMaxSaturationImage, bool);
   itkBooleanMacro(SetMaxSaturationImage);
 
+  /**Set/Get whether the filter, when running until convergence, only
+  * updates the active set: the voxels of the ROI that have a changed voxel
+  * in their neighborhood. The first iteration updates the whole ROI, the
+  * following ones only the voxels along the moving front. Active voxels are
+  * updated in chunks by multiple threads and the filter converges when an
+  * iteration changes no voxel. Default setting is off.
+  *
+  * The results are not identical to the iterations over the whole ROI.
+  * Those update the voxels in place, so a voxel may already see the values
+  * of neighbors updated earlier in the same iteration. The active set
+  * computes all voxels of an iteration from the values of the previous
+  * iteration, independently of the thread split. The front can therefore
+  * advance at a different pace and competing labels may settle on slightly
+  * different boundaries and strengths.
+  **/
+  itkSetMacro(UseActiveSet, bool);
+  itkGetConstMacro(UseActiveSet, bool);
+  itkBooleanMacro(UseActiveSet);
+
  protected:
 
   GrowCutSegmentationImageFilter();
@@ -302,6 +323,40 @@ template<class TInputImage,
 
   void MaskSegmentedImageByWeight(float upperThresh);
 
+  /** New values of an active voxel computed by an iteration **/
+  struct ActiveVoxelUpdate
+  {
+    OutputPixelType Label;
+    OutputPixelType State;
+    WeightPixelType Weight;
+    WeightPixelType MaxSaturation;
+  };
+
+  /** Buffers and neighborhood shared by the threads of an active set iteration **/
+  struct ActiveSetStruct
+  {
+    const Self *Filter;
+    const OutputImageType *Geometry;
+    const InputPixelType *Input;
+    const WeightPixelType *Distances;
+    const OutputPixelType *Labels;
+    const OutputPixelType *States;
+    const WeightPixelType *Weights;
+    const WeightPixelType *MaxSaturations;
+    std::vector< typename OutputImageType::OffsetType > NeighborSteps;
+    std::vector< OffsetValueType > NeighborOffsets;
+    const std::vector< OffsetValueType > *ActiveVoxels;
+    std::vector< ActiveVoxelUpdate > *Updates;
+  };
+
+  void RunActiveSetIterations(InputImageType *inputImage, OutputImageType *stateImage,
+                              WeightImageType *distancesImage, WeightImageType *maxSaturationImage,
+                              bool converged, IterationReporter &iterate);
+
+  void UpdateActiveVoxel(const ActiveSetStruct &str, OffsetValueType voxel, ActiveVoxelUpdate &update) const;
+
+  static ITK_THREAD_RETURN_TYPE ActiveSetThreaderCallback(void *arg);
+
 
   WeightPixelType                            m_ConfThresh;
   InputSizeType                              m_Radius;
@@ -316,6 +371,7 @@ template<class TInputImage,
   bool                                       m_SetStateImage;
   bool                                       m_SetDistancesImage;
   bool                                       m_SetMaxSaturationImage;
+  bool                                       m_UseActiveSet;
 
   unsigned int                               m_MaxIterations;
   unsigned int                               m_ObjectRadius;
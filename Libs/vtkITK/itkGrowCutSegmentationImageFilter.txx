@@ -54,6 +54,8 @@ GrowCutSegmentationImageFilter<TInputImage, TOutputImage, TWeightPixelType>
 
   m_SetMaxSaturationImage = false;
 
+  m_UseActiveSet = false;
+
   m_ConfThresh = 0.2;
 
   m_MaxIterations = 500;
@@ -86,6 +88,7 @@ GrowCutSegmentationImageFilter<TInputImage, TOutputImage, TWeightPixelType>
   //   os << indent << "max enemies for attack T1 : " << m_T1<< std::endl;
   // os << indent << "min enemies for submit T2 : " << m_T2<< std::endl;
   os << indent << "starting seed strength :" <<m_SeedStrength<< std::endl;
+  os << indent << "use active set : " << m_UseActiveSet << std::endl;
   //os << indent << "use Algorithm Speed Slow : " << m_UseSlow<< std::endl;
 }
 
@@ -552,6 +555,21 @@ GrowCutSegmentationImageFilter<TInputImage, TOutputImage, TWeightPixelType>
 
   /////////////////////////////////////////////////////////////////
 
+  if(m_UseActiveSet)
+    {
+    // images set by the caller are updated in place, as by the single iteration filter
+    this->RunActiveSetIterations(inputImage,
+                                 m_SetStateImage ? this->GetStateImage().GetPointer() : pixelStateImage.GetPointer(),
+                                 m_SetDistancesImage ? this->GetDistancesImage().GetPointer() : maxDistancesImage.GetPointer(),
+                                 m_SetMaxSaturationImage ? this->GetMaxSaturationImage().GetPointer() : maxSaturationImage.GetPointer(),
+                                 converged, iterate);
+    this->UpdateProgress(1.0);
+
+    this->MaskSegmentedImageByWeight(m_ConfThresh);
+    this->GraftOutput(m_LabelImage);
+    return;
+    }
+
   // Filter was configured to run until convergence. We need to delegate a different instance of the filter to run on each iteration.
   // std::cout<<" Running filter until convergence .... "<<std::endl;
 
@@ -753,6 +771,301 @@ GrowCutSegmentationImageFilter<TInputImage, TOutputImage, TWeightPixelType>
 
 
 
+template <class TInputImage, class TOutputImage, class TWeightPixelType>
+void
+GrowCutSegmentationImageFilter<TInputImage, TOutputImage, TWeightPixelType>
+::RunActiveSetIterations(InputImageType *inputImage, OutputImageType *stateImage,
+                         WeightImageType *distancesImage, WeightImageType *maxSaturationImage,
+                         bool converged, IterationReporter &iterate)
+{
+  const OutputImageRegionType region = stateImage->GetBufferedRegion();
+  const SizeValueType numberOfPixels = region.GetNumberOfPixels();
+
+  // labels and strengths are updated in new images, the inputs are not modified
+  typename OutputImageType::Pointer labelImage = OutputImageType::New();
+  labelImage->CopyInformation( stateImage );
+  labelImage->SetBufferedRegion( region );
+  labelImage->Allocate();
+  std::copy(this->GetLabelImage()->GetBufferPointer(),
+            this->GetLabelImage()->GetBufferPointer() + numberOfPixels, labelImage->GetBufferPointer());
+
+  typename WeightImageType::Pointer weightImage = WeightImageType::New();
+  weightImage->CopyInformation( stateImage );
+  weightImage->SetBufferedRegion( region );
+  weightImage->Allocate();
+  std::copy(this->GetStrengthImage()->GetBufferPointer(),
+            this->GetStrengthImage()->GetBufferPointer() + numberOfPixels, weightImage->GetBufferPointer());
+
+  m_LabelImage = labelImage;
+  m_WeightImage = weightImage;
+
+  OutputPixelType *labels = labelImage->GetBufferPointer();
+  OutputPixelType *states = stateImage->GetBufferPointer();
+  WeightPixelType *weights = weightImage->GetBufferPointer();
+  WeightPixelType *maxSaturations = maxSaturationImage->GetBufferPointer();
+
+  ActiveSetStruct str;
+  str.Filter = this;
+  str.Geometry = stateImage;
+  str.Input = inputImage->GetBufferPointer();
+  str.Distances = distancesImage->GetBufferPointer();
+  str.Labels = labels;
+  str.States = states;
+  str.Weights = weights;
+  str.MaxSaturations = maxSaturations;
+
+  // the neighborhood of radius 1, center included
+  unsigned int numberOfNeighbors = 1;
+  for (unsigned int d = 0; d < ImageDimension; d++)
+    {
+    numberOfNeighbors *= 3;
+    }
+  const typename OutputImageType::OffsetValueType *strides = stateImage->GetOffsetTable();
+  for (unsigned int n = 0; n < numberOfNeighbors; n++)
+    {
+    typename OutputImageType::OffsetType step;
+    OffsetValueType offset = 0;
+    unsigned int m = n;
+    for (unsigned int d = 0; d < ImageDimension; d++)
+      {
+      step[d] = static_cast< OffsetValueType >(m % 3) - 1;
+      offset += step[d] * strides[d];
+      m /= 3;
+      }
+    str.NeighborSteps.push_back(step);
+    str.NeighborOffsets.push_back(offset);
+    }
+
+  // only voxels of the ROI are updated
+  typename OutputImageType::SizeType roiSize;
+  for (unsigned int d = 0; d < ImageDimension; d++)
+    {
+    roiSize[d] = (m_roiEnd[d] >= m_roiStart[d]) ? static_cast< SizeValueType >(m_roiEnd[d] - m_roiStart[d] + 1) : 0;
+    }
+  OutputImageRegionType roi(m_roiStart, roiSize);
+  if(!roi.Crop(region))
+    {
+    converged = true;
+    }
+
+  // the first iteration updates every voxel of the ROI
+  std::vector< OffsetValueType > activeVoxels;
+  std::vector< OffsetValueType > nextActiveVoxels;
+  if(!converged)
+    {
+    activeVoxels.reserve(roi.GetNumberOfPixels());
+    ImageRegionConstIteratorWithIndex< OutputImageType > roiIt(stateImage, roi);
+    for(roiIt.GoToBegin(); !roiIt.IsAtEnd(); ++roiIt)
+      {
+      activeVoxels.push_back(stateImage->ComputeOffset(roiIt.GetIndex()));
+      }
+    }
+
+  std::vector< ActiveVoxelUpdate > updates;
+  str.ActiveVoxels = &activeVoxels;
+  str.Updates = &updates;
+
+  // marks the voxels already queued for the next iteration
+  std::vector< unsigned char > queued(numberOfPixels, 0);
+
+  // small active sets are not worth splitting between threads
+  const SizeValueType minimumChunkSize = 4096;
+
+  float progress = 0.0;
+  unsigned int iter = 0;
+  while (iter < m_MaxIterations && !converged)
+    {
+    // compute the new values of all active voxels from the current ones
+    updates.resize(activeVoxels.size());
+    ThreadIdType numberOfThreads = static_cast< ThreadIdType >(
+      std::min< SizeValueType >(this->GetNumberOfThreads(), activeVoxels.size() / minimumChunkSize + 1));
+    this->GetMultiThreader()->SetNumberOfThreads(numberOfThreads);
+    this->GetMultiThreader()->SetSingleMethod(Self::ActiveSetThreaderCallback, &str);
+    this->GetMultiThreader()->SingleMethodExecute();
+
+    // apply the new values and queue the neighborhood of each changed voxel
+    SizeValueType numberOfChanges = 0;
+    nextActiveVoxels.clear();
+    for (std::size_t k = 0; k < activeVoxels.size(); k++)
+      {
+      const OffsetValueType voxel = activeVoxels[k];
+      const ActiveVoxelUpdate &update = updates[k];
+      if(labels[voxel] == update.Label && states[voxel] == update.State &&
+         weights[voxel] == update.Weight && maxSaturations[voxel] == update.MaxSaturation)
+        {
+        continue;
+        }
+      labels[voxel] = update.Label;
+      states[voxel] = update.State;
+      weights[voxel] = update.Weight;
+      maxSaturations[voxel] = update.MaxSaturation;
+      ++numberOfChanges;
+
+      const typename OutputImageType::IndexType index = stateImage->ComputeIndex(voxel);
+      for (unsigned int n = 0; n < numberOfNeighbors; n++)
+        {
+        const OffsetValueType neighbor = voxel + str.NeighborOffsets[n];
+        if(!roi.IsInside(index + str.NeighborSteps[n]) || queued[neighbor])
+          {
+          continue;
+          }
+        queued[neighbor] = 1;
+        nextActiveVoxels.push_back(neighbor);
+        }
+      }
+
+    // keep the active voxels in memory order
+    std::sort(nextActiveVoxels.begin(), nextActiveVoxels.end());
+    for (std::size_t k = 0; k < nextActiveVoxels.size(); k++)
+      {
+      queued[nextActiveVoxels[k]] = 0;
+      }
+    activeVoxels.swap(nextActiveVoxels);
+
+    converged = (numberOfChanges == 0);
+    ++iter;
+    iterate.CompletedStep();
+
+    progress = std::max(progress, 1.0f - activeVoxels.size() / static_cast< float >(roi.GetNumberOfPixels()));
+    this->UpdateProgress(progress);
+    }
+}
+
+template <class TInputImage, class TOutputImage, class TWeightPixelType>
+ITK_THREAD_RETURN_TYPE
+GrowCutSegmentationImageFilter<TInputImage, TOutputImage, TWeightPixelType>
+::ActiveSetThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >(arg);
+  ActiveSetStruct *str = static_cast< ActiveSetStruct * >(info->UserData);
+
+  // each thread updates a contiguous chunk of the active voxels
+  const std::size_t numberOfActiveVoxels = str->ActiveVoxels->size();
+  const std::size_t first = (numberOfActiveVoxels * info->ThreadID) / info->NumberOfThreads;
+  const std::size_t last = (numberOfActiveVoxels * (info->ThreadID + 1)) / info->NumberOfThreads;
+  for (std::size_t k = first; k < last; k++)
+    {
+    str->Filter->UpdateActiveVoxel(*str, (*str->ActiveVoxels)[k], (*str->Updates)[k]);
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+/** Same update rule as ThreadedGenerateData, but all values are read
+ * from the previous iteration: the result does not depend on the order in
+ * which the voxels are updated. **/
+template <class TInputImage, class TOutputImage, class TWeightPixelType>
+void
+GrowCutSegmentationImageFilter<TInputImage, TOutputImage, TWeightPixelType>
+::UpdateActiveVoxel(const ActiveSetStruct &str, OffsetValueType voxel, ActiveVoxelUpdate &update) const
+{
+  const OutputPixelType s_center = str.States[voxel];
+  const OutputPixelType l_center = str.Labels[voxel];
+  const WeightPixelType w_center = str.Weights[voxel];
+
+  update.Label = l_center;
+  update.State = s_center;
+  update.Weight = w_center;
+  update.MaxSaturation = str.MaxSaturations[voxel];
+
+  if(s_center == SATURATED)
+    {
+    return;
+    }
+
+  const InputPixelType minI = NumericTraits< InputPixelType > ::min(InputPixelType());
+  const WeightPixelType minW = NumericTraits< WeightPixelType > ::min(WeightPixelType());
+
+  const typename OutputImageType::IndexType index = str.Geometry->ComputeIndex(voxel);
+  const OutputImageRegionType &region = str.Geometry->GetBufferedRegion();
+
+  InputPixelType f_center = str.Input[voxel];
+
+  OutputPixelType winnerLabel = l_center;
+  WeightPixelType winnerWeight = w_center;
+
+  WeightPixelType maxDist = str.Distances[voxel];
+
+  unsigned int countSaturatedLinks = 0;
+  unsigned int countLocalSaturatedLinks = 0;
+
+  bool modified = false;
+  WeightPixelType maxWt = 0.0;
+
+  unsigned int nlinks = 0;
+
+  for (unsigned k = 0; k < str.NeighborOffsets.size(); k++)
+    {
+    // neighbors outside of the image are skipped, as with the constant boundary condition
+    if(!region.IsInside(index + str.NeighborSteps[k]))
+      {
+      continue;
+      }
+    const OffsetValueType neighbor = voxel + str.NeighborOffsets[k];
+
+    InputPixelType f = str.Input[neighbor];
+    WeightPixelType w = str.Weights[neighbor];
+
+    if(f == minI && w == minW)
+      {
+      continue;
+      }
+
+    OutputPixelType s = str.States[neighbor];
+    OutputPixelType l = str.Labels[neighbor];
+
+    ++nlinks;
+
+    WeightPixelType attackWeight = (f_center - f)*(f_center - f);
+    attackWeight = (maxDist > 0) ? (1.0 - attackWeight/maxDist) : 1.0;
+
+    WeightPixelType msat = str.MaxSaturations[neighbor];
+
+    WeightPixelType maxAttackWeight = (s == UNLABELED) ? 0.0 :
+      ((msat == 0.0) ? (attackWeight * this->GetSeedStrength()) :
+       ((s == SATURATED) ? attackWeight * w : attackWeight*msat ) );
+
+    attackWeight *= w;
+
+    maxWt = (maxWt < maxAttackWeight) ? maxAttackWeight : maxWt;
+
+    if(s_center != UNLABELED)
+      {
+      countSaturatedLinks += (maxAttackWeight <= w_center) ? 1 : 0;
+      countLocalSaturatedLinks += (attackWeight <= w_center) ? 1 : 0;
+      }
+
+    if(s != UNLABELED && attackWeight > winnerWeight)
+      {
+      winnerWeight = attackWeight;
+      winnerLabel = l;
+      modified = true;
+      update.State = LABELED;
+      }
+    }
+
+  if(nlinks > 0)
+    {
+    if(countSaturatedLinks == nlinks && winnerLabel != m_UnknownLabel)
+      {
+      update.State = SATURATED;
+      }
+    else if(countLocalSaturatedLinks == nlinks && winnerLabel != m_UnknownLabel)
+      {
+      update.State = LOCALLY_SATURATED;
+      }
+    else if(s_center != UNLABELED && !modified)
+      {
+      update.State = LOCALLY_SATURATED;
+      }
+    }
+
+  update.MaxSaturation = maxWt;
+  update.Label = winnerLabel;
+  update.Weight = winnerWeight;
+}
+
+
 template <class TInputImage, class TOutputImage, class TWeightPixelType>
 void GrowCutSegmentationImageFilter<TInputImage, TOutputImage, TWeightPixelType>
   ::ThreadedGenerateData( const OutputImageRegionType &outputRegionForThread,
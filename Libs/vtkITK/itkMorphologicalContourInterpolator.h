@@ -126,6 +126,24 @@ public:
   *   Default is OFF (that is, use repeated dilations). */
   itkGetConstMacro( UseDistanceTransform, bool );
 
+  /** Build all intermediate slices between two labeled slices at once by blending
+  *   the signed distance fields of the aligned regions, instead of recursively
+  *   computing median slices. Distance fields are computed only once for each
+  *   pair of corresponding regions. Default is OFF. */
+  itkSetMacro( UseDistanceFieldBlending, bool );
+
+  /** Build all intermediate slices between two labeled slices at once by blending
+  *   the signed distance fields of the aligned regions, instead of recursively
+  *   computing median slices. Distance fields are computed only once for each
+  *   pair of corresponding regions. Default is OFF. */
+  itkGetMacro( UseDistanceFieldBlending, bool );
+
+  /** Build all intermediate slices between two labeled slices at once by blending
+  *   the signed distance fields of the aligned regions, instead of recursively
+  *   computing median slices. Distance fields are computed only once for each
+  *   pair of corresponding regions. Default is OFF. */
+  itkGetConstMacro( UseDistanceFieldBlending, bool );
+
   /** Use custom slice positions (not slice auto-detection).
   *   SetLabeledSliceIndices has to be called prior to Update(). */
   itkSetMacro( UseCustomSlicePositions, bool );
@@ -220,6 +238,7 @@ protected:
   int                        m_Axis;
   bool                       m_HeuristicAlignment;
   bool                       m_UseDistanceTransform;
+  bool                       m_UseDistanceFieldBlending;
   bool                       m_UseBallStructuringElement;
   bool                       m_UseCustomSlicePositions;
   IdentifierType             m_MinAlignIters; // minimum number of iterations in align method
@@ -295,6 +314,21 @@ protected:
     typename BoolSliceType::Pointer& jMask,
     ThreadIdType threadId );
 
+  /** Writes all slices strictly between i and j by linear blending of the signed
+  distance fields of the aligned masks. The masks are moved from the position of
+  slice i (at -iTrans) to the position of slice j (at -jTrans) gradually. */
+  void
+  InterpolateDistanceFields( int axis,
+    TImage* out,
+    typename TImage::PixelType label,
+    typename TImage::IndexValueType i,
+    typename TImage::IndexValueType j,
+    typename BoolSliceType::Pointer& iMask,
+    typename BoolSliceType::Pointer& jMask,
+    const typename SliceType::IndexType& iTrans,
+    const typename SliceType::IndexType& jTrans,
+    ThreadIdType threadId );
+
   /** Build transition sequence and pick the median */
   void
   Interpolate1to1( int axis,
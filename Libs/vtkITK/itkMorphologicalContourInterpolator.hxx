@@ -26,6 +26,7 @@
 #include "itkImageAlgorithm.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkImageRegionIterator.h"
+#include "itkMath.h"
 #include "itkMorphologicalContourInterpolator.h"
 #include "itkMultiThreader.h"
 #include "itkObjectFactory.h"
@@ -144,6 +145,7 @@ MorphologicalContourInterpolator< TImage >
   m_Axis( -1 ),
   m_HeuristicAlignment( true ),
   m_UseDistanceTransform( true ),
+  m_UseDistanceFieldBlending( false ),
   m_UseBallStructuringElement( false ),
   m_UseCustomSlicePositions( false ),
   m_MinAlignIters( pow( 2, TImage::ImageDimension ) ), // smaller of this and pixel count of the search image
@@ -603,6 +605,76 @@ MorphologicalContourInterpolator< TImage >
   return median;
 } // >::FindMedianImageDistances
 
+template< typename TImage >
+void
+MorphologicalContourInterpolator< TImage >
+::InterpolateDistanceFields( int axis,
+  TImage* out,
+  typename TImage::PixelType label,
+  typename TImage::IndexValueType i,
+  typename TImage::IndexValueType j,
+  typename BoolSliceType::Pointer& iMask,
+  typename BoolSliceType::Pointer& jMask,
+  const typename SliceType::IndexType& iTrans,
+  const typename SliceType::IndexType& jTrans,
+  ThreadIdType threadId )
+{
+  // distance fields of both masks are computed only once
+  typename FloatSliceType::Pointer iSdf = MaurerDM( iMask, threadId );
+  iSdf->DisconnectPipeline();
+  typename FloatSliceType::Pointer jSdf = MaurerDM( jMask, threadId );
+  jSdf->DisconnectPipeline();
+
+  // blending of two distance fields is negative only where at least one of them
+  // is negative, so interpolated shapes are within the region of the masks
+  const typename SliceType::RegionType region = iMask->GetRequestedRegion();
+  const typename TImage::RegionType reqRegion = this->GetOutput()->GetRequestedRegion();
+  const typename TImage::IndexValueType first = std::min( i, j ) + 1;
+  const typename TImage::IndexValueType last = std::max( i, j ) - 1;
+
+  static SimpleFastMutexLock mutex;
+  for ( typename TImage::IndexValueType k = first; k <= last; k++ )
+    {
+    if ( k < reqRegion.GetIndex( axis ) || k >= reqRegion.GetIndex( axis ) + IndexValueType( reqRegion.GetSize( axis ) ) )
+      {
+      continue; // slice is not requested
+      }
+    const float t = float( k - i ) / float( j - i );
+
+    // translation of the aligned masks back to the position of slice k
+    typename SliceType::IndexType shift;
+    for ( unsigned d = 0; d < SliceType::ImageDimension; d++ )
+      {
+      shift[d] = -Math::Round< IndexValueType >( ( 1.0f - t ) * iTrans[d] + t * jTrans[d] );
+      }
+
+    ImageRegionConstIteratorWithIndex< FloatSliceType > iIt( iSdf, region );
+    ImageRegionConstIterator< FloatSliceType > jIt( jSdf, region );
+    // writing through one RLEImage iterator invalidates all the others
+    // so this whole writing loop needs to be serialized
+    mutex.Lock();
+    for ( ; !iIt.IsAtEnd(); ++iIt, ++jIt )
+      {
+      if ( ( 1.0f - t ) * iIt.Get() + t * jIt.Get() > 0.0f )
+        {
+        continue; // outside of interpolated shape
+        }
+      const typename SliceType::IndexType sliceIndex = iIt.GetIndex();
+      typename TImage::IndexType outIndex;
+      for ( int d = 0; d < int(TImage::ImageDimension) - 1; d++ )
+        {
+        outIndex[d < axis ? d : d + 1] = sliceIndex[d] + shift[d];
+        }
+      outIndex[axis] = k;
+      if ( reqRegion.IsInside( outIndex ) && out->GetPixel( outIndex ) < label )
+        {
+        out->SetPixel( outIndex, label );
+        }
+      }
+    mutex.Unlock();
+    }
+} // >::InterpolateDistanceFields
+
 template< typename TImage >
 typename MorphologicalContourInterpolator< TImage >::SliceType::RegionType
 MorphologicalContourInterpolator< TImage >
@@ -744,6 +816,13 @@ MorphologicalContourInterpolator< TImage >
     ++jbIt;
     }
 
+  if ( m_UseDistanceFieldBlending )
+    {
+    // all the intermediate slices are generated at once, no recursion is needed
+    InterpolateDistanceFields( axis, out, label, i, j, iSlice, jSlice, iTrans, jTrans, threadId );
+    return;
+    }
+
   // create intersection
   typedef AndImageFilter< BoolSliceType > AndSliceType;
   static std::vector< bool > initialized( m_ThreadCount ); // default: false
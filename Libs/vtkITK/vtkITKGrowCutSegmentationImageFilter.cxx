@@ -298,6 +298,10 @@ void vtkITKImageGrowCutExecute3D(vtkImageData *inData,
 
   filter->SetSeedStrength( contrastNoiseRatio );
   filter->SetObjectRadius((unsigned int)ObjectSize);
+  // only update the voxels along the moving front. Each iteration reads the values of the
+  // previous one instead of updating in place, so boundaries between labels may differ slightly
+  // from the full ROI iterations.
+  filter->UseActiveSetOn();
 
   filter->Update();
   outputImageROI = filter->GetOutput();
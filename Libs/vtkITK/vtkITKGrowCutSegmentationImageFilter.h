@@ -24,6 +24,10 @@ class vtkImageData;
 ///
 /// This filter is implemented only for scalar images gray scale images.
 /// The current implementation supports n-class segmentation.
+///
+/// The ITK filter runs with UseActiveSet on: only the voxels along the moving front are
+/// updated, from the values of the previous iteration. Boundaries between labels may
+/// differ slightly from the in-place iterations over the whole region of interest.
 class VTK_ITK_EXPORT vtkITKGrowCutSegmentationImageFilter : public vtkImageAlgorithm
 {
 public:
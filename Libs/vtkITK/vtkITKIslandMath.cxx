@@ -19,12 +19,16 @@
 #include "vtkPointData.h"
 #include "vtkImageData.h"
 #include "vtkAlgorithm.h"
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
 #include <vtkVersion.h>
 
 #include "itkConnectedComponentImageFilter.h"
-#include "itkRelabelComponentImageFilter.h"
 #include "itkCommand.h"
 
+#include <algorithm>
+#include <map>
+
 vtkStandardNewMacro(vtkITKIslandMath);
 
 vtkITKIslandMath::vtkITKIslandMath()
@@ -54,6 +58,147 @@ void vtkITKIslandMath::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "OriginalNumberOfIslands: " << OriginalNumberOfIslands << std::endl;
 }
 
+vtkIdType vtkITKIslandMath::GetIslandSize(unsigned long island)
+{
+  if (island < 1 || island > this->IslandSizes.size())
+    {
+    vtkErrorMacro("GetIslandSize: invalid island " << island);
+    return 0;
+    }
+  return this->IslandSizes[island - 1];
+}
+
+void vtkITKIslandMath::GetIslandExtent(unsigned long island, int extent[6])
+{
+  if (island < 1 || island > this->IslandSizes.size())
+    {
+    vtkErrorMacro("GetIslandExtent: invalid island " << island);
+    extent[0] = extent[2] = extent[4] = 0;
+    extent[1] = extent[3] = extent[5] = -1;
+    return;
+    }
+  std::copy(this->IslandExtents.begin() + (island - 1) * 6, this->IslandExtents.begin() + island * 6, extent);
+}
+
+namespace
+{
+
+// Number of voxels and bounding box (in voxel index) of one island
+struct IslandStatistics
+{
+  IslandStatistics()
+  : Size(0)
+  {
+    this->Extent[0] = this->Extent[2] = this->Extent[4] = VTK_INT_MAX;
+    this->Extent[1] = this->Extent[3] = this->Extent[5] = VTK_INT_MIN;
+  }
+  vtkIdType Size;
+  int Extent[6];
+};
+
+// Statistics of the islands found by one thread, indexed by component label
+typedef std::map<unsigned long, IslandStatistics> IslandStatisticsMap;
+
+// Accumulates size and bounding box of the islands of a range of slices.
+// Each thread only stores the islands that it has seen: noisy images can have
+// millions of islands, most of them within a few slices.
+template <class T>
+class IslandStatisticsFunctor
+{
+public:
+  IslandStatisticsFunctor(const T* componentPtr, const int dims[3])
+  : ComponentPtr(componentPtr)
+  {
+    std::copy(dims, dims + 3, this->Dims);
+  }
+
+  void operator()(vtkIdType beginK, vtkIdType endK)
+  {
+    IslandStatisticsMap& statistics = this->Statistics.Local();
+    // consecutive voxels mostly belong to the same island, the map is only searched when the island changes
+    unsigned long lastComponent = 0;
+    IslandStatistics* island = NULL;
+    for (int k = static_cast<int>(beginK); k < endK; k++)
+      {
+      const T* componentPtr = this->ComponentPtr + static_cast<vtkIdType>(k) * this->Dims[0] * this->Dims[1];
+      for (int j = 0; j < this->Dims[1]; j++)
+        {
+        for (int i = 0; i < this->Dims[0]; i++, componentPtr++)
+          {
+          if (*componentPtr == 0)
+            {
+            continue;
+            }
+          unsigned long component = static_cast<unsigned long>(*componentPtr);
+          if (component != lastComponent)
+            {
+            island = &statistics[component];
+            lastComponent = component;
+            }
+          island->Size++;
+          island->Extent[0] = std::min(island->Extent[0], i);
+          island->Extent[1] = std::max(island->Extent[1], i);
+          island->Extent[2] = std::min(island->Extent[2], j);
+          island->Extent[3] = std::max(island->Extent[3], j);
+          island->Extent[4] = std::min(island->Extent[4], k);
+          island->Extent[5] = std::max(island->Extent[5], k);
+          }
+        }
+      }
+  }
+
+  vtkSMPThreadLocal<IslandStatisticsMap> Statistics;
+
+protected:
+  const T* ComponentPtr;
+  int Dims[3];
+};
+
+// Writes output label of each voxel for a range of slices
+template <class T>
+class RelabelFunctor
+{
+public:
+  RelabelFunctor(const T* componentPtr, T* outPtr, vtkIdType numberOfVoxelsPerSlice, const std::vector<T>& outputLabels)
+  : ComponentPtr(componentPtr)
+  , OutPtr(outPtr)
+  , NumberOfVoxelsPerSlice(numberOfVoxelsPerSlice)
+  , OutputLabels(outputLabels)
+  {
+  }
+
+  void operator()(vtkIdType beginK, vtkIdType endK)
+  {
+    vtkIdType endIndex = endK * this->NumberOfVoxelsPerSlice;
+    for (vtkIdType index = beginK * this->NumberOfVoxelsPerSlice; index < endIndex; index++)
+      {
+      this->OutPtr[index] = this->OutputLabels[static_cast<unsigned long>(this->ComponentPtr[index])];
+      }
+  }
+
+protected:
+  const T* ComponentPtr;
+  T* OutPtr;
+  vtkIdType NumberOfVoxelsPerSlice;
+  const std::vector<T>& OutputLabels;
+};
+
+// Orders islands by decreasing size, islands of the same size keep their original order
+struct IslandSizeGreater
+{
+  IslandSizeGreater(const std::vector<IslandStatistics>& statistics)
+  : Statistics(statistics)
+  {
+  }
+  bool operator()(unsigned long a, unsigned long b) const
+  {
+    return this->Statistics[a].Size > this->Statistics[b].Size;
+  }
+  const std::vector<IslandStatistics>& Statistics;
+};
+
+} // end of anonymous namespace
+
 // Note: local function not method - conforms to signature in itkCommand.h
 void vtkITKIslandMathHandleProgressEvent (itk::Object *caller,
                                           const itk::EventObject& vtkNotUsed(eventObject),
@@ -70,7 +215,8 @@ void vtkITKIslandMathHandleProgressEvent (itk::Object *caller,
 template <class T>
 void vtkITKIslandMathExecute(vtkITKIslandMath *self, vtkImageData* input,
                 vtkImageData* vtkNotUsed(output),
-                T* inPtr, T* outPtr)
+                T* inPtr, T* outPtr,
+                std::vector<vtkIdType>& islandSizes, std::vector<int>& islandExtents)
 {
 
   int dims[3];
@@ -103,27 +249,72 @@ void vtkITKIslandMathExecute(vtkITKIslandMath *self, vtkImageData* input,
 
   // Calculate the island operation
   // ccfilter - identifies the islands
-  // relabel - sorts them by size
   typedef itk::ConnectedComponentImageFilter<ImageType, ImageType> ConnectedComponentType;
   typename ConnectedComponentType::Pointer ccfilter = ConnectedComponentType::New();
-  typedef itk::RelabelComponentImageFilter<ImageType, ImageType> RelabelComponentType;
-  typename RelabelComponentType::Pointer relabel = RelabelComponentType::New();
 
   ccfilter->AddObserver(itk::ProgressEvent(), progressCommand);
-  relabel->AddObserver(itk::ProgressEvent(), progressCommand);
 
   ccfilter->SetFullyConnected(self->GetFullyConnected());
   ccfilter->SetInput( inImage );
-  relabel->SetInput( ccfilter->GetOutput() );
-  relabel->SetMinimumObjectSize( self->GetMinimumSize() );
-  relabel->Update();
-  self->SetNumberOfIslands(relabel->GetNumberOfObjects());
-  self->SetOriginalNumberOfIslands(relabel->GetOriginalNumberOfObjects());
+  ccfilter->Update();
+  const T* componentPtr = ccfilter->GetOutput()->GetBufferPointer();
+  unsigned long originalNumberOfIslands = static_cast<unsigned long>(ccfilter->GetObjectCount());
+
+  // Size and bounding box of all islands in one pass
+  IslandStatisticsFunctor<T> statisticsFunctor(componentPtr, dims);
+  vtkSMPTools::For(0, dims[2], statisticsFunctor);
+  // Only islands seen by a thread are merged, islands spanning several slabs are merged once per thread
+  std::vector<IslandStatistics> statistics(originalNumberOfIslands + 1);
+  typedef vtkSMPThreadLocal<IslandStatisticsMap> ThreadLocalStatisticsType;
+  for (typename ThreadLocalStatisticsType::iterator threadIt = statisticsFunctor.Statistics.begin();
+    threadIt != statisticsFunctor.Statistics.end(); ++threadIt)
+    {
+    for (IslandStatisticsMap::const_iterator islandIt = (*threadIt).begin(); islandIt != (*threadIt).end(); ++islandIt)
+      {
+      const IslandStatistics& threadIsland = islandIt->second;
+      IslandStatistics& island = statistics[islandIt->first];
+      island.Size += threadIsland.Size;
+      for (int axis = 0; axis < 3; axis++)
+        {
+        island.Extent[axis * 2] = std::min(island.Extent[axis * 2], threadIsland.Extent[axis * 2]);
+        island.Extent[axis * 2 + 1] = std::max(island.Extent[axis * 2 + 1], threadIsland.Extent[axis * 2 + 1]);
+        }
+      }
+    }
 
-  // Copy to the output
-  memcpy(outPtr, relabel->GetOutput()->GetBufferPointer(),
-         relabel->GetOutput()->GetBufferedRegion().GetNumberOfPixels() * sizeof(T));
+  // Sort kept islands by size (same order as itk::RelabelComponentImageFilter)
+  std::vector<unsigned long> keptComponents;
+  for (unsigned long component = 1; component <= originalNumberOfIslands; component++)
+    {
+    if (statistics[component].Size >= self->GetMinimumSize() && statistics[component].Size <= self->GetMaximumSize())
+      {
+      keptComponents.push_back(component);
+      }
+    }
+  std::stable_sort(keptComponents.begin(), keptComponents.end(), IslandSizeGreater(statistics));
+
+  std::vector<T> outputLabels(originalNumberOfIslands + 1, static_cast<T>(0));
+  int inputExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  input->GetExtent(inputExtent);
+  islandSizes.clear();
+  islandExtents.clear();
+  for (size_t islandIndex = 0; islandIndex < keptComponents.size(); islandIndex++)
+    {
+    const IslandStatistics& island = statistics[keptComponents[islandIndex]];
+    outputLabels[keptComponents[islandIndex]] = static_cast<T>(islandIndex + 1);
+    islandSizes.push_back(island.Size);
+    for (int axis = 0; axis < 3; axis++)
+      {
+      islandExtents.push_back(island.Extent[axis * 2] + inputExtent[axis * 2]);
+      islandExtents.push_back(island.Extent[axis * 2 + 1] + inputExtent[axis * 2]);
+      }
+    }
+  self->SetNumberOfIslands(static_cast<unsigned long>(keptComponents.size()));
+  self->SetOriginalNumberOfIslands(originalNumberOfIslands);
 
+  // Write sorted labels to the output
+  RelabelFunctor<T> relabelFunctor(componentPtr, outPtr, static_cast<vtkIdType>(dims[0]) * dims[1], outputLabels);
+  vtkSMPTools::For(0, dims[2], relabelFunctor);
 }
 
 
@@ -135,6 +326,9 @@ void vtkITKIslandMath::SimpleExecute(vtkImageData *input, vtkImageData *output)
 {
   vtkDebugMacro(<< "Executing Island Math");
 
+  this->IslandSizes.clear();
+  this->IslandExtents.clear();
+
   //
   // Initialize and check input
   //
@@ -159,7 +353,7 @@ void vtkITKIslandMath::SimpleExecute(vtkImageData *input, vtkImageData *output)
 #undef VTK_TYPE_USE_LONG_LONG
 #undef VTK_TYPE_USE___INT64
 
-#define CALL  vtkITKIslandMathExecute(this, input, output, static_cast<VTK_TT *>(inPtr), static_cast<VTK_TT *>(outPtr));
+#define CALL  vtkITKIslandMathExecute(this, input, output, static_cast<VTK_TT *>(inPtr), static_cast<VTK_TT *>(outPtr), this->IslandSizes, this->IslandExtents);
 
     void* inPtr = input->GetScalarPointer();
     void* outPtr = output->GetScalarPointer();
@@ -13,7 +13,14 @@
 #include "vtkITK.h"
 #include "vtkSimpleImageToImageFilter.h"
 
+#include <vector>
+
 /// \brief ITK-based utilities for manipulating connected regions in label maps.
+///
+/// Islands are identified by itk::ConnectedComponentImageFilter. Size and bounding box
+/// of all islands are then computed in a single pass and the kept islands are written
+/// to the output in a second pass, both in parallel blocks of slices. Output labels
+/// are sorted by island size: the largest island gets label 1.
 class VTK_ITK_EXPORT vtkITKIslandMath : public vtkSimpleImageToImageFilter
 {
  public:
@@ -55,6 +62,15 @@ class VTK_ITK_EXPORT vtkITKIslandMath : public vtkSimpleImageToImageFilter
   vtkGetMacro(OriginalNumberOfIslands, unsigned long);
   vtkSetMacro(OriginalNumberOfIslands, unsigned long);
 
+  ///
+  /// Number of voxels in the island that has the specified label in the output (1 <= island <= NumberOfIslands)
+  vtkIdType GetIslandSize(unsigned long island);
+
+  ///
+  /// Extent of the island that has the specified label in the output (1 <= island <= NumberOfIslands).
+  /// Allows processing islands in their bounding box instead of the full output.
+  void GetIslandExtent(unsigned long island, int extent[6]);
+
 
 protected:
   vtkITKIslandMath();
@@ -70,6 +86,11 @@ protected:
   unsigned long NumberOfIslands;
   unsigned long OriginalNumberOfIslands;
 
+  /// Size of each island of the output, first element is for label 1
+  std::vector<vtkIdType> IslandSizes;
+  /// Extent of each island of the output (6 values per island), first element is for label 1
+  std::vector<int> IslandExtents;
+
 private:
   vtkITKIslandMath(const vtkITKIslandMath&);  /// Not implemented.
   void operator=(const vtkITKIslandMath&);  /// Not implemented.
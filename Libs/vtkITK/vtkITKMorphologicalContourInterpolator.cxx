@@ -28,6 +28,7 @@ vtkITKMorphologicalContourInterpolator::vtkITKMorphologicalContourInterpolator()
   , Axis(-1)
   , HeuristicAlignment(true)
   , UseDistanceTransform(false)
+  , UseDistanceFieldBlending(false)
   , UseBallStructuringElement(false)
 {
 }
@@ -75,6 +76,7 @@ void vtkITKMorphologicalContourInterpolatorExecute(vtkITKMorphologicalContourInt
   interpolatorFilter->SetAxis(self->GetAxis());
   interpolatorFilter->SetHeuristicAlignment(self->GetHeuristicAlignment());
   interpolatorFilter->SetUseDistanceTransform(self->GetUseDistanceTransform());
+  interpolatorFilter->SetUseDistanceFieldBlending(self->GetUseDistanceFieldBlending());
   interpolatorFilter->SetUseBallStructuringElement(self->GetUseBallStructuringElement());
 
   interpolatorFilter->SetInput( inImage );
@@ -151,5 +153,6 @@ void vtkITKMorphologicalContourInterpolator::PrintSelf(ostream& os, vtkIndent in
   os << indent << "Axis: " << Axis << std::endl;
   os << indent << "HeuristicAlignment: " << HeuristicAlignment << std::endl;
   os << indent << "UseDistanceTransform: " << UseDistanceTransform << std::endl;
+  os << indent << "UseDistanceFieldBlending: " << UseDistanceFieldBlending << std::endl;
   os << indent << "UseBallStructuringElement: " << UseBallStructuringElement << std::endl;
 }
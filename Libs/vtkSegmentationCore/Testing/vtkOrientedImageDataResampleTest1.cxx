@@ -0,0 +1,342 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkTransform.h>
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void CreateImage(vtkOrientedImageData* image, const int extent[6], vtkMatrix4x4* imageToWorldMatrix, double fillValue)
+{
+  image->SetExtent(const_cast<int*>(extent));
+  image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  image->SetGeometryFromImageToWorldMatrix(imageToWorldMatrix);
+  vtkOrientedImageDataResample::FillImage(image, fillValue);
+}
+
+//----------------------------------------------------------------------------
+bool IsInExtent(const int ijk[3], const int extent[6])
+{
+  return ijk[0] >= extent[0] && ijk[0] <= extent[1]
+    && ijk[1] >= extent[2] && ijk[1] <= extent[3]
+    && ijk[2] >= extent[4] && ijk[2] <= extent[5];
+}
+
+//----------------------------------------------------------------------------
+// Check each voxel of the output image: voxels that are nearest to a voxel of the modifier within modifierExtent
+// are combined with the modifier value, all other voxels keep the base value (0 outside of the base extent).
+// Voxels that are half-way between two modifier voxels are skipped, as nearest neighbor rounding is ambiguous there.
+int CheckMergedImage(int line, vtkOrientedImageData* outputImage, const int expectedOutputExtent[6],
+  const int baseExtent[6], int baseValue, vtkOrientedImageData* modifierImage, const int modifierExtent[6], int modifierValue,
+  int operation, int fillValue = 1)
+{
+  int* outputExtent = outputImage->GetExtent();
+  for (int i = 0; i < 6; i++)
+    {
+    if (outputExtent[i] != expectedOutputExtent[i])
+      {
+      std::cerr << line << ": Output extent mismatch: ("
+        << outputExtent[0] << ", " << outputExtent[1] << ", " << outputExtent[2] << ", "
+        << outputExtent[3] << ", " << outputExtent[4] << ", " << outputExtent[5] << ") expected ("
+        << expectedOutputExtent[0] << ", " << expectedOutputExtent[1] << ", " << expectedOutputExtent[2] << ", "
+        << expectedOutputExtent[3] << ", " << expectedOutputExtent[4] << ", " << expectedOutputExtent[5] << ")" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  vtkNew<vtkMatrix4x4> outputImageToWorldMatrix;
+  outputImage->GetImageToWorldMatrix(outputImageToWorldMatrix.GetPointer());
+  vtkNew<vtkMatrix4x4> worldToModifierImageMatrix;
+  modifierImage->GetWorldToImageMatrix(worldToModifierImageMatrix.GetPointer());
+  vtkNew<vtkMatrix4x4> outputToModifierImageMatrix;
+  vtkMatrix4x4::Multiply4x4(worldToModifierImageMatrix.GetPointer(), outputImageToWorldMatrix.GetPointer(), outputToModifierImageMatrix.GetPointer());
+
+  int numberOfCheckedModifiedVoxels = 0;
+  int numberOfCheckedUnmodifiedVoxels = 0;
+  for (int k = outputExtent[4]; k <= outputExtent[5]; k++)
+    {
+    for (int j = outputExtent[2]; j <= outputExtent[3]; j++)
+      {
+      for (int i = outputExtent[0]; i <= outputExtent[1]; i++)
+        {
+        double outputIjk[4] = { double(i), double(j), double(k), 1.0 };
+        double modifierIjk[4] = { 0.0, 0.0, 0.0, 1.0 };
+        outputToModifierImageMatrix->MultiplyPoint(outputIjk, modifierIjk);
+        bool ambiguous = false;
+        int nearestModifierIjk[3] = { 0, 0, 0 };
+        for (int axis = 0; axis < 3; axis++)
+          {
+          double fraction = modifierIjk[axis] - floor(modifierIjk[axis]);
+          if (fabs(fraction - 0.5) < 1e-3)
+            {
+            ambiguous = true;
+            }
+          nearestModifierIjk[axis] = static_cast<int>(floor(modifierIjk[axis] + 0.5));
+          }
+        if (ambiguous)
+          {
+          continue;
+          }
+
+        int ijk[3] = { i, j, k };
+        int expectedValue = (IsInExtent(ijk, baseExtent) ? baseValue : 0);
+        if (IsInExtent(nearestModifierIjk, modifierExtent))
+          {
+          switch (operation)
+            {
+            case vtkOrientedImageDataResample::OPERATION_MAXIMUM: expectedValue = std::max(expectedValue, modifierValue); break;
+            case vtkOrientedImageDataResample::OPERATION_MINIMUM: expectedValue = std::min(expectedValue, modifierValue); break;
+            case vtkOrientedImageDataResample::OPERATION_MASKING: expectedValue = (modifierValue > 0 ? fillValue : expectedValue); break;
+            }
+          numberOfCheckedModifiedVoxels++;
+          }
+        else
+          {
+          numberOfCheckedUnmodifiedVoxels++;
+          }
+
+        int value = static_cast<int>(outputImage->GetScalarComponentAsDouble(i, j, k, 0));
+        if (value != expectedValue)
+          {
+          std::cerr << line << ": Unexpected value " << value << " at (" << i << ", " << j << ", " << k << "), expected " << expectedValue << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+  if (numberOfCheckedModifiedVoxels == 0 || numberOfCheckedUnmodifiedVoxels == 0)
+    {
+    std::cerr << line << ": Invalid test case, modified voxels: " << numberOfCheckedModifiedVoxels
+      << ", unmodified voxels: " << numberOfCheckedUnmodifiedVoxels << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestMatchingGeometry()
+{
+  vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+  imageToWorldMatrix->SetElement(0, 0, 1.5);
+  imageToWorldMatrix->SetElement(2, 2, 2.0);
+  imageToWorldMatrix->SetElement(0, 3, 12.0);
+  imageToWorldMatrix->SetElement(1, 3, -30.0);
+
+  int baseExtent[6] = { 0, 9, 0, 9, 0, 9 };
+  int modifierExtent[6] = { 5, 14, 2, 6, -3, 4 };
+  int unionExtent[6] = { 0, 14, 0, 9, -3, 9 };
+
+  vtkNew<vtkOrientedImageData> modifierImage;
+  CreateImage(modifierImage.GetPointer(), modifierExtent, imageToWorldMatrix.GetPointer(), 3);
+
+  // Merge into separate output, extent grows
+  vtkNew<vtkOrientedImageData> baseImage;
+  CreateImage(baseImage.GetPointer(), baseExtent, imageToWorldMatrix.GetPointer(), 1);
+  vtkNew<vtkOrientedImageData> outputImage;
+  bool outputModified = false;
+  if (!vtkOrientedImageDataResample::MergeImage(baseImage.GetPointer(), modifierImage.GetPointer(), outputImage.GetPointer(),
+    vtkOrientedImageDataResample::OPERATION_MAXIMUM, NULL, 0, 1, &outputModified) || !outputModified)
+    {
+    std::cerr << __LINE__ << ": MergeImage failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (CheckMergedImage(__LINE__, outputImage.GetPointer(), unionExtent, baseExtent, 1,
+    modifierImage.GetPointer(), modifierExtent, 3, vtkOrientedImageDataResample::OPERATION_MAXIMUM) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  // Input must not be changed
+  if (baseImage->GetExtent()[1] != baseExtent[1] || baseImage->GetScalarComponentAsDouble(7, 4, 2, 0) != 1)
+    {
+    std::cerr << __LINE__ << ": MergeImage modified the input image" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Merge in place, extent grows
+  if (!vtkOrientedImageDataResample::MergeImage(baseImage.GetPointer(), modifierImage.GetPointer(), baseImage.GetPointer(),
+    vtkOrientedImageDataResample::OPERATION_MAXIMUM))
+    {
+    std::cerr << __LINE__ << ": MergeImage in place failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (CheckMergedImage(__LINE__, baseImage.GetPointer(), unionExtent, baseExtent, 1,
+    modifierImage.GetPointer(), modifierExtent, 3, vtkOrientedImageDataResample::OPERATION_MAXIMUM) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Merge in place, extent does not grow, merge is restricted to an extent
+  int restrictedModifierExtent[6] = { 5, 9, 2, 4, 0, 4 };
+  CreateImage(baseImage.GetPointer(), baseExtent, imageToWorldMatrix.GetPointer(), 1);
+  if (!vtkOrientedImageDataResample::MergeImage(baseImage.GetPointer(), modifierImage.GetPointer(), baseImage.GetPointer(),
+    vtkOrientedImageDataResample::OPERATION_MAXIMUM, restrictedModifierExtent))
+    {
+    std::cerr << __LINE__ << ": MergeImage in place with extent failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (CheckMergedImage(__LINE__, baseImage.GetPointer(), baseExtent, baseExtent, 1,
+    modifierImage.GetPointer(), restrictedModifierExtent, 3, vtkOrientedImageDataResample::OPERATION_MAXIMUM) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Modify with minimum, extent does not change, voxels outside of the modifier are unchanged
+  vtkNew<vtkOrientedImageData> erasingModifierImage;
+  CreateImage(erasingModifierImage.GetPointer(), modifierExtent, imageToWorldMatrix.GetPointer(), 0);
+  CreateImage(baseImage.GetPointer(), baseExtent, imageToWorldMatrix.GetPointer(), 1);
+  if (!vtkOrientedImageDataResample::ModifyImage(baseImage.GetPointer(), erasingModifierImage.GetPointer(),
+    vtkOrientedImageDataResample::OPERATION_MINIMUM))
+    {
+    std::cerr << __LINE__ << ": ModifyImage failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (CheckMergedImage(__LINE__, baseImage.GetPointer(), baseExtent, baseExtent, 1,
+    erasingModifierImage.GetPointer(), modifierExtent, 0, vtkOrientedImageDataResample::OPERATION_MINIMUM) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestRotatedGeometry()
+{
+  vtkNew<vtkMatrix4x4> baseImageToWorldMatrix;
+  baseImageToWorldMatrix->SetElement(0, 3, -2.0);
+
+  vtkNew<vtkTransform> modifierImageToWorldTransform;
+  modifierImageToWorldTransform->Translate(4.37, 5.21, 3.73);
+  modifierImageToWorldTransform->RotateZ(30.0);
+  modifierImageToWorldTransform->RotateX(20.0);
+  modifierImageToWorldTransform->Scale(1.3, 1.3, 1.1);
+
+  int baseExtent[6] = { 0, 19, 0, 19, 0, 19 };
+  int modifierExtent[6] = { 0, 7, 0, 7, 0, 7 };
+
+  // Modify with minimum, voxels in the corners of the bounding box of the rotated modifier must not be changed
+  vtkNew<vtkOrientedImageData> erasingModifierImage;
+  CreateImage(erasingModifierImage.GetPointer(), modifierExtent, modifierImageToWorldTransform->GetMatrix(), 0);
+  vtkNew<vtkOrientedImageData> baseImage;
+  CreateImage(baseImage.GetPointer(), baseExtent, baseImageToWorldMatrix.GetPointer(), 3);
+  if (!vtkOrientedImageDataResample::ModifyImage(baseImage.GetPointer(), erasingModifierImage.GetPointer(),
+    vtkOrientedImageDataResample::OPERATION_MINIMUM))
+    {
+    std::cerr << __LINE__ << ": ModifyImage failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (CheckMergedImage(__LINE__, baseImage.GetPointer(), baseExtent, baseExtent, 3,
+    erasingModifierImage.GetPointer(), modifierExtent, 0, vtkOrientedImageDataResample::OPERATION_MINIMUM) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Extent is specified in the IJK coordinate system of the modifier
+  int restrictedModifierExtent[6] = { 0, 3, 2, 7, 0, 7 };
+  CreateImage(baseImage.GetPointer(), baseExtent, baseImageToWorldMatrix.GetPointer(), 3);
+  if (!vtkOrientedImageDataResample::ModifyImage(baseImage.GetPointer(), erasingModifierImage.GetPointer(),
+    vtkOrientedImageDataResample::OPERATION_MINIMUM, restrictedModifierExtent))
+    {
+    std::cerr << __LINE__ << ": ModifyImage with extent failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (CheckMergedImage(__LINE__, baseImage.GetPointer(), baseExtent, baseExtent, 3,
+    erasingModifierImage.GetPointer(), restrictedModifierExtent, 0, vtkOrientedImageDataResample::OPERATION_MINIMUM) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Masking
+  vtkNew<vtkOrientedImageData> maskModifierImage;
+  CreateImage(maskModifierImage.GetPointer(), modifierExtent, modifierImageToWorldTransform->GetMatrix(), 1);
+  CreateImage(baseImage.GetPointer(), baseExtent, baseImageToWorldMatrix.GetPointer(), 3);
+  if (!vtkOrientedImageDataResample::ModifyImage(baseImage.GetPointer(), maskModifierImage.GetPointer(),
+    vtkOrientedImageDataResample::OPERATION_MASKING, NULL, 0, 7))
+    {
+    std::cerr << __LINE__ << ": ModifyImage masking failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (CheckMergedImage(__LINE__, baseImage.GetPointer(), baseExtent, baseExtent, 3,
+    maskModifierImage.GetPointer(), modifierExtent, 1, vtkOrientedImageDataResample::OPERATION_MASKING, 7) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Merge in place with maximum, extent grows to contain the bounding box of the rotated modifier
+  int smallBaseExtent[6] = { 0, 9, 0, 9, 0, 9 };
+  vtkNew<vtkOrientedImageData> paintModifierImage;
+  CreateImage(paintModifierImage.GetPointer(), modifierExtent, modifierImageToWorldTransform->GetMatrix(), 5);
+  CreateImage(baseImage.GetPointer(), smallBaseExtent, baseImageToWorldMatrix.GetPointer(), 1);
+  vtkNew<vtkTransform> modifierToBaseImageTransform;
+  vtkOrientedImageDataResample::GetTransformBetweenOrientedImages(paintModifierImage.GetPointer(), baseImage.GetPointer(), modifierToBaseImageTransform.GetPointer());
+  int unionExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  vtkOrientedImageDataResample::TransformExtent(modifierExtent, modifierToBaseImageTransform.GetPointer(), unionExtent);
+  for (int i = 0; i < 3; i++)
+    {
+    unionExtent[i * 2] = std::min(unionExtent[i * 2], smallBaseExtent[i * 2]);
+    unionExtent[i * 2 + 1] = std::max(unionExtent[i * 2 + 1], smallBaseExtent[i * 2 + 1]);
+    }
+  if (unionExtent[1] <= smallBaseExtent[1])
+    {
+    std::cerr << __LINE__ << ": Invalid test case, modifier is expected to extend beyond the base image" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!vtkOrientedImageDataResample::MergeImage(baseImage.GetPointer(), paintModifierImage.GetPointer(), baseImage.GetPointer(),
+    vtkOrientedImageDataResample::OPERATION_MAXIMUM))
+    {
+    std::cerr << __LINE__ << ": MergeImage failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (CheckMergedImage(__LINE__, baseImage.GetPointer(), unionExtent, smallBaseExtent, 1,
+    paintModifierImage.GetPointer(), modifierExtent, 5, vtkOrientedImageDataResample::OPERATION_MAXIMUM) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkOrientedImageDataResampleTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  if (TestMatchingGeometry() != EXIT_SUCCESS)
+    {
+    std::cerr << "Merging images with matching geometry failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (TestRotatedGeometry() != EXIT_SUCCESS)
+    {
+    std::cerr << "Merging images with rotated geometry failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
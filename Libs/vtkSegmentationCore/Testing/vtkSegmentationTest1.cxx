@@ -25,6 +25,8 @@
 #include <vtkSphereSource.h>
 #include <vtkMatrix4x4.h>
 #include <vtkImageAccumulate.h>
+#include <vtkPointData.h>
+#include <vtkDataArray.h>
 
 // SegmentationCore includes
 #include "vtkSegmentation.h"
@@ -283,6 +285,54 @@ int vtkSegmentationTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
     return EXIT_FAILURE;
     }
 
+  //////////////////////////////////////////////////////////////////////////
+  // Shared labelmap layers
+
+  vtkNew<vtkSegmentation> layerSegmentation;
+  layerSegmentation->SetMasterRepresentationName(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() );
+  for (int i=0; i<3; ++i)
+    {
+    // Non-overlapping slabs: segment i is foreground in z=[10*i,10*i+4]
+    vtkNew<vtkOrientedImageData> slabImageData;
+    slabImageData->SetExtent(0,9,0,9,0,29);
+    slabImageData->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    slabImageData->GetPointData()->GetScalars()->Fill(0);
+    for (int z=10*i; z<10*i+5; ++z)
+      {
+      memset(slabImageData->GetScalarPointer(0,0,z), 1, 100);
+      }
+    vtkNew<vtkSegment> slabSegment;
+    slabSegment->AddRepresentation(
+      vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), slabImageData.GetPointer());
+    layerSegmentation->AddSegment(slabSegment.GetPointer());
+    }
+  layerSegmentation->CollapseBinaryLabelmaps();
+  if (layerSegmentation->GetNumberOfLayers() != 1)
+    {
+    std::cerr << __LINE__ << ": Non-overlapping segments were not collapsed into a single layer!" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string secondSegmentId = layerSegmentation->GetNthSegmentID(1);
+  vtkNew<vtkOrientedImageData> secondSegmentLabelmap;
+  layerSegmentation->GetBinaryLabelmapRepresentation(secondSegmentId, secondSegmentLabelmap.GetPointer());
+  imageAccumulate->SetInputData(secondSegmentLabelmap.GetPointer());
+  imageAccumulate->Update();
+  if (imageAccumulate->GetMin()[0] != 1 || imageAccumulate->GetVoxelCount() != 500)
+    {
+    std::cerr << __LINE__ << ": Unexpected binary labelmap extracted from shared layer!" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Separating a segment moves it to its own layer, removing one clears its label only
+  layerSegmentation->SeparateSegmentLabelmap(secondSegmentId);
+  layerSegmentation->RemoveSegment(layerSegmentation->GetNthSegmentID(0));
+  if (layerSegmentation->GetNumberOfLayers() != 2 || layerSegmentation->GetNumberOfSegments() != 2)
+    {
+    std::cerr << __LINE__ << ": Unexpected layers after separating and removing segments!" << std::endl;
+    return EXIT_FAILURE;
+    }
+
   std::cout << "Segmentation test passed." << std::endl;
   return EXIT_SUCCESS;
 }
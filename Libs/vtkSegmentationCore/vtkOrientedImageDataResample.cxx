@@ -26,6 +26,7 @@
 // VTK includes
 #include <vtkAppendPolyData.h>
 #include <vtkGeneralTransform.h>
+#include <vtkImageCast.h>
 #include <vtkImageReslice.h>
 #include <vtkImageConstantPad.h>
 #include <vtkMatrix4x4.h>
@@ -34,6 +35,8 @@
 #include <vtkPlaneSource.h>
 #include <vtkPointData.h>
 #include <vtkSmartPointer.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
 #include <vtkTransform.h>
 #include <vtkTransformPolyDataFilter.h>
 #include <vtkVersionMacros.h>
@@ -44,6 +47,105 @@
 
 vtkStandardNewMacro(vtkOrientedImageDataResample);
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Combines the modifier image into the base image in the update extent, in place.
+/// Both images must contain the update extent. Rows are processed in parallel, so that
+/// thin extents (such as a single slice) are split between threads as well.
+template <class BaseImageScalarType, class ModifierImageScalarType>
+class MergeImageFunctor
+{
+public:
+  MergeImageFunctor(vtkImageData* baseImage, vtkImageData* modifierImage, const int updateExt[6],
+    int operation, int maskThreshold, double fillValue)
+    : BaseImage(baseImage)
+    , ModifierImage(modifierImage)
+    , Operation(operation)
+    , MaskThreshold(maskThreshold)
+    , FillValue(static_cast<BaseImageScalarType>(fillValue))
+  {
+    std::copy(updateExt, updateExt + 6, this->UpdateExt);
+    this->NumberOfScalarsPerRow = (updateExt[1] - updateExt[0] + 1) * baseImage->GetNumberOfScalarComponents();
+  }
+
+  void Initialize()
+  {
+    this->BaseImageModified.Local() = 0;
+  }
+
+  void operator()(vtkIdType rowBegin, vtkIdType rowEnd)
+  {
+    int numberOfRowsPerSlice = this->UpdateExt[3] - this->UpdateExt[2] + 1;
+    bool baseImageModified = false;
+    for (vtkIdType row = rowBegin; row < rowEnd; row++)
+      {
+      int j = this->UpdateExt[2] + static_cast<int>(row % numberOfRowsPerSlice);
+      int k = this->UpdateExt[4] + static_cast<int>(row / numberOfRowsPerSlice);
+      BaseImageScalarType* baseImagePtr = static_cast<BaseImageScalarType*>(this->BaseImage->GetScalarPointer(this->UpdateExt[0], j, k));
+      ModifierImageScalarType* modifierImagePtr = static_cast<ModifierImageScalarType*>(this->ModifierImage->GetScalarPointer(this->UpdateExt[0], j, k));
+
+      // There is difference in only one line between min/max computation but the comparison
+      // is performed for each pixel, so it is faster to make the conditional expression outside of the row loop.
+      if (this->Operation == vtkOrientedImageDataResample::OPERATION_MAXIMUM)
+        {
+        for (vtkIdType idxX = 0; idxX < this->NumberOfScalarsPerRow; idxX++, baseImagePtr++, modifierImagePtr++)
+          {
+          if (static_cast<BaseImageScalarType>(*modifierImagePtr) > *baseImagePtr)
+            {
+            *baseImagePtr = *modifierImagePtr;
+            baseImageModified = true;
+            }
+          }
+        }
+      else if (this->Operation == vtkOrientedImageDataResample::OPERATION_MINIMUM)
+        {
+        for (vtkIdType idxX = 0; idxX < this->NumberOfScalarsPerRow; idxX++, baseImagePtr++, modifierImagePtr++)
+          {
+          if (static_cast<BaseImageScalarType>(*modifierImagePtr) < *baseImagePtr)
+            {
+            *baseImagePtr = *modifierImagePtr;
+            baseImageModified = true;
+            }
+          }
+        }
+      else if (this->Operation == vtkOrientedImageDataResample::OPERATION_MASKING)
+        {
+        for (vtkIdType idxX = 0; idxX < this->NumberOfScalarsPerRow; idxX++, baseImagePtr++, modifierImagePtr++)
+          {
+          if (static_cast<int>(*modifierImagePtr) > this->MaskThreshold)
+            {
+            *baseImagePtr = this->FillValue;
+            baseImageModified = true;
+            }
+          }
+        }
+      }
+    if (baseImageModified)
+      {
+      this->BaseImageModified.Local() = 1;
+      }
+  }
+
+  void Reduce()
+  {
+  }
+
+  vtkSMPThreadLocal<unsigned char> BaseImageModified;
+
+protected:
+  vtkImageData* BaseImage;
+  vtkImageData* ModifierImage;
+  int UpdateExt[6];
+  vtkIdType NumberOfScalarsPerRow;
+  int Operation;
+  int MaskThreshold;
+  BaseImageScalarType FillValue;
+};
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 // This templated function executes the filter for any type of data.
 template <class BaseImageScalarType, class ModifierImageScalarType>
@@ -84,108 +186,30 @@ void MergeImageGeneric2(
     return;
     }
 
-  // Get increments to march through data
-  vtkIdType baseIncX = 0;
-  vtkIdType baseIncY = 0;
-  vtkIdType baseIncZ = 0;
-  vtkIdType modifierIncX = 0;
-  vtkIdType modifierIncY = 0;
-  vtkIdType modifierIncZ = 0;
-  baseImage->GetContinuousIncrements(updateExt, baseIncX, baseIncY, baseIncZ);
-  modifierImage->GetContinuousIncrements(updateExt, modifierIncX, modifierIncY, modifierIncZ);
-  int maxX = (updateExt[1] - updateExt[0]) * baseImage->GetNumberOfScalarComponents();
-  int maxY = updateExt[3] - updateExt[2];
-  int maxZ = updateExt[5] - updateExt[4];
-  BaseImageScalarType* baseImagePtr = static_cast<BaseImageScalarType*>(baseImage->GetScalarPointerForExtent(updateExt));
-  ModifierImageScalarType* modifierImagePtr = static_cast<ModifierImageScalarType*>(modifierImage->GetScalarPointerForExtent(updateExt));
-
-  if (baseImagePtr == NULL)
+  if (baseImage->GetScalarPointer() == NULL)
     {
     vtkGenericWarningMacro("vtkOrientedImageDataResample::MergeImageGeneric: Base image pointer is invalid");
     return;
     }
-  if (modifierImagePtr == NULL)
+  if (modifierImage->GetScalarPointer() == NULL)
     {
     vtkGenericWarningMacro("vtkOrientedImageDataResample::MergeImageGeneric: Modifier image pointer is invalid");
     return;
     }
 
-  bool baseImageModified = false;
+  MergeImageFunctor<BaseImageScalarType, ModifierImageScalarType> functor(
+    baseImage, modifierImage, updateExt, operation, maskThreshold, fillValue);
+  vtkIdType numberOfRows = static_cast<vtkIdType>(updateExt[3] - updateExt[2] + 1) * (updateExt[5] - updateExt[4] + 1);
+  vtkSMPTools::For(0, numberOfRows, functor);
 
-  // Loop through output pixels
-  // There is difference in only one line between min/max computation but the comparison
-  // is performed for each pixel, so it is faster to make the conditional expression in the outer loop.
-  // Looping is performed in two step: first we just check if any of the pixels have to be changed,
-  // if we find any, then we set baseImageModified flag and to the second loop without need to set
-  // baseImageModified flag again (setting a flag in a hot loop may impact speed).
-  if (operation == vtkOrientedImageDataResample::OPERATION_MAXIMUM)
-    {
-    for (vtkIdType idxZ = 0; idxZ <= maxZ; idxZ++)
-      {
-      for (vtkIdType idxY = 0; idxY <= maxY; idxY++)
-        {
-        for (vtkIdType idxX = 0; idxX <= maxX; idxX++)
-          {
-          if (static_cast<BaseImageScalarType>(*modifierImagePtr) > *baseImagePtr)
-            {
-            *baseImagePtr = *modifierImagePtr;
-            baseImageModified = true;
-            }
-          baseImagePtr++;
-          modifierImagePtr++;
-          }
-        baseImagePtr += baseIncY;
-        modifierImagePtr += modifierIncY;
-        }
-      baseImagePtr += baseIncZ;
-      modifierImagePtr += modifierIncZ;
-      }
-    }
-  else if (operation == vtkOrientedImageDataResample::OPERATION_MINIMUM)
-    {
-    for (vtkIdType idxZ = 0; idxZ <= maxZ; idxZ++)
-      {
-      for (vtkIdType idxY = 0; idxY <= maxY; idxY++)
-        {
-        for (vtkIdType idxX = 0; idxX <= maxX; idxX++)
-          {
-          if (static_cast<BaseImageScalarType>(*modifierImagePtr) < *baseImagePtr)
-            {
-            *baseImagePtr = *modifierImagePtr;
-            baseImageModified = true;
-            }
-          baseImagePtr++;
-          modifierImagePtr++;
-          }
-        baseImagePtr += baseIncY;
-        modifierImagePtr += modifierIncY;
-        }
-      baseImagePtr += baseIncZ;
-      modifierImagePtr += modifierIncZ;
-      }
-    }
-  else if (operation == vtkOrientedImageDataResample::OPERATION_MASKING)
+  // Base image is modified if any of the threads modified it
+  bool baseImageModified = false;
+  for (vtkSMPThreadLocal<unsigned char>::iterator threadIt = functor.BaseImageModified.begin();
+    threadIt != functor.BaseImageModified.end(); ++threadIt)
     {
-    BaseImageScalarType fillValueBaseImageType = static_cast<BaseImageScalarType>(fillValue);
-    for (vtkIdType idxZ = 0; idxZ <= maxZ; idxZ++)
+    if (*threadIt)
       {
-      for (vtkIdType idxY = 0; idxY <= maxY; idxY++)
-        {
-        for (vtkIdType idxX = 0; idxX <= maxX; idxX++)
-          {
-          if (static_cast<int>(*modifierImagePtr) > maskThreshold)
-            {
-            *baseImagePtr = fillValueBaseImageType;
-            baseImageModified = true;
-            }
-          baseImagePtr++;
-          modifierImagePtr++;
-        }
-        baseImagePtr += baseIncY;
-        modifierImagePtr += modifierIncY;
-        }
-      baseImagePtr += baseIncZ;
-      modifierImagePtr += modifierIncZ;
+      baseImageModified = true;
       }
     }
   if (baseImageModified)
@@ -997,6 +1021,98 @@ bool vtkOrientedImageDataResample::PadImageToContainImage(vtkOrientedImageData*
   return true;
 }
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Resample the part of modifierImage within extent (in modifierImage IJK coordinates, whole modifierImage
+/// if extent is NULL) into the geometry of baseImage with nearest neighbor interpolation. Output extent is
+/// the bounding box of this part in baseImage IJK coordinates, clipped to clipExtent if specified, so only
+/// the voxels that the modifier may change are resampled. Voxels of the bounding box that are not covered
+/// by the modifier are set to a value that leaves the base image unchanged when merged with the operation.
+/// \return False if the output extent is empty
+bool ResampleModifierToBaseGeometry(vtkOrientedImageData* baseImage, vtkOrientedImageData* modifierImage,
+  const int extent[6], const int clipExtent[6], int operation, int maskThreshold, vtkOrientedImageData* resampledModifierImage)
+{
+  int modifierExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  modifierImage->GetExtent(modifierExtent);
+  vtkOrientedImageData* modifierImageInExtent = modifierImage;
+  vtkNew<vtkOrientedImageData> croppedModifierImage;
+  if (extent)
+    {
+    // Voxels outside of extent must not get into the resampled image
+    for (int i = 0; i < 3; i++)
+      {
+      modifierExtent[i * 2] = std::max(modifierExtent[i * 2], extent[i * 2]);
+      modifierExtent[i * 2 + 1] = std::min(modifierExtent[i * 2 + 1], extent[i * 2 + 1]);
+      }
+    if (modifierExtent[0] > modifierExtent[1] || modifierExtent[2] > modifierExtent[3] || modifierExtent[4] > modifierExtent[5])
+      {
+      return false;
+      }
+    vtkOrientedImageDataResample::CopyImage(modifierImage, croppedModifierImage.GetPointer(), modifierExtent);
+    modifierImageInExtent = croppedModifierImage.GetPointer();
+    }
+  else if (modifierExtent[0] > modifierExtent[1] || modifierExtent[2] > modifierExtent[3] || modifierExtent[4] > modifierExtent[5])
+    {
+    return false;
+    }
+
+  vtkNew<vtkTransform> modifierToBaseTransform;
+  vtkOrientedImageDataResample::GetTransformBetweenOrientedImages(modifierImage, baseImage, modifierToBaseTransform.GetPointer());
+  int resampledExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  vtkOrientedImageDataResample::TransformExtent(modifierExtent, modifierToBaseTransform.GetPointer(), resampledExtent);
+  if (clipExtent)
+    {
+    for (int i = 0; i < 3; i++)
+      {
+      resampledExtent[i * 2] = std::max(resampledExtent[i * 2], clipExtent[i * 2]);
+      resampledExtent[i * 2 + 1] = std::min(resampledExtent[i * 2 + 1], clipExtent[i * 2 + 1]);
+      }
+    }
+  if (resampledExtent[0] > resampledExtent[1] || resampledExtent[2] > resampledExtent[3] || resampledExtent[4] > resampledExtent[5])
+    {
+    return false;
+    }
+
+  // Background value must not change the base image, as voxels outside of the modifier are left unchanged
+  // when geometries match
+  double backgroundValue = 0.0;
+  vtkNew<vtkOrientedImageData> castModifierImage;
+  if (operation == vtkOrientedImageDataResample::OPERATION_MAXIMUM || operation == vtkOrientedImageDataResample::OPERATION_MINIMUM)
+    {
+    // Values are compared in the scalar type of the base image, so convert the modifier to that type
+    // to be able to represent the extreme values of the base image
+    if (modifierImageInExtent->GetScalarType() != baseImage->GetScalarType())
+      {
+      vtkNew<vtkImageCast> castFilter;
+      castFilter->SetInputData(modifierImageInExtent);
+      castFilter->SetOutputScalarType(baseImage->GetScalarType());
+      castFilter->Update();
+      castModifierImage->ShallowCopy(castFilter->GetOutput());
+      castModifierImage->CopyDirections(modifierImageInExtent);
+      modifierImageInExtent = castModifierImage.GetPointer();
+      }
+    backgroundValue = (operation == vtkOrientedImageDataResample::OPERATION_MAXIMUM
+      ? baseImage->GetScalarTypeMin() : baseImage->GetScalarTypeMax());
+    }
+  else if (operation == vtkOrientedImageDataResample::OPERATION_MASKING)
+    {
+    // Only modifier voxels above the threshold fill the base image
+    backgroundValue = std::max(static_cast<double>(std::min(0, maskThreshold)), modifierImageInExtent->GetScalarTypeMin());
+    }
+
+  vtkNew<vtkMatrix4x4> baseImageToWorldMatrix;
+  baseImage->GetImageToWorldMatrix(baseImageToWorldMatrix.GetPointer());
+  vtkNew<vtkOrientedImageData> referenceImage;
+  referenceImage->SetGeometryFromImageToWorldMatrix(baseImageToWorldMatrix.GetPointer());
+  referenceImage->SetExtent(resampledExtent);
+  return vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+    modifierImageInExtent, referenceImage.GetPointer(), resampledModifierImage, false, false, NULL, backgroundValue);
+}
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 bool vtkOrientedImageDataResample::MergeImage(
     vtkOrientedImageData* inputImage,
@@ -1017,22 +1133,73 @@ bool vtkOrientedImageDataResample::MergeImage(
     return false;
     }
 
+  // Resample image to append into the geometry of the input image, only within its own extent
+  vtkOrientedImageData* modifierImage = imageToAppend;
+  vtkNew<vtkOrientedImageData> resampledImageToAppend;
   if (!vtkOrientedImageDataResample::DoGeometriesMatch(inputImage, imageToAppend))
     {
-    vtkGenericWarningMacro("vtkOrientedImageDataResample::MergeImage failed: geometry mismatch between inputImage and imageToAppend");
-    return false;
+    if (!ResampleModifierToBaseGeometry(inputImage, imageToAppend, extent, NULL,
+      operation, maskThreshold, resampledImageToAppend.GetPointer()))
+      {
+      vtkGenericWarningMacro("vtkOrientedImageDataResample::MergeImage: Failed to resample imageToAppend");
+      return false;
+      }
+    modifierImage = resampledImageToAppend.GetPointer();
+    extent = NULL;
     }
-  if (!vtkOrientedImageDataResample::PadImageToContainImage(inputImage, imageToAppend, outputImage, extent))
+
+  // Output extent is the union of the input extent and the extent to append
+  const int* appendedExtent = extent ? extent : modifierImage->GetExtent();
+  if (appendedExtent[0] > appendedExtent[1] || appendedExtent[2] > appendedExtent[3] || appendedExtent[4] > appendedExtent[5])
     {
     vtkGenericWarningMacro("vtkOrientedImageDataResample::MergeImage: Failed to pad segment labelmap");
     return false;
     }
+  int inputExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  inputImage->GetExtent(inputExtent);
+  bool inputEmpty = (inputExtent[0] > inputExtent[1] || inputExtent[2] > inputExtent[3] || inputExtent[4] > inputExtent[5]
+    || inputImage->GetScalarPointer() == NULL);
+  int unionExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  bool padRequired = inputEmpty;
+  for (int i = 0; i < 3; i++)
+    {
+    unionExtent[i * 2] = inputEmpty ? appendedExtent[i * 2] : std::min(appendedExtent[i * 2], inputExtent[i * 2]);
+    unionExtent[i * 2 + 1] = inputEmpty ? appendedExtent[i * 2 + 1] : std::max(appendedExtent[i * 2 + 1], inputExtent[i * 2 + 1]);
+    if (unionExtent[i * 2] != inputExtent[i * 2] || unionExtent[i * 2 + 1] != inputExtent[i * 2 + 1])
+      {
+      padRequired = true;
+      }
+    }
+
+  if (padRequired)
+    {
+    // Input image is copied into the padded image once, the rest is cleared
+    vtkNew<vtkMatrix4x4> inputImageToWorldMatrix;
+    inputImage->GetImageToWorldMatrix(inputImageToWorldMatrix.GetPointer());
+    vtkNew<vtkOrientedImageData> paddedImage;
+    paddedImage->SetExtent(unionExtent);
+    paddedImage->AllocateScalars(inputImage->GetScalarType(), std::max(1, inputImage->GetNumberOfScalarComponents()));
+    vtkOrientedImageDataResample::FillImage(paddedImage.GetPointer(), 0);
+    if (!inputEmpty)
+      {
+      paddedImage->CopyAndCastFrom(inputImage, inputExtent);
+      }
+    // Output may be same as input, so the geometry is set after overwriting it
+    outputImage->ShallowCopy(paddedImage.GetPointer());
+    outputImage->SetGeometryFromImageToWorldMatrix(inputImageToWorldMatrix.GetPointer());
+    }
+  else if (outputImage != inputImage)
+    {
+    outputImage->DeepCopy(inputImage);
+    }
+
+  // Merge in place
   vtkMTimeType outputImageMTimeBefore = outputImage->GetMTime();
   switch (inputImage->GetScalarType())
     {
     vtkTemplateMacro(MergeImageGeneric<VTK_TT>(
                        outputImage,
-                       imageToAppend,
+                       modifierImage,
                        operation,
                        extent,
                        maskThreshold,
@@ -1062,16 +1229,27 @@ bool vtkOrientedImageDataResample::ModifyImage(
     {
     return false;
     }
+
+  // Resample modifier into the geometry of the input image, only where it overlaps with the input image
+  vtkOrientedImageData* modifierImageInInputGeometry = modifierImage;
+  vtkNew<vtkOrientedImageData> resampledModifierImage;
   if (!vtkOrientedImageDataResample::DoGeometriesMatch(inputImage, modifierImage))
     {
-    vtkGenericWarningMacro("vtkOrientedImageDataResample::ModifyImage failed: geometry mismatch between inputImage and modifierImage");
-    return false;
+    if (!ResampleModifierToBaseGeometry(inputImage, modifierImage, extent, inputImage->GetExtent(),
+      operation, maskThreshold, resampledModifierImage.GetPointer()))
+      {
+      // modifier does not overlap with the input image, nothing to do
+      return true;
+      }
+    modifierImageInInputGeometry = resampledModifierImage.GetPointer();
+    extent = NULL;
     }
+
   switch (inputImage->GetScalarType())
     {
     vtkTemplateMacro(MergeImageGeneric<VTK_TT>(
                        inputImage,
-                       modifierImage,
+                       modifierImageInInputGeometry,
                        operation,
                        extent,
                        maskThreshold,
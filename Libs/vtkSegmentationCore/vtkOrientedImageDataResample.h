@@ -78,15 +78,23 @@ public:
   static void TransformOrientedImage(vtkOrientedImageData* image, vtkAbstractTransform* transform, bool geometryOnly=false, bool alwaysResample=false, bool linearInterpolation=false, double backgroundColor[4]=NULL);
 
   /// Combines the inputImage and imageToAppend into a new image by max/min operation. The extent will be the union of the two images.
-  /// Extent can be specified to restrict imageToAppend's extent to a smaller region.
-  /// inputImage and imageToAppend must have the same geometry, but they may have different extents.
+  /// Extent can be specified to restrict imageToAppend's extent to a smaller region. Extent is in the IJK coordinate
+  /// system of imageToAppend (which is the same as the IJK coordinate system of inputImage if their geometries match).
+  /// If the geometry of imageToAppend differs from inputImage then imageToAppend is resampled (nearest neighbor)
+  /// into the geometry of inputImage, only within its own bounding box. Voxels of the bounding box that imageToAppend
+  /// does not cover are left unchanged, same as when geometries match. Output is allocated and the input copied only once
+  /// when the extent has to grow, otherwise the merge is done in place. Rows are processed in parallel.
   static bool MergeImage(vtkOrientedImageData* inputImage, vtkOrientedImageData* imageToAppend, vtkOrientedImageData* outputImage, int operation,
     const int extent[6] = 0, int maskThreshold = 0, double fillValue = 1, bool *outputModified=NULL);
 
   /// Modifies inputImage in-place by combining with modifierImage using max/min operation.
   /// The extent will remain unchanged.
-  /// Extent can be specified to restrict modifierImage's extent to a smaller region.
-  /// inputImage and modifierImage must have the same geometry (origin, spacing, directions) and scalar type, but they may have different extents.
+  /// Extent can be specified to restrict modifierImage's extent to a smaller region. Extent is in the IJK coordinate
+  /// system of modifierImage (which is the same as the IJK coordinate system of inputImage if their geometries match).
+  /// inputImage and modifierImage must have the same scalar type, but they may have different extents.
+  /// If the geometry (origin, spacing, directions) of modifierImage differs from inputImage then only the part of modifierImage
+  /// that overlaps with inputImage is resampled (nearest neighbor) into the geometry of inputImage. Voxels that modifierImage
+  /// does not cover are left unchanged. Rows are processed in parallel.
   static bool ModifyImage(vtkOrientedImageData* inputImage, vtkOrientedImageData* modifierImage, int operation,
     const int extent[6] = 0, int maskThreshold = 0, double fillValue = 1);
 
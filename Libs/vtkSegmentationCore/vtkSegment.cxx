@@ -59,6 +59,8 @@ vtkSegment::vtkSegment()
   this->NameAutoGenerated = true;
   this->ColorAutoGenerated = true;
 
+  this->LabelValue = 1;
+
   // Set default terminology Tissue/Tissue from the default Slicer terminology dictionary
   this->SetTag( vtkSegment::GetTerminologyEntryTagName(),
     "Segmentation category and type - 3D Slicer General Anatomy list~SRT^T-D0050^Tissue~SRT^T-D0050^Tissue~^^~Anatomic codes - DICOM master list~^^~^^");
@@ -82,6 +84,7 @@ void vtkSegment::PrintSelf(ostream& os, vtkIndent indent)
 
   os << indent << "Name: " << (this->Name ? this->Name : "NULL") << "\n";
   os << indent << "Color: (" << this->Color[0] << ", " << this->Color[1] << ", " << this->Color[2] << ")\n";
+  os << indent << "LabelValue: " << this->LabelValue << "\n";
 
   RepresentationMap::iterator reprIt;
   os << indent << "Representations:\n";
@@ -159,6 +162,7 @@ void vtkSegment::DeepCopy(vtkSegment* source)
     }
 
   this->DeepCopyMetadata(source);
+  this->LabelValue = source->LabelValue;
 
   // Deep copy representations
   std::set<std::string> representationNamesToKeep;
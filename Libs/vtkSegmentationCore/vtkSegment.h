@@ -129,6 +129,11 @@ public:
   vtkSetMacro(ColorAutoGenerated, bool);
   vtkBooleanMacro(ColorAutoGenerated, bool);
 
+  /// Voxel value of the segment in its binary labelmap representation.
+  /// It is 1 unless the labelmap is a layer shared with other segments (\sa vtkSegmentation::CollapseBinaryLabelmaps).
+  vtkGetMacro(LabelValue, int);
+  vtkSetMacro(LabelValue, int);
+
 protected:
   vtkSegment();
   ~vtkSegment();
@@ -154,6 +159,9 @@ protected:
   bool NameAutoGenerated;
   /// Flag indicating whether color was automatically generated. False after user manually overrides. True by default
   bool ColorAutoGenerated;
+
+  /// Value of the voxels that belong to this segment in the binary labelmap representation. 1 by default
+  int LabelValue;
 };
 
 #endif // __vtkSegment_h
@@ -40,11 +40,14 @@
 #include <vtkTransform.h>
 #include <vtkPolyData.h>
 #include <vtkTransformPolyDataFilter.h>
+#include <vtkImageThreshold.h>
+#include <vtkPointData.h>
 
 // STD includes
 #include <sstream>
 #include <algorithm>
 #include <functional>
+#include <set>
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSegmentation);
@@ -60,6 +63,189 @@ public:
     }
 };
 
+//----------------------------------------------------------------------------
+// Replace all voxels of a value in an image (used for removing a segment from a shared layer)
+template <class ImageScalarType>
+void ReplaceLabelValueGeneric(vtkImageData* image, double oldValue, double newValue)
+{
+  ImageScalarType* imagePtr = static_cast<ImageScalarType*>(image->GetScalarPointer());
+  if (imagePtr == NULL)
+    {
+    return;
+    }
+  ImageScalarType oldValueImageType = static_cast<ImageScalarType>(oldValue);
+  ImageScalarType newValueImageType = static_cast<ImageScalarType>(newValue);
+  vtkIdType numberOfValues = image->GetNumberOfPoints() * image->GetNumberOfScalarComponents();
+  bool imageModified = false;
+  for (vtkIdType index = 0; index < numberOfValues; ++index, ++imagePtr)
+    {
+    if (*imagePtr == oldValueImageType)
+      {
+      *imagePtr = newValueImageType;
+      imageModified = true;
+      }
+    }
+  if (imageModified)
+    {
+    image->Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+// Determine if non-zero voxels of the modifier image overlap voxels of the layer image that are non-zero
+// and differ from the allowed label value. Only the intersection of the image extents is checked,
+// the two images are expected to have the same geometry.
+template <class LayerScalarType, class ModifierScalarType>
+void HasLabelOverlapGeneric2(vtkImageData* layerImage, vtkImageData* modifierImage, int allowedLabelValue, bool* overlap)
+{
+  *overlap = false;
+  int updateExt[6] = { 0, -1, 0, -1, 0, -1 };
+  layerImage->GetExtent(updateExt);
+  int* modifierExt = modifierImage->GetExtent();
+  for (int idx = 0; idx < 3; ++idx)
+    {
+    updateExt[idx * 2] = std::max(updateExt[idx * 2], modifierExt[idx * 2]);
+    updateExt[idx * 2 + 1] = std::min(updateExt[idx * 2 + 1], modifierExt[idx * 2 + 1]);
+    }
+  if (updateExt[0] > updateExt[1] || updateExt[2] > updateExt[3] || updateExt[4] > updateExt[5])
+    {
+    return;
+    }
+
+  vtkIdType layerIncX = 0;
+  vtkIdType layerIncY = 0;
+  vtkIdType layerIncZ = 0;
+  vtkIdType modifierIncX = 0;
+  vtkIdType modifierIncY = 0;
+  vtkIdType modifierIncZ = 0;
+  layerImage->GetContinuousIncrements(updateExt, layerIncX, layerIncY, layerIncZ);
+  modifierImage->GetContinuousIncrements(updateExt, modifierIncX, modifierIncY, modifierIncZ);
+  LayerScalarType* layerPtr = static_cast<LayerScalarType*>(layerImage->GetScalarPointerForExtent(updateExt));
+  ModifierScalarType* modifierPtr = static_cast<ModifierScalarType*>(modifierImage->GetScalarPointerForExtent(updateExt));
+  if (layerPtr == NULL || modifierPtr == NULL)
+    {
+    return;
+    }
+  LayerScalarType allowedLabelValueLayerType = static_cast<LayerScalarType>(allowedLabelValue);
+  for (int idxZ = updateExt[4]; idxZ <= updateExt[5]; idxZ++)
+    {
+    for (int idxY = updateExt[2]; idxY <= updateExt[3]; idxY++)
+      {
+      for (int idxX = updateExt[0]; idxX <= updateExt[1]; idxX++)
+        {
+        if (*modifierPtr != 0 && *layerPtr != 0 && *layerPtr != allowedLabelValueLayerType)
+          {
+          *overlap = true;
+          return;
+          }
+        layerPtr++;
+        modifierPtr++;
+        }
+      layerPtr += layerIncY;
+      modifierPtr += modifierIncY;
+      }
+    layerPtr += layerIncZ;
+    modifierPtr += modifierIncZ;
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class LayerScalarType>
+void HasLabelOverlapGeneric(vtkImageData* layerImage, vtkImageData* modifierImage, int allowedLabelValue, bool* overlap)
+{
+  switch (modifierImage->GetScalarType())
+    {
+    vtkTemplateMacro((HasLabelOverlapGeneric2<LayerScalarType, VTK_TT>(layerImage, modifierImage, allowedLabelValue, overlap)));
+  default:
+    vtkGenericWarningMacro("vtkSegmentation::HasLabelOverlap: Unknown ScalarType");
+    }
+}
+
+//----------------------------------------------------------------------------
+static bool HasLabelOverlap(vtkImageData* layerImage, vtkImageData* modifierImage, int allowedLabelValue)
+{
+  if (!layerImage->GetPointData()->GetScalars() || !modifierImage->GetPointData()->GetScalars())
+    {
+    return false;
+    }
+  bool overlap = false;
+  switch (layerImage->GetScalarType())
+    {
+    vtkTemplateMacro(HasLabelOverlapGeneric<VTK_TT>(layerImage, modifierImage, allowedLabelValue, &overlap));
+  default:
+    vtkGenericWarningMacro("vtkSegmentation::HasLabelOverlap: Unknown ScalarType");
+    }
+  return overlap;
+}
+
+//----------------------------------------------------------------------------
+// Set voxels of the label value to 1 and all other voxels to 0, cropped to the extent of the label
+static void ExtractBinaryLabelmap(vtkOrientedImageData* layerImage, int labelValue, vtkOrientedImageData* binaryLabelmap)
+{
+  if (layerImage->IsEmpty())
+    {
+    binaryLabelmap->DeepCopy(layerImage);
+    return;
+    }
+  vtkNew<vtkImageThreshold> threshold;
+  threshold->SetInputData(layerImage);
+  threshold->ThresholdBetween(labelValue, labelValue);
+  threshold->SetInValue(1);
+  threshold->SetOutValue(0);
+  threshold->ReplaceInOn();
+  threshold->ReplaceOutOn();
+  threshold->SetOutputScalarTypeToUnsignedChar();
+  threshold->Update();
+
+  vtkSmartPointer<vtkOrientedImageData> thresholdedImage = vtkSmartPointer<vtkOrientedImageData>::New();
+  thresholdedImage->ShallowCopy(threshold->GetOutput());
+  thresholdedImage->CopyDirections(layerImage);
+
+  int effectiveExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  vtkOrientedImageDataResample::CalculateEffectiveExtent(thresholdedImage, effectiveExtent);
+  if (effectiveExtent[0] > effectiveExtent[1] || effectiveExtent[2] > effectiveExtent[3] || effectiveExtent[4] > effectiveExtent[5])
+    {
+    // Segment is empty, keep the whole extent
+    binaryLabelmap->ShallowCopy(thresholdedImage);
+    return;
+    }
+  vtkOrientedImageDataResample::CopyImage(thresholdedImage, binaryLabelmap, effectiveExtent);
+}
+
+//----------------------------------------------------------------------------
+// Deep copy representations of a segment. Data objects shared between segments are copied only once,
+// the copies are stored in copiedObjects (source object -> copy).
+static void DeepCopySegmentSharingRepresentations(vtkSegment* source, vtkSegment* destination,
+  std::map<vtkDataObject*, vtkSmartPointer<vtkDataObject> >& copiedObjects)
+{
+  destination->RemoveAllRepresentations();
+  destination->DeepCopyMetadata(source);
+  destination->SetLabelValue(source->GetLabelValue());
+
+  std::vector<std::string> representationNames;
+  source->GetContainedRepresentationNames(representationNames);
+  for (std::vector<std::string>::iterator reprIt = representationNames.begin(); reprIt != representationNames.end(); ++reprIt)
+    {
+    vtkDataObject* sourceRepresentation = source->GetRepresentation(*reprIt);
+    std::map<vtkDataObject*, vtkSmartPointer<vtkDataObject> >::iterator copiedIt = copiedObjects.find(sourceRepresentation);
+    if (copiedIt != copiedObjects.end())
+      {
+      destination->AddRepresentation(*reprIt, copiedIt->second);
+      continue;
+      }
+    vtkSmartPointer<vtkDataObject> representationCopy = vtkSmartPointer<vtkDataObject>::Take(
+      vtkSegmentationConverterFactory::GetInstance()->ConstructRepresentationObjectByClass(sourceRepresentation->GetClassName()) );
+    if (!representationCopy.GetPointer())
+      {
+      vtkGenericWarningMacro("vtkSegmentation::DeepCopy: Unable to construct representation type class '" << sourceRepresentation->GetClassName() << "'");
+      continue;
+      }
+    representationCopy->DeepCopy(sourceRepresentation);
+    destination->AddRepresentation(*reprIt, representationCopy);
+    copiedObjects[sourceRepresentation] = representationCopy;
+    }
+}
+
 //----------------------------------------------------------------------------
 vtkSegmentation::vtkSegmentation()
 {
@@ -145,11 +331,12 @@ void vtkSegmentation::DeepCopy(vtkSegmentation* aSegmentation)
   // Copy conversion parameters
   this->Converter->DeepCopy(aSegmentation->Converter);
 
-  // Deep copy segments list
+  // Deep copy segments list. Shared labelmap layers are copied only once to preserve sharing.
+  std::map<vtkDataObject*, vtkSmartPointer<vtkDataObject> > copiedRepresentations;
   for (std::deque< std::string >::iterator segmentIdIt = aSegmentation->SegmentIds.begin(); segmentIdIt != aSegmentation->SegmentIds.end(); ++segmentIdIt)
     {
     vtkSmartPointer<vtkSegment> segment = vtkSmartPointer<vtkSegment>::New();
-    segment->DeepCopy(aSegmentation->Segments[*segmentIdIt]);
+    DeepCopySegmentSharingRepresentations(aSegmentation->Segments[*segmentIdIt], segment, copiedRepresentations);
     this->AddSegment(segment);
     }
 }
@@ -499,7 +686,7 @@ void vtkSegmentation::RemoveSegment(vtkSegment* segment)
 }
 
 //---------------------------------------------------------------------------
-void vtkSegmentation::RemoveSegment(SegmentMap::iterator segmentIt)
+void vtkSegmentation::RemoveSegment(SegmentMap::iterator segmentIt, bool clearSharedLabelmap/*=true*/)
 {
   if (segmentIt == this->Segments.end())
     {
@@ -510,11 +697,23 @@ void vtkSegmentation::RemoveSegment(SegmentMap::iterator segmentIt)
 
   // Remove observation of segment modified event
   segmentIt->second.GetPointer()->RemoveObservers(vtkCommand::ModifiedEvent, this->SegmentCallbackCommand);
-  // Remove observation of master representation of removed segment
+  // Remove observation of master representation of removed segment.
+  // If the master representation is a layer shared with other segments, then only the voxels
+  // of the segment are cleared and the layer remains observed.
   vtkDataObject* masterRepresentation = segmentIt->second->GetRepresentation(this->MasterRepresentationName);
   if (masterRepresentation)
     {
-    masterRepresentation->RemoveObservers(vtkCommand::ModifiedEvent, this->MasterRepresentationCallbackCommand);
+    if (this->IsSharedBinaryLabelmap(segmentIt->second))
+      {
+      if (clearSharedLabelmap)
+        {
+        this->ClearSegmentInLayer(segmentIt->second);
+        }
+      }
+    else
+      {
+      masterRepresentation->RemoveObservers(vtkCommand::ModifiedEvent, this->MasterRepresentationCallbackCommand);
+      }
     }
 
   // Remove segment
@@ -540,7 +739,8 @@ void vtkSegmentation::RemoveAllSegments()
   this->GetSegmentIDs(segmentIds);
   for (std::vector<std::string>::iterator segmentIt = segmentIds.begin(); segmentIt != segmentIds.end(); ++segmentIt)
     {
-    this->RemoveSegment(*segmentIt);
+    // Shared layers are removed with the segments, so there is no need to clear the segments in them
+    this->RemoveSegment(this->Segments.find(*segmentIt), false);
     }
   this->Segments.clear();
 
@@ -740,7 +940,9 @@ void vtkSegmentation::ApplyLinearTransform(vtkAbstractTransform* transform)
   this->Converter->ApplyTransformOnReferenceImageGeometry(transform);
 
   // Apply linear transform for each segment:
-  // Harden transform on master representation if poly data, apply directions if oriented image data
+  // Harden transform on master representation if poly data, apply directions if oriented image data.
+  // Shared labelmap layers are transformed only once.
+  std::set<vtkDataObject*> transformedRepresentations;
   for (SegmentMap::iterator it = this->Segments.begin(); it != this->Segments.end(); ++it)
     {
     vtkDataObject* currentMasterRepresentation = it->second->GetRepresentation(this->MasterRepresentationName);
@@ -749,6 +951,10 @@ void vtkSegmentation::ApplyLinearTransform(vtkAbstractTransform* transform)
       vtkErrorMacro("ApplyLinearTransform: Cannot get master representation (" << this->MasterRepresentationName << ") from segment!");
       return;
       }
+    if (!transformedRepresentations.insert(currentMasterRepresentation).second)
+      {
+      continue;
+      }
 
     vtkPolyData* currentMasterRepresentationPolyData = vtkPolyData::SafeDownCast(currentMasterRepresentation);
     vtkOrientedImageData* currentMasterRepresentationOrientedImageData = vtkOrientedImageData::SafeDownCast(currentMasterRepresentation);
@@ -787,7 +993,9 @@ void vtkSegmentation::ApplyNonLinearTransform(vtkAbstractTransform* transform)
   // Apply transform on reference image geometry conversion parameter (to preserve validity of merged labelmap)
   this->Converter->ApplyTransformOnReferenceImageGeometry(transform);
 
-  // Harden transform on master representation (both image data and poly data) for each segment individually
+  // Harden transform on master representation (both image data and poly data) for each segment individually.
+  // Shared labelmap layers are transformed only once.
+  std::set<vtkDataObject*> transformedRepresentations;
   for (SegmentMap::iterator it = this->Segments.begin(); it != this->Segments.end(); ++it)
     {
     vtkDataObject* currentMasterRepresentation = it->second->GetRepresentation(this->MasterRepresentationName);
@@ -796,6 +1004,10 @@ void vtkSegmentation::ApplyNonLinearTransform(vtkAbstractTransform* transform)
       vtkErrorMacro("ApplyNonLinearTransform: Cannot get master representation (" << this->MasterRepresentationName << ") from segment!");
       return;
       }
+    if (!transformedRepresentations.insert(currentMasterRepresentation).second)
+      {
+      continue;
+      }
 
     vtkPolyData* currentMasterRepresentationPolyData = vtkPolyData::SafeDownCast(currentMasterRepresentation);
     vtkOrientedImageData* currentMasterRepresentationOrientedImageData = vtkOrientedImageData::SafeDownCast(currentMasterRepresentation);
@@ -835,13 +1047,21 @@ bool vtkSegmentation::ConvertSegmentUsingPath(vtkSegment* segment, vtkSegmentati
       }
 
     // Get source representation from segment. It is expected to exist
-    vtkDataObject* sourceRepresentation = segment->GetRepresentation(
+    vtkSmartPointer<vtkDataObject> sourceRepresentation = segment->GetRepresentation(
       currentConversionRule->GetSourceRepresentationName() );
-    if (!sourceRepresentation)
+    if (!sourceRepresentation.GetPointer())
       {
       vtkErrorMacro("ConvertSegmentUsingPath: Source representation does not exist!");
       return false;
       }
+    // Conversion rules expect a binary labelmap, so pass only the voxels of the segment if the labelmap is a layer
+    if (!currentConversionRule->GetSourceRepresentationName().compare(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName())
+      && this->IsLayerBinaryLabelmap(segment))
+      {
+      vtkSmartPointer<vtkOrientedImageData> binaryLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      ExtractBinaryLabelmap(vtkOrientedImageData::SafeDownCast(sourceRepresentation), segment->GetLabelValue(), binaryLabelmap);
+      sourceRepresentation = binaryLabelmap;
+      }
 
     // Get target representation
     vtkSmartPointer<vtkDataObject> targetRepresentation = segment->GetRepresentation(
@@ -1210,20 +1430,36 @@ bool vtkSegmentation::CopySegmentFromSegmentation(vtkSegmentation* fromSegmentat
     this->SetConversionParameter(vtkSegmentationConverter::GetReferenceImageGeometryParameterName(), fromReferenceImageGeometryParameter);
     }
 
-  // If copy, then duplicate segment and add it to the target segmentation
+  // If copy, then duplicate segment and add it to the target segmentation.
+  // If the segment is in a labelmap layer, then only the voxels of the segment are copied.
   if (!removeFromSource)
     {
+    std::map<vtkDataObject*, vtkSmartPointer<vtkDataObject> > copiedRepresentations;
+    vtkDataObject* masterRepresentation = segment->GetRepresentation(fromSegmentation->GetMasterRepresentationName());
+    if (masterRepresentation && fromSegmentation->IsLayerBinaryLabelmap(segment))
+      {
+      vtkSmartPointer<vtkOrientedImageData> binaryLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      ExtractBinaryLabelmap(vtkOrientedImageData::SafeDownCast(masterRepresentation), segment->GetLabelValue(), binaryLabelmap);
+      copiedRepresentations[masterRepresentation] = binaryLabelmap;
+      }
     vtkSmartPointer<vtkSegment> segmentCopy = vtkSmartPointer<vtkSegment>::New();
-    segmentCopy->DeepCopy(segment);
+    DeepCopySegmentSharingRepresentations(segment, segmentCopy, copiedRepresentations);
+    segmentCopy->SetLabelValue(1);
     if (!this->AddSegment(segmentCopy, targetSegmentId))
       {
       vtkErrorMacro("CopySegmentFromSegmentation: Failed to add segment '" << targetSegmentId << "' to segmentation");
       return false;
       }
     }
-  // If move, then just add segment to target and remove from source (ownership is transferred)
+  // If move, then just add segment to target and remove from source (ownership is transferred).
+  // A segment in a labelmap layer is separated from the layer first.
   else
     {
+    if (!fromSegmentation->SeparateSegmentLabelmap(segmentId))
+      {
+      vtkErrorMacro("CopySegmentFromSegmentation: Failed to separate segment '" << segmentId << "' from its labelmap layer");
+      return false;
+      }
     if (!this->AddSegment(segment, targetSegmentId))
       {
       vtkErrorMacro("CopySegmentFromSegmentation: Failed to add segment '" << targetSegmentId << "' to segmentation");
@@ -1235,6 +1471,446 @@ bool vtkSegmentation::CopySegmentFromSegmentation(vtkSegmentation* fromSegmentat
   return true;
 }
 
+//---------------------------------------------------------------------------
+void vtkSegmentation::GetLayerDataObjects(std::vector<vtkDataObject*>& layerObjects)
+{
+  layerObjects.clear();
+  std::set<vtkDataObject*> foundLayerObjects;
+  for (std::deque< std::string >::iterator segmentIdIt = this->SegmentIds.begin(); segmentIdIt != this->SegmentIds.end(); ++segmentIdIt)
+    {
+    vtkDataObject* masterRepresentation = this->Segments[*segmentIdIt]->GetRepresentation(this->MasterRepresentationName);
+    if (masterRepresentation && foundLayerObjects.insert(masterRepresentation).second)
+      {
+      layerObjects.push_back(masterRepresentation);
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+int vtkSegmentation::GetNumberOfLayers()
+{
+  std::vector<vtkDataObject*> layerObjects;
+  this->GetLayerDataObjects(layerObjects);
+  return layerObjects.size();
+}
+
+//---------------------------------------------------------------------------
+int vtkSegmentation::GetLayerIndex(const std::string& segmentId)
+{
+  vtkSegment* segment = this->GetSegment(segmentId);
+  if (!segment)
+    {
+    return -1;
+    }
+  vtkDataObject* segmentLayerObject = segment->GetRepresentation(this->MasterRepresentationName);
+  if (!segmentLayerObject)
+    {
+    return -1;
+    }
+  // Layers are numbered in the order of their first segment, so the index is the number of
+  // distinct layers found before the first segment of this layer
+  std::set<vtkDataObject*> precedingLayerObjects;
+  for (std::deque< std::string >::iterator segmentIdIt = this->SegmentIds.begin(); segmentIdIt != this->SegmentIds.end(); ++segmentIdIt)
+    {
+    vtkDataObject* masterRepresentation = this->Segments[*segmentIdIt]->GetRepresentation(this->MasterRepresentationName);
+    if (masterRepresentation == segmentLayerObject)
+      {
+      return static_cast<int>(precedingLayerObjects.size());
+      }
+    if (masterRepresentation)
+      {
+      precedingLayerObjects.insert(masterRepresentation);
+      }
+    }
+  return -1;
+}
+
+//---------------------------------------------------------------------------
+vtkDataObject* vtkSegmentation::GetLayerDataObject(int layer)
+{
+  std::vector<vtkDataObject*> layerObjects;
+  this->GetLayerDataObjects(layerObjects);
+  if (layer < 0 || layer >= static_cast<int>(layerObjects.size()))
+    {
+    return NULL;
+    }
+  return layerObjects[layer];
+}
+
+//---------------------------------------------------------------------------
+void vtkSegmentation::GetLayerSegmentIDs(int layer, std::vector<std::string>& segmentIds)
+{
+  segmentIds.clear();
+  vtkDataObject* layerObject = this->GetLayerDataObject(layer);
+  if (!layerObject)
+    {
+    return;
+    }
+  for (std::deque< std::string >::iterator segmentIdIt = this->SegmentIds.begin(); segmentIdIt != this->SegmentIds.end(); ++segmentIdIt)
+    {
+    if (this->Segments[*segmentIdIt]->GetRepresentation(this->MasterRepresentationName) == layerObject)
+      {
+      segmentIds.push_back(*segmentIdIt);
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSegmentation::GetSegmentIDsSharingMasterRepresentation(const std::string& segmentId, std::vector<std::string>& segmentIds, bool includeOriginal/*=false*/)
+{
+  segmentIds.clear();
+  vtkSegment* segment = this->GetSegment(segmentId);
+  if (!segment)
+    {
+    return;
+    }
+  vtkDataObject* masterRepresentation = segment->GetRepresentation(this->MasterRepresentationName);
+  if (!masterRepresentation)
+    {
+    return;
+    }
+  for (std::deque< std::string >::iterator segmentIdIt = this->SegmentIds.begin(); segmentIdIt != this->SegmentIds.end(); ++segmentIdIt)
+    {
+    if (!includeOriginal && (*segmentIdIt) == segmentId)
+      {
+      continue;
+      }
+    if (this->Segments[*segmentIdIt]->GetRepresentation(this->MasterRepresentationName) == masterRepresentation)
+      {
+      segmentIds.push_back(*segmentIdIt);
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+bool vtkSegmentation::IsSharedBinaryLabelmap(const std::string& segmentId)
+{
+  return this->IsSharedBinaryLabelmap(this->GetSegment(segmentId));
+}
+
+//---------------------------------------------------------------------------
+bool vtkSegmentation::IsSharedBinaryLabelmap(vtkSegment* segment)
+{
+  if (!segment || this->MasterRepresentationName.compare(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()))
+    {
+    return false;
+    }
+  vtkDataObject* masterRepresentation = segment->GetRepresentation(this->MasterRepresentationName);
+  if (!masterRepresentation)
+    {
+    return false;
+    }
+  for (SegmentMap::iterator segmentIt = this->Segments.begin(); segmentIt != this->Segments.end(); ++segmentIt)
+    {
+    if (segmentIt->second.GetPointer() != segment
+      && segmentIt->second->GetRepresentation(this->MasterRepresentationName) == masterRepresentation)
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSegmentation::IsLayerBinaryLabelmap(vtkSegment* segment)
+{
+  if (!segment || this->MasterRepresentationName.compare(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()))
+    {
+    return false;
+    }
+  return (segment->GetLabelValue() != 1 || this->IsSharedBinaryLabelmap(segment));
+}
+
+//---------------------------------------------------------------------------
+int vtkSegmentation::GetUniqueLabelValueInLayer(int layer)
+{
+  std::vector<std::string> segmentIds;
+  this->GetLayerSegmentIDs(layer, segmentIds);
+  int maximumLabelValue = 0;
+  for (std::vector<std::string>::iterator segmentIdIt = segmentIds.begin(); segmentIdIt != segmentIds.end(); ++segmentIdIt)
+    {
+    maximumLabelValue = std::max(maximumLabelValue, this->Segments[*segmentIdIt]->GetLabelValue());
+    }
+  return maximumLabelValue + 1;
+}
+
+//---------------------------------------------------------------------------
+void vtkSegmentation::ClearSegmentInLayer(vtkSegment* segment)
+{
+  vtkOrientedImageData* layerImage = vtkOrientedImageData::SafeDownCast(
+    segment->GetRepresentation(this->MasterRepresentationName));
+  if (!layerImage || !layerImage->GetPointData()->GetScalars())
+    {
+    return;
+    }
+  bool wasMasterRepresentationModifiedEnabled = this->SetMasterRepresentationModifiedEnabled(false);
+  switch (layerImage->GetScalarType())
+    {
+    vtkTemplateMacro(ReplaceLabelValueGeneric<VTK_TT>(layerImage, segment->GetLabelValue(), 0));
+  default:
+    vtkErrorMacro("ClearSegmentInLayer: Unknown ScalarType");
+    }
+  this->SetMasterRepresentationModifiedEnabled(wasMasterRepresentationModifiedEnabled);
+}
+
+//---------------------------------------------------------------------------
+bool vtkSegmentation::CollapseBinaryLabelmaps(bool forceToSingleLayer/*=false*/)
+{
+  if (this->MasterRepresentationName.compare(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()))
+    {
+    vtkErrorMacro("CollapseBinaryLabelmaps: Master representation is not binary labelmap");
+    return false;
+    }
+  if (this->Segments.empty())
+    {
+    return true;
+    }
+
+  // All layers use the common labelmap geometry
+  std::string commonGeometryString = this->DetermineCommonLabelmapGeometry(EXTENT_UNION_OF_EFFECTIVE_SEGMENTS);
+  vtkSmartPointer<vtkOrientedImageData> commonGeometryImage = vtkSmartPointer<vtkOrientedImageData>::New();
+  if (!vtkSegmentationConverter::DeserializeImageGeometry(commonGeometryString, commonGeometryImage, false))
+    {
+    vtkErrorMacro("CollapseBinaryLabelmaps: Failed to determine common labelmap geometry");
+    return false;
+    }
+  int layerScalarType = (this->Segments.size() < VTK_UNSIGNED_CHAR_MAX ? VTK_UNSIGNED_CHAR : VTK_SHORT);
+  int maximumLabelValue = (layerScalarType == VTK_UNSIGNED_CHAR ? VTK_UNSIGNED_CHAR_MAX : VTK_SHORT_MAX);
+
+  // Place segments into the layers. Current master representations are not changed until all segments are placed,
+  // as segments that are not placed yet may still share them.
+  std::vector< vtkSmartPointer<vtkOrientedImageData> > layers;
+  std::vector<int> layerNextLabelValues;
+  std::vector<int> segmentLayerIndices;
+  std::vector<int> segmentLabelValues;
+  for (std::deque< std::string >::iterator segmentIdIt = this->SegmentIds.begin(); segmentIdIt != this->SegmentIds.end(); ++segmentIdIt)
+    {
+    vtkSegment* segment = this->Segments[*segmentIdIt];
+    vtkOrientedImageData* labelmap = vtkOrientedImageData::SafeDownCast(segment->GetRepresentation(this->MasterRepresentationName));
+    if (!labelmap)
+      {
+      vtkErrorMacro("CollapseBinaryLabelmaps: Failed to get binary labelmap of segment " << (*segmentIdIt));
+      return false;
+      }
+
+    vtkSmartPointer<vtkOrientedImageData> resampledLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    if (!labelmap->IsEmpty())
+      {
+      vtkSmartPointer<vtkOrientedImageData> binaryLabelmap = labelmap;
+      if (this->IsLayerBinaryLabelmap(segment))
+        {
+        binaryLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+        ExtractBinaryLabelmap(labelmap, segment->GetLabelValue(), binaryLabelmap);
+        }
+      if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(binaryLabelmap, commonGeometryImage, resampledLabelmap))
+        {
+        vtkErrorMacro("CollapseBinaryLabelmaps: Failed to resample binary labelmap of segment " << (*segmentIdIt));
+        return false;
+        }
+      }
+
+    // Find the first layer that the segment does not overlap
+    unsigned int layerIndex = 0;
+    for (; layerIndex < layers.size(); ++layerIndex)
+      {
+      if (layerNextLabelValues[layerIndex] > maximumLabelValue)
+        {
+        continue;
+        }
+      if (forceToSingleLayer || resampledLabelmap->IsEmpty()
+        || !HasLabelOverlap(layers[layerIndex], resampledLabelmap, 0))
+        {
+        break;
+        }
+      }
+    if (layerIndex == layers.size())
+      {
+      vtkSmartPointer<vtkOrientedImageData> layer = vtkSmartPointer<vtkOrientedImageData>::New();
+      vtkSegmentationConverter::DeserializeImageGeometry(commonGeometryString, layer, true, layerScalarType, 1);
+      vtkOrientedImageDataResample::FillImage(layer, 0);
+      layers.push_back(layer);
+      layerNextLabelValues.push_back(1);
+      }
+
+    int labelValue = layerNextLabelValues[layerIndex]++;
+    if (!resampledLabelmap->IsEmpty())
+      {
+      vtkOrientedImageDataResample::ModifyImage(layers[layerIndex], resampledLabelmap,
+        vtkOrientedImageDataResample::OPERATION_MASKING, NULL, 0, labelValue);
+      }
+    segmentLayerIndices.push_back(layerIndex);
+    segmentLabelValues.push_back(labelValue);
+    }
+
+  // Replace master representations by the layers. Observations are moved to the layers when
+  // master representation modified event is re-enabled.
+  bool wasMasterRepresentationModifiedEnabled = this->SetMasterRepresentationModifiedEnabled(false);
+  for (unsigned int segmentIndex = 0; segmentIndex < this->SegmentIds.size(); ++segmentIndex)
+    {
+    vtkSegment* segment = this->Segments[this->SegmentIds[segmentIndex]];
+    segment->SetLabelValue(segmentLabelValues[segmentIndex]);
+    segment->AddRepresentation(this->MasterRepresentationName, layers[segmentLayerIndices[segmentIndex]]);
+    }
+  this->SetMasterRepresentationModifiedEnabled(wasMasterRepresentationModifiedEnabled);
+
+  this->Modified();
+  this->InvokeEvent(vtkSegmentation::MasterRepresentationModified, NULL);
+  this->InvokeEvent(vtkSegmentation::RepresentationModified, NULL);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSegmentation::SeparateSegmentLabelmap(const std::string& segmentId)
+{
+  vtkSegment* segment = this->GetSegment(segmentId);
+  if (!segment)
+    {
+    vtkErrorMacro("SeparateSegmentLabelmap: Segment " << segmentId << " not found");
+    return false;
+    }
+  if (!this->IsLayerBinaryLabelmap(segment))
+    {
+    return true;
+    }
+  vtkOrientedImageData* layerImage = vtkOrientedImageData::SafeDownCast(segment->GetRepresentation(this->MasterRepresentationName));
+  if (!layerImage)
+    {
+    vtkErrorMacro("SeparateSegmentLabelmap: Failed to get binary labelmap of segment " << segmentId);
+    return false;
+    }
+
+  vtkSmartPointer<vtkOrientedImageData> binaryLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  ExtractBinaryLabelmap(layerImage, segment->GetLabelValue(), binaryLabelmap);
+
+  bool wasMasterRepresentationModifiedEnabled = this->SetMasterRepresentationModifiedEnabled(false);
+  if (this->IsSharedBinaryLabelmap(segment))
+    {
+    this->ClearSegmentInLayer(segment);
+    }
+  segment->SetLabelValue(1);
+  segment->AddRepresentation(this->MasterRepresentationName, binaryLabelmap);
+  this->SetMasterRepresentationModifiedEnabled(wasMasterRepresentationModifiedEnabled);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSegmentation::GetBinaryLabelmapRepresentation(const std::string& segmentId, vtkOrientedImageData* binaryLabelmap)
+{
+  if (!binaryLabelmap)
+    {
+    vtkErrorMacro("GetBinaryLabelmapRepresentation: Invalid output labelmap");
+    return false;
+    }
+  vtkSegment* segment = this->GetSegment(segmentId);
+  if (!segment)
+    {
+    vtkErrorMacro("GetBinaryLabelmapRepresentation: Segment " << segmentId << " not found");
+    return false;
+    }
+  vtkOrientedImageData* labelmap = vtkOrientedImageData::SafeDownCast(
+    segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) );
+  if (!labelmap)
+    {
+    vtkErrorMacro("GetBinaryLabelmapRepresentation: Segment " << segmentId << " does not contain binary labelmap representation");
+    return false;
+    }
+  if (this->IsLayerBinaryLabelmap(segment))
+    {
+    ExtractBinaryLabelmap(labelmap, segment->GetLabelValue(), binaryLabelmap);
+    }
+  else
+    {
+    binaryLabelmap->DeepCopy(labelmap);
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSegmentation::SetBinaryLabelmapRepresentation(const std::string& segmentId, vtkOrientedImageData* binaryLabelmap)
+{
+  if (!binaryLabelmap)
+    {
+    vtkErrorMacro("SetBinaryLabelmapRepresentation: Invalid input labelmap");
+    return false;
+    }
+  vtkSegment* segment = this->GetSegment(segmentId);
+  if (!segment)
+    {
+    vtkErrorMacro("SetBinaryLabelmapRepresentation: Segment " << segmentId << " not found");
+    return false;
+    }
+  vtkOrientedImageData* layerImage = vtkOrientedImageData::SafeDownCast(
+    segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) );
+  if (!layerImage)
+    {
+    vtkErrorMacro("SetBinaryLabelmapRepresentation: Segment " << segmentId << " does not contain binary labelmap representation");
+    return false;
+    }
+
+  bool wasMasterRepresentationModifiedEnabled = this->SetMasterRepresentationModifiedEnabled(false);
+  if (!this->IsSharedBinaryLabelmap(segment))
+    {
+    layerImage->DeepCopy(binaryLabelmap);
+    segment->SetLabelValue(1);
+    this->SetMasterRepresentationModifiedEnabled(wasMasterRepresentationModifiedEnabled);
+    return true;
+    }
+
+  // Make sure the labelmap has the same lattice as the layer
+  vtkSmartPointer<vtkOrientedImageData> resampledLabelmap = binaryLabelmap;
+  if (!binaryLabelmap->IsEmpty() && !vtkOrientedImageDataResample::DoGeometriesMatch(layerImage, binaryLabelmap))
+    {
+    resampledLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+      binaryLabelmap, layerImage, resampledLabelmap, false /*interpolate*/, true /*pad*/);
+    }
+
+  if (HasLabelOverlap(layerImage, resampledLabelmap, segment->GetLabelValue()))
+    {
+    // The segment would overlap other segments of the layer, so it spills into its own labelmap
+    this->ClearSegmentInLayer(segment);
+    vtkSmartPointer<vtkOrientedImageData> separatedLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    separatedLabelmap->DeepCopy(binaryLabelmap);
+    segment->SetLabelValue(1);
+    segment->AddRepresentation(this->MasterRepresentationName, separatedLabelmap);
+    this->SetMasterRepresentationModifiedEnabled(wasMasterRepresentationModifiedEnabled);
+    return true;
+    }
+
+  // Replace voxels of the segment in the layer
+  this->ClearSegmentInLayer(segment);
+  if (!resampledLabelmap->IsEmpty())
+    {
+    int* layerExtent = layerImage->GetExtent();
+    int* labelmapExtent = resampledLabelmap->GetExtent();
+    if (layerImage->IsEmpty())
+      {
+      // Layer does not contain any voxels yet, allocate it in the extent of the labelmap
+      int layerScalarType = (layerImage->GetPointData()->GetScalars() ? layerImage->GetScalarType() : VTK_UNSIGNED_CHAR);
+      vtkNew<vtkMatrix4x4> layerImageToWorldMatrix;
+      layerImage->GetImageToWorldMatrix(layerImageToWorldMatrix.GetPointer());
+      vtkSmartPointer<vtkOrientedImageData> allocatedLayerImage = vtkSmartPointer<vtkOrientedImageData>::New();
+      allocatedLayerImage->SetExtent(labelmapExtent);
+      allocatedLayerImage->SetImageToWorldMatrix(layerImageToWorldMatrix.GetPointer());
+      allocatedLayerImage->AllocateScalars(layerScalarType, 1);
+      vtkOrientedImageDataResample::FillImage(allocatedLayerImage, 0);
+      layerImage->ShallowCopy(allocatedLayerImage);
+      }
+    else if (labelmapExtent[0] < layerExtent[0] || labelmapExtent[1] > layerExtent[1]
+      || labelmapExtent[2] < layerExtent[2] || labelmapExtent[3] > layerExtent[3]
+      || labelmapExtent[4] < layerExtent[4] || labelmapExtent[5] > layerExtent[5])
+      {
+      vtkSmartPointer<vtkOrientedImageData> paddedLayerImage = vtkSmartPointer<vtkOrientedImageData>::New();
+      vtkOrientedImageDataResample::PadImageToContainImage(layerImage, resampledLabelmap, paddedLayerImage);
+      layerImage->ShallowCopy(paddedLayerImage);
+      }
+    vtkOrientedImageDataResample::ModifyImage(layerImage, resampledLabelmap,
+      vtkOrientedImageDataResample::OPERATION_MASKING, NULL, 0, segment->GetLabelValue());
+    }
+  this->SetMasterRepresentationModifiedEnabled(wasMasterRepresentationModifiedEnabled);
+  return true;
+}
+
 //-----------------------------------------------------------------------------
 std::string vtkSegmentation::DetermineCommonLabelmapGeometry(int extentComputationMode, vtkStringArray* segmentIds)
 {
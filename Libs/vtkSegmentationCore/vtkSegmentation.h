@@ -28,6 +28,7 @@
 // STD includes
 #include <map>
 #include <deque>
+#include <vector>
 
 // SegmentationCore includes
 #include "vtkSegment.h"
@@ -84,6 +85,15 @@ class vtkStringArray;
 ///      Custom representation | vtkDataObject        | vtkDataObject        |
 ///                            +----------------------+----------------------+
 ///
+///   * Shared labelmap layers
+///     * Binary labelmap master representations of non-overlapping segments can share one label volume (layer),
+///       each segment is then identified by the pair of the layer and its label value (\sa vtkSegment::GetLabelValue)
+///     * Segments are collapsed into layers by \sa CollapseBinaryLabelmaps. Segments that would overlap are placed
+///       into additional layers, and a segment spills into a new layer automatically when an edit would make it
+///       overlap another segment of its layer
+///     * The binary (0/1) view of one segment can be retrieved by \sa GetBinaryLabelmapRepresentation, this is
+///       what the conversion rules receive as input
+///
 class vtkSegmentationCore_EXPORT vtkSegmentation : public vtkObject
 {
 public:
@@ -255,6 +265,62 @@ public:
   /// \return Success flag
   bool CopySegmentFromSegmentation(vtkSegmentation* fromSegmentation, std::string segmentId, bool removeFromSource=false);
 
+// Shared labelmap layer related methods
+
+  /// Get number of distinct master representation data objects (layers) in the segmentation.
+  /// Segments that do not share their master representation each count as one layer.
+  int GetNumberOfLayers();
+
+  /// Get index of the layer the master representation of the segment belongs to. -1 if segment is not found.
+  int GetLayerIndex(const std::string& segmentId);
+
+  /// Get master representation data object of a layer. NULL if layer index is invalid.
+  vtkDataObject* GetLayerDataObject(int layer);
+
+  /// Get IDs of the segments that belong to a layer, in display order
+  void GetLayerSegmentIDs(int layer, std::vector<std::string>& segmentIds);
+
+  /// Get IDs of the segments whose master representation is the same data object as the one of the given segment
+  /// \param includeOriginal If true then the given segment ID is included in the output
+  void GetSegmentIDsSharingMasterRepresentation(const std::string& segmentId, std::vector<std::string>& segmentIds, bool includeOriginal=false);
+
+  /// Determine if the binary labelmap master representation of the segment is shared with other segments
+  bool IsSharedBinaryLabelmap(const std::string& segmentId);
+
+  /// Determine if the binary labelmap master representation of the segment cannot be used as a binary labelmap
+  /// as it is (it is shared or its label value is not 1). \sa GetBinaryLabelmapRepresentation
+  bool IsLayerBinaryLabelmap(vtkSegment* segment);
+
+  /// Get a label value that is not used by any segment in the layer
+  int GetUniqueLabelValueInLayer(int layer);
+
+  /// Merge binary labelmap master representations of non-overlapping segments into shared layers.
+  /// All labelmaps are resampled to the common labelmap geometry, each segment is placed into the first
+  /// layer in which it does not overlap other segments, and a new layer is created if there is no such layer.
+  /// Segments are never collapsed implicitly: the segment editor, import and reading of non-layered
+  /// files create one labelmap per segment, so layers only exist if this method is called.
+  /// \param forceToSingleLayer If true then all segments are placed into one layer. Overlapping voxels are
+  ///   assigned to the segment that is later in the display order.
+  /// \return Success flag
+  bool CollapseBinaryLabelmaps(bool forceToSingleLayer=false);
+
+  /// Move the segment out of its shared layer into a separate binary labelmap with label value 1.
+  /// Voxels of the segment are cleared in the shared layer.
+  /// \return Success flag. True if the segment is already not shared.
+  bool SeparateSegmentLabelmap(const std::string& segmentId);
+
+  /// Get binary (0/1) labelmap of a segment. If the segment is in a shared layer or its label value differs
+  /// from 1 then voxels of the label value are extracted, otherwise the labelmap is copied.
+  /// \return Success flag
+  bool GetBinaryLabelmapRepresentation(const std::string& segmentId, vtkOrientedImageData* binaryLabelmap);
+
+  /// Set binary labelmap content of a segment. If the segment is in a shared layer then its voxels in the layer
+  /// are replaced by the non-zero voxels of the input labelmap. If the new content would overlap other segments
+  /// of the layer then the segment is separated from the layer first (\sa SeparateSegmentLabelmap).
+  /// Master representation modified events of the segmentation are not invoked.
+  /// \return Success flag
+  bool SetBinaryLabelmapRepresentation(const std::string& segmentId, vtkOrientedImageData* binaryLabelmap);
+
 // Representation related methods
 
   /// Get representation names present in this segmentation in an output string vector
@@ -365,9 +431,19 @@ protected:
   /// Converts a single segment to a representation.
   bool ConvertSingleSegment(std::string segmentId, std::string targetRepresentationName);
 
+  /// Determine if the binary labelmap master representation of the segment is shared with other segments
+  bool IsSharedBinaryLabelmap(vtkSegment* segment);
+
+  /// Get unique master representation data objects in segment display order
+  void GetLayerDataObjects(std::vector<vtkDataObject*>& layerObjects);
+
+  /// Set voxels of the label value of the segment to 0 in its shared layer
+  void ClearSegmentInLayer(vtkSegment* segment);
+
   /// Remove segment by iterator. The two \sa RemoveSegment methods call this function after
   /// finding the iterator based on their different input arguments.
-  void RemoveSegment(SegmentMap::iterator segmentIt);
+  /// \param clearSharedLabelmap If true then voxels of the segment are cleared in its shared labelmap layer
+  void RemoveSegment(SegmentMap::iterator segmentIt, bool clearSharedLabelmap=true);
 
   /// Temporarily enable/disable master representation modified event.
   /// \return Old value of MasterRepresentationModifiedEnabled.
@@ -115,6 +115,7 @@ bool vtkSegmentationHistory::SaveState()
   this->RemoveAllNextStates();
 
   SegmentationState newSegmentationState;
+  std::map<vtkDataObject*, vtkSmartPointer<vtkDataObject> > copiedRepresentations;
 
   std::vector<std::string> segmentIDs;
   this->Segmentation->GetSegmentIDs(segmentIDs);
@@ -138,7 +139,7 @@ bool vtkSegmentationHistory::SaveState()
         }
       }
     vtkSmartPointer<vtkSegment> segmentClone = vtkSmartPointer<vtkSegment>::New();
-    CopySegment(segmentClone, segment, baselineSegment);
+    CopySegment(segmentClone, segment, baselineSegment, copiedRepresentations);
     newSegmentationState.Segments[*segmentIDIt] = segmentClone;
     }
   this->SegmentationStates.push_back(newSegmentationState);
@@ -152,10 +153,12 @@ bool vtkSegmentationHistory::SaveState()
 }
 
 //---------------------------------------------------------------------------
-void vtkSegmentationHistory::CopySegment(vtkSegment* destination, vtkSegment* source, vtkSegment* baseline)
+void vtkSegmentationHistory::CopySegment(vtkSegment* destination, vtkSegment* source, vtkSegment* baseline,
+  std::map<vtkDataObject*, vtkSmartPointer<vtkDataObject> >& copiedRepresentations)
 {
   destination->RemoveAllRepresentations();
   destination->DeepCopyMetadata(source);
+  destination->SetLabelValue(source->GetLabelValue());
 
   // Copy representations
   std::vector<std::string> representationNames;
@@ -164,6 +167,13 @@ void vtkSegmentationHistory::CopySegment(vtkSegment* destination, vtkSegment* so
     representationNameIt != representationNames.end(); ++representationNameIt)
     {
     vtkDataObject* sourceRepresentation = source->GetRepresentation(*representationNameIt);
+    // Representation shared with an already copied segment
+    std::map<vtkDataObject*, vtkSmartPointer<vtkDataObject> >::iterator copiedRepresentationIt = copiedRepresentations.find(sourceRepresentation);
+    if (copiedRepresentationIt != copiedRepresentations.end())
+      {
+      destination->AddRepresentation(*representationNameIt, copiedRepresentationIt->second);
+      continue;
+      }
     vtkDataObject* baselineRepresentation = NULL;
     if (baseline)
       {
@@ -175,6 +185,7 @@ void vtkSegmentationHistory::CopySegment(vtkSegment* destination, vtkSegment* so
       {
       // we already have an up-to-date copy in the baseline, so reuse that
       destination->AddRepresentation(*representationNameIt, baselineRepresentation);
+      copiedRepresentations[sourceRepresentation] = baselineRepresentation;
       }
     else
       {
@@ -187,6 +198,7 @@ void vtkSegmentationHistory::CopySegment(vtkSegment* destination, vtkSegment* so
         }
       representationCopy->DeepCopy(sourceRepresentation);
       destination->AddRepresentation(*representationNameIt, representationCopy);
+      copiedRepresentations[sourceRepresentation] = representationCopy;
       representationCopy->Delete(); // this representation is now owned by the segment
       }
     }
@@ -247,6 +259,8 @@ bool vtkSegmentationHistory::RestoreState(unsigned int stateIndex)
   SegmentationState restoredState = this->SegmentationStates[stateIndex];
 
   std::set<std::string> segmentIDsToKeep;
+  // Labelmap layers shared between segments are restored only once
+  std::map<vtkDataObject*, vtkSmartPointer<vtkDataObject> > restoredRepresentations;
   for (SegmentsMap::iterator restoredSegmentsIt = restoredState.Segments.begin();
     restoredSegmentsIt != restoredState.Segments.end(); ++restoredSegmentsIt)
     {
@@ -254,13 +268,13 @@ bool vtkSegmentationHistory::RestoreState(unsigned int stateIndex)
     vtkSegment* segment = this->Segmentation->GetSegment(restoredSegmentsIt->first);
     if (segment != NULL)
       {
-      segment->DeepCopy(restoredSegmentsIt->second);
+      CopySegment(segment, restoredSegmentsIt->second, NULL, restoredRepresentations);
       segment->Modified();
       }
     else
       {
       vtkSmartPointer<vtkSegment> newSegment = vtkSmartPointer<vtkSegment>::New();
-      newSegment->DeepCopy(restoredSegmentsIt->second);
+      CopySegment(newSegment, restoredSegmentsIt->second, NULL, restoredRepresentations);
       this->Segmentation->AddSegment(newSegment);
       }
     }
@@ -32,6 +32,7 @@
 #include "vtkSegmentationCoreConfigure.h"
 
 class vtkCallbackCommand;
+class vtkDataObject;
 class vtkSegment;
 class vtkSegmentation;
 
@@ -102,7 +103,10 @@ protected:
 
   /// Deep copies source segment to destination segment. If the same representation is found in baseline
   /// with up-to-date timestamp then the representation is reused from baseline.
-  void CopySegment(vtkSegment* destination, vtkSegment* source, vtkSegment* baseline);
+  /// Representations that are shared between segments (labelmap layers) are copied only once,
+  /// copiedRepresentations maps the source representation objects to their copies.
+  void CopySegment(vtkSegment* destination, vtkSegment* source, vtkSegment* baseline,
+    std::map<vtkDataObject*, vtkSmartPointer<vtkDataObject> >& copiedRepresentations);
 
 protected:  /// Container type for segments. Maps segment IDs to segment objects
   typedef std::map<std::string, vtkSmartPointer<vtkSegment> > SegmentsMap;
@@ -24,11 +24,15 @@
 // VTK includes
 #include <vtkDataArray.h>
 #include <vtkImageData.h>
+#include <vtkIntArray.h>
 #include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
 #include <vtkVersion.h>
 
+// STD includes
+#include <cmath>
+
 //----------------------------------------------------------------------------
 int vtkDiffusionTensorMathematicsTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
 {
@@ -119,5 +123,32 @@ int vtkDiffusionTensorMathematicsTest1(int vtkNotUsed(argc), char* vtkNotUsed(ar
       }
     std::cout << std::endl << std::endl;
     }
+
+  // Compute multiple scalar maps in one pass
+  vtkNew<vtkDiffusionTensorMathematics> mapsFilter;
+  vtkNew<vtkIntArray> operations;
+  operations->InsertNextValue(vtkDiffusionTensorMathematics::VTK_TENS_TRACE);
+  operations->InsertNextValue(vtkDiffusionTensorMathematics::VTK_TENS_FRACTIONAL_ANISOTROPY);
+  operations->InsertNextValue(vtkDiffusionTensorMathematics::VTK_TENS_MAX_EIGENVALUE);
+  operations->InsertNextValue(vtkDiffusionTensorMathematics::VTK_TENS_MIN_EIGENVALUE);
+  vtkNew<vtkImageData> maps;
+  if (!mapsFilter->ComputeScalarMaps(tensorImage.GetPointer(), operations.GetPointer(), maps.GetPointer())
+    || maps->GetNumberOfScalarComponents() != 4)
+    {
+    std::cerr << "ComputeScalarMaps failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const int numberOfVoxels = dimensions[0]*dimensions[1]*dimensions[2];
+  ptr = reinterpret_cast<float*>(maps->GetScalarPointer());
+  // first voxel is identity, last voxel is diag(1,1,2)
+  float* lastVoxel = ptr + (numberOfVoxels - 1) * 4;
+  if (fabs(ptr[0] - 3.) > 1e-5 || fabs(ptr[1]) > 1e-5 || fabs(ptr[2] - 1.) > 1e-5 || fabs(ptr[3] - 1.) > 1e-5
+    || fabs(lastVoxel[0] - 4.) > 1e-5 || fabs(lastVoxel[2] - 2.) > 1e-5 || fabs(lastVoxel[3] - 1.) > 1e-5)
+    {
+    std::cerr << "ComputeScalarMaps returned wrong values: "
+      << ptr[0] << " " << ptr[1] << " " << ptr[2] << " " << ptr[3] << " / "
+      << lastVoxel[0] << " " << lastVoxel[1] << " " << lastVoxel[2] << " " << lastVoxel[3] << std::endl;
+    return EXIT_FAILURE;
+    }
   return EXIT_SUCCESS;
 }
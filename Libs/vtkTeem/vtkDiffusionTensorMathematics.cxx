@@ -22,12 +22,15 @@
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkImageData.h"
+#include "vtkIntArray.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkDiffusionTensorMathematics.h"
 #include "vtkMath.h"
 #include "vtkObjectFactory.h"
 #include "vtkTransform.h"
 #include "vtkPointData.h"
+#include "vtkSMPThreadLocal.h"
+#include "vtkSMPTools.h"
 #ifndef M_SQRT2
 #define M_SQRT2    1.41421356237309504880168872421      /* sqrt(2) */
 #endif
@@ -36,8 +39,10 @@ extern "C" {
 #include "teem/ten.h"
 }
 
+#include <algorithm>
 #include <ctime>
 #include <limits>
+#include <vector>
 
 #define VTK_EPS 1e-16
 #define DOUBLE_NAN (std::numeric_limits<double>::quiet_NaN())
@@ -364,6 +369,358 @@ inline Type tensor_math_clamp(const Type a,
                   const Type b,
                   const Type c) { return (a) > (b) ? ((a) < (c) ? (a) : (c)) : (b) ; }
 
+//----------------------------------------------------------------------------
+// Operations that only depend on the tensor components
+static bool vtkDiffusionTensorMathematicsIsComponentOperation(int op)
+{
+  switch (op)
+    {
+    case vtkDiffusionTensorMathematics::VTK_TENS_D11:
+    case vtkDiffusionTensorMathematics::VTK_TENS_D22:
+    case vtkDiffusionTensorMathematics::VTK_TENS_D33:
+    case vtkDiffusionTensorMathematics::VTK_TENS_TRACE:
+    case vtkDiffusionTensorMathematics::VTK_TENS_DETERMINANT:
+      return true;
+    default:
+      return false;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Operations that only depend on the eigenvalues (eigenvectors are not needed)
+static bool vtkDiffusionTensorMathematicsIsEigenvalueOperation(int op)
+{
+  switch (op)
+    {
+    case vtkDiffusionTensorMathematics::VTK_TENS_RELATIVE_ANISOTROPY:
+    case vtkDiffusionTensorMathematics::VTK_TENS_FRACTIONAL_ANISOTROPY:
+    case vtkDiffusionTensorMathematics::VTK_TENS_LINEAR_MEASURE:
+    case vtkDiffusionTensorMathematics::VTK_TENS_PLANAR_MEASURE:
+    case vtkDiffusionTensorMathematics::VTK_TENS_SPHERICAL_MEASURE:
+    case vtkDiffusionTensorMathematics::VTK_TENS_MAX_EIGENVALUE:
+    case vtkDiffusionTensorMathematics::VTK_TENS_MID_EIGENVALUE:
+    case vtkDiffusionTensorMathematics::VTK_TENS_MIN_EIGENVALUE:
+    case vtkDiffusionTensorMathematics::VTK_TENS_MODE:
+    case vtkDiffusionTensorMathematics::VTK_TENS_COLOR_MODE:
+    case vtkDiffusionTensorMathematics::VTK_TENS_PARALLEL_DIFFUSIVITY:
+    case vtkDiffusionTensorMathematics::VTK_TENS_PERPENDICULAR_DIFFUSIVITY:
+      return true;
+    default:
+      return false;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Tensors and eigenvalues of an image row, stored in structure-of-arrays form
+// so that the computations can be done for many voxels in simple loops
+// (that the compiler can vectorize).
+class vtkDiffusionTensorMathematicsRowBuffer
+{
+public:
+  vtkDiffusionTensorMathematicsRowBuffer(int length)
+    : Length(length)
+    , Dxx(length), Dxy(length), Dxz(length), Dyy(length), Dyz(length), Dzz(length)
+    , W0(length), W1(length), W2(length), Value(length)
+    {
+    }
+
+  // Load the upper triangle of 3x3 float tensors
+  void Load(const float* inPtr)
+    {
+    for (int i = 0; i < this->Length; i++, inPtr += 9)
+      {
+      this->Dxx[i] = inPtr[0];
+      this->Dxy[i] = inPtr[1];
+      this->Dxz[i] = inPtr[2];
+      this->Dyy[i] = inPtr[4];
+      this->Dyz[i] = inPtr[5];
+      this->Dzz[i] = inPtr[8];
+      }
+    }
+
+  // Closed-form eigenvalues of symmetric 3x3 matrices (trigonometric solution
+  // of the characteristic equation). Eigenvalues are sorted: W0 >= W1 >= W2.
+  void ComputeEigenvalues()
+    {
+    const double twoThirdPi = 2.0 * vtkMath::Pi() / 3.0;
+    for (int i = 0; i < this->Length; i++)
+      {
+      const double xy = this->Dxy[i];
+      const double xz = this->Dxz[i];
+      const double yz = this->Dyz[i];
+      const double mean = (this->Dxx[i] + this->Dyy[i] + this->Dzz[i]) / 3.0;
+      const double a = this->Dxx[i] - mean;
+      const double d = this->Dyy[i] - mean;
+      const double f = this->Dzz[i] - mean;
+      const double offDiagonal = xy * xy + xz * xz + yz * yz;
+      const double p = sqrt((a * a + d * d + f * f + 2.0 * offDiagonal) / 6.0);
+      // r = det((A - mean*I) / p) / 2, in [-1, 1]
+      const double detB = a * (d * f - yz * yz) - xy * (xy * f - yz * xz) + xz * (xy * yz - d * xz);
+      const double pInv = (p > VTK_EPS ? 1.0 / p : 0.0);
+      double r = detB * pInv * pInv * pInv * 0.5;
+      r = (r < -1.0 ? -1.0 : (r > 1.0 ? 1.0 : r));
+      const double phi = acos(r) / 3.0;
+      this->W0[i] = mean + 2.0 * p * cos(phi);
+      this->W2[i] = mean + 2.0 * p * cos(phi + twoThirdPi);
+      this->W1[i] = 3.0 * mean - this->W0[i] - this->W2[i];
+      }
+    }
+
+  // Same correction as in vtkDiffusionTensorMathematicsExecute1Eigen.
+  // Returns the number of voxels that still have negative eigenvalues after the correction.
+  int FixEigenvalues(bool fixNegativeEigenvalues)
+    {
+    int numberOfNegativeEigenvalues = 0;
+    for (int i = 0; i < this->Length; i++)
+      {
+      if (fixNegativeEigenvalues)
+        {
+        // the smallest eigenvalue is W2
+        const double shift = (this->W2[i] < 0 ? -this->W2[i] + VTK_EPS : 0.0);
+        this->W0[i] += shift;
+        this->W1[i] += shift;
+        this->W2[i] += shift;
+        if (this->W0[i] < 0 || this->W1[i] < 0 || this->W2[i] < 0)
+          {
+          numberOfNegativeEigenvalues++;
+          }
+        }
+      else
+        {
+        this->W0[i] = (this->W0[i] < 0 ? DOUBLE_NAN : this->W0[i]);
+        this->W1[i] = (this->W1[i] < 0 ? DOUBLE_NAN : this->W1[i]);
+        this->W2[i] = (this->W2[i] < 0 ? DOUBLE_NAN : this->W2[i]);
+        }
+      }
+    return numberOfNegativeEigenvalues;
+    }
+
+  template <double (*Function)(double[3])>
+  void EvaluateEigenvalueFunction()
+    {
+    double w[3];
+    for (int i = 0; i < this->Length; i++)
+      {
+      w[0] = this->W0[i];
+      w[1] = this->W1[i];
+      w[2] = this->W2[i];
+      this->Value[i] = Function(w);
+      }
+    }
+
+  // Compute the result of a component or eigenvalue operation in Value.
+  // Eigenvalues must be already computed for eigenvalue operations.
+  void Evaluate(int op)
+    {
+    int i;
+    switch (op)
+      {
+      case vtkDiffusionTensorMathematics::VTK_TENS_D11:
+        this->Value = this->Dxx;
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_D22:
+        this->Value = this->Dyy;
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_D33:
+        this->Value = this->Dzz;
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_TRACE:
+        for (i = 0; i < this->Length; i++)
+          {
+          this->Value[i] = this->Dxx[i] + this->Dyy[i] + this->Dzz[i];
+          }
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_DETERMINANT:
+        for (i = 0; i < this->Length; i++)
+          {
+          this->Value[i] = this->Dxx[i] * (this->Dyy[i] * this->Dzz[i] - this->Dyz[i] * this->Dyz[i])
+            - this->Dxy[i] * (this->Dxy[i] * this->Dzz[i] - this->Dyz[i] * this->Dxz[i])
+            + this->Dxz[i] * (this->Dxy[i] * this->Dyz[i] - this->Dyy[i] * this->Dxz[i]);
+          }
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_MAX_EIGENVALUE:
+      case vtkDiffusionTensorMathematics::VTK_TENS_PARALLEL_DIFFUSIVITY:
+        this->Value = this->W0;
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_MID_EIGENVALUE:
+        this->Value = this->W1;
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_MIN_EIGENVALUE:
+        this->Value = this->W2;
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_PERPENDICULAR_DIFFUSIVITY:
+        for (i = 0; i < this->Length; i++)
+          {
+          this->Value[i] = (this->W1[i] + this->W2[i]) / 2;
+          }
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_RELATIVE_ANISOTROPY:
+        this->EvaluateEigenvalueFunction<vtkDiffusionTensorMathematics::RelativeAnisotropy>();
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_FRACTIONAL_ANISOTROPY:
+        this->EvaluateEigenvalueFunction<vtkDiffusionTensorMathematics::FractionalAnisotropy>();
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_LINEAR_MEASURE:
+        this->EvaluateEigenvalueFunction<vtkDiffusionTensorMathematics::LinearMeasure>();
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_PLANAR_MEASURE:
+        this->EvaluateEigenvalueFunction<vtkDiffusionTensorMathematics::PlanarMeasure>();
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_SPHERICAL_MEASURE:
+        this->EvaluateEigenvalueFunction<vtkDiffusionTensorMathematics::SphericalMeasure>();
+        break;
+      case vtkDiffusionTensorMathematics::VTK_TENS_MODE:
+        this->EvaluateEigenvalueFunction<vtkDiffusionTensorMathematics::Mode>();
+        break;
+      default:
+        std::fill(this->Value.begin(), this->Value.end(), 0.0);
+        break;
+      }
+    }
+
+  int Length;
+  std::vector<double> Dxx, Dxy, Dxz, Dyy, Dyz, Dzz;
+  std::vector<double> W0, W1, W2;
+  std::vector<double> Value;
+};
+
+//----------------------------------------------------------------------------
+// This templated function executes the filter for any type of data.
+// Handles the one input operations.
+// Handles the ops where only eigenvalues are needed: eigenvalues of
+// a full image row are computed at once, using a closed-form solution.
+template <class T>
+static void vtkDiffusionTensorMathematicsExecute1EigenvalueBatch(vtkDiffusionTensorMathematics *self,
+                          vtkImageData *in1Data,
+                          vtkImageData *outData,
+                          T *outPtr,
+                          int outExt[6], int id)
+{
+  int op = self->GetOperation();
+  double scaleFactor = self->GetScaleFactor();
+  bool fixNegativeEigenvalues = (self->GetFixNegativeEigenvalues() == 1);
+  const double rgb_scale = (double)VTK_UNSIGNED_CHAR_MAX * scaleFactor / 1000.;
+
+  vtkDataArray* inTensors = in1Data->GetPointData()->GetTensors();
+  if ( !inTensors || in1Data->GetNumberOfPoints() < 1 )
+    {
+    vtkGenericWarningMacro(<<"No input tensor data to filter!");
+    return;
+    }
+  if (self->GetScalarMask() && self->GetScalarMask()->GetScalarType() != VTK_SHORT)
+    {
+    vtkGenericWarningMacro(<<"scalr type for mask must be short!");
+    return;
+    }
+
+  // find the output region to loop over
+  int rowLength = (outExt[1] - outExt[0]+1);
+  int maxY = outExt[3] - outExt[2];
+  int maxZ = outExt[5] - outExt[4];
+  unsigned long count = 0;
+  unsigned long target = (unsigned long)((maxZ+1)*(maxY+1)/50.0);
+  target++;
+
+  vtkIdType outIncX, outIncY, outIncZ;
+  vtkIdType inIncX, inIncY, inIncZ;
+  outData->GetContinuousIncrements(outExt, outIncX, outIncY, outIncZ);
+  GetContinuousIncrements(in1Data, outExt, inIncX, inIncY, inIncZ);
+  float* inPtr = reinterpret_cast<float*>(in1Data->GetArrayPointerForExtent(inTensors, outExt));
+
+  bool doMasking = false;
+  short * inMaskPtr = 0;
+  vtkIdType maskIncX = 0;
+  vtkIdType maskIncY = 0;
+  vtkIdType maskIncZ = 0;
+  if (self->GetMaskWithScalars() && self->GetScalarMask())
+    {
+    self->GetScalarMask()->GetContinuousIncrements(outExt, maskIncX, maskIncY, maskIncZ);
+    inMaskPtr = reinterpret_cast<short *>(self->GetScalarMask()->GetScalarPointerForExtent(outExt));
+    doMasking = self->GetScalarMask()->GetPointData()->GetScalars() != 0;
+    }
+  int maskLabelValue = self->GetMaskLabelValue();
+
+  vtkDiffusionTensorMathematicsRowBuffer row(rowLength);
+  int numberOfNegativeEigenvalues = 0;
+  double w[3];
+  double r, g, b;
+  for (int idxZ = 0; idxZ <= maxZ; idxZ++)
+    {
+    for (int idxY = 0; idxY <= maxY; idxY++)
+      {
+      if (!id)
+        {
+        if (!(count%target))
+          {
+          self->UpdateProgress(count/(50.0*target));
+          }
+        count++;
+        }
+
+      row.Load(inPtr);
+      row.ComputeEigenvalues();
+      numberOfNegativeEigenvalues += row.FixEigenvalues(fixNegativeEigenvalues);
+
+      if (op == vtkDiffusionTensorMathematics::VTK_TENS_COLOR_MODE)
+        {
+        for (int idxR = 0; idxR < rowLength; idxR++)
+          {
+          if (doMasking && inMaskPtr[idxR] != maskLabelValue)
+            {
+            r = g = b = 0.0;
+            }
+          else
+            {
+            w[0] = row.W0[idxR];
+            w[1] = row.W1[idxR];
+            w[2] = row.W2[idxR];
+            vtkDiffusionTensorMathematics::ColorByMode(w,r,g,b);
+            r *= rgb_scale;
+            g *= rgb_scale;
+            b *= rgb_scale;
+            }
+          *(outPtr++) = (T)tensor_math_clamp(r, (double)VTK_UNSIGNED_CHAR_MIN, (double)VTK_UNSIGNED_CHAR_MAX);
+          *(outPtr++) = (T)tensor_math_clamp(g, (double)VTK_UNSIGNED_CHAR_MIN, (double)VTK_UNSIGNED_CHAR_MAX);
+          *(outPtr++) = (T)tensor_math_clamp(b, (double)VTK_UNSIGNED_CHAR_MIN, (double)VTK_UNSIGNED_CHAR_MAX);
+          *(outPtr++) = (T)VTK_UNSIGNED_CHAR_MAX; //alpha
+          }
+        }
+      else
+        {
+        row.Evaluate(op);
+        for (int idxR = 0; idxR < rowLength; idxR++)
+          {
+          T value = static_cast<T>(row.Value[idxR]);
+          if (scaleFactor != 1)
+            {
+            value = (T) (value * scaleFactor);
+            }
+          *(outPtr++) = (doMasking && inMaskPtr[idxR] != maskLabelValue) ? 0 : value;
+          }
+        }
+
+      inPtr += 9 * rowLength + inIncY;
+      outPtr += outIncY;
+      if (doMasking)
+        {
+        inMaskPtr += rowLength + maskIncY;
+        }
+      }
+    outPtr += outIncZ;
+    inPtr += inIncZ;
+    if (doMasking)
+      {
+      inMaskPtr += maskIncZ;
+      }
+    }
+
+  if (numberOfNegativeEigenvalues > 0)
+    {
+    vtkGenericWarningMacro( "Warning: Negative Eigenvalues after positivity fix in "
+      << numberOfNegativeEigenvalues << " voxels" );
+    }
+}
+
 //----------------------------------------------------------------------------
 // This templated function executes the filter for any type of data.
 // Handles the one input operations.
@@ -798,6 +1155,175 @@ static void vtkDiffusionTensorMathematicsExecute1Eigen(vtkDiffusionTensorMathema
 #endif
 }
 
+//----------------------------------------------------------------------------
+// Computes multiple scalar maps for a range of slices
+class vtkDiffusionTensorMathematicsScalarMapsFunctor
+{
+public:
+  vtkDiffusionTensorMathematicsScalarMapsFunctor(vtkImageData* tensorImage, vtkImageData* outputImage,
+    const std::vector<int>& operations, double scaleFactor, bool fixNegativeEigenvalues,
+    vtkImageData* mask, int maskLabelValue)
+    : TensorImage(tensorImage)
+    , OutputImage(outputImage)
+    , Operations(operations)
+    , ScaleFactor(scaleFactor)
+    , FixNegativeEigenvalues(fixNegativeEigenvalues)
+    , Mask(mask)
+    , MaskLabelValue(maskLabelValue)
+    {
+    this->ComputeEigenvalues = false;
+    for (std::vector<int>::const_iterator opIt = this->Operations.begin(); opIt != this->Operations.end(); ++opIt)
+      {
+      if (vtkDiffusionTensorMathematicsIsEigenvalueOperation(*opIt))
+        {
+        this->ComputeEigenvalues = true;
+        }
+      }
+    }
+
+  void Initialize()
+    {
+    this->NumberOfNegativeEigenvalues.Local() = 0;
+    }
+
+  void operator()(vtkIdType beginSlice, vtkIdType endSlice)
+    {
+    const int* extent = this->TensorImage->GetExtent();
+    const int rowLength = extent[1] - extent[0] + 1;
+    const int numberOfRows = extent[3] - extent[2] + 1;
+    const int numberOfOperations = static_cast<int>(this->Operations.size());
+
+    vtkDataArray* inTensors = this->TensorImage->GetPointData()->GetTensors();
+    const float* tensors = static_cast<const float*>(inTensors->GetVoidPointer(0));
+    float* output = static_cast<float*>(this->OutputImage->GetScalarPointer());
+    const short* mask = (this->Mask ? static_cast<const short*>(this->Mask->GetScalarPointer()) : NULL);
+    const int maskComponents = (this->Mask ? this->Mask->GetNumberOfScalarComponents() : 1);
+
+    vtkDiffusionTensorMathematicsRowBuffer row(rowLength);
+    int& numberOfNegativeEigenvalues = this->NumberOfNegativeEigenvalues.Local();
+    for (vtkIdType slice = beginSlice; slice < endSlice; slice++)
+      {
+      for (int rowIndex = 0; rowIndex < numberOfRows; rowIndex++)
+        {
+        vtkIdType firstVoxel = (slice * numberOfRows + rowIndex) * rowLength;
+        row.Load(tensors + firstVoxel * 9);
+        if (this->ComputeEigenvalues)
+          {
+          row.ComputeEigenvalues();
+          numberOfNegativeEigenvalues += row.FixEigenvalues(this->FixNegativeEigenvalues);
+          }
+        for (int operationIndex = 0; operationIndex < numberOfOperations; operationIndex++)
+          {
+          row.Evaluate(this->Operations[operationIndex]);
+          float* outPtr = output + firstVoxel * numberOfOperations + operationIndex;
+          for (int i = 0; i < rowLength; i++, outPtr += numberOfOperations)
+            {
+            if (mask && mask[(firstVoxel + i) * maskComponents] != this->MaskLabelValue)
+              {
+              *outPtr = 0;
+              }
+            else
+              {
+              *outPtr = static_cast<float>(row.Value[i] * this->ScaleFactor);
+              }
+            }
+          }
+        }
+      }
+    }
+
+  void Reduce()
+    {
+    int numberOfNegativeEigenvalues = 0;
+    for (vtkSMPThreadLocal<int>::iterator it = this->NumberOfNegativeEigenvalues.begin();
+      it != this->NumberOfNegativeEigenvalues.end(); ++it)
+      {
+      numberOfNegativeEigenvalues += *it;
+      }
+    if (numberOfNegativeEigenvalues > 0)
+      {
+      vtkGenericWarningMacro( "Warning: Negative Eigenvalues after positivity fix in "
+        << numberOfNegativeEigenvalues << " voxels" );
+      }
+    }
+
+private:
+  vtkImageData* TensorImage;
+  vtkImageData* OutputImage;
+  const std::vector<int>& Operations;
+  double ScaleFactor;
+  bool FixNegativeEigenvalues;
+  vtkImageData* Mask;
+  int MaskLabelValue;
+  bool ComputeEigenvalues;
+  vtkSMPThreadLocal<int> NumberOfNegativeEigenvalues;
+};
+
+//----------------------------------------------------------------------------
+int vtkDiffusionTensorMathematics::ComputeScalarMaps(vtkImageData* tensorImage,
+  vtkIntArray* operations, vtkImageData* outputImage)
+{
+  if (!tensorImage || !operations || !outputImage)
+    {
+    vtkErrorMacro("ComputeScalarMaps: Invalid input");
+    return 0;
+    }
+  vtkDataArray* inTensors = tensorImage->GetPointData()->GetTensors();
+  if (!inTensors || inTensors->GetDataType() != VTK_FLOAT || inTensors->GetNumberOfComponents() != 9)
+    {
+    vtkErrorMacro("ComputeScalarMaps: Input must have float tensors with 9 components");
+    return 0;
+    }
+  std::vector<int> ops;
+  for (vtkIdType index = 0; index < operations->GetNumberOfTuples(); index++)
+    {
+    int op = operations->GetValue(index);
+    if (!vtkDiffusionTensorMathematicsIsComponentOperation(op)
+      && (!vtkDiffusionTensorMathematicsIsEigenvalueOperation(op) || op == VTK_TENS_COLOR_MODE))
+      {
+      vtkErrorMacro("ComputeScalarMaps: Operation " << op << " is not supported");
+      return 0;
+      }
+    ops.push_back(op);
+    }
+  if (ops.empty())
+    {
+    vtkErrorMacro("ComputeScalarMaps: No operations are specified");
+    return 0;
+    }
+
+  vtkImageData* mask = NULL;
+  if (this->MaskWithScalars && this->ScalarMask && this->ScalarMask->GetPointData()->GetScalars())
+    {
+    int maskExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    this->ScalarMask->GetExtent(maskExtent);
+    int* tensorExtent = tensorImage->GetExtent();
+    if (this->ScalarMask->GetScalarType() != VTK_SHORT
+      || !std::equal(maskExtent, maskExtent + 6, tensorExtent))
+      {
+      vtkErrorMacro("ComputeScalarMaps: Scalar mask must be short type with the same extent as the tensor image");
+      return 0;
+      }
+    mask = this->ScalarMask;
+    }
+
+  outputImage->SetExtent(tensorImage->GetExtent());
+  outputImage->SetOrigin(tensorImage->GetOrigin());
+  outputImage->SetSpacing(tensorImage->GetSpacing());
+  outputImage->AllocateScalars(VTK_FLOAT, static_cast<int>(ops.size()));
+
+  const int* extent = tensorImage->GetExtent();
+  vtkIdType numberOfSlices = extent[5] - extent[4] + 1;
+  if (tensorImage->GetNumberOfPoints() < 1)
+    {
+    return 1;
+    }
+  vtkDiffusionTensorMathematicsScalarMapsFunctor functor(tensorImage, outputImage, ops,
+    this->ScaleFactor, this->FixNegativeEigenvalues == 1, mask, this->MaskLabelValue);
+  vtkSMPTools::For(0, numberOfSlices, functor);
+  return 1;
+}
+
 //----------------------------------------------------------------------------
 // This method computes the increments from the MemoryOrder and the extent.
 void vtkDiffusionTensorMathematics::ComputeTensorIncrements(vtkImageData *imageData, vtkIdType incr[3])
@@ -874,7 +1400,7 @@ void vtkDiffusionTensorMathematics::ThreadedRequestData(
       }
       break;
 
-    // Operations where eigenvalues are computed
+    // Operations where only eigenvalues are computed
     case VTK_TENS_RELATIVE_ANISOTROPY:
     case VTK_TENS_FRACTIONAL_ANISOTROPY:
     case VTK_TENS_LINEAR_MEASURE:
@@ -883,6 +1409,27 @@ void vtkDiffusionTensorMathematics::ThreadedRequestData(
     case VTK_TENS_MAX_EIGENVALUE:
     case VTK_TENS_MID_EIGENVALUE:
     case VTK_TENS_MIN_EIGENVALUE:
+    case VTK_TENS_MODE:
+    case VTK_TENS_COLOR_MODE:
+    case VTK_TENS_PARALLEL_DIFFUSIVITY:
+    case VTK_TENS_PERPENDICULAR_DIFFUSIVITY:
+      if (this->ExtractEigenvalues)
+        {
+        // eigenvalues of full image rows are computed at once
+        switch (outData[0]->GetScalarType())
+        {
+          vtkTemplateMacro(vtkDiffusionTensorMathematicsExecute1EigenvalueBatch(
+                  this,inData[0][0], outData[0],
+                  static_cast<VTK_TT*>(outPtr), outExt, id));
+          default:
+          vtkErrorMacro(<< "Execute: Unknown ScalarType");
+          return;
+        }
+        break;
+        }
+      // eigenvalues are not extracted but computed from tensor columns
+      // (same as when eigenvectors are needed)
+    // Operations where eigenvalues and eigenvectors are computed
     case VTK_TENS_MAX_EIGENVALUE_PROJX:
     case VTK_TENS_MAX_EIGENVALUE_PROJY:
     case VTK_TENS_MAX_EIGENVALUE_PROJZ:
@@ -890,10 +1437,6 @@ void vtkDiffusionTensorMathematics::ThreadedRequestData(
     case VTK_TENS_RAI_MAX_EIGENVEC_PROJY:
     case VTK_TENS_RAI_MAX_EIGENVEC_PROJZ:
     case VTK_TENS_COLOR_ORIENTATION:
-    case VTK_TENS_MODE:
-    case VTK_TENS_COLOR_MODE:
-    case VTK_TENS_PARALLEL_DIFFUSIVITY:
-    case VTK_TENS_PERPENDICULAR_DIFFUSIVITY:
       switch (outData[0]->GetScalarType())
       {
         vtkTemplateMacro(vtkDiffusionTensorMathematicsExecute1Eigen(
@@ -34,6 +34,7 @@
 
 class vtkMatrix4x4;
 class vtkImageData;
+class vtkIntArray;
 class VTK_Teem_EXPORT vtkDiffusionTensorMathematics : public vtkThreadedImageAlgorithm
 {
 public:
@@ -229,6 +230,18 @@ public:
   vtkSetMacro(MaskLabelValue, int);
   vtkGetMacro(MaskLabelValue, int);
 
+  ///
+  /// Compute several scalar maps from the tensors of \a tensorImage in a single pass.
+  /// \a operations contains the operation codes (VTK_TENS_...) and \a outputImage
+  /// receives a float image that has the geometry of the input and one component
+  /// per operation. Only operations that need the tensor components or the
+  /// eigenvalues are supported (color and eigenvector based operations are not).
+  /// Eigenvalues are computed only once per voxel and only if any of the
+  /// operations needs them. ScaleFactor, FixNegativeEigenvalues and scalar
+  /// mask settings of the filter are used.
+  /// Returns 1 on success, 0 on failure.
+  int ComputeScalarMaps(vtkImageData* tensorImage, vtkIntArray* operations, vtkImageData* outputImage);
+
   /// Public for access from threads
   static void ModeToRGB(double Mode, double FA,
                  double &R, double &G, double &B);
@@ -413,6 +413,39 @@ int DoIt( int argc, char *argv[] )
               << std::endl;
     }
 
+  reger->SetRigidNumberOfLevels( rigidPyramidLevels );
+  reger->SetRigidLevelSamplingRatios( std::vector<double>( rigidLevelSamplingRatios.begin(),
+                                                           rigidLevelSamplingRatios.end() ) );
+  reger->SetRigidLevelMaxIterations( std::vector<unsigned int>( rigidLevelMaxIterations.begin(),
+                                                                rigidLevelMaxIterations.end() ) );
+  if( verbosity >= STANDARD )
+    {
+    std::cout << "###RigidPyramidLevels: " << rigidPyramidLevels
+              << std::endl;
+    }
+
+  reger->SetAffineNumberOfLevels( affinePyramidLevels );
+  reger->SetAffineLevelSamplingRatios( std::vector<double>( affineLevelSamplingRatios.begin(),
+                                                            affineLevelSamplingRatios.end() ) );
+  reger->SetAffineLevelMaxIterations( std::vector<unsigned int>( affineLevelMaxIterations.begin(),
+                                                                 affineLevelMaxIterations.end() ) );
+  if( verbosity >= STANDARD )
+    {
+    std::cout << "###AffinePyramidLevels: " << affinePyramidLevels
+              << std::endl;
+    }
+
+  reger->SetBSplineNumberOfLevels( bsplinePyramidLevels );
+  reger->SetBSplineLevelSamplingRatios( std::vector<double>( bsplineLevelSamplingRatios.begin(),
+                                                             bsplineLevelSamplingRatios.end() ) );
+  reger->SetBSplineLevelMaxIterations( std::vector<unsigned int>( bsplineLevelMaxIterations.begin(),
+                                                                  bsplineLevelMaxIterations.end() ) );
+  if( verbosity >= STANDARD )
+    {
+    std::cout << "###BSplinePyramidLevels: " << bsplinePyramidLevels
+              << std::endl;
+    }
+
   /** not sure */
   if( interpolation == "NearestNeighbor" )
     {
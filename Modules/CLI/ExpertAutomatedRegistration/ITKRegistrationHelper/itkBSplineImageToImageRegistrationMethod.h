@@ -88,9 +88,6 @@ public:
   itkSetClampMacro( NumberOfControlPoints, unsigned int, 3, 2000 );
   itkGetConstMacro( NumberOfControlPoints, unsigned int );
 
-  itkSetClampMacro( NumberOfLevels, unsigned int, 1, 5 );
-  itkGetConstMacro( NumberOfLevels, unsigned int );
-
   BSplineTransformPointer GetBSplineTransform( void ) const;
 
   void ComputeGridRegion( int numberOfControlPoints,
@@ -128,8 +125,6 @@ private:
 
   unsigned int m_NumberOfControlPoints;
 
-  unsigned int m_NumberOfLevels;
-
   bool m_GradientOptimizeOnly;
 
 };
@@ -122,12 +122,12 @@ BSplineImageToImageRegistrationMethod<TImage>
 ::BSplineImageToImageRegistrationMethod( void )
 {
   m_NumberOfControlPoints = 10;
-  m_NumberOfLevels = 4;
   m_ExpectedDeformationMagnitude = 10;
   m_GradientOptimizeOnly = false;
   this->SetTransformMethodEnum( Superclass::BSPLINE_TRANSFORM );
 
   // Override superclass defaults:
+  this->SetNumberOfLevels( 4 );
   this->SetMaxIterations( 40 );
   this->SetNumberOfSamples( 800000 );
   this->SetInterpolationMethodEnum( Superclass::BSPLINE_INTERPOLATION );
@@ -471,9 +471,9 @@ BSplineImageToImageRegistrationMethod<TImage>
   unsigned int levelNumberOfControlPoints =
     this->GetNumberOfControlPoints();
   double levelScale = 1;
-  if( this->m_NumberOfLevels > 1 )
+  if( this->GetNumberOfLevels() > 1 )
     {
-    for( unsigned int level = 1; level < this->m_NumberOfLevels; level++ )
+    for( unsigned int level = 1; level < this->GetNumberOfLevels(); level++ )
       {
       levelNumberOfControlPoints = (unsigned int)(levelNumberOfControlPoints / controlPointFactor);
       levelScale *= controlPointFactor;
@@ -487,8 +487,8 @@ BSplineImageToImageRegistrationMethod<TImage>
   /**/
   /* Setup the multi-scale image pyramids */
   /**/
-  fixedPyramid->SetNumberOfLevels( this->m_NumberOfLevels );
-  movingPyramid->SetNumberOfLevels( this->m_NumberOfLevels );
+  fixedPyramid->SetNumberOfLevels( this->GetNumberOfLevels() );
+  movingPyramid->SetNumberOfLevels( this->GetNumberOfLevels() );
 
   typename ImageType::SpacingType fixedSpacing =
     this->GetFixedImage()->GetSpacing();
@@ -522,7 +522,7 @@ BSplineImageToImageRegistrationMethod<TImage>
   /**/
   /*   Second, determine the pyramid at the remaining levels */
   /**/
-  for( level = 1; level < this->m_NumberOfLevels; level++ )
+  for( level = 1; level < this->GetNumberOfLevels(); level++ )
     {
     for( unsigned int i = 0; i < ImageDimension; i++ )
       {
@@ -562,8 +562,10 @@ BSplineImageToImageRegistrationMethod<TImage>
   /**/
   typename Superclass::TransformParametersType levelParameters;
   this->ResampleControlGrid( levelNumberOfControlPoints, levelParameters );
+  RealTimeClock::Pointer timer = RealTimeClock::New();
+
   /* Perform registration at each level */
-  for( level = 0; level < this->m_NumberOfLevels; level++ )
+  for( level = 0; level < this->GetNumberOfLevels(); level++ )
     {
     if( this->GetReportProgress() )
       {
@@ -615,12 +617,11 @@ BSplineImageToImageRegistrationMethod<TImage>
 
     double levelDeformationMagnitude = this->GetExpectedDeformationMagnitude() / levelFactor;
 
-    unsigned int levelNumberOfSamples = (unsigned int)(this->GetNumberOfSamples() / levelFactor);
-    unsigned int fixedImageNumberOfSamples = fixedImage->GetLargestPossibleRegion().GetNumberOfPixels();
-    if( levelNumberOfSamples > fixedImageNumberOfSamples )
-      {
-      levelNumberOfSamples = fixedImageNumberOfSamples;
-      }
+    unsigned int levelNumberOfSamples = this->ComputeLevelNumberOfSamples(
+        level, fixedImage, (unsigned int)(this->GetNumberOfSamples() / levelFactor) );
+
+    unsigned int levelMaxIterations = this->ComputeLevelMaxIterations(
+        level, (unsigned int)(this->GetMaxIterations() / ( (level + 1) / 2.0) ) );
 
     if( this->GetReportProgress() )
       {
@@ -637,6 +638,7 @@ BSplineImageToImageRegistrationMethod<TImage>
     typedef BSplineImageToImageRegistrationMethod<ImageType> BSplineRegType;
     typename BSplineRegType::Pointer reg = BSplineRegType::New();
     reg->SetReportProgress( this->GetReportProgress() );
+    reg->SetRegistrationNumberOfThreads( this->GetRegistrationNumberOfThreads() );
     reg->SetFixedImage( fixedImage );
     reg->SetMovingImage( movingImage );
     reg->SetNumberOfControlPoints( levelNumberOfControlPoints );
@@ -649,14 +651,14 @@ BSplineImageToImageRegistrationMethod<TImage>
       this->GetFixedImageSamplesIntensityThreshold() );
     reg->SetUseFixedImageSamplesIntensityThreshold(
       this->GetUseFixedImageSamplesIntensityThreshold() );
-    reg->SetMaxIterations( (unsigned int)(this->GetMaxIterations() / ( (level + 1) / 2.0) ) );
+    reg->SetMaxIterations( levelMaxIterations );
     reg->SetMetricMethodEnum( this->GetMetricMethodEnum() );
     reg->SetInterpolationMethodEnum( this->GetInterpolationMethodEnum() );
     reg->SetInitialTransformParameters( levelParameters );
     // For the last two levels (the ones at the highest resolution, use
     //   user-specified values of MinimizeMemory, otherwise do not
     //   minimizeMemory so as to maximize speed.
-    if( level >= this->m_NumberOfLevels - 2 )
+    if( level >= this->GetNumberOfLevels() - 2 )
       {
       reg->SetMinimizeMemory( this->GetMinimizeMemory() );
       }
@@ -665,6 +667,8 @@ BSplineImageToImageRegistrationMethod<TImage>
       reg->SetMinimizeMemory( false );
       }
 
+    RealTimeClock::TimeStampType levelStartTime = timer->GetTimeInSeconds();
+
     try
       {
       reg->Update();
@@ -682,6 +686,9 @@ BSplineImageToImageRegistrationMethod<TImage>
                 << std::endl;
       }
 
+    this->AddLevelReport( level, fixedImage, levelNumberOfSamples, levelMaxIterations,
+                          timer->GetTimeInSeconds() - levelStartTime, reg->GetFinalMetricValue() );
+
     /*
     if( this->GetReportProgress() )
       {
@@ -718,11 +725,11 @@ BSplineImageToImageRegistrationMethod<TImage>
       }
     */
 
-    if( level < this->m_NumberOfLevels - 1 )
+    if( level < this->GetNumberOfLevels() - 1 )
       {
       levelNumberOfControlPoints = (unsigned int)(levelNumberOfControlPoints * controlPointFactor);
       if( levelNumberOfControlPoints > this->GetNumberOfControlPoints() ||
-          level == this->m_NumberOfLevels - 2 )
+          level == this->GetNumberOfLevels() - 2 )
         {
         levelNumberOfControlPoints = this->GetNumberOfControlPoints();
         }
@@ -367,6 +367,15 @@ public:
   itkSetMacro( RigidMaxIterations, unsigned int );
   itkGetConstMacro( RigidMaxIterations, unsigned int );
 
+  itkSetClampMacro( RigidNumberOfLevels, unsigned int, 1, 5 );
+  itkGetConstMacro( RigidNumberOfLevels, unsigned int );
+
+  void SetRigidLevelSamplingRatios( const std::vector<double> & ratios );
+  itkGetConstReferenceMacro( RigidLevelSamplingRatios, std::vector<double> );
+
+  void SetRigidLevelMaxIterations( const std::vector<unsigned int> & iterations );
+  itkGetConstReferenceMacro( RigidLevelMaxIterations, std::vector<unsigned int> );
+
   itkSetMacro( RigidMetricMethodEnum, MetricMethodEnumType );
   itkGetConstMacro( RigidMetricMethodEnum, MetricMethodEnumType );
 
@@ -388,6 +397,15 @@ public:
   itkSetMacro( AffineMaxIterations, unsigned int );
   itkGetConstMacro( AffineMaxIterations, unsigned int );
 
+  itkSetClampMacro( AffineNumberOfLevels, unsigned int, 1, 5 );
+  itkGetConstMacro( AffineNumberOfLevels, unsigned int );
+
+  void SetAffineLevelSamplingRatios( const std::vector<double> & ratios );
+  itkGetConstReferenceMacro( AffineLevelSamplingRatios, std::vector<double> );
+
+  void SetAffineLevelMaxIterations( const std::vector<unsigned int> & iterations );
+  itkGetConstReferenceMacro( AffineLevelMaxIterations, std::vector<unsigned int> );
+
   itkSetMacro( AffineMetricMethodEnum, MetricMethodEnumType );
   itkGetConstMacro( AffineMetricMethodEnum, MetricMethodEnumType );
 
@@ -409,6 +427,15 @@ public:
   itkSetMacro( BSplineMaxIterations, unsigned int );
   itkGetConstMacro( BSplineMaxIterations, unsigned int );
 
+  itkSetClampMacro( BSplineNumberOfLevels, unsigned int, 1, 5 );
+  itkGetConstMacro( BSplineNumberOfLevels, unsigned int );
+
+  void SetBSplineLevelSamplingRatios( const std::vector<double> & ratios );
+  itkGetConstReferenceMacro( BSplineLevelSamplingRatios, std::vector<double> );
+
+  void SetBSplineLevelMaxIterations( const std::vector<unsigned int> & iterations );
+  itkGetConstReferenceMacro( BSplineLevelMaxIterations, std::vector<unsigned int> );
+
   itkSetMacro( BSplineControlPointPixelSpacing, double );
   itkGetConstMacro( BSplineControlPointPixelSpacing, double );
 
@@ -511,6 +538,9 @@ private:
   double       m_RigidSamplingRatio;
   double       m_RigidTargetError;
   unsigned int m_RigidMaxIterations;
+  unsigned int m_RigidNumberOfLevels;
+  std::vector<double>       m_RigidLevelSamplingRatios;
+  std::vector<unsigned int> m_RigidLevelMaxIterations;
   typename RigidTransformType::Pointer    m_RigidTransform;
   MetricMethodEnumType        m_RigidMetricMethodEnum;
   InterpolationMethodEnumType m_RigidInterpolationMethodEnum;
@@ -521,6 +551,9 @@ private:
   double       m_AffineSamplingRatio;
   double       m_AffineTargetError;
   unsigned int m_AffineMaxIterations;
+  unsigned int m_AffineNumberOfLevels;
+  std::vector<double>       m_AffineLevelSamplingRatios;
+  std::vector<unsigned int> m_AffineLevelMaxIterations;
   typename AffineTransformType::Pointer   m_AffineTransform;
   MetricMethodEnumType        m_AffineMetricMethodEnum;
   InterpolationMethodEnumType m_AffineInterpolationMethodEnum;
@@ -531,6 +564,9 @@ private:
   double       m_BSplineSamplingRatio;
   double       m_BSplineTargetError;
   unsigned int m_BSplineMaxIterations;
+  unsigned int m_BSplineNumberOfLevels;
+  std::vector<double>       m_BSplineLevelSamplingRatios;
+  std::vector<unsigned int> m_BSplineLevelMaxIterations;
   double       m_BSplineControlPointPixelSpacing;
   typename BSplineTransformType::Pointer  m_BSplineTransform;
   MetricMethodEnumType        m_BSplineMetricMethodEnum;
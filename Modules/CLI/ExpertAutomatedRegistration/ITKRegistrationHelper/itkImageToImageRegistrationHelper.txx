@@ -117,6 +117,9 @@ ImageToImageRegistrationHelper<TImage>
   m_RigidSamplingRatio = 0.01;
   m_RigidTargetError = 0.0001;
   m_RigidMaxIterations = 100;
+  m_RigidNumberOfLevels = 1;
+  m_RigidLevelSamplingRatios.clear();
+  m_RigidLevelMaxIterations.clear();
   m_RigidTransform = NULL;
   m_RigidMetricMethodEnum = OptimizedRegistrationMethodType::MATTES_MI_METRIC;
   m_RigidInterpolationMethodEnum = OptimizedRegistrationMethodType::LINEAR_INTERPOLATION;
@@ -126,6 +129,9 @@ ImageToImageRegistrationHelper<TImage>
   m_AffineSamplingRatio = 0.02;
   m_AffineTargetError = 0.0001;
   m_AffineMaxIterations = 50;
+  m_AffineNumberOfLevels = 1;
+  m_AffineLevelSamplingRatios.clear();
+  m_AffineLevelMaxIterations.clear();
   m_AffineTransform = NULL;
   m_AffineMetricMethodEnum = OptimizedRegistrationMethodType::MATTES_MI_METRIC;
   m_AffineInterpolationMethodEnum = OptimizedRegistrationMethodType::LINEAR_INTERPOLATION;
@@ -135,6 +141,9 @@ ImageToImageRegistrationHelper<TImage>
   m_BSplineSamplingRatio = 0.10;
   m_BSplineTargetError = 0.0001;
   m_BSplineMaxIterations = 20;
+  m_BSplineNumberOfLevels = 4;
+  m_BSplineLevelSamplingRatios.clear();
+  m_BSplineLevelMaxIterations.clear();
   m_BSplineControlPointPixelSpacing = 40;
   m_BSplineTransform = NULL;
   m_BSplineMetricMethodEnum = OptimizedRegistrationMethodType::MATTES_MI_METRIC;
@@ -426,6 +435,9 @@ ImageToImageRegistrationHelper<TImage>
     regRigid->SetSampleFromOverlap( m_SampleFromOverlap );
     regRigid->SetMinimizeMemory( m_MinimizeMemory );
     regRigid->SetMaxIterations( m_RigidMaxIterations );
+    regRigid->SetNumberOfLevels( m_RigidNumberOfLevels );
+    regRigid->SetLevelSamplingRatios( m_RigidLevelSamplingRatios );
+    regRigid->SetLevelMaxIterations( m_RigidLevelMaxIterations );
     regRigid->SetTargetError( m_RigidTargetError );
     if( m_UseFixedImageMaskObject )
       {
@@ -551,6 +563,9 @@ ImageToImageRegistrationHelper<TImage>
     regAff->SetSampleFromOverlap( m_SampleFromOverlap );
     regAff->SetMinimizeMemory( m_MinimizeMemory );
     regAff->SetMaxIterations( m_AffineMaxIterations );
+    regAff->SetNumberOfLevels( m_AffineNumberOfLevels );
+    regAff->SetLevelSamplingRatios( m_AffineLevelSamplingRatios );
+    regAff->SetLevelMaxIterations( m_AffineLevelMaxIterations );
     regAff->SetTargetError( m_AffineTargetError );
     if( m_EnableRigidRegistration )
       {
@@ -676,6 +691,9 @@ ImageToImageRegistrationHelper<TImage>
     regBspline->SetSampleFromOverlap( m_SampleFromOverlap );
     regBspline->SetMinimizeMemory( m_MinimizeMemory );
     regBspline->SetMaxIterations( m_BSplineMaxIterations );
+    regBspline->SetNumberOfLevels( m_BSplineNumberOfLevels );
+    regBspline->SetLevelSamplingRatios( m_BSplineLevelSamplingRatios );
+    regBspline->SetLevelMaxIterations( m_BSplineLevelMaxIterations );
     regBspline->SetTargetError( m_BSplineTargetError );
     if( m_UseFixedImageMaskObject )
       {
@@ -1240,6 +1258,78 @@ ImageToImageRegistrationHelper<TImage>
     }
 }
 
+template <class TImage>
+void
+ImageToImageRegistrationHelper<TImage>
+::SetRigidLevelSamplingRatios( const std::vector<double> & ratios )
+{
+  if( m_RigidLevelSamplingRatios != ratios )
+    {
+    m_RigidLevelSamplingRatios = ratios;
+    this->Modified();
+    }
+}
+
+template <class TImage>
+void
+ImageToImageRegistrationHelper<TImage>
+::SetRigidLevelMaxIterations( const std::vector<unsigned int> & iterations )
+{
+  if( m_RigidLevelMaxIterations != iterations )
+    {
+    m_RigidLevelMaxIterations = iterations;
+    this->Modified();
+    }
+}
+
+template <class TImage>
+void
+ImageToImageRegistrationHelper<TImage>
+::SetAffineLevelSamplingRatios( const std::vector<double> & ratios )
+{
+  if( m_AffineLevelSamplingRatios != ratios )
+    {
+    m_AffineLevelSamplingRatios = ratios;
+    this->Modified();
+    }
+}
+
+template <class TImage>
+void
+ImageToImageRegistrationHelper<TImage>
+::SetAffineLevelMaxIterations( const std::vector<unsigned int> & iterations )
+{
+  if( m_AffineLevelMaxIterations != iterations )
+    {
+    m_AffineLevelMaxIterations = iterations;
+    this->Modified();
+    }
+}
+
+template <class TImage>
+void
+ImageToImageRegistrationHelper<TImage>
+::SetBSplineLevelSamplingRatios( const std::vector<double> & ratios )
+{
+  if( m_BSplineLevelSamplingRatios != ratios )
+    {
+    m_BSplineLevelSamplingRatios = ratios;
+    this->Modified();
+    }
+}
+
+template <class TImage>
+void
+ImageToImageRegistrationHelper<TImage>
+::SetBSplineLevelMaxIterations( const std::vector<unsigned int> & iterations )
+{
+  if( m_BSplineLevelMaxIterations != iterations )
+    {
+    m_BSplineLevelMaxIterations = iterations;
+    this->Modified();
+    }
+}
+
 template <class TImage>
 void
 ImageToImageRegistrationHelper<TImage>
@@ -1445,6 +1535,7 @@ ImageToImageRegistrationHelper<TImage>
   os << indent << "Rigid Sampling Ratio = " << m_RigidSamplingRatio << std::endl;
   os << indent << "Rigid Target Error = " << m_RigidTargetError << std::endl;
   os << indent << "Rigid Max Iterations = " << m_RigidMaxIterations << std::endl;
+  os << indent << "Rigid Number Of Levels = " << m_RigidNumberOfLevels << std::endl;
   PrintSelfHelper( os, indent, "Rigid", m_RigidMetricMethodEnum,
                    m_RigidInterpolationMethodEnum );
   os << indent << std::endl;
@@ -1460,6 +1551,7 @@ ImageToImageRegistrationHelper<TImage>
   os << indent << "Affine Sampling Ratio = " << m_AffineSamplingRatio << std::endl;
   os << indent << "Affine Target Error = " << m_AffineTargetError << std::endl;
   os << indent << "Affine Max Iterations = " << m_AffineMaxIterations << std::endl;
+  os << indent << "Affine Number Of Levels = " << m_AffineNumberOfLevels << std::endl;
   PrintSelfHelper( os, indent, "Affine", m_AffineMetricMethodEnum,
                    m_AffineInterpolationMethodEnum );
   os << indent << std::endl;
@@ -1475,6 +1567,7 @@ ImageToImageRegistrationHelper<TImage>
   os << indent << "BSpline Sampling Ratio = " << m_BSplineSamplingRatio << std::endl;
   os << indent << "BSpline Target Error = " << m_BSplineTargetError << std::endl;
   os << indent << "BSpline Max Iterations = " << m_BSplineMaxIterations << std::endl;
+  os << indent << "BSpline Number Of Levels = " << m_BSplineNumberOfLevels << std::endl;
   os << indent << "BSpline Control Point Pixel Spacing = " << m_BSplineControlPointPixelSpacing << std::endl;
   PrintSelfHelper( os, indent, "BSpline", m_BSplineMetricMethodEnum,
                    m_BSplineInterpolationMethodEnum );
@@ -22,6 +22,8 @@
 
 #include "itkImageToImageRegistrationMethod.h"
 
+#include <vector>
+
 namespace itk
 {
 
@@ -130,6 +132,50 @@ public:
   itkGetConstMacro( InterpolationMethodEnum, InterpolationMethodEnumType );
 
   itkGetMacro( FinalMetricValue, double );
+
+  /** Number of levels of the image pyramid. Level 0 is the coarsest
+   *  level, level NumberOfLevels-1 is the full resolution image. Each
+   *  level halves the resolution of the next one. The metric samples
+   *  are selected on each level with the transform of the previous one.
+   *  The BSpline registration uses its own pyramid, where each level
+   *  also halves the number of control points of the next one. The
+   *  value is clamped to 1 to 5 for all transforms. */
+  itkSetClampMacro( NumberOfLevels, unsigned int, 1, 5 );
+  itkGetConstMacro( NumberOfLevels, unsigned int );
+
+  /** Portion of the pixels of each level used as metric samples, from
+   *  the coarsest level to the full resolution. Levels without a value
+   *  use NumberOfSamples (at most all the pixels of the level). */
+  void SetLevelSamplingRatios( const std::vector<double> & ratios );
+  const std::vector<double> & GetLevelSamplingRatios( void ) const
+  {
+    return m_LevelSamplingRatios;
+  }
+
+  /** Maximum number of iterations at each level, from the coarsest level
+   *  to the full resolution. Levels without a value use MaxIterations. */
+  void SetLevelMaxIterations( const std::vector<unsigned int> & iterations );
+  const std::vector<unsigned int> & GetLevelMaxIterations( void ) const
+  {
+    return m_LevelMaxIterations;
+  }
+
+  /** Time spent and final metric value at each optimized level */
+  struct LevelReportType
+    {
+    unsigned int Level;
+    unsigned long NumberOfPixels;
+    unsigned int NumberOfSamples;
+    unsigned int MaxIterations;
+    double Time;
+    double MetricValue;
+    };
+  typedef std::vector<LevelReportType> LevelReportContainerType;
+
+  const LevelReportContainerType & GetLevelReports( void ) const
+  {
+    return m_LevelReports;
+  }
 protected:
 
   OptimizedImageToImageRegistrationMethod( void );
@@ -144,6 +190,35 @@ protected:
 
   virtual void Optimize( MetricType * metric, InterpolatorType * interpolator );
 
+  /** Create the metric on the given images, including the selection of
+   *  the fixed image samples. numberOfSamples is reduced if not enough
+   *  samples pass the threshold/overlap/mask criteria. */
+  typename MetricType::Pointer CreateMetric( const ImageType * fixedImage,
+                                             const ImageType * movingImage,
+                                             unsigned int & numberOfSamples );
+
+  typename InterpolatorType::Pointer CreateInterpolator( const ImageType * movingImage );
+
+  /** Evolutionary (optional) and gradient optimization on the given
+   *  images, starting from initialParameters */
+  void OptimizeLevel( MetricType * metric, InterpolatorType * interpolator,
+                      const ImageType * fixedImage, const ImageType * movingImage,
+                      const TransformParametersType & initialParameters,
+                      unsigned int maxIterations, bool useEvolutionaryOptimization );
+
+  /** Optimize on the coarse levels of the image pyramid. parameters are
+   *  the initial parameters on input and the coarse result on output. */
+  void PyramidOptimize( TransformParametersType & parameters );
+
+  unsigned int ComputeLevelNumberOfSamples( unsigned int level, const ImageType * levelFixedImage,
+                                            unsigned int defaultNumberOfSamples ) const;
+
+  unsigned int ComputeLevelMaxIterations( unsigned int level, unsigned int defaultMaxIterations ) const;
+
+  void AddLevelReport( unsigned int level, const ImageType * levelFixedImage,
+                       unsigned int numberOfSamples, unsigned int maxIterations,
+                       double time, double metricValue );
+
   virtual void PrintSelf( std::ostream & os, Indent indent ) const ITK_OVERRIDE;
 
 private:
@@ -182,6 +257,11 @@ private:
   InterpolationMethodEnumType m_InterpolationMethodEnum;
 
   double m_FinalMetricValue;
+
+  unsigned int              m_NumberOfLevels;
+  std::vector<double>       m_LevelSamplingRatios;
+  std::vector<unsigned int> m_LevelMaxIterations;
+  LevelReportContainerType  m_LevelReports;
 };
 
 }
@@ -31,6 +31,7 @@
 
 #include "itkImageRegistrationMethod.h"
 #include "itkMultiResolutionImageRegistrationMethod.h"
+#include "itkRecursiveMultiResolutionPyramidImageFilter.h"
 
 #include "itkRealTimeClock.h"
 
@@ -46,6 +47,7 @@
 #include <itkConstantBoundaryCondition.h>
 
 
+#include <algorithm>
 #include <sstream>
 
 namespace itk
@@ -175,6 +177,10 @@ OptimizedImageToImageRegistrationMethod<TImage>
 
   m_FinalMetricValue = 0;
 
+  m_NumberOfLevels = 1;
+  m_LevelSamplingRatios.clear();
+  m_LevelMaxIterations.clear();
+
 }
 
 template <class TImage>
@@ -192,6 +198,92 @@ OptimizedImageToImageRegistrationMethod<TImage>
   m_UseFixedImageSamplesIntensityThreshold = true;
 }
 
+template <class TImage>
+void
+OptimizedImageToImageRegistrationMethod<TImage>
+::SetLevelSamplingRatios( const std::vector<double> & ratios )
+{
+  if( m_LevelSamplingRatios != ratios )
+    {
+    m_LevelSamplingRatios = ratios;
+    this->Modified();
+    }
+}
+
+template <class TImage>
+void
+OptimizedImageToImageRegistrationMethod<TImage>
+::SetLevelMaxIterations( const std::vector<unsigned int> & iterations )
+{
+  if( m_LevelMaxIterations != iterations )
+    {
+    m_LevelMaxIterations = iterations;
+    this->Modified();
+    }
+}
+
+template <class TImage>
+unsigned int
+OptimizedImageToImageRegistrationMethod<TImage>
+::ComputeLevelNumberOfSamples( unsigned int level, const ImageType * levelFixedImage,
+                               unsigned int defaultNumberOfSamples ) const
+{
+  unsigned long numberOfPixels = levelFixedImage->GetLargestPossibleRegion().GetNumberOfPixels();
+  unsigned long numberOfSamples = defaultNumberOfSamples;
+  if( level < m_LevelSamplingRatios.size() && m_LevelSamplingRatios[level] > 0 )
+    {
+    numberOfSamples = (unsigned long)(m_LevelSamplingRatios[level] * numberOfPixels);
+    }
+  if( numberOfSamples > numberOfPixels )
+    {
+    numberOfSamples = numberOfPixels;
+    }
+  if( numberOfSamples < 1 )
+    {
+    numberOfSamples = 1;
+    }
+  return (unsigned int)numberOfSamples;
+}
+
+template <class TImage>
+unsigned int
+OptimizedImageToImageRegistrationMethod<TImage>
+::ComputeLevelMaxIterations( unsigned int level, unsigned int defaultMaxIterations ) const
+{
+  if( level < m_LevelMaxIterations.size() && m_LevelMaxIterations[level] > 0 )
+    {
+    return m_LevelMaxIterations[level];
+    }
+  return defaultMaxIterations;
+}
+
+template <class TImage>
+void
+OptimizedImageToImageRegistrationMethod<TImage>
+::AddLevelReport( unsigned int level, const ImageType * levelFixedImage,
+                  unsigned int numberOfSamples, unsigned int maxIterations,
+                  double time, double metricValue )
+{
+  LevelReportType report;
+  report.Level = level;
+  report.NumberOfPixels = levelFixedImage->GetLargestPossibleRegion().GetNumberOfPixels();
+  report.NumberOfSamples = numberOfSamples;
+  report.MaxIterations = maxIterations;
+  report.Time = time;
+  report.MetricValue = metricValue;
+  m_LevelReports.push_back( report );
+
+  if( this->GetReportProgress() )
+    {
+    std::cout << "LEVEL " << level << " : "
+              << levelFixedImage->GetLargestPossibleRegion().GetSize()
+              << "  samples = " << numberOfSamples
+              << "  max iterations = " << maxIterations
+              << "  metric = " << metricValue
+              << "   (" << time << "s)" << std::endl;
+    }
+}
+
 template <class TImage>
 void
 OptimizedImageToImageRegistrationMethod<TImage>
@@ -206,6 +298,41 @@ OptimizedImageToImageRegistrationMethod<TImage>
 
   this->GetTransform()->SetParametersByValue( this->GetInitialTransformParameters() );
 
+  m_LevelReports.clear();
+
+  typename ImageType::ConstPointer fixedImage = this->GetFixedImage();
+  typename ImageType::ConstPointer movingImage = this->GetMovingImage();
+
+  // The last level of the pyramid is the full resolution image.
+  // NumberOfSamples is kept as requested until all the levels are
+  // done, because the levels compute their number of samples from it.
+  unsigned int numberOfSamples = this->ComputeLevelNumberOfSamples( m_NumberOfLevels - 1, fixedImage,
+                                                                    m_NumberOfSamples );
+  typename MetricType::Pointer metric = this->CreateMetric( fixedImage, movingImage, numberOfSamples );
+
+  typename InterpolatorType::Pointer interpolator = this->CreateInterpolator( movingImage );
+
+  try
+    {
+    this->Optimize(metric, interpolator);
+    }
+  catch( ... )
+    {
+    std::cerr << "Optimization threw an exception." << std::endl;
+    }
+
+  if( this->GetReportProgress() )
+    {
+    std::cout << "UPDATE END" << std::endl;
+    }
+}
+
+template <class TImage>
+typename OptimizedImageToImageRegistrationMethod<TImage>::MetricType::Pointer
+OptimizedImageToImageRegistrationMethod<TImage>
+::CreateMetric( const ImageType * fixedImage, const ImageType * movingImage,
+                unsigned int & numberOfSamples )
+{
   typename MetricType::Pointer metric;
 
   switch( this->GetMetricMethodEnum() )
@@ -243,13 +370,15 @@ OptimizedImageToImageRegistrationMethod<TImage>
     metric->ReinitializeSeed();
     }
 
-  typename ImageType::ConstPointer fixedImage = this->GetFixedImage();
-  typename ImageType::ConstPointer movingImage = this->GetMovingImage();
+  // The metric splits the samples between the threads: each thread
+  // accumulates its own joint histogram (Mattes) or sums, which are
+  // merged once per evaluation of the value and derivative.
+  metric->SetNumberOfThreads( this->GetRegistrationNumberOfThreads() );
 
   metric->SetFixedImage( fixedImage );
   metric->SetMovingImage( movingImage );
 
-  metric->SetNumberOfSpatialSamples( m_NumberOfSamples );
+  metric->SetNumberOfSpatialSamples( numberOfSamples );
 
   if( this->GetUseRegionOfInterest() ||
       this->GetSampleFromOverlap() ||
@@ -322,7 +451,7 @@ OptimizedImageToImageRegistrationMethod<TImage>
 
       ++count;
       }
-    double samplingRate = (double)(m_NumberOfSamples + 2) / (double)count;
+    double samplingRate = (double)(numberOfSamples + 2) / (double)count;
     if( this->GetReportProgress() )
       {
       std::cout << "...Second pass, sampling rate = " << samplingRate << std::endl;
@@ -332,8 +461,8 @@ OptimizedImageToImageRegistrationMethod<TImage>
       {
       samplingRate = 1;
       itkWarningMacro(<< "Adjusting the number of samples due to restrictive threshold/overlap criteria.");
-      this->SetNumberOfSamples( count );
-      metric->SetNumberOfSpatialSamples( m_NumberOfSamples );
+      numberOfSamples = count;
+      metric->SetNumberOfSpatialSamples( numberOfSamples );
       }
     double step = 0;
     typename MetricType::FixedImageIndexContainer indexList;
@@ -377,18 +506,18 @@ OptimizedImageToImageRegistrationMethod<TImage>
           step -= 1;
           }
 
-        if( indexList.size() == m_NumberOfSamples )
+        if( indexList.size() == numberOfSamples )
           {
           break;
           }
         }
       }
-    if( indexList.size() != m_NumberOfSamples )
+    if( indexList.size() != numberOfSamples )
       {
       itkWarningMacro(<< "Full set of samples not collected. Collected "
-                      << indexList.size() << " of " << m_NumberOfSamples );
-      this->SetNumberOfSamples( indexList.size() );
-      metric->SetNumberOfSpatialSamples( m_NumberOfSamples );
+                      << indexList.size() << " of " << numberOfSamples );
+      numberOfSamples = indexList.size();
+      metric->SetNumberOfSpatialSamples( numberOfSamples );
       }
     std::cout << "Passing index list to metric..." << std::endl;
     std::cout << "  List size = " << indexList.size() << std::endl;
@@ -403,6 +532,14 @@ OptimizedImageToImageRegistrationMethod<TImage>
       }
     }
 
+  return metric;
+}
+
+template <class TImage>
+typename OptimizedImageToImageRegistrationMethod<TImage>::InterpolatorType::Pointer
+OptimizedImageToImageRegistrationMethod<TImage>
+::CreateInterpolator( const ImageType * movingImage )
+{
   typename InterpolatorType::Pointer interpolator;
 
   switch( this->GetInterpolationMethodEnum() )
@@ -424,31 +561,163 @@ OptimizedImageToImageRegistrationMethod<TImage>
                                                           double>::New();
       break;
     }
-  interpolator->SetInputImage( this->GetMovingImage() );
+  interpolator->SetInputImage( movingImage );
 
-  try
+  return interpolator;
+}
+
+template <class TImage>
+void
+OptimizedImageToImageRegistrationMethod<TImage>
+::Optimize( MetricType * metric, InterpolatorType * interpolator )
+{
+  TransformParametersType initialParameters = this->GetInitialTransformParameters();
+  bool                    useEvolutionaryOptimization = m_UseEvolutionaryOptimization;
+
+  unsigned int level = m_NumberOfLevels - 1;
+
+  typename MetricType::Pointer levelMetric = metric;
+  unsigned int                 numberOfSamples = metric->GetNumberOfSpatialSamples();
+  if( m_NumberOfLevels > 1 )
     {
-    this->Optimize(metric, interpolator);
+    // The global (evolutionary) search is done at the coarsest level
+    this->PyramidOptimize( initialParameters );
+    useEvolutionaryOptimization = false;
+
+    // The metric of GenerateData() selected its samples with the initial
+    // transform, select the full resolution samples (overlap criterion)
+    // with the transform found on the coarser levels instead
+    this->GetTransform()->SetParametersByValue( initialParameters );
+    numberOfSamples = this->ComputeLevelNumberOfSamples( level, this->GetFixedImage(), m_NumberOfSamples );
+    levelMetric = this->CreateMetric( this->GetFixedImage(), this->GetMovingImage(), numberOfSamples );
     }
-  catch( ... )
+
+  unsigned int maxIterations = this->ComputeLevelMaxIterations( level, this->GetMaxIterations() );
+
+  RealTimeClock::Pointer       timer = RealTimeClock::New();
+  RealTimeClock::TimeStampType startTime = timer->GetTimeInSeconds();
+
+  this->OptimizeLevel( levelMetric, interpolator, this->GetFixedImage(), this->GetMovingImage(),
+                       initialParameters, maxIterations, useEvolutionaryOptimization );
+
+  this->AddLevelReport( level, this->GetFixedImage(), numberOfSamples, maxIterations,
+                        timer->GetTimeInSeconds() - startTime, m_FinalMetricValue );
+
+  // Number of samples used at full resolution
+  this->SetNumberOfSamples( numberOfSamples );
+}
+
+template <class TImage>
+void
+OptimizedImageToImageRegistrationMethod<TImage>
+::PyramidOptimize( TransformParametersType & parameters )
+{
+  if( this->GetReportProgress() )
     {
-    std::cerr << "Optimization threw an exception." << std::endl;
+    std::cout << "PYRAMID START" << std::endl;
+    }
+
+  typedef RecursiveMultiResolutionPyramidImageFilter<ImageType, ImageType> PyramidType;
+  typename PyramidType::Pointer fixedPyramid = PyramidType::New();
+  typename PyramidType::Pointer movingPyramid = PyramidType::New();
+
+  fixedPyramid->SetNumberOfLevels( m_NumberOfLevels );
+  movingPyramid->SetNumberOfLevels( m_NumberOfLevels );
+
+  typename ImageType::SpacingType fixedSpacing = this->GetFixedImage()->GetSpacing();
+  typename ImageType::SpacingType movingSpacing = this->GetMovingImage()->GetSpacing();
+  double fixedMinSpacing = fixedSpacing[0];
+  double movingMinSpacing = movingSpacing[0];
+  for( unsigned int i = 1; i < ImageDimension; i++ )
+    {
+    fixedMinSpacing = std::min( fixedMinSpacing, (double)fixedSpacing[i] );
+    movingMinSpacing = std::min( movingMinSpacing, (double)movingSpacing[i] );
+    }
+
+  // Shrink the finest axis by 2 per level, the other axes so that the
+  // voxels of each level are as isotropic as possible
+  typename PyramidType::ScheduleType fixedSchedule = fixedPyramid->GetSchedule();
+  typename PyramidType::ScheduleType movingSchedule = movingPyramid->GetSchedule();
+  for( unsigned int level = 0; level < m_NumberOfLevels; level++ )
+    {
+    double levelScale = (double)( 1 << (m_NumberOfLevels - 1 - level) );
+    for( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      fixedSchedule[level][i] = (unsigned int)(levelScale * fixedMinSpacing / fixedSpacing[i]);
+      if( fixedSchedule[level][i] < 1 )
+        {
+        fixedSchedule[level][i] = 1;
+        }
+      movingSchedule[level][i] = (unsigned int)(levelScale * movingMinSpacing / movingSpacing[i]);
+      if( movingSchedule[level][i] < 1 )
+        {
+        movingSchedule[level][i] = 1;
+        }
+      }
+    }
+
+  fixedPyramid->SetSchedule( fixedSchedule );
+  fixedPyramid->SetInput( this->GetFixedImage() );
+  fixedPyramid->Update();
+
+  movingPyramid->SetSchedule( movingSchedule );
+  movingPyramid->SetInput( this->GetMovingImage() );
+  movingPyramid->Update();
+
+  RealTimeClock::Pointer timer = RealTimeClock::New();
+
+  // The last level is the full resolution image, optimized by the caller
+  for( unsigned int level = 0; level < m_NumberOfLevels - 1; level++ )
+    {
+    RealTimeClock::TimeStampType startTime = timer->GetTimeInSeconds();
+
+    typename ImageType::ConstPointer fixedImage = fixedPyramid->GetOutput(level);
+    typename ImageType::ConstPointer movingImage = movingPyramid->GetOutput(level);
+
+    if( this->GetReportProgress() )
+      {
+      std::cout << "PYRAMID LEVEL = " << level << std::endl;
+      std::cout << "   Fixed image = "
+                << fixedImage->GetLargestPossibleRegion().GetSize() << std::endl;
+      std::cout << "   Moving image = "
+                << movingImage->GetLargestPossibleRegion().GetSize() << std::endl;
+      }
+
+    // Samples are selected with the current transform (overlap criterion)
+    this->GetTransform()->SetParametersByValue( parameters );
+
+    unsigned int numberOfSamples = this->ComputeLevelNumberOfSamples( level, fixedImage, m_NumberOfSamples );
+    unsigned int maxIterations = this->ComputeLevelMaxIterations( level, this->GetMaxIterations() );
+
+    typename MetricType::Pointer metric = this->CreateMetric( fixedImage, movingImage, numberOfSamples );
+    typename InterpolatorType::Pointer interpolator = this->CreateInterpolator( movingImage );
+
+    this->OptimizeLevel( metric, interpolator, fixedImage, movingImage, parameters,
+                         maxIterations, level == 0 && m_UseEvolutionaryOptimization );
+
+    parameters = this->GetLastTransformParameters();
+
+    this->AddLevelReport( level, fixedImage, numberOfSamples, maxIterations,
+                          timer->GetTimeInSeconds() - startTime, m_FinalMetricValue );
     }
 
   if( this->GetReportProgress() )
     {
-    std::cout << "UPDATE END" << std::endl;
+    std::cout << "PYRAMID END" << std::endl;
     }
 }
 
 template <class TImage>
 void
 OptimizedImageToImageRegistrationMethod<TImage>
-::Optimize( MetricType * metric, InterpolatorType * interpolator )
+::OptimizeLevel( MetricType * metric, InterpolatorType * interpolator,
+                 const ImageType * fixedImage, const ImageType * movingImage,
+                 const TransformParametersType & initialParameters,
+                 unsigned int maxIterations, bool useEvolutionaryOptimization )
 {
   typedef ImageRegistrationMethod<TImage, TImage> RegType;
 
-  if( m_UseEvolutionaryOptimization )
+  if( useEvolutionaryOptimization )
     {
     if( this->GetReportProgress() )
       {
@@ -471,7 +740,7 @@ OptimizedImageToImageRegistrationMethod<TImage>
       scales[i] = scales[i] * scales[i]; // OnePlusOne opt uses squared scales
       }
     evoOpt->SetScales( scales ); // this->GetTransformParametersScales() );
-    evoOpt->SetMaximumIteration( this->GetMaxIterations() );
+    evoOpt->SetMaximumIteration( maxIterations );
 
     if( this->GetObserver() )
       {
@@ -490,15 +759,11 @@ OptimizedImageToImageRegistrationMethod<TImage>
       }
 
     typename RegType::Pointer reg = RegType::New();
-    typename ImageType::ConstPointer fixedImage = this->GetFixedImage();
-    typename ImageType::ConstPointer movingImage = this->GetMovingImage();
     reg->SetFixedImage( fixedImage );
     reg->SetMovingImage( movingImage );
-    reg->SetFixedImageRegion( this->GetFixedImage()
-                              ->GetLargestPossibleRegion() );
+    reg->SetFixedImageRegion( fixedImage->GetLargestPossibleRegion() );
     reg->SetTransform( this->GetTransform() );
-    reg->SetInitialTransformParameters(
-      this->GetInitialTransformParameters() );
+    reg->SetInitialTransformParameters( initialParameters );
     reg->SetMetric( metric );
     reg->SetInterpolator( interpolator );
     reg->SetOptimizer( evoOpt );
@@ -538,8 +803,7 @@ OptimizedImageToImageRegistrationMethod<TImage>
     }
   else
     {
-    this->GetTransform()->SetParametersByValue(
-      this->GetInitialTransformParameters() );
+    this->GetTransform()->SetParametersByValue( initialParameters );
     }
 
   if( this->GetReportProgress() )
@@ -555,7 +819,7 @@ OptimizedImageToImageRegistrationMethod<TImage>
   gradOpt->SetMetricWorstPossibleValue( 0 );
   gradOpt->SetStepLength( 0.25 );
   gradOpt->SetStepTolerance( this->GetTargetError() );
-  gradOpt->SetMaximumIteration( this->GetMaxIterations() );
+  gradOpt->SetMaximumIteration( maxIterations );
   gradOpt->SetMaximumLineIteration( 10 );
   gradOpt->SetScales( this->GetTransformParametersScales() );
   gradOpt->SetUseUnitLengthGradient(true);
@@ -577,12 +841,9 @@ OptimizedImageToImageRegistrationMethod<TImage>
     }
 
   typename RegType::Pointer reg = RegType::New();
-  typename ImageType::ConstPointer fixedImage = this->GetFixedImage();
-  typename ImageType::ConstPointer movingImage = this->GetMovingImage();
   reg->SetFixedImage( fixedImage );
   reg->SetMovingImage( movingImage );
-  reg->SetFixedImageRegion( this->GetFixedImage()
-                            ->GetLargestPossibleRegion() );
+  reg->SetFixedImageRegion( fixedImage->GetLargestPossibleRegion() );
   reg->SetTransform( this->GetTransform() );
   reg->SetInitialTransformParameters( this->GetTransform()->GetParameters() );
   reg->SetMetric( metric );
@@ -628,8 +889,7 @@ OptimizedImageToImageRegistrationMethod<TImage>
     m_FinalMetricValue = reg->GetOptimizer()->GetValue(
         reg->GetInitialTransformParameters() );
     this->SetLastTransformParameters( reg->GetInitialTransformParameters() );
-    this->GetTransform()->SetParametersByValue(
-      this->GetInitialTransformParameters() );
+    this->GetTransform()->SetParametersByValue( initialParameters );
     }
   else
     {
@@ -675,6 +935,22 @@ OptimizedImageToImageRegistrationMethod<TImage>
 
   os << indent << "Target Error = " << m_TargetError << std::endl;
 
+  os << indent << "Number of Levels = " << m_NumberOfLevels << std::endl;
+
+  os << indent << "Level Sampling Ratios =";
+  for( unsigned int i = 0; i < m_LevelSamplingRatios.size(); i++ )
+    {
+    os << " " << m_LevelSamplingRatios[i];
+    }
+  os << std::endl;
+
+  os << indent << "Level Max Iterations =";
+  for( unsigned int i = 0; i < m_LevelMaxIterations.size(); i++ )
+    {
+    os << " " << m_LevelMaxIterations[i];
+    }
+  os << std::endl;
+
   switch( m_MetricMethodEnum )
     {
     case MATTES_MI_METRIC:
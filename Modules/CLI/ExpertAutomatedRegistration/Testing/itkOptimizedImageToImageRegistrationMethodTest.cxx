@@ -0,0 +1,190 @@
+#include "itkRigidImageToImageRegistrationMethod.h"
+
+// ITK includes
+#include <itkImage.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+// STD includes
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+typedef itk::Image<float, 3>                                ImageType;
+typedef itk::RigidImageToImageRegistrationMethod<ImageType> RegistrationMethodType;
+
+// Anisotropic image: the first axis has twice the spacing of the other axes
+ImageType::Pointer CreateBlobImage(double centerX, double centerY, double centerZ, double originY = 0.0)
+{
+  ImageType::SizeType size;
+  size[0] = 16;
+  size[1] = 32;
+  size[2] = 32;
+  ImageType::SpacingType spacing;
+  spacing[0] = 2.0;
+  spacing[1] = 1.0;
+  spacing[2] = 1.0;
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->SetSpacing( spacing );
+  ImageType::PointType origin;
+  origin[0] = 0.0;
+  origin[1] = originY;
+  origin[2] = 0.0;
+  image->SetOrigin( origin );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    ImageType::PointType point;
+    image->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    double dx = point[0] - centerX;
+    double dy = point[1] - centerY;
+    double dz = point[2] - centerZ;
+    it.Set( 100.0 * std::exp( -(dx * dx + dy * dy + dz * dz) / (2.0 * 6.0 * 6.0) ) );
+    }
+  return image;
+}
+
+int CheckLevelReport( const RegistrationMethodType::LevelReportType & report, unsigned int level,
+                      unsigned long numberOfPixels, unsigned int numberOfSamples, unsigned int maxIterations )
+{
+  if( report.Level != level
+      || report.NumberOfPixels != numberOfPixels
+      || report.NumberOfSamples != numberOfSamples
+      || report.MaxIterations != maxIterations )
+    {
+    std::cerr << "Level " << level << ": unexpected report"
+              << " level = " << report.Level
+              << " pixels = " << report.NumberOfPixels << " (expected " << numberOfPixels << ")"
+              << " samples = " << report.NumberOfSamples << " (expected " << numberOfSamples << ")"
+              << " max iterations = " << report.MaxIterations << " (expected " << maxIterations << ")"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+// The moving image is shifted by 4mm along the second axis, so with the
+// initial (identity) transform only 28 of the 32 rows of the fixed image
+// overlap with it. The full resolution samples must be selected with the
+// transform found on the coarse levels, which overlaps more.
+int TestSampleFromOverlapPerLevel()
+{
+  ImageType::Pointer fixedImage = CreateBlobImage( 16.0, 16.0, 16.0 );
+  ImageType::Pointer movingImage = CreateBlobImage( 16.0, 20.0, 16.0, 4.0 );
+
+  RegistrationMethodType::Pointer registrationMethod = RegistrationMethodType::New();
+  registrationMethod->SetFixedImage( fixedImage );
+  registrationMethod->SetMovingImage( movingImage );
+  registrationMethod->SetMetricMethodEnum( RegistrationMethodType::MEAN_SQUARED_ERROR_METRIC );
+  registrationMethod->SetUseEvolutionaryOptimization( false );
+  registrationMethod->SetRandomNumberSeed( 1 );
+  registrationMethod->SetSampleFromOverlap( true );
+  const unsigned int numberOfPixels = 16 * 32 * 32;
+  registrationMethod->SetNumberOfSamples( numberOfPixels );
+  registrationMethod->SetMaxIterations( 10 );
+  registrationMethod->SetNumberOfLevels( 3 );
+
+  try
+    {
+    registrationMethod->Update();
+    }
+  catch( itk::ExceptionObject & e )
+    {
+    std::cerr << "Registration failed: " << e << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const RegistrationMethodType::LevelReportContainerType & reports = registrationMethod->GetLevelReports();
+  if( reports.size() != 3 )
+    {
+    std::cerr << "Expected 3 level reports, got " << reports.size() << std::endl;
+    return EXIT_FAILURE;
+    }
+  const unsigned int numberOfSamplesWithInitialTransform = 16 * 28 * 32;
+  if( reports[2].NumberOfSamples <= numberOfSamplesWithInitialTransform
+      || reports[2].NumberOfSamples > numberOfPixels )
+    {
+    std::cerr << "Full resolution samples were not selected with the transform of the coarse levels: "
+              << reports[2].NumberOfSamples << " samples, " << numberOfSamplesWithInitialTransform
+              << " overlap with the initial transform" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if( registrationMethod->GetNumberOfSamples() != reports[2].NumberOfSamples )
+    {
+    std::cerr << "NumberOfSamples " << registrationMethod->GetNumberOfSamples()
+              << " is not the number of full resolution samples " << reports[2].NumberOfSamples << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
+
+int main(int, char *[])
+{
+  ImageType::Pointer fixedImage = CreateBlobImage( 16.0, 16.0, 16.0 );
+  ImageType::Pointer movingImage = CreateBlobImage( 18.0, 15.0, 17.0 );
+
+  RegistrationMethodType::Pointer registrationMethod = RegistrationMethodType::New();
+  registrationMethod->SetFixedImage( fixedImage );
+  registrationMethod->SetMovingImage( movingImage );
+  registrationMethod->SetMetricMethodEnum( RegistrationMethodType::MEAN_SQUARED_ERROR_METRIC );
+  registrationMethod->SetUseEvolutionaryOptimization( false );
+  registrationMethod->SetRandomNumberSeed( 1 );
+  registrationMethod->SetNumberOfSamples( 2000 );
+  registrationMethod->SetMaxIterations( 10 );
+  registrationMethod->SetNumberOfLevels( 3 );
+
+  // Level 0 has no sampling ratio: NumberOfSamples is limited to the pixels of the level.
+  // Level 2 (full resolution) has no value at all: NumberOfSamples and MaxIterations are used.
+  std::vector<double> samplingRatios;
+  samplingRatios.push_back( 0.0 );
+  samplingRatios.push_back( 0.25 );
+  registrationMethod->SetLevelSamplingRatios( samplingRatios );
+  std::vector<unsigned int> maxIterations;
+  maxIterations.push_back( 5 );
+  registrationMethod->SetLevelMaxIterations( maxIterations );
+
+  try
+    {
+    registrationMethod->Update();
+    }
+  catch( itk::ExceptionObject & e )
+    {
+    std::cerr << "Registration failed: " << e << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const RegistrationMethodType::LevelReportContainerType & reports = registrationMethod->GetLevelReports();
+  if( reports.size() != 3 )
+    {
+    std::cerr << "Expected 3 level reports, got " << reports.size() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The finest axis (spacing 1) is shrunk by 2 per level, the first axis (spacing 2)
+  // half as much, so the coarsest level is 8x8x8 with isotropic 4mm voxels.
+  if( CheckLevelReport( reports[0], 0, 8 * 8 * 8, 8 * 8 * 8, 5 ) != EXIT_SUCCESS
+      || CheckLevelReport( reports[1], 1, 16 * 16 * 16, 16 * 16 * 16 / 4, 10 ) != EXIT_SUCCESS
+      || CheckLevelReport( reports[2], 2, 16 * 32 * 32, 2000, 10 ) != EXIT_SUCCESS )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Coarse levels must bring the transform close to the expected translation
+  RegistrationMethodType::TransformType::OutputVectorType translation =
+    registrationMethod->GetTypedTransform()->GetTranslation();
+  const double expectedTranslation[3] = { 2.0, -1.0, 1.0 };
+  for( unsigned int i = 0; i < 3; i++ )
+    {
+    if( std::fabs( translation[i] - expectedTranslation[i] ) > 1.0 )
+      {
+      std::cerr << "Unexpected translation " << translation << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return TestSampleFromOverlapPerLevel();
+}
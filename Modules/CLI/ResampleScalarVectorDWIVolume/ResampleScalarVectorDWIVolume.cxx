@@ -17,17 +17,14 @@
 #include <itkImageFileReader.h>
 #include <itkImageFileWriter.h>
 #include <itkMetaDataObject.h>
-#include <itkNearestNeighborInterpolateImageFunction.h>
 #include <itkResampleImageFilter.h>
-#include <itkBSplineInterpolateImageFunction.h>
 #include <itkRigid3DTransform.h>
 #include <itkTransformFileReader.h>
 #include <itkVectorResampleImageFilter.h>
-#include <itkWindowedSincInterpolateImageFunction.h>
-#include <itkConstantBoundaryCondition.h>
 
 // ResampleScalarVectorDWIVolume includes
 #include "ResampleScalarVectorDWIVolumeCLP.h"
+#include "itkVectorImageResampleFilter.h"
 
 // ResampleDTIVolume includes
 #include "dtiprocessFiles/deformationfieldio.h"
@@ -655,91 +652,6 @@ SetAllTransform( parameters & list,
   return transform;
 }
 
-// Write back the vector of images into a image vector
-template <class PixelType>
-int AddImage( typename itk::VectorImage<PixelType, 3>
-              ::Pointer & imagePile,
-              const std::vector<typename itk::Image<PixelType, 3>::Pointer> & vectorImage
-              )
-{
-  typedef itk::Image<PixelType, 3> ImageType;
-  imagePile->SetRegions( vectorImage.at( 0 )->GetLargestPossibleRegion().GetSize() );
-  imagePile->SetOrigin( vectorImage.at( 0 )->GetOrigin() );
-  imagePile->SetDirection( vectorImage.at( 0 )->GetDirection() );
-  imagePile->SetSpacing( vectorImage.at( 0 )->GetSpacing() );
-  imagePile->SetVectorLength( vectorImage.size() );
-  imagePile->Allocate();
-  typename itk::ImageRegionIterator<itk::VectorImage<PixelType, 3> > out( imagePile,
-                                                                          imagePile->GetLargestPossibleRegion()
-                                                                          );
-  typedef typename itk::ImageRegionIterator<ImageType> IteratorImageType;
-  std::vector<IteratorImageType> in;
-  for( unsigned int i = 0; i < imagePile->GetVectorLength(); i++ )
-    {
-    IteratorImageType intemp( vectorImage.at( i ), vectorImage.at( i )->GetLargestPossibleRegion() );
-    intemp.GoToBegin();
-    in.push_back( intemp );
-    }
-  itk::VariableLengthVector<PixelType> value;
-  value.SetSize( vectorImage.size() );
-  for( out.GoToBegin(); !out.IsAtEnd(); ++out )
-    {
-    for( unsigned int i = 0; i < imagePile->GetVectorLength(); i++ )
-      {
-      value.SetElement( i, in.at( i ).Get() );
-      ++in[i];
-      }
-    out.Set( value );
-    }
-  return EXIT_SUCCESS;
-}
-
-// Separate the vector image into a vector of images
-template <class PixelType>
-int SeparateImages( const typename itk::VectorImage<PixelType, 3>
-                    ::Pointer & imagePile,
-                    std::vector<typename itk::Image<PixelType, 3>::Pointer> & vectorImage
-                    )
-{
-  typedef itk::Image<PixelType, 3>       ImageType;
-  typedef itk::VectorImage<PixelType, 3> VectorImageType;
-  typename itk::VectorImage<PixelType, 3>::SizeType size;
-  typename itk::VectorImage<PixelType, 3>::DirectionType direction;
-  typename itk::VectorImage<PixelType, 3>::PointType origin;
-  typename itk::VectorImage<PixelType, 3>::SpacingType spacing;
-  size = imagePile->GetLargestPossibleRegion().GetSize();
-  direction = imagePile->GetDirection();
-  origin = imagePile->GetOrigin();
-  spacing = imagePile->GetSpacing();
-  typename itk::ImageRegionIterator<VectorImageType> in( imagePile,
-                                                         imagePile->GetLargestPossibleRegion() );
-  typedef typename itk::ImageRegionIterator<ImageType> IteratorImageType;
-  std::vector<IteratorImageType> out;
-  for( unsigned int i = 0; i < imagePile->GetVectorLength(); i++ )
-    {
-    typename ImageType::Pointer imageTemp = ImageType::New();
-    imageTemp->SetRegions( size );
-    imageTemp->SetOrigin( origin );
-    imageTemp->SetDirection( direction );
-    imageTemp->SetSpacing( spacing );
-    imageTemp->Allocate();
-    vectorImage.push_back( imageTemp );
-    IteratorImageType outtemp( imageTemp, imageTemp->GetLargestPossibleRegion() );
-    outtemp.GoToBegin();
-    out.push_back( outtemp );
-    }
-  for( in.GoToBegin(); !in.IsAtEnd(); ++in )
-    {
-    itk::VariableLengthVector<PixelType> value = in.Get();
-    for( unsigned int i = 0; i < imagePile->GetVectorLength(); i++ )
-      {
-      out[i].Set( value[i] );
-      ++out[i];
-      }
-    }
-  return EXIT_SUCCESS;
-}
-
 // Verify if some input parameters are null
 bool VectorIsNul( std::vector<double> vec )
 {
@@ -1101,100 +1013,72 @@ void RASLPS( typename ImageType::Pointer image )
   image->SetDirection( m_Direction );
 }
 
-// Check the selected interpolator. Creates and returns an object of that type
-template <class ImageType>
-typename itk::InterpolateImageFunction<ImageType, double>::Pointer
-SetInterpolator( const parameters & list )
+// Check the selected interpolator and set it in the resampler.
+// Returns false if the interpolator is unknown.
+template <class ResamplerType>
+bool SetInterpolator( const parameters & list, typename ResamplerType::Pointer & resampler )
 {
-  typedef itk::ConstantBoundaryCondition<ImageType>                       BoundaryCondition;
-  typedef itk::InterpolateImageFunction<ImageType, double>                InterpolatorType;
-  typedef itk::NearestNeighborInterpolateImageFunction<ImageType, double> NearestNeighborInterpolateType;
-  typedef itk::LinearInterpolateImageFunction<ImageType, double>          LinearInterpolateType;
-  typedef itk::BSplineInterpolateImageFunction<ImageType, double, double> BSplineInterpolateFunction;
-  typename InterpolatorType::Pointer interpol;
   if( !list.interpolationType.compare( "linear" ) )
     {
-    typename LinearInterpolateType::Pointer linearinterpolator = LinearInterpolateType::New();
-    interpol = linearinterpolator;
+    resampler->SetInterpolation( ResamplerType::Linear );
     }
   else if( !list.interpolationType.compare( "nn" ) )
     {
-    typename NearestNeighborInterpolateType::Pointer interpolator = NearestNeighborInterpolateType::New();
-    interpol = interpolator;
+    resampler->SetInterpolation( ResamplerType::NearestNeighbor );
     }
   else if( !list.interpolationType.compare( "ws" ) )
     {
+    resampler->SetInterpolation( ResamplerType::WindowedSinc );
+    resampler->SetWindowRadius( RADIUS );
     if( !list.windowFunction.compare( "h" ) )
       {
-      typedef itk::Function::HammingWindowFunction<RADIUS> windowFunction;
-      typedef itk::WindowedSincInterpolateImageFunction<ImageType,
-                                                        RADIUS,
-                                                        windowFunction,
-                                                        BoundaryCondition,
-                                                        double> WindowedSincInterpolateImageFunctionType;
-      interpol = WindowedSincInterpolateImageFunctionType::New();
+      resampler->SetWindowFunction( ResamplerType::Hamming );
       }
     else if( !list.windowFunction.compare( "c" ) )
       {
-      typedef itk::Function::CosineWindowFunction<RADIUS> windowFunction;
-      typedef itk::WindowedSincInterpolateImageFunction<ImageType,
-                                                        RADIUS,
-                                                        windowFunction,
-                                                        BoundaryCondition,
-                                                        double> WindowedSincInterpolateImageFunctionType;
-      interpol = WindowedSincInterpolateImageFunctionType::New();
+      resampler->SetWindowFunction( ResamplerType::Cosine );
       }
     else if( !list.windowFunction.compare( "w" ) )
       {
-      typedef itk::Function::WelchWindowFunction<RADIUS> windowFunction;
-      typedef itk::WindowedSincInterpolateImageFunction<ImageType,
-                                                        RADIUS,
-                                                        windowFunction,
-                                                        BoundaryCondition,
-                                                        double> WindowedSincInterpolateImageFunctionType;
-      interpol = WindowedSincInterpolateImageFunctionType::New();
+      resampler->SetWindowFunction( ResamplerType::Welch );
       }
     else if( !list.windowFunction.compare( "l" ) )
       {
-      typedef itk::Function::LanczosWindowFunction<RADIUS> windowFunction;
-      typedef itk::WindowedSincInterpolateImageFunction<ImageType,
-                                                        RADIUS,
-                                                        windowFunction,
-                                                        BoundaryCondition,
-                                                        double> WindowedSincInterpolateImageFunctionType;
-      interpol = WindowedSincInterpolateImageFunctionType::New();
+      resampler->SetWindowFunction( ResamplerType::Lanczos );
       }
     else if( !list.windowFunction.compare( "b" ) )
       {
-      typedef itk::Function::BlackmanWindowFunction<RADIUS> windowFunction;
-      typedef itk::WindowedSincInterpolateImageFunction<ImageType,
-                                                        RADIUS,
-                                                        windowFunction,
-                                                        BoundaryCondition,
-                                                        double> WindowedSincInterpolateImageFunctionType;
-      interpol = WindowedSincInterpolateImageFunctionType::New();
+      resampler->SetWindowFunction( ResamplerType::Blackman );
+      }
+    else
+      {
+      std::cerr << "Unknown window function: " << list.windowFunction << std::endl;
+      return false;
       }
     }
   else if( !list.interpolationType.compare( "bs" ) )
     {
-    typename BSplineInterpolateFunction::Pointer bSplineInterpolator = BSplineInterpolateFunction::New();
-    bSplineInterpolator->SetSplineOrder( list.splineOrder );
-    interpol = bSplineInterpolator;
+    resampler->SetInterpolation( ResamplerType::BSpline );
+    resampler->SetSplineOrder( list.splineOrder );
     }
-  return interpol;
+  else
+    {
+    std::cerr << "Unknown interpolation type: " << list.interpolationType << std::endl;
+    return false;
+    }
+  return true;
 }
 
 template <class PixelType>
 int Rotate( parameters & list )
 {
   typedef itk::Image<PixelType, 3>                         ImageType;
-  typedef itk::InterpolateImageFunction<ImageType, double> InterpolatorType;
   typedef itk::ResampleImageFilter<ImageType, ImageType>   ResampleType;
   typedef itk::Transform<double, 3, 3>                     TransformType;
   typedef itk::VectorImage<PixelType, 3>                   VectorImageType;
-  typename ImageType::Pointer image;
-  std::vector<typename ImageType::Pointer> vectorOfImage;
-  itk::MetaDataDictionary                  dico;
+  typedef itk::VectorImageResampleFilter<PixelType, 3>     VectorResampleType;
+  typename VectorImageType::Pointer inputImage;
+  itk::MetaDataDictionary           dico;
   try
     {
     // open image file
@@ -1206,44 +1090,64 @@ int Rotate( parameters & list )
       {
       RASLPS<VectorImageType>( reader->GetOutput() );
       }
+    inputImage = reader->GetOutput();
+    inputImage->DisconnectPipeline();
     // Save metadata dictionary
-    dico = reader->GetOutput()->GetMetaDataDictionary();
-    // Separate the vector image into a vector of images
-    SeparateImages<PixelType>( reader->GetOutput(), vectorOfImage );
+    dico = inputImage->GetMetaDataDictionary();
     }
   catch( itk::ExceptionObject exception )
     {
     std::cerr << exception << std::endl;
     return EXIT_FAILURE;
     }
-  // Set interpolator
-  typename InterpolatorType::Pointer interpol;
-  interpol = SetInterpolator<ImageType>( list );
-  // Create resampler and initialize its output parameters
+  // Scalar image with the geometry of the input image (no voxels are allocated),
+  // used for computing the output geometry and the transform
+  typename ImageType::Pointer image = ImageType::New();
+  image->SetRegions( inputImage->GetLargestPossibleRegion() );
+  image->SetOrigin( inputImage->GetOrigin() );
+  image->SetSpacing( inputImage->GetSpacing() );
+  image->SetDirection( inputImage->GetDirection() );
+  // Initialize the output parameters
   typename ResampleType::Pointer resample = ResampleType::New();
-  SetOutputParameters<ImageType>( list, resample, vectorOfImage[0] );
+  SetOutputParameters<ImageType>( list, resample, image );
   TransformType::Pointer transform;
   // Load transforms and compute a merged transform
-  transform = SetAllTransform<ImageType>( list, resample, vectorOfImage[0] );
+  transform = SetAllTransform<ImageType>( list, resample, image );
   if( !transform )
     {
     return EXIT_FAILURE;
     }
-  resample->SetTransform( transform );
-  resample->SetInterpolator( interpol );
-  std::vector<typename ImageType::Pointer> vectorOutputImage;
-  // Resample all the images separately
-  for( ::size_t idx = 0; idx < vectorOfImage.size(); idx++ )
+  // Resample all the components at once: the mapped position and the
+  // interpolation weights of each output voxel are computed only once
+  typename VectorResampleType::Pointer vectorResample = VectorResampleType::New();
+  if( !SetInterpolator<VectorResampleType>( list, vectorResample ) )
+    {
+    return EXIT_FAILURE;
+    }
+  vectorResample->SetTransform( transform );
+  vectorResample->SetSize( resample->GetSize() );
+  vectorResample->SetOutputSpacing( resample->GetOutputSpacing() );
+  vectorResample->SetOutputOrigin( resample->GetOutputOrigin() );
+  vectorResample->SetOutputDirection( resample->GetOutputDirection() );
+  vectorResample->SetDefaultPixelValue( resample->GetDefaultPixelValue() );
+  if( list.numberOfThread )
+    {
+    vectorResample->SetNumberOfThreads( list.numberOfThread );
+    }
+  vectorResample->SetInput( inputImage );
+  typename VectorImageType::Pointer outputImage;
+  try
+    {
+    vectorResample->Update();
+    outputImage = vectorResample->GetOutput();
+    outputImage->DisconnectPipeline();
+    }
+  catch( itk::ExceptionObject exception )
     {
-    resample->SetInput( vectorOfImage[idx] );
-    resample->Update();
-    vectorOutputImage.push_back( resample->GetOutput() );
-    vectorOutputImage[idx]->DisconnectPipeline();
+    std::cerr << exception << std::endl;
+    return EXIT_FAILURE;
     }
-  typename itk::VectorImage<PixelType, 3>::Pointer outputImage;
-  outputImage = itk::VectorImage<PixelType, 3>::New();
-  AddImage<PixelType>( outputImage, vectorOutputImage );
-  vectorOutputImage.clear();
+  inputImage = NULL;
   // If necessary, transform gradient vectors with the loaded transformations
   int dwmriProblem = CheckDWMRI( dico, transform );
   if( list.space ) // && list.transformationFile.compare( "" ) )
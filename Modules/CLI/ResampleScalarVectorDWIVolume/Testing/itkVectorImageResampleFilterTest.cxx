@@ -0,0 +1,264 @@
+#include "itkVectorImageResampleFilter.h"
+
+// ITK includes
+#include <itkAffineTransform.h>
+#include <itkBSplineInterpolateImageFunction.h>
+#include <itkConstantBoundaryCondition.h>
+#include <itkImage.h>
+#include <itkImageRegionConstIteratorWithIndex.h>
+#include <itkLinearInterpolateImageFunction.h>
+#include <itkNearestNeighborInterpolateImageFunction.h>
+#include <itkResampleImageFilter.h>
+#include <itkVectorImage.h>
+#include <itkWindowedSincInterpolateImageFunction.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+typedef short                                           PixelType;
+typedef itk::VectorImage<PixelType, 3>                  VectorImageType;
+typedef itk::Image<PixelType, 3>                        ComponentImageType;
+typedef itk::VectorImageResampleFilter<PixelType, 3>    VectorResampleFilterType;
+typedef itk::ResampleImageFilter<ComponentImageType, ComponentImageType> ComponentResampleFilterType;
+typedef itk::AffineTransform<double, 3>                 TransformType;
+
+const unsigned int NumberOfComponents = 4;
+const unsigned int WindowRadius = 3;
+const unsigned int SplineOrder = 3;
+const PixelType    DefaultPixelValue = -7;
+
+// Vector image with random values, the geometry is not axis aligned
+VectorImageType::Pointer CreateInputImage()
+{
+  VectorImageType::SizeType size;
+  size[0] = 17;
+  size[1] = 13;
+  size[2] = 11;
+  VectorImageType::SpacingType spacing;
+  spacing[0] = 1.2;
+  spacing[1] = 0.9;
+  spacing[2] = 2.1;
+  VectorImageType::PointType origin;
+  origin[0] = -8.3;
+  origin[1] = 4.1;
+  origin[2] = -2.7;
+  VectorImageType::DirectionType direction;
+  direction.SetIdentity();
+  direction[0][0] = 0.0;
+  direction[0][1] = 1.0;
+  direction[1][0] = -1.0;
+  direction[1][1] = 0.0;
+
+  VectorImageType::Pointer image = VectorImageType::New();
+  image->SetRegions( size );
+  image->SetSpacing( spacing );
+  image->SetOrigin( origin );
+  image->SetDirection( direction );
+  image->SetNumberOfComponentsPerPixel( NumberOfComponents );
+  image->Allocate();
+
+  unsigned int seed = 1234;
+  PixelType *  buffer = image->GetBufferPointer();
+  const size_t bufferSize = image->GetBufferedRegion().GetNumberOfPixels() * NumberOfComponents;
+  for( size_t i = 0; i < bufferSize; i++ )
+    {
+    // linear congruential generator, so that the test does not depend on the platform
+    seed = seed * 1103515245 + 12345;
+    buffer[i] = static_cast<PixelType>( static_cast<int>( (seed >> 16) % 2001 ) - 1000 );
+    }
+  return image;
+}
+
+// Small rotation, scaling and translation. Part of the output is mapped outside of the input.
+TransformType::Pointer CreateTransform()
+{
+  TransformType::Pointer transform = TransformType::New();
+  TransformType::OutputVectorType axis;
+  axis[0] = 0.2;
+  axis[1] = 0.3;
+  axis[2] = 0.9;
+  transform->Rotate3D( axis, 0.13 );
+  TransformType::OutputVectorType scale;
+  scale[0] = 1.07;
+  scale[1] = 0.93;
+  scale[2] = 1.01;
+  transform->Scale( scale );
+  TransformType::OutputVectorType translation;
+  translation[0] = 1.3;
+  translation[1] = -0.7;
+  translation[2] = 2.2;
+  transform->Translate( translation );
+  return transform;
+}
+
+ComponentImageType::Pointer ExtractComponent( VectorImageType * image, unsigned int component )
+{
+  ComponentImageType::Pointer componentImage = ComponentImageType::New();
+  componentImage->CopyInformation( image );
+  componentImage->SetRegions( image->GetBufferedRegion() );
+  componentImage->Allocate();
+  const PixelType * vectorBuffer = image->GetBufferPointer();
+  PixelType *       componentBuffer = componentImage->GetBufferPointer();
+  const size_t      numberOfPixels = image->GetBufferedRegion().GetNumberOfPixels();
+  for( size_t i = 0; i < numberOfPixels; i++ )
+    {
+    componentBuffer[i] = vectorBuffer[i * NumberOfComponents + component];
+    }
+  return componentImage;
+}
+
+// Compare the resampled vector image with the result of itk::ResampleImageFilter on each component
+int CompareWithComponentResampling( VectorResampleFilterType::InterpolationType interpolation, int tolerance,
+                                    const char * interpolationName )
+{
+  VectorImageType::Pointer input = CreateInputImage();
+  TransformType::Pointer   transform = CreateTransform();
+
+  VectorImageType::SizeType size;
+  size[0] = 19;
+  size[1] = 15;
+  size[2] = 9;
+  VectorImageType::SpacingType spacing;
+  spacing[0] = 1.1;
+  spacing[1] = 1.3;
+  spacing[2] = 2.3;
+  VectorImageType::PointType origin;
+  origin[0] = -7.9;
+  origin[1] = -13.2;
+  origin[2] = -3.1;
+  VectorImageType::DirectionType direction;
+  direction.SetIdentity();
+
+  VectorResampleFilterType::Pointer vectorResample = VectorResampleFilterType::New();
+  vectorResample->SetInput( input );
+  vectorResample->SetTransform( transform );
+  vectorResample->SetInterpolation( interpolation );
+  vectorResample->SetWindowFunction( VectorResampleFilterType::Hamming );
+  vectorResample->SetWindowRadius( WindowRadius );
+  vectorResample->SetSplineOrder( SplineOrder );
+  vectorResample->SetDefaultPixelValue( DefaultPixelValue );
+  vectorResample->SetSize( size );
+  vectorResample->SetOutputSpacing( spacing );
+  vectorResample->SetOutputOrigin( origin );
+  vectorResample->SetOutputDirection( direction );
+  vectorResample->Update();
+  VectorImageType::Pointer vectorOutput = vectorResample->GetOutput();
+  if( vectorOutput->GetNumberOfComponentsPerPixel() != NumberOfComponents )
+    {
+    std::cerr << interpolationName << ": number of output components is "
+              << vectorOutput->GetNumberOfComponentsPerPixel() << ", expected " << NumberOfComponents << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  unsigned int numberOfDefaultPixels = 0;
+  unsigned int numberOfInterpolatedPixels = 0;
+  for( unsigned int c = 0; c < NumberOfComponents; c++ )
+    {
+    ComponentResampleFilterType::Pointer componentResample = ComponentResampleFilterType::New();
+    componentResample->SetInput( ExtractComponent( input, c ) );
+    componentResample->SetTransform( transform );
+    switch( interpolation )
+      {
+      case VectorResampleFilterType::NearestNeighbor:
+        componentResample->SetInterpolator(
+          itk::NearestNeighborInterpolateImageFunction<ComponentImageType, double>::New() );
+        break;
+      case VectorResampleFilterType::WindowedSinc:
+        {
+        typedef itk::WindowedSincInterpolateImageFunction<ComponentImageType, WindowRadius,
+                                                          itk::Function::HammingWindowFunction<WindowRadius>,
+                                                          itk::ConstantBoundaryCondition<ComponentImageType>,
+                                                          double> WindowedSincInterpolatorType;
+        componentResample->SetInterpolator( WindowedSincInterpolatorType::New() );
+        break;
+        }
+      case VectorResampleFilterType::BSpline:
+        {
+        typedef itk::BSplineInterpolateImageFunction<ComponentImageType, double, double> BSplineInterpolatorType;
+        BSplineInterpolatorType::Pointer bsplineInterpolator = BSplineInterpolatorType::New();
+        bsplineInterpolator->SetSplineOrder( SplineOrder );
+        componentResample->SetInterpolator( bsplineInterpolator );
+        break;
+        }
+      case VectorResampleFilterType::Linear:
+      default:
+        componentResample->SetInterpolator( itk::LinearInterpolateImageFunction<ComponentImageType, double>::New() );
+        break;
+      }
+    componentResample->SetDefaultPixelValue( DefaultPixelValue );
+    componentResample->SetSize( size );
+    componentResample->SetOutputSpacing( spacing );
+    componentResample->SetOutputOrigin( origin );
+    componentResample->SetOutputDirection( direction );
+    componentResample->Update();
+
+    itk::ImageRegionConstIteratorWithIndex<ComponentImageType> expectedIt( componentResample->GetOutput(),
+                                                                           componentResample->GetOutput()->GetBufferedRegion() );
+    for( expectedIt.GoToBegin(); !expectedIt.IsAtEnd(); ++expectedIt )
+      {
+      const int expected = expectedIt.Get();
+      const int actual = vectorOutput->GetPixel( expectedIt.GetIndex() )[c];
+      if( std::abs( actual - expected ) > tolerance )
+        {
+        std::cerr << interpolationName << ": component " << c << " at " << expectedIt.GetIndex() << " is " << actual
+                  << ", expected " << expected << std::endl;
+        return EXIT_FAILURE;
+        }
+      if( expected == DefaultPixelValue )
+        {
+        numberOfDefaultPixels++;
+        }
+      else
+        {
+        numberOfInterpolatedPixels++;
+        }
+      }
+    }
+
+  // Test is only meaningful if the output is partially inside and partially outside of the input
+  if( numberOfDefaultPixels == 0 || numberOfInterpolatedPixels == 0 )
+    {
+    std::cerr << interpolationName << ": " << numberOfDefaultPixels << " voxels outside and "
+              << numberOfInterpolatedPixels << " voxels inside of the input, expected both" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
+
+int main(int, char *[])
+{
+  try
+    {
+    // Nearest neighbor selects the same voxel, values must be identical.
+    if( CompareWithComponentResampling( VectorResampleFilterType::NearestNeighbor, 0, "Nearest neighbor" )
+        != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+    // Weights are accumulated in a different order, which may change the truncated value by one.
+    if( CompareWithComponentResampling( VectorResampleFilterType::Linear, 1, "Linear" ) != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+    // Hamming window with radius 3 and constant zero boundary, same tolerance as linear.
+    if( CompareWithComponentResampling( VectorResampleFilterType::WindowedSinc, 1, "Windowed sinc" )
+        != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+    // Cubic BSpline, coefficients are computed by the same decomposition filter on each component.
+    if( CompareWithComponentResampling( VectorResampleFilterType::BSpline, 1, "BSpline" ) != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  catch( itk::ExceptionObject & e )
+    {
+    std::cerr << "Resampling failed: " << e << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
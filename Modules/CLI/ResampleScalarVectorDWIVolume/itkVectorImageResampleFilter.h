@@ -0,0 +1,182 @@
+#ifndef __itkVectorImageResampleFilter_h
+#define __itkVectorImageResampleFilter_h
+
+#include <itkImageToImageFilter.h>
+#include <itkImage.h>
+#include <itkVectorImage.h>
+#include <itkTransform.h>
+
+#include <vector>
+
+namespace itk
+{
+/** \class VectorImageResampleFilter
+ *
+ * Resample all the components of a vector image (e.g., DWI) at once.
+ *
+ * The position of each output voxel in the input image and the interpolation
+ * stencil (input offsets and weights) are computed only once per voxel and
+ * then applied to every component. Supported interpolators are the same as
+ * the ones available in ResampleScalarVectorDWIVolume: nearest neighbor,
+ * linear, windowed sinc (with constant zero boundary condition) and BSpline
+ * (with mirror boundary condition).
+ *
+ * As in itk::ResampleImageFilter, the transform maps points from the
+ * output space to the input space.
+ */
+
+template <class TPixel, unsigned int NDimensions = 3>
+class VectorImageResampleFilter
+  : public ImageToImageFilter<VectorImage<TPixel, NDimensions>, VectorImage<TPixel, NDimensions> >
+{
+public:
+  typedef TPixel                                              PixelType;
+  typedef VectorImage<PixelType, NDimensions>                 InputImageType;
+  typedef VectorImage<PixelType, NDimensions>                 OutputImageType;
+  typedef ImageToImageFilter<InputImageType, OutputImageType> Superclass;
+  typedef VectorImageResampleFilter                           Self;
+  typedef SmartPointer<Self>                                  Pointer;
+  typedef SmartPointer<const Self>                            ConstPointer;
+
+  typedef typename InputImageType::ConstPointer      InputImageConstPointer;
+  typedef typename OutputImageType::Pointer          OutputImagePointer;
+  typedef typename OutputImageType::RegionType       OutputImageRegionType;
+  typedef typename OutputImageType::SizeType         SizeType;
+  typedef typename OutputImageType::IndexType        IndexType;
+  typedef typename OutputImageType::SpacingType      SpacingType;
+  typedef typename OutputImageType::PointType        PointType;
+  typedef typename OutputImageType::DirectionType    DirectionType;
+  typedef Transform<double, NDimensions, NDimensions> TransformType;
+  typedef typename TransformType::ConstPointer       TransformConstPointerType;
+  typedef VectorImage<double, NDimensions>           CoefficientImageType;
+
+  /** Maximum number of samples along one axis (windowed sinc with the maximum radius) */
+  itkStaticConstMacro( MaximumAxisSamples, unsigned int, 20 );
+
+  /** Interpolation methods */
+  enum InterpolationType
+    {
+    NearestNeighbor,
+    Linear,
+    WindowedSinc,
+    BSpline
+    };
+
+  /** Window functions of the windowed sinc interpolator */
+  enum WindowFunctionType
+    {
+    Hamming,
+    Cosine,
+    Welch,
+    Lanczos,
+    Blackman
+    };
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(VectorImageResampleFilter, ImageToImageFilter);
+
+  itkNewMacro( Self );
+
+  /** Set/Get the transform that maps output points to input points */
+  itkSetConstObjectMacro( Transform, TransformType );
+  itkGetConstObjectMacro( Transform, TransformType );
+
+  itkSetMacro( Interpolation, InterpolationType );
+  itkGetConstMacro( Interpolation, InterpolationType );
+
+  itkSetMacro( WindowFunction, WindowFunctionType );
+  itkGetConstMacro( WindowFunction, WindowFunctionType );
+
+  /** Radius of the windowed sinc interpolator */
+  itkSetClampMacro( WindowRadius, unsigned int, 1, 10 );
+  itkGetConstMacro( WindowRadius, unsigned int );
+
+  /** Order of the BSpline interpolator (0-5) */
+  itkSetClampMacro( SplineOrder, unsigned int, 0, 5 );
+  itkGetConstMacro( SplineOrder, unsigned int );
+
+  /** Value of the voxels that are mapped outside of the input image */
+  itkSetMacro( DefaultPixelValue, PixelType );
+  itkGetConstMacro( DefaultPixelValue, PixelType );
+
+  /** Output image geometry */
+  itkSetMacro( Size, SizeType );
+  itkGetConstReferenceMacro( Size, SizeType );
+  itkSetMacro( OutputSpacing, SpacingType );
+  itkGetConstReferenceMacro( OutputSpacing, SpacingType );
+  itkSetMacro( OutputOrigin, PointType );
+  itkGetConstReferenceMacro( OutputOrigin, PointType );
+  itkSetMacro( OutputDirection, DirectionType );
+  itkGetConstReferenceMacro( OutputDirection, DirectionType );
+
+  unsigned long GetMTime() const ITK_OVERRIDE;
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  /** Begin concept checking */
+  itkConceptMacro( PixelConvertibleToDoubleCheck,
+                   ( Concept::Convertible<PixelType, double> ) );
+  itkConceptMacro( DoubleConvertibleToPixelCheck,
+                   ( Concept::Convertible<double, PixelType> ) );
+  /** End concept checking */
+#endif
+protected:
+  VectorImageResampleFilter();
+
+  void BeforeThreadedGenerateData() ITK_OVERRIDE;
+
+  void ThreadedGenerateData( const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId ) ITK_OVERRIDE;
+
+  void AfterThreadedGenerateData() ITK_OVERRIDE;
+
+  void GenerateOutputInformation() ITK_OVERRIDE;
+
+  void GenerateInputRequestedRegion() ITK_OVERRIDE;
+
+  void PrintSelf( std::ostream & os, Indent indent ) const ITK_OVERRIDE;
+
+  /** Compute the input buffer offsets and weights used for interpolating
+   * at the given continuous index. Returns false if the index is outside
+   * of the input image. */
+  bool ComputeStencil( const ContinuousIndex<double, NDimensions> & index,
+                       std::vector<OffsetValueType> & offsets,
+                       std::vector<double> & weights ) const;
+
+  /** Compute the 1D sample indices and weights along one axis */
+  unsigned int ComputeAxisWeights( unsigned int axis, double x, IndexValueType * indices, double * weights ) const;
+
+  double EvaluateWindowFunction( double x ) const;
+
+  static double EvaluateBSplineKernel( unsigned int order, double x );
+
+  /** Compute BSpline coefficients of all the components */
+  void ComputeBSplineCoefficients();
+
+private:
+  VectorImageResampleFilter( const Self & ); // purposely not implemented
+  void operator=( const Self & );            // purposely not implemented
+
+  TransformConstPointerType m_Transform;
+  InterpolationType         m_Interpolation;
+  WindowFunctionType        m_WindowFunction;
+  unsigned int              m_WindowRadius;
+  unsigned int              m_SplineOrder;
+  PixelType                 m_DefaultPixelValue;
+  SizeType                  m_Size;
+  SpacingType               m_OutputSpacing;
+  PointType                 m_OutputOrigin;
+  DirectionType             m_OutputDirection;
+
+  // Valid during the execution of the filter
+  typename CoefficientImageType::Pointer m_Coefficients;
+  IndexType                              m_StartIndex;
+  IndexType                              m_EndIndex;
+  OffsetValueType                        m_OffsetTable[NDimensions + 1];
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkVectorImageResampleFilter.txx"
+#endif
+
+#endif
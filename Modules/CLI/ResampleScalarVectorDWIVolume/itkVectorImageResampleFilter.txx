@@ -0,0 +1,574 @@
+#ifndef __itkVectorImageResampleFilter_txx
+#define __itkVectorImageResampleFilter_txx
+
+#include "itkVectorImageResampleFilter.h"
+
+#include <itkBSplineDecompositionImageFilter.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkMath.h>
+#include <itkNumericTraits.h>
+#include <itkProgressReporter.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+template <class TPixel, unsigned int NDimensions>
+VectorImageResampleFilter<TPixel, NDimensions>
+::VectorImageResampleFilter()
+{
+  this->SetNumberOfRequiredInputs( 1 );
+  m_Interpolation = Linear;
+  m_WindowFunction = Hamming;
+  m_WindowRadius = 3;
+  m_SplineOrder = 3;
+  m_DefaultPixelValue = NumericTraits<PixelType>::Zero;
+  m_Size.Fill( 0 );
+  m_OutputSpacing.Fill( 1.0 );
+  m_OutputOrigin.Fill( 0.0 );
+  m_OutputDirection.SetIdentity();
+  m_StartIndex.Fill( 0 );
+  m_EndIndex.Fill( 0 );
+  for( unsigned int i = 0; i <= NDimensions; i++ )
+    {
+    m_OffsetTable[i] = 0;
+    }
+}
+
+template <class TPixel, unsigned int NDimensions>
+unsigned long
+VectorImageResampleFilter<TPixel, NDimensions>
+::GetMTime() const
+{
+  unsigned long latestTime = Superclass::GetMTime();
+
+  if( m_Transform.IsNotNull() )
+    {
+    if( latestTime < m_Transform->GetMTime() )
+      {
+      latestTime = m_Transform->GetMTime();
+      }
+    }
+  return latestTime;
+}
+
+template <class TPixel, unsigned int NDimensions>
+void
+VectorImageResampleFilter<TPixel, NDimensions>
+::BeforeThreadedGenerateData()
+{
+  if( m_Transform.IsNull() )
+    {
+    itkExceptionMacro( << "Transform not set" );
+    }
+  InputImageConstPointer input = this->GetInput();
+  if( !input )
+    {
+    itkExceptionMacro( << "Input image not set" );
+    }
+  const typename InputImageType::RegionType & bufferedRegion = input->GetBufferedRegion();
+  for( unsigned int i = 0; i < NDimensions; i++ )
+    {
+    m_StartIndex[i] = bufferedRegion.GetIndex()[i];
+    m_EndIndex[i] = m_StartIndex[i] + static_cast<IndexValueType>( bufferedRegion.GetSize()[i] ) - 1;
+    }
+  // offsets are in number of pixels (not components)
+  const OffsetValueType *offsetTable = input->GetOffsetTable();
+  for( unsigned int i = 0; i <= NDimensions; i++ )
+    {
+    m_OffsetTable[i] = offsetTable[i];
+    }
+  if( m_Interpolation == BSpline )
+    {
+    this->ComputeBSplineCoefficients();
+    }
+}
+
+template <class TPixel, unsigned int NDimensions>
+void
+VectorImageResampleFilter<TPixel, NDimensions>
+::AfterThreadedGenerateData()
+{
+  // coefficients are only needed during the execution
+  m_Coefficients = NULL;
+}
+
+template <class TPixel, unsigned int NDimensions>
+void
+VectorImageResampleFilter<TPixel, NDimensions>
+::ComputeBSplineCoefficients()
+{
+  typedef Image<double, NDimensions>                                    ComponentImageType;
+  typedef BSplineDecompositionImageFilter<ComponentImageType, ComponentImageType> DecompositionFilterType;
+
+  InputImageConstPointer input = this->GetInput();
+  const unsigned int numberOfComponents = input->GetNumberOfComponentsPerPixel();
+  const typename InputImageType::RegionType & region = input->GetBufferedRegion();
+
+  m_Coefficients = CoefficientImageType::New();
+  m_Coefficients->CopyInformation( input );
+  m_Coefficients->SetRegions( region );
+  m_Coefficients->SetNumberOfComponentsPerPixel( numberOfComponents );
+  m_Coefficients->Allocate();
+
+  typename ComponentImageType::Pointer component = ComponentImageType::New();
+  component->CopyInformation( input );
+  component->SetRegions( region );
+  component->Allocate();
+
+  const SizeValueType numberOfPixels = region.GetNumberOfPixels();
+  const PixelType *   inputBuffer = input->GetBufferPointer();
+  double *            coefficientBuffer = m_Coefficients->GetBufferPointer();
+  for( unsigned int c = 0; c < numberOfComponents; c++ )
+    {
+    double *componentBuffer = component->GetBufferPointer();
+    for( SizeValueType i = 0; i < numberOfPixels; i++ )
+      {
+      componentBuffer[i] = static_cast<double>( inputBuffer[i * numberOfComponents + c] );
+      }
+    typename DecompositionFilterType::Pointer decomposition = DecompositionFilterType::New();
+    decomposition->SetSplineOrder( m_SplineOrder );
+    decomposition->SetInput( component );
+    decomposition->Update();
+    const double *decompositionBuffer = decomposition->GetOutput()->GetBufferPointer();
+    for( SizeValueType i = 0; i < numberOfPixels; i++ )
+      {
+      coefficientBuffer[i * numberOfComponents + c] = decompositionBuffer[i];
+      }
+    }
+}
+
+template <class TPixel, unsigned int NDimensions>
+double
+VectorImageResampleFilter<TPixel, NDimensions>
+::EvaluateWindowFunction( double x ) const
+{
+  // same definitions as the window functions of itkWindowedSincInterpolateImageFunction.h
+  const double radius = static_cast<double>( m_WindowRadius );
+  switch( m_WindowFunction )
+    {
+    case Cosine:
+      return std::cos( x * vnl_math::pi / ( 2.0 * radius ) );
+    case Welch:
+      return 1.0 - x * x / ( radius * radius );
+    case Lanczos:
+      {
+      if( x == 0.0 )
+        {
+        return 1.0;
+        }
+      const double z = x * vnl_math::pi / radius;
+      return std::sin( z ) / z;
+      }
+    case Blackman:
+      return 0.42 + 0.5 * std::cos( x * vnl_math::pi / radius ) + 0.08 * std::cos( x * 2.0 * vnl_math::pi / radius );
+    case Hamming:
+    default:
+      return 0.54 + 0.46 * std::cos( x * vnl_math::pi / radius );
+    }
+}
+
+template <class TPixel, unsigned int NDimensions>
+double
+VectorImageResampleFilter<TPixel, NDimensions>
+::EvaluateBSplineKernel( unsigned int order, double x )
+{
+  const double a = std::fabs( x );
+  double       t;
+  switch( order )
+    {
+    case 0:
+      if( a < 0.5 )
+        {
+        return 1.0;
+        }
+      return ( a == 0.5 ) ? 0.5 : 0.0;
+    case 1:
+      return ( a < 1.0 ) ? 1.0 - a : 0.0;
+    case 2:
+      if( a < 0.5 )
+        {
+        return 0.75 - a * a;
+        }
+      if( a < 1.5 )
+        {
+        t = 1.5 - a;
+        return 0.5 * t * t;
+        }
+      return 0.0;
+    case 3:
+      if( a < 1.0 )
+        {
+        return 2.0 / 3.0 - a * a + 0.5 * a * a * a;
+        }
+      if( a < 2.0 )
+        {
+        t = 2.0 - a;
+        return t * t * t / 6.0;
+        }
+      return 0.0;
+    case 4:
+      if( a < 0.5 )
+        {
+        return 115.0 / 192.0 - 5.0 / 8.0 * a * a + 0.25 * a * a * a * a;
+        }
+      if( a < 1.5 )
+        {
+        return ( 55.0 + 20.0 * a - 120.0 * a * a + 80.0 * a * a * a - 16.0 * a * a * a * a ) / 96.0;
+        }
+      if( a < 2.5 )
+        {
+        t = 5.0 - 2.0 * a;
+        return t * t * t * t / 384.0;
+        }
+      return 0.0;
+    case 5:
+      if( a < 1.0 )
+        {
+        return 11.0 / 20.0 - 0.5 * a * a + 0.25 * a * a * a * a - a * a * a * a * a / 12.0;
+        }
+      if( a < 2.0 )
+        {
+        return 17.0 / 40.0 + 5.0 / 8.0 * a - 7.0 / 4.0 * a * a + 5.0 / 4.0 * a * a * a
+               - 3.0 / 8.0 * a * a * a * a + a * a * a * a * a / 24.0;
+        }
+      if( a < 3.0 )
+        {
+        t = 3.0 - a;
+        return t * t * t * t * t / 120.0;
+        }
+      return 0.0;
+    default:
+      return 0.0;
+    }
+}
+
+template <class TPixel, unsigned int NDimensions>
+unsigned int
+VectorImageResampleFilter<TPixel, NDimensions>
+::ComputeAxisWeights( unsigned int axis, double x, IndexValueType * indices, double * weights ) const
+{
+  const IndexValueType start = m_StartIndex[axis];
+  const IndexValueType end = m_EndIndex[axis];
+  switch( m_Interpolation )
+    {
+    case NearestNeighbor:
+      {
+      indices[0] = Math::RoundHalfIntegerUp<IndexValueType>( x );
+      weights[0] = 1.0;
+      return 1;
+      }
+    case Linear:
+      {
+      // same boundary handling as itk::LinearInterpolateImageFunction
+      IndexValueType base = Math::Floor<IndexValueType>( x );
+      if( base < start )
+        {
+        base = start;
+        }
+      double distance = x - static_cast<double>( base );
+      if( distance < 0.0 )
+        {
+        distance = 0.0;
+        }
+      indices[0] = base;
+      weights[0] = 1.0 - distance;
+      indices[1] = ( base + 1 > end ) ? end : base + 1;
+      weights[1] = distance;
+      return 2;
+      }
+    case WindowedSinc:
+      {
+      const IndexValueType base = Math::Floor<IndexValueType>( x );
+      const double         distance = x - static_cast<double>( base );
+      const int            radius = static_cast<int>( m_WindowRadius );
+      unsigned int         numberOfSamples = 0;
+      for( int offset = 1 - radius; offset <= radius; offset++, numberOfSamples++ )
+        {
+        IndexValueType index = base + offset;
+        double         weight = 0.0;
+        if( distance == 0.0 )
+          {
+          weight = ( offset == 0 ) ? 1.0 : 0.0;
+          }
+        else
+          {
+          const double s = distance - offset;
+          const double sinc = vnl_math::pi * s;
+          weight = this->EvaluateWindowFunction( s ) * std::sin( sinc ) / sinc;
+          }
+        if( index < start || index > end )
+          {
+          // constant (zero) boundary condition
+          index = start;
+          weight = 0.0;
+          }
+        indices[numberOfSamples] = index;
+        weights[numberOfSamples] = weight;
+        }
+      return numberOfSamples;
+      }
+    case BSpline:
+      {
+      // same region of support and mirror boundary as itk::BSplineInterpolateImageFunction
+      const int      order = static_cast<int>( m_SplineOrder );
+      const double   halfOffset = ( order & 1 ) ? 0.0 : 0.5;
+      IndexValueType index = Math::Floor<IndexValueType>( x + halfOffset ) - order / 2;
+      for( int k = 0; k <= order; k++, index++ )
+        {
+        weights[k] = EvaluateBSplineKernel( m_SplineOrder, x - static_cast<double>( index ) );
+        IndexValueType mirroredIndex = index;
+        if( start == end )
+          {
+          mirroredIndex = start;
+          }
+        else
+          {
+          if( mirroredIndex < start )
+            {
+            mirroredIndex = start + ( start - mirroredIndex );
+            }
+          if( mirroredIndex > end )
+            {
+            mirroredIndex = end - ( mirroredIndex - end );
+            }
+          mirroredIndex = std::max( start, std::min( end, mirroredIndex ) );
+          }
+        indices[k] = mirroredIndex;
+        }
+      return static_cast<unsigned int>( order + 1 );
+      }
+    default:
+      return 0;
+    }
+}
+
+template <class TPixel, unsigned int NDimensions>
+bool
+VectorImageResampleFilter<TPixel, NDimensions>
+::ComputeStencil( const ContinuousIndex<double, NDimensions> & index,
+                  std::vector<OffsetValueType> & offsets,
+                  std::vector<double> & weights ) const
+{
+  offsets.clear();
+  weights.clear();
+
+  // same test as itk::ImageFunction::IsInsideBuffer
+  for( unsigned int d = 0; d < NDimensions; d++ )
+    {
+    if( !( index[d] >= static_cast<double>( m_StartIndex[d] ) - 0.5 )
+        || !( index[d] < static_cast<double>( m_EndIndex[d] ) + 0.5 ) )
+      {
+      return false;
+      }
+    }
+
+  IndexValueType axisIndices[NDimensions][MaximumAxisSamples];
+  double         axisWeights[NDimensions][MaximumAxisSamples];
+  unsigned int   axisSamples[NDimensions];
+  for( unsigned int d = 0; d < NDimensions; d++ )
+    {
+    axisSamples[d] = this->ComputeAxisWeights( d, index[d], axisIndices[d], axisWeights[d] );
+    }
+
+  // tensor product of the axis samples
+  unsigned int sample[NDimensions];
+  for( unsigned int d = 0; d < NDimensions; d++ )
+    {
+    sample[d] = 0;
+    }
+  bool done = false;
+  while( !done )
+    {
+    double          weight = 1.0;
+    OffsetValueType offset = 0;
+    for( unsigned int d = 0; d < NDimensions; d++ )
+      {
+      weight *= axisWeights[d][sample[d]];
+      offset += ( axisIndices[d][sample[d]] - m_StartIndex[d] ) * m_OffsetTable[d];
+      }
+    if( weight != 0.0 )
+      {
+      offsets.push_back( offset );
+      weights.push_back( weight );
+      }
+    // next sample
+    done = true;
+    for( unsigned int d = 0; d < NDimensions; d++ )
+      {
+      if( ++sample[d] < axisSamples[d] )
+        {
+        done = false;
+        break;
+        }
+      sample[d] = 0;
+      }
+    }
+  return true;
+}
+
+template <class TPixel, unsigned int NDimensions>
+void
+VectorImageResampleFilter<TPixel, NDimensions>
+::ThreadedGenerateData( const OutputImageRegionType &outputRegionForThread,
+                        ThreadIdType threadId )
+{
+  InputImageConstPointer input = this->GetInput();
+  OutputImagePointer     output = this->GetOutput();
+  const unsigned int     numberOfComponents = input->GetNumberOfComponentsPerPixel();
+
+  const PixelType *inputBuffer = input->GetBufferPointer();
+  const double *   coefficientBuffer = m_Coefficients.IsNotNull() ? m_Coefficients->GetBufferPointer() : NULL;
+  PixelType *      outputBuffer = output->GetBufferPointer();
+
+  const double minOutputValue = static_cast<double>( NumericTraits<PixelType>::NonpositiveMin() );
+  const double maxOutputValue = static_cast<double>( NumericTraits<PixelType>::max() );
+
+  std::vector<OffsetValueType> offsets;
+  std::vector<double>          weights;
+  std::vector<double>          value( numberOfComponents );
+
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  PointType                            outputPoint;
+  PointType                            inputPoint;
+  ContinuousIndex<double, NDimensions> inputIndex;
+  typedef ImageRegionIteratorWithIndex<OutputImageType> OutputIteratorType;
+  OutputIteratorType outIt( output, outputRegionForThread );
+  for( outIt.GoToBegin(); !outIt.IsAtEnd(); ++outIt )
+    {
+    const IndexType & outputIndex = outIt.GetIndex();
+    PixelType *       outputPixel = outputBuffer + output->ComputeOffset( outputIndex ) * numberOfComponents;
+
+    // Geometry is computed once for all the components
+    output->TransformIndexToPhysicalPoint( outputIndex, outputPoint );
+    inputPoint = m_Transform->TransformPoint( outputPoint );
+    input->TransformPhysicalPointToContinuousIndex( inputPoint, inputIndex );
+    if( !this->ComputeStencil( inputIndex, offsets, weights ) )
+      {
+      for( unsigned int c = 0; c < numberOfComponents; c++ )
+        {
+        outputPixel[c] = m_DefaultPixelValue;
+        }
+      progress.CompletedPixel();
+      continue;
+      }
+
+    std::fill( value.begin(), value.end(), 0.0 );
+    const size_t numberOfSamples = offsets.size();
+    if( coefficientBuffer )
+      {
+      for( size_t s = 0; s < numberOfSamples; s++ )
+        {
+        const double   weight = weights[s];
+        const double * samplePixel = coefficientBuffer + offsets[s] * numberOfComponents;
+        for( unsigned int c = 0; c < numberOfComponents; c++ )
+          {
+          value[c] += weight * samplePixel[c];
+          }
+        }
+      }
+    else
+      {
+      for( size_t s = 0; s < numberOfSamples; s++ )
+        {
+        const double      weight = weights[s];
+        const PixelType * samplePixel = inputBuffer + offsets[s] * numberOfComponents;
+        for( unsigned int c = 0; c < numberOfComponents; c++ )
+          {
+          value[c] += weight * static_cast<double>( samplePixel[c] );
+          }
+        }
+      }
+
+    // same bounds checking as itk::ResampleImageFilter
+    for( unsigned int c = 0; c < numberOfComponents; c++ )
+      {
+      double v = value[c];
+      if( v < minOutputValue )
+        {
+        v = minOutputValue;
+        }
+      else if( v > maxOutputValue )
+        {
+        v = maxOutputValue;
+        }
+      outputPixel[c] = static_cast<PixelType>( v );
+      }
+    progress.CompletedPixel();
+    }
+}
+
+/**
+ * Inform pipeline of required output region
+ */
+template <class TPixel, unsigned int NDimensions>
+void
+VectorImageResampleFilter<TPixel, NDimensions>
+::GenerateOutputInformation()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateOutputInformation();
+  OutputImagePointer outputPtr = this->GetOutput();
+  if( !outputPtr )
+    {
+    return;
+    }
+  typename OutputImageType::RegionType outputRegion;
+  outputRegion.SetSize( m_Size );
+  outputPtr->SetLargestPossibleRegion( outputRegion );
+  outputPtr->SetSpacing( m_OutputSpacing );
+  outputPtr->SetOrigin( m_OutputOrigin );
+  outputPtr->SetDirection( m_OutputDirection );
+  if( this->GetInput() )
+    {
+    outputPtr->SetNumberOfComponentsPerPixel( this->GetInput()->GetNumberOfComponentsPerPixel() );
+    }
+}
+
+/**
+ * Inform pipeline of necessary input image region
+ *
+ * Determining the actual input region is non-trivial, especially
+ * when we cannot assume anything about the transform being used.
+ * So we do the easy thing and request the entire input image.
+ */
+template <class TPixel, unsigned int NDimensions>
+void
+VectorImageResampleFilter<TPixel, NDimensions>
+::GenerateInputRequestedRegion()
+{
+  // call the superclass's implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  if( !this->GetInput() )
+    {
+    return;
+    }
+  typename InputImageType::Pointer inputPtr = const_cast<InputImageType *>( this->GetInput() );
+  inputPtr->SetRequestedRegionToLargestPossibleRegion();
+}
+
+template <class TPixel, unsigned int NDimensions>
+void
+VectorImageResampleFilter<TPixel, NDimensions>
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "Interpolation: " << m_Interpolation << std::endl;
+  os << indent << "WindowFunction: " << m_WindowFunction << std::endl;
+  os << indent << "WindowRadius: " << m_WindowRadius << std::endl;
+  os << indent << "SplineOrder: " << m_SplineOrder << std::endl;
+  os << indent << "DefaultPixelValue: "
+     << static_cast<typename NumericTraits<PixelType>::PrintType>( m_DefaultPixelValue ) << std::endl;
+  os << indent << "Size: " << m_Size << std::endl;
+  os << indent << "OutputSpacing: " << m_OutputSpacing << std::endl;
+  os << indent << "OutputOrigin: " << m_OutputOrigin << std::endl;
+  os << indent << "OutputDirection: " << m_OutputDirection << std::endl;
+  os << indent << "Transform: " << m_Transform.GetPointer() << std::endl;
+}
+
+} // end namespace itk
+#endif
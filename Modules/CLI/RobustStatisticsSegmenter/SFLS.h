@@ -2,18 +2,90 @@
 #define SFLS_h_
 
 // std
-#include <list>
+#include <cstddef>
+#include <vector>
 
 // itk
 #include "vnl/vnl_vector_fixed.h"
 
+/*----------------------------------------------------------------------
+  One layer of the sparse field.
+
+  Nodes are stored contiguously, so no node is allocated or freed
+  during the evolution. Nodes leaving a layer are removed by compacting
+  the remaining ones in place while the layer is scanned (see
+  CSFLSSegmentor3D::oneStepLevelSetEvolution), which keeps the nodes in
+  the same order as the std::list the layers used to be.  */
+class CSFLSNodeLayer
+{
+public:
+  typedef vnl_vector_fixed<int, 3>              NodeType;
+  typedef std::vector<NodeType>::iterator       iterator;
+  typedef std::vector<NodeType>::const_iterator const_iterator;
+
+  iterator begin()
+  {
+    return m_nodes.begin();
+  }
+  iterator end()
+  {
+    return m_nodes.end();
+  }
+  const_iterator begin() const
+  {
+    return m_nodes.begin();
+  }
+  const_iterator end() const
+  {
+    return m_nodes.end();
+  }
+
+  std::size_t size() const
+  {
+    return m_nodes.size();
+  }
+  bool empty() const
+  {
+    return m_nodes.empty();
+  }
+  void clear()
+  {
+    // keep the capacity, the layer will be filled again
+    m_nodes.clear();
+  }
+  void reserve(std::size_t n)
+  {
+    m_nodes.reserve(n);
+  }
+  void resize(std::size_t n)
+  {
+    m_nodes.resize(n);
+  }
+
+  void push_back(const NodeType& node)
+  {
+    m_nodes.push_back(node);
+  }
+
+  NodeType& operator[](std::size_t i)
+  {
+    return m_nodes[i];
+  }
+  const NodeType& operator[](std::size_t i) const
+  {
+    return m_nodes[i];
+  }
+private:
+  std::vector<NodeType> m_nodes;
+};
+
 class CSFLS
 {
 public:
   typedef CSFLS Self;
 
-  typedef vnl_vector_fixed<int, 3> NodeType;
-  typedef std::list<NodeType>      CSFLSLayer;
+  typedef CSFLSNodeLayer::NodeType NodeType;
+  typedef CSFLSNodeLayer           CSFLSLayer;
 
   // typedef boost::shared_ptr< Self > Pointer;
 
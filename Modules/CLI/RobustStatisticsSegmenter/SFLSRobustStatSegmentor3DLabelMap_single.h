@@ -3,6 +3,8 @@
 
 #include "SFLSSegmentor3D.h"
 
+#include "itkMultiThreader.h"
+
 #include <list>
 #include <vector>
 
@@ -128,6 +130,25 @@ protected:
 
   double kernelEvaluationUsingPDF(const std::vector<double>& newFeature);
 
+  /* Curvature and robust statistics force at the nodes [begin, end) of
+     the zero layer. Called from several threads by computeForce. */
+  void computeForceOnZeroLayer(long begin, long end, double* kappaOnZeroLS, double* cvForce);
+
+  struct ComputeForceThreadStruct
+    {
+    Self*   Segmentor;
+    double* Kappa;
+    double* CvForce;
+    };
+
+  static ITK_THREAD_RETURN_TYPE computeForceThreaderCallback(void* arg);
+
+  itk::MultiThreader::Pointer m_forceThreader;
+  long                        m_maximumNumberOfForceThreads;
+
+  // buffers of computeForce, kept to reuse their memory
+  std::vector<double> m_kappaOnZeroLS;
+  std::vector<double> m_cvForce;
 };
 
 #include "SFLSRobustStatSegmentor3DLabelMap_single.txx"
@@ -15,6 +15,7 @@
 
 #include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkImageRegionConstIterator.h"
+#include "itkRealTimeClock.h"
 
 /* ============================================================   */
 template <typename TPixel>
@@ -33,6 +34,10 @@ CSFLSRobustStatSegmentor3DLabelMap<TPixel>
   m_inputImageIntensityMin = 0;
   m_inputImageIntensityMax = 0;
 
+  // computeForce runs at every iteration, the threader is created once
+  m_forceThreader = itk::MultiThreader::New();
+  m_maximumNumberOfForceThreads = m_forceThreader->GetNumberOfThreads();
+
   return;
 }
 
@@ -75,52 +80,86 @@ CSFLSRobustStatSegmentor3DLabelMap<TPixel>
 
 /* ============================================================  */
 template <typename TPixel>
-void
+ITK_THREAD_RETURN_TYPE
 CSFLSRobustStatSegmentor3DLabelMap<TPixel>
-::computeForce()
+::computeForceThreaderCallback(void* arg)
 {
-  double fmax = std::numeric_limits<double>::min();
-  double kappaMax = std::numeric_limits<double>::min();
+  typedef itk::MultiThreader::ThreadInfoStruct ThreadInfoType;
+  ThreadInfoType*           info = static_cast<ThreadInfoType*>(arg);
+  ComputeForceThreadStruct* str = static_cast<ComputeForceThreadStruct*>(info->UserData);
 
-  long    n = this->m_lz.size();
-  double* kappaOnZeroLS = new double[n];
-  double* cvForce = new double[n];
+  // split the zero layer in contiguous chunks, one per thread
+  long n = str->Segmentor->m_lz.size();
+  long chunk = n / info->NumberOfThreads + 1;
+  long begin = chunk * info->ThreadID;
+  long end = std::min(begin + chunk, n);
 
-  std::vector<typename CSFLSLayer::iterator> m_lzIterVct( n );
-    {
-    long iiizzz = 0;
-    for( typename CSFLSLayer::iterator itz = this->m_lz.begin(); itz != this->m_lz.end(); ++itz )
-      {
-      m_lzIterVct[iiizzz++] = itz;
-      }
-    }
+  str->Segmentor->computeForceOnZeroLayer(begin, end, str->Kappa, str->CvForce);
 
-// #ifndef NDEBUG
-//     std::ofstream ff("/tmp/force.txt");
-// #endif
-  for( long i = 0; i < n; ++i )
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+/* ============================================================  */
+template <typename TPixel>
+void
+CSFLSRobustStatSegmentor3DLabelMap<TPixel>
+::computeForceOnZeroLayer(long begin, long end, double* kappaOnZeroLS, double* cvForce)
+{
+  std::vector<double> f(m_numberOfFeature);
+  for( long i = begin; i < end; ++i )
     {
-    typename CSFLSLayer::iterator itz = m_lzIterVct[i];
+    const NodeType& node = this->m_lz[i];
 
-    long ix = (*itz)[0];
-    long iy = (*itz)[1];
-    long iz = (*itz)[2];
+    long ix = node[0];
+    long iy = node[1];
+    long iz = node[2];
 
     TIndex idx = {{ix, iy, iz}};
 
     kappaOnZeroLS[i] = this->computeKappa(ix, iy, iz);
 
-    std::vector<double> f(m_numberOfFeature);
-
+    /* The nodes of the zero layer are distinct voxels, so each thread
+       only fills the feature cache at its own voxels. */
     computeFeatureAt(idx, f);
 
     // double a = -kernelEvaluation(f);
-    double a = -kernelEvaluationUsingPDF(f);
+    cvForce[i] = -kernelEvaluationUsingPDF(f);
+    }
 
-    fmax = fmax > fabs(a) ? fmax : fabs(a);
-    kappaMax = kappaMax > fabs(kappaOnZeroLS[i]) ? kappaMax : fabs(kappaOnZeroLS[i]);
+  return;
+}
+
+/* ============================================================  */
+template <typename TPixel>
+void
+CSFLSRobustStatSegmentor3DLabelMap<TPixel>
+::computeForce()
+{
+  double fmax = std::numeric_limits<double>::min();
+  double kappaMax = std::numeric_limits<double>::min();
+
+  long n = this->m_lz.size();
+
+  this->m_kappaOnZeroLS.resize(n);
+  this->m_cvForce.resize(n);
+
+  if( n > 0 )
+    {
+    ComputeForceThreadStruct str;
+    str.Segmentor = this;
+    str.Kappa = &(this->m_kappaOnZeroLS[0]);
+    str.CvForce = &(this->m_cvForce[0]);
 
-    cvForce[i] = a;
+    // no more threads than nodes, small zero layers are common
+    m_forceThreader->SetNumberOfThreads(std::max(1L, std::min(m_maximumNumberOfForceThreads, n) ) );
+    m_forceThreader->SetSingleMethod(computeForceThreaderCallback, &str);
+    m_forceThreader->SingleMethodExecute();
+    }
+
+  for( long i = 0; i < n; ++i )
+    {
+    fmax = fmax > fabs(m_cvForce[i]) ? fmax : fabs(m_cvForce[i]);
+    kappaMax = kappaMax > fabs(m_kappaOnZeroLS[i]) ? kappaMax : fabs(m_kappaOnZeroLS[i]);
     }
 
   // std::cout<<"fmax = "<<fmax<<std::endl;
@@ -129,12 +168,9 @@ CSFLSRobustStatSegmentor3DLabelMap<TPixel>
   for( long i = 0; i < n; ++i )
     {
     // this->m_force.push_back(cvForce[i]/(fmax + 1e-10) +  (this->m_curvatureWeight)*kappaOnZeroLS[i]);
-    this->m_force[i] = (1 - (this->m_curvatureWeight) ) * cvForce[i] / (fmax + 1e-10) \
-      +  (this->m_curvatureWeight) * kappaOnZeroLS[i] / (kappaMax + 1e-10);
+    this->m_force[i] = (1 - (this->m_curvatureWeight) ) * m_cvForce[i] / (fmax + 1e-10) \
+      +  (this->m_curvatureWeight) * m_kappaOnZeroLS[i] / (kappaMax + 1e-10);
     }
-
-  delete[] kappaOnZeroLS;
-  delete[] cvForce;
 }
 
 /* ============================================================  */
@@ -308,7 +344,10 @@ void
 CSFLSRobustStatSegmentor3DLabelMap<TPixel>
 ::doSegmenation()
 {
-  double startingTime = clock();
+  /* wall clock time: the force is computed on several threads, so
+     clock() would count the time of all of them */
+  itk::RealTimeClock::Pointer timer = itk::RealTimeClock::New();
+  double                      startingTime = timer->GetTimeInSeconds();
 
   getThingsReady();
 
@@ -396,7 +435,7 @@ CSFLSRobustStatSegmentor3DLabelMap<TPixel>
     /*If the inside physical volume exceed expected volume, stop
       ----------------------------------------------------------------------*/
 
-    double ellapsedTime = (clock() - startingTime) / static_cast<double>(CLOCKS_PER_SEC);
+    double ellapsedTime = timer->GetTimeInSeconds() - startingTime;
     if( ellapsedTime > (this->m_maxRunningTime) )
       {
       std::ofstream f("/tmp/o.txt");
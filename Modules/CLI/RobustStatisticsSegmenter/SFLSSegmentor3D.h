@@ -147,6 +147,28 @@ protected:
   CSFLSLayer m_lIn2out;
   CSFLSLayer m_lOut2in;
 
+  /*----------------------------------------------------------------------
+    The 'changing status' lists of oneStepLevelSetEvolution. They are
+    members only to reuse their memory from one iteration to the next. */
+  CSFLSLayer m_sz;
+  CSFLSLayer m_sn1;
+  CSFLSLayer m_sp1;
+  CSFLSLayer m_sn2;
+  CSFLSLayer m_sp2;
+
+  /*----------------------------------------------------------------------
+    Buffers of mp_label (the status of each voxel: -3..3, 0 being the
+    zero layer) and mp_phi. The images start at (0, 0, 0), so the
+    neighbors of a voxel are accessed by adding 1, m_nx or m_nx*m_ny to
+    its offset. Valid after initializeLabel and initializePhi.  */
+  char*  m_labelBuffer;
+  float* m_phiBuffer;
+
+  inline long voxelOffset(long ix, long iy, long iz) const
+  {
+    return ix + m_nx * (iy + m_ny * iz);
+  }
+
   void updateInsideVoxelCount();
 
   inline bool doubleEqual(double a, double b, double eps = 1e-10)
@@ -48,6 +48,9 @@ CSFLSSegmentor3D<TPixel>
   m_keepZeroLayerHistory = false;
 
   m_done = false;
+
+  m_labelBuffer = NULL;
+  m_phiBuffer = NULL;
 }
 
 /* ============================================================
@@ -211,129 +214,42 @@ CSFLSSegmentor3D<TPixel>
    * go through all nbhd who is in the layer of label = mylevel+1
    * pick the LARGEST phi.
    */
-  TIndex idx = {{ix, iy, iz}};
-  char   mylevel = mp_label->GetPixel(idx);
+  const long offset = voxelOffset(ix, iy, iz);
+  const char mylevel = m_labelBuffer[offset];
+
+  const long nbhdOffset[6] = {1, -1, m_nx, -m_nx, m_nx * m_ny, -m_nx * m_ny};
+  const bool nbhdInside[6] = {ix + 1 < m_nx, ix - 1 >= 0, iy + 1 < m_ny, iy - 1 >= 0, iz + 1 < m_nz, iz - 1 >= 0};
 
-  //  char mylevel = mp_label->get(ix, iy, iz);
   bool foundNbhd = false;
 
   if( mylevel > 0 )
     {
     // find the SMALLEST phi
     thePhi = 10000;
-
-    TIndex idx1 = {{ix + 1, iy, iz}};
-    if( (ix + 1 < m_nx) && (mp_label->GetPixel(idx1) == mylevel - 1) )
-      {
-      double itsPhi = mp_phi->GetPixel(idx1);
-      thePhi = thePhi < itsPhi ? thePhi : itsPhi;
-
-      foundNbhd = true;
-      }
-
-    TIndex idx2 = {{ix - 1, iy, iz}};
-    if( (ix - 1 >= 0 ) && (mp_label->GetPixel(idx2) == mylevel - 1) )
-      {
-      double itsPhi = mp_phi->GetPixel(idx2);
-      thePhi = thePhi < itsPhi ? thePhi : itsPhi;
-
-      foundNbhd = true;
-      }
-
-    TIndex idx3 = {{ix, iy + 1, iz}};
-    if( (iy + 1 < m_ny) && (mp_label->GetPixel(idx3) == mylevel - 1) )
-      {
-      double itsPhi = mp_phi->GetPixel(idx3);
-      thePhi = thePhi < itsPhi ? thePhi : itsPhi;
-
-      foundNbhd = true;
-      }
-
-    TIndex idx4 = {{ix, iy - 1, iz}};
-    if( ( (iy - 1) >= 0 ) && (mp_label->GetPixel(idx4) == mylevel - 1) )
-      {
-      double itsPhi = mp_phi->GetPixel(idx4);
-      thePhi = thePhi < itsPhi ? thePhi : itsPhi;
-
-      foundNbhd = true;
-      }
-
-    TIndex idx5 = {{ix, iy, iz + 1}};
-    if( (iz + 1 < m_nz) && (mp_label->GetPixel(idx5) == mylevel - 1) )
-      {
-      double itsPhi = mp_phi->GetPixel(idx5);
-      thePhi = thePhi < itsPhi ? thePhi : itsPhi;
-
-      foundNbhd = true;
-      }
-
-    TIndex idx6 = {{ix, iy, iz - 1}};
-    if( ( (iz - 1) >= 0 ) && (mp_label->GetPixel(idx6) == mylevel - 1) )
+    for( int i = 0; i < 6; ++i )
       {
-      double itsPhi = mp_phi->GetPixel(idx6);
-      thePhi = thePhi < itsPhi ? thePhi : itsPhi;
+      if( nbhdInside[i] && m_labelBuffer[offset + nbhdOffset[i]] == mylevel - 1 )
+        {
+        double itsPhi = m_phiBuffer[offset + nbhdOffset[i]];
+        thePhi = thePhi < itsPhi ? thePhi : itsPhi;
 
-      foundNbhd = true;
+        foundNbhd = true;
+        }
       }
-
     }
   else
     {
     // find the LARGEST phi
     thePhi = -10000;
-
-    TIndex idx1 = {{ix + 1, iy, iz}};
-    if( (ix + 1 < m_nx) && (mp_label->GetPixel(idx1) == mylevel + 1) )
-      {
-      double itsPhi = mp_phi->GetPixel(idx1);
-      thePhi = thePhi > itsPhi ? thePhi : itsPhi;
-
-      foundNbhd = true;
-      }
-
-    TIndex idx2 = {{ix - 1, iy, iz}};
-    if( (ix - 1 >= 0  ) && (mp_label->GetPixel(idx2) == mylevel + 1) )
-      {
-      double itsPhi = mp_phi->GetPixel(idx2);
-      thePhi = thePhi > itsPhi ? thePhi : itsPhi;
-
-      foundNbhd = true;
-      }
-
-    TIndex idx3 = {{ix, iy + 1, iz}};
-    if( (iy + 1 < m_ny) && (mp_label->GetPixel(idx3) == mylevel + 1) )
-      {
-      double itsPhi = mp_phi->GetPixel(idx3);
-      thePhi = thePhi > itsPhi ? thePhi : itsPhi;
-
-      foundNbhd = true;
-      }
-
-    TIndex idx4 = {{ix, iy - 1, iz}};
-    if( ( (iy - 1) >= 0 ) && (mp_label->GetPixel(idx4) == mylevel + 1) )
-      {
-      double itsPhi = mp_phi->GetPixel(idx4);
-      thePhi = thePhi > itsPhi ? thePhi : itsPhi;
-
-      foundNbhd = true;
-      }
-
-    TIndex idx5 = {{ix, iy, iz + 1}};
-    if( (iz + 1 < m_nz) && (mp_label->GetPixel(idx5) == mylevel + 1) )
+    for( int i = 0; i < 6; ++i )
       {
-      double itsPhi = mp_phi->GetPixel(idx5);
-      thePhi = thePhi > itsPhi ? thePhi : itsPhi;
-
-      foundNbhd = true;
-      }
-
-    TIndex idx6 = {{ix, iy, iz - 1}};
-    if( ( (iz - 1) >= 0 ) && (mp_label->GetPixel(idx6) == mylevel + 1) )
-      {
-      double itsPhi = mp_phi->GetPixel(idx6);
-      thePhi = thePhi > itsPhi ? thePhi : itsPhi;
+      if( nbhdInside[i] && m_labelBuffer[offset + nbhdOffset[i]] == mylevel + 1 )
+        {
+        double itsPhi = m_phiBuffer[offset + nbhdOffset[i]];
+        thePhi = thePhi > itsPhi ? thePhi : itsPhi;
 
-      foundNbhd = true;
+        foundNbhd = true;
+        }
       }
     }
 
@@ -406,47 +322,44 @@ void
 CSFLSSegmentor3D<TPixel>
 ::oneStepLevelSetEvolution()
 {
-  // create 'changing status' lists
-  CSFLSLayer Sz;
-  CSFLSLayer Sn1;
-  CSFLSLayer Sp1;
-  CSFLSLayer Sn2;
-  CSFLSLayer Sp2;
+  // 'changing status' lists
+  CSFLSLayer& Sz = m_sz;
+  CSFLSLayer& Sn1 = m_sn1;
+  CSFLSLayer& Sp1 = m_sp1;
+  CSFLSLayer& Sn2 = m_sn2;
+  CSFLSLayer& Sp2 = m_sp2;
+
+  Sz.clear();
+  Sn1.clear();
+  Sp1.clear();
+  Sn2.clear();
+  Sp2.clear();
 
   m_lIn2out.clear();
   m_lOut2in.clear();
 
+  const long sliceStride = m_nx * m_ny;
+
   /*--------------------------------------------------
     1. add F to phi(Lz), create Sn1 & Sp1
     scan Lz values [-2.5 -1.5)[-1.5 -.5)[-.5 .5](.5 1.5](1.5 2.5]
     ========                */
     {
-    // std::list<double>::const_iterator itf = m_force.begin();
-
-    long                              nz = m_lz.size();
-    std::vector<CSFLSLayer::iterator> m_lzIterVct( nz );
+    /* m_force[i] is the force at the i-th node of Lz. The nodes
+       staying in Lz are compacted in place, keeping their order. */
+    long nz = m_lz.size();
+    long nKeep = 0;
+    for( long itf = 0; itf < nz; ++itf )
       {
-      long iiizzz = 0;
-      for( CSFLSLayer::iterator itz = m_lz.begin(); itz != m_lz.end(); ++itz )
-        {
-        m_lzIterVct[iiizzz++] = itz;
-        }
-      }
-    //    for (CSFLSLayer::iterator itz = m_lz.begin(); itz != m_lz.end(); ++itf)
-    // #pragma omp parallel for
-    for( long iiizzz = 0; iiizzz < nz; ++iiizzz )
-      {
-      long itf = iiizzz;
-
-      CSFLSLayer::iterator itz = m_lzIterVct[iiizzz];
+      const NodeType node = m_lz[itf];
 
-      long ix = (*itz)[0];
-      long iy = (*itz)[1];
-      long iz = (*itz)[2];
+      long ix = node[0];
+      long iy = node[1];
+      long iz = node[2];
 
-      TIndex idx = {{ix, iy, iz}};
+      const long offset = voxelOffset(ix, iy, iz);
 
-      double phi_old = mp_phi->GetPixel(idx);
+      double phi_old = m_phiBuffer[offset];
       double phi_new = phi_old + m_force[itf];
 
       /*----------------------------------------------------------------------
@@ -454,255 +367,247 @@ CSFLSSegmentor3D<TPixel>
         energy fnal computation. */
       if( phi_old <= 0 && phi_new > 0 )
         {
-        m_lIn2out.push_back(NodeType(ix, iy, iz) );
+        m_lIn2out.push_back(node);
         }
 
       if( phi_old > 0  && phi_new <= 0 )
         {
-        m_lOut2in.push_back(NodeType(ix, iy, iz) );
+        m_lOut2in.push_back(node);
         }
 
-      //           // DEBUG
-      //           if (phi_new > 3.1 || phi_new < -3.1)
-      //             {
-      //               std::cout<<"phi_old = "<<phi_old<<std::endl;
-      //               std::cout<<"its lbl = "<<(int)mp_label->get(ix, iy)<<std::endl;
-
-      //               std::cerr<<"phi_new > 3.1 || phi_new < -3.1\n";
-      //               raise(SIGABRT);
-      //             }
-
-      mp_phi->SetPixel(idx, phi_new);
+      m_phiBuffer[offset] = phi_new;
 
       if( phi_new > 0.5 )
         {
-        Sp1.push_back(*itz);
-        itz = m_lz.erase(itz);
+        Sp1.push_back(node);
         }
       else if( phi_new < -0.5 )
         {
-        Sn1.push_back(*itz);
-        itz = m_lz.erase(itz);
+        Sn1.push_back(node);
         }
       else
         {
-        ++itz;
+        m_lz[nKeep++] = node;
         }
       /*--------------------------------------------------
         NOTE, mp_label are (should) NOT update here. They should
         be updated with Sz, Sn/p's
         --------------------------------------------------*/
       }
+    m_lz.resize(nKeep);
     }
 
-  //     // debug
-  //     labelsCoherentCheck1();
   /*--------------------------------------------------
     2. update Ln1,Lp1,Lp2,Lp2, ****in that order****
 
     2.1 scan Ln1 values [-2.5 -1.5)[-1.5 -.5)[-.5 .5](.5 1.5](1.5 2.5]
     ==========                     */
-  for( CSFLSLayer::iterator itn1 = m_ln1.begin(); itn1 != m_ln1.end(); )
+  /* Nodes leaving a layer are dropped by compacting the remaining
+     ones in place, as for Lz: the layers keep their order, which the
+     S-lists and the layers built from them depend on. */
     {
-    long ix = (*itn1)[0];
-    long iy = (*itn1)[1];
-    long iz = (*itn1)[2];
+    long nn1 = m_ln1.size();
+    long nKeep = 0;
+    for( long itn1 = 0; itn1 < nn1; ++itn1 )
+      {
+      const NodeType node = m_ln1[itn1];
 
-    TIndex idx = {{ix, iy, iz}};
+      long ix = node[0];
+      long iy = node[1];
+      long iz = node[2];
 
-    double thePhi;
-    bool   found = getPhiOfTheNbhdWhoIsClosestToZeroLevelInLayerCloserToZeroLevel(ix, iy, iz, thePhi);
+      const long offset = voxelOffset(ix, iy, iz);
 
-    if( found )
-      {
-      double phi_new = thePhi - 1;
-      mp_phi->SetPixel(idx, phi_new);
+      double thePhi;
+      bool   found = getPhiOfTheNbhdWhoIsClosestToZeroLevelInLayerCloserToZeroLevel(ix, iy, iz, thePhi);
 
-      if( phi_new >= -0.5 )
+      if( found )
         {
-        Sz.push_back(*itn1);
-        itn1 = m_ln1.erase(itn1);
-        }
-      else if( phi_new < -1.5 )
-        {
-        Sn2.push_back(*itn1);
-        itn1 = m_ln1.erase(itn1);
+        double phi_new = thePhi - 1;
+        m_phiBuffer[offset] = phi_new;
+
+        if( phi_new >= -0.5 )
+          {
+          Sz.push_back(node);
+          }
+        else if( phi_new < -1.5 )
+          {
+          Sn2.push_back(node);
+          }
+        else
+          {
+          m_ln1[nKeep++] = node;
+          }
         }
       else
         {
-        ++itn1;
-        }
-      }
-    else
-      {
-      /*--------------------------------------------------
-        No nbhd in inner (closer to zero contour) layer, so
-        should go to Sn2. And the phi shold be further -1
-      */
-      Sn2.push_back(*itn1);
-      itn1 = m_ln1.erase(itn1);
+        /*--------------------------------------------------
+          No nbhd in inner (closer to zero contour) layer, so
+          should go to Sn2. And the phi shold be further -1
+        */
+        Sn2.push_back(node);
 
-      mp_phi->SetPixel(idx, mp_phi->GetPixel(idx) - 1);
+        m_phiBuffer[offset] -= 1;
+        }
       }
+    m_ln1.resize(nKeep);
     }
 
-  //     // debug
-  //     labelsCoherentCheck1();
   /*--------------------------------------------------
     2.2 scan Lp1 values [-2.5 -1.5)[-1.5 -.5)[-.5 .5](.5 1.5](1.5 2.5]
     ========          */
-  for( CSFLSLayer::iterator itp1 = m_lp1.begin(); itp1 != m_lp1.end(); )
     {
-    long ix = (*itp1)[0];
-    long iy = (*itp1)[1];
-    long iz = (*itp1)[2];
+    long np1 = m_lp1.size();
+    long nKeep = 0;
+    for( long itp1 = 0; itp1 < np1; ++itp1 )
+      {
+      const NodeType node = m_lp1[itp1];
 
-    TIndex idx = {{ix, iy, iz}};
+      long ix = node[0];
+      long iy = node[1];
+      long iz = node[2];
 
-    double thePhi;
-    bool   found = getPhiOfTheNbhdWhoIsClosestToZeroLevelInLayerCloserToZeroLevel(ix, iy, iz, thePhi);
+      const long offset = voxelOffset(ix, iy, iz);
 
-    if( found )
-      {
-      double phi_new = thePhi + 1;
-      mp_phi->SetPixel(idx, phi_new);
+      double thePhi;
+      bool   found = getPhiOfTheNbhdWhoIsClosestToZeroLevelInLayerCloserToZeroLevel(ix, iy, iz, thePhi);
 
-      if( phi_new <= 0.5 )
-        {
-        Sz.push_back(*itp1);
-        itp1 = m_lp1.erase(itp1);
-        }
-      else if( phi_new > 1.5 )
+      if( found )
         {
-        Sp2.push_back(*itp1);
-        itp1 = m_lp1.erase(itp1);
+        double phi_new = thePhi + 1;
+        m_phiBuffer[offset] = phi_new;
+
+        if( phi_new <= 0.5 )
+          {
+          Sz.push_back(node);
+          }
+        else if( phi_new > 1.5 )
+          {
+          Sp2.push_back(node);
+          }
+        else
+          {
+          m_lp1[nKeep++] = node;
+          }
         }
       else
         {
-        ++itp1;
-        }
-      }
-    else
-      {
-      /*--------------------------------------------------
-        No nbhd in inner (closer to zero contour) layer, so
-        should go to Sp2. And the phi shold be further +1
-      */
+        /*--------------------------------------------------
+          No nbhd in inner (closer to zero contour) layer, so
+          should go to Sp2. And the phi shold be further +1
+        */
 
-      Sp2.push_back(*itp1);
-      itp1 = m_lp1.erase(itp1);
+        Sp2.push_back(node);
 
-      mp_phi->SetPixel(idx, mp_phi->GetPixel(idx) + 1);
+        m_phiBuffer[offset] += 1;
+        }
       }
+    m_lp1.resize(nKeep);
     }
 
-  //     // debug
-  //     labelsCoherentCheck1();
   /*--------------------------------------------------
     2.3 scan Ln2 values [-2.5 -1.5)[-1.5 -.5)[-.5 .5](.5 1.5](1.5 2.5]
     ==========                                      */
-  for( CSFLSLayer::iterator itn2 = m_ln2.begin(); itn2 != m_ln2.end(); )
     {
-    long ix = (*itn2)[0];
-    long iy = (*itn2)[1];
-    long iz = (*itn2)[2];
+    long nn2 = m_ln2.size();
+    long nKeep = 0;
+    for( long itn2 = 0; itn2 < nn2; ++itn2 )
+      {
+      const NodeType node = m_ln2[itn2];
 
-    TIndex idx = {{ix, iy, iz}};
+      long ix = node[0];
+      long iy = node[1];
+      long iz = node[2];
 
-    double thePhi;
-    bool   found = getPhiOfTheNbhdWhoIsClosestToZeroLevelInLayerCloserToZeroLevel(ix, iy, iz, thePhi);
+      const long offset = voxelOffset(ix, iy, iz);
 
-    if( found )
-      {
-      double phi_new = thePhi - 1;
-      mp_phi->SetPixel(idx, phi_new);
+      double thePhi;
+      bool   found = getPhiOfTheNbhdWhoIsClosestToZeroLevelInLayerCloserToZeroLevel(ix, iy, iz, thePhi);
 
-      if( phi_new >= -1.5 )
+      if( found )
         {
-        Sn1.push_back(*itn2);
-        itn2 = m_ln2.erase(itn2);
-        }
-      else if( phi_new < -2.5 )
-        {
-        itn2 = m_ln2.erase(itn2);
-        mp_phi->SetPixel(idx, -3);
-        mp_label->SetPixel(idx, -3);
+        double phi_new = thePhi - 1;
+        m_phiBuffer[offset] = phi_new;
+
+        if( phi_new >= -1.5 )
+          {
+          Sn1.push_back(node);
+          }
+        else if( phi_new < -2.5 )
+          {
+          m_phiBuffer[offset] = -3;
+          m_labelBuffer[offset] = -3;
+          }
+        else
+          {
+          m_ln2[nKeep++] = node;
+          }
         }
       else
         {
-        ++itn2;
+        m_phiBuffer[offset] = -3;
+        m_labelBuffer[offset] = -3;
         }
       }
-    else
-      {
-      itn2 = m_ln2.erase(itn2);
-      mp_phi->SetPixel(idx, -3);
-      mp_label->SetPixel(idx, -3);
-      }
+    m_ln2.resize(nKeep);
     }
 
-  //     // debug
-  //     labelsCoherentCheck1();
   /*--------------------------------------------------
     2.4 scan Lp2 values [-2.5 -1.5)[-1.5 -.5)[-.5 .5](.5 1.5](1.5 2.5]
     ========= */
-  for( CSFLSLayer::iterator itp2 = m_lp2.begin(); itp2 != m_lp2.end(); )
     {
-    long   ix = (*itp2)[0];
-    long   iy = (*itp2)[1];
-    long   iz = (*itp2)[2];
-    TIndex idx = {{ix, iy, iz}};
+    long np2 = m_lp2.size();
+    long nKeep = 0;
+    for( long itp2 = 0; itp2 < np2; ++itp2 )
+      {
+      const NodeType node = m_lp2[itp2];
 
-    double thePhi;
-    bool   found = getPhiOfTheNbhdWhoIsClosestToZeroLevelInLayerCloserToZeroLevel(ix, iy, iz, thePhi);
+      long ix = node[0];
+      long iy = node[1];
+      long iz = node[2];
 
-    if( found )
-      {
-      double phi_new = thePhi + 1;
-      mp_phi->SetPixel(idx, phi_new);
+      const long offset = voxelOffset(ix, iy, iz);
 
-      if( phi_new <= 1.5 )
-        {
-        Sp1.push_back(*itp2);
-        itp2 = m_lp2.erase(itp2);
-        }
-      else if( phi_new > 2.5 )
+      double thePhi;
+      bool   found = getPhiOfTheNbhdWhoIsClosestToZeroLevelInLayerCloserToZeroLevel(ix, iy, iz, thePhi);
+
+      if( found )
         {
-        itp2 = m_lp2.erase(itp2);
-        mp_phi->SetPixel(idx, 3);
-        mp_label->SetPixel(idx, 3);
+        double phi_new = thePhi + 1;
+        m_phiBuffer[offset] = phi_new;
+
+        if( phi_new <= 1.5 )
+          {
+          Sp1.push_back(node);
+          }
+        else if( phi_new > 2.5 )
+          {
+          m_phiBuffer[offset] = 3;
+          m_labelBuffer[offset] = 3;
+          }
+        else
+          {
+          m_lp2[nKeep++] = node;
+          }
         }
       else
         {
-        ++itp2;
+        m_phiBuffer[offset] = 3;
+        m_labelBuffer[offset] = 3;
         }
       }
-    else
-      {
-      itp2 = m_lp2.erase(itp2);
-      mp_phi->SetPixel(idx, 3);
-      mp_label->SetPixel(idx, 3);
-      }
+    m_lp2.resize(nKeep);
     }
 
-  //     // debug
-  //     labelsCoherentCheck1();
   /*--------------------------------------------------
     3. Deal with S-lists Sz,Sn1,Sp1,Sn2,Sp2
     3.1 Scan Sz */
   for( CSFLSLayer::iterator itSz = Sz.begin(); itSz != Sz.end(); ++itSz )
     {
-    long   ix = (*itSz)[0];
-    long   iy = (*itSz)[1];
-    long   iz = (*itSz)[2];
-    TIndex idx = {{ix, iy, iz}};
-
     m_lz.push_back(*itSz);
-    mp_label->SetPixel(idx, 0);
+    m_labelBuffer[voxelOffset( (*itSz)[0], (*itSz)[1], (*itSz)[2])] = 0;
     }
 
-  //     // debug
-  //     labelsCoherentCheck1();
   /*--------------------------------------------------
     3.2 Scan Sn1     */
   for( CSFLSLayer::iterator itSn1 = Sn1.begin(); itSn1 != Sn1.end(); ++itSn1 )
@@ -711,58 +616,27 @@ CSFLSSegmentor3D<TPixel>
     long iy = (*itSn1)[1];
     long iz = (*itSn1)[2];
 
-    TIndex idx = {{ix, iy, iz}};
+    const long offset = voxelOffset(ix, iy, iz);
 
     m_ln1.push_back(*itSn1);
-    // itSn1 = Sn1.erase(itSn1);
 
-    mp_label->SetPixel(idx, -1);
+    m_labelBuffer[offset] = -1;
 
-    TIndex idx1 = {{ix + 1, iy, iz}};
-    if( (ix + 1 < m_nx) && doubleEqual(mp_phi->GetPixel(idx1), -3.0) )
+    const long     nbhdOffset[6] = {1, -1, m_nx, -m_nx, sliceStride, -sliceStride};
+    const bool     nbhdInside[6] = {ix + 1 < m_nx, ix - 1 >= 0, iy + 1 < m_ny, iy - 1 >= 0, iz + 1 < m_nz, iz - 1 >= 0};
+    const NodeType nbhd[6] = {NodeType(ix + 1, iy, iz), NodeType(ix - 1, iy, iz),
+                              NodeType(ix, iy + 1, iz), NodeType(ix, iy - 1, iz),
+                              NodeType(ix, iy, iz + 1), NodeType(ix, iy, iz - 1)};
+    for( int i = 0; i < 6; ++i )
       {
-      Sn2.push_back(NodeType(ix + 1, iy, iz) );
-      mp_phi->SetPixel(idx1, mp_phi->GetPixel(idx) - 1 );
-      }
-
-    TIndex idx2 = {{ix - 1, iy, iz}};
-    if( (ix - 1 >= 0) && doubleEqual(mp_phi->GetPixel(idx2), -3.0) )
-      {
-      Sn2.push_back(NodeType(ix - 1, iy, iz) );
-      mp_phi->SetPixel(idx2, mp_phi->GetPixel(idx) - 1);
-      }
-
-    TIndex idx3 = {{ix, iy + 1, iz}};
-    if( (iy + 1 < m_ny) && doubleEqual(mp_phi->GetPixel(idx3), -3.0) )
-      {
-      Sn2.push_back(NodeType(ix, iy + 1, iz) );
-      mp_phi->SetPixel(idx3, mp_phi->GetPixel(idx) - 1 );
-      }
-
-    TIndex idx4 = {{ix, iy - 1, iz}};
-    if( (iy - 1 >= 0) && doubleEqual(mp_phi->GetPixel(idx4), -3.0) )
-      {
-      Sn2.push_back(NodeType(ix, iy - 1, iz) );
-      mp_phi->SetPixel(idx4, mp_phi->GetPixel(idx) - 1 );
-      }
-
-    TIndex idx5 = {{ix, iy, iz + 1}};
-    if( (iz + 1 < m_nz) && doubleEqual(mp_phi->GetPixel(idx5), -3.0) )
-      {
-      Sn2.push_back(NodeType(ix, iy, iz + 1) );
-      mp_phi->SetPixel(idx5, mp_phi->GetPixel(idx) - 1 );
-      }
-
-    TIndex idx6 = {{ix, iy, iz - 1}};
-    if( (iz - 1 >= 0) && doubleEqual(mp_phi->GetPixel(idx6), -3.0) )
-      {
-      Sn2.push_back(NodeType(ix, iy, iz - 1) );
-      mp_phi->SetPixel(idx6, mp_phi->GetPixel(idx) - 1 );
+      if( nbhdInside[i] && doubleEqual(m_phiBuffer[offset + nbhdOffset[i]], -3.0) )
+        {
+        Sn2.push_back(nbhd[i]);
+        m_phiBuffer[offset + nbhdOffset[i]] = m_phiBuffer[offset] - 1;
+        }
       }
     }
 
-  //     // debug
-  //     labelsCoherentCheck1();
   /*--------------------------------------------------
     3.3 Scan Sp1     */
   for( CSFLSLayer::iterator itSp1 = Sp1.begin(); itSp1 != Sp1.end(); ++itSp1 )
@@ -771,96 +645,41 @@ CSFLSSegmentor3D<TPixel>
     long iy = (*itSp1)[1];
     long iz = (*itSp1)[2];
 
-    TIndex idx = {{ix, iy, iz}};
+    const long offset = voxelOffset(ix, iy, iz);
 
     m_lp1.push_back(*itSp1);
-    mp_label->SetPixel(idx, 1);
-
-    TIndex idx1 = {{ix + 1, iy, iz}};
-    if( (ix + 1 < m_nx) && doubleEqual(mp_phi->GetPixel(idx1), 3.0) )
-      {
-      Sp2.push_back(NodeType(ix + 1, iy, iz) );
-      mp_phi->SetPixel(idx1, mp_phi->GetPixel(idx) + 1 );
-      }
-
-    TIndex idx2 = {{ix - 1, iy, iz}};
-    if( (ix - 1 >= 0) && doubleEqual(mp_phi->GetPixel(idx2), 3.0) )
-      {
-      Sp2.push_back(NodeType(ix - 1, iy, iz) );
-      mp_phi->SetPixel(idx2, mp_phi->GetPixel(idx) + 1);
-      }
-
-    TIndex idx3 = {{ix, iy + 1, iz}};
-    if( (iy + 1 < m_ny) && doubleEqual(mp_phi->GetPixel(idx3), 3.0) )
-      {
-      Sp2.push_back(NodeType(ix, iy + 1, iz) );
-      mp_phi->SetPixel(idx3, mp_phi->GetPixel(idx) + 1 );
-      }
-
-    TIndex idx4 = {{ix, iy - 1, iz}};
-    if( (iy - 1 >= 0) && doubleEqual(mp_phi->GetPixel(idx4), 3.0) )
-      {
-      Sp2.push_back(NodeType(ix, iy - 1, iz) );
-      mp_phi->SetPixel(idx4, mp_phi->GetPixel(idx) + 1 );
-      }
-
-    TIndex idx5 = {{ix, iy, iz + 1}};
-    if( (iz + 1 < m_nz) && doubleEqual(mp_phi->GetPixel(idx5), 3.0) )
+    m_labelBuffer[offset] = 1;
+
+    const long     nbhdOffset[6] = {1, -1, m_nx, -m_nx, sliceStride, -sliceStride};
+    const bool     nbhdInside[6] = {ix + 1 < m_nx, ix - 1 >= 0, iy + 1 < m_ny, iy - 1 >= 0, iz + 1 < m_nz, iz - 1 >= 0};
+    const NodeType nbhd[6] = {NodeType(ix + 1, iy, iz), NodeType(ix - 1, iy, iz),
+                              NodeType(ix, iy + 1, iz), NodeType(ix, iy - 1, iz),
+                              NodeType(ix, iy, iz + 1), NodeType(ix, iy, iz - 1)};
+    for( int i = 0; i < 6; ++i )
       {
-      Sp2.push_back(NodeType(ix, iy, iz + 1) );
-      mp_phi->SetPixel(idx5, mp_phi->GetPixel(idx) + 1 );
-      }
-
-    TIndex idx6 = {{ix, iy, iz - 1}};
-    if( (iz - 1 >= 0) && doubleEqual(mp_phi->GetPixel(idx6), 3.0) )
-      {
-      Sp2.push_back(NodeType(ix, iy, iz - 1) );
-      mp_phi->SetPixel(idx6, mp_phi->GetPixel(idx) + 1 );
+      if( nbhdInside[i] && doubleEqual(m_phiBuffer[offset + nbhdOffset[i]], 3.0) )
+        {
+        Sp2.push_back(nbhd[i]);
+        m_phiBuffer[offset + nbhdOffset[i]] = m_phiBuffer[offset] + 1;
+        }
       }
     }
 
-  //     // debug
-  //     labelsCoherentCheck1();
-
   /*--------------------------------------------------
     3.4 Scan Sn2     */
+  for( CSFLSLayer::iterator itSn2 = Sn2.begin(); itSn2 != Sn2.end(); ++itSn2 )
     {
-    // debug
-    int aaa = 0;
-    for( CSFLSLayer::iterator itSn2 = Sn2.begin(); itSn2 != Sn2.end(); ++itSn2, ++aaa )
-      {
-      long ix = (*itSn2)[0];
-      long iy = (*itSn2)[1];
-      long iz = (*itSn2)[2];
-
-      TIndex idx = {{ix, iy, iz}};
-
-      m_ln2.push_back(*itSn2);
-
-      mp_label->SetPixel(idx, -2);
-
-      //           // debug
-      //           labelsCoherentCheck1();
-      }
+    m_ln2.push_back(*itSn2);
+    m_labelBuffer[voxelOffset( (*itSn2)[0], (*itSn2)[1], (*itSn2)[2])] = -2;
     }
+
   /*--------------------------------------------------
     3.5 Scan Sp2     */
   for( CSFLSLayer::iterator itSp2 = Sp2.begin(); itSp2 != Sp2.end(); ++itSp2 )
     {
-    long ix = (*itSp2)[0];
-    long iy = (*itSp2)[1];
-    long iz = (*itSp2)[2];
-
-    TIndex idx = {{ix, iy, iz}};
-
     m_lp2.push_back(*itSp2);
-
-    mp_label->SetPixel(idx, 2);
+    m_labelBuffer[voxelOffset( (*itSp2)[0], (*itSp2)[1], (*itSp2)[2])] = 2;
     }
-
-  //     // debug
-  //     labelsCoherentCheck1();
-
 }
 
 /*================================================================================
@@ -890,6 +709,8 @@ CSFLSSegmentor3D<TPixel>
 
   mp_label->FillBuffer(defaultLabel);
 
+  m_labelBuffer = mp_label->GetBufferPointer();
+
   return;
 }
 
@@ -919,6 +740,8 @@ CSFLSSegmentor3D<TPixel>
 
   mp_phi->FillBuffer(arbitraryInitPhi);
 
+  m_phiBuffer = mp_phi->GetBufferPointer();
+
   return;
 }
 
@@ -1368,13 +1191,11 @@ CSFLSSegmentor3D<TPixel>
   char yok = 0;
   char zok = 0;
 
-  TIndex idx = {{ix, iy, iz}};
-  TIndex idx1 = {{ix - 1, iy, iz}};
-  TIndex idx2 = {{ix + 1, iy, iz}};
-  TIndex idx3 = {{ix, iy - 1, iz}};
-  TIndex idx4 = {{ix, iy + 1, iz}};
-  TIndex idx5 = {{ix, iy, iz - 1}};
-  TIndex idx6 = {{ix, iy, iz + 1}};
+  // phi[0] is the voxel, its neighbors are at +-sx, +-sy and +-sz
+  const float* phi = m_phiBuffer + voxelOffset(ix, iy, iz);
+  const long   sx = 1;
+  const long   sy = m_nx;
+  const long   sz = m_nx * m_ny;
 
   if( ix + 1 < m_nx && ix - 1 >= 0 )
     {
@@ -1393,56 +1214,38 @@ CSFLSSegmentor3D<TPixel>
 
   if( xok )
     {
-    dx  = (mp_phi->GetPixel(idx2) - mp_phi->GetPixel(idx1) ) / (2.0 * m_dx);
-    dxx = (mp_phi->GetPixel(idx2) - 2.0 * (mp_phi->GetPixel(idx) ) + mp_phi->GetPixel(idx1) ) / (m_dx * m_dx);
+    dx  = (phi[sx] - phi[-sx]) / (2.0 * m_dx);
+    dxx = (phi[sx] - 2.0 * phi[0] + phi[-sx]) / (m_dx * m_dx);
     dx2 = dx * dx;
     }
 
   if( yok )
     {
-    dy  = ( (mp_phi->GetPixel(idx4) - mp_phi->GetPixel(idx3) ) ) / (2.0 * m_dy);
-    dyy = (mp_phi->GetPixel(idx4) - 2 * (mp_phi->GetPixel(idx) ) + mp_phi->GetPixel(idx3) ) / (m_dy * m_dy);
+    dy  = (phi[sy] - phi[-sy]) / (2.0 * m_dy);
+    dyy = (phi[sy] - 2.0 * phi[0] + phi[-sy]) / (m_dy * m_dy);
     dy2 = dy * dy;
     }
 
   if( zok )
     {
-    dz  = ( (mp_phi->GetPixel(idx6) - mp_phi->GetPixel(idx5) ) ) / (2.0 * m_dz);
-    dzz = (mp_phi->GetPixel(idx6) - 2.0 * (mp_phi->GetPixel(idx) ) + mp_phi->GetPixel(idx5) ) / (m_dz * m_dz);
+    dz  = (phi[sz] - phi[-sz]) / (2.0 * m_dz);
+    dzz = (phi[sz] - 2.0 * phi[0] + phi[-sz]) / (m_dz * m_dz);
     dz2 = dz * dz;
     }
 
   if( xok && yok )
     {
-    TIndex idx_1 = {{ix + 1, iy + 1, iz}};
-    TIndex idx_2 = {{ix - 1, iy - 1, iz}};
-    TIndex idx_3 = {{ix + 1, iy - 1, iz}};
-    TIndex idx_4 = {{ix - 1, iy + 1, iz}};
-
-    dxy = 0.25 * (mp_phi->GetPixel(idx_1) + mp_phi->GetPixel(idx_2) - mp_phi->GetPixel(idx_3) - mp_phi->GetPixel(idx_4) ) \
-      / (m_dx * m_dy);
+    dxy = 0.25 * (phi[sx + sy] + phi[-sx - sy] - phi[sx - sy] - phi[-sx + sy]) / (m_dx * m_dy);
     }
 
   if( xok && zok )
     {
-    TIndex idx_1 = {{ix + 1, iy, iz + 1}};
-    TIndex idx_2 = {{ix - 1, iy, iz - 1}};
-    TIndex idx_3 = {{ix + 1, iy, iz - 1}};
-    TIndex idx_4 = {{ix - 1, iy, iz + 1}};
-
-    dxz = 0.25 * (mp_phi->GetPixel(idx_1) + mp_phi->GetPixel(idx_2) - mp_phi->GetPixel(idx_3) - mp_phi->GetPixel(idx_4) ) \
-      / (m_dx * m_dz);
+    dxz = 0.25 * (phi[sx + sz] + phi[-sx - sz] - phi[sx - sz] - phi[-sx + sz]) / (m_dx * m_dz);
     }
 
   if( yok && zok )
     {
-    TIndex idx_1 = {{ix, iy + 1, iz + 1}};
-    TIndex idx_2 = {{ix, iy - 1, iz - 1}};
-    TIndex idx_3 = {{ix, iy + 1, iz - 1}};
-    TIndex idx_4 = {{ix, iy - 1, iz + 1}};
-
-    dyz = 0.25 * (mp_phi->GetPixel(idx_1) + mp_phi->GetPixel(idx_2) - mp_phi->GetPixel(idx_3) - mp_phi->GetPixel(idx_4) ) \
-      / (m_dy * m_dz);
+    dyz = 0.25 * (phi[sy + sz] + phi[-sy - sz] - phi[sy - sz] - phi[-sy + sz]) / (m_dy * m_dz);
     }
 
   return (dxx
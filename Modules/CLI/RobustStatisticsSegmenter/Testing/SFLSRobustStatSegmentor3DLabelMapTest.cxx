@@ -0,0 +1,127 @@
+#include "SFLSRobustStatSegmentor3DLabelMap_single.h"
+
+// ITK includes
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkMultiThreader.h>
+
+// STD includes
+#include <cmath>
+#include <iostream>
+
+typedef short                                         PixelType;
+typedef CSFLSRobustStatSegmentor3DLabelMap<PixelType> SegmentorType;
+typedef SegmentorType::TImage                         ImageType;
+typedef SegmentorType::TLabelImage                    LabelImageType;
+typedef SegmentorType::LSImageType                    LevelSetImageType;
+
+const long   ImageSize = 32;
+const double SphereRadius = 8.0;
+
+double DistanceFromCenter( const ImageType::IndexType & idx )
+{
+  double d2 = 0;
+  for( unsigned int i = 0; i < 3; i++ )
+    {
+    double d = idx[i] - ImageSize / 2;
+    d2 += d * d;
+    }
+  return std::sqrt( d2 );
+}
+
+// Bright sphere with some noise on a dark background
+ImageType::Pointer CreateSphereImage()
+{
+  ImageType::SizeType size;
+  size.Fill( ImageSize );
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  unsigned int seed = 1234;
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    // linear congruential generator, so that the test does not depend on the platform
+    seed = seed * 1103515245 + 12345;
+    int noise = static_cast<int>( (seed >> 16) % 21 ) - 10;
+    it.Set( (DistanceFromCenter( it.GetIndex() ) <= SphereRadius ? 200 : 50) + noise );
+    }
+  return image;
+}
+
+// 3x3x3 seed at the center of the sphere
+LabelImageType::Pointer CreateSeedImage()
+{
+  LabelImageType::SizeType size;
+  size.Fill( ImageSize );
+  LabelImageType::Pointer label = LabelImageType::New();
+  label->SetRegions( size );
+  label->Allocate();
+  label->FillBuffer( 0 );
+
+  itk::ImageRegionIteratorWithIndex<LabelImageType> it( label, label->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    if( DistanceFromCenter( it.GetIndex() ) <= 1.8 )
+      {
+      it.Set( 1 );
+      }
+    }
+  return label;
+}
+
+LevelSetImageType::Pointer Segment( ImageType::Pointer image, LabelImageType::Pointer seeds )
+{
+  SegmentorType seg;
+  seg.setImage( image );
+  seg.setNumIter( 100 );
+  seg.setMaxVolume( 10.0 );
+  seg.setInputLabelImage( seeds );
+  seg.setMaxRunningTime( 10 );
+  seg.setIntensityHomogeneity( 0.6 );
+  seg.setCurvatureWeight( 0.5 / 1.5 );
+  seg.doSegmenation();
+  return seg.mp_phi;
+}
+
+int main(int, char *[])
+{
+  ImageType::Pointer      image = CreateSphereImage();
+  LabelImageType::Pointer seeds = CreateSeedImage();
+
+  LevelSetImageType::Pointer phi = Segment( image, seeds );
+
+  // The contour must grow from the seed to the sphere boundary and stop there
+  itk::ImageRegionIteratorWithIndex<LevelSetImageType> it( phi, phi->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    double r = DistanceFromCenter( it.GetIndex() );
+    bool   inside = ( it.Get() <= 0 );
+    if( (r <= SphereRadius - 3.0 && !inside) || (r >= SphereRadius + 3.0 && inside) )
+      {
+      std::cerr << "Unexpected segmentation at " << it.GetIndex() << " (distance from center " << r
+                << ", phi = " << it.Get() << ")" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // The force is computed on several threads, the result must not depend on the number of threads
+  int numberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  itk::MultiThreader::SetGlobalDefaultNumberOfThreads( 1 );
+  LevelSetImageType::Pointer singleThreadPhi = Segment( image, seeds );
+  itk::MultiThreader::SetGlobalDefaultNumberOfThreads( numberOfThreads );
+
+  itk::ImageRegionIteratorWithIndex<LevelSetImageType> singleIt( singleThreadPhi,
+                                                                 singleThreadPhi->GetLargestPossibleRegion() );
+  for( it.GoToBegin(), singleIt.GoToBegin(); !it.IsAtEnd(); ++it, ++singleIt )
+    {
+    if( it.Get() != singleIt.Get() )
+      {
+      std::cerr << "Result differs with a single thread at " << it.GetIndex() << ": phi = " << it.Get()
+                << " instead of " << singleIt.Get() << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
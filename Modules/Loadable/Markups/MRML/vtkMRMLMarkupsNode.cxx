@@ -29,10 +29,12 @@
 #include <vtkAbstractTransform.h>
 #include <vtkBitArray.h>
 #include <vtkCommand.h>
+#include <vtkIdList.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
+#include <vtkPoints.h>
 #include <vtkPolyData.h>
 #include <vtkStringArray.h>
 
@@ -51,6 +53,7 @@ vtkMRMLMarkupsNode::vtkMRMLMarkupsNode()
   this->Locked = 0;
   this->MarkupLabelFormat = std::string("%N-%d");
   this->MaximumNumberOfMarkups = 0;
+  this->MarkupIDIndexValid = true;
 }
 
 //----------------------------------------------------------------------------
@@ -143,12 +146,15 @@ void vtkMRMLMarkupsNode::Copy(vtkMRMLNode *anode)
       }
     }
 
-  this->Markups.clear();
-  int numMarkups = node->GetNumberOfMarkups();
-  for (int n = 0; n < numMarkups; n++)
+  // copy all markups at once instead of adding them one by one, observers
+  // get a single batch update
+  this->Markups = node->Markups;
+  this->MarkupIDIndex.clear();
+  this->MarkupIDIndexValid = false;
+  if (!this->Markups.empty())
     {
-    Markup *markup = node->GetNthMarkup(n);
-    this->AddMarkup(*markup);
+    this->Modified();
+    this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::MarkupAddedEvent);
     }
 
   // set max number of markups after adding the new ones
@@ -235,9 +241,13 @@ void vtkMRMLMarkupsNode::RemoveAllMarkups()
 
   this->SetLocked(0); // Should this be done here ?
 
-  while(this->Markups.size() > 0)
+  if (!this->Markups.empty())
     {
-    this->RemoveMarkup(0);
+    this->Markups.clear();
+    this->MarkupIDIndex.clear();
+    this->MarkupIDIndexValid = true;
+    this->Modified();
+    this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::MarkupRemovedEvent);
     }
   this->MaximumNumberOfMarkups = 0;
 
@@ -488,6 +498,8 @@ int vtkMRMLMarkupsNode::AddMarkup(Markup markup)
   this->MaximumNumberOfMarkups++;
 
   int markupIndex = this->GetNumberOfMarkups() - 1;
+  // keeps the first occurrence if the id is duplicated, same as a linear search
+  this->AddToMarkupIDIndex(markup.ID, markupIndex);
 
   this->Modified();
   this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::MarkupAddedEvent, (void*)&markupIndex);
@@ -542,6 +554,45 @@ int vtkMRMLMarkupsNode::AddPointToNthMarkup(vtkVector3d point, int n)
   return pointIndex;
 }
 
+//-----------------------------------------------------------
+int vtkMRMLMarkupsNode::AddPointsToNewMarkups(vtkPoints* points)
+{
+  if (!points)
+    {
+    vtkErrorMacro("AddPointsToNewMarkups: invalid points");
+    return -1;
+    }
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  if (numberOfPoints == 0)
+    {
+    return -1;
+    }
+
+  int firstMarkupIndex = this->GetNumberOfMarkups();
+  this->Markups.reserve(this->Markups.size() + numberOfPoints);
+  double pos[3] = { 0.0, 0.0, 0.0 };
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+    Markup markup;
+    // InitMarkup relies on MaximumNumberOfMarkups for the default label
+    // and id, so it is incremented as markups are appended
+    this->InitMarkup(&markup);
+    points->GetPoint(i, pos);
+    markup.points.push_back(vtkVector3d(pos[0], pos[1], pos[2]));
+    this->Markups.push_back(markup);
+    this->MaximumNumberOfMarkups++;
+    if (this->MarkupIDIndexValid)
+      {
+      this->MarkupIDIndex.insert(std::make_pair(markup.ID, static_cast<int>(this->Markups.size()) - 1));
+      }
+    }
+
+  // observers treat an added event without call data as a batch update
+  this->Modified();
+  this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::MarkupAddedEvent);
+  return firstMarkupIndex;
+}
+
 //-----------------------------------------------------------
 vtkVector3d vtkMRMLMarkupsNode::GetMarkupPointVector(int markupIndex, int pointIndex)
 {
@@ -593,6 +644,8 @@ void vtkMRMLMarkupsNode::RemoveMarkup(int m)
   if (this->MarkupExists(m))
     {
     vtkDebugMacro("RemoveMarkup: m = " << m << ", markups size = " << this->Markups.size());
+    this->RemoveFromMarkupIDIndex(this->Markups[m].ID, m);
+    this->ShiftMarkupIDIndex(m + 1, -1);
     this->Markups.erase(this->Markups.begin() + m);
 
     this->Modified();
@@ -600,6 +653,55 @@ void vtkMRMLMarkupsNode::RemoveMarkup(int m)
     }
 }
 
+//-----------------------------------------------------------
+int vtkMRMLMarkupsNode::RemoveMarkups(vtkIdList* markupIndices)
+{
+  if (!markupIndices)
+    {
+    vtkErrorMacro("RemoveMarkups: invalid markup index list");
+    return 0;
+    }
+  int numberOfMarkups = this->GetNumberOfMarkups();
+  std::vector<bool> removeMarkup(numberOfMarkups, false);
+  int numberOfMarkupsToRemove = 0;
+  for (vtkIdType i = 0; i < markupIndices->GetNumberOfIds(); ++i)
+    {
+    vtkIdType m = markupIndices->GetId(i);
+    if (m < 0 || m >= numberOfMarkups || removeMarkup[m])
+      {
+      continue;
+      }
+    removeMarkup[m] = true;
+    numberOfMarkupsToRemove++;
+    }
+  if (numberOfMarkupsToRemove == 0)
+    {
+    return 0;
+    }
+
+  // compact the kept markups towards the front of the list, preserving order
+  int targetIndex = 0;
+  for (int m = 0; m < numberOfMarkups; ++m)
+    {
+    if (removeMarkup[m])
+      {
+      continue;
+      }
+    if (targetIndex != m)
+      {
+      this->Markups[targetIndex] = this->Markups[m];
+      }
+    targetIndex++;
+    }
+  this->Markups.resize(targetIndex);
+  this->MarkupIDIndexValid = false;
+
+  // observers treat a removed event without call data as a batch update
+  this->Modified();
+  this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::MarkupRemovedEvent);
+  return numberOfMarkupsToRemove;
+}
+
 //-----------------------------------------------------------
 bool vtkMRMLMarkupsNode::InsertMarkup(Markup m, int targetIndex)
 {
@@ -623,6 +725,8 @@ bool vtkMRMLMarkupsNode::InsertMarkup(Markup m, int targetIndex)
 
   std::vector < Markup >::iterator result;
   result = this->Markups.insert(pos, m);
+  this->ShiftMarkupIDIndex(destIndex, 1);
+  this->AddToMarkupIDIndex(m.ID, destIndex);
 
   // sanity check
   if (result->Label.compare(m.Label) != 0)
@@ -648,6 +752,13 @@ void vtkMRMLMarkupsNode::CopyMarkup(Markup *source, Markup *target)
     return;
     }
 
+  // target may be a markup of this node, then its ID is changed in the ID index as well
+  if (!this->Markups.empty() && target >= &this->Markups.front() && target <= &this->Markups.back()
+    && target->ID != source->ID)
+    {
+    this->MarkupIDIndexValid = false;
+    }
+
   target->ID = source->ID;
   target->Label = source->Label;
   target->Description = source->Description;
@@ -679,6 +790,11 @@ void vtkMRMLMarkupsNode::SwapMarkups(int m1, int m2)
     return;
     }
 
+  // exchange the two entries in the ID index, copying the markups below would invalidate it
+  std::string m1ID = this->Markups[m1].ID;
+  std::string m2ID = this->Markups[m2].ID;
+  bool markupIDIndexValid = this->MarkupIDIndexValid;
+
   Markup *m1Markup = this->GetNthMarkup(m1);
   Markup m1MarkupBackup;
   // make a copy of the first markup
@@ -687,6 +803,14 @@ void vtkMRMLMarkupsNode::SwapMarkups(int m1, int m2)
   this->CopyMarkup(this->GetNthMarkup(m2), m1Markup);
   // and copy the backup of the first one into the second
   this->CopyMarkup(&m1MarkupBackup, this->GetNthMarkup(m2));
+  this->MarkupIDIndexValid = markupIDIndexValid;
+  if (m1ID != m2ID)
+    {
+    this->RemoveFromMarkupIDIndex(m1ID, m1);
+    this->RemoveFromMarkupIDIndex(m2ID, m2);
+    this->AddToMarkupIDIndex(m1ID, m2);
+    this->AddToMarkupIDIndex(m2ID, m1);
+    }
 
   // and let listeners know that two markups have changed
   this->Modified();
@@ -761,6 +885,67 @@ void vtkMRMLMarkupsNode::SetMarkupPointWorld(const int markupIndex, const int po
   this->SetMarkupPoint(markupIndex, pointIndex, markupxyz[0], markupxyz[1], markupxyz[2]);
 }
 
+//-----------------------------------------------------------
+bool vtkMRMLMarkupsNode::SetMarkupPointsFromPoints(vtkPoints* points, int pointIndex /*=0*/)
+{
+  if (!points)
+    {
+    vtkErrorMacro("SetMarkupPointsFromPoints: invalid points");
+    return false;
+    }
+  int numberOfMarkups = this->GetNumberOfMarkups();
+  if (points->GetNumberOfPoints() != numberOfMarkups)
+    {
+    vtkErrorMacro("SetMarkupPointsFromPoints: number of points " << points->GetNumberOfPoints()
+      << " doesn't match number of markups " << numberOfMarkups);
+    return false;
+    }
+  for (int m = 0; m < numberOfMarkups; ++m)
+    {
+    if (!this->PointExistsInMarkup(pointIndex, m))
+      {
+      vtkErrorMacro("SetMarkupPointsFromPoints: markup " << m << " doesn't have point " << pointIndex);
+      return false;
+      }
+    }
+
+  double pos[3] = { 0.0, 0.0, 0.0 };
+  for (int m = 0; m < numberOfMarkups; ++m)
+    {
+    points->GetPoint(m, pos);
+    this->Markups[m].points[pointIndex] = vtkVector3d(pos[0], pos[1], pos[2]);
+    }
+
+  // a single modified event lets observers update all markups at once
+  this->Modified();
+  return true;
+}
+
+//-----------------------------------------------------------
+void vtkMRMLMarkupsNode::GetMarkupPoints(vtkPoints* points, int pointIndex /*=0*/)
+{
+  if (!points)
+    {
+    vtkErrorMacro("GetMarkupPoints: invalid points");
+    return;
+    }
+  int numberOfMarkups = this->GetNumberOfMarkups();
+  points->SetNumberOfPoints(numberOfMarkups);
+  for (int m = 0; m < numberOfMarkups; ++m)
+    {
+    const std::vector<vtkVector3d>& markupPoints = this->Markups[m].points;
+    if (pointIndex >= 0 && pointIndex < static_cast<int>(markupPoints.size()))
+      {
+      const vtkVector3d& point = markupPoints[pointIndex];
+      points->SetPoint(m, point.GetX(), point.GetY(), point.GetZ());
+      }
+    else
+      {
+      points->SetPoint(m, 0.0, 0.0, 0.0);
+      }
+    }
+}
+
 //-----------------------------------------------------------
 void vtkMRMLMarkupsNode::SetNthMarkupOrientationFromPointer(int n, const double *orientation)
 {
@@ -882,19 +1067,102 @@ int vtkMRMLMarkupsNode::GetMarkupIndexByID(const char* markupID)
     return -1;
     }
 
+  this->UpdateMarkupIDIndex();
+  vtksys::hash_map< std::string, int >::iterator it = this->MarkupIDIndex.find(markupID);
+  if (it != this->MarkupIDIndex.end())
+    {
+    int markupIndex = it->second;
+    if (this->MarkupExists(markupIndex) && this->Markups[markupIndex].ID.compare(markupID) == 0)
+      {
+      return markupIndex;
+      }
+    }
+
+  // The id may have been set behind the node's back (e.g. by InitMarkup or
+  // through the pointer returned by GetNthMarkup), fall back to a linear search
+  // and rebuild the map if the markup is found.
   int numberOfMarkups = this->GetNumberOfMarkups();
-  for (int i = 0; i < numberOfMarkups; ++i)
+  for (int markupIndex = 0; markupIndex < numberOfMarkups; ++markupIndex)
     {
-    Markup* compareMarkup = this->GetNthMarkup(i);
-    if (compareMarkup &&
-        strcmp(compareMarkup->ID.c_str(), markupID) == 0)
+    if (this->Markups[markupIndex].ID.compare(markupID) == 0)
       {
-      return i;
+      vtkDebugMacro("GetMarkupIndexByID: markup ID index is out of date, rebuilding");
+      this->MarkupIDIndexValid = false;
+      this->UpdateMarkupIDIndex();
+      return markupIndex;
       }
     }
   return -1;
 }
 
+//-------------------------------------------------------------------------
+void vtkMRMLMarkupsNode::UpdateMarkupIDIndex()
+{
+  if (this->MarkupIDIndexValid)
+    {
+    return;
+    }
+  this->MarkupIDIndex.clear();
+  int numberOfMarkups = this->GetNumberOfMarkups();
+  for (int i = 0; i < numberOfMarkups; ++i)
+    {
+    // insert keeps the first occurrence of duplicated ids
+    this->MarkupIDIndex.insert(std::make_pair(this->Markups[i].ID, i));
+    }
+  this->MarkupIDIndexValid = true;
+}
+
+//-------------------------------------------------------------------------
+void vtkMRMLMarkupsNode::ShiftMarkupIDIndex(int firstIndex, int offset)
+{
+  if (!this->MarkupIDIndexValid)
+    {
+    return;
+    }
+  for (vtksys::hash_map< std::string, int >::iterator it = this->MarkupIDIndex.begin();
+    it != this->MarkupIDIndex.end(); ++it)
+    {
+    if (it->second >= firstIndex)
+      {
+      it->second += offset;
+      }
+    }
+}
+
+//-------------------------------------------------------------------------
+void vtkMRMLMarkupsNode::RemoveFromMarkupIDIndex(const std::string& markupID, int markupIndex)
+{
+  if (!this->MarkupIDIndexValid)
+    {
+    return;
+    }
+  // a duplicate of the id at a higher index is not in the map,
+  // it is found by the linear search in GetMarkupIndexByID
+  vtksys::hash_map< std::string, int >::iterator it = this->MarkupIDIndex.find(markupID);
+  if (it != this->MarkupIDIndex.end() && it->second == markupIndex)
+    {
+    this->MarkupIDIndex.erase(it);
+    }
+}
+
+//-------------------------------------------------------------------------
+void vtkMRMLMarkupsNode::AddToMarkupIDIndex(const std::string& markupID, int markupIndex)
+{
+  if (!this->MarkupIDIndexValid)
+    {
+    return;
+    }
+  vtksys::hash_map< std::string, int >::iterator it = this->MarkupIDIndex.find(markupID);
+  if (it == this->MarkupIDIndex.end())
+    {
+    this->MarkupIDIndex.insert(std::make_pair(markupID, markupIndex));
+    }
+  else if (it->second > markupIndex)
+    {
+    it->second = markupIndex;
+    }
+}
+
 //-------------------------------------------------------------------------
 Markup* vtkMRMLMarkupsNode::GetMarkupByID(const char* markupID)
 {
@@ -923,7 +1191,9 @@ void vtkMRMLMarkupsNode::SetNthMarkupID(int n, std::string id)
       if (markup->ID.compare(id) != 0)
         {
         vtkDebugMacro("Changing markup " << n << " associated node id from " << markup->ID.c_str() << " to " << id.c_str());
+        this->RemoveFromMarkupIDIndex(markup->ID, n);
         markup->ID = std::string(id.c_str());
+        this->AddToMarkupIDIndex(markup->ID, n);
         }
       else
         {
@@ -27,9 +27,12 @@
 // VTK includes
 #include <vtkSmartPointer.h>
 #include <vtkVector.h>
+#include <vtksys/hash_map.hxx>
 
-class vtkStringArray;
+class vtkIdList;
 class vtkMatrix4x4;
+class vtkPoints;
+class vtkStringArray;
 
 /// see doxygen enabled comment in class description
 typedef struct
@@ -193,6 +196,11 @@ public:
   int AddPointWorldToNewMarkup(vtkVector3d point, std::string label = std::string());
   /// Add a point to the nth markup, returning the point index
   int AddPointToNthMarkup(vtkVector3d point, int n);
+  /// Create a new single point markup for each point in \a points.
+  /// Observers are notified once: a single MarkupAddedEvent is invoked
+  /// without call data, which listeners treat as a batch update.
+  /// Return index of the first new markup, -1 on failure.
+  int AddPointsToNewMarkups(vtkPoints* points);
 
   /// Get the position of the pointIndex'th point in markupIndex markup,
   /// returning it as a vtkVector3d
@@ -209,6 +217,11 @@ public:
 
   /// Remove a markup
   void RemoveMarkup(int m);
+  /// Remove all markups whose index is listed in \a markupIndices.
+  /// Invalid and duplicate indices are ignored. The remaining markups are
+  /// compacted in a single pass and a single MarkupRemovedEvent is invoked
+  /// without call data. Returns the number of removed markups.
+  int RemoveMarkups(vtkIdList* markupIndices);
 
   /// Insert a markup in this list at targetIndex.
   /// If targetIndex is < 0, insert at the start of the list.
@@ -216,7 +229,8 @@ public:
   /// Returns true on success, false on failure.
   bool InsertMarkup(Markup m, int targetIndex);
 
-  /// Copy settings from source markup to target markup
+  /// Copy settings from source markup to target markup.
+  /// Target may be a markup of this node (e.g., returned by GetNthMarkup), its ID is then updated in the ID index.
   void CopyMarkup(Markup *source, Markup *target);
 
   /// Swap the position of two markups
@@ -239,6 +253,16 @@ public:
   /// Calls SetMarkupPoint after transforming the passed in coordinate
   /// \sa SetMarkupPoint
   void SetMarkupPointWorld(const int markupIndex, const int pointIndex, const double x, const double y, const double z);
+  /// Set point \a pointIndex of every markup from \a points, where the
+  /// i-th point is assigned to the i-th markup. The number of points must match
+  /// the number of markups. Only a single Modified event is invoked.
+  /// Returns true on success, false on failure.
+  /// \sa GetMarkupPoints
+  bool SetMarkupPointsFromPoints(vtkPoints* points, int pointIndex = 0);
+  /// Fill \a points with point \a pointIndex of every markup, in markup order.
+  /// Markups that don't have such a point are reported at (0,0,0).
+  /// \sa SetMarkupPointsFromPoints
+  void GetMarkupPoints(vtkPoints* points, int pointIndex = 0);
 
   /// Set the orientation for a markup from a pointer to a double array
   void SetNthMarkupOrientationFromPointer(int n, const double *orientation);
@@ -255,7 +279,9 @@ public:
 
   /// Get the id for the nth markup
   std::string GetNthMarkupID(int n = 0);
-  /// Get Markup index based on it's ID
+  /// Get Markup index based on it's ID.
+  /// Lookups use an ID to index map that is maintained by the node, so
+  /// markup IDs must only be changed through the node API.
   int GetMarkupIndexByID(const char* markupID);
   /// Get Markup based on it's ID
   Markup* GetMarkupByID(const char* markupID);
@@ -374,6 +400,24 @@ private:
   // incrementing, not decreasing when they're removed. Used to help create
   // unique names and ids. Reset to 0 when \sa RemoveAllMarkups called
   int MaximumNumberOfMarkups;
+
+  /// Rebuild the markup ID to index map if it was invalidated
+  void UpdateMarkupIDIndex();
+  /// Add offset to the indices in the markup ID index that are greater than or equal to firstIndex
+  void ShiftMarkupIDIndex(int firstIndex, int offset);
+  /// Remove the ID of the markup at markupIndex from the markup ID index
+  void RemoveFromMarkupIDIndex(const std::string& markupID, int markupIndex);
+  /// Add the ID of the markup at markupIndex to the markup ID index,
+  /// an ID that is already in the index is kept at its lowest index
+  void AddToMarkupIDIndex(const std::string& markupID, int markupIndex);
+
+  /// Hash map from markup ID to markup index, used for fast lookup of markups
+  /// by ID in large lists. Add, insert, remove, swap, and ID changes update it in place.
+  /// Bulk removal and copy only invalidate it and it is rebuilt on the next lookup.
+  /// IDs that are not found are searched in the markup list, as markups can be
+  /// modified directly through the pointer returned by GetNthMarkup.
+  vtksys::hash_map< std::string, int > MarkupIDIndex;
+  bool MarkupIDIndexValid;
 };
 
 #endif
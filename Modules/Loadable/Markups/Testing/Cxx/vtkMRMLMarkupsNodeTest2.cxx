@@ -19,9 +19,24 @@
 #include "vtkMRMLMarkupsNode.h"
 
 // VTK includes
+#include <vtkIdList.h>
 #include <vtkNew.h>
+#include <vtkPoints.h>
 #include <vtkTestingOutputWindow.h>
 
+//----------------------------------------------------------------------------
+bool CheckMarkupIndexByID(vtkMRMLMarkupsNode* node, const std::string& markupID, int expectedIndex, const char* operation)
+{
+  int markupIndex = node->GetMarkupIndexByID(markupID.c_str());
+  if (markupIndex != expectedIndex)
+    {
+    std::cerr << "Get Markup index by ID after " << operation << " failed for " << markupID
+              << ", returned " << markupIndex << ", expecting " << expectedIndex << std::endl;
+    return false;
+    }
+  return true;
+}
+
 // test copy and swap
 int vtkMRMLMarkupsNodeTest2(int , char * [] )
 {
@@ -197,5 +212,163 @@ int vtkMRMLMarkupsNodeTest2(int , char * [] )
     return EXIT_FAILURE;
     }
 
+  // test bulk add, set, get and remove
+  vtkNew<vtkMRMLMarkupsNode> node2;
+  vtkNew<vtkPoints> points;
+  const int numberOfBulkPoints = 100;
+  for (int i = 0; i < numberOfBulkPoints; ++i)
+    {
+    points->InsertNextPoint(i, 2.0 * i, -1.0 * i);
+    }
+  int firstIndex = node2->AddPointsToNewMarkups(points.GetPointer());
+  if (firstIndex != 0 || node2->GetNumberOfMarkups() != numberOfBulkPoints)
+    {
+    std::cerr << "AddPointsToNewMarkups failed, first index = " << firstIndex
+              << ", number of markups = " << node2->GetNumberOfMarkups() << std::endl;
+    return EXIT_FAILURE;
+    }
+  double bulkPos[3];
+  node2->GetMarkupPoint(42, 0, bulkPos);
+  if (bulkPos[0] != 42.0 || bulkPos[1] != 84.0 || bulkPos[2] != -42.0)
+    {
+    std::cerr << "AddPointsToNewMarkups failed, markup 42 is at "
+              << bulkPos[0] << ", " << bulkPos[1] << ", " << bulkPos[2] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  for (int i = 0; i < numberOfBulkPoints; ++i)
+    {
+    points->SetPoint(i, -i, 0.0, 3.0);
+    }
+  if (!node2->SetMarkupPointsFromPoints(points.GetPointer()))
+    {
+    std::cerr << "SetMarkupPointsFromPoints failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkNew<vtkPoints> pointsOut;
+  node2->GetMarkupPoints(pointsOut.GetPointer());
+  if (pointsOut->GetNumberOfPoints() != numberOfBulkPoints)
+    {
+    std::cerr << "GetMarkupPoints returned " << pointsOut->GetNumberOfPoints()
+              << " points, expected " << numberOfBulkPoints << std::endl;
+    return EXIT_FAILURE;
+    }
+  pointsOut->GetPoint(7, bulkPos);
+  if (bulkPos[0] != -7.0 || bulkPos[1] != 0.0 || bulkPos[2] != 3.0)
+    {
+    std::cerr << "SetMarkupPointsFromPoints failed, markup 7 is at "
+              << bulkPos[0] << ", " << bulkPos[1] << ", " << bulkPos[2] << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkNew<vtkPoints> tooFewPoints;
+  tooFewPoints->InsertNextPoint(0.0, 0.0, 0.0);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  bool setResult = node2->SetMarkupPointsFromPoints(tooFewPoints.GetPointer());
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  if (setResult)
+    {
+    std::cerr << "SetMarkupPointsFromPoints succeeded with mismatched number of points" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // remove every even markup, lookups by ID must follow the new indices
+  std::string id51 = node2->GetNthMarkupID(51);
+  vtkNew<vtkIdList> markupsToRemove;
+  for (int i = 0; i < numberOfBulkPoints; i += 2)
+    {
+    markupsToRemove->InsertNextId(i);
+    }
+  markupsToRemove->InsertNextId(0); // duplicate
+  markupsToRemove->InsertNextId(numberOfBulkPoints + 10); // invalid
+  int numberOfRemoved = node2->RemoveMarkups(markupsToRemove.GetPointer());
+  if (numberOfRemoved != numberOfBulkPoints / 2
+    || node2->GetNumberOfMarkups() != numberOfBulkPoints / 2)
+    {
+    std::cerr << "RemoveMarkups failed, removed " << numberOfRemoved
+              << ", remaining " << node2->GetNumberOfMarkups() << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (node2->GetMarkupIndexByID(id51.c_str()) != 25)
+    {
+    std::cerr << "Get Markup index by ID after RemoveMarkups failed, returned "
+              << node2->GetMarkupIndexByID(id51.c_str()) << ", expecting 25" << std::endl;
+    return EXIT_FAILURE;
+    }
+  node2->SwapMarkups(0, 25);
+  if (node2->GetMarkupIndexByID(id51.c_str()) != 0)
+    {
+    std::cerr << "Get Markup index by ID after SwapMarkups failed, returned "
+              << node2->GetMarkupIndexByID(id51.c_str()) << ", expecting 0" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // copy a markup over an existing markup of the node, lookups must find the copied ID
+  Markup copiedMarkup;
+  node2->CopyMarkup(node2->GetNthMarkup(3), &copiedMarkup);
+  copiedMarkup.ID = "CopiedMarkupID";
+  std::string id3 = node2->GetNthMarkupID(3);
+  node2->CopyMarkup(&copiedMarkup, node2->GetNthMarkup(10));
+  if (node2->GetMarkupIndexByID("CopiedMarkupID") != 10)
+    {
+    std::cerr << "Get Markup index by ID after CopyMarkup failed, returned "
+              << node2->GetMarkupIndexByID("CopiedMarkupID") << ", expecting 10" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (node2->GetMarkupIndexByID(id3.c_str()) != 3)
+    {
+    std::cerr << "Get Markup index by ID of copy source after CopyMarkup failed, returned "
+              << node2->GetMarkupIndexByID(id3.c_str()) << ", expecting 3" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // single remove, insert, and ID change update the ID index in place
+  std::string id20 = node2->GetNthMarkupID(20);
+  std::string id21 = node2->GetNthMarkupID(21);
+  node2->RemoveMarkup(node2->GetMarkupIndexByID(id20.c_str()));
+  if (!CheckMarkupIndexByID(node2.GetPointer(), id20, -1, "RemoveMarkup")
+    || !CheckMarkupIndexByID(node2.GetPointer(), id21, 20, "RemoveMarkup")
+    || !CheckMarkupIndexByID(node2.GetPointer(), id3, 3, "RemoveMarkup"))
+    {
+    return EXIT_FAILURE;
+    }
+  Markup insertedMarkup;
+  node2->InitMarkup(&insertedMarkup);
+  insertedMarkup.ID = "InsertedMarkupID";
+  node2->InsertMarkup(insertedMarkup, 5);
+  if (!CheckMarkupIndexByID(node2.GetPointer(), "InsertedMarkupID", 5, "InsertMarkup")
+    || !CheckMarkupIndexByID(node2.GetPointer(), id21, 21, "InsertMarkup")
+    || !CheckMarkupIndexByID(node2.GetPointer(), id3, 3, "InsertMarkup"))
+    {
+    return EXIT_FAILURE;
+    }
+  std::string id7 = node2->GetNthMarkupID(7);
+  node2->SetNthMarkupID(7, "RenamedMarkupID");
+  if (!CheckMarkupIndexByID(node2.GetPointer(), "RenamedMarkupID", 7, "SetNthMarkupID")
+    || !CheckMarkupIndexByID(node2.GetPointer(), id7, -1, "SetNthMarkupID"))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // ID set directly on a markup of the node must be found as well
+  std::string id12 = node2->GetNthMarkupID(12);
+  node2->InitMarkup(node2->GetNthMarkup(12));
+  if (!CheckMarkupIndexByID(node2.GetPointer(), node2->GetNthMarkupID(12), 12, "InitMarkup")
+    || !CheckMarkupIndexByID(node2.GetPointer(), id12, -1, "InitMarkup"))
+    {
+    return EXIT_FAILURE;
+    }
+  node2->GetNthMarkup(13)->ID = "DirectlySetMarkupID";
+  if (!CheckMarkupIndexByID(node2.GetPointer(), "DirectlySetMarkupID", 13, "setting the ID directly"))
+    {
+    return EXIT_FAILURE;
+    }
+
+  node2->RemoveAllMarkups();
+  if (node2->GetNumberOfMarkups() != 0 || node2->GetMarkupIndexByID(id51.c_str()) != -1)
+    {
+    std::cerr << "RemoveAllMarkups failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
   return EXIT_SUCCESS;
 }
@@ -65,12 +65,7 @@ class SegmentEditorIdentifyIslandsEffect(AbstractScriptedSegmentEditorIslandEffe
     islandMath.SetFullyConnected(fullyConnected)
     islandMath.SetMinimumSize(minimumSize)
 
-    # Note that island operation happens in unsigned long space
-    # but the segment editor works in unsigned char
-    castOut = vtk.vtkImageCast()
-    castOut.SetInputConnection(islandMath.GetOutputPort())
-    castOut.SetOutputScalarTypeToUnsignedChar()
-    castOut.Update()
+    islandMath.Update()
 
     islandCount = islandMath.GetNumberOfIslands()
     islandOrigCount = islandMath.GetOriginalNumberOfIslands()
@@ -80,12 +75,13 @@ class SegmentEditorIdentifyIslandsEffect(AbstractScriptedSegmentEditorIslandEffe
     # Create oriented image data from output
     import vtkSegmentationCorePython as vtkSegmentationCore
     multiLabelImage = vtkSegmentationCore.vtkOrientedImageData()
-    multiLabelImage.DeepCopy(castOut.GetOutput())
+    multiLabelImage.ShallowCopy(islandMath.GetOutput())
     selectedSegmentLabelmapImageToWorldMatrix = vtk.vtkMatrix4x4()
     selectedSegmentLabelmap.GetImageToWorldMatrix(selectedSegmentLabelmapImageToWorldMatrix)
     multiLabelImage.SetGeometryFromImageToWorldMatrix(selectedSegmentLabelmapImageToWorldMatrix)
 
-    # Import multi-label labelmap to segmentation
+    # Import multi-label labelmap to segmentation. Island labels are not cast to unsigned char,
+    # so there is no limit on the number of islands. Each island is extracted within its bounding box.
     segmentationNode = self.scriptedEffect.parameterSetNode().GetSegmentationNode()
     selectedSegmentID = self.scriptedEffect.parameterSetNode().GetSelectedSegmentID()
     selectedSegmentName = segmentationNode.GetSegmentation().GetSegment(selectedSegmentID).GetName()
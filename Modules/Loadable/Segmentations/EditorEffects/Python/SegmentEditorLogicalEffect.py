@@ -195,8 +195,9 @@ class SegmentEditorLogicalEffect(AbstractScriptedSegmentEditorEffect):
       if not modifierSegmentID:
         logging.error("Operation {0} requires a selected modifier segment".format(operation))
         return
-      modifierSegment = segmentation.GetSegment(modifierSegmentID)
-      modifierSegmentLabelmap = modifierSegment.GetRepresentation(vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName())
+      # Modifier segment may share its labelmap with other segments, so only get its own voxels
+      modifierSegmentLabelmap = vtkSegmentationCore.vtkOrientedImageData()
+      segmentation.GetBinaryLabelmapRepresentation(modifierSegmentID, modifierSegmentLabelmap)
 
       if operation == LOGICAL_COPY:
         if bypassMasking:
@@ -219,6 +220,12 @@ class SegmentEditorLogicalEffect(AbstractScriptedSegmentEditorEffect):
           self.scriptedEffect.modifySelectedSegmentByLabelmap(modifierSegmentLabelmap, slicer.qSlicerSegmentEditorAbstractEffect.ModificationModeRemove)
       elif operation == LOGICAL_INTERSECT:
         selectedSegmentLabelmap = self.scriptedEffect.selectedSegmentLabelmap()
+        if not vtkSegmentationCore.vtkOrientedImageDataResample.DoGeometriesMatch(selectedSegmentLabelmap, modifierSegmentLabelmap):
+          # Extents below are in the IJK coordinate system of the selected segment
+          resampledModifierSegmentLabelmap = vtkSegmentationCore.vtkOrientedImageData()
+          vtkSegmentationCore.vtkOrientedImageDataResample.ResampleOrientedImageToReferenceOrientedImage(
+            modifierSegmentLabelmap, selectedSegmentLabelmap, resampledModifierSegmentLabelmap)
+          modifierSegmentLabelmap = resampledModifierSegmentLabelmap
         intersectionLabelmap = vtkSegmentationCore.vtkOrientedImageData()
         vtkSegmentationCore.vtkOrientedImageDataResample.MergeImage(selectedSegmentLabelmap, modifierSegmentLabelmap, intersectionLabelmap, vtkSegmentationCore.vtkOrientedImageDataResample.OPERATION_MINIMUM, selectedSegmentLabelmap.GetExtent())
         selectedSegmentLabelmapExtent = selectedSegmentLabelmap.GetExtent()
@@ -45,12 +45,12 @@ class SegmentEditorMarginEffect(AbstractScriptedSegmentEditorEffect):
     self.marginSizeMmSpinBox.value = 3.0
     self.marginSizeMmSpinBox.singleStep = 1.0
 
-    self.kernelSizePixel = qt.QLabel()
-    self.kernelSizePixel.setToolTip("Size change in pixels. Computed from the segment's spacing and the specified margin size.")
+    self.marginSizeVoxel = qt.QLabel()
+    self.marginSizeVoxel.setToolTip("Margin size in voxels along each axis. Computed from the segment's spacing and the specified margin size.")
 
     marginSizeFrame = qt.QHBoxLayout()
     marginSizeFrame.addWidget(self.marginSizeMmSpinBox)
-    marginSizeFrame.addWidget(self.kernelSizePixel)
+    marginSizeFrame.addWidget(self.marginSizeVoxel)
     self.marginSizeMmLabel = self.scriptedEffect.addLabeledOptionsWidget("Margin size:", marginSizeFrame)
 
     self.applyButton = qt.QPushButton("Apply")
@@ -70,16 +70,17 @@ class SegmentEditorMarginEffect(AbstractScriptedSegmentEditorEffect):
   def setMRMLDefaults(self):
     self.scriptedEffect.setParameterDefault("MarginSizeMm", 3)
 
-  def getKernelSizePixel(self):
-    selectedSegmentLabelmapSpacing = [1.0, 1.0, 1.0]
+  def getSelectedSegmentLabelmapSpacing(self):
     selectedSegmentLabelmap = self.scriptedEffect.selectedSegmentLabelmap()
     if selectedSegmentLabelmap:
-      selectedSegmentLabelmapSpacing = selectedSegmentLabelmap.GetSpacing()
+      return selectedSegmentLabelmap.GetSpacing()
+    return [1.0, 1.0, 1.0]
 
-    # size rounded to nearest odd number. If kernel size is even then image gets shifted.
+  def getMarginSizeVoxel(self):
+    # The margin is applied using the exact Euclidean distance, so it does not have to be a whole number of voxels
+    selectedSegmentLabelmapSpacing = self.getSelectedSegmentLabelmapSpacing()
     marginSizeMm = abs(self.scriptedEffect.doubleParameter("MarginSizeMm"))
-    kernelSizePixel = [int(round((marginSizeMm / selectedSegmentLabelmapSpacing[componentIndex]+1)/2)*2-1) for componentIndex in range(3)]
-    return kernelSizePixel
+    return [marginSizeMm / selectedSegmentLabelmapSpacing[componentIndex] for componentIndex in range(3)]
 
   def updateGUIFromMRML(self):
     marginSizeMm = self.scriptedEffect.doubleParameter("MarginSizeMm")
@@ -95,13 +96,13 @@ class SegmentEditorMarginEffect(AbstractScriptedSegmentEditorEffect):
     self.shrinkOptionRadioButton.setChecked(marginSizeMm < 0)
     self.shrinkOptionRadioButton.blockSignals(wasBlocked)
 
-    kernelSizePixel = self.getKernelSizePixel()
-
-    if kernelSizePixel[0]<=1 and kernelSizePixel[1]<=1 and kernelSizePixel[2]<=1:
-      self.kernelSizePixel.text = "margin too small"
+    # Margin smaller than the smallest voxel size would not change the segment
+    if abs(marginSizeMm) < min(self.getSelectedSegmentLabelmapSpacing()):
+      self.marginSizeVoxel.text = "margin too small"
       self.applyButton.setEnabled(False)
     else:
-      self.kernelSizePixel.text = "{0}x{1}x{2} pixels".format(abs(kernelSizePixel[0]), abs(kernelSizePixel[1]), abs(kernelSizePixel[2]))
+      marginSizeVoxel = self.getMarginSizeVoxel()
+      self.marginSizeVoxel.text = "{0:.1f}x{1:.1f}x{2:.1f} voxels".format(marginSizeVoxel[0], marginSizeVoxel[1], marginSizeVoxel[2])
       self.applyButton.setEnabled(True)
 
   def growOperationToggled(self, toggled):
@@ -125,35 +126,12 @@ class SegmentEditorMarginEffect(AbstractScriptedSegmentEditorEffect):
     selectedSegmentLabelmap = self.scriptedEffect.selectedSegmentLabelmap()
 
     marginSizeMm = self.scriptedEffect.doubleParameter("MarginSizeMm")
-    kernelSizePixel = self.getKernelSizePixel()
-
-    # We need to know exactly the value of the segment voxels, apply threshold to make force the selected label value
-    labelValue = 1
-    backgroundValue = 0
-    thresh = vtk.vtkImageThreshold()
-    thresh.SetInputData(selectedSegmentLabelmap)
-    thresh.ThresholdByLower(0)
-    thresh.SetInValue(backgroundValue)
-    thresh.SetOutValue(labelValue)
-    thresh.SetOutputScalarType(selectedSegmentLabelmap.GetScalarType())
-
-    erodeDilate = vtk.vtkImageDilateErode3D()
-    erodeDilate.SetInputConnection(thresh.GetOutputPort())
-    if marginSizeMm>0:
-      # grow
-      erodeDilate.SetDilateValue(labelValue)
-      erodeDilate.SetErodeValue(backgroundValue)
-    else:
-      # shrink
-      erodeDilate.SetDilateValue(backgroundValue)
-      erodeDilate.SetErodeValue(labelValue)
 
     # This can be a long operation - indicate it to the user
     qt.QApplication.setOverrideCursor(qt.Qt.WaitCursor)
 
-    erodeDilate.SetKernelSize(kernelSizePixel[0],kernelSizePixel[1],kernelSizePixel[2])
-    erodeDilate.Update()
-    modifierLabelmap.DeepCopy(erodeDilate.GetOutput())
+    # Threshold the exact Euclidean distance from the segment (grow) or from the background (shrink)
+    slicer.vtkSlicerSegmentationsModuleLogic.ApplyMarginToBinaryLabelmap(selectedSegmentLabelmap, modifierLabelmap, marginSizeMm)
 
     # Apply changes
     self.scriptedEffect.modifySelectedSegmentByLabelmap(modifierLabelmap, slicer.qSlicerSegmentEditorAbstractEffect.ModificationModeSet)
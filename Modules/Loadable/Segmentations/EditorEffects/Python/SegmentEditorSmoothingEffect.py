@@ -215,38 +215,20 @@ class SegmentEditorSmoothingEffect(AbstractScriptedSegmentEditorEffect):
         thresh2.Update()
         modifierLabelmap.DeepCopy(thresh2.GetOutput())
 
-      else:
+      elif smoothingMethod == MEDIAN:
         # size rounded to nearest odd number. If kernel size is even then image gets shifted.
         kernelSizePixel = self.getKernelSizePixel()
+        # Median of a binary labelmap is the majority vote, computed by running sums in the effective extent
+        slicer.vtkBinaryLabelmapMorphology.ApplyMedian(selectedSegmentLabelmap, modifierLabelmap, kernelSizePixel)
 
-        if smoothingMethod == MEDIAN:
-          # Median filter does not require a particular label value
-          smoothingFilter = vtk.vtkImageMedian3D()
-          smoothingFilter.SetInputData(selectedSegmentLabelmap)
-
-        else:
-          # We need to know exactly the value of the segment voxels, apply threshold to make force the selected label value
-          labelValue = 1
-          backgroundValue = 0
-          thresh = vtk.vtkImageThreshold()
-          thresh.SetInputData(selectedSegmentLabelmap)
-          thresh.ThresholdByLower(0)
-          thresh.SetInValue(backgroundValue)
-          thresh.SetOutValue(labelValue)
-          thresh.SetOutputScalarType(selectedSegmentLabelmap.GetScalarType())
-
-          smoothingFilter = vtk.vtkImageOpenClose3D()
-          smoothingFilter.SetInputConnection(thresh.GetOutputPort())
-          if smoothingMethod == MORPHOLOGICAL_OPENING:
-            smoothingFilter.SetOpenValue(labelValue)
-            smoothingFilter.SetCloseValue(backgroundValue)
-          else: # must be smoothingMethod == MORPHOLOGICAL_CLOSING:
-            smoothingFilter.SetOpenValue(backgroundValue)
-            smoothingFilter.SetCloseValue(labelValue)
-
-        smoothingFilter.SetKernelSize(kernelSizePixel[0],kernelSizePixel[1],kernelSizePixel[2])
-        smoothingFilter.Update()
-        modifierLabelmap.DeepCopy(smoothingFilter.GetOutput())
+      else:
+        # Opening and closing with an isotropic ball computed from exact distance transform,
+        # so the kernel size is not rounded to whole voxels
+        kernelRadiusMm = self.scriptedEffect.doubleParameter("KernelSizeMm") / 2.0
+        if smoothingMethod == MORPHOLOGICAL_OPENING:
+          slicer.vtkBinaryLabelmapMorphology.ApplyOpening(selectedSegmentLabelmap, modifierLabelmap, kernelRadiusMm)
+        else: # must be smoothingMethod == MORPHOLOGICAL_CLOSING:
+          slicer.vtkBinaryLabelmapMorphology.ApplyClosing(selectedSegmentLabelmap, modifierLabelmap, kernelRadiusMm)
 
     except IndexError:
       logging.error('apply: Failed to apply smoothing')
@@ -277,69 +259,30 @@ class SegmentEditorSmoothingEffect(AbstractScriptedSegmentEditorEffect):
       segmentId = visibleSegmentIds.GetValue(i)
       segmentLabelValues.append([segmentId, i+1])
 
-    # Perform smoothing in voxel space
-    ici = vtk.vtkImageChangeInformation()
-    ici.SetInputData(mergedImage)
-    ici.SetOutputSpacing(1, 1, 1)
-    ici.SetOutputOrigin(0, 0, 0)
-
-    # Convert labelmap to combined polydata
-    convertToPolyData = vtk.vtkDiscreteMarchingCubes()
-    convertToPolyData.SetInputConnection(ici.GetOutputPort())
-    convertToPolyData.SetNumberOfContours(len(segmentLabelValues))
-    contourIndex = 0
-    for segmentId, labelValue in segmentLabelValues:
-      convertToPolyData.SetValue(contourIndex, labelValue)
-      contourIndex += 1
-
-    # Low-pass filtering using Taubin's method
+    # Smooth indicator functions of all labels in voxel space and assign each voxel to the label
+    # with the highest smoothed value, so segments remain non-overlapping and no gaps are created between them
     smoothingFactor = self.scriptedEffect.doubleParameter("JointTaubinSmoothingFactor")
-    smoothingIterations = 100 #  according to VTK documentation 10-20 iterations could be enough but we use a higher value to reduce chance of shrinking
-    passBand = pow(10.0, -4.0*smoothingFactor) # gives a nice range of 1-0.0001 from a user input of 0-1
-    smoother = vtk.vtkWindowedSincPolyDataFilter()
-    smoother.SetInputConnection(convertToPolyData.GetOutputPort())
-    smoother.SetNumberOfIterations(smoothingIterations)
-    smoother.BoundarySmoothingOff()
-    smoother.FeatureEdgeSmoothingOff()
-    smoother.SetFeatureAngle(90.0)
-    smoother.SetPassBand(passBand)
-    smoother.NonManifoldSmoothingOn()
-    smoother.NormalizeCoordinatesOn()
+    standardDeviationMm = smoothingFactor * 2.0 * min(mergedImage.GetSpacing()) # up to 2 voxels
+    smoothedImage = vtkSegmentationCore.vtkOrientedImageData()
+    if not slicer.vtkLabelmapJointSmoothing.Smooth(mergedImage, smoothedImage, standardDeviationMm):
+      logging.error('Failed to apply smoothing')
+      return
 
     # Extract a label
-    threshold = vtk.vtkThreshold()
-    threshold.SetInputConnection(smoother.GetOutputPort())
-
-    # Convert to polydata
-    geometryFilter = vtk.vtkGeometryFilter()
-    geometryFilter.SetInputConnection(threshold.GetOutputPort())
-
-    # Convert polydata to stencil
-    polyDataToImageStencil = vtk.vtkPolyDataToImageStencil()
-    polyDataToImageStencil.SetInputConnection(geometryFilter.GetOutputPort())
-    polyDataToImageStencil.SetOutputSpacing(1,1,1)
-    polyDataToImageStencil.SetOutputOrigin(0,0,0)
-    polyDataToImageStencil.SetOutputWholeExtent(mergedImage.GetExtent())
-
-    # Convert stencil to image
-    stencil = vtk.vtkImageStencil()
-    emptyBinaryLabelMap = vtk.vtkImageData()
-    emptyBinaryLabelMap.SetExtent(mergedImage.GetExtent())
-    emptyBinaryLabelMap.AllocateScalars(vtk.VTK_UNSIGNED_CHAR, 1)
-    vtkSegmentationCore.vtkOrientedImageDataResample.FillImage(emptyBinaryLabelMap, 0)
-    stencil.SetInputData(emptyBinaryLabelMap)
-    stencil.SetStencilConnection(polyDataToImageStencil.GetOutputPort())
-    stencil.ReverseStencilOn()
-    stencil.SetBackgroundValue(1) # General foreground value is 1 (background value because of reverse stencil)
+    threshold = vtk.vtkImageThreshold()
+    threshold.SetInputData(smoothedImage)
+    threshold.SetInValue(1)
+    threshold.SetOutValue(0)
+    threshold.SetOutputScalarType(vtk.VTK_UNSIGNED_CHAR)
 
     imageToWorldMatrix = vtk.vtkMatrix4x4()
-    mergedImage.GetImageToWorldMatrix(imageToWorldMatrix)
+    smoothedImage.GetImageToWorldMatrix(imageToWorldMatrix)
 
     for segmentId, labelValue in segmentLabelValues:
       threshold.ThresholdBetween(labelValue, labelValue)
-      stencil.Update()
+      threshold.Update()
       smoothedBinaryLabelMap = vtkSegmentationCore.vtkOrientedImageData()
-      smoothedBinaryLabelMap.ShallowCopy(stencil.GetOutput())
+      smoothedBinaryLabelMap.ShallowCopy(threshold.GetOutput())
       smoothedBinaryLabelMap.SetImageToWorldMatrix(imageToWorldMatrix)
       # Write results to segments directly, bypassing masking
       slicer.vtkSlicerSegmentationsModuleLogic.SetBinaryLabelmapToSegment(smoothedBinaryLabelMap,
@@ -17,14 +17,11 @@ class SegmentEditorThresholdEffect(AbstractScriptedSegmentEditorEffect):
     scriptedEffect.name = 'Threshold'
 
     # Effect-specific members
-    self.timer = qt.QTimer()
-    self.previewState = 0
-    self.previewStep = 1
-    self.previewSteps = 5
-    self.timer.connect('timeout()', self.preview)
-
+    self.previewOpacity = 0.75
     self.previewPipelines = {}
-    self.setupPreviewDisplay()
+
+    # Cumulative histogram of the master volume for instant voxel count feedback
+    self.masterVolumeHistogram = slicer.vtkImageThresholdHistogram()
 
   def clone(self):
     import qSlicerSegmentationsEditorEffectsPythonQt as effects
@@ -55,9 +52,9 @@ class SegmentEditorThresholdEffect(AbstractScriptedSegmentEditorEffect):
     # Update intensity range
     self.masterVolumeNodeChanged()
 
-    # Setup and start preview pulse
+    # Setup preview display. It is updated when threshold parameters change and
+    # re-rendered with the slice views, there is no need for polling.
     self.setupPreviewDisplay()
-    self.timer.start(200)
 
   def deactivate(self):
     # Restore segment opacity
@@ -68,9 +65,8 @@ class SegmentEditorThresholdEffect(AbstractScriptedSegmentEditorEffect):
       displayNode.SetSegmentOpacity2DFill(segmentID, self.segment2DFillOpacity)
       displayNode.SetSegmentOpacity2DOutline(segmentID, self.segment2DOutlineOpacity)
 
-    # Clear preview pipeline and stop timer
+    # Clear preview pipeline
     self.clearPreviewDisplay()
-    self.timer.stop()
 
   def setupOptionsFrame(self):
     self.thresholdSliderLabel = qt.QLabel("Threshold Range:")
@@ -82,6 +78,10 @@ class SegmentEditorThresholdEffect(AbstractScriptedSegmentEditorEffect):
     self.thresholdSlider.singleStep = 0.01
     self.scriptedEffect.addOptionsWidget(self.thresholdSlider)
 
+    self.voxelCountLabel = qt.QLabel()
+    self.voxelCountLabel.setToolTip("Number of master volume voxels and their total volume within the threshold range.")
+    self.scriptedEffect.addOptionsWidget(self.voxelCountLabel)
+
     self.useForPaintButton = qt.QPushButton("Use For Paint")
     self.useForPaintButton.setToolTip("Transfer the current threshold settings to be used for labeling operations such as Paint and Draw.")
     self.scriptedEffect.addOptionsWidget(self.useForPaintButton)
@@ -103,6 +103,7 @@ class SegmentEditorThresholdEffect(AbstractScriptedSegmentEditorEffect):
     # Set scalar range of master volume image data to threshold slider
     import vtkSegmentationCorePython as vtkSegmentationCore
     masterImageData = self.scriptedEffect.masterVolumeImageData()
+    self.masterVolumeHistogram.SetInputData(masterImageData)
     if masterImageData:
       lo, hi = masterImageData.GetScalarRange()
       self.thresholdSlider.minimum, self.thresholdSlider.maximum = lo, hi
@@ -130,6 +131,8 @@ class SegmentEditorThresholdEffect(AbstractScriptedSegmentEditorEffect):
     self.thresholdSlider.setMinimumValue(self.scriptedEffect.doubleParameter("MinimumThreshold"))
     self.thresholdSlider.setMaximumValue(self.scriptedEffect.doubleParameter("MaximumThreshold"))
     self.thresholdSlider.blockSignals(False)
+    self.updateVoxelCount(self.thresholdSlider.minimumValue, self.thresholdSlider.maximumValue)
+    self.updatePreview()
 
   def updateMRMLFromGUI(self):
     self.scriptedEffect.setParameter("MinimumThreshold", self.thresholdSlider.minimumValue)
@@ -139,8 +142,19 @@ class SegmentEditorThresholdEffect(AbstractScriptedSegmentEditorEffect):
   # Effect specific methods (the above ones are the API methods to override)
   #
   def onThresholdValuesChanged(self,min,max):
+    self.updateVoxelCount(min, max)
     self.scriptedEffect.updateMRMLFromGUI()
 
+  def updateVoxelCount(self, min, max):
+    masterImageData = self.masterVolumeHistogram.GetInputData()
+    if masterImageData is None:
+      self.voxelCountLabel.text = ""
+      return
+    voxelCount = self.masterVolumeHistogram.GetNumberOfVoxelsInRange(min, max)
+    spacing = masterImageData.GetSpacing()
+    volumeMm3 = voxelCount * spacing[0] * spacing[1] * spacing[2]
+    self.voxelCountLabel.text = "Voxels in range: {0} ({1:.2f} cc)".format(voxelCount, volumeMm3 / 1000.0)
+
   def onUseForPaint(self):
     parameterSetNode = self.scriptedEffect.parameterSetNode()
     parameterSetNode.MasterVolumeIntensityMaskOn()
@@ -203,44 +217,42 @@ class SegmentEditorThresholdEffect(AbstractScriptedSegmentEditorEffect):
         logging.error("setupPreviewDisplay: Failed to get renderer!")
         continue
 
-      # Create pipeline
+      # Create pipeline. Preview is computed from the resliced background volume that
+      # the slice logic already computes, it is only updated when the slice or the threshold changes.
       pipeline = PreviewPipeline()
+      backgroundLogic = sliceWidget.sliceLogic().GetBackgroundLayer()
+      pipeline.thresholdPreview.SetInputConnection(backgroundLogic.GetReslice().GetOutputPort())
       self.previewPipelines[sliceWidget] = pipeline
 
       # Add actor
       self.scriptedEffect.addActor2D(sliceWidget, pipeline.actor)
 
-  def preview(self):
-    opacity = 0.5 + self.previewState / (2. * self.previewSteps)
+    self.updatePreview()
+
+  def updatePreview(self):
+    if not self.previewPipelines:
+      return
     min = self.scriptedEffect.doubleParameter("MinimumThreshold")
     max = self.scriptedEffect.doubleParameter("MaximumThreshold")
 
     # Get color of edited segment
     segmentationNode = self.scriptedEffect.parameterSetNode().GetSegmentationNode()
-    displayNode = segmentationNode.GetDisplayNode()
-    if displayNode is None:
-      logging.error("preview: Invalid segmentation display node!")
-      color = [0.5,0.5,0.5]
     segmentID = self.scriptedEffect.parameterSetNode().GetSelectedSegmentID()
-    r,g,b = segmentationNode.GetSegmentation().GetSegment(segmentID).GetColor()
-
-    # Set values to pipelines
+    segment = segmentationNode.GetSegmentation().GetSegment(segmentID) if segmentationNode else None
+    if segment is None:
+      logging.error("updatePreview: Invalid selected segment!")
+      r,g,b = [0.5,0.5,0.5]
+    else:
+      r,g,b = segment.GetColor()
+
+    # Set values to pipelines. Filters only execute if the values are actually changed.
     for sliceWidget in self.previewPipelines:
       pipeline = self.previewPipelines[sliceWidget]
-      pipeline.lookupTable.SetTableValue(1,  r, g, b,  opacity)
-      sliceLogic = sliceWidget.sliceLogic()
-      backgroundLogic = sliceLogic.GetBackgroundLayer()
-      pipeline.thresholdFilter.SetInputConnection(backgroundLogic.GetReslice().GetOutputPort())
-      pipeline.thresholdFilter.ThresholdBetween(min, max)
+      pipeline.thresholdPreview.SetColor(r, g, b, self.previewOpacity)
+      pipeline.thresholdPreview.ThresholdBetween(min, max)
       pipeline.actor.VisibilityOn()
       sliceWidget.sliceView().scheduleRender()
 
-    self.previewState += self.previewStep
-    if self.previewState >= self.previewSteps:
-      self.previewStep = -1
-    if self.previewState <= 0:
-      self.previewStep = 1
-
 #
 # PreviewPipeline
 #
@@ -249,18 +261,8 @@ class PreviewPipeline:
   """
 
   def __init__(self):
-    self.lookupTable = vtk.vtkLookupTable()
-    self.lookupTable.SetRampToLinear()
-    self.lookupTable.SetNumberOfTableValues(2)
-    self.lookupTable.SetTableRange(0, 1)
-    self.lookupTable.SetTableValue(0,  0, 0, 0,  0)
-    self.colorMapper = vtk.vtkImageMapToRGBA()
-    self.colorMapper.SetOutputFormatToRGBA()
-    self.colorMapper.SetLookupTable(self.lookupTable)
-    self.thresholdFilter = vtk.vtkImageThreshold()
-    self.thresholdFilter.SetInValue(1)
-    self.thresholdFilter.SetOutValue(0)
-    self.thresholdFilter.SetOutputScalarTypeToUnsignedChar()
+    # Threshold and color mapping in one pass
+    self.thresholdPreview = slicer.vtkImageThresholdPreview()
 
     # Feedback actor
     self.mapper = vtk.vtkImageMapper()
@@ -274,5 +276,4 @@ class PreviewPipeline:
     self.mapper.SetColorLevel(128)
 
     # Setup pipeline
-    self.colorMapper.SetInputConnection(self.thresholdFilter.GetOutputPort())
-    self.mapper.SetInputConnection(self.colorMapper.GetOutputPort())
+    self.mapper.SetInputConnection(self.thresholdPreview.GetOutputPort())
@@ -26,6 +26,8 @@
 #include "vtkMRMLSegmentationDisplayNode.h"
 #include "vtkMRMLSegmentEditorNode.h"
 #include "vtkOrientedImageData.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
 #include "vtkSlicerSegmentationsModuleLogic.h"
 
 // Qt includes
@@ -64,10 +66,187 @@
 #include <vtkRenderWindow.h>
 #include <vtkRenderWindowInteractor.h>
 #include <vtkSmartPointer.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
 #include <vtkWeakPointer.h>
 
 #include <vtkOrientedImageDataResample.h>
 
+// STD includes
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+/// Labelmap of overwritten segments in which the editable voxels are cleared.
+/// Segments sharing a labelmap layer are cleared in the same target, ClearedLabels
+/// tells which voxel values belong to overwritten segments.
+struct OverwriteTarget
+{
+  vtkOrientedImageData* Labelmap;
+  int Extent[6]; // part of the labelmap extent that is inside the modified region
+  bool ClearedLabels[256];
+};
+
+//-----------------------------------------------------------------------------
+/// Computes the editable region of the modifier labelmap and clears it in the overwritten
+/// segment labelmaps. Voxels of the modifier labelmap are erased where the mask labelmap is
+/// non-zero or where the master volume intensity is outside of the intensity range.
+/// Voxels outside of the master volume extent are not editable, voxels outside of the mask
+/// labelmap extent are.
+/// All images must have the same lattice, modifier, mask and target labelmaps are unsigned char.
+/// Slices are processed in parallel.
+template <class MasterType>
+class EditableRegionFunctor
+{
+public:
+  EditableRegionFunctor(vtkImageData* modifierLabelmap, const int extent[6], vtkImageData* maskLabelmap,
+    vtkImageData* masterVolume, const double intensityRange[2], unsigned char eraseValue, std::vector<OverwriteTarget>& targets)
+    : ModifierLabelmap(modifierLabelmap)
+    , MaskLabelmap(maskLabelmap)
+    , MasterVolume(masterVolume)
+    , EraseValue(eraseValue)
+    , Targets(targets)
+  {
+    std::copy(extent, extent + 6, this->Extent);
+    this->IntensityRange[0] = intensityRange[0];
+    this->IntensityRange[1] = intensityRange[1];
+    if (maskLabelmap)
+      {
+      maskLabelmap->GetExtent(this->MaskExtent);
+      }
+    if (masterVolume)
+      {
+      masterVolume->GetExtent(this->MasterExtent);
+      }
+  }
+
+  void Initialize()
+  {
+    this->TargetModified.Local().assign(this->Targets.size(), 0);
+  }
+
+  void operator()(vtkIdType kBegin, vtkIdType kEnd)
+  {
+    std::vector<char>& targetModified = this->TargetModified.Local();
+    std::vector<unsigned char*> targetRows(this->Targets.size(), NULL);
+    for (int k = static_cast<int>(kBegin); k < static_cast<int>(kEnd); k++)
+      {
+      for (int j = this->Extent[2]; j <= this->Extent[3]; j++)
+        {
+        unsigned char* modifierPtr = static_cast<unsigned char*>(this->ModifierLabelmap->GetScalarPointer(this->Extent[0], j, k));
+        unsigned char* maskRow = NULL;
+        if (this->MaskLabelmap && j >= this->MaskExtent[2] && j <= this->MaskExtent[3] && k >= this->MaskExtent[4] && k <= this->MaskExtent[5])
+          {
+          maskRow = static_cast<unsigned char*>(this->MaskLabelmap->GetScalarPointer(this->MaskExtent[0], j, k));
+          }
+        MasterType* masterRow = NULL;
+        if (this->MasterVolume && j >= this->MasterExtent[2] && j <= this->MasterExtent[3] && k >= this->MasterExtent[4] && k <= this->MasterExtent[5])
+          {
+          masterRow = static_cast<MasterType*>(this->MasterVolume->GetScalarPointer(this->MasterExtent[0], j, k));
+          }
+        for (size_t targetIndex = 0; targetIndex < this->Targets.size(); targetIndex++)
+          {
+          const int* targetExtent = this->Targets[targetIndex].Extent;
+          targetRows[targetIndex] = NULL;
+          if (j >= targetExtent[2] && j <= targetExtent[3] && k >= targetExtent[4] && k <= targetExtent[5])
+            {
+            targetRows[targetIndex] = static_cast<unsigned char*>(this->Targets[targetIndex].Labelmap->GetScalarPointer(targetExtent[0], j, k));
+            }
+          }
+
+        for (int i = this->Extent[0]; i <= this->Extent[1]; i++, modifierPtr++)
+          {
+          if (*modifierPtr == 0)
+            {
+            continue;
+            }
+          // Voxels outside of the mask labelmap extent are editable (same as padding the mask with 0)
+          if (maskRow && i >= this->MaskExtent[0] && i <= this->MaskExtent[1] && maskRow[i - this->MaskExtent[0]] != 0)
+            {
+            *modifierPtr = this->EraseValue;
+            continue;
+            }
+          if (this->MasterVolume)
+            {
+            if (!masterRow || i < this->MasterExtent[0] || i > this->MasterExtent[1])
+              {
+              *modifierPtr = this->EraseValue;
+              continue;
+              }
+            double intensity = static_cast<double>(masterRow[i - this->MasterExtent[0]]);
+            if (intensity < this->IntensityRange[0] || intensity > this->IntensityRange[1])
+              {
+              *modifierPtr = this->EraseValue;
+              continue;
+              }
+            }
+          for (size_t targetIndex = 0; targetIndex < this->Targets.size(); targetIndex++)
+            {
+            const OverwriteTarget& target = this->Targets[targetIndex];
+            if (!targetRows[targetIndex] || i < target.Extent[0] || i > target.Extent[1])
+              {
+              continue;
+              }
+            unsigned char& targetVoxel = targetRows[targetIndex][i - target.Extent[0]];
+            if (targetVoxel != 0 && target.ClearedLabels[targetVoxel])
+              {
+              targetVoxel = 0;
+              targetModified[targetIndex] = 1;
+              }
+            }
+          }
+        }
+      }
+  }
+
+  void Reduce()
+  {
+  }
+
+  vtkSMPThreadLocal< std::vector<char> > TargetModified;
+
+protected:
+  vtkImageData* ModifierLabelmap;
+  vtkImageData* MaskLabelmap;
+  vtkImageData* MasterVolume;
+  int Extent[6];
+  int MaskExtent[6];
+  int MasterExtent[6];
+  double IntensityRange[2];
+  unsigned char EraseValue;
+  std::vector<OverwriteTarget>& Targets;
+};
+
+//-----------------------------------------------------------------------------
+template <class MasterType>
+void ApplyEditableRegion(vtkImageData* modifierLabelmap, const int extent[6], vtkImageData* maskLabelmap,
+  vtkImageData* masterVolume, const double intensityRange[2], unsigned char eraseValue,
+  std::vector<OverwriteTarget>& targets, std::vector<bool>& targetModified)
+{
+  EditableRegionFunctor<MasterType> functor(modifierLabelmap, extent, maskLabelmap, masterVolume, intensityRange, eraseValue, targets);
+  vtkSMPTools::For(extent[4], extent[5] + 1, functor);
+
+  // Combine results of all threads
+  targetModified.assign(targets.size(), false);
+  typedef vtkSMPThreadLocal< std::vector<char> > ThreadLocalModifiedType;
+  for (typename ThreadLocalModifiedType::iterator threadIt = functor.TargetModified.begin();
+    threadIt != functor.TargetModified.end(); ++threadIt)
+    {
+    for (size_t targetIndex = 0; targetIndex < targets.size(); targetIndex++)
+      {
+      if ((*threadIt)[targetIndex])
+        {
+        targetModified[targetIndex] = true;
+        }
+      }
+    }
+}
+
+} // end of anonymous namespace
+
 //-----------------------------------------------------------------------------
 // qSlicerSegmentEditorAbstractEffectPrivate methods
 
@@ -254,8 +433,6 @@ void qSlicerSegmentEditorAbstractEffect::modifySelectedSegmentByLabelmap(vtkOrie
 //-----------------------------------------------------------------------------
 void qSlicerSegmentEditorAbstractEffect::modifySelectedSegmentByLabelmap(vtkOrientedImageData* modifierLabelmapInput, ModificationMode modificationMode, const int modificationExtent[6])
 {
-  Q_D(qSlicerSegmentEditorAbstractEffect);
-
   vtkMRMLSegmentEditorNode* parameterSetNode = this->parameterSetNode();
   if (!parameterSetNode)
     {
@@ -264,27 +441,115 @@ void qSlicerSegmentEditorAbstractEffect::modifySelectedSegmentByLabelmap(vtkOrie
     return;
     }
 
+  vtkMRMLSegmentationNode* segmentationNode = parameterSetNode->GetSegmentationNode();
+  const char* selectedSegmentID = parameterSetNode->GetSelectedSegmentID();
+  if (!segmentationNode || !selectedSegmentID)
+    {
+    qCritical() << Q_FUNC_INFO << ": Invalid segment selection";
+    this->defaultModifierLabelmap();
+    return;
+    }
+
+  if (!modifierLabelmapInput)
+    {
+    // If per-segment flag is off, then it is not an error (the effect itself has written it back to segmentation)
+    if (this->perSegment())
+      {
+      qCritical() << Q_FUNC_INFO << ": Cannot apply edit operation because modifier labelmap cannot be accessed";
+      }
+    this->defaultModifierLabelmap();
+    return;
+    }
+
   vtkSmartPointer<vtkOrientedImageData> modifierLabelmap = modifierLabelmapInput;
 
-  // Apply mask to modifier labelmap if paint over is turned off
-  if (parameterSetNode->GetMaskMode() != vtkMRMLSegmentEditorNode::PaintAllowedEverywhere)
+  const int* extent = modificationExtent;
+  if (extent[0]>extent[1] || extent[2]>extent[3] || extent[4]>extent[5])
     {
-    vtkOrientedImageData* maskImage = this->maskLabelmap();
+    // invalid extent, it means we have to work with the entire modifier labelmap
+    extent = NULL;
+    }
 
-    if (modifierLabelmap.GetPointer() == modifierLabelmapInput)
+  // Crop the modifier labelmap to the modified region so that masking, thresholding
+  // and overwriting of other segments only has to process the affected voxels.
+  int modifierExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  modifierLabelmapInput->GetExtent(modifierExtent);
+  int croppedExtent[6] = { modifierExtent[0], modifierExtent[1], modifierExtent[2], modifierExtent[3], modifierExtent[4], modifierExtent[5] };
+  if (extent)
+    {
+    for (int i = 0; i < 3; i++)
       {
-      // make a copy to not modify the input
-      vtkNew<vtkOrientedImageData> maskedModifierLabelmap;
-      maskedModifierLabelmap->DeepCopy(modifierLabelmap);
-      modifierLabelmap = maskedModifierLabelmap.GetPointer();
+      croppedExtent[i * 2] = std::max(extent[i * 2], modifierExtent[i * 2]);
+      croppedExtent[i * 2 + 1] = std::min(extent[i * 2 + 1], modifierExtent[i * 2 + 1]);
+      }
+    if (croppedExtent[0] > croppedExtent[1] || croppedExtent[2] > croppedExtent[3] || croppedExtent[4] > croppedExtent[5])
+      {
+      // modified region is outside of the modifier labelmap, there is nothing to do
+      return;
       }
-    this->applyImageMask(modifierLabelmap, maskImage, this->m_EraseValue, true);
+    if (croppedExtent[0] != modifierExtent[0] || croppedExtent[1] != modifierExtent[1]
+      || croppedExtent[2] != modifierExtent[2] || croppedExtent[3] != modifierExtent[3]
+      || croppedExtent[4] != modifierExtent[4] || croppedExtent[5] != modifierExtent[5])
+      {
+      vtkNew<vtkOrientedImageData> croppedModifierLabelmap;
+      vtkOrientedImageDataResample::CopyImage(modifierLabelmapInput, croppedModifierLabelmap.GetPointer(), croppedExtent);
+      modifierLabelmap = croppedModifierLabelmap.GetPointer();
+      }
+    extent = croppedExtent;
     }
 
-  // Apply threshold mask if paint threshold is turned on
+  std::vector<std::string> allSegmentIDs;
+  segmentationNode->GetSegmentation()->GetSegmentIDs(allSegmentIDs);
+  // remove selected segment, that is handled separately
+  allSegmentIDs.erase(std::remove(allSegmentIDs.begin(), allSegmentIDs.end(), selectedSegmentID), allSegmentIDs.end());
+
+  std::vector<std::string> visibleSegmentIDs;
+  vtkMRMLSegmentationDisplayNode* displayNode = vtkMRMLSegmentationDisplayNode::SafeDownCast(segmentationNode->GetDisplayNode());
+  if (displayNode)
+    {
+    for (std::vector<std::string>::iterator segmentIDIt = allSegmentIDs.begin(); segmentIDIt != allSegmentIDs.end(); ++segmentIDIt)
+      {
+      if (displayNode->GetSegmentVisibility(*segmentIDIt))
+        {
+        visibleSegmentIDs.push_back(*segmentIDIt);
+        }
+      }
+    }
+
+  std::vector<std::string> segmentIDsToOverwrite;
+  switch (parameterSetNode->GetOverwriteMode())
+    {
+  case vtkMRMLSegmentEditorNode::OverwriteNone:
+    // nothing to overwrite
+    break;
+  case vtkMRMLSegmentEditorNode::OverwriteVisibleSegments:
+    segmentIDsToOverwrite = visibleSegmentIDs;
+    break;
+  case vtkMRMLSegmentEditorNode::OverwriteAllSegments:
+    segmentIDsToOverwrite = allSegmentIDs;
+    break;
+    }
+  // Segments that lose the voxels that are added to the selected segment
+  bool overwriteSegments = !segmentIDsToOverwrite.empty()
+    && (modificationMode == qSlicerSegmentEditorAbstractEffect::ModificationModeSet
+    || modificationMode == qSlicerSegmentEditorAbstractEffect::ModificationModeAdd);
+
+  vtkOrientedImageData* maskImage = NULL;
+  if (parameterSetNode->GetMaskMode() != vtkMRMLSegmentEditorNode::PaintAllowedEverywhere)
+    {
+    maskImage = this->maskLabelmap();
+    if (!maskImage)
+      {
+      qCritical() << Q_FUNC_INFO << ": Unable to get mask labelmap";
+      this->defaultModifierLabelmap();
+      return;
+      }
+    }
+
+  vtkOrientedImageData* masterVolumeOrientedImageData = NULL;
   if (parameterSetNode->GetMasterVolumeIntensityMask())
     {
-    vtkOrientedImageData* masterVolumeOrientedImageData = this->masterVolumeImageData();
+    masterVolumeOrientedImageData = this->masterVolumeImageData();
     if (!masterVolumeOrientedImageData)
       {
       qCritical() << Q_FUNC_INFO << ": Unable to get master volume image";
@@ -298,69 +563,186 @@ void qSlicerSegmentEditorAbstractEffect::modifySelectedSegmentByLabelmap(vtkOrie
       this->defaultModifierLabelmap();
       return;
       }
+    }
+
+  // Segments that could not be overwritten in the fused pass (their labelmap has a different lattice or
+  // scalar type than the modifier labelmap) are overwritten one by one after the selected segment is updated.
+  std::vector<std::string> segmentIDsToOverwriteSeparately;
 
-    // Create threshold image
-    vtkSmartPointer<vtkImageThreshold> threshold = vtkSmartPointer<vtkImageThreshold>::New();
-    threshold->SetInputData(masterVolumeOrientedImageData);
-    threshold->ThresholdBetween(parameterSetNode->GetMasterVolumeIntensityMaskRange()[0], parameterSetNode->GetMasterVolumeIntensityMaskRange()[1]);
-    threshold->SetInValue(1);
-    threshold->SetOutValue(0);
-    threshold->SetOutputScalarType(modifierLabelmap->GetScalarType());
-    threshold->Update();
-
-    vtkSmartPointer<vtkOrientedImageData> thresholdMask = vtkSmartPointer<vtkOrientedImageData>::New();
-    thresholdMask->DeepCopy(threshold->GetOutput());
-    vtkSmartPointer<vtkMatrix4x4> modifierLabelmapToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-    modifierLabelmap->GetImageToWorldMatrix(modifierLabelmapToWorldMatrix);
-    thresholdMask->SetGeometryFromImageToWorldMatrix(modifierLabelmapToWorldMatrix);
-
-    if (modifierLabelmap.GetPointer() == modifierLabelmapInput)
+  bool fusedUpdate = (modifierLabelmap->GetScalarType() == VTK_UNSIGNED_CHAR
+    && (!maskImage || (maskImage->GetScalarType() == VTK_UNSIGNED_CHAR
+      && vtkOrientedImageDataResample::DoGeometriesMatch(modifierLabelmap, maskImage))));
+  if (fusedUpdate)
+    {
+    // Compute the editable region (mask, intensity range) and clear it in the overwritten segments in one pass
+    std::vector<OverwriteTarget> overwriteTargets;
+    std::vector< std::vector<std::string> > overwriteTargetSegmentIDs;
+    vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
+    for (std::vector<std::string>::iterator segmentIDIt = segmentIDsToOverwrite.begin();
+      overwriteSegments && segmentIDIt != segmentIDsToOverwrite.end(); ++segmentIDIt)
       {
-      // make a copy to not modify the input
-      vtkNew<vtkOrientedImageData> maskedModifierLabelmap;
-      maskedModifierLabelmap->DeepCopy(modifierLabelmap);
-      modifierLabelmap = maskedModifierLabelmap.GetPointer();
+      vtkSegment* segment = segmentation->GetSegment(*segmentIDIt);
+      vtkOrientedImageData* segmentLabelmap = (segment ? vtkOrientedImageData::SafeDownCast(
+        segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName())) : NULL);
+      if (!segmentLabelmap || segmentLabelmap->GetScalarType() != VTK_UNSIGNED_CHAR
+        || !vtkOrientedImageDataResample::DoGeometriesMatch(modifierLabelmap, segmentLabelmap))
+        {
+        segmentIDsToOverwriteSeparately.push_back(*segmentIDIt);
+        continue;
+        }
+      int targetExtent[6] = { 0, -1, 0, -1, 0, -1 };
+      segmentLabelmap->GetExtent(targetExtent);
+      for (int i = 0; i < 3; i++)
+        {
+        targetExtent[i * 2] = std::max(targetExtent[i * 2], croppedExtent[i * 2]);
+        targetExtent[i * 2 + 1] = std::min(targetExtent[i * 2 + 1], croppedExtent[i * 2 + 1]);
+        }
+      if (targetExtent[0] > targetExtent[1] || targetExtent[2] > targetExtent[3] || targetExtent[4] > targetExtent[5])
+        {
+        // segment does not intersect the modified region
+        continue;
+        }
+      // Segments that share a labelmap layer are cleared in the same target
+      size_t targetIndex = 0;
+      for (; targetIndex < overwriteTargets.size(); targetIndex++)
+        {
+        if (overwriteTargets[targetIndex].Labelmap == segmentLabelmap)
+          {
+          break;
+          }
+        }
+      if (targetIndex == overwriteTargets.size())
+        {
+        OverwriteTarget target;
+        target.Labelmap = segmentLabelmap;
+        std::copy(targetExtent, targetExtent + 6, target.Extent);
+        std::fill(target.ClearedLabels, target.ClearedLabels + 256, false);
+        overwriteTargets.push_back(target);
+        overwriteTargetSegmentIDs.push_back(std::vector<std::string>());
+        }
+      if (segmentation->IsLayerBinaryLabelmap(segment))
+        {
+        overwriteTargets[targetIndex].ClearedLabels[segment->GetLabelValue() & 0xFF] = true;
+        }
+      else
+        {
+        std::fill(overwriteTargets[targetIndex].ClearedLabels + 1, overwriteTargets[targetIndex].ClearedLabels + 256, true);
+        }
+      overwriteTargetSegmentIDs[targetIndex].push_back(*segmentIDIt);
       }
-    this->applyImageMask(modifierLabelmap.GetPointer(), thresholdMask, this->m_EraseValue);
-    }
 
-  if (!d->ParameterSetNode)
-    {
-    qCritical() << Q_FUNC_INFO << ": Invalid segment editor parameter set node";
-    this->defaultModifierLabelmap();
-    return;
-    }
+    if (maskImage || masterVolumeOrientedImageData || !overwriteTargets.empty())
+      {
+      if ((maskImage || masterVolumeOrientedImageData) && modifierLabelmap.GetPointer() == modifierLabelmapInput)
+        {
+        // make a copy to not modify the input
+        vtkNew<vtkOrientedImageData> maskedModifierLabelmap;
+        maskedModifierLabelmap->DeepCopy(modifierLabelmap);
+        modifierLabelmap = maskedModifierLabelmap.GetPointer();
+        }
 
-  vtkMRMLSegmentationNode* segmentationNode = d->ParameterSetNode->GetSegmentationNode();
-  const char* selectedSegmentID = d->ParameterSetNode->GetSelectedSegmentID();
-  if (!segmentationNode || !selectedSegmentID)
-    {
-    qCritical() << Q_FUNC_INFO << ": Invalid segment selection";
-    this->defaultModifierLabelmap();
-    return;
-    }
+      std::vector<bool> targetModified(overwriteTargets.size(), false);
+      double intensityRange[2] = { parameterSetNode->GetMasterVolumeIntensityMaskRange()[0], parameterSetNode->GetMasterVolumeIntensityMaskRange()[1] };
+      if (masterVolumeOrientedImageData)
+        {
+        switch (masterVolumeOrientedImageData->GetScalarType())
+          {
+          vtkTemplateMacro(ApplyEditableRegion<VTK_TT>(modifierLabelmap, croppedExtent, maskImage,
+            masterVolumeOrientedImageData, intensityRange, static_cast<unsigned char>(this->m_EraseValue), overwriteTargets, targetModified));
+          default:
+            qCritical() << Q_FUNC_INFO << ": Unknown master volume scalar type";
+          }
+        }
+      else
+        {
+        ApplyEditableRegion<unsigned char>(modifierLabelmap, croppedExtent, maskImage,
+          NULL, intensityRange, static_cast<unsigned char>(this->m_EraseValue), overwriteTargets, targetModified);
+        }
+      modifierLabelmap->Modified();
 
-  if (!modifierLabelmap)
+      // Re-convert other representations of the overwritten segments and update their display
+      std::vector<std::string> modifiedSegmentIDs;
+      for (size_t targetIndex = 0; targetIndex < overwriteTargets.size(); targetIndex++)
+        {
+        if (targetModified[targetIndex])
+          {
+          modifiedSegmentIDs.insert(modifiedSegmentIDs.end(),
+            overwriteTargetSegmentIDs[targetIndex].begin(), overwriteTargetSegmentIDs[targetIndex].end());
+          }
+        }
+      if (!modifiedSegmentIDs.empty())
+        {
+        vtkSlicerSegmentationsModuleLogic::NotifyBinaryLabelmapsModified(segmentationNode, modifiedSegmentIDs);
+        }
+      }
+    }
+  else
     {
-    // If per-segment flag is off, then it is not an error (the effect itself has written it back to segmentation)
-    if (this->perSegment())
+    if (overwriteSegments)
       {
-      qCritical() << Q_FUNC_INFO << ": Cannot apply edit operation because modifier labelmap cannot be accessed";
+      segmentIDsToOverwriteSeparately = segmentIDsToOverwrite;
+      }
+
+    // Apply mask to modifier labelmap if paint over is turned off
+    if (maskImage)
+      {
+      if (modifierLabelmap.GetPointer() == modifierLabelmapInput)
+        {
+        // make a copy to not modify the input
+        vtkNew<vtkOrientedImageData> maskedModifierLabelmap;
+        maskedModifierLabelmap->DeepCopy(modifierLabelmap);
+        modifierLabelmap = maskedModifierLabelmap.GetPointer();
+        }
+      this->applyImageMask(modifierLabelmap, maskImage, this->m_EraseValue, true);
+      }
+
+    // Apply threshold mask if paint threshold is turned on
+    if (masterVolumeOrientedImageData)
+      {
+      // Create threshold image
+      vtkSmartPointer<vtkImageThreshold> threshold = vtkSmartPointer<vtkImageThreshold>::New();
+      threshold->SetInputData(masterVolumeOrientedImageData);
+      threshold->ThresholdBetween(parameterSetNode->GetMasterVolumeIntensityMaskRange()[0], parameterSetNode->GetMasterVolumeIntensityMaskRange()[1]);
+      threshold->SetInValue(1);
+      threshold->SetOutValue(0);
+      threshold->SetOutputScalarType(modifierLabelmap->GetScalarType());
+      if (extent)
+        {
+        // only threshold the part of the master volume that is covered by the modified region
+        int masterExtent[6] = { 0, -1, 0, -1, 0, -1 };
+        masterVolumeOrientedImageData->GetExtent(masterExtent);
+        int thresholdExtent[6] = { 0, -1, 0, -1, 0, -1 };
+        for (int i = 0; i < 3; i++)
+          {
+          thresholdExtent[i * 2] = std::max(extent[i * 2], masterExtent[i * 2]);
+          thresholdExtent[i * 2 + 1] = std::min(extent[i * 2 + 1], masterExtent[i * 2 + 1]);
+          }
+        threshold->UpdateExtent(thresholdExtent);
+        }
+      else
+        {
+        threshold->Update();
+        }
+
+      vtkSmartPointer<vtkOrientedImageData> thresholdMask = vtkSmartPointer<vtkOrientedImageData>::New();
+      thresholdMask->DeepCopy(threshold->GetOutput());
+      vtkSmartPointer<vtkMatrix4x4> modifierLabelmapToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+      modifierLabelmap->GetImageToWorldMatrix(modifierLabelmapToWorldMatrix);
+      thresholdMask->SetGeometryFromImageToWorldMatrix(modifierLabelmapToWorldMatrix);
+
+      if (modifierLabelmap.GetPointer() == modifierLabelmapInput)
+        {
+        // make a copy to not modify the input
+        vtkNew<vtkOrientedImageData> maskedModifierLabelmap;
+        maskedModifierLabelmap->DeepCopy(modifierLabelmap);
+        modifierLabelmap = maskedModifierLabelmap.GetPointer();
+        }
+      this->applyImageMask(modifierLabelmap.GetPointer(), thresholdMask, this->m_EraseValue);
       }
-    this->defaultModifierLabelmap();
-    return;
     }
 
   // Copy the temporary padded modifier labelmap to the segment.
   // Mask and threshold was already applied on modifier labelmap at this point if requested.
-  const int* extent = modificationExtent;
-  if (extent[0]>extent[1] || extent[2]>extent[3] || extent[4]>extent[5])
-    {
-    // invalid extent, it means we have to work with the entire modifier labelmap
-    extent = NULL;
-    }
-
-  // TODO: composite modifierLabelmap with threshold mask
 
   // Create inverted binary labelmap
   vtkSmartPointer<vtkImageThreshold> inverter = vtkSmartPointer<vtkImageThreshold>::New();
@@ -402,72 +784,36 @@ void qSlicerSegmentEditorAbstractEffect::modifySelectedSegmentByLabelmap(vtkOrie
       }
     }
 
-  std::vector<std::string> allSegmentIDs;
-  segmentationNode->GetSegmentation()->GetSegmentIDs(allSegmentIDs);
-  // remove selected segment, that is already handled
-  allSegmentIDs.erase(std::remove(allSegmentIDs.begin(), allSegmentIDs.end(), selectedSegmentID), allSegmentIDs.end());
-
-  std::vector<std::string> visibleSegmentIDs;
-  vtkMRMLSegmentationDisplayNode* displayNode = vtkMRMLSegmentationDisplayNode::SafeDownCast(segmentationNode->GetDisplayNode());
-  if (displayNode)
+  if (!segmentIDsToOverwriteSeparately.empty())
     {
-    for (std::vector<std::string>::iterator segmentIDIt = allSegmentIDs.begin(); segmentIDIt != allSegmentIDs.end(); ++segmentIDIt)
+    inverter->Update();
+    vtkNew<vtkOrientedImageData> invertedModifierLabelmap;
+    invertedModifierLabelmap->ShallowCopy(inverter->GetOutput());
+    vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+    modifierLabelmap->GetImageToWorldMatrix(imageToWorldMatrix.GetPointer());
+    invertedModifierLabelmap->SetGeometryFromImageToWorldMatrix(imageToWorldMatrix.GetPointer());
+    for (std::vector<std::string>::iterator segmentIDIt = segmentIDsToOverwriteSeparately.begin(); segmentIDIt != segmentIDsToOverwriteSeparately.end(); ++segmentIDIt)
       {
-      if (displayNode->GetSegmentVisibility(*segmentIDIt))
+      if (!vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment(
+        invertedModifierLabelmap.GetPointer(), segmentationNode, *segmentIDIt, vtkSlicerSegmentationsModuleLogic::MODE_MERGE_MIN, extent))
         {
-        visibleSegmentIDs.push_back(*segmentIDIt);
+        qCritical() << Q_FUNC_INFO << ": Failed to set modifier labelmap to segment " << (segmentIDIt->c_str());
         }
       }
     }
 
-  std::vector<std::string> segmentIDsToOverwrite;
-  switch (this->parameterSetNode()->GetOverwriteMode())
-    {
-  case vtkMRMLSegmentEditorNode::OverwriteNone:
-    // nothing to overwrite
-    break;
-  case vtkMRMLSegmentEditorNode::OverwriteVisibleSegments:
-    segmentIDsToOverwrite = visibleSegmentIDs;
-    break;
-  case vtkMRMLSegmentEditorNode::OverwriteAllSegments:
-    segmentIDsToOverwrite = allSegmentIDs;
-    break;
-    }
-
-  if (!segmentIDsToOverwrite.empty())
+  // In general, we don't try to "add back" areas to other segments when an area is removed from the selected segment.
+  // The only exception is when we draw inside one specific segment. In that case erasing adds to the mask segment. It is useful
+  // for splitting a segment into two by painting.
+  if (modificationMode == qSlicerSegmentEditorAbstractEffect::ModificationModeRemove
+    && !segmentIDsToOverwrite.empty()
+    && parameterSetNode->GetMaskMode() == vtkMRMLSegmentEditorNode::PaintAllowedInsideSingleSegment
+    && parameterSetNode->GetMaskSegmentID())
     {
-    if (modificationMode == qSlicerSegmentEditorAbstractEffect::ModificationModeSet
-      || modificationMode == qSlicerSegmentEditorAbstractEffect::ModificationModeAdd)
-      {
-      inverter->Update();
-      vtkNew<vtkOrientedImageData> invertedModifierLabelmap;
-      invertedModifierLabelmap->ShallowCopy(inverter->GetOutput());
-      vtkNew<vtkMatrix4x4> imageToWorldMatrix;
-      modifierLabelmap->GetImageToWorldMatrix(imageToWorldMatrix.GetPointer());
-      invertedModifierLabelmap->SetGeometryFromImageToWorldMatrix(imageToWorldMatrix.GetPointer());
-      for (std::vector<std::string>::iterator segmentIDIt = segmentIDsToOverwrite.begin(); segmentIDIt != segmentIDsToOverwrite.end(); ++segmentIDIt)
-        {
-        if (!vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment(
-          invertedModifierLabelmap.GetPointer(), segmentationNode, *segmentIDIt, vtkSlicerSegmentationsModuleLogic::MODE_MERGE_MIN, extent))
-          {
-          qCritical() << Q_FUNC_INFO << ": Failed to set modifier labelmap to segment " << (segmentIDIt->c_str());
-          }
-        }
-      }
-    else if (modificationMode == qSlicerSegmentEditorAbstractEffect::ModificationModeRemove)
+    if (!vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment(
+      modifierLabelmap, segmentationNode, parameterSetNode->GetMaskSegmentID(), vtkSlicerSegmentationsModuleLogic::MODE_MERGE_MAX, extent))
       {
-      // In general, we don't try to "add back" areas to other segments when an area is removed from the selected segment.
-      // The only exception is when we draw inside one specific segment. In that case erasing adds to the mask segment. It is useful
-      // for splitting a segment into two by painting.
-      if (this->parameterSetNode()->GetMaskMode() == vtkMRMLSegmentEditorNode::PaintAllowedInsideSingleSegment
-        && this->parameterSetNode()->GetMaskSegmentID())
-        {
-        if (!vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment(
-          modifierLabelmap, segmentationNode, this->parameterSetNode()->GetMaskSegmentID(), vtkSlicerSegmentationsModuleLogic::MODE_MERGE_MAX, extent))
-          {
-          qCritical() << Q_FUNC_INFO << ": Failed to remove modifier labelmap from segment " << this->parameterSetNode()->GetMaskSegmentID();
-          }
-        }
+      qCritical() << Q_FUNC_INFO << ": Failed to remove modifier labelmap from segment " << parameterSetNode->GetMaskSegmentID();
       }
     }
 }
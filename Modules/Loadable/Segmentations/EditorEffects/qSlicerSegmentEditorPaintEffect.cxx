@@ -45,10 +45,8 @@
 #include <vtkGlyph2D.h>
 #include <vtkGlyph3D.h>
 #include <vtkIdList.h>
-#include <vtkImageChangeInformation.h>
 #include <vtkImageStencil.h>
 #include <vtkImageStencilData.h>
-#include <vtkImageStencilToImage.h>
 #include <vtkMath.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
@@ -91,6 +89,71 @@
 #include "vtkMRMLSliceLayerLogic.h"
 #include "vtkOrientedImageDataResample.h"
 
+// STD includes
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+/// Write fillValue into the voxel runs of the brush stencil, translated by brushPosition_Ijk and
+/// clipped to the image extent. Returns the bounding extent of the written voxels in paintedExtent
+/// (it is only grown, so the same extent can be accumulated over multiple brush positions).
+template <class T>
+void PaintBrushStencilRunsGeneric(vtkImageData* image, vtkImageStencilData* stencilData,
+  const int brushPosition_Ijk[3], T fillValue, int paintedExtent[6])
+{
+  int imageExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  image->GetExtent(imageExtent);
+  int stencilExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  stencilData->GetExtent(stencilExtent);
+
+  for (int z = stencilExtent[4]; z <= stencilExtent[5]; z++)
+    {
+    int imageZ = z + brushPosition_Ijk[2];
+    if (imageZ < imageExtent[4] || imageZ > imageExtent[5])
+      {
+      continue;
+      }
+    for (int y = stencilExtent[2]; y <= stencilExtent[3]; y++)
+      {
+      int imageY = y + brushPosition_Ijk[1];
+      if (imageY < imageExtent[2] || imageY > imageExtent[3])
+        {
+        continue;
+        }
+      int iter = 0;
+      int runStart = 0;
+      int runEnd = -1;
+      while (stencilData->GetNextExtent(runStart, runEnd, stencilExtent[0], stencilExtent[1], y, z, iter))
+        {
+        int imageXStart = std::max(runStart + brushPosition_Ijk[0], imageExtent[0]);
+        int imageXEnd = std::min(runEnd + brushPosition_Ijk[0], imageExtent[1]);
+        if (imageXStart > imageXEnd)
+          {
+          continue;
+          }
+        T* voxelPtr = static_cast<T*>(image->GetScalarPointer(imageXStart, imageY, imageZ));
+        std::fill(voxelPtr, voxelPtr + (imageXEnd - imageXStart + 1), fillValue);
+
+        if (paintedExtent[0] > paintedExtent[1])
+          {
+          paintedExtent[0] = imageXStart;
+          paintedExtent[1] = imageXEnd;
+          paintedExtent[2] = paintedExtent[3] = imageY;
+          paintedExtent[4] = paintedExtent[5] = imageZ;
+          }
+        else
+          {
+          paintedExtent[0] = std::min(paintedExtent[0], imageXStart);
+          paintedExtent[1] = std::max(paintedExtent[1], imageXEnd);
+          paintedExtent[2] = std::min(paintedExtent[2], imageY);
+          paintedExtent[3] = std::max(paintedExtent[3], imageY);
+          paintedExtent[4] = std::min(paintedExtent[4], imageZ);
+          paintedExtent[5] = std::max(paintedExtent[5], imageZ);
+          }
+        }
+      }
+    }
+}
+
 //-----------------------------------------------------------------------------
 /// Visualization objects and pipeline for each slice view for the paint brush
 class BrushPipeline
@@ -343,7 +406,8 @@ void qSlicerSegmentEditorPaintEffectPrivate::paintApply(qMRMLWidget* viewWidget)
     return;
     }
 
-  q->saveStateForUndo();
+  // Region of the modifier labelmap that is painted (invalid extent means the entire labelmap)
+  int paintExtent[6] = { 0, -1, 0, -1, 0, -1 };
 
   if (q->integerParameter("BrushPixelMode"))
     {
@@ -355,8 +419,6 @@ void qSlicerSegmentEditorPaintEffectPrivate::paintApply(qMRMLWidget* viewWidget)
 
     this->BrushPolyDataToStencil->Update();
     vtkImageStencilData* stencilData = this->BrushPolyDataToStencil->GetOutput();
-    int stencilExtent[6]={0,-1,0,-1,0,-1};
-    stencilData->GetExtent(stencilExtent);
 
     vtkNew<vtkTransform> worldToModifierLabelmapIjkTransform;
 
@@ -373,37 +435,39 @@ void qSlicerSegmentEditorPaintEffectPrivate::paintApply(qMRMLWidget* viewWidget)
     vtkNew<vtkPoints> paintCoordinates_Ijk;
     worldToModifierLabelmapIjkTransform->TransformPoints(this->PaintCoordinates_World, paintCoordinates_Ijk.GetPointer());
 
-    vtkNew<vtkImageStencilToImage> stencilToImage;
-    stencilToImage->SetInputConnection(this->BrushPolyDataToStencil->GetOutputPort());
-    stencilToImage->SetInsideValue(q->m_FillValue);
-    stencilToImage->SetOutsideValue(q->m_EraseValue);
-    stencilToImage->SetOutputScalarType(modifierLabelmap->GetScalarType());
-
-    vtkNew<vtkImageChangeInformation> brushPositioner;
-    brushPositioner->SetInputConnection(stencilToImage->GetOutputPort());
-    brushPositioner->SetOutputSpacing(modifierLabelmap->GetSpacing());
-    brushPositioner->SetOutputOrigin(modifierLabelmap->GetOrigin());
-
+    // Write the voxel runs of the brush stencil directly into the modifier labelmap at each brush position
+    // and keep track of the region that the stroke has touched.
     vtkIdType numberOfPoints = this->PaintCoordinates_World->GetNumberOfPoints();
     for (int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
       {
       double* shiftDouble = paintCoordinates_Ijk->GetPoint(pointIndex);
-      int shift[3] = {int(shiftDouble[0]+0.5), int(shiftDouble[1]+0.5), int(shiftDouble[2]+0.5)};
-      brushPositioner->SetExtentTranslation(shift);
-      brushPositioner->Update();
-      vtkNew<vtkOrientedImageData> orientedBrushPositionerOutput;
-      orientedBrushPositionerOutput->ShallowCopy(brushPositioner->GetOutput());
-      orientedBrushPositionerOutput->CopyDirections(modifierLabelmap);
-      vtkOrientedImageDataResample::ModifyImage(modifierLabelmap, orientedBrushPositionerOutput.GetPointer(), vtkOrientedImageDataResample::OPERATION_MAXIMUM);
+      int shift[3] = {int(floor(shiftDouble[0]+0.5)), int(floor(shiftDouble[1]+0.5)), int(floor(shiftDouble[2]+0.5))};
+      switch (modifierLabelmap->GetScalarType())
+        {
+        vtkTemplateMacro(PaintBrushStencilRunsGeneric<VTK_TT>(modifierLabelmap, stencilData, shift,
+          static_cast<VTK_TT>(q->m_FillValue), paintExtent));
+        default:
+          qCritical() << Q_FUNC_INFO << ": Unknown modifier labelmap scalar type";
+        }
       }
     modifierLabelmap->Modified();
     }
   this->PaintCoordinates_World->Reset();
 
+  if (!q->integerParameter("BrushPixelMode")
+    && (paintExtent[0] > paintExtent[1] || paintExtent[2] > paintExtent[3] || paintExtent[4] > paintExtent[5]))
+    {
+    // the brush did not touch the modifier labelmap, there is nothing to update
+    return;
+    }
+
+  // Only the segment is part of the undo state, so it is enough to save it here, after it is known
+  // that the brush touched the modifier labelmap. This way no empty undo steps are recorded.
+  q->saveStateForUndo();
+
   // Notify editor about changes
   qSlicerSegmentEditorAbstractEffect::ModificationMode modificationMode = (q->m_Erase ? qSlicerSegmentEditorAbstractEffect::ModificationModeRemove : qSlicerSegmentEditorAbstractEffect::ModificationModeAdd);
-  //TODO: it would be nice to compute paint extent and pass it to make the painting operation faster
-  q->modifySelectedSegmentByLabelmap(modifierLabelmap, modificationMode);
+  q->modifySelectedSegmentByLabelmap(modifierLabelmap, modificationMode, paintExtent);
 }
 
 //-----------------------------------------------------------------------------
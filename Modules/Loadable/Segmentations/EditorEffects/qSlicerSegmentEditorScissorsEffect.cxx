@@ -21,6 +21,7 @@
 // Segmentations includes
 #include "qSlicerSegmentEditorScissorsEffect.h"
 
+#include "vtkLabelmapOutlineRasterizer.h"
 #include "vtkOrientedImageData.h"
 #include "vtkOrientedImageDataResample.h"
 #include "vtkMRMLSegmentEditorNode.h"
@@ -35,22 +36,18 @@
 #include <vtkCallbackCommand.h>
 #include <vtkCamera.h>
 #include <vtkCellArray.h>
-#include <vtkImageChangeInformation.h>
-#include <vtkImageStencilData.h>
-#include <vtkImageStencilToImage.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPoints.h>
 #include <vtkPolyData.h>
 #include <vtkPolyDataMapper2D.h>
-#include <vtkPolyDataNormals.h>
-#include <vtkPolyDataToImageStencil.h>
 #include <vtkProperty2D.h>
 #include <vtkRenderer.h>
 #include <vtkRenderWindowInteractor.h>
 #include <vtkSmartPointer.h>
 #include <vtkTransform.h>
-#include <vtkTransformPolyDataFilter.h>
 #include <vtkVector.h>
 
 // MRML includes
@@ -67,6 +64,9 @@
 #include "vtkMRMLSliceLayerLogic.h"
 #include "vtkMRMLSliceLogic.h"
 
+// STD includes
+#include <algorithm>
+
 //-----------------------------------------------------------------------------
 /// Visualization objects and pipeline for each slice view for drawing cutting outline
 class ScissorsPipeline: public QObject
@@ -142,10 +142,10 @@ public:
   /// Update outline glyph based on positions
   void updateGlyphWithNewPosition(ScissorsPipeline* pipeline, const vtkVector2i& eventPosition, bool finalize);
   void finalizeGlyph(ScissorsPipeline* pipeline, const vtkVector2i& eventPosition);
-  /// Update 3D mesh of the brush
+  /// Update outline of the brush in view coordinates and mapping from world to view coordinates
   bool updateBrushModel(qMRMLWidget* viewWidget);
-  /// Update image stencil from mesh
-  bool updateBrushStencil(qMRMLWidget* viewWidget);
+  /// Update mapping from modifier labelmap IJK to view coordinates and the extent to fill
+  bool updateBrushProjection(qMRMLWidget* viewWidget);
   /// Paint brush into segment
   void paintApply(qMRMLWidget* viewWidget);
 
@@ -171,11 +171,18 @@ public:
 
   vtkSmartPointer<vtkPoints> PaintCoordinates_View;
 
-  vtkSmartPointer<vtkPolyDataNormals> BrushPolyDataNormals;
-  vtkSmartPointer<vtkTransformPolyDataFilter> WorldToModifierLabelmapIjkTransformer;
-  // transforms from polydata source to modifierLabelmap's IJK coordinate system (brush origin in IJK origin)
-  vtkSmartPointer<vtkTransform> WorldToModifierLabelmapIjkTransform;
-  vtkSmartPointer<vtkPolyDataToImageStencil> BrushPolyDataToStencil;
+  // outline of the brush in view coordinates (slice XY or camera plane)
+  vtkSmartPointer<vtkPoints> BrushPolygon_View;
+  // rows map homogeneous world coordinates to homogeneous view coordinates (x, y, w) and to depth
+  vtkSmartPointer<vtkMatrix4x4> WorldToBrushView;
+  // the outline is extruded between these depth values
+  double BrushDepthRange[2];
+  // corners of the extruded outline, for computing the extent that it may cover
+  vtkSmartPointer<vtkPoints> BrushCorners_World;
+  // same as WorldToBrushView, from modifierLabelmap's IJK coordinate system
+  vtkSmartPointer<vtkMatrix4x4> ModifierLabelmapIjkToBrushView;
+  // extent of the modifier labelmap that is filled
+  int BrushExtent[6];
 
   QMap<qMRMLWidget*, ScissorsPipeline*> ScissorsPipelines;
 
@@ -190,17 +197,18 @@ qSlicerSegmentEditorScissorsEffectPrivate::qSlicerSegmentEditorScissorsEffectPri
   this->ScissorsIcon = QIcon(":Icons/Medium/SlicerEditCut.png");
   this->CircleNumberOfPoints = 36;
   this->PaintCoordinates_View = vtkSmartPointer<vtkPoints>::New();
-
-  this->BrushPolyDataNormals = vtkSmartPointer<vtkPolyDataNormals>::New();
-  this->BrushPolyDataNormals->AutoOrientNormalsOn();
-
-  this->WorldToModifierLabelmapIjkTransformer = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-  this->WorldToModifierLabelmapIjkTransform = vtkSmartPointer<vtkTransform>::New();
-  this->WorldToModifierLabelmapIjkTransformer->SetTransform(this->WorldToModifierLabelmapIjkTransform);
-  this->WorldToModifierLabelmapIjkTransformer->SetInputConnection(this->BrushPolyDataNormals->GetOutputPort());
-  this->BrushPolyDataToStencil = vtkSmartPointer<vtkPolyDataToImageStencil>::New();
-  this->BrushPolyDataToStencil->SetOutputSpacing(1.0, 1.0, 1.0);
-  this->BrushPolyDataToStencil->SetInputConnection(this->WorldToModifierLabelmapIjkTransformer->GetOutputPort());
+  this->BrushPolygon_View = vtkSmartPointer<vtkPoints>::New();
+
+  this->WorldToBrushView = vtkSmartPointer<vtkMatrix4x4>::New();
+  this->BrushDepthRange[0] = -VTK_DOUBLE_MAX;
+  this->BrushDepthRange[1] = VTK_DOUBLE_MAX;
+  this->BrushCorners_World = vtkSmartPointer<vtkPoints>::New();
+  this->ModifierLabelmapIjkToBrushView = vtkSmartPointer<vtkMatrix4x4>::New();
+  for (int i = 0; i < 3; i++)
+    {
+    this->BrushExtent[2 * i] = 0;
+    this->BrushExtent[2 * i + 1] = -1;
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -429,9 +437,8 @@ bool qSlicerSegmentEditorScissorsEffectPrivate::updateBrushModel(qMRMLWidget* vi
     return false;
     }
 
-  vtkNew<vtkPoints> closedSurfacePoints; // p0Top, p0Bottom, p1Top, p1Bottom, ...
-  vtkNew<vtkCellArray> closedSurfaceStrips;
-  vtkNew<vtkCellArray> closedSurfacePolys;
+  this->BrushPolygon_View->Reset();
+  this->BrushCorners_World->Reset(); // p0Top, p0Bottom, p1Top, p1Bottom, ...
 
   vtkPoints* pointsXY = pipeline->PolyData->GetPoints();
   int numberOfPoints = pointsXY ? pointsXY->GetNumberOfPoints() : 0;
@@ -495,19 +502,30 @@ bool qSlicerSegmentEditorScissorsEffectPrivate::updateBrushModel(qMRMLWidget* vi
       segmentationBounds_SliceXY[5] -= 0.5;
       }
 
+    // View coordinates are slice XY, the outline is extruded through the whole labelmap
+    this->WorldToBrushView->DeepCopy(worldToSliceXYMatrix.GetPointer());
+    for (int i = 0; i < 4; i++)
+      {
+      this->WorldToBrushView->SetElement(3, i, worldToSliceXYMatrix->GetElement(2, i));
+      this->WorldToBrushView->SetElement(2, i, i == 3 ? 1.0 : 0.0);
+      }
+    this->BrushDepthRange[0] = -VTK_DOUBLE_MAX;
+    this->BrushDepthRange[1] = VTK_DOUBLE_MAX;
+
     for (int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
       {
       double pointXY[4] = { 0., 0., 0., 1. };
       double pointWorld[4] = { 0., 0., 0., 1. };
       pointsXY->GetPoint(pointIndex, pointXY);
+      this->BrushPolygon_View->InsertNextPoint(pointXY[0], pointXY[1], 0.0);
 
       pointXY[2] = segmentationBounds_SliceXY[4];
       sliceNode->GetXYToRAS()->MultiplyPoint(pointXY, pointWorld);
-      closedSurfacePoints->InsertNextPoint(pointWorld);
+      this->BrushCorners_World->InsertNextPoint(pointWorld);
 
       pointXY[2] = segmentationBounds_SliceXY[5];
       sliceNode->GetXYToRAS()->MultiplyPoint(pointXY, pointWorld);
-      closedSurfacePoints->InsertNextPoint(pointWorld);
+      this->BrushCorners_World->InsertNextPoint(pointWorld);
       }
     }
   else if(threeDWidget)
@@ -588,6 +606,27 @@ bool qSlicerSegmentEditorScissorsEffectPrivate::updateBrushModel(qMRMLWidget* vi
       std::min(clipRangeFromModifierLabelmap[1], clipRangeFromCamera[1]),
       };
 
+    // View coordinates are along camera view right and view up axes, divided by the
+    // distance from the camera in perspective projection. Depth is the distance along
+    // the direction of projection.
+    double* viewAxes[3] = { cameraViewRight, cameraViewUp, cameraDOP };
+    for (int axis = 0; axis < 3; axis++)
+      {
+      int row = (axis == 2 ? 3 : axis);
+      for (int i = 0; i < 3; i++)
+        {
+        this->WorldToBrushView->SetElement(row, i, viewAxes[axis][i]);
+        }
+      this->WorldToBrushView->SetElement(row, 3, -vtkMath::Dot(viewAxes[axis], cameraPos));
+      }
+    for (int i = 0; i < 4; i++)
+      {
+      this->WorldToBrushView->SetElement(2, i, camera->GetParallelProjection()
+        ? (i == 3 ? 1.0 : 0.0) : this->WorldToBrushView->GetElement(3, i));
+      }
+    this->BrushDepthRange[0] = clipRange[0];
+    this->BrushDepthRange[1] = clipRange[1];
+
     for (int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
       {
       // Convert the selection point into world coordinates.
@@ -651,8 +690,16 @@ bool qSlicerSegmentEditorScissorsEffectPrivate::updateBrushModel(qMRMLWidget* vi
         }
       p1World[3] = p2World[3] = 1.0;
 
-      closedSurfacePoints->InsertNextPoint(p1World);
-      closedSurfacePoints->InsertNextPoint(p2World);
+      this->BrushCorners_World->InsertNextPoint(p1World);
+      this->BrushCorners_World->InsertNextPoint(p2World);
+
+      double pointView[2] = { vtkMath::Dot(cameraViewRight, ray), vtkMath::Dot(cameraViewUp, ray) };
+      if (!camera->GetParallelProjection())
+        {
+        pointView[0] /= rayLength;
+        pointView[1] /= rayLength;
+        }
+      this->BrushPolygon_View->InsertNextPoint(pointView[0], pointView[1], 0.0);
       }
     }
   else
@@ -660,39 +707,11 @@ bool qSlicerSegmentEditorScissorsEffectPrivate::updateBrushModel(qMRMLWidget* vi
     return false;
     }
 
-  // Construct polydata
-  vtkNew<vtkPolyData> closedSurfacePolyData;
-  closedSurfacePolyData->SetPoints(closedSurfacePoints.GetPointer());
-  closedSurfacePolyData->SetStrips(closedSurfaceStrips.GetPointer());
-  closedSurfacePolyData->SetPolys(closedSurfacePolys.GetPointer());
-
-  // Skirt
-  closedSurfaceStrips->InsertNextCell(numberOfPoints * 2 + 2);
-  for (int i = 0; i < numberOfPoints * 2; i++)
-    {
-    closedSurfaceStrips->InsertCellPoint(i);
-    }
-  closedSurfaceStrips->InsertCellPoint(0);
-  closedSurfaceStrips->InsertCellPoint(1);
-  // Front cap
-  closedSurfacePolys->InsertNextCell(numberOfPoints);
-  for (int i = 0; i < numberOfPoints; i++)
-    {
-    closedSurfacePolys->InsertCellPoint(i * 2);
-    }
-  // Back cap
-  closedSurfacePolys->InsertNextCell(numberOfPoints);
-  for (int i = 0; i < numberOfPoints; i++)
-    {
-    closedSurfacePolys->InsertCellPoint(i * 2 + 1);
-    }
-
-  this->BrushPolyDataNormals->SetInputData(closedSurfacePolyData.GetPointer());
   return true;
 }
 
 //-----------------------------------------------------------------------------
-bool qSlicerSegmentEditorScissorsEffectPrivate::updateBrushStencil(qMRMLWidget* viewWidget)
+bool qSlicerSegmentEditorScissorsEffectPrivate::updateBrushProjection(qMRMLWidget* viewWidget)
 {
   Q_Q(qSlicerSegmentEditorScissorsEffect);
   Q_UNUSED(viewWidget);
@@ -715,32 +734,50 @@ bool qSlicerSegmentEditorScissorsEffectPrivate::updateBrushStencil(qMRMLWidget*
     return false;
     }
 
-  // Brush stencil transform
-
-  this->WorldToModifierLabelmapIjkTransform->Identity();
-
-  vtkNew<vtkMatrix4x4> segmentationToSegmentationIjkTransformMatrix;
-  modifierLabelmap->GetWorldToImageMatrix(segmentationToSegmentationIjkTransformMatrix.GetPointer());
-  this->WorldToModifierLabelmapIjkTransform->Concatenate(segmentationToSegmentationIjkTransformMatrix.GetPointer());
-
-  vtkNew<vtkMatrix4x4> worldToSegmentationTransformMatrix;
+  // Modifier labelmap IJK to world transform
+  vtkNew<vtkMatrix4x4> modifierLabelmapIjkToSegmentationMatrix;
+  modifierLabelmap->GetImageToWorldMatrix(modifierLabelmapIjkToSegmentationMatrix.GetPointer());
+  vtkNew<vtkMatrix4x4> segmentationToWorldMatrix;
   // We don't support painting in non-linearly transformed node (it could be implemented, but would probably slow down things too much)
   // TODO: show a meaningful error message to the user if attempted
-  vtkMRMLTransformNode::GetMatrixTransformBetweenNodes(NULL, segmentationNode->GetParentTransformNode(), worldToSegmentationTransformMatrix.GetPointer());
-  this->WorldToModifierLabelmapIjkTransform->Concatenate(worldToSegmentationTransformMatrix.GetPointer());
+  vtkMRMLTransformNode::GetMatrixTransformBetweenNodes(segmentationNode->GetParentTransformNode(), NULL, segmentationToWorldMatrix.GetPointer());
+  vtkNew<vtkMatrix4x4> modifierLabelmapIjkToWorldMatrix;
+  vtkMatrix4x4::Multiply4x4(segmentationToWorldMatrix.GetPointer(), modifierLabelmapIjkToSegmentationMatrix.GetPointer(),
+    modifierLabelmapIjkToWorldMatrix.GetPointer());
+
+  vtkMatrix4x4::Multiply4x4(this->WorldToBrushView, modifierLabelmapIjkToWorldMatrix.GetPointer(), this->ModifierLabelmapIjkToBrushView);
 
-  this->WorldToModifierLabelmapIjkTransformer->Update();
+  modifierLabelmap->GetExtent(this->BrushExtent);
   if (this->operationInside())
     {
     // Clip modifier labelmap to non-null region to make labelmap modification faster later
-    vtkPolyData* brushModel_ModifierLabelmapIjk = this->WorldToModifierLabelmapIjkTransformer->GetOutput();
-    double* boundsIjk = brushModel_ModifierLabelmapIjk->GetBounds();
-    this->BrushPolyDataToStencil->SetOutputWholeExtent(floor(boundsIjk[0]) - 1, ceil(boundsIjk[1]) + 1,
-      floor(boundsIjk[2]) - 1, ceil(boundsIjk[3]) + 1, floor(boundsIjk[4]) - 1, ceil(boundsIjk[5]) + 1);
-    }
-  else
-    {
-    this->BrushPolyDataToStencil->SetOutputWholeExtent(modifierLabelmap->GetExtent());
+    vtkNew<vtkMatrix4x4> worldToModifierLabelmapIjkMatrix;
+    vtkMatrix4x4::Invert(modifierLabelmapIjkToWorldMatrix.GetPointer(), worldToModifierLabelmapIjkMatrix.GetPointer());
+    double boundsIjk[6] = { VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX };
+    for (vtkIdType pointIndex = 0; pointIndex < this->BrushCorners_World->GetNumberOfPoints(); pointIndex++)
+      {
+      double pointWorld[4] = { 0.0, 0.0, 0.0, 1.0 };
+      double pointIjk[4] = { 0.0, 0.0, 0.0, 1.0 };
+      this->BrushCorners_World->GetPoint(pointIndex, pointWorld);
+      worldToModifierLabelmapIjkMatrix->MultiplyPoint(pointWorld, pointIjk);
+      for (int i = 0; i < 3; i++)
+        {
+        boundsIjk[2 * i] = std::min(boundsIjk[2 * i], pointIjk[i]);
+        boundsIjk[2 * i + 1] = std::max(boundsIjk[2 * i + 1], pointIjk[i]);
+        }
+      }
+    for (int i = 0; i < 3; i++)
+      {
+      if (boundsIjk[2 * i] > boundsIjk[2 * i + 1])
+        {
+        // no corners, empty extent
+        this->BrushExtent[2 * i] = 0;
+        this->BrushExtent[2 * i + 1] = -1;
+        continue;
+        }
+      this->BrushExtent[2 * i] = std::max(this->BrushExtent[2 * i], static_cast<int>(floor(boundsIjk[2 * i])) - 1);
+      this->BrushExtent[2 * i + 1] = std::min(this->BrushExtent[2 * i + 1], static_cast<int>(ceil(boundsIjk[2 * i + 1])) + 1);
+      }
     }
   return true;
 }
@@ -772,60 +809,32 @@ void qSlicerSegmentEditorScissorsEffectPrivate::paintApply(qMRMLWidget* viewWidg
     {
     return;
     }
-  if (!this->updateBrushStencil(viewWidget))
+  if (!this->updateBrushProjection(viewWidget))
     {
     return;
     }
   q->saveStateForUndo();
   QApplication::setOverrideCursor(QCursor(Qt::BusyCursor));
 
-  this->BrushPolyDataToStencil->Update();
-  vtkImageStencilData* stencilData = this->BrushPolyDataToStencil->GetOutput();
-  int stencilExtent[6] = { 0, -1, 0, -1, 0, -1 };
-  stencilData->GetExtent(stencilExtent);
+  vtkNew<vtkLabelmapOutlineRasterizer> rasterizer;
+  rasterizer->SetOutline(this->BrushPolygon_View);
+  rasterizer->SetImageToViewMatrix(this->ModifierLabelmapIjkToBrushView);
+  rasterizer->SetDepthRange(this->BrushDepthRange);
+  rasterizer->SetInsideValue(this->operationInside() ? q->m_FillValue : q->m_EraseValue);
+  rasterizer->SetOutsideValue(this->operationInside() ? q->m_EraseValue : q->m_FillValue);
 
-  vtkNew<vtkTransform> worldToModifierLabelmapIjkTransform;
-
-  vtkNew<vtkMatrix4x4> segmentationToSegmentationIjkTransformMatrix;
-  modifierLabelmap->GetImageToWorldMatrix(segmentationToSegmentationIjkTransformMatrix.GetPointer());
-  segmentationToSegmentationIjkTransformMatrix->Invert();
-  worldToModifierLabelmapIjkTransform->Concatenate(segmentationToSegmentationIjkTransformMatrix.GetPointer());
-
-  vtkNew<vtkMatrix4x4> worldToSegmentationTransformMatrix;
-  // We don't support painting in non-linearly transformed node (it could be implemented, but would probably slow down things too much)
-  // TODO: show a meaningful error message to the user if attempted
-  vtkMRMLTransformNode::GetMatrixTransformBetweenNodes(NULL, segmentationNode->GetParentTransformNode(), worldToSegmentationTransformMatrix.GetPointer());
-  worldToModifierLabelmapIjkTransform->Concatenate(worldToSegmentationTransformMatrix.GetPointer());
-
-  vtkNew<vtkImageStencilToImage> stencilToImage;
-  stencilToImage->SetInputConnection(this->BrushPolyDataToStencil->GetOutputPort());
-  if (this->operationInside())
+  // Modifier labelmap is cleared, only the brush extent needs to be filled
+  const int* extent = this->BrushExtent;
+  if (extent[0] <= extent[1] && extent[2] <= extent[3] && extent[4] <= extent[5])
     {
-    stencilToImage->SetInsideValue(q->m_FillValue);
-    stencilToImage->SetOutsideValue(q->m_EraseValue);
-    }
-  else
-    {
-    stencilToImage->SetInsideValue(q->m_EraseValue);
-    stencilToImage->SetOutsideValue(q->m_FillValue);
+    if (!rasterizer->FillLabelmap(modifierLabelmap, extent))
+      {
+      qCritical() << Q_FUNC_INFO << ": Failed to fill modifier labelmap";
+      QApplication::restoreOverrideCursor();
+      return;
+      }
     }
 
-  stencilToImage->SetOutputScalarType(modifierLabelmap->GetScalarType());
-
-  vtkNew<vtkImageChangeInformation> brushPositioner;
-  brushPositioner->SetInputConnection(stencilToImage->GetOutputPort());
-  brushPositioner->SetOutputSpacing(modifierLabelmap->GetSpacing());
-  brushPositioner->SetOutputOrigin(modifierLabelmap->GetOrigin());
-
-  brushPositioner->Update();
-  vtkNew<vtkOrientedImageData> orientedBrushPositionerOutput;
-  orientedBrushPositionerOutput->ShallowCopy(stencilToImage->GetOutput());
-  vtkNew<vtkMatrix4x4> imageToWorld;
-  modifierLabelmap->GetImageToWorldMatrix(imageToWorld.GetPointer());
-  orientedBrushPositionerOutput->SetImageToWorldMatrix(imageToWorld.GetPointer());
-
-  vtkOrientedImageDataResample::ModifyImage(modifierLabelmap, orientedBrushPositionerOutput.GetPointer(), vtkOrientedImageDataResample::OPERATION_MAXIMUM);
-
   // Notify editor about changes
   qSlicerSegmentEditorAbstractEffect::ModificationMode modificationMode = qSlicerSegmentEditorAbstractEffect::ModificationModeAdd;
   if (this->operationErase())
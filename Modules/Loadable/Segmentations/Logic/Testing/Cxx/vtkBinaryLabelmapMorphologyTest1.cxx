@@ -0,0 +1,392 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkBinaryLabelmapMorphology.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkImageMedian3D.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Empty labelmap with anisotropic spacing and an extent that does not start at 0
+void CreateLabelmap(vtkOrientedImageData* labelmap)
+{
+  labelmap->SetExtent(-3, 8, 2, 11, 0, 7);
+  labelmap->SetSpacing(1.0, 0.5, 2.0);
+  labelmap->SetOrigin(10.0, -20.0, 5.0);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkOrientedImageDataResample::FillImage(labelmap, 0);
+}
+
+//----------------------------------------------------------------------------
+/// Ellipsoid and a single voxel at the corner of the image
+void CreateShapeLabelmap(vtkOrientedImageData* labelmap)
+{
+  CreateLabelmap(labelmap);
+  int* extent = labelmap->GetExtent();
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        double x = (i - 2.0) / 3.5;
+        double y = (j - 6.0) / 3.0;
+        double z = (k - 3.0) / 1.6;
+        if (x * x + y * y + z * z <= 1.0)
+          {
+          labelmap->SetScalarComponentFromDouble(i, j, k, 0, 1);
+          }
+        }
+      }
+    }
+  labelmap->SetScalarComponentFromDouble(extent[1], extent[3], extent[5], 0, 1);
+}
+
+//----------------------------------------------------------------------------
+/// Margin computed by brute force: squared distance of each voxel from all the foreground voxels (grow)
+/// or background voxels (shrink) of the image.
+std::vector<int> ComputeExpectedMargin(vtkOrientedImageData* labelmap, double marginMm)
+{
+  int* extent = labelmap->GetExtent();
+  double* spacing = labelmap->GetSpacing();
+  bool grow = (marginMm > 0);
+
+  std::vector<int> featureVoxels;
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        bool foreground = (labelmap->GetScalarComponentAsDouble(i, j, k, 0) > 0);
+        if (foreground == grow)
+          {
+          featureVoxels.push_back(i);
+          featureVoxels.push_back(j);
+          featureVoxels.push_back(k);
+          }
+        }
+      }
+    }
+
+  std::vector<int> expected;
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        double minimumSquaredDistance = VTK_DOUBLE_MAX;
+        for (size_t featureIndex = 0; featureIndex < featureVoxels.size(); featureIndex += 3)
+          {
+          double dx = (i - featureVoxels[featureIndex]) * spacing[0];
+          double dy = (j - featureVoxels[featureIndex + 1]) * spacing[1];
+          double dz = (k - featureVoxels[featureIndex + 2]) * spacing[2];
+          minimumSquaredDistance = std::min(minimumSquaredDistance, dx * dx + dy * dy + dz * dz);
+          }
+        bool withinMargin = (minimumSquaredDistance <= marginMm * marginMm);
+        expected.push_back(grow == withinMargin ? 1 : 0);
+        }
+      }
+    }
+  return expected;
+}
+
+//----------------------------------------------------------------------------
+int CheckLabelmap(vtkOrientedImageData* labelmap, const std::vector<int>& expected, const char* operation)
+{
+  int* extent = labelmap->GetExtent();
+  std::vector<int>::const_iterator expectedIt = expected.begin();
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        int value = static_cast<int>(labelmap->GetScalarComponentAsDouble(i, j, k, 0));
+        if (value != *(expectedIt++))
+          {
+          std::cerr << operation << ": unexpected value " << value << " at (" << i << ", " << j << ", " << k << ")" << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+std::vector<int> GetVoxelValues(vtkOrientedImageData* labelmap)
+{
+  int* extent = labelmap->GetExtent();
+  std::vector<int> values;
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        values.push_back(static_cast<int>(labelmap->GetScalarComponentAsDouble(i, j, k, 0)));
+        }
+      }
+    }
+  return values;
+}
+
+//----------------------------------------------------------------------------
+int CheckGeometry(vtkOrientedImageData* input, vtkOrientedImageData* output)
+{
+  int* inputExtent = input->GetExtent();
+  int* outputExtent = output->GetExtent();
+  for (int i = 0; i < 6; i++)
+    {
+    CHECK_INT(outputExtent[i], inputExtent[i]);
+    }
+  CHECK_INT(output->GetScalarType(), input->GetScalarType());
+  for (int i = 0; i < 3; i++)
+    {
+    CHECK_DOUBLE(output->GetSpacing()[i], input->GetSpacing()[i]);
+    CHECK_DOUBLE(output->GetOrigin()[i], input->GetOrigin()[i]);
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestMargin(double marginMm)
+{
+  vtkNew<vtkOrientedImageData> input;
+  CreateShapeLabelmap(input.GetPointer());
+  std::vector<int> expected = ComputeExpectedMargin(input.GetPointer(), marginMm);
+
+  vtkNew<vtkOrientedImageData> output;
+  CHECK_BOOL(vtkBinaryLabelmapMorphology::ApplyMargin(input.GetPointer(), output.GetPointer(), marginMm), true);
+  CHECK_EXIT_SUCCESS(CheckGeometry(input.GetPointer(), output.GetPointer()));
+  CHECK_EXIT_SUCCESS(CheckLabelmap(output.GetPointer(), expected, "ApplyMargin"));
+
+  // In-place
+  CHECK_BOOL(vtkBinaryLabelmapMorphology::ApplyMargin(input.GetPointer(), input.GetPointer(), marginMm), true);
+  CHECK_EXIT_SUCCESS(CheckLabelmap(input.GetPointer(), expected, "ApplyMargin in place"));
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestAnisotropicGrow()
+{
+  // Growing a single voxel by 1mm adds 1 voxel along the first axis (spacing 1),
+  // 2 voxels along the second axis (spacing 0.5) and none along the third axis (spacing 2)
+  vtkNew<vtkOrientedImageData> input;
+  CreateLabelmap(input.GetPointer());
+  input->SetScalarComponentFromDouble(2, 6, 3, 0, 1);
+  vtkNew<vtkOrientedImageData> output;
+  CHECK_BOOL(vtkBinaryLabelmapMorphology::ApplyMargin(input.GetPointer(), output.GetPointer(), 1.0), true);
+  int effectiveExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  CHECK_BOOL(vtkOrientedImageDataResample::CalculateEffectiveExtent(output.GetPointer(), effectiveExtent), true);
+  int expectedEffectiveExtent[6] = { 1, 3, 4, 8, 3, 3 };
+  for (int i = 0; i < 6; i++)
+    {
+    CHECK_INT(effectiveExtent[i], expectedEffectiveExtent[i]);
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestEmptyInput()
+{
+  vtkNew<vtkOrientedImageData> input;
+  CreateLabelmap(input.GetPointer());
+  std::vector<int> expected(input->GetNumberOfPoints(), 0);
+
+  vtkNew<vtkOrientedImageData> output;
+  CHECK_BOOL(vtkBinaryLabelmapMorphology::ApplyMargin(input.GetPointer(), output.GetPointer(), 3.0), true);
+  CHECK_EXIT_SUCCESS(CheckGeometry(input.GetPointer(), output.GetPointer()));
+  CHECK_EXIT_SUCCESS(CheckLabelmap(output.GetPointer(), expected, "Grow empty labelmap"));
+
+  CHECK_BOOL(vtkBinaryLabelmapMorphology::ApplyMargin(input.GetPointer(), output.GetPointer(), -3.0), true);
+  CHECK_EXIT_SUCCESS(CheckGeometry(input.GetPointer(), output.GetPointer()));
+  CHECK_EXIT_SUCCESS(CheckLabelmap(output.GetPointer(), expected, "Shrink empty labelmap"));
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+/// Random binary labelmap with isotropic spacing
+void CreateRandomLabelmap(vtkOrientedImageData* labelmap)
+{
+  labelmap->SetExtent(0, 13, -2, 9, 0, 9);
+  labelmap->SetSpacing(1.0, 1.0, 1.0);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  int* extent = labelmap->GetExtent();
+  unsigned int seed = 12345;
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        // linear congruential generator, so that the test does not depend on the platform
+        seed = seed * 1103515245 + 12345;
+        labelmap->SetScalarComponentFromDouble(i, j, k, 0, ((seed >> 16) % 100) < 45 ? 1 : 0);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Compare median to vtkImageMedian3D. Voxels closer to the image boundary than the kernel radius are
+/// not compared, because the clipped kernel may contain an even number of voxels, which
+/// vtkImageMedian3D resolves differently.
+int TestMedian(int kernelSize[3])
+{
+  vtkNew<vtkOrientedImageData> input;
+  CreateRandomLabelmap(input.GetPointer());
+
+  vtkNew<vtkImageMedian3D> referenceFilter;
+  referenceFilter->SetInputData(input.GetPointer());
+  referenceFilter->SetKernelSize(kernelSize[0], kernelSize[1], kernelSize[2]);
+  referenceFilter->Update();
+  vtkImageData* reference = referenceFilter->GetOutput();
+
+  vtkNew<vtkOrientedImageData> output;
+  CHECK_BOOL(vtkBinaryLabelmapMorphology::ApplyMedian(input.GetPointer(), output.GetPointer(), kernelSize), true);
+  CHECK_EXIT_SUCCESS(CheckGeometry(input.GetPointer(), output.GetPointer()));
+
+  int* extent = input->GetExtent();
+  int numberOfComparedVoxels = 0;
+  for (int k = extent[4] + kernelSize[2] / 2; k <= extent[5] - kernelSize[2] / 2; k++)
+    {
+    for (int j = extent[2] + kernelSize[1] / 2; j <= extent[3] - kernelSize[1] / 2; j++)
+      {
+      for (int i = extent[0] + kernelSize[0] / 2; i <= extent[1] - kernelSize[0] / 2; i++)
+        {
+        int value = static_cast<int>(output->GetScalarComponentAsDouble(i, j, k, 0));
+        int expectedValue = static_cast<int>(reference->GetScalarComponentAsDouble(i, j, k, 0));
+        if (value != expectedValue)
+          {
+          std::cerr << "ApplyMedian with kernel size " << kernelSize[0] << "x" << kernelSize[1] << "x" << kernelSize[2]
+            << ": value " << value << " at (" << i << ", " << j << ", " << k << "), vtkImageMedian3D computed " << expectedValue << std::endl;
+          return EXIT_FAILURE;
+          }
+        numberOfComparedVoxels++;
+        }
+      }
+    }
+  CHECK_BOOL(numberOfComparedVoxels > 0, true);
+
+  // In-place
+  std::vector<int> expected = GetVoxelValues(output.GetPointer());
+  CHECK_BOOL(vtkBinaryLabelmapMorphology::ApplyMedian(input.GetPointer(), input.GetPointer(), kernelSize), true);
+  CHECK_EXIT_SUCCESS(CheckLabelmap(input.GetPointer(), expected, "ApplyMedian in place"));
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+/// 24x24x24 labelmap with a box at 4..15 along all axes
+void CreateBoxLabelmap(vtkOrientedImageData* labelmap)
+{
+  labelmap->SetExtent(0, 23, 0, 23, 0, 23);
+  labelmap->SetSpacing(1.0, 1.0, 1.0);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkOrientedImageDataResample::FillImage(labelmap, 0);
+  int boxExtent[6] = { 4, 15, 4, 15, 4, 15 };
+  vtkOrientedImageDataResample::FillImage(labelmap, 1, boxExtent);
+}
+
+//----------------------------------------------------------------------------
+int TestClosing()
+{
+  // Hole smaller than the kernel is filled
+  vtkNew<vtkOrientedImageData> smallHole;
+  CreateBoxLabelmap(smallHole.GetPointer());
+  smallHole->SetScalarComponentFromDouble(9, 9, 9, 0, 0);
+  CHECK_BOOL(vtkBinaryLabelmapMorphology::ApplyClosing(smallHole.GetPointer(), smallHole.GetPointer(), 1.5), true);
+  CHECK_INT(static_cast<int>(smallHole->GetScalarComponentAsDouble(9, 9, 9, 0)), 1);
+
+  // Hole larger than the kernel is kept
+  vtkNew<vtkOrientedImageData> largeHole;
+  CreateBoxLabelmap(largeHole.GetPointer());
+  int holeExtent[6] = { 7, 11, 7, 11, 7, 11 };
+  vtkOrientedImageDataResample::FillImage(largeHole.GetPointer(), 0, holeExtent);
+  CHECK_BOOL(vtkBinaryLabelmapMorphology::ApplyClosing(largeHole.GetPointer(), largeHole.GetPointer(), 1.5), true);
+  CHECK_INT(static_cast<int>(largeHole->GetScalarComponentAsDouble(9, 9, 9, 0)), 0);
+  CHECK_INT(static_cast<int>(largeHole->GetScalarComponentAsDouble(5, 5, 5, 0)), 1);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestOpening()
+{
+  // Protrusion thinner than the kernel is removed
+  vtkNew<vtkOrientedImageData> thinProtrusion;
+  CreateBoxLabelmap(thinProtrusion.GetPointer());
+  int thinProtrusionExtent[6] = { 16, 19, 9, 9, 9, 9 };
+  vtkOrientedImageDataResample::FillImage(thinProtrusion.GetPointer(), 1, thinProtrusionExtent);
+  CHECK_BOOL(vtkBinaryLabelmapMorphology::ApplyOpening(thinProtrusion.GetPointer(), thinProtrusion.GetPointer(), 1.5), true);
+  CHECK_INT(static_cast<int>(thinProtrusion->GetScalarComponentAsDouble(18, 9, 9, 0)), 0);
+  CHECK_INT(static_cast<int>(thinProtrusion->GetScalarComponentAsDouble(9, 9, 9, 0)), 1);
+
+  // Protrusion thicker than the kernel is kept
+  vtkNew<vtkOrientedImageData> thickProtrusion;
+  CreateBoxLabelmap(thickProtrusion.GetPointer());
+  int thickProtrusionExtent[6] = { 16, 19, 8, 12, 8, 12 };
+  vtkOrientedImageDataResample::FillImage(thickProtrusion.GetPointer(), 1, thickProtrusionExtent);
+  CHECK_BOOL(vtkBinaryLabelmapMorphology::ApplyOpening(thickProtrusion.GetPointer(), thickProtrusion.GetPointer(), 1.5), true);
+  CHECK_INT(static_cast<int>(thickProtrusion->GetScalarComponentAsDouble(18, 10, 10, 0)), 1);
+  CHECK_INT(static_cast<int>(thickProtrusion->GetScalarComponentAsDouble(9, 9, 9, 0)), 1);
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkBinaryLabelmapMorphologyTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestMargin(1.2));
+  CHECK_EXIT_SUCCESS(TestMargin(2.0)); // voxels exactly at the margin distance are added
+  CHECK_EXIT_SUCCESS(TestMargin(2.3));
+  CHECK_EXIT_SUCCESS(TestMargin(-1.1));
+  CHECK_EXIT_SUCCESS(TestMargin(-2.0)); // voxels exactly at the margin distance are removed
+  CHECK_EXIT_SUCCESS(TestMargin(-2.2));
+  CHECK_EXIT_SUCCESS(TestAnisotropicGrow());
+  CHECK_EXIT_SUCCESS(TestEmptyInput());
+
+  int kernelSize3x3x3[3] = { 3, 3, 3 };
+  CHECK_EXIT_SUCCESS(TestMedian(kernelSize3x3x3));
+  int kernelSize5x3x1[3] = { 5, 3, 1 };
+  CHECK_EXIT_SUCCESS(TestMedian(kernelSize5x3x1));
+  CHECK_EXIT_SUCCESS(TestClosing());
+  CHECK_EXIT_SUCCESS(TestOpening());
+  return EXIT_SUCCESS;
+}
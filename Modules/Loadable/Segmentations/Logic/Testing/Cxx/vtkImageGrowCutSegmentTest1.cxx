@@ -0,0 +1,180 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkImageGrowCutSegment.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+namespace
+{
+
+const int VolumeSize = 20;
+
+//----------------------------------------------------------------------------
+/// Three regions with small (at most 1) deterministic noise:
+/// A (i < 10, k < 15) = 100, B (i >= 10) = 200, C (i < 10, k >= 15) = 300.
+/// Within a region any voxel can be reached from a seed with a path cost of at most 20,
+/// while crossing to another region costs at least 98.
+void CreateIntensityVolume(vtkImageData* intensityVolume)
+{
+  intensityVolume->SetExtent(0, VolumeSize - 1, 0, VolumeSize - 1, 0, VolumeSize - 1);
+  intensityVolume->AllocateScalars(VTK_SHORT, 1);
+  unsigned int seed = 1;
+  for (int k = 0; k < VolumeSize; k++)
+    {
+    for (int j = 0; j < VolumeSize; j++)
+      {
+      for (int i = 0; i < VolumeSize; i++)
+        {
+        seed = seed * 1103515245 + 12345;
+        int noise = static_cast<int>((seed >> 16) % 3) - 1;
+        int regionIntensity = (i >= 10 ? 200 : (k >= 15 ? 300 : 100));
+        intensityVolume->SetScalarComponentFromDouble(i, j, k, 0, regionIntensity + noise);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void CreateSeedLabelVolume(vtkImageData* seedLabelVolume)
+{
+  seedLabelVolume->SetExtent(0, VolumeSize - 1, 0, VolumeSize - 1, 0, VolumeSize - 1);
+  seedLabelVolume->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  seedLabelVolume->GetPointData()->GetScalars()->FillComponent(0, 0);
+  seedLabelVolume->SetScalarComponentFromDouble(4, 10, 7, 0, 1);
+  seedLabelVolume->SetScalarComponentFromDouble(5, 10, 7, 0, 1);
+  seedLabelVolume->SetScalarComponentFromDouble(15, 10, 10, 0, 2);
+}
+
+//----------------------------------------------------------------------------
+/// Compare the result with the label of the region of each voxel.
+/// Region C gets the label of region B if it has no seed.
+int CheckResult(vtkImageData* result, bool regionCHasSeed)
+{
+  CHECK_NOT_NULL(result->GetPointData()->GetScalars());
+  CHECK_INT(result->GetScalarType(), VTK_UNSIGNED_CHAR);
+  int* extent = result->GetExtent();
+  for (int i = 0; i < 6; i++)
+    {
+    CHECK_INT(extent[i], (i % 2 == 0 ? 0 : VolumeSize - 1));
+    }
+  for (int k = 0; k < VolumeSize; k++)
+    {
+    for (int j = 0; j < VolumeSize; j++)
+      {
+      for (int i = 0; i < VolumeSize; i++)
+        {
+        int expectedLabel = (i >= 10 ? 2 : (k >= 15 ? (regionCHasSeed ? 3 : 2) : 1));
+        int label = static_cast<int>(result->GetScalarComponentAsDouble(i, j, k, 0));
+        if (label != expectedLabel)
+          {
+          std::cerr << "Unexpected label " << label << " (expected " << expectedLabel << ") at ("
+            << i << ", " << j << ", " << k << ")" << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestSegmentation()
+{
+  vtkNew<vtkImageData> intensityVolume;
+  CreateIntensityVolume(intensityVolume.GetPointer());
+  vtkNew<vtkImageData> seedLabelVolume;
+  CreateSeedLabelVolume(seedLabelVolume.GetPointer());
+
+  vtkNew<vtkImageGrowCutSegment> growCut;
+  growCut->SetIntensityVolume(intensityVolume.GetPointer());
+  growCut->SetSeedLabelVolume(seedLabelVolume.GetPointer());
+  growCut->Update();
+  CHECK_EXIT_SUCCESS(CheckResult(growCut->GetOutput(), false));
+
+  // Incremental update: only the region of the new seed changes
+  seedLabelVolume->SetScalarComponentFromDouble(4, 10, 17, 0, 3);
+  seedLabelVolume->Modified();
+  growCut->Update();
+  CHECK_EXIT_SUCCESS(CheckResult(growCut->GetOutput(), true));
+
+  // Computing from scratch gives the same result as the incremental update
+  growCut->Reset();
+  growCut->Modified();
+  growCut->Update();
+  CHECK_EXIT_SUCCESS(CheckResult(growCut->GetOutput(), true));
+
+  vtkNew<vtkImageGrowCutSegment> growCutFromScratch;
+  growCutFromScratch->SetIntensityVolume(intensityVolume.GetPointer());
+  growCutFromScratch->SetSeedLabelVolume(seedLabelVolume.GetPointer());
+  growCutFromScratch->Update();
+  CHECK_EXIT_SUCCESS(CheckResult(growCutFromScratch->GetOutput(), true));
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestInvalidInput()
+{
+  vtkNew<vtkImageData> intensityVolume;
+  CreateIntensityVolume(intensityVolume.GetPointer());
+  vtkNew<vtkImageData> seedLabelVolume;
+  CreateSeedLabelVolume(seedLabelVolume.GetPointer());
+
+  // Seed label volume geometry must match the intensity volume
+  seedLabelVolume->SetSpacing(2.0, 1.0, 1.0);
+  vtkNew<vtkImageGrowCutSegment> growCut;
+  growCut->SetIntensityVolume(intensityVolume.GetPointer());
+  growCut->SetSeedLabelVolume(seedLabelVolume.GetPointer());
+  TESTING_OUTPUT_ASSERT_WARNINGS_BEGIN();
+  growCut->Update();
+  TESTING_OUTPUT_ASSERT_WARNINGS_END();
+  CHECK_NULL(growCut->GetOutput()->GetPointData()->GetScalars());
+
+  // Image must be larger than 2 voxels along each axis
+  intensityVolume->SetExtent(0, VolumeSize - 1, 0, VolumeSize - 1, 0, 1);
+  intensityVolume->AllocateScalars(VTK_SHORT, 1);
+  intensityVolume->GetPointData()->GetScalars()->FillComponent(0, 100);
+  seedLabelVolume->SetSpacing(1.0, 1.0, 1.0);
+  seedLabelVolume->SetExtent(0, VolumeSize - 1, 0, VolumeSize - 1, 0, 1);
+  seedLabelVolume->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  seedLabelVolume->GetPointData()->GetScalars()->FillComponent(0, 1);
+  growCut->Modified();
+  TESTING_OUTPUT_ASSERT_WARNINGS_BEGIN();
+  growCut->Update();
+  TESTING_OUTPUT_ASSERT_WARNINGS_END();
+  CHECK_NULL(growCut->GetOutput()->GetPointData()->GetScalars());
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageGrowCutSegmentTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestSegmentation());
+  CHECK_EXIT_SUCCESS(TestInvalidInput());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,240 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkImageThresholdHistogram.h"
+#include "vtkImageThresholdPreview.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <cmath>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Short image with values between -10 and 39
+void CreateIntegerImage(vtkImageData* image)
+{
+  image->SetExtent(0, 9, -2, 5, 0, 5);
+  image->AllocateScalars(VTK_SHORT, 1);
+  int* extent = image->GetExtent();
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        image->SetScalarComponentFromDouble(i, j, k, 0, (i * 7 + (j + 2) * 3 + k * 11) % 50 - 10);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Float image with 1000 evenly spaced values between 0.0 and 99.9
+void CreateFloatImage(vtkImageData* image)
+{
+  image->SetExtent(0, 9, 0, 9, 0, 9);
+  image->AllocateScalars(VTK_FLOAT, 1);
+  for (int k = 0; k < 10; k++)
+    {
+    for (int j = 0; j < 10; j++)
+      {
+      for (int i = 0; i < 10; i++)
+        {
+        image->SetScalarComponentFromDouble(i, j, k, 0, (i + j * 10 + k * 100) * 0.1);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkIdType CountVoxelsInRange(vtkImageData* image, double lower, double upper)
+{
+  int* extent = image->GetExtent();
+  vtkIdType count = 0;
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        double value = image->GetScalarComponentAsDouble(i, j, k, 0);
+        if (value >= lower && value <= upper)
+          {
+          count++;
+          }
+        }
+      }
+    }
+  return count;
+}
+
+//----------------------------------------------------------------------------
+int CheckExactCount(vtkImageThresholdHistogram* histogram, vtkImageData* image, double lower, double upper)
+{
+  vtkIdType count = histogram->GetNumberOfVoxelsInRange(lower, upper);
+  vtkIdType expectedCount = CountVoxelsInRange(image, lower, upper);
+  if (count != expectedCount)
+    {
+    std::cerr << "Number of voxels in range [" << lower << ", " << upper << "] is " << count
+      << ", expected " << expectedCount << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestIntegerBins()
+{
+  vtkNew<vtkImageData> image;
+  CreateIntegerImage(image.GetPointer());
+  vtkNew<vtkImageThresholdHistogram> histogram;
+  histogram->SetInputData(image.GetPointer());
+
+  // Each integer value has its own bin, so counts are exact for any range
+  CHECK_EXIT_SUCCESS(CheckExactCount(histogram.GetPointer(), image.GetPointer(), -10.0, 39.0));
+  CHECK_EXIT_SUCCESS(CheckExactCount(histogram.GetPointer(), image.GetPointer(), 0.0, 0.0));
+  CHECK_EXIT_SUCCESS(CheckExactCount(histogram.GetPointer(), image.GetPointer(), 5.5, 20.2));
+  CHECK_EXIT_SUCCESS(CheckExactCount(histogram.GetPointer(), image.GetPointer(), -1000.0, -9.5));
+  CHECK_EXIT_SUCCESS(CheckExactCount(histogram.GetPointer(), image.GetPointer(), 38.7, 1000.0));
+  CHECK_INT(histogram->GetNumberOfVoxelsInRange(-100.0, -50.0), 0);
+  CHECK_INT(histogram->GetNumberOfVoxelsInRange(20.0, 10.0), 0);
+  CHECK_INT(histogram->GetNumberOfVoxelsInRange(-1000.0, 1000.0), image->GetNumberOfPoints());
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestFloatBins()
+{
+  vtkNew<vtkImageData> image;
+  CreateFloatImage(image.GetPointer());
+  vtkNew<vtkImageThresholdHistogram> histogram;
+  histogram->SetMaximumNumberOfBins(100);
+  histogram->SetInputData(image.GetPointer());
+
+  // Ranges that include the entire scalar range are exact
+  CHECK_INT(histogram->GetNumberOfVoxelsInRange(-5.0, 200.0), 1000);
+
+  // Counts are interpolated within bins. Each bin contains about 10 voxels,
+  // the interpolated count must be within one bin of the exact count.
+  double ranges[4][2] = { { 10.0, 20.0 }, { 33.33, 33.37 }, { 0.0, 50.05 }, { 71.2, 99.9 } };
+  for (int rangeIndex = 0; rangeIndex < 4; rangeIndex++)
+    {
+    double lower = ranges[rangeIndex][0];
+    double upper = ranges[rangeIndex][1];
+    vtkIdType count = histogram->GetNumberOfVoxelsInRange(lower, upper);
+    vtkIdType expectedCount = CountVoxelsInRange(image.GetPointer(), lower, upper);
+    if (std::abs(static_cast<double>(count - expectedCount)) > 10.0)
+      {
+      std::cerr << "Number of voxels in range [" << lower << ", " << upper << "] is " << count
+        << ", expected about " << expectedCount << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestInputModified()
+{
+  vtkNew<vtkImageData> image;
+  CreateIntegerImage(image.GetPointer());
+  vtkNew<vtkImageThresholdHistogram> histogram;
+  histogram->SetInputData(image.GetPointer());
+  CHECK_EXIT_SUCCESS(CheckExactCount(histogram.GetPointer(), image.GetPointer(), 5.0, 20.0));
+  CHECK_INT(histogram->GetNumberOfVoxelsInRange(1000.0, 1000.0), 0);
+
+  // Change values within and outside of the original scalar range
+  image->SetScalarComponentFromDouble(3, 1, 2, 0, 12);
+  image->SetScalarComponentFromDouble(4, 1, 2, 0, 1000);
+  image->Modified();
+  CHECK_EXIT_SUCCESS(CheckExactCount(histogram.GetPointer(), image.GetPointer(), 5.0, 20.0));
+  CHECK_INT(histogram->GetNumberOfVoxelsInRange(1000.0, 1000.0), 1);
+
+  // Replace the input
+  vtkNew<vtkImageData> floatImage;
+  CreateFloatImage(floatImage.GetPointer());
+  histogram->SetInputData(floatImage.GetPointer());
+  CHECK_INT(histogram->GetNumberOfVoxelsInRange(-5.0, 200.0), 1000);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestThresholdPreview()
+{
+  vtkNew<vtkImageData> image;
+  CreateIntegerImage(image.GetPointer());
+
+  vtkNew<vtkImageThresholdPreview> preview;
+  preview->SetInputData(image.GetPointer());
+  preview->ThresholdBetween(5.5, 20.2);
+  preview->SetColor(1.0, 0.5, 0.0, 0.4);
+  preview->Update();
+  vtkImageData* output = preview->GetOutput();
+  CHECK_INT(output->GetScalarType(), VTK_UNSIGNED_CHAR);
+  CHECK_INT(output->GetNumberOfScalarComponents(), 4);
+
+  // Voxels within the range are colored, the number of colored voxels matches the histogram
+  int* extent = image->GetExtent();
+  vtkIdType numberOfColoredVoxels = 0;
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        double value = image->GetScalarComponentAsDouble(i, j, k, 0);
+        bool inRange = (value >= 5.5 && value <= 20.2);
+        CHECK_INT(static_cast<int>(output->GetScalarComponentAsDouble(i, j, k, 0)), inRange ? 255 : 0);
+        CHECK_INT(static_cast<int>(output->GetScalarComponentAsDouble(i, j, k, 1)), inRange ? 128 : 0);
+        CHECK_INT(static_cast<int>(output->GetScalarComponentAsDouble(i, j, k, 2)), 0);
+        CHECK_INT(static_cast<int>(output->GetScalarComponentAsDouble(i, j, k, 3)), inRange ? 102 : 0);
+        if (inRange)
+          {
+          numberOfColoredVoxels++;
+          }
+        }
+      }
+    }
+  vtkNew<vtkImageThresholdHistogram> histogram;
+  histogram->SetInputData(image.GetPointer());
+  CHECK_INT(histogram->GetNumberOfVoxelsInRange(5.5, 20.2), numberOfColoredVoxels);
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageThresholdHistogramTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestIntegerBins());
+  CHECK_EXIT_SUCCESS(TestFloatBins());
+  CHECK_EXIT_SUCCESS(TestInputModified());
+  CHECK_EXIT_SUCCESS(TestThresholdPreview());
+  return EXIT_SUCCESS;
+}
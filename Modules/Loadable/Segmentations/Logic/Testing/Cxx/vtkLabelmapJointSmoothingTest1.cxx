@@ -0,0 +1,172 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkLabelmapJointSmoothing.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkNew.h>
+
+// STD includes
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Box at 4..23 along all axes, split into label 1 and label 2 by a jagged interface around i=13
+void CreateTwoLabelLabelmap(vtkOrientedImageData* labelmap)
+{
+  labelmap->SetExtent(0, 27, 0, 27, 0, 27);
+  labelmap->SetSpacing(1.0, 1.0, 1.0);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkOrientedImageDataResample::FillImage(labelmap, 0);
+  for (int k = 4; k <= 23; k++)
+    {
+    for (int j = 4; j <= 23; j++)
+      {
+      for (int i = 4; i <= 23; i++)
+        {
+        int label = (i + (j * 7 + k * 3) % 3 < 14) ? 1 : 2;
+        labelmap->SetScalarComponentFromDouble(i, j, k, 0, label);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+std::vector<int> GetVoxelValues(vtkOrientedImageData* labelmap)
+{
+  int* extent = labelmap->GetExtent();
+  std::vector<int> values;
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        values.push_back(static_cast<int>(labelmap->GetScalarComponentAsDouble(i, j, k, 0)));
+        }
+      }
+    }
+  return values;
+}
+
+//----------------------------------------------------------------------------
+int CheckSmoothedLabels(vtkOrientedImageData* labelmap)
+{
+  int* extent = labelmap->GetExtent();
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        int value = static_cast<int>(labelmap->GetScalarComponentAsDouble(i, j, k, 0));
+        bool insideBox = (i >= 7 && i <= 20 && j >= 7 && j <= 20 && k >= 7 && k <= 20);
+        bool outsideBox = (i < 2 || i > 25 || j < 2 || j > 25 || k < 2 || k > 25);
+        int expectedValue = -1; // any label or background
+        if (insideBox && i <= 9)
+          {
+          expectedValue = 1;
+          }
+        else if (insideBox && i >= 17)
+          {
+          expectedValue = 2;
+          }
+        else if (outsideBox)
+          {
+          expectedValue = 0;
+          }
+        if (value < 0 || value > 2 || (expectedValue >= 0 && value != expectedValue))
+          {
+          std::cerr << "Unexpected value " << value << " at (" << i << ", " << j << ", " << k << ")" << std::endl;
+          return EXIT_FAILURE;
+          }
+        // Labels compete with each other, so no gap may appear between them
+        if (insideBox && value == 0)
+          {
+          std::cerr << "Gap between labels at (" << i << ", " << j << ", " << k << ")" << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestSmoothing()
+{
+  vtkNew<vtkOrientedImageData> input;
+  CreateTwoLabelLabelmap(input.GetPointer());
+
+  vtkNew<vtkOrientedImageData> output;
+  CHECK_BOOL(vtkLabelmapJointSmoothing::Smooth(input.GetPointer(), output.GetPointer(), 1.0), true);
+  int* inputExtent = input->GetExtent();
+  int* outputExtent = output->GetExtent();
+  for (int i = 0; i < 6; i++)
+    {
+    CHECK_INT(outputExtent[i], inputExtent[i]);
+    }
+  CHECK_INT(output->GetScalarType(), input->GetScalarType());
+  CHECK_EXIT_SUCCESS(CheckSmoothedLabels(output.GetPointer()));
+
+  // Smoothing must straighten the jagged interface between the labels
+  std::vector<int> inputValues = GetVoxelValues(input.GetPointer());
+  std::vector<int> outputValues = GetVoxelValues(output.GetPointer());
+  CHECK_BOOL(inputValues != outputValues, true);
+
+  // In-place
+  CHECK_BOOL(vtkLabelmapJointSmoothing::Smooth(input.GetPointer(), input.GetPointer(), 1.0), true);
+  CHECK_BOOL(GetVoxelValues(input.GetPointer()) == outputValues, true);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestZeroStandardDeviation()
+{
+  vtkNew<vtkOrientedImageData> input;
+  CreateTwoLabelLabelmap(input.GetPointer());
+  std::vector<int> inputValues = GetVoxelValues(input.GetPointer());
+
+  vtkNew<vtkOrientedImageData> output;
+  CHECK_BOOL(vtkLabelmapJointSmoothing::Smooth(input.GetPointer(), output.GetPointer(), 0.0), true);
+  CHECK_BOOL(GetVoxelValues(output.GetPointer()) == inputValues, true);
+
+  CHECK_BOOL(vtkLabelmapJointSmoothing::Smooth(input.GetPointer(), input.GetPointer(), 0.0), true);
+  CHECK_BOOL(GetVoxelValues(input.GetPointer()) == inputValues, true);
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkLabelmapJointSmoothingTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestSmoothing());
+  CHECK_EXIT_SUCCESS(TestZeroStandardDeviation());
+  return EXIT_SUCCESS;
+}
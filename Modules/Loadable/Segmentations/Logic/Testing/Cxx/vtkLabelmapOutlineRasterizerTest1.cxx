@@ -0,0 +1,280 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkLabelmapOutlineRasterizer.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+const double InsideValue = 3.0;
+const double OutsideValue = 5.0;
+const double UnchangedValue = 7.0;
+
+//----------------------------------------------------------------------------
+/// Five-pointed star drawn as a self-intersecting polygon. By the even-odd rule
+/// the pentagon in the middle is outside.
+void CreateStarOutline(vtkPoints* outline, double center[2], double radius)
+{
+  for (int pointIndex = 0; pointIndex < 5; pointIndex++)
+    {
+    double angle = vtkMath::RadiansFromDegrees(90.0 + 144.0 * pointIndex);
+    outline->InsertNextPoint(center[0] + radius * cos(angle), center[1] + radius * sin(angle), 0.0);
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Even-odd point in polygon test, returns -1 if the point is too close to an edge to decide
+int GetPointInPolygon(vtkPoints* outline, double x, double y)
+{
+  bool inside = false;
+  vtkIdType numberOfPoints = outline->GetNumberOfPoints();
+  for (vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+    {
+    double p0[3] = { 0.0, 0.0, 0.0 };
+    double p1[3] = { 0.0, 0.0, 0.0 };
+    outline->GetPoint(pointIndex, p0);
+    outline->GetPoint((pointIndex + 1) % numberOfPoints, p1);
+    double edge[2] = { p1[0] - p0[0], p1[1] - p0[1] };
+    double edgeLength2 = edge[0] * edge[0] + edge[1] * edge[1];
+    double t = std::max(0.0, std::min(1.0, ((x - p0[0]) * edge[0] + (y - p0[1]) * edge[1]) / edgeLength2));
+    double dx = x - (p0[0] + t * edge[0]);
+    double dy = y - (p0[1] + t * edge[1]);
+    if (dx * dx + dy * dy < 1e-12)
+      {
+      return -1;
+      }
+    if ((p0[1] > y) != (p1[1] > y) && x < p0[0] + (y - p0[1]) * edge[0] / edge[1])
+      {
+      inside = !inside;
+      }
+    }
+  return inside ? 1 : 0;
+}
+
+//----------------------------------------------------------------------------
+void CreateLabelmap(vtkImageData* labelmap, int scalarType, int maxK)
+{
+  labelmap->SetExtent(0, 29, 0, 29, 0, maxK);
+  labelmap->AllocateScalars(scalarType, 1);
+  int* extent = labelmap->GetExtent();
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        labelmap->SetScalarComponentFromDouble(i, j, k, 0, UnchangedValue);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Compare each voxel with the projection of its position onto the view
+int CheckFilledLabelmap(vtkImageData* labelmap, const int fillExtent[6], vtkPoints* outline,
+  vtkMatrix4x4* imageToView, const double depthRange[2])
+{
+  int numberOfInsideVoxels = 0;
+  int numberOfVoxelsInHole = 0;
+  int numberOfDepthClippedVoxels = 0;
+  int* extent = labelmap->GetExtent();
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        double value = labelmap->GetScalarComponentAsDouble(i, j, k, 0);
+        if (i < fillExtent[0] || i > fillExtent[1] || j < fillExtent[2] || j > fillExtent[3]
+          || k < fillExtent[4] || k > fillExtent[5])
+          {
+          CHECK_DOUBLE(value, UnchangedValue);
+          continue;
+          }
+        double position_Image[4] = { static_cast<double>(i), static_cast<double>(j), static_cast<double>(k), 1.0 };
+        double position_View[4] = { 0.0, 0.0, 0.0, 0.0 };
+        imageToView->MultiplyPoint(position_Image, position_View);
+        int insidePolygon = 0;
+        if (position_View[2] > 0.0)
+          {
+          insidePolygon = GetPointInPolygon(outline, position_View[0] / position_View[2], position_View[1] / position_View[2]);
+          }
+        if (insidePolygon < 0)
+          {
+          // on the outline
+          continue;
+          }
+        bool insideDepthRange = (position_View[3] >= depthRange[0] && position_View[3] <= depthRange[1]);
+        bool inside = (insidePolygon == 1 && insideDepthRange);
+        if (value != (inside ? InsideValue : OutsideValue))
+          {
+          std::cerr << "Unexpected value " << value << " at (" << i << ", " << j << ", " << k << ")" << std::endl;
+          return EXIT_FAILURE;
+          }
+        if (inside)
+          {
+          numberOfInsideVoxels++;
+          }
+        else if (insidePolygon == 1)
+          {
+          numberOfDepthClippedVoxels++;
+          }
+        else if (position_View[2] > 0.0 && insideDepthRange
+          && fabs(position_View[0] / position_View[2]) < 2.0 && fabs(position_View[1] / position_View[2]) < 2.0)
+          {
+          // in the pentagon at the middle of the star
+          numberOfVoxelsInHole++;
+          }
+        }
+      }
+    }
+
+  // Test is only meaningful if all cases occur
+  CHECK_BOOL(numberOfInsideVoxels > 0, true);
+  CHECK_BOOL(numberOfDepthClippedVoxels > 0, true);
+  CHECK_BOOL(numberOfVoxelsInHole > 0, true);
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+/// Slice view: affine mapping, slightly oblique slice, depth range is a slab of slices
+int TestSliceView()
+{
+  vtkNew<vtkImageData> labelmap;
+  CreateLabelmap(labelmap.GetPointer(), VTK_UNSIGNED_CHAR, 9);
+
+  vtkNew<vtkPoints> outline;
+  double center[2] = { 0.0, 0.0 };
+  CreateStarOutline(outline.GetPointer(), center, 12.0);
+
+  // Center of the labelmap is projected near the view origin
+  double elements[16] =
+    {
+    0.9, 0.2, -0.1, -15.0,
+    -0.15, 0.95, 0.05, -14.66,
+    0.0, 0.0, 0.0, 1.0,
+    0.1, 0.05, 1.0, 0.0
+    };
+  vtkNew<vtkMatrix4x4> imageToView;
+  imageToView->DeepCopy(elements);
+
+  double depthRange[2] = { 2.33, 6.71 };
+  vtkNew<vtkLabelmapOutlineRasterizer> rasterizer;
+  rasterizer->SetOutline(outline.GetPointer());
+  rasterizer->SetImageToViewMatrix(imageToView.GetPointer());
+  rasterizer->SetDepthRange(depthRange);
+  rasterizer->SetInsideValue(InsideValue);
+  rasterizer->SetOutsideValue(OutsideValue);
+  int fillExtent[6] = { 1, 28, 2, 27, 0, 9 };
+  CHECK_BOOL(rasterizer->FillLabelmap(labelmap.GetPointer(), fillExtent), true);
+  CHECK_EXIT_SUCCESS(CheckFilledLabelmap(labelmap.GetPointer(), fillExtent, outline.GetPointer(),
+    imageToView.GetPointer(), depthRange));
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+/// 3D view with perspective projection: w grows with the distance from the camera,
+/// voxels in the first slices are behind the camera (w <= 0) and are removed by the near clipping plane.
+int TestPerspectiveView()
+{
+  vtkNew<vtkImageData> labelmap;
+  CreateLabelmap(labelmap.GetPointer(), VTK_SHORT, 19);
+
+  vtkNew<vtkPoints> outline;
+  double center[2] = { 0.0, 0.0 };
+  CreateStarOutline(outline.GetPointer(), center, 12.0);
+
+  double elements[16] =
+    {
+    1.0, 0.1, 0.05, -15.0,
+    -0.1, 1.0, 0.1, -15.0,
+    0.003, 0.002, 0.08, -0.1,
+    0.03, 0.02, 0.8, -1.0
+    };
+  vtkNew<vtkMatrix4x4> imageToView;
+  imageToView->DeepCopy(elements);
+
+  double depthRange[2] = { 1.5, 12.0 };
+  vtkNew<vtkLabelmapOutlineRasterizer> rasterizer;
+  rasterizer->SetOutline(outline.GetPointer());
+  rasterizer->SetImageToViewMatrix(imageToView.GetPointer());
+  rasterizer->SetDepthRange(depthRange);
+  rasterizer->SetInsideValue(InsideValue);
+  rasterizer->SetOutsideValue(OutsideValue);
+  int fillExtent[6] = { 0, 29, 0, 29, 0, 19 };
+  CHECK_BOOL(rasterizer->FillLabelmap(labelmap.GetPointer(), fillExtent), true);
+  CHECK_EXIT_SUCCESS(CheckFilledLabelmap(labelmap.GetPointer(), fillExtent, outline.GetPointer(),
+    imageToView.GetPointer(), depthRange));
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestInvalidInput()
+{
+  vtkNew<vtkPoints> outline;
+  double center[2] = { 0.0, 0.0 };
+  CreateStarOutline(outline.GetPointer(), center, 12.0);
+  vtkNew<vtkMatrix4x4> imageToView;
+  vtkNew<vtkLabelmapOutlineRasterizer> rasterizer;
+  int fillExtent[6] = { 0, 3, 0, 3, 0, 3 };
+
+  // Outline and matrix are required
+  vtkNew<vtkImageData> labelmap;
+  labelmap->SetExtent(fillExtent);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(rasterizer->FillLabelmap(labelmap.GetPointer(), fillExtent), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  // Only single component labelmaps are supported
+  rasterizer->SetOutline(outline.GetPointer());
+  rasterizer->SetImageToViewMatrix(imageToView.GetPointer());
+  vtkNew<vtkImageData> vectorImage;
+  vectorImage->SetExtent(fillExtent);
+  vectorImage->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(rasterizer->FillLabelmap(vectorImage.GetPointer(), fillExtent), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  CHECK_BOOL(rasterizer->FillLabelmap(labelmap.GetPointer(), fillExtent), true);
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkLabelmapOutlineRasterizerTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestSliceView());
+  CHECK_EXIT_SUCCESS(TestPerspectiveView());
+  CHECK_EXIT_SUCCESS(TestInvalidInput());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,352 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkSegmentStatisticsCalculator.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+#include "vtkSegmentationConverter.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkFieldData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Expected statistics computed voxel by voxel
+struct ExpectedStatistics
+{
+  ExpectedStatistics()
+  : VoxelCount(0.0)
+  , Sum(0.0)
+  , SumOfSquares(0.0)
+  {
+    this->SumIjk[0] = this->SumIjk[1] = this->SumIjk[2] = 0.0;
+  }
+  double VoxelCount;
+  double Sum;
+  double SumOfSquares;
+  double SumIjk[3];
+  std::map<double, double> WeightOfValues;
+};
+
+//----------------------------------------------------------------------------
+void SetGeometry(vtkOrientedImageData* image, int extent[6])
+{
+  image->SetExtent(extent);
+  image->SetSpacing(1.0, 2.0, 0.5);
+  image->SetOrigin(10.0, 20.0, 30.0);
+}
+
+//----------------------------------------------------------------------------
+/// Short image with values between -20 and 100
+void CreateReferenceImage(vtkOrientedImageData* image)
+{
+  int extent[6] = { 0, 19, 0, 15, 0, 9 };
+  SetGeometry(image, extent);
+  image->AllocateScalars(VTK_SHORT, 1);
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        image->SetScalarComponentFromDouble(i, j, k, 0, (i * 3 + j * 5 + k * 7) % 121 - 20);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Labelmap with a scattered pattern of values between 0 and maximumValue
+void CreateLabelmap(vtkOrientedImageData* labelmap, int extent[6], int maximumValue)
+{
+  SetGeometry(labelmap, extent);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        int value = (i + 2 * j + 3 * k) % (maximumValue + 2);
+        labelmap->SetScalarComponentFromDouble(i, j, k, 0, value > maximumValue ? 0 : value);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void SetFractionalScalarRange(vtkOrientedImageData* labelmap, double minimumValue, double maximumValue)
+{
+  vtkNew<vtkDoubleArray> scalarRange;
+  scalarRange->SetName(vtkSegmentationConverter::GetScalarRangeFieldName());
+  scalarRange->InsertNextValue(minimumValue);
+  scalarRange->InsertNextValue(maximumValue);
+  labelmap->GetFieldData()->AddArray(scalarRange.GetPointer());
+}
+
+//----------------------------------------------------------------------------
+ExpectedStatistics ComputeExpectedStatistics(vtkOrientedImageData* labelmap, vtkOrientedImageData* referenceImage,
+  double fractionalMaximum)
+{
+  ExpectedStatistics expected;
+  int* extent = labelmap->GetExtent();
+  int* referenceExtent = referenceImage ? referenceImage->GetExtent() : extent;
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        if (i < referenceExtent[0] || i > referenceExtent[1] || j < referenceExtent[2] || j > referenceExtent[3]
+          || k < referenceExtent[4] || k > referenceExtent[5])
+          {
+          continue;
+          }
+        double labelValue = labelmap->GetScalarComponentAsDouble(i, j, k, 0);
+        double weight = (fractionalMaximum > 0 ? labelValue / fractionalMaximum : (labelValue > 0 ? 1.0 : 0.0));
+        if (weight <= 0)
+          {
+          continue;
+          }
+        expected.VoxelCount += weight;
+        expected.SumIjk[0] += weight * i;
+        expected.SumIjk[1] += weight * j;
+        expected.SumIjk[2] += weight * k;
+        if (referenceImage)
+          {
+          double value = referenceImage->GetScalarComponentAsDouble(i, j, k, 0);
+          expected.Sum += weight * value;
+          expected.SumOfSquares += weight * value * value;
+          expected.WeightOfValues[value] += weight;
+          }
+        }
+      }
+    }
+  return expected;
+}
+
+//----------------------------------------------------------------------------
+/// Smallest value below which (inclusive) at least the given percentage of the weights fall
+double ComputeExpectedPercentile(const ExpectedStatistics& expected, double percentile)
+{
+  double targetWeight = expected.VoxelCount * percentile / 100.0;
+  double cumulativeWeight = 0.0;
+  for (std::map<double, double>::const_iterator valueIt = expected.WeightOfValues.begin();
+    valueIt != expected.WeightOfValues.end(); ++valueIt)
+    {
+    cumulativeWeight += valueIt->second;
+    if (cumulativeWeight >= targetWeight)
+      {
+      return valueIt->first;
+      }
+    }
+  return expected.WeightOfValues.rbegin()->first;
+}
+
+//----------------------------------------------------------------------------
+int CheckClose(double actual, double expected, double tolerance, const char* name, int segmentIndex)
+{
+  if (std::abs(actual - expected) > tolerance)
+    {
+    std::cerr << "Segment " << segmentIndex << ": " << name << " is " << actual
+      << ", expected " << expected << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int CheckSegment(vtkSegmentStatisticsCalculator* calculator, int segmentIndex,
+  vtkOrientedImageData* labelmap, vtkOrientedImageData* referenceImage, double fractionalMaximum)
+{
+  ExpectedStatistics expected = ComputeExpectedStatistics(labelmap, referenceImage, fractionalMaximum);
+  CHECK_BOOL(expected.VoxelCount > 0, true);
+
+  CHECK_EXIT_SUCCESS(CheckClose(calculator->GetVoxelCount(segmentIndex), expected.VoxelCount, 1e-6, "voxel count", segmentIndex));
+  CHECK_EXIT_SUCCESS(CheckClose(calculator->GetVolumeMm3(segmentIndex), expected.VoxelCount * 1.0 * 2.0 * 0.5, 1e-6, "volume", segmentIndex));
+
+  vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+  labelmap->GetImageToWorldMatrix(imageToWorldMatrix.GetPointer());
+  double expectedCentroidIjk[4] = { expected.SumIjk[0] / expected.VoxelCount, expected.SumIjk[1] / expected.VoxelCount,
+    expected.SumIjk[2] / expected.VoxelCount, 1.0 };
+  double expectedCentroid[4] = { 0.0, 0.0, 0.0, 1.0 };
+  imageToWorldMatrix->MultiplyPoint(expectedCentroidIjk, expectedCentroid);
+  double centroid[3] = { 0.0, 0.0, 0.0 };
+  calculator->GetCentroid(segmentIndex, centroid);
+  for (int i = 0; i < 3; i++)
+    {
+    CHECK_EXIT_SUCCESS(CheckClose(centroid[i], expectedCentroid[i], 1e-6, "centroid", segmentIndex));
+    }
+
+  if (!referenceImage)
+    {
+    CHECK_BOOL(calculator->GetIntensityStatisticsComputed(), false);
+    CHECK_DOUBLE(calculator->GetMean(segmentIndex), 0.0);
+    return EXIT_SUCCESS;
+    }
+
+  CHECK_BOOL(calculator->GetIntensityStatisticsComputed(), true);
+  double expectedMean = expected.Sum / expected.VoxelCount;
+  double expectedStdev = std::sqrt(expected.SumOfSquares / expected.VoxelCount - expectedMean * expectedMean);
+  CHECK_EXIT_SUCCESS(CheckClose(calculator->GetMinimum(segmentIndex), expected.WeightOfValues.begin()->first, 0.0, "minimum", segmentIndex));
+  CHECK_EXIT_SUCCESS(CheckClose(calculator->GetMaximum(segmentIndex), expected.WeightOfValues.rbegin()->first, 0.0, "maximum", segmentIndex));
+  CHECK_EXIT_SUCCESS(CheckClose(calculator->GetSum(segmentIndex), expected.Sum, 1e-6, "sum", segmentIndex));
+  CHECK_EXIT_SUCCESS(CheckClose(calculator->GetSumOfSquares(segmentIndex), expected.SumOfSquares, 1e-3, "sum of squares", segmentIndex));
+  CHECK_EXIT_SUCCESS(CheckClose(calculator->GetMean(segmentIndex), expectedMean, 1e-6, "mean", segmentIndex));
+  CHECK_EXIT_SUCCESS(CheckClose(calculator->GetStandardDeviation(segmentIndex), expectedStdev, 1e-6, "standard deviation", segmentIndex));
+
+  // With the default number of bins each intensity value of the short reference image has its own bin,
+  // percentiles are exact
+  const double percentiles[5] = { 0.0, 5.0, 50.0, 95.0, 100.0 };
+  for (int i = 0; i < 5; i++)
+    {
+    CHECK_EXIT_SUCCESS(CheckClose(calculator->GetPercentile(segmentIndex, percentiles[i]),
+      ComputeExpectedPercentile(expected, percentiles[i]), 0.0, "percentile", segmentIndex));
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestStatistics(bool useReferenceImage)
+{
+  vtkNew<vtkOrientedImageData> referenceImage;
+  CreateReferenceImage(referenceImage.GetPointer());
+
+  // Binary segment inside the reference image
+  vtkNew<vtkOrientedImageData> insideLabelmap;
+  int insideExtent[6] = { 2, 11, 3, 9, 1, 8 };
+  CreateLabelmap(insideLabelmap.GetPointer(), insideExtent, 1);
+  // Binary segment partially outside of the reference image
+  vtkNew<vtkOrientedImageData> overlappingLabelmap;
+  int overlappingExtent[6] = { -3, 5, 10, 18, 6, 12 };
+  CreateLabelmap(overlappingLabelmap.GetPointer(), overlappingExtent, 1);
+  // Fractional segment with values between 0 and 4
+  vtkNew<vtkOrientedImageData> fractionalLabelmap;
+  int fractionalExtent[6] = { 5, 17, 0, 15, 0, 9 };
+  CreateLabelmap(fractionalLabelmap.GetPointer(), fractionalExtent, 4);
+  SetFractionalScalarRange(fractionalLabelmap.GetPointer(), 0.0, 4.0);
+  // Empty segment
+  vtkNew<vtkOrientedImageData> emptyLabelmap;
+  int emptyExtent[6] = { 0, 4, 0, 4, 0, 4 };
+  SetGeometry(emptyLabelmap.GetPointer(), emptyExtent);
+  emptyLabelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkOrientedImageDataResample::FillImage(emptyLabelmap.GetPointer(), 0);
+
+  vtkNew<vtkSegmentStatisticsCalculator> calculator;
+  if (useReferenceImage)
+    {
+    calculator->SetReferenceImage(referenceImage.GetPointer());
+    }
+  CHECK_INT(calculator->AddSegmentLabelmap(insideLabelmap.GetPointer()), 0);
+  CHECK_INT(calculator->AddSegmentLabelmap(overlappingLabelmap.GetPointer()), 1);
+  CHECK_INT(calculator->AddSegmentLabelmap(fractionalLabelmap.GetPointer()), 2);
+  CHECK_INT(calculator->AddSegmentLabelmap(emptyLabelmap.GetPointer()), 3);
+  CHECK_INT(calculator->GetNumberOfSegments(), 4);
+  CHECK_BOOL(calculator->Compute(), true);
+
+  vtkOrientedImageData* reference = (useReferenceImage ? referenceImage.GetPointer() : NULL);
+  CHECK_EXIT_SUCCESS(CheckSegment(calculator.GetPointer(), 0, insideLabelmap.GetPointer(), reference, 0.0));
+  CHECK_EXIT_SUCCESS(CheckSegment(calculator.GetPointer(), 1, overlappingLabelmap.GetPointer(), reference, 0.0));
+  CHECK_EXIT_SUCCESS(CheckSegment(calculator.GetPointer(), 2, fractionalLabelmap.GetPointer(), reference, 4.0));
+
+  CHECK_DOUBLE(calculator->GetVoxelCount(3), 0.0);
+  CHECK_DOUBLE(calculator->GetVolumeMm3(3), 0.0);
+  CHECK_DOUBLE(calculator->GetMean(3), 0.0);
+  CHECK_DOUBLE(calculator->GetPercentile(3, 50.0), 0.0);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestInterpolatedPercentiles()
+{
+  vtkNew<vtkOrientedImageData> referenceImage;
+  CreateReferenceImage(referenceImage.GetPointer());
+  vtkNew<vtkOrientedImageData> labelmap;
+  int extent[6] = { 0, 19, 0, 15, 0, 9 };
+  CreateLabelmap(labelmap.GetPointer(), extent, 1);
+
+  // 10 bins for 121 intensity values: percentiles are interpolated within bins
+  vtkNew<vtkSegmentStatisticsCalculator> calculator;
+  calculator->SetReferenceImage(referenceImage.GetPointer());
+  calculator->SetNumberOfHistogramBins(10);
+  calculator->AddSegmentLabelmap(labelmap.GetPointer());
+  CHECK_BOOL(calculator->Compute(), true);
+
+  ExpectedStatistics expected = ComputeExpectedStatistics(labelmap.GetPointer(), referenceImage.GetPointer(), 0.0);
+  const double binWidth = 120.0 / 10;
+  const double percentiles[3] = { 5.0, 50.0, 95.0 };
+  double previousValue = VTK_DOUBLE_MIN;
+  for (int i = 0; i < 3; i++)
+    {
+    double value = calculator->GetPercentile(0, percentiles[i]);
+    CHECK_EXIT_SUCCESS(CheckClose(value, ComputeExpectedPercentile(expected, percentiles[i]), binWidth, "interpolated percentile", 0));
+    CHECK_BOOL(value >= previousValue, true);
+    previousValue = value;
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestGeometryMismatch()
+{
+  vtkNew<vtkOrientedImageData> referenceImage;
+  CreateReferenceImage(referenceImage.GetPointer());
+  vtkNew<vtkOrientedImageData> labelmap;
+  int extent[6] = { 0, 4, 0, 4, 0, 4 };
+  CreateLabelmap(labelmap.GetPointer(), extent, 1);
+  labelmap->SetSpacing(1.0, 1.0, 1.0);
+
+  vtkNew<vtkSegmentStatisticsCalculator> calculator;
+  calculator->SetReferenceImage(referenceImage.GetPointer());
+  calculator->AddSegmentLabelmap(labelmap.GetPointer());
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(calculator->Compute(), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  CHECK_BOOL(calculator->GetIntensityStatisticsComputed(), false);
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSegmentStatisticsCalculatorTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestStatistics(true));
+  CHECK_EXIT_SUCCESS(TestStatistics(false));
+  CHECK_EXIT_SUCCESS(TestInterpolatedPercentiles());
+  CHECK_EXIT_SUCCESS(TestGeometryMismatch());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,178 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkSlicerSegmentationsModuleLogic.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLSegmentationNode.h"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <sstream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Labelmap with labels that do not fit in unsigned char and an extent that does not start at 0.
+/// Label 7 has two separate voxels, so its bounding box contains voxels of other labels.
+void CreateLabelmap(vtkOrientedImageData* labelmap)
+{
+  labelmap->SetExtent(-2, 13, 1, 10, 0, 5);
+  labelmap->SetSpacing(0.5, 1.5, 2.0);
+  labelmap->SetOrigin(-10.0, 20.0, 3.0);
+  labelmap->AllocateScalars(VTK_SHORT, 1);
+  vtkOrientedImageDataResample::FillImage(labelmap, 0);
+  for (int k = 1; k <= 3; k++)
+    {
+    for (int j = 2; j <= 5; j++)
+      {
+      for (int i = -1; i <= 4; i++)
+        {
+        labelmap->SetScalarComponentFromDouble(i, j, k, 0, 1);
+        }
+      }
+    }
+  for (int k = 2; k <= 5; k++)
+    {
+    for (int j = 6; j <= 10; j++)
+      {
+      for (int i = 8; i <= 9; i++)
+        {
+        labelmap->SetScalarComponentFromDouble(i, j, k, 0, 300);
+        }
+      }
+    }
+  labelmap->SetScalarComponentFromDouble(0, 3, 0, 0, 7);
+  labelmap->SetScalarComponentFromDouble(12, 9, 4, 0, 7);
+}
+
+//----------------------------------------------------------------------------
+int CheckSegment(vtkSegmentation* segmentation, int segmentIndex, vtkOrientedImageData* labelmap,
+  int label, const int expectedExtent[6])
+{
+  vtkSegment* segment = segmentation->GetNthSegment(segmentIndex);
+  CHECK_NOT_NULL(segment);
+  std::stringstream expectedName;
+  expectedName << "Label_" << label;
+  CHECK_STD_STRING(segment->GetName(), expectedName.str());
+
+  vtkOrientedImageData* binaryLabelmap = vtkOrientedImageData::SafeDownCast(
+    segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
+  CHECK_NOT_NULL(binaryLabelmap);
+  CHECK_INT(binaryLabelmap->GetScalarType(), VTK_UNSIGNED_CHAR);
+
+  // Cropped to the bounding box of the label
+  int* extent = binaryLabelmap->GetExtent();
+  for (int i = 0; i < 6; i++)
+    {
+    CHECK_INT(extent[i], expectedExtent[i]);
+    }
+
+  // Same geometry as the imported labelmap
+  vtkNew<vtkMatrix4x4> labelmapImageToWorld;
+  labelmap->GetImageToWorldMatrix(labelmapImageToWorld.GetPointer());
+  vtkNew<vtkMatrix4x4> binaryLabelmapImageToWorld;
+  binaryLabelmap->GetImageToWorldMatrix(binaryLabelmapImageToWorld.GetPointer());
+  for (int row = 0; row < 4; row++)
+    {
+    for (int column = 0; column < 4; column++)
+      {
+      CHECK_DOUBLE(binaryLabelmapImageToWorld->GetElement(row, column), labelmapImageToWorld->GetElement(row, column));
+      }
+    }
+
+  // Voxels of the label are 1, voxels of other labels within the bounding box are 0
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        int expectedValue = (labelmap->GetScalarComponentAsDouble(i, j, k, 0) == label ? 1 : 0);
+        CHECK_INT(static_cast<int>(binaryLabelmap->GetScalarComponentAsDouble(i, j, k, 0)), expectedValue);
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestImportLabelmap()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSegmentationNode> segmentationNode;
+  scene->AddNode(segmentationNode.GetPointer());
+
+  vtkNew<vtkOrientedImageData> labelmap;
+  CreateLabelmap(labelmap.GetPointer());
+  CHECK_BOOL(vtkSlicerSegmentationsModuleLogic::ImportLabelmapToSegmentationNode(
+    labelmap.GetPointer(), segmentationNode.GetPointer()), true);
+
+  // Segments are added in increasing label value order
+  vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
+  CHECK_INT(segmentation->GetNumberOfSegments(), 3);
+  const int expectedExtent1[6] = { -1, 4, 2, 5, 1, 3 };
+  CHECK_EXIT_SUCCESS(CheckSegment(segmentation, 0, labelmap.GetPointer(), 1, expectedExtent1));
+  const int expectedExtent7[6] = { 0, 12, 3, 9, 0, 4 };
+  CHECK_EXIT_SUCCESS(CheckSegment(segmentation, 1, labelmap.GetPointer(), 7, expectedExtent7));
+  const int expectedExtent300[6] = { 8, 9, 6, 10, 2, 5 };
+  CHECK_EXIT_SUCCESS(CheckSegment(segmentation, 2, labelmap.GetPointer(), 300, expectedExtent300));
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestImportEmptyLabelmap()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSegmentationNode> segmentationNode;
+  scene->AddNode(segmentationNode.GetPointer());
+
+  vtkNew<vtkOrientedImageData> labelmap;
+  labelmap->SetExtent(0, 4, 0, 4, 0, 4);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkOrientedImageDataResample::FillImage(labelmap.GetPointer(), 0);
+  CHECK_BOOL(vtkSlicerSegmentationsModuleLogic::ImportLabelmapToSegmentationNode(
+    labelmap.GetPointer(), segmentationNode.GetPointer()), true);
+  CHECK_INT(segmentationNode->GetSegmentation()->GetNumberOfSegments(), 0);
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSlicerSegmentationsModuleLogicImportTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestImportLabelmap());
+  CHECK_EXIT_SUCCESS(TestImportEmptyLabelmap());
+  return EXIT_SUCCESS;
+}
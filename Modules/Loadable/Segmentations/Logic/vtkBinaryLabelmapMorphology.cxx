@@ -0,0 +1,522 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkBinaryLabelmapMorphology.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+vtkStandardNewMacro(vtkBinaryLabelmapMorphology);
+
+namespace
+{
+
+/// Squared distance of voxels that have no feature voxel along the processed lines
+const float INFINITE_DISTANCE = VTK_FLOAT_MAX;
+
+//----------------------------------------------------------------------------
+/// Squared distance transform of one line of samples: d(q) = min_p ((q-p)*spacing)^2 + f(p).
+/// It is the lower envelope of parabolas rooted at the samples that have finite f.
+/// v and z are work arrays of size n and n+1.
+void DistanceTransformLine(const float* f, float* d, int n, double spacing, int* v, double* z)
+{
+  double spacing2 = spacing * spacing;
+  int k = -1;
+  for (int q = 0; q < n; q++)
+    {
+    if (f[q] >= INFINITE_DISTANCE)
+      {
+      continue;
+      }
+    double s = -VTK_DOUBLE_MAX;
+    while (k >= 0)
+      {
+      // intersection of the parabola rooted at q and the rightmost parabola of the envelope
+      int p = v[k];
+      s = ((f[q] + spacing2 * q * q) - (f[p] + spacing2 * p * p)) / (2.0 * spacing2 * (q - p));
+      if (s > z[k])
+        {
+        break;
+        }
+      k--;
+      }
+    if (k < 0)
+      {
+      s = -VTK_DOUBLE_MAX;
+      }
+    k++;
+    v[k] = q;
+    z[k] = s;
+    }
+
+  if (k < 0)
+    {
+    // no feature along this line
+    std::fill(d, d + n, INFINITE_DISTANCE);
+    return;
+    }
+  z[k + 1] = VTK_DOUBLE_MAX;
+
+  int j = 0;
+  for (int q = 0; q < n; q++)
+    {
+    while (z[j + 1] < q)
+      {
+      j++;
+      }
+    double distance = spacing * (q - v[j]);
+    d[q] = static_cast<float>(distance * distance + f[v[j]]);
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Runs the one-dimensional distance transform on all lines of the buffer along one axis
+class DistanceTransformAxisFunctor
+{
+public:
+  DistanceTransformAxisFunctor(float* distance, const int dimensions[3], int axis, double spacing)
+    : Distance(distance)
+    , Axis(axis)
+    , Spacing(spacing)
+  {
+    std::copy(dimensions, dimensions + 3, this->Dimensions);
+    this->Increments[0] = 1;
+    this->Increments[1] = dimensions[0];
+    this->Increments[2] = static_cast<vtkIdType>(dimensions[0]) * dimensions[1];
+  }
+
+  vtkIdType GetNumberOfLines()
+  {
+    return static_cast<vtkIdType>(this->Dimensions[(this->Axis + 1) % 3]) * this->Dimensions[(this->Axis + 2) % 3];
+  }
+
+  void operator()(vtkIdType lineBegin, vtkIdType lineEnd)
+  {
+    int n = this->Dimensions[this->Axis];
+    int axis1 = (this->Axis + 1) % 3;
+    int axis2 = (this->Axis + 2) % 3;
+    vtkIdType increment = this->Increments[this->Axis];
+    std::vector<float> f(n);
+    std::vector<float> d(n);
+    std::vector<int> v(n);
+    std::vector<double> z(n + 1);
+    for (vtkIdType line = lineBegin; line < lineEnd; line++)
+      {
+      vtkIdType index1 = line % this->Dimensions[axis1];
+      vtkIdType index2 = line / this->Dimensions[axis1];
+      float* linePtr = this->Distance + index1 * this->Increments[axis1] + index2 * this->Increments[axis2];
+      for (int q = 0; q < n; q++)
+        {
+        f[q] = linePtr[q * increment];
+        }
+      DistanceTransformLine(&f[0], &d[0], n, this->Spacing, &v[0], &z[0]);
+      for (int q = 0; q < n; q++)
+        {
+        linePtr[q * increment] = d[q];
+        }
+      }
+  }
+
+protected:
+  float* Distance;
+  int Dimensions[3];
+  vtkIdType Increments[3];
+  int Axis;
+  double Spacing;
+};
+
+//----------------------------------------------------------------------------
+/// Compute squared Euclidean distance to the nearest feature voxel in place.
+/// Buffer contains 0 for feature voxels and INFINITE_DISTANCE for all others.
+void ComputeSquaredDistance(float* distance, const int dimensions[3], const double spacing[3])
+{
+  for (int axis = 0; axis < 3; axis++)
+    {
+    if (dimensions[axis] < 2)
+      {
+      // nothing to propagate along this axis
+      continue;
+      }
+    DistanceTransformAxisFunctor functor(distance, dimensions, axis, spacing[axis]);
+    vtkSMPTools::For(0, functor.GetNumberOfLines(), functor);
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Sum of the values in a window of radius voxels around each sample along one axis, for all lines of the buffer.
+/// Window is clipped at the ends of the lines.
+class BoxSumAxisFunctor
+{
+public:
+  BoxSumAxisFunctor(int* sums, const int dimensions[3], int axis, int radius)
+    : Sums(sums)
+    , Axis(axis)
+    , Radius(radius)
+  {
+    std::copy(dimensions, dimensions + 3, this->Dimensions);
+    this->Increments[0] = 1;
+    this->Increments[1] = dimensions[0];
+    this->Increments[2] = static_cast<vtkIdType>(dimensions[0]) * dimensions[1];
+  }
+
+  vtkIdType GetNumberOfLines()
+  {
+    return static_cast<vtkIdType>(this->Dimensions[(this->Axis + 1) % 3]) * this->Dimensions[(this->Axis + 2) % 3];
+  }
+
+  void operator()(vtkIdType lineBegin, vtkIdType lineEnd)
+  {
+    int n = this->Dimensions[this->Axis];
+    int axis1 = (this->Axis + 1) % 3;
+    int axis2 = (this->Axis + 2) % 3;
+    vtkIdType increment = this->Increments[this->Axis];
+    std::vector<int> values(n);
+    for (vtkIdType line = lineBegin; line < lineEnd; line++)
+      {
+      vtkIdType index1 = line % this->Dimensions[axis1];
+      vtkIdType index2 = line / this->Dimensions[axis1];
+      int* linePtr = this->Sums + index1 * this->Increments[axis1] + index2 * this->Increments[axis2];
+      for (int q = 0; q < n; q++)
+        {
+        values[q] = linePtr[q * increment];
+        }
+      // running sum: add the sample entering the window, remove the one leaving it
+      int sum = 0;
+      for (int q = 0; q < std::min(this->Radius, n); q++)
+        {
+        sum += values[q];
+        }
+      for (int q = 0; q < n; q++)
+        {
+        if (q + this->Radius < n)
+          {
+          sum += values[q + this->Radius];
+          }
+        if (q - this->Radius - 1 >= 0)
+          {
+          sum -= values[q - this->Radius - 1];
+          }
+        linePtr[q * increment] = sum;
+        }
+      }
+  }
+
+protected:
+  int* Sums;
+  int Dimensions[3];
+  vtkIdType Increments[3];
+  int Axis;
+  int Radius;
+};
+
+//----------------------------------------------------------------------------
+/// Allocate output with the same geometry, extent and scalar type as the input (if they are different images)
+/// and set all voxels to background.
+void InitializeOutputLabelmap(vtkOrientedImageData* inputLabelmap, vtkOrientedImageData* outputLabelmap)
+{
+  if (outputLabelmap != inputLabelmap)
+    {
+    vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+    inputLabelmap->GetImageToWorldMatrix(imageToWorldMatrix.GetPointer());
+    outputLabelmap->SetExtent(inputLabelmap->GetExtent());
+    outputLabelmap->AllocateScalars(inputLabelmap->GetScalarType(), 1);
+    outputLabelmap->SetImageToWorldMatrix(imageToWorldMatrix.GetPointer());
+    }
+  vtkOrientedImageDataResample::FillImage(outputLabelmap, 0);
+}
+
+//----------------------------------------------------------------------------
+/// Initialize distance buffer from the region of the labelmap: voxels that are foreground (if foregroundIsFeature)
+/// or background (if !foregroundIsFeature) are feature voxels.
+template <class T>
+void InitializeDistanceGeneric(vtkImageData* labelmap, const int extent[6], bool foregroundIsFeature, float* distance)
+{
+  float* distancePtr = distance;
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      T* labelmapPtr = static_cast<T*>(labelmap->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        bool foreground = (*(labelmapPtr++) > 0);
+        *(distancePtr++) = (foreground == foregroundIsFeature) ? 0.0f : INFINITE_DISTANCE;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Write 1 into the region of the labelmap where the squared distance is larger than the threshold
+/// (if foregroundIsFar) or not larger than the threshold (if !foregroundIsFar), 0 elsewhere.
+template <class T>
+void WriteThresholdedDistanceGeneric(vtkImageData* labelmap, const int extent[6], const float* distance,
+  double squaredDistanceThreshold, bool foregroundIsFar)
+{
+  const float* distancePtr = distance;
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      T* labelmapPtr = static_cast<T*>(labelmap->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        bool farFromFeature = (*(distancePtr++) > squaredDistanceThreshold);
+        *(labelmapPtr++) = static_cast<T>(farFromFeature == foregroundIsFar ? 1 : 0);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Store 1 for foreground and 0 for background voxels of the region of the labelmap
+template <class T>
+void ReadForegroundGeneric(vtkImageData* labelmap, const int extent[6], int* foreground)
+{
+  int* foregroundPtr = foreground;
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      T* labelmapPtr = static_cast<T*>(labelmap->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        *(foregroundPtr++) = (*(labelmapPtr++) > 0) ? 1 : 0;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Write 1 into the region of the labelmap where more than half of the voxels of the kernel
+/// (clipped to the image extent) are foreground, 0 elsewhere.
+template <class T>
+void WriteMajorityGeneric(vtkImageData* labelmap, const int extent[6], const int* foregroundCounts,
+  const int radius[3], const int imageExtent[6])
+{
+  const int* countPtr = foregroundCounts;
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    int kernelSizeK = std::min(k + radius[2], imageExtent[5]) - std::max(k - radius[2], imageExtent[4]) + 1;
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      int kernelSizeJK = kernelSizeK * (std::min(j + radius[1], imageExtent[3]) - std::max(j - radius[1], imageExtent[2]) + 1);
+      T* labelmapPtr = static_cast<T*>(labelmap->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        int kernelSize = kernelSizeJK * (std::min(i + radius[0], imageExtent[1]) - std::max(i - radius[0], imageExtent[0]) + 1);
+        *(labelmapPtr++) = static_cast<T>(2 * (*(countPtr++)) > kernelSize ? 1 : 0);
+        }
+      }
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkBinaryLabelmapMorphology::vtkBinaryLabelmapMorphology()
+{
+}
+
+//----------------------------------------------------------------------------
+vtkBinaryLabelmapMorphology::~vtkBinaryLabelmapMorphology()
+{
+}
+
+//----------------------------------------------------------------------------
+bool vtkBinaryLabelmapMorphology::ApplyMargin(vtkOrientedImageData* inputLabelmap, vtkOrientedImageData* outputLabelmap, double marginMm)
+{
+  if (!inputLabelmap || !outputLabelmap)
+    {
+    vtkGenericWarningMacro("vtkBinaryLabelmapMorphology::ApplyMargin: Invalid inputs");
+    return false;
+    }
+  if (!inputLabelmap->GetPointData() || !inputLabelmap->GetPointData()->GetScalars())
+    {
+    vtkGenericWarningMacro("vtkBinaryLabelmapMorphology::ApplyMargin: Input labelmap is empty");
+    return false;
+    }
+
+  int inputExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  inputLabelmap->GetExtent(inputExtent);
+  double spacing[3] = { 1.0, 1.0, 1.0 };
+  inputLabelmap->GetSpacing(spacing);
+  int scalarType = inputLabelmap->GetScalarType();
+
+  int effectiveExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  bool emptyInput = !vtkOrientedImageDataResample::CalculateEffectiveExtent(inputLabelmap, effectiveExtent);
+
+  // Region that the margin operation may change: effective extent extended by the margin when growing,
+  // by one voxel when shrinking (to include the background voxels that the distance is computed from)
+  int processedExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  std::vector<float> distance;
+  bool grow = (marginMm > 0);
+  if (!emptyInput)
+    {
+    for (int axis = 0; axis < 3; axis++)
+      {
+      int marginVoxels = 1;
+      if (grow)
+        {
+        marginVoxels = static_cast<int>(floor(marginMm / spacing[axis])) + 1;
+        }
+      processedExtent[axis * 2] = std::max(effectiveExtent[axis * 2] - marginVoxels, inputExtent[axis * 2]);
+      processedExtent[axis * 2 + 1] = std::min(effectiveExtent[axis * 2 + 1] + marginVoxels, inputExtent[axis * 2 + 1]);
+      }
+    vtkIdType numberOfVoxels = static_cast<vtkIdType>(processedExtent[1] - processedExtent[0] + 1)
+      * (processedExtent[3] - processedExtent[2] + 1) * (processedExtent[5] - processedExtent[4] + 1);
+    distance.resize(numberOfVoxels);
+    switch (scalarType)
+      {
+      vtkTemplateMacro(InitializeDistanceGeneric<VTK_TT>(inputLabelmap, processedExtent, grow, &distance[0]));
+      default:
+        vtkGenericWarningMacro("vtkBinaryLabelmapMorphology::ApplyMargin: Unknown ScalarType");
+        return false;
+      }
+    }
+
+  // Output has the same geometry as the input. Distances are stored already, so input and output may be the same.
+  InitializeOutputLabelmap(inputLabelmap, outputLabelmap);
+  if (emptyInput)
+    {
+    return true;
+    }
+
+  int dimensions[3] = { processedExtent[1] - processedExtent[0] + 1, processedExtent[3] - processedExtent[2] + 1, processedExtent[5] - processedExtent[4] + 1 };
+  ComputeSquaredDistance(&distance[0], dimensions, spacing);
+
+  // Small tolerance to keep voxels that are exactly at the margin distance
+  double squaredMargin = marginMm * marginMm * (1.0 + 1e-6);
+  switch (scalarType)
+    {
+    // grow: foreground is where distance from the foreground is within margin
+    // shrink: foreground is where distance from the background is larger than margin
+    vtkTemplateMacro(WriteThresholdedDistanceGeneric<VTK_TT>(outputLabelmap, processedExtent, &distance[0], squaredMargin, !grow));
+    default:
+      vtkGenericWarningMacro("vtkBinaryLabelmapMorphology::ApplyMargin: Unknown ScalarType");
+      return false;
+    }
+  outputLabelmap->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkBinaryLabelmapMorphology::ApplyMedian(vtkOrientedImageData* inputLabelmap, vtkOrientedImageData* outputLabelmap, int kernelSize[3])
+{
+  if (!inputLabelmap || !outputLabelmap || !kernelSize)
+    {
+    vtkGenericWarningMacro("vtkBinaryLabelmapMorphology::ApplyMedian: Invalid inputs");
+    return false;
+    }
+  if (!inputLabelmap->GetPointData() || !inputLabelmap->GetPointData()->GetScalars())
+    {
+    vtkGenericWarningMacro("vtkBinaryLabelmapMorphology::ApplyMedian: Input labelmap is empty");
+    return false;
+    }
+
+  int inputExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  inputLabelmap->GetExtent(inputExtent);
+  int scalarType = inputLabelmap->GetScalarType();
+  int radius[3] = { 0, 0, 0 };
+  for (int axis = 0; axis < 3; axis++)
+    {
+    radius[axis] = std::max(0, (kernelSize[axis] - 1) / 2);
+    }
+
+  int effectiveExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  bool emptyInput = !vtkOrientedImageDataResample::CalculateEffectiveExtent(inputLabelmap, effectiveExtent);
+
+  // Only voxels within the kernel radius of the effective extent may become foreground
+  int processedExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  std::vector<int> foregroundCounts;
+  if (!emptyInput)
+    {
+    for (int axis = 0; axis < 3; axis++)
+      {
+      processedExtent[axis * 2] = std::max(effectiveExtent[axis * 2] - radius[axis], inputExtent[axis * 2]);
+      processedExtent[axis * 2 + 1] = std::min(effectiveExtent[axis * 2 + 1] + radius[axis], inputExtent[axis * 2 + 1]);
+      }
+    vtkIdType numberOfVoxels = static_cast<vtkIdType>(processedExtent[1] - processedExtent[0] + 1)
+      * (processedExtent[3] - processedExtent[2] + 1) * (processedExtent[5] - processedExtent[4] + 1);
+    foregroundCounts.resize(numberOfVoxels);
+    switch (scalarType)
+      {
+      vtkTemplateMacro(ReadForegroundGeneric<VTK_TT>(inputLabelmap, processedExtent, &foregroundCounts[0]));
+      default:
+        vtkGenericWarningMacro("vtkBinaryLabelmapMorphology::ApplyMedian: Unknown ScalarType");
+        return false;
+      }
+    }
+
+  InitializeOutputLabelmap(inputLabelmap, outputLabelmap);
+  if (emptyInput)
+    {
+    return true;
+    }
+
+  // Box kernel is separable: count foreground voxels in the kernel by a running sum along each axis.
+  // Voxels outside the processed extent are all background, so they do not contribute to the counts.
+  int dimensions[3] = { processedExtent[1] - processedExtent[0] + 1, processedExtent[3] - processedExtent[2] + 1, processedExtent[5] - processedExtent[4] + 1 };
+  for (int axis = 0; axis < 3; axis++)
+    {
+    if (radius[axis] < 1 || dimensions[axis] < 2)
+      {
+      continue;
+      }
+    BoxSumAxisFunctor functor(&foregroundCounts[0], dimensions, axis, radius[axis]);
+    vtkSMPTools::For(0, functor.GetNumberOfLines(), functor);
+    }
+
+  switch (scalarType)
+    {
+    vtkTemplateMacro(WriteMajorityGeneric<VTK_TT>(outputLabelmap, processedExtent, &foregroundCounts[0], radius, inputExtent));
+    default:
+      vtkGenericWarningMacro("vtkBinaryLabelmapMorphology::ApplyMedian: Unknown ScalarType");
+      return false;
+    }
+  outputLabelmap->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkBinaryLabelmapMorphology::ApplyOpening(vtkOrientedImageData* inputLabelmap, vtkOrientedImageData* outputLabelmap, double radiusMm)
+{
+  // Shrink then grow, the second step works in place on the output
+  return vtkBinaryLabelmapMorphology::ApplyMargin(inputLabelmap, outputLabelmap, -radiusMm)
+    && vtkBinaryLabelmapMorphology::ApplyMargin(outputLabelmap, outputLabelmap, radiusMm);
+}
+
+//----------------------------------------------------------------------------
+bool vtkBinaryLabelmapMorphology::ApplyClosing(vtkOrientedImageData* inputLabelmap, vtkOrientedImageData* outputLabelmap, double radiusMm)
+{
+  // Grow then shrink, the second step works in place on the output
+  return vtkBinaryLabelmapMorphology::ApplyMargin(inputLabelmap, outputLabelmap, radiusMm)
+    && vtkBinaryLabelmapMorphology::ApplyMargin(outputLabelmap, outputLabelmap, -radiusMm);
+}
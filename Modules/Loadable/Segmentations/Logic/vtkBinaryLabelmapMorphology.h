@@ -0,0 +1,79 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkBinaryLabelmapMorphology_h
+#define __vtkBinaryLabelmapMorphology_h
+
+#include "vtkSlicerSegmentationsModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+class vtkOrientedImageData;
+
+/// \ingroup Segmentations
+/// \brief Morphological operations on binary labelmaps
+///
+/// Margin, opening and closing use exact Euclidean distance transform. Squared Euclidean distance is computed in linear time by separable passes along the three axes,
+/// each pass computing the lower envelope of parabolas (Felzenszwalb and Huttenlocher). Distances are
+/// in millimeters, spacing of the image is taken into account along each axis, so the structuring
+/// element is an isotropic ball. Lines of each axis pass are processed in parallel.
+///
+/// Only the effective extent of the input (extent of non-zero voxels) extended by the margin or kernel radius is processed.
+/// Voxels with positive value are foreground. The output has the same geometry, extent and scalar type
+/// as the input, foreground voxels are set to 1 and background voxels to 0.
+class VTK_SLICER_SEGMENTATIONS_LOGIC_EXPORT vtkBinaryLabelmapMorphology : public vtkObject
+{
+public:
+  static vtkBinaryLabelmapMorphology* New();
+  vtkTypeMacro(vtkBinaryLabelmapMorphology, vtkObject);
+
+  /// Grow (positive marginMm) or shrink (negative marginMm) the foreground by an isotropic margin.
+  /// When growing, voxels closer than marginMm to the foreground are added. When shrinking, voxels
+  /// closer than -marginMm to the background are removed. Voxels outside of the image extent are
+  /// ignored, therefore shrinking does not remove voxels along the image boundary.
+  /// Input and output may be the same image.
+  /// \return Success flag
+  static bool ApplyMargin(vtkOrientedImageData* inputLabelmap, vtkOrientedImageData* outputLabelmap, double marginMm);
+
+  /// Morphological opening (shrink then grow by radiusMm). Removes foreground regions and protrusions
+  /// that are thinner than the diameter. Input and output may be the same image.
+  /// \return Success flag
+  static bool ApplyOpening(vtkOrientedImageData* inputLabelmap, vtkOrientedImageData* outputLabelmap, double radiusMm);
+
+  /// Morphological closing (grow then shrink by radiusMm). Fills holes and gaps that are
+  /// narrower than the diameter. Input and output may be the same image.
+  /// \return Success flag
+  static bool ApplyClosing(vtkOrientedImageData* inputLabelmap, vtkOrientedImageData* outputLabelmap, double radiusMm);
+
+  /// Median filter with a box kernel. On a binary labelmap the median is the majority: a voxel is foreground
+  /// if more than half of the voxels in the kernel are foreground. The kernel is clipped at the image boundary.
+  /// Foreground voxels in the kernel are counted by running sums along each axis, so the computation time
+  /// does not depend on the kernel size. Input and output may be the same image.
+  /// \param kernelSize Kernel size along each axis in voxels, should be an odd number
+  /// \return Success flag
+  static bool ApplyMedian(vtkOrientedImageData* inputLabelmap, vtkOrientedImageData* outputLabelmap, int kernelSize[3]);
+
+protected:
+  vtkBinaryLabelmapMorphology();
+  virtual ~vtkBinaryLabelmapMorphology();
+
+private:
+  vtkBinaryLabelmapMorphology(const vtkBinaryLabelmapMorphology&); // Not implemented
+  void operator=(const vtkBinaryLabelmapMorphology&);             // Not implemented
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include "vtkImageGrowCutSegment.h"
 
 #include <iostream>
+#include <limits>
 #include <vector>
 
 #include <vtkInformation.h>
@@ -9,11 +10,11 @@
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include <vtkTimerLog.h>
 
-#include "FibHeap.h"
-
 vtkStandardNewMacro(vtkImageGrowCutSegment);
 
 //----------------------------------------------------------------------------
@@ -22,57 +23,228 @@ const int DistancePixelTypeID = VTK_FLOAT;
 const DistancePixelType DIST_INF = std::numeric_limits<DistancePixelType>::max();
 const DistancePixelType DIST_EPSILON = 1e-3;
 
+// Number of buckets the intensity range is quantized into.
+// Larger number means less re-processing of voxels within a bucket
+// but more (mostly empty) buckets to step through.
+const int NUMBER_OF_DISTANCE_BUCKETS = 4096;
+
 //----------------------------------------------------------------------------
-class HeapNode : public FibHeapNode
+// Queue entry: voxel index and the distance it was queued with.
+// Entries are never updated in place: when the distance of a voxel decreases
+// a new entry is pushed and the old one is discarded when popped (lazy deletion).
+struct HeapNode
+{
+  DistancePixelType Key;
+  long Index;
+};
+
+//----------------------------------------------------------------------------
+// Bucket (radix) priority queue with quantized keys.
+//
+// Since all edge weights are non-negative and bounded by the intensity range
+// of the image, all keys in the queue are between the current minimum and
+// current minimum + maximum edge weight. Therefore a fixed number of buckets,
+// used in a circular manner, can hold all queued entries.
+//
+// Entries within the same bucket are not sorted. If a voxel is popped before
+// its final distance is known then it is re-queued when its distance decreases
+// (label-correcting), so the computed distances are still exact.
+class BucketQueue
 {
 public:
-  HeapNode()
-  : FibHeapNode()
-  , m_Key(0)
-  , m_Index(-1)
+  BucketQueue()
+  : BucketWidth(1.0)
+  , CurrentBucket(0)
+  , Size(0)
   {
   }
 
-  virtual void operator =(FibHeapNode& RHS)
+  void Initialize(DistancePixelType maximumEdgeWeight, int numberOfBuckets)
   {
-    FHN_Assign(RHS);
-    m_Key = ((HeapNode&)RHS).m_Key;
+    if (numberOfBuckets < 1)
+      {
+      numberOfBuckets = 1;
+      }
+    this->BucketWidth = maximumEdgeWeight / numberOfBuckets;
+    if (this->BucketWidth < DIST_EPSILON)
+      {
+      this->BucketWidth = DIST_EPSILON;
+      }
+    // +2: one bucket for rounding and one for the current bucket
+    size_t requiredNumberOfBuckets = static_cast<size_t>(maximumEdgeWeight / this->BucketWidth) + 2;
+    this->Buckets.clear();
+    this->Buckets.resize(requiredNumberOfBuckets);
+    this->CurrentBucket = 0;
+    this->Size = 0;
+  }
+
+  void Clear()
+  {
+    std::vector< std::vector<HeapNode> > emptyBuckets;
+    this->Buckets.swap(emptyBuckets);
+    this->CurrentBucket = 0;
+    this->Size = 0;
   }
 
-  virtual int operator ==(FibHeapNode& RHS)
+  bool IsEmpty() const
   {
-    if (FHN_Cmp(RHS))
+    return this->Size == 0;
+  }
+
+  void Push(long index, DistancePixelType key)
+  {
+    long long bucket = static_cast<long long>(key / this->BucketWidth);
+    if (bucket < this->CurrentBucket)
       {
-      return 0;
+      // may happen due to rounding error, keys never decrease below the current minimum
+      bucket = this->CurrentBucket;
       }
-    return m_Key == ((HeapNode&)RHS).m_Key ? 1 : 0;
+    HeapNode node;
+    node.Key = key;
+    node.Index = index;
+    this->Buckets[bucket % this->Buckets.size()].push_back(node);
+    this->Size++;
   }
 
-  virtual int operator <(FibHeapNode& RHS)
+  /// Remove an entry from the lowest non-empty bucket. Queue must not be empty.
+  HeapNode Pop()
   {
-    int x = FHN_Cmp(RHS);
-    if (x != 0)
+    std::vector<HeapNode>* bucket = &(this->Buckets[this->CurrentBucket % this->Buckets.size()]);
+    while (bucket->empty())
       {
-      return x < 0 ? 1 : 0;
+      this->CurrentBucket++;
+      bucket = &(this->Buckets[this->CurrentBucket % this->Buckets.size()]);
       }
-    return m_Key < ((HeapNode&)RHS).m_Key ? 1 : 0;
+    HeapNode node = bucket->back();
+    bucket->pop_back();
+    this->Size--;
+    return node;
   }
 
-  virtual void operator =(DistancePixelType newKeyVal)
+protected:
+  std::vector< std::vector<HeapNode> > Buckets;
+  DistancePixelType BucketWidth;
+  long long CurrentBucket;
+  size_t Size;
+};
+
+//----------------------------------------------------------------------------
+// Computes the number of neighbors that are processed at each voxel.
+// It is 0 for voxels at the image boundary and the full neighborhood size everywhere else.
+class NumberOfNeighborsFunctor
+{
+public:
+  NumberOfNeighborsFunctor(unsigned char* numberOfNeighbors, long dimX, long dimY, long dimZ, unsigned char fullNeighborhoodSize)
+  : NumberOfNeighbors(numberOfNeighbors), DimX(dimX), DimY(dimY), DimZ(dimZ), FullNeighborhoodSize(fullNeighborhoodSize)
   {
-    HeapNode tmp;
-    tmp.m_Key = m_Key = newKeyVal;
-    FHN_Assign(tmp);
   }
+  // Processes a range of slices
+  void operator()(vtkIdType beginZ, vtkIdType endZ)
+  {
+    for (vtkIdType z = beginZ; z < endZ; z++)
+      {
+      bool zEdge = (z == 0 || z == this->DimZ - 1);
+      unsigned char* nbSizePtr = this->NumberOfNeighbors + z * this->DimX * this->DimY;
+      for (long y = 0; y < this->DimY; y++)
+        {
+        bool yEdge = (y == 0 || y == this->DimY - 1);
+        *(nbSizePtr++) = 0; // x == 0 (there is always padding, so we don't need to check if m_DimX>0)
+        unsigned char nbSize = (zEdge || yEdge) ? 0 : this->FullNeighborhoodSize;
+        for (long x = this->DimX - 2; x > 0; x--)
+          {
+          *(nbSizePtr++) = nbSize;
+          }
+        *(nbSizePtr++) = 0; // x == m_DimX-1 (there is always padding, so we don't need to check if m_DimX>1)
+        }
+      }
+  }
+protected:
+  unsigned char* NumberOfNeighbors;
+  long DimX;
+  long DimY;
+  long DimZ;
+  unsigned char FullNeighborhoodSize;
+};
 
-  inline DistancePixelType GetKeyValue() { return m_Key; }
-  inline void SetKeyValue(DistancePixelType keyValue) { m_Key = keyValue; }
-  inline long int GetIndexValue() { return m_Index; }
-  inline void SetIndexValue(long int indexValue) { m_Index = indexValue; }
+//----------------------------------------------------------------------------
+// Initializes result labels and distances from the seeds and collects
+// the indices of voxels that the growing has to be started from.
+template<typename LabelPixelType>
+class InitializeSeedsFunctor
+{
+public:
+  InitializeSeedsFunctor(LabelPixelType* seedLabelVolumePtr, LabelPixelType* resultLabelVolumePtr,
+    DistancePixelType* distanceVolumePtr, bool segInitialized)
+  : SeedLabelVolumePtr(seedLabelVolumePtr)
+  , ResultLabelVolumePtr(resultLabelVolumePtr)
+  , DistanceVolumePtr(distanceVolumePtr)
+  , SegInitialized(segInitialized)
+  {
+  }
+  void Initialize()
+  {
+  }
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    std::vector<long>& seedIndices = this->SeedIndices.Local();
+    for (vtkIdType index = begin; index < end; index++)
+      {
+      LabelPixelType seedValue = this->SeedLabelVolumePtr[index];
+      if (seedValue == 0)
+        {
+        this->DistanceVolumePtr[index] = DIST_INF;
+        this->ResultLabelVolumePtr[index] = 0;
+        }
+      else if (!this->SegInitialized || this->ResultLabelVolumePtr[index] != seedValue)
+        {
+        // In incremental mode only grow from new/changed seeds
+        this->DistanceVolumePtr[index] = DIST_EPSILON;
+        this->ResultLabelVolumePtr[index] = seedValue;
+        seedIndices.push_back(index);
+        }
+      }
+  }
+  void Reduce()
+  {
+  }
+  vtkSMPThreadLocal< std::vector<long> > SeedIndices;
+protected:
+  LabelPixelType* SeedLabelVolumePtr;
+  LabelPixelType* ResultLabelVolumePtr;
+  DistancePixelType* DistanceVolumePtr;
+  bool SegInitialized;
+};
 
+//----------------------------------------------------------------------------
+// Restore previous result for voxels that were not reached in incremental update
+template<typename LabelPixelType>
+class RestoreUnreachedFunctor
+{
+public:
+  RestoreUnreachedFunctor(LabelPixelType* resultLabelVolumePtr, LabelPixelType* resultLabelVolumePrePtr,
+    DistancePixelType* distanceVolumePtr, DistancePixelType* distanceVolumePrePtr)
+  : ResultLabelVolumePtr(resultLabelVolumePtr)
+  , ResultLabelVolumePrePtr(resultLabelVolumePrePtr)
+  , DistanceVolumePtr(distanceVolumePtr)
+  , DistanceVolumePrePtr(distanceVolumePrePtr)
+  {
+  }
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType index = begin; index < end; index++)
+      {
+      if (this->ResultLabelVolumePtr[index] == 0)
+        {
+        this->ResultLabelVolumePtr[index] = this->ResultLabelVolumePrePtr[index];
+        this->DistanceVolumePtr[index] = this->DistanceVolumePrePtr[index];
+        }
+      }
+  }
 protected:
-  DistancePixelType m_Key;
-  long m_Index;
+  LabelPixelType* ResultLabelVolumePtr;
+  LabelPixelType* ResultLabelVolumePrePtr;
+  DistancePixelType* DistanceVolumePtr;
+  DistancePixelType* DistanceVolumePrePtr;
 };
 
 //----------------------------------------------------------------------------
@@ -107,16 +279,13 @@ public:
   std::vector<long> m_NeighborIndexOffsets;
   std::vector<unsigned char> m_NumberOfNeighbors;
 
-  FibHeap *m_Heap;
-  HeapNode *m_HeapNodes;
+  BucketQueue m_Heap;
   bool m_bSegInitialized;
 };
 
 //-----------------------------------------------------------------------------
 vtkImageGrowCutSegment::vtkInternal::vtkInternal()
 {
-  m_Heap = NULL;
-  m_HeapNodes = NULL;
   m_bSegInitialized = false;
   m_DistanceVolume = vtkSmartPointer<vtkImageData>::New();
   m_DistanceVolumePre = vtkSmartPointer<vtkImageData>::New();
@@ -133,16 +302,7 @@ vtkImageGrowCutSegment::vtkInternal::~vtkInternal()
 //-----------------------------------------------------------------------------
 void vtkImageGrowCutSegment::vtkInternal::Reset()
 {
-  if (m_Heap != NULL)
-    {
-    delete m_Heap;
-    m_Heap = NULL;
-    }
-  if (m_HeapNodes != NULL)
-    {
-    delete[]m_HeapNodes;
-    m_HeapNodes = NULL;
-    }
+  m_Heap.Clear();
   m_bSegInitialized = false;
   m_DistanceVolume->Initialize();
   m_DistanceVolumePre->Initialize();
@@ -154,16 +314,15 @@ void vtkImageGrowCutSegment::vtkInternal::Reset()
 template<typename IntensityPixelType, typename LabelPixelType>
 bool vtkImageGrowCutSegment::vtkInternal::InitializationAHP(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume)
 {
-  m_Heap = new FibHeap;
   long dimXYZ = m_DimX * m_DimY * m_DimZ;
-  if ((m_HeapNodes = new HeapNode[dimXYZ + 1]) == NULL)
-    {
-    vtkGenericWarningMacro("Memory allocation failed. Dimensions: " << m_DimX << "x" << m_DimY << "x" << m_DimZ);
-    return false;
-    }
-  IntensityPixelType* imSrc = static_cast<IntensityPixelType*>(intensityVolume->GetScalarPointer());
   LabelPixelType* seedLabelVolumePtr = static_cast<LabelPixelType*>(seedLabelVolume->GetScalarPointer());
 
+  // Edge weights are absolute intensity differences, therefore the largest possible
+  // edge weight is the intensity range. This determines the number of buckets.
+  double intensityRange[2] = { 0.0, 0.0 };
+  intensityVolume->GetScalarRange(intensityRange);
+  m_Heap.Initialize(static_cast<DistancePixelType>(intensityRange[1] - intensityRange[0]), NUMBER_OF_DISTANCE_BUCKETS);
+
   if (!m_bSegInitialized)
     {
     m_ResultLabelVolume->SetOrigin(seedLabelVolume->GetOrigin());
@@ -178,8 +337,6 @@ bool vtkImageGrowCutSegment::vtkInternal::InitializationAHP(vtkImageData *intens
     m_ResultLabelVolumePre->AllocateScalars(seedLabelVolume->GetScalarType(), 1);
     m_DistanceVolumePre->SetExtent(0, -1, 0, -1, 0, -1);
     m_DistanceVolumePre->AllocateScalars(DistancePixelTypeID, 1);
-    LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
-    DistancePixelType* distanceVolumePtr = static_cast<DistancePixelType*>(m_DistanceVolume->GetScalarPointer());
 
     // Compute index offset
     m_NeighborIndexOffsets.clear();
@@ -208,72 +365,25 @@ bool vtkImageGrowCutSegment::vtkInternal::InitializationAHP(vtkImageData *intens
     // The neighborhood size is everwhere the same (size of m_NeighborIndexOffsets)
     // except at the edges of the volume, where the neighborhood size is 0.
     m_NumberOfNeighbors.resize(dimXYZ);
-    const unsigned char numberOfNeighbors = m_NeighborIndexOffsets.size();
-    unsigned char* nbSizePtr = &(m_NumberOfNeighbors[0]);
-    for (int z = 0; z < m_DimZ; z++)
-      {
-      bool zEdge = (z == 0 || z == m_DimZ - 1);
-      for (int y = 0; y < m_DimY; y++)
-        {
-        bool yEdge = (y == 0 || y == m_DimY - 1);
-        *(nbSizePtr++) = 0; // x == 0 (there is always padding, so we don'neighborNewDistance need to check if m_DimX>0)
-        unsigned char nbSize = (zEdge || yEdge) ? 0 : numberOfNeighbors;
-        for (int x = m_DimX-2; x > 0; x--)
-          {
-          *(nbSizePtr++) = nbSize;
-          }
-        *(nbSizePtr++) = 0; // x == m_DimX-1 (there is always padding, so we don'neighborNewDistance need to check if m_DimX>1)
-        }
-      }
-
-    for (long index = 0; index < dimXYZ; index++)
-      {
-      LabelPixelType seedValue = seedLabelVolumePtr[index];
-      resultLabelVolumePtr[index] = seedValue;
-      if (seedValue == 0)
-        {
-        m_HeapNodes[index] = DIST_INF;
-        distanceVolumePtr[index] = DIST_INF;
-        }
-      else
-        {
-        m_HeapNodes[index] = DIST_EPSILON;
-        distanceVolumePtr[index] = DIST_EPSILON;
-        }
-      m_Heap->Insert(&m_HeapNodes[index]);
-      m_HeapNodes[index].SetIndexValue(index);
-      }
+    NumberOfNeighborsFunctor numberOfNeighborsFunctor(&(m_NumberOfNeighbors[0]), m_DimX, m_DimY, m_DimZ,
+      static_cast<unsigned char>(m_NeighborIndexOffsets.size()));
+    vtkSMPTools::For(0, m_DimZ, numberOfNeighborsFunctor);
     }
-  else
-    {
-    // Already initialized
-    LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
-    LabelPixelType* resultLabelVolumePrePtr = static_cast<LabelPixelType*>(m_ResultLabelVolumePre->GetScalarPointer());
-    DistancePixelType* distanceVolumePtr = static_cast<DistancePixelType*>(m_DistanceVolume->GetScalarPointer());
-    DistancePixelType* distanceVolumePrePtr = static_cast<DistancePixelType*>(m_DistanceVolumePre->GetScalarPointer());
 
-    for (long index = 0; index < dimXYZ; index++)
+  // Set initial labels and distances and collect voxels to grow from.
+  // In incremental mode only new/changed seeds are grown from.
+  LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
+  DistancePixelType* distanceVolumePtr = static_cast<DistancePixelType*>(m_DistanceVolume->GetScalarPointer());
+  InitializeSeedsFunctor<LabelPixelType> initializeSeedsFunctor(seedLabelVolumePtr, resultLabelVolumePtr,
+    distanceVolumePtr, m_bSegInitialized);
+  vtkSMPTools::For(0, dimXYZ, initializeSeedsFunctor);
+  vtkSMPThreadLocal< std::vector<long> >::iterator seedIndicesIt;
+  for (seedIndicesIt = initializeSeedsFunctor.SeedIndices.begin();
+    seedIndicesIt != initializeSeedsFunctor.SeedIndices.end(); ++seedIndicesIt)
+    {
+    for (std::vector<long>::iterator indexIt = seedIndicesIt->begin(); indexIt != seedIndicesIt->end(); ++indexIt)
       {
-      if (seedLabelVolumePtr[index] != 0)
-        {
-        // Only grow from new/changed seeds
-        if (resultLabelVolumePtr[index] != seedLabelVolumePtr[index])
-          {
-          m_HeapNodes[index] = DIST_EPSILON;
-          distanceVolumePtr[index] = DIST_EPSILON;
-          resultLabelVolumePtr[index] = seedLabelVolumePtr[index];
-          m_Heap->Insert(&m_HeapNodes[index]);
-          m_HeapNodes[index].SetIndexValue(index);
-          }
-        }
-      else
-        {
-        m_HeapNodes[index] = DIST_INF;
-        distanceVolumePtr[index] = DIST_INF;
-        resultLabelVolumePtr[index] = 0;
-        m_Heap->Insert(&m_HeapNodes[index]);
-        m_HeapNodes[index].SetIndexValue(index);
-        }
+      m_Heap.Push(*indexIt, DIST_EPSILON);
       }
     }
   return true;
@@ -281,133 +391,76 @@ bool vtkImageGrowCutSegment::vtkInternal::InitializationAHP(vtkImageData *intens
 
 //-----------------------------------------------------------------------------
 template<typename IntensityPixelType, typename LabelPixelType>
-void vtkImageGrowCutSegment::vtkInternal::DijkstraBasedClassificationAHP(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume)
+void vtkImageGrowCutSegment::vtkInternal::DijkstraBasedClassificationAHP(vtkImageData *intensityVolume, vtkImageData *vtkNotUsed(seedLabelVolume))
 {
   LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
+  DistancePixelType* distanceVolumePtr = static_cast<DistancePixelType*>(m_DistanceVolume->GetScalarPointer());
   IntensityPixelType* imSrc = static_cast<IntensityPixelType*>(intensityVolume->GetScalarPointer());
 
-  // Insert 0 then extract it, which will balance heap
-  HeapNode hnZero;
-  m_Heap->Insert(&hnZero);
-  m_Heap->ExtractMin();
+  // In incremental mode growing stops where the previous distance is smaller than the new one
+  DistancePixelType* distanceVolumePrePtr = NULL;
+  LabelPixelType* resultLabelVolumePrePtr = NULL;
+  if (m_bSegInitialized)
+    {
+    distanceVolumePrePtr = static_cast<DistancePixelType*>(m_DistanceVolumePre->GetScalarPointer());
+    resultLabelVolumePrePtr = static_cast<LabelPixelType*>(m_ResultLabelVolumePre->GetScalarPointer());
+    }
 
-  if (!m_bSegInitialized)
+  while (!m_Heap.IsEmpty())
     {
-    // Full computation
-    DistancePixelType* distanceVolumePtr = static_cast<DistancePixelType*>(m_DistanceVolume->GetScalarPointer());
-    LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
+    HeapNode hnMin = m_Heap.Pop();
+    long index = hnMin.Index;
+    DistancePixelType currentDistance = hnMin.Key;
 
-    // Normal Dijkstra (to be used in initializing the segmenter for the current image)
-    HeapNode hnTmp;
-    while (!m_Heap->IsEmpty())
+    // Skip outdated entries (distance of the voxel has been decreased since it was queued)
+    if (currentDistance > distanceVolumePtr[index])
       {
-      HeapNode* hnMin = (HeapNode *)m_Heap->ExtractMin();
-      long index = hnMin->GetIndexValue();
-      DistancePixelType currentDistance = hnMin->GetKeyValue();
-      LabelPixelType currentLabel = resultLabelVolumePtr[index];
-      distanceVolumePtr[index] = currentDistance;
-
-      // Update neighbors
-      DistancePixelType pixCenter = imSrc[index];
-      unsigned char nbSize = m_NumberOfNeighbors[index];
-      for (unsigned char i = 0; i < nbSize; i++)
-        {
-        long indexNgbh = index + m_NeighborIndexOffsets[i];
-        DistancePixelType neighborCurrentDistance = distanceVolumePtr[indexNgbh];
-        DistancePixelType neighborNewDistance = fabs(pixCenter - imSrc[indexNgbh]) + currentDistance;
-        if (neighborCurrentDistance > neighborNewDistance)
-          {
-          distanceVolumePtr[indexNgbh] = neighborNewDistance;
-          resultLabelVolumePtr[indexNgbh] = currentLabel;
-
-          hnTmp = m_HeapNodes[indexNgbh];
-          hnTmp.SetKeyValue(neighborNewDistance);
-          m_Heap->DecreaseKey(&m_HeapNodes[indexNgbh], hnTmp);
-          }
-        }
+      continue;
       }
-    }
-  else
-    {
-    // Quick update
 
-    LabelPixelType* resultLabelVolumePrePtr = static_cast<LabelPixelType*>(m_ResultLabelVolumePre->GetScalarPointer());
-
-    // Adaptive Dijkstra
-    HeapNode hnTmp;
-    long dimXYZ = m_DimX * m_DimY * m_DimZ;
-    while (!m_Heap->IsEmpty())
+    if (m_bSegInitialized && currentDistance > distanceVolumePrePtr[index])
       {
-      DistancePixelType* distanceVolumePrePtr = static_cast<DistancePixelType*>(m_DistanceVolumePre->GetScalarPointer());
-      DistancePixelType* distanceVolumePtr = static_cast<DistancePixelType*>(m_DistanceVolume->GetScalarPointer());
-
-      HeapNode* hnMin = (HeapNode *)m_Heap->ExtractMin();
-      DistancePixelType currentDistance = hnMin->GetKeyValue();
-
-      // Stop of minimum value is infinite
-      if (currentDistance == DIST_INF)
-        {
-        for (long index = 0; index < dimXYZ; index++)
-          {
-          if (resultLabelVolumePtr[index] == 0)
-            {
-            resultLabelVolumePtr[index] = resultLabelVolumePrePtr[index];
-            distanceVolumePtr[index] = distanceVolumePrePtr[index];
-            }
-          }
-        break;
-        }
-
       // Stop propagation when the new distance is larger than the previous one
-      long index = hnMin->GetIndexValue();
-      if (currentDistance > distanceVolumePrePtr[index])
-        {
-        distanceVolumePtr[index] = distanceVolumePrePtr[index];
-        resultLabelVolumePtr[index] = resultLabelVolumePrePtr[index];
-        continue;
-        }
+      distanceVolumePtr[index] = distanceVolumePrePtr[index];
+      resultLabelVolumePtr[index] = resultLabelVolumePrePtr[index];
+      continue;
+      }
 
-      LabelPixelType currentLabel = resultLabelVolumePtr[index];
-      distanceVolumePtr[index] = currentDistance;
+    LabelPixelType currentLabel = resultLabelVolumePtr[index];
 
-      // Update neighbors
-      DistancePixelType pixCenter = imSrc[index];
-      unsigned char nbSize = m_NumberOfNeighbors[index];
-      for (unsigned char i = 0; i < nbSize; i++)
+    // Update neighbors
+    DistancePixelType pixCenter = imSrc[index];
+    unsigned char nbSize = m_NumberOfNeighbors[index];
+    for (unsigned char i = 0; i < nbSize; i++)
+      {
+      long indexNgbh = index + m_NeighborIndexOffsets[i];
+      DistancePixelType neighborCurrentDistance = distanceVolumePtr[indexNgbh];
+      DistancePixelType neighborNewDistance = fabs(pixCenter - imSrc[indexNgbh]) + currentDistance;
+      if (neighborCurrentDistance > neighborNewDistance)
         {
-        long indexNgbh = index + m_NeighborIndexOffsets[i];
-        DistancePixelType neighborCurrentDistance = distanceVolumePtr[indexNgbh];
-        DistancePixelType neighborNewDistance = fabs(pixCenter - imSrc[indexNgbh]) + currentDistance;
-        if (neighborCurrentDistance > neighborNewDistance)
-          {
-          distanceVolumePtr[indexNgbh] = neighborNewDistance;
-          resultLabelVolumePtr[indexNgbh] = currentLabel;
-
-          hnTmp = m_HeapNodes[indexNgbh];
-          hnTmp.SetKeyValue(neighborNewDistance);
-          m_Heap->DecreaseKey(&m_HeapNodes[indexNgbh], hnTmp);
-          }
+        distanceVolumePtr[indexNgbh] = neighborNewDistance;
+        resultLabelVolumePtr[indexNgbh] = currentLabel;
+        m_Heap.Push(indexNgbh, neighborNewDistance);
         }
       }
     }
 
+  if (m_bSegInitialized)
+    {
+    // Voxels that have not been reached keep their previous label
+    long dimXYZ = m_DimX * m_DimY * m_DimZ;
+    RestoreUnreachedFunctor<LabelPixelType> restoreUnreachedFunctor(resultLabelVolumePtr, resultLabelVolumePrePtr,
+      distanceVolumePtr, distanceVolumePrePtr);
+    vtkSMPTools::For(0, dimXYZ, restoreUnreachedFunctor);
+    }
+
   // Update previous labels and distance information
   m_ResultLabelVolumePre->DeepCopy(m_ResultLabelVolume);
   m_DistanceVolumePre->DeepCopy(m_DistanceVolume);
   m_bSegInitialized = true;
 
   // Release memory
-  if (m_Heap != NULL)
-    {
-    delete m_Heap;
-    m_Heap = NULL;
-    }
-  //m_HeapNodes.clear();
-  if (m_HeapNodes != NULL)
-    {
-    delete[] m_HeapNodes;
-    m_HeapNodes = NULL;
-    }
+  m_Heap.Clear();
 }
 
 //-----------------------------------------------------------------------------
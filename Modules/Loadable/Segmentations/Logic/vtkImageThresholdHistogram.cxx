@@ -0,0 +1,264 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkImageThresholdHistogram.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageThresholdHistogram);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Counts voxels of each bin for a range of slices
+template <class T>
+class AccumulateHistogramFunctor
+{
+public:
+  AccumulateHistogramFunctor(vtkImageData* image, int numberOfBins, double binMinimum, double binWidth)
+  : Image(image)
+  , NumberOfBins(numberOfBins)
+  , BinMinimum(binMinimum)
+  , BinWidth(binWidth)
+  {
+  }
+
+  void Initialize()
+  {
+    this->Counts.Local().assign(this->NumberOfBins, 0);
+  }
+
+  void operator()(vtkIdType beginK, vtkIdType endK)
+  {
+    std::vector<vtkIdType>& counts = this->Counts.Local();
+    int extent[6] = { 0, -1, 0, -1, 0, -1 };
+    this->Image->GetExtent(extent);
+    int numberOfComponents = this->Image->GetNumberOfScalarComponents();
+    for (vtkIdType k = beginK; k < endK; k++)
+      {
+      for (int j = extent[2]; j <= extent[3]; j++)
+        {
+        T* imagePtr = static_cast<T*>(this->Image->GetScalarPointer(extent[0], j, static_cast<int>(k)));
+        for (int i = extent[0]; i <= extent[1]; i++, imagePtr += numberOfComponents)
+          {
+          double value = static_cast<double>(*imagePtr);
+          if (value != value)
+            {
+            // NaN is not in any range
+            continue;
+            }
+          int bin = static_cast<int>((value - this->BinMinimum) / this->BinWidth);
+          counts[std::max(0, std::min(bin, this->NumberOfBins - 1))]++;
+          }
+        }
+      }
+  }
+
+  void Reduce()
+  {
+  }
+
+  vtkSMPThreadLocal< std::vector<vtkIdType> > Counts;
+
+protected:
+  vtkImageData* Image;
+  int NumberOfBins;
+  double BinMinimum;
+  double BinWidth;
+};
+
+//----------------------------------------------------------------------------
+template <class T>
+void AccumulateHistogram(vtkImageData* image, int numberOfBins, double binMinimum, double binWidth,
+  std::vector<vtkIdType>& counts)
+{
+  counts.assign(numberOfBins, 0);
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  image->GetExtent(extent);
+  if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+    {
+    return;
+    }
+
+  AccumulateHistogramFunctor<T> functor(image, numberOfBins, binMinimum, binWidth);
+  vtkSMPTools::For(extent[4], extent[5] + 1, functor);
+
+  // Combine results of all threads
+  typedef vtkSMPThreadLocal< std::vector<vtkIdType> > ThreadLocalCountsType;
+  for (typename ThreadLocalCountsType::iterator threadIt = functor.Counts.begin();
+    threadIt != functor.Counts.end(); ++threadIt)
+    {
+    for (int bin = 0; bin < numberOfBins; bin++)
+      {
+      counts[bin] += (*threadIt)[bin];
+      }
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkImageThresholdHistogram::vtkImageThresholdHistogram()
+{
+  this->MaximumNumberOfBins = 65536;
+  this->ScalarRange[0] = 0.0;
+  this->ScalarRange[1] = 0.0;
+  this->BinWidth = 1.0;
+  this->IntegerBins = true;
+}
+
+//----------------------------------------------------------------------------
+vtkImageThresholdHistogram::~vtkImageThresholdHistogram()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkImageThresholdHistogram::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "InputData: " << this->InputData.GetPointer() << "\n";
+  os << indent << "MaximumNumberOfBins: " << this->MaximumNumberOfBins << "\n";
+  os << indent << "IntegerBins: " << (this->IntegerBins ? "true" : "false") << "\n";
+  os << indent << "NumberOfBins: " << (this->CumulativeCounts.empty() ? 0 : this->CumulativeCounts.size() - 1) << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkImageThresholdHistogram::SetInputData(vtkImageData* image)
+{
+  if (this->InputData == image)
+    {
+    return;
+    }
+  this->InputData = image;
+  this->CumulativeCounts.clear();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkImageThresholdHistogram::GetInputData()
+{
+  return this->InputData;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageThresholdHistogram::Update()
+{
+  vtkDataArray* scalars = (this->InputData ? this->InputData->GetPointData()->GetScalars() : NULL);
+  if (!scalars)
+    {
+    this->CumulativeCounts.clear();
+    return;
+    }
+  if (!this->CumulativeCounts.empty()
+    && this->HistogramComputeTime > this->GetMTime()
+    && this->HistogramComputeTime > this->InputData->GetMTime()
+    && this->HistogramComputeTime > scalars->GetMTime())
+    {
+    // histogram is up-to-date
+    return;
+    }
+
+  scalars->GetRange(this->ScalarRange, 0);
+  int scalarType = scalars->GetDataType();
+  double numberOfValues = this->ScalarRange[1] - this->ScalarRange[0] + 1.0;
+  this->IntegerBins = (scalarType != VTK_FLOAT && scalarType != VTK_DOUBLE && numberOfValues <= this->MaximumNumberOfBins);
+  int numberOfBins = this->MaximumNumberOfBins;
+  this->BinWidth = (this->ScalarRange[1] - this->ScalarRange[0]) / numberOfBins;
+  if (this->IntegerBins)
+    {
+    numberOfBins = static_cast<int>(numberOfValues);
+    this->BinWidth = 1.0;
+    }
+  else if (this->BinWidth <= 0.0)
+    {
+    // all voxels have the same value
+    numberOfBins = 1;
+    this->BinWidth = 1.0;
+    }
+
+  std::vector<vtkIdType> counts;
+  switch (scalarType)
+    {
+    vtkTemplateMacro(AccumulateHistogram<VTK_TT>(this->InputData, numberOfBins, this->ScalarRange[0], this->BinWidth, counts));
+    default:
+      vtkErrorMacro("Update: Unknown ScalarType");
+      this->CumulativeCounts.clear();
+      return;
+    }
+
+  this->CumulativeCounts.resize(numberOfBins + 1);
+  this->CumulativeCounts[0] = 0;
+  for (int bin = 0; bin < numberOfBins; bin++)
+    {
+    this->CumulativeCounts[bin + 1] = this->CumulativeCounts[bin] + counts[bin];
+    }
+  this->HistogramComputeTime.Modified();
+}
+
+//----------------------------------------------------------------------------
+double vtkImageThresholdHistogram::GetNumberOfVoxelsBelow(double value, bool inclusive)
+{
+  int numberOfBins = static_cast<int>(this->CumulativeCounts.size()) - 1;
+  double totalCount = static_cast<double>(this->CumulativeCounts[numberOfBins]);
+  if (value < this->ScalarRange[0] || (!inclusive && value == this->ScalarRange[0]))
+    {
+    return 0.0;
+    }
+  if (value > this->ScalarRange[1] || (inclusive && value == this->ScalarRange[1]))
+    {
+    return totalCount;
+    }
+
+  if (this->IntegerBins)
+    {
+    // first bin that is not counted
+    double firstExcludedValue = inclusive ? floor(value) + 1.0 : ceil(value);
+    int bin = static_cast<int>(firstExcludedValue - this->ScalarRange[0]);
+    return static_cast<double>(this->CumulativeCounts[std::max(0, std::min(bin, numberOfBins))]);
+    }
+
+  // Voxels are assumed to be evenly distributed within the bin
+  double position = (value - this->ScalarRange[0]) / this->BinWidth;
+  int bin = std::max(0, std::min(static_cast<int>(floor(position)), numberOfBins - 1));
+  double fraction = std::max(0.0, std::min(1.0, position - bin));
+  return this->CumulativeCounts[bin] + fraction * (this->CumulativeCounts[bin + 1] - this->CumulativeCounts[bin]);
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkImageThresholdHistogram::GetNumberOfVoxelsInRange(double lower, double upper)
+{
+  this->Update();
+  if (this->CumulativeCounts.empty() || lower > upper)
+    {
+    return 0;
+    }
+  double count = this->GetNumberOfVoxelsBelow(upper, true) - this->GetNumberOfVoxelsBelow(lower, false);
+  return static_cast<vtkIdType>(std::max(0.0, count) + 0.5);
+}
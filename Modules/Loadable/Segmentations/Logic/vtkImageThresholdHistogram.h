@@ -0,0 +1,88 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkImageThresholdHistogram_h
+#define __vtkImageThresholdHistogram_h
+
+#include "vtkSlicerSegmentationsModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimeStamp.h>
+
+// STD includes
+#include <vector>
+
+class vtkImageData;
+
+/// \ingroup Segmentations
+/// \brief Number of voxels of an image within an intensity range, for interactive threshold feedback
+///
+/// Cumulative histogram of the image is computed once (in parallel blocks of slices) and it is
+/// only recomputed if the image is modified, so that the number of voxels within a range can be
+/// queried at interactive rate, for example while a threshold range slider is dragged.
+///
+/// Images of integer scalar type that have at most MaximumNumberOfBins different values get one bin
+/// for each value and counts are exact. For other images the scalar range is divided into
+/// MaximumNumberOfBins bins and voxels are assumed to be evenly distributed within each bin.
+class VTK_SLICER_SEGMENTATIONS_LOGIC_EXPORT vtkImageThresholdHistogram : public vtkObject
+{
+public:
+  static vtkImageThresholdHistogram* New();
+  vtkTypeMacro(vtkImageThresholdHistogram, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Image that the voxels are counted in. Only the first scalar component is used.
+  void SetInputData(vtkImageData* image);
+  vtkImageData* GetInputData();
+
+  /// Maximum number of histogram bins. Default is 65536.
+  vtkSetClampMacro(MaximumNumberOfBins, int, 1, VTK_INT_MAX);
+  vtkGetMacro(MaximumNumberOfBins, int);
+
+  /// Recompute the histogram if the input image has been modified since the last computation.
+  /// Called automatically by GetNumberOfVoxelsInRange.
+  void Update();
+
+  /// Number of voxels with value in [lower, upper]
+  vtkIdType GetNumberOfVoxelsInRange(double lower, double upper);
+
+protected:
+  vtkImageThresholdHistogram();
+  virtual ~vtkImageThresholdHistogram();
+
+  /// Number of voxels with value lower than (or equal to, if inclusive is set) the given value
+  double GetNumberOfVoxelsBelow(double value, bool inclusive);
+
+  vtkSmartPointer<vtkImageData> InputData;
+  int MaximumNumberOfBins;
+
+  /// Scalar range of the input image, the first bin starts at the minimum
+  double ScalarRange[2];
+  double BinWidth;
+  /// Each integer value has its own bin, counts are exact
+  bool IntegerBins;
+  /// Number of voxels in all bins below the bin index (one more element than the number of bins)
+  std::vector<vtkIdType> CumulativeCounts;
+  vtkTimeStamp HistogramComputeTime;
+
+private:
+  vtkImageThresholdHistogram(const vtkImageThresholdHistogram&); // Not implemented
+  void operator=(const vtkImageThresholdHistogram&);            // Not implemented
+};
+
+#endif
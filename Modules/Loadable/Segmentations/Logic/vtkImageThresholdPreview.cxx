@@ -0,0 +1,134 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkImageThresholdPreview.h"
+
+// VTK includes
+#include <vtkDataObject.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <algorithm>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageThresholdPreview);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+template <class T>
+void ThresholdPreviewGeneric(vtkImageThresholdPreview* self, vtkImageData* inData, vtkImageData* outData, int outExt[6])
+{
+  double lower = self->GetLowerThreshold();
+  double upper = self->GetUpperThreshold();
+  double* color = self->GetColor();
+  unsigned char inColor[4] = { 0, 0, 0, 0 };
+  for (int c = 0; c < 4; c++)
+    {
+    inColor[c] = static_cast<unsigned char>(std::max(0.0, std::min(1.0, color[c])) * 255.0 + 0.5);
+    }
+  const unsigned char outColor[4] = { 0, 0, 0, 0 };
+
+  int numberOfInputComponents = inData->GetNumberOfScalarComponents();
+  for (int k = outExt[4]; k <= outExt[5]; k++)
+    {
+    for (int j = outExt[2]; j <= outExt[3]; j++)
+      {
+      T* inPtr = static_cast<T*>(inData->GetScalarPointer(outExt[0], j, k));
+      unsigned char* outPtr = static_cast<unsigned char*>(outData->GetScalarPointer(outExt[0], j, k));
+      for (int i = outExt[0]; i <= outExt[1]; i++, inPtr += numberOfInputComponents, outPtr += 4)
+        {
+        double value = static_cast<double>(*inPtr);
+        const unsigned char* voxelColor = (value >= lower && value <= upper) ? inColor : outColor;
+        std::copy(voxelColor, voxelColor + 4, outPtr);
+        }
+      }
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkImageThresholdPreview::vtkImageThresholdPreview()
+{
+  this->LowerThreshold = 0.0;
+  this->UpperThreshold = 0.0;
+  this->Color[0] = 1.0;
+  this->Color[1] = 1.0;
+  this->Color[2] = 1.0;
+  this->Color[3] = 1.0;
+}
+
+//----------------------------------------------------------------------------
+vtkImageThresholdPreview::~vtkImageThresholdPreview()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkImageThresholdPreview::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "LowerThreshold: " << this->LowerThreshold << "\n";
+  os << indent << "UpperThreshold: " << this->UpperThreshold << "\n";
+  os << indent << "Color: " << this->Color[0] << ", " << this->Color[1] << ", "
+    << this->Color[2] << ", " << this->Color[3] << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkImageThresholdPreview::ThresholdBetween(double lower, double upper)
+{
+  if (this->LowerThreshold == lower && this->UpperThreshold == upper)
+    {
+    return;
+    }
+  this->LowerThreshold = lower;
+  this->UpperThreshold = upper;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkImageThresholdPreview::RequestInformation(vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** vtkNotUsed(inputVector), vtkInformationVector* outputVector)
+{
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  vtkDataObject::SetPointDataActiveScalarInfo(outInfo, VTK_UNSIGNED_CHAR, 4);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageThresholdPreview::ThreadedRequestData(vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** vtkNotUsed(inputVector), vtkInformationVector* vtkNotUsed(outputVector),
+  vtkImageData*** inData, vtkImageData** outData, int outExt[6], int vtkNotUsed(threadId))
+{
+  if (!inData[0][0] || !outData[0] || !inData[0][0]->GetPointData()->GetScalars())
+    {
+    return;
+    }
+  switch (inData[0][0]->GetScalarType())
+    {
+    vtkTemplateMacro(ThresholdPreviewGeneric<VTK_TT>(this, inData[0][0], outData[0], outExt));
+    default:
+      vtkErrorMacro("ThreadedRequestData: Unknown input ScalarType");
+      return;
+    }
+}
@@ -0,0 +1,74 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkImageThresholdPreview_h
+#define __vtkImageThresholdPreview_h
+
+#include "vtkSlicerSegmentationsModuleLogicExport.h"
+
+// VTK includes
+#include <vtkThreadedImageAlgorithm.h>
+
+/// \ingroup Segmentations
+/// \brief Colored overlay of voxels that are within a threshold range
+///
+/// Output is an RGBA image: voxels with first component value in [LowerThreshold, UpperThreshold]
+/// get Color, all other voxels are fully transparent. Thresholding and color mapping are
+/// done in a single pass over the input.
+///
+/// The filter is intended to be connected to the reslice output of a slice layer logic, so that
+/// the overlay is only recomputed when the slice or the threshold range changes.
+class VTK_SLICER_SEGMENTATIONS_LOGIC_EXPORT vtkImageThresholdPreview : public vtkThreadedImageAlgorithm
+{
+public:
+  static vtkImageThresholdPreview* New();
+  vtkTypeMacro(vtkImageThresholdPreview, vtkThreadedImageAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Lowest value that is within the range
+  vtkSetMacro(LowerThreshold, double);
+  vtkGetMacro(LowerThreshold, double);
+
+  /// Highest value that is within the range
+  vtkSetMacro(UpperThreshold, double);
+  vtkGetMacro(UpperThreshold, double);
+
+  /// Set both thresholds at once
+  void ThresholdBetween(double lower, double upper);
+
+  /// Color of voxels within the range, RGBA, each component in the range 0.0-1.0
+  vtkSetVector4Macro(Color, double);
+  vtkGetVector4Macro(Color, double);
+
+protected:
+  vtkImageThresholdPreview();
+  virtual ~vtkImageThresholdPreview();
+
+  virtual int RequestInformation(vtkInformation* request, vtkInformationVector** inputVector, vtkInformationVector* outputVector);
+
+  virtual void ThreadedRequestData(vtkInformation* request, vtkInformationVector** inputVector, vtkInformationVector* outputVector,
+    vtkImageData*** inData, vtkImageData** outData, int outExt[6], int threadId);
+
+  double LowerThreshold;
+  double UpperThreshold;
+  double Color[4];
+
+private:
+  vtkImageThresholdPreview(const vtkImageThresholdPreview&); // Not implemented
+  void operator=(const vtkImageThresholdPreview&);          // Not implemented
+};
+
+#endif
@@ -0,0 +1,427 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkLabelmapJointSmoothing.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkLabelmapJointSmoothing);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Gaussian filtering of all lines of a buffer along one axis.
+/// The buffer covers a region of the image, values outside of the region are zero. Kernel weights
+/// are normalized by the sum of the weights of kernel samples that are inside the image extent,
+/// so that the smoothed indicators of all labels and the background still sum up to one at the image boundary.
+class GaussianAxisFunctor
+{
+public:
+  GaussianAxisFunctor(float* buffer, const int dimensions[3], int axis, const std::vector<double>& kernel,
+    int regionStart, int imageStart, int imageEnd)
+    : Buffer(buffer)
+    , Axis(axis)
+    , Kernel(kernel)
+  {
+    std::copy(dimensions, dimensions + 3, this->Dimensions);
+    this->Increments[0] = 1;
+    this->Increments[1] = dimensions[0];
+    this->Increments[2] = static_cast<vtkIdType>(dimensions[0]) * dimensions[1];
+
+    // Normalization only depends on the position along the axis
+    int n = dimensions[axis];
+    int radius = static_cast<int>(kernel.size()) - 1;
+    this->Normalization.resize(n);
+    for (int q = 0; q < n; q++)
+      {
+      double weightSum = 0.0;
+      for (int t = -radius; t <= radius; t++)
+        {
+        int imageIndex = regionStart + q + t;
+        if (imageIndex >= imageStart && imageIndex <= imageEnd)
+          {
+          weightSum += kernel[std::abs(t)];
+          }
+        }
+      this->Normalization[q] = (weightSum > 0.0 ? 1.0 / weightSum : 0.0);
+      }
+  }
+
+  vtkIdType GetNumberOfLines()
+  {
+    return static_cast<vtkIdType>(this->Dimensions[(this->Axis + 1) % 3]) * this->Dimensions[(this->Axis + 2) % 3];
+  }
+
+  void operator()(vtkIdType lineBegin, vtkIdType lineEnd)
+  {
+    int n = this->Dimensions[this->Axis];
+    int radius = static_cast<int>(this->Kernel.size()) - 1;
+    int axis1 = (this->Axis + 1) % 3;
+    int axis2 = (this->Axis + 2) % 3;
+    vtkIdType increment = this->Increments[this->Axis];
+    std::vector<float> values(n);
+    for (vtkIdType line = lineBegin; line < lineEnd; line++)
+      {
+      vtkIdType index1 = line % this->Dimensions[axis1];
+      vtkIdType index2 = line / this->Dimensions[axis1];
+      float* linePtr = this->Buffer + index1 * this->Increments[axis1] + index2 * this->Increments[axis2];
+      bool emptyLine = true;
+      for (int q = 0; q < n; q++)
+        {
+        values[q] = linePtr[q * increment];
+        if (values[q] != 0.0f)
+          {
+          emptyLine = false;
+          }
+        }
+      if (emptyLine)
+        {
+        continue;
+        }
+      for (int q = 0; q < n; q++)
+        {
+        double sum = 0.0;
+        int tStart = std::max(-radius, -q);
+        int tEnd = std::min(radius, n - 1 - q);
+        for (int t = tStart; t <= tEnd; t++)
+          {
+          sum += this->Kernel[std::abs(t)] * values[q + t];
+          }
+        linePtr[q * increment] = static_cast<float>(sum * this->Normalization[q]);
+        }
+      }
+  }
+
+protected:
+  float* Buffer;
+  int Dimensions[3];
+  vtkIdType Increments[3];
+  int Axis;
+  std::vector<double> Kernel;
+  std::vector<double> Normalization;
+};
+
+//----------------------------------------------------------------------------
+/// Add the smoothed indicator of a label to the sum of indicators and keep the label with the highest indicator.
+/// Slices of the label region are processed in parallel, they update distinct voxels.
+class AccumulateLabelFunctor
+{
+public:
+  AccumulateLabelFunctor(const float* indicator, const int labelRegion[6], const int processedExtent[6], int label,
+    float* indicatorSum, float* maximumIndicator, int* maximumLabel)
+    : Indicator(indicator)
+    , Label(label)
+    , IndicatorSum(indicatorSum)
+    , MaximumIndicator(maximumIndicator)
+    , MaximumLabel(maximumLabel)
+  {
+    std::copy(labelRegion, labelRegion + 6, this->LabelRegion);
+    std::copy(processedExtent, processedExtent + 6, this->ProcessedExtent);
+  }
+
+  void operator()(vtkIdType kBegin, vtkIdType kEnd)
+  {
+    int regionDimensions[2] = { this->LabelRegion[1] - this->LabelRegion[0] + 1, this->LabelRegion[3] - this->LabelRegion[2] + 1 };
+    int processedDimensions[2] = { this->ProcessedExtent[1] - this->ProcessedExtent[0] + 1, this->ProcessedExtent[3] - this->ProcessedExtent[2] + 1 };
+    for (int k = static_cast<int>(kBegin); k < kEnd; k++)
+      {
+      for (int j = this->LabelRegion[2]; j <= this->LabelRegion[3]; j++)
+        {
+        const float* indicatorPtr = this->Indicator
+          + (static_cast<vtkIdType>(k - this->LabelRegion[4]) * regionDimensions[1] + (j - this->LabelRegion[2])) * regionDimensions[0];
+        vtkIdType processedIndex = (static_cast<vtkIdType>(k - this->ProcessedExtent[4]) * processedDimensions[1]
+          + (j - this->ProcessedExtent[2])) * processedDimensions[0] + (this->LabelRegion[0] - this->ProcessedExtent[0]);
+        for (int i = this->LabelRegion[0]; i <= this->LabelRegion[1]; i++, indicatorPtr++, processedIndex++)
+          {
+          if (*indicatorPtr <= 0.0f)
+            {
+            continue;
+            }
+          this->IndicatorSum[processedIndex] += *indicatorPtr;
+          if (*indicatorPtr > this->MaximumIndicator[processedIndex])
+            {
+            this->MaximumIndicator[processedIndex] = *indicatorPtr;
+            this->MaximumLabel[processedIndex] = this->Label;
+            }
+          }
+        }
+      }
+  }
+
+protected:
+  const float* Indicator;
+  int LabelRegion[6];
+  int ProcessedExtent[6];
+  int Label;
+  float* IndicatorSum;
+  float* MaximumIndicator;
+  int* MaximumLabel;
+};
+
+//----------------------------------------------------------------------------
+/// Get bounding box of each positive label value. labelExtents contains 6 values for each label value.
+template <class T>
+void ComputeLabelExtentsGeneric(vtkImageData* labelmap, std::vector<int>& labelExtents)
+{
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  labelmap->GetExtent(extent);
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      T* labelmapPtr = static_cast<T*>(labelmap->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; i++, labelmapPtr++)
+        {
+        if (*labelmapPtr <= 0)
+          {
+          continue;
+          }
+        int label = static_cast<int>(*labelmapPtr);
+        if (static_cast<int>(labelExtents.size()) < (label + 1) * 6)
+          {
+          int emptyExtent[6] = { 0, -1, 0, -1, 0, -1 };
+          for (int newLabel = static_cast<int>(labelExtents.size()) / 6; newLabel <= label; newLabel++)
+            {
+            labelExtents.insert(labelExtents.end(), emptyExtent, emptyExtent + 6);
+            }
+          }
+        int* labelExtent = &labelExtents[label * 6];
+        if (labelExtent[0] > labelExtent[1])
+          {
+          labelExtent[0] = labelExtent[1] = i;
+          labelExtent[2] = labelExtent[3] = j;
+          labelExtent[4] = labelExtent[5] = k;
+          continue;
+          }
+        labelExtent[0] = std::min(labelExtent[0], i);
+        labelExtent[1] = std::max(labelExtent[1], i);
+        labelExtent[2] = std::min(labelExtent[2], j);
+        labelExtent[3] = std::max(labelExtent[3], j);
+        labelExtent[4] = std::min(labelExtent[4], k);
+        labelExtent[5] = std::max(labelExtent[5], k);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Store 1 for voxels of the label and 0 for all other voxels of the region of the labelmap
+template <class T>
+void ReadLabelIndicatorGeneric(vtkImageData* labelmap, const int extent[6], int label, float* indicator)
+{
+  float* indicatorPtr = indicator;
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      T* labelmapPtr = static_cast<T*>(labelmap->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; i++, labelmapPtr++)
+        {
+        *(indicatorPtr++) = (*labelmapPtr > 0 && static_cast<int>(*labelmapPtr) == label) ? 1.0f : 0.0f;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Write the label with the highest smoothed indicator into the region of the labelmap.
+/// Background is kept where its indicator (one minus the sum of label indicators) is not lower.
+template <class T>
+void WriteJointLabelsGeneric(vtkImageData* labelmap, const int extent[6], const float* indicatorSum,
+  const float* maximumIndicator, const int* maximumLabel)
+{
+  vtkIdType index = 0;
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      T* labelmapPtr = static_cast<T*>(labelmap->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; i++, index++)
+        {
+        bool foreground = (maximumLabel[index] > 0 && maximumIndicator[index] > 1.0f - indicatorSum[index]);
+        *(labelmapPtr++) = static_cast<T>(foreground ? maximumLabel[index] : 0);
+        }
+      }
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkLabelmapJointSmoothing::vtkLabelmapJointSmoothing()
+{
+}
+
+//----------------------------------------------------------------------------
+vtkLabelmapJointSmoothing::~vtkLabelmapJointSmoothing()
+{
+}
+
+//----------------------------------------------------------------------------
+bool vtkLabelmapJointSmoothing::Smooth(vtkOrientedImageData* inputLabelmap, vtkOrientedImageData* outputLabelmap, double standardDeviationMm)
+{
+  if (!inputLabelmap || !outputLabelmap)
+    {
+    vtkGenericWarningMacro("vtkLabelmapJointSmoothing::Smooth: Invalid inputs");
+    return false;
+    }
+  if (!inputLabelmap->GetPointData() || !inputLabelmap->GetPointData()->GetScalars())
+    {
+    vtkGenericWarningMacro("vtkLabelmapJointSmoothing::Smooth: Input labelmap is empty");
+    return false;
+    }
+
+  int inputExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  inputLabelmap->GetExtent(inputExtent);
+  double spacing[3] = { 1.0, 1.0, 1.0 };
+  inputLabelmap->GetSpacing(spacing);
+  int scalarType = inputLabelmap->GetScalarType();
+
+  std::vector<int> labelExtents;
+  switch (scalarType)
+    {
+    vtkTemplateMacro(ComputeLabelExtentsGeneric<VTK_TT>(inputLabelmap, labelExtents));
+    default:
+      vtkGenericWarningMacro("vtkLabelmapJointSmoothing::Smooth: Unknown ScalarType");
+      return false;
+    }
+
+  // Gaussian kernel along each axis, truncated at three standard deviations
+  std::vector<double> kernels[3];
+  int radius[3] = { 0, 0, 0 };
+  for (int axis = 0; axis < 3; axis++)
+    {
+    if (standardDeviationMm > 0.0 && spacing[axis] > 0.0)
+      {
+      radius[axis] = static_cast<int>(ceil(3.0 * standardDeviationMm / spacing[axis]));
+      }
+    for (int t = 0; t <= radius[axis]; t++)
+      {
+      double distanceInStandardDeviations = t * spacing[axis] / standardDeviationMm;
+      kernels[axis].push_back(radius[axis] > 0 ? exp(-0.5 * distanceInStandardDeviations * distanceInStandardDeviations) : 1.0);
+      }
+    }
+
+  // Region that smoothing may change: union of label bounding boxes extended by the kernel radius
+  int processedExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  int numberOfLabelValues = static_cast<int>(labelExtents.size()) / 6;
+  for (int label = 1; label < numberOfLabelValues; label++)
+    {
+    int* labelExtent = &labelExtents[label * 6];
+    if (labelExtent[0] > labelExtent[1])
+      {
+      continue;
+      }
+    for (int axis = 0; axis < 3; axis++)
+      {
+      labelExtent[axis * 2] = std::max(labelExtent[axis * 2] - radius[axis], inputExtent[axis * 2]);
+      labelExtent[axis * 2 + 1] = std::min(labelExtent[axis * 2 + 1] + radius[axis], inputExtent[axis * 2 + 1]);
+      }
+    if (processedExtent[0] > processedExtent[1])
+      {
+      std::copy(labelExtent, labelExtent + 6, processedExtent);
+      continue;
+      }
+    for (int axis = 0; axis < 3; axis++)
+      {
+      processedExtent[axis * 2] = std::min(processedExtent[axis * 2], labelExtent[axis * 2]);
+      processedExtent[axis * 2 + 1] = std::max(processedExtent[axis * 2 + 1], labelExtent[axis * 2 + 1]);
+      }
+    }
+
+  std::vector<float> indicatorSum;
+  std::vector<float> maximumIndicator;
+  std::vector<int> maximumLabel;
+  bool emptyInput = (processedExtent[0] > processedExtent[1]);
+  if (!emptyInput)
+    {
+    vtkIdType numberOfVoxels = static_cast<vtkIdType>(processedExtent[1] - processedExtent[0] + 1)
+      * (processedExtent[3] - processedExtent[2] + 1) * (processedExtent[5] - processedExtent[4] + 1);
+    indicatorSum.resize(numberOfVoxels, 0.0f);
+    maximumIndicator.resize(numberOfVoxels, 0.0f);
+    maximumLabel.resize(numberOfVoxels, 0);
+
+    std::vector<float> indicator;
+    for (int label = 1; label < numberOfLabelValues; label++)
+      {
+      int* labelRegion = &labelExtents[label * 6];
+      if (labelRegion[0] > labelRegion[1])
+        {
+        continue;
+        }
+      int dimensions[3] = { labelRegion[1] - labelRegion[0] + 1, labelRegion[3] - labelRegion[2] + 1, labelRegion[5] - labelRegion[4] + 1 };
+      indicator.resize(static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2]);
+      switch (scalarType)
+        {
+        vtkTemplateMacro(ReadLabelIndicatorGeneric<VTK_TT>(inputLabelmap, labelRegion, label, &indicator[0]));
+        }
+      for (int axis = 0; axis < 3; axis++)
+        {
+        if (radius[axis] < 1 || dimensions[axis] < 2)
+          {
+          continue;
+          }
+        GaussianAxisFunctor functor(&indicator[0], dimensions, axis, kernels[axis],
+          labelRegion[axis * 2], inputExtent[axis * 2], inputExtent[axis * 2 + 1]);
+        vtkSMPTools::For(0, functor.GetNumberOfLines(), functor);
+        }
+      AccumulateLabelFunctor accumulateFunctor(&indicator[0], labelRegion, processedExtent, label,
+        &indicatorSum[0], &maximumIndicator[0], &maximumLabel[0]);
+      vtkSMPTools::For(labelRegion[4], labelRegion[5] + 1, accumulateFunctor);
+      }
+    }
+
+  // Output has the same geometry as the input. Labels are stored already, so input and output may be the same.
+  if (outputLabelmap != inputLabelmap)
+    {
+    vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+    inputLabelmap->GetImageToWorldMatrix(imageToWorldMatrix.GetPointer());
+    outputLabelmap->SetExtent(inputExtent);
+    outputLabelmap->AllocateScalars(scalarType, 1);
+    outputLabelmap->SetImageToWorldMatrix(imageToWorldMatrix.GetPointer());
+    }
+  vtkOrientedImageDataResample::FillImage(outputLabelmap, 0);
+  if (emptyInput)
+    {
+    return true;
+    }
+
+  switch (scalarType)
+    {
+    vtkTemplateMacro(WriteJointLabelsGeneric<VTK_TT>(outputLabelmap, processedExtent,
+      &indicatorSum[0], &maximumIndicator[0], &maximumLabel[0]));
+    }
+  outputLabelmap->Modified();
+  return true;
+}
@@ -0,0 +1,59 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkLabelmapJointSmoothing_h
+#define __vtkLabelmapJointSmoothing_h
+
+#include "vtkSlicerSegmentationsModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+class vtkOrientedImageData;
+
+/// \ingroup Segmentations
+/// \brief Smooth all labels of a labelmap at once
+///
+/// The indicator function of each label is smoothed by a Gaussian filter and each voxel gets
+/// the label that has the highest smoothed value. Background competes with the labels, its smoothed
+/// indicator is one minus the sum of the smoothed label indicators. As every voxel is assigned exactly
+/// one label, smoothing does not create gaps or overlaps between neighboring labels.
+///
+/// Each label is only processed in its bounding box extended by the kernel radius and the separable
+/// filter passes are run in parallel, so the computation time is proportional to the size of the labels.
+class VTK_SLICER_SEGMENTATIONS_LOGIC_EXPORT vtkLabelmapJointSmoothing : public vtkObject
+{
+public:
+  static vtkLabelmapJointSmoothing* New();
+  vtkTypeMacro(vtkLabelmapJointSmoothing, vtkObject);
+
+  /// Smooth all labels of the input labelmap.
+  /// Voxels with positive value are labels, all other voxels are background. The output has the same
+  /// geometry, extent and scalar type as the input. Input and output may be the same image.
+  /// \param standardDeviationMm Standard deviation of the Gaussian kernel. Kernel is truncated at three standard deviations.
+  /// \return Success flag
+  static bool Smooth(vtkOrientedImageData* inputLabelmap, vtkOrientedImageData* outputLabelmap, double standardDeviationMm);
+
+protected:
+  vtkLabelmapJointSmoothing();
+  virtual ~vtkLabelmapJointSmoothing();
+
+private:
+  vtkLabelmapJointSmoothing(const vtkLabelmapJointSmoothing&); // Not implemented
+  void operator=(const vtkLabelmapJointSmoothing&);           // Not implemented
+};
+
+#endif
@@ -0,0 +1,306 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkLabelmapOutlineRasterizer.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkSMPTools.h>
+#include <vtkVector.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkLabelmapOutlineRasterizer);
+vtkCxxSetObjectMacro(vtkLabelmapOutlineRasterizer, Outline, vtkPoints);
+vtkCxxSetObjectMacro(vtkLabelmapOutlineRasterizer, ImageToViewMatrix, vtkMatrix4x4);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Fills the rows of a range of slices
+template <class T>
+class OutlineRasterizerFunctor
+{
+public:
+  OutlineRasterizerFunctor(vtkImageData* labelmap, const int extent[6], const std::vector<vtkVector2d>& polygon,
+    vtkMatrix4x4* imageToView, const double depthRange[2], T insideValue, T outsideValue)
+  : Labelmap(labelmap)
+  , Polygon(polygon)
+  , InsideValue(insideValue)
+  , OutsideValue(outsideValue)
+  {
+    std::copy(extent, extent + 6, this->Extent);
+    for (int row = 0; row < 4; row++)
+      {
+      for (int column = 0; column < 4; column++)
+        {
+        this->ImageToView[row][column] = imageToView->GetElement(row, column);
+        }
+      }
+    this->DepthRange[0] = depthRange[0];
+    this->DepthRange[1] = depthRange[1];
+  }
+
+  void operator()(vtkIdType kBegin, vtkIdType kEnd)
+  {
+    std::vector<double> crossings;
+    for (int k = static_cast<int>(kBegin); k < static_cast<int>(kEnd); k++)
+      {
+      for (int j = this->Extent[2]; j <= this->Extent[3]; j++)
+        {
+        T* rowPtr = static_cast<T*>(this->Labelmap->GetScalarPointer(this->Extent[0], j, k));
+        this->FillRow(j, k, rowPtr, crossings);
+        }
+      }
+  }
+
+protected:
+  void FillRow(int j, int k, T* rowPtr, std::vector<double>& crossings)
+  {
+    // Coordinates along the row: start[r] + i * step[r] (x, y, w, depth)
+    double start[4] = { 0.0 };
+    double step[4] = { 0.0 };
+    for (int r = 0; r < 4; r++)
+      {
+      start[r] = this->ImageToView[r][1] * j + this->ImageToView[r][2] * k + this->ImageToView[r][3];
+      step[r] = this->ImageToView[r][0];
+      }
+
+    // Part of the row between the depth limits
+    double iMin = this->Extent[0];
+    double iMax = this->Extent[1];
+    if (step[3] == 0.0)
+      {
+      if (start[3] < this->DepthRange[0] || start[3] > this->DepthRange[1])
+        {
+        iMin = iMax + 1.0;
+        }
+      }
+    else
+      {
+      double iNear = (this->DepthRange[0] - start[3]) / step[3];
+      double iFar = (this->DepthRange[1] - start[3]) / step[3];
+      iMin = std::max(iMin, std::min(iNear, iFar));
+      iMax = std::min(iMax, std::max(iNear, iFar));
+      }
+    int iFirst = (iMin <= iMax) ? static_cast<int>(ceil(iMin)) : this->Extent[1] + 1;
+    int iLast = (iMin <= iMax) ? static_cast<int>(floor(iMax)) : this->Extent[1];
+
+    // Line of the row in homogeneous view coordinates
+    double startPoint[3] = { start[0], start[1], start[2] };
+    double stepPoint[3] = { step[0], step[1], step[2] };
+    double line[3] = { 0.0 };
+    vtkMath::Cross(startPoint, stepPoint, line);
+
+    crossings.clear();
+    bool insideAtStart = false;
+    if (vtkMath::Norm(line) <= 1e-12 * vtkMath::Norm(startPoint) * vtkMath::Norm(stepPoint))
+      {
+      // The whole row projects to a single point
+      if (start[2] != 0.0)
+        {
+        insideAtStart = this->IsInsidePolygon(start[0] / start[2], start[1] / start[2]);
+        }
+      else if (step[2] != 0.0)
+        {
+        insideAtStart = this->IsInsidePolygon(step[0] / step[2], step[1] / step[2]);
+        }
+      }
+    else
+      {
+      size_t numberOfPoints = this->Polygon.size();
+      for (size_t pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+        {
+        const vtkVector2d& p0 = this->Polygon[pointIndex];
+        const vtkVector2d& p1 = this->Polygon[(pointIndex + 1) % numberOfPoints];
+        bool side0 = (line[0] * p0[0] + line[1] * p0[1] + line[2] > 0.0);
+        bool side1 = (line[0] * p1[0] + line[1] * p1[1] + line[2] > 0.0);
+        if (side0 == side1)
+          {
+          continue;
+          }
+        // Position along the row where the projected voxel is on the line of the edge
+        double edge[2] = { p1[0] - p0[0], p1[1] - p0[1] };
+        double distanceStart = edge[0] * (start[1] - p0[1] * start[2]) - edge[1] * (start[0] - p0[0] * start[2]);
+        double distanceStep = edge[0] * (step[1] - p0[1] * step[2]) - edge[1] * (step[0] - p0[0] * step[2]);
+        if (distanceStep == 0.0)
+          {
+          continue;
+          }
+        double crossing = -distanceStart / distanceStep;
+        // Crossings behind the camera are not on the projected row
+        if (start[2] + crossing * step[2] <= 0.0)
+          {
+          continue;
+          }
+        crossings.push_back(crossing);
+        }
+      std::sort(crossings.begin(), crossings.end());
+      }
+
+    // Inside/outside flips at each crossing. The projected row starts outside of the polygon
+    // at its end that is far from the vanishing point (the lower end in affine mapping).
+    bool countFromEnd = (step[2] < 0.0);
+    size_t crossingIndex = 0;
+    for (int i = this->Extent[0]; i <= this->Extent[1]; i++, rowPtr++)
+      {
+      if (i < iFirst || i > iLast)
+        {
+        *rowPtr = this->OutsideValue;
+        continue;
+        }
+      while (crossingIndex < crossings.size() && crossings[crossingIndex] < i)
+        {
+        crossingIndex++;
+        }
+      size_t numberOfCrossings = countFromEnd ? crossings.size() - crossingIndex : crossingIndex;
+      bool inside = (numberOfCrossings % 2 == 1) != insideAtStart;
+      *rowPtr = inside ? this->InsideValue : this->OutsideValue;
+      }
+  }
+
+  /// Even-odd point in polygon test
+  bool IsInsidePolygon(double x, double y)
+  {
+    bool inside = false;
+    size_t numberOfPoints = this->Polygon.size();
+    for (size_t pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+      {
+      const vtkVector2d& p0 = this->Polygon[pointIndex];
+      const vtkVector2d& p1 = this->Polygon[(pointIndex + 1) % numberOfPoints];
+      if ((p0[1] > y) != (p1[1] > y)
+        && x < p0[0] + (y - p0[1]) * (p1[0] - p0[0]) / (p1[1] - p0[1]))
+        {
+        inside = !inside;
+        }
+      }
+    return inside;
+  }
+
+  vtkImageData* Labelmap;
+  int Extent[6];
+  const std::vector<vtkVector2d>& Polygon;
+  double ImageToView[4][4];
+  double DepthRange[2];
+  T InsideValue;
+  T OutsideValue;
+};
+
+//----------------------------------------------------------------------------
+template <class T>
+void FillLabelmapGeneric(vtkImageData* labelmap, const int extent[6], const std::vector<vtkVector2d>& polygon,
+  vtkMatrix4x4* imageToView, const double depthRange[2], double insideValue, double outsideValue)
+{
+  OutlineRasterizerFunctor<T> functor(labelmap, extent, polygon, imageToView, depthRange,
+    static_cast<T>(insideValue), static_cast<T>(outsideValue));
+  vtkSMPTools::For(extent[4], extent[5] + 1, functor);
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkLabelmapOutlineRasterizer::vtkLabelmapOutlineRasterizer()
+{
+  this->Outline = NULL;
+  this->ImageToViewMatrix = NULL;
+  this->DepthRange[0] = -VTK_DOUBLE_MAX;
+  this->DepthRange[1] = VTK_DOUBLE_MAX;
+  this->InsideValue = 1.0;
+  this->OutsideValue = 0.0;
+}
+
+//----------------------------------------------------------------------------
+vtkLabelmapOutlineRasterizer::~vtkLabelmapOutlineRasterizer()
+{
+  this->SetOutline(NULL);
+  this->SetImageToViewMatrix(NULL);
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapOutlineRasterizer::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Outline: " << this->Outline << "\n";
+  os << indent << "ImageToViewMatrix: " << this->ImageToViewMatrix << "\n";
+  os << indent << "DepthRange: " << this->DepthRange[0] << ", " << this->DepthRange[1] << "\n";
+  os << indent << "InsideValue: " << this->InsideValue << "\n";
+  os << indent << "OutsideValue: " << this->OutsideValue << "\n";
+}
+
+//----------------------------------------------------------------------------
+bool vtkLabelmapOutlineRasterizer::FillLabelmap(vtkImageData* labelmap, const int extent[6])
+{
+  if (!labelmap || !labelmap->GetPointData() || !labelmap->GetPointData()->GetScalars())
+    {
+    vtkErrorMacro("FillLabelmap: Invalid labelmap");
+    return false;
+    }
+  if (labelmap->GetNumberOfScalarComponents() != 1)
+    {
+    vtkErrorMacro("FillLabelmap: Labelmap must have a single scalar component");
+    return false;
+    }
+  if (!this->Outline || !this->ImageToViewMatrix)
+    {
+    vtkErrorMacro("FillLabelmap: Outline and image to view matrix must be set");
+    return false;
+    }
+
+  // Only the part of the extent that is inside of the labelmap is filled
+  int labelmapExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  labelmap->GetExtent(labelmapExtent);
+  int fillExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  for (int i = 0; i < 3; i++)
+    {
+    fillExtent[i * 2] = std::max(extent[i * 2], labelmapExtent[i * 2]);
+    fillExtent[i * 2 + 1] = std::min(extent[i * 2 + 1], labelmapExtent[i * 2 + 1]);
+    if (fillExtent[i * 2] > fillExtent[i * 2 + 1])
+      {
+      // nothing to fill
+      return true;
+      }
+    }
+
+  std::vector<vtkVector2d> polygon;
+  for (vtkIdType pointIndex = 0; pointIndex < this->Outline->GetNumberOfPoints(); pointIndex++)
+    {
+    double* point = this->Outline->GetPoint(pointIndex);
+    polygon.push_back(vtkVector2d(point[0], point[1]));
+    }
+
+  switch (labelmap->GetScalarType())
+    {
+    vtkTemplateMacro(FillLabelmapGeneric<VTK_TT>(labelmap, fillExtent, polygon, this->ImageToViewMatrix,
+      this->DepthRange, this->InsideValue, this->OutsideValue));
+    default:
+      vtkErrorMacro("FillLabelmap: Unknown labelmap scalar type");
+      return false;
+    }
+  labelmap->Modified();
+  return true;
+}
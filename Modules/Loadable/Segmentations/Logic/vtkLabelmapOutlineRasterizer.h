@@ -0,0 +1,90 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkLabelmapOutlineRasterizer_h
+#define __vtkLabelmapOutlineRasterizer_h
+
+#include "vtkSlicerSegmentationsModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+class vtkImageData;
+class vtkMatrix4x4;
+class vtkPoints;
+
+/// \ingroup Segmentations
+/// \brief Fills a labelmap by an outline drawn in a view, extruded along the projection rays
+///
+/// Voxel positions are mapped to homogeneous view coordinates (x, y, w) and to depth by
+/// the rows of ImageToViewMatrix. The outline is a closed polygon in view coordinates (x/w, y/w),
+/// voxels between the depth limits that project inside the polygon (even-odd rule) get InsideValue,
+/// all other voxels of the filled extent get OutsideValue. Works for affine (slice view, parallel
+/// projection) and perspective mapping.
+///
+/// A voxel row projects onto a line of the view. The polygon edges that cross this line
+/// are found by the side of their endpoints and the crossing position along the row is
+/// computed in closed form, so each row is filled by intervals without testing voxels
+/// one by one. Slices are processed in parallel.
+class VTK_SLICER_SEGMENTATIONS_LOGIC_EXPORT vtkLabelmapOutlineRasterizer : public vtkObject
+{
+public:
+  static vtkLabelmapOutlineRasterizer* New();
+  vtkTypeMacro(vtkLabelmapOutlineRasterizer, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Closed outline in view coordinates. Only the first two coordinates of the points are used.
+  virtual void SetOutline(vtkPoints* outline);
+  vtkGetObjectMacro(Outline, vtkPoints);
+
+  /// Maps voxel (i, j, k, 1) to homogeneous view coordinates (x, y, w) and depth (4th row)
+  virtual void SetImageToViewMatrix(vtkMatrix4x4* matrix);
+  vtkGetObjectMacro(ImageToViewMatrix, vtkMatrix4x4);
+
+  /// Voxels are only inside if their depth is within this range (inclusive)
+  vtkSetVector2Macro(DepthRange, double);
+  vtkGetVector2Macro(DepthRange, double);
+
+  /// Value of voxels inside of the extruded outline. Default is 1.
+  vtkSetMacro(InsideValue, double);
+  vtkGetMacro(InsideValue, double);
+
+  /// Value of voxels outside of the extruded outline. Default is 0.
+  vtkSetMacro(OutsideValue, double);
+  vtkGetMacro(OutsideValue, double);
+
+  /// Fill the extent of the labelmap. Voxels outside of the extent are not changed.
+  /// The labelmap must have a single scalar component, any scalar type is accepted.
+  /// \return Success flag
+  bool FillLabelmap(vtkImageData* labelmap, const int extent[6]);
+
+protected:
+  vtkLabelmapOutlineRasterizer();
+  virtual ~vtkLabelmapOutlineRasterizer();
+
+  vtkPoints* Outline;
+  vtkMatrix4x4* ImageToViewMatrix;
+  double DepthRange[2];
+  double InsideValue;
+  double OutsideValue;
+
+private:
+  vtkLabelmapOutlineRasterizer(const vtkLabelmapOutlineRasterizer&); // Not implemented
+  void operator=(const vtkLabelmapOutlineRasterizer&);              // Not implemented
+};
+
+#endif
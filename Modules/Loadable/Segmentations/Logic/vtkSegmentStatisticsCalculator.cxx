@@ -0,0 +1,657 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkSegmentStatisticsCalculator.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+#include "vtkSegmentationConverter.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkFieldData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+vtkStandardNewMacro(vtkSegmentStatisticsCalculator);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct SegmentStatistics
+{
+  SegmentStatistics()
+  : VoxelCount(0.0)
+  , Sum(0.0)
+  , SumOfSquares(0.0)
+  , Minimum(VTK_DOUBLE_MAX)
+  , Maximum(VTK_DOUBLE_MIN)
+  {
+    this->SumIjk[0] = this->SumIjk[1] = this->SumIjk[2] = 0.0;
+  }
+  double VoxelCount;
+  double Sum;
+  double SumOfSquares;
+  double Minimum;
+  double Maximum;
+  double SumIjk[3];
+  std::vector<double> Histogram;
+};
+
+//----------------------------------------------------------------------------
+// Segment labelmap information that is needed for accumulating statistics
+struct SegmentInput
+{
+  vtkOrientedImageData* Labelmap;
+  int Extent[6]; // extent that is processed (intersection of labelmap and reference extent)
+  bool Fractional;
+  double WeightScale; // weight = (labelValue - WeightOffset) * WeightScale
+  double WeightOffset;
+};
+
+//----------------------------------------------------------------------------
+template <class ReferenceType, class LabelType>
+void AccumulateRow(const ReferenceType* referencePtr, const LabelType* labelPtr, int numberOfVoxels,
+  int i0, int j, int k, const SegmentInput& segment, SegmentStatistics& stats,
+  double histogramMinimum, double histogramBinWidth)
+{
+  int numberOfBins = static_cast<int>(stats.Histogram.size());
+  for (int i = 0; i < numberOfVoxels; i++)
+    {
+    double weight = 0.0;
+    if (segment.Fractional)
+      {
+      weight = (static_cast<double>(labelPtr[i]) - segment.WeightOffset) * segment.WeightScale;
+      if (weight <= 0.0)
+        {
+        continue;
+        }
+      if (weight > 1.0)
+        {
+        weight = 1.0;
+        }
+      }
+    else
+      {
+      if (labelPtr[i] <= 0)
+        {
+        continue;
+        }
+      weight = 1.0;
+      }
+    stats.VoxelCount += weight;
+    stats.SumIjk[0] += weight * (i0 + i);
+    stats.SumIjk[1] += weight * j;
+    stats.SumIjk[2] += weight * k;
+    if (referencePtr)
+      {
+      double value = static_cast<double>(referencePtr[i]);
+      stats.Sum += weight * value;
+      stats.SumOfSquares += weight * value * value;
+      if (value < stats.Minimum)
+        {
+        stats.Minimum = value;
+        }
+      if (value > stats.Maximum)
+        {
+        stats.Maximum = value;
+        }
+      int bin = static_cast<int>((value - histogramMinimum) / histogramBinWidth);
+      if (bin < 0)
+        {
+        bin = 0;
+        }
+      else if (bin >= numberOfBins)
+        {
+        bin = numberOfBins - 1;
+        }
+      stats.Histogram[bin] += weight;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Accumulates statistics of all segments for a range of slices
+template <class ReferenceType>
+class AccumulateStatisticsFunctor
+{
+public:
+  AccumulateStatisticsFunctor(vtkOrientedImageData* referenceImage, std::vector<SegmentInput>& segments,
+    int numberOfHistogramBins, double histogramMinimum, double histogramBinWidth)
+  : ReferenceImage(referenceImage)
+  , Segments(segments)
+  , NumberOfHistogramBins(numberOfHistogramBins)
+  , HistogramMinimum(histogramMinimum)
+  , HistogramBinWidth(histogramBinWidth)
+  {
+  }
+
+  void Initialize()
+  {
+    std::vector<SegmentStatistics>& statistics = this->Statistics.Local();
+    statistics.resize(this->Segments.size());
+    if (this->ReferenceImage)
+      {
+      for (std::vector<SegmentStatistics>::iterator statIt = statistics.begin(); statIt != statistics.end(); ++statIt)
+        {
+        statIt->Histogram.assign(this->NumberOfHistogramBins, 0.0);
+        }
+      }
+  }
+
+  void operator()(vtkIdType beginK, vtkIdType endK)
+  {
+    std::vector<SegmentStatistics>& statistics = this->Statistics.Local();
+    std::vector<size_t> sliceSegmentIndices;
+    for (vtkIdType k = beginK; k < endK; k++)
+      {
+      // Segments that overlap this slice
+      sliceSegmentIndices.clear();
+      int jRange[2] = { VTK_INT_MAX, VTK_INT_MIN };
+      for (size_t segmentIndex = 0; segmentIndex < this->Segments.size(); segmentIndex++)
+        {
+        const SegmentInput& segment = this->Segments[segmentIndex];
+        if (k < segment.Extent[4] || k > segment.Extent[5]
+          || segment.Extent[0] > segment.Extent[1] || segment.Extent[2] > segment.Extent[3])
+          {
+          continue;
+          }
+        sliceSegmentIndices.push_back(segmentIndex);
+        jRange[0] = std::min(jRange[0], segment.Extent[2]);
+        jRange[1] = std::max(jRange[1], segment.Extent[3]);
+        }
+
+      // Rows are visited in the outer loop so that each reference row is fetched
+      // from memory once and is still in cache when the next segment reads it.
+      for (int j = jRange[0]; j <= jRange[1]; j++)
+        {
+        for (std::vector<size_t>::iterator segmentIndexIt = sliceSegmentIndices.begin();
+          segmentIndexIt != sliceSegmentIndices.end(); ++segmentIndexIt)
+          {
+          const SegmentInput& segment = this->Segments[*segmentIndexIt];
+          if (j < segment.Extent[2] || j > segment.Extent[3])
+            {
+            continue;
+            }
+          ReferenceType* referencePtr = NULL;
+          if (this->ReferenceImage)
+            {
+            referencePtr = static_cast<ReferenceType*>(this->ReferenceImage->GetScalarPointer(segment.Extent[0], j, k));
+            }
+          int numberOfVoxelsInRow = segment.Extent[1] - segment.Extent[0] + 1;
+          void* labelPtr = segment.Labelmap->GetScalarPointer(segment.Extent[0], j, k);
+          switch (segment.Labelmap->GetScalarType())
+            {
+            vtkTemplateMacro(AccumulateRow<ReferenceType, VTK_TT>(referencePtr, static_cast<VTK_TT*>(labelPtr),
+              numberOfVoxelsInRow, segment.Extent[0], j, k, segment, statistics[*segmentIndexIt],
+              this->HistogramMinimum, this->HistogramBinWidth));
+            }
+          }
+        }
+      }
+  }
+
+  void Reduce()
+  {
+  }
+
+  vtkSMPThreadLocal< std::vector<SegmentStatistics> > Statistics;
+
+protected:
+  vtkOrientedImageData* ReferenceImage;
+  std::vector<SegmentInput>& Segments;
+  int NumberOfHistogramBins;
+  double HistogramMinimum;
+  double HistogramBinWidth;
+};
+
+//----------------------------------------------------------------------------
+template <class ReferenceType>
+void AccumulateStatistics(vtkOrientedImageData* referenceImage, std::vector<SegmentInput>& segments,
+  int numberOfHistogramBins, double histogramMinimum, double histogramBinWidth,
+  std::vector<SegmentStatistics>& statistics)
+{
+  int kRange[2] = { VTK_INT_MAX, VTK_INT_MIN };
+  for (std::vector<SegmentInput>::iterator segmentIt = segments.begin(); segmentIt != segments.end(); ++segmentIt)
+    {
+    if (segmentIt->Extent[0] > segmentIt->Extent[1] || segmentIt->Extent[2] > segmentIt->Extent[3] || segmentIt->Extent[4] > segmentIt->Extent[5])
+      {
+      continue;
+      }
+    kRange[0] = std::min(kRange[0], segmentIt->Extent[4]);
+    kRange[1] = std::max(kRange[1], segmentIt->Extent[5]);
+    }
+
+  statistics.clear();
+  statistics.resize(segments.size());
+  if (referenceImage)
+    {
+    for (std::vector<SegmentStatistics>::iterator statIt = statistics.begin(); statIt != statistics.end(); ++statIt)
+      {
+      statIt->Histogram.assign(numberOfHistogramBins, 0.0);
+      }
+    }
+  if (kRange[0] > kRange[1])
+    {
+    // all segments are empty
+    return;
+    }
+
+  AccumulateStatisticsFunctor<ReferenceType> functor(referenceImage, segments,
+    numberOfHistogramBins, histogramMinimum, histogramBinWidth);
+  vtkSMPTools::For(kRange[0], kRange[1] + 1, functor);
+
+  // Combine results of all threads
+  typedef vtkSMPThreadLocal< std::vector<SegmentStatistics> > ThreadLocalStatisticsType;
+  for (ThreadLocalStatisticsType::iterator threadIt = functor.Statistics.begin();
+    threadIt != functor.Statistics.end(); ++threadIt)
+    {
+    for (size_t segmentIndex = 0; segmentIndex < segments.size(); segmentIndex++)
+      {
+      const SegmentStatistics& threadStats = (*threadIt)[segmentIndex];
+      SegmentStatistics& stats = statistics[segmentIndex];
+      stats.VoxelCount += threadStats.VoxelCount;
+      stats.Sum += threadStats.Sum;
+      stats.SumOfSquares += threadStats.SumOfSquares;
+      stats.Minimum = std::min(stats.Minimum, threadStats.Minimum);
+      stats.Maximum = std::max(stats.Maximum, threadStats.Maximum);
+      for (int i = 0; i < 3; i++)
+        {
+        stats.SumIjk[i] += threadStats.SumIjk[i];
+        }
+      for (size_t bin = 0; bin < threadStats.Histogram.size(); bin++)
+        {
+        stats.Histogram[bin] += threadStats.Histogram[bin];
+        }
+      }
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+class vtkSegmentStatisticsCalculator::vtkInternal
+{
+public:
+  vtkInternal()
+  : HistogramMinimum(0.0)
+  , HistogramBinWidth(1.0)
+  , ExactHistogramBins(false)
+  {
+  }
+  std::vector< vtkSmartPointer<vtkOrientedImageData> > SegmentLabelmaps;
+  std::vector<SegmentStatistics> Statistics;
+  double HistogramMinimum;
+  double HistogramBinWidth;
+  bool ExactHistogramBins;
+};
+
+//----------------------------------------------------------------------------
+vtkSegmentStatisticsCalculator::vtkSegmentStatisticsCalculator()
+{
+  this->Internal = new vtkInternal();
+  this->NumberOfHistogramBins = 1000;
+  this->IntensityStatisticsComputed = false;
+}
+
+//----------------------------------------------------------------------------
+vtkSegmentStatisticsCalculator::~vtkSegmentStatisticsCalculator()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentStatisticsCalculator::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "ReferenceImage: " << this->ReferenceImage.GetPointer() << "\n";
+  os << indent << "NumberOfSegments: " << this->GetNumberOfSegments() << "\n";
+  os << indent << "NumberOfHistogramBins: " << this->NumberOfHistogramBins << "\n";
+  os << indent << "IntensityStatisticsComputed: " << (this->IntensityStatisticsComputed ? "true" : "false") << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentStatisticsCalculator::SetReferenceImage(vtkOrientedImageData* referenceImage)
+{
+  if (this->ReferenceImage == referenceImage)
+    {
+    return;
+    }
+  this->ReferenceImage = referenceImage;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedImageData* vtkSegmentStatisticsCalculator::GetReferenceImage()
+{
+  return this->ReferenceImage;
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentStatisticsCalculator::RemoveAllSegmentLabelmaps()
+{
+  this->Internal->SegmentLabelmaps.clear();
+  this->Internal->Statistics.clear();
+  this->IntensityStatisticsComputed = false;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkSegmentStatisticsCalculator::AddSegmentLabelmap(vtkOrientedImageData* labelmap)
+{
+  if (!labelmap)
+    {
+    vtkErrorMacro("AddSegmentLabelmap: Invalid labelmap");
+    return -1;
+    }
+  this->Internal->SegmentLabelmaps.push_back(labelmap);
+  this->Modified();
+  return static_cast<int>(this->Internal->SegmentLabelmaps.size()) - 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkSegmentStatisticsCalculator::GetNumberOfSegments()
+{
+  return static_cast<int>(this->Internal->SegmentLabelmaps.size());
+}
+
+//----------------------------------------------------------------------------
+bool vtkSegmentStatisticsCalculator::Compute()
+{
+  this->Internal->Statistics.clear();
+  this->IntensityStatisticsComputed = false;
+
+  vtkOrientedImageData* referenceImage = this->ReferenceImage;
+  if (referenceImage && referenceImage->GetPointData()->GetScalars() == NULL)
+    {
+    referenceImage = NULL;
+    }
+  if (referenceImage && referenceImage->GetNumberOfScalarComponents() != 1)
+    {
+    vtkErrorMacro("Compute: Reference image must have a single scalar component");
+    return false;
+    }
+
+  // Determine processed extent and voxel weighting of each segment
+  std::vector<SegmentInput> segments;
+  for (std::vector< vtkSmartPointer<vtkOrientedImageData> >::iterator labelmapIt = this->Internal->SegmentLabelmaps.begin();
+    labelmapIt != this->Internal->SegmentLabelmaps.end(); ++labelmapIt)
+    {
+    vtkOrientedImageData* labelmap = *labelmapIt;
+    SegmentInput segment;
+    segment.Labelmap = labelmap;
+    labelmap->GetExtent(segment.Extent);
+    segment.Fractional = false;
+    segment.WeightOffset = 0.0;
+    segment.WeightScale = 1.0;
+    if (labelmap->GetPointData()->GetScalars() == NULL || labelmap->GetNumberOfScalarComponents() != 1)
+      {
+      // empty segment
+      segment.Extent[0] = segment.Extent[2] = segment.Extent[4] = 0;
+      segment.Extent[1] = segment.Extent[3] = segment.Extent[5] = -1;
+      }
+    if (referenceImage)
+      {
+      if (!vtkOrientedImageDataResample::DoGeometriesMatch(labelmap, referenceImage))
+        {
+        vtkErrorMacro("Compute: Segment labelmap geometry does not match reference image geometry");
+        return false;
+        }
+      int* referenceExtent = referenceImage->GetExtent();
+      for (int i = 0; i < 3; i++)
+        {
+        segment.Extent[i * 2] = std::max(segment.Extent[i * 2], referenceExtent[i * 2]);
+        segment.Extent[i * 2 + 1] = std::min(segment.Extent[i * 2 + 1], referenceExtent[i * 2 + 1]);
+        }
+      }
+    if (segment.Extent[0] > segment.Extent[1] || segment.Extent[2] > segment.Extent[3] || segment.Extent[4] > segment.Extent[5])
+      {
+      // no overlap, make sure no voxels are visited
+      segment.Extent[0] = segment.Extent[2] = segment.Extent[4] = 0;
+      segment.Extent[1] = segment.Extent[3] = segment.Extent[5] = -1;
+      }
+    vtkDataArray* scalarRange = vtkDataArray::SafeDownCast(
+      labelmap->GetFieldData()->GetAbstractArray(vtkSegmentationConverter::GetScalarRangeFieldName()));
+    if (scalarRange && scalarRange->GetNumberOfTuples() * scalarRange->GetNumberOfComponents() >= 2)
+      {
+      double minimumValue = scalarRange->GetComponent(0, 0);
+      double maximumValue = (scalarRange->GetNumberOfComponents() >= 2 ? scalarRange->GetComponent(0, 1) : scalarRange->GetComponent(1, 0));
+      if (maximumValue > minimumValue)
+        {
+        segment.Fractional = true;
+        segment.WeightOffset = minimumValue;
+        segment.WeightScale = 1.0 / (maximumValue - minimumValue);
+        }
+      }
+    segments.push_back(segment);
+    }
+
+  // Set up histogram for percentile computation
+  int numberOfHistogramBins = this->NumberOfHistogramBins;
+  this->Internal->HistogramMinimum = 0.0;
+  this->Internal->HistogramBinWidth = 1.0;
+  this->Internal->ExactHistogramBins = false;
+  if (referenceImage)
+    {
+    double* intensityRange = referenceImage->GetScalarRange();
+    this->Internal->HistogramMinimum = intensityRange[0];
+    double intensityRangeWidth = intensityRange[1] - intensityRange[0];
+    int scalarType = referenceImage->GetScalarType();
+    bool integerType = (scalarType != VTK_FLOAT && scalarType != VTK_DOUBLE);
+    if (integerType && intensityRangeWidth + 1 <= numberOfHistogramBins)
+      {
+      // one bin for each intensity value
+      numberOfHistogramBins = static_cast<int>(intensityRangeWidth) + 1;
+      this->Internal->HistogramBinWidth = 1.0;
+      this->Internal->ExactHistogramBins = true;
+      }
+    else if (intensityRangeWidth > 0)
+      {
+      this->Internal->HistogramBinWidth = intensityRangeWidth / numberOfHistogramBins;
+      }
+    }
+
+  if (referenceImage)
+    {
+    switch (referenceImage->GetScalarType())
+      {
+      vtkTemplateMacro(AccumulateStatistics<VTK_TT>(referenceImage, segments, numberOfHistogramBins,
+        this->Internal->HistogramMinimum, this->Internal->HistogramBinWidth, this->Internal->Statistics));
+      default:
+        vtkErrorMacro("Compute: Unknown reference image scalar type");
+        return false;
+      }
+    this->IntensityStatisticsComputed = true;
+    }
+  else
+    {
+    AccumulateStatistics<char>(NULL, segments, numberOfHistogramBins,
+      this->Internal->HistogramMinimum, this->Internal->HistogramBinWidth, this->Internal->Statistics);
+    }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSegmentStatisticsCalculator::IsValidSegmentIndex(int segmentIndex)
+{
+  if (segmentIndex < 0 || segmentIndex >= static_cast<int>(this->Internal->Statistics.size()))
+    {
+    vtkErrorMacro("Invalid segment index " << segmentIndex << ", statistics are available for "
+      << this->Internal->Statistics.size() << " segments");
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+double vtkSegmentStatisticsCalculator::GetVoxelCount(int segmentIndex)
+{
+  if (!this->IsValidSegmentIndex(segmentIndex))
+    {
+    return 0.0;
+    }
+  return this->Internal->Statistics[segmentIndex].VoxelCount;
+}
+
+//----------------------------------------------------------------------------
+double vtkSegmentStatisticsCalculator::GetVolumeMm3(int segmentIndex)
+{
+  if (!this->IsValidSegmentIndex(segmentIndex))
+    {
+    return 0.0;
+    }
+  double* spacing = this->Internal->SegmentLabelmaps[segmentIndex]->GetSpacing();
+  return this->Internal->Statistics[segmentIndex].VoxelCount * spacing[0] * spacing[1] * spacing[2];
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentStatisticsCalculator::GetCentroid(int segmentIndex, double centroid[3])
+{
+  centroid[0] = centroid[1] = centroid[2] = 0.0;
+  if (!this->IsValidSegmentIndex(segmentIndex))
+    {
+    return;
+    }
+  SegmentStatistics& stats = this->Internal->Statistics[segmentIndex];
+  if (stats.VoxelCount <= 0)
+    {
+    return;
+    }
+  double centroidIjk[4] = { stats.SumIjk[0] / stats.VoxelCount, stats.SumIjk[1] / stats.VoxelCount, stats.SumIjk[2] / stats.VoxelCount, 1.0 };
+  vtkSmartPointer<vtkMatrix4x4> imageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  this->Internal->SegmentLabelmaps[segmentIndex]->GetImageToWorldMatrix(imageToWorldMatrix);
+  double centroidWorld[4] = { 0.0, 0.0, 0.0, 1.0 };
+  imageToWorldMatrix->MultiplyPoint(centroidIjk, centroidWorld);
+  centroid[0] = centroidWorld[0];
+  centroid[1] = centroidWorld[1];
+  centroid[2] = centroidWorld[2];
+}
+
+//----------------------------------------------------------------------------
+double vtkSegmentStatisticsCalculator::GetMinimum(int segmentIndex)
+{
+  if (!this->IsValidSegmentIndex(segmentIndex) || !this->IntensityStatisticsComputed
+    || this->Internal->Statistics[segmentIndex].VoxelCount <= 0)
+    {
+    return 0.0;
+    }
+  return this->Internal->Statistics[segmentIndex].Minimum;
+}
+
+//----------------------------------------------------------------------------
+double vtkSegmentStatisticsCalculator::GetMaximum(int segmentIndex)
+{
+  if (!this->IsValidSegmentIndex(segmentIndex) || !this->IntensityStatisticsComputed
+    || this->Internal->Statistics[segmentIndex].VoxelCount <= 0)
+    {
+    return 0.0;
+    }
+  return this->Internal->Statistics[segmentIndex].Maximum;
+}
+
+//----------------------------------------------------------------------------
+double vtkSegmentStatisticsCalculator::GetMean(int segmentIndex)
+{
+  if (!this->IsValidSegmentIndex(segmentIndex) || !this->IntensityStatisticsComputed
+    || this->Internal->Statistics[segmentIndex].VoxelCount <= 0)
+    {
+    return 0.0;
+    }
+  SegmentStatistics& stats = this->Internal->Statistics[segmentIndex];
+  return stats.Sum / stats.VoxelCount;
+}
+
+//----------------------------------------------------------------------------
+double vtkSegmentStatisticsCalculator::GetStandardDeviation(int segmentIndex)
+{
+  if (!this->IsValidSegmentIndex(segmentIndex) || !this->IntensityStatisticsComputed
+    || this->Internal->Statistics[segmentIndex].VoxelCount <= 0)
+    {
+    return 0.0;
+    }
+  SegmentStatistics& stats = this->Internal->Statistics[segmentIndex];
+  double mean = stats.Sum / stats.VoxelCount;
+  double variance = stats.SumOfSquares / stats.VoxelCount - mean * mean;
+  return (variance > 0 ? sqrt(variance) : 0.0);
+}
+
+//----------------------------------------------------------------------------
+double vtkSegmentStatisticsCalculator::GetSum(int segmentIndex)
+{
+  if (!this->IsValidSegmentIndex(segmentIndex) || !this->IntensityStatisticsComputed)
+    {
+    return 0.0;
+    }
+  return this->Internal->Statistics[segmentIndex].Sum;
+}
+
+//----------------------------------------------------------------------------
+double vtkSegmentStatisticsCalculator::GetSumOfSquares(int segmentIndex)
+{
+  if (!this->IsValidSegmentIndex(segmentIndex) || !this->IntensityStatisticsComputed)
+    {
+    return 0.0;
+    }
+  return this->Internal->Statistics[segmentIndex].SumOfSquares;
+}
+
+//----------------------------------------------------------------------------
+double vtkSegmentStatisticsCalculator::GetPercentile(int segmentIndex, double percentile)
+{
+  if (!this->IsValidSegmentIndex(segmentIndex) || !this->IntensityStatisticsComputed)
+    {
+    return 0.0;
+    }
+  SegmentStatistics& stats = this->Internal->Statistics[segmentIndex];
+  if (stats.VoxelCount <= 0 || stats.Histogram.empty())
+    {
+    return 0.0;
+    }
+  percentile = std::max(0.0, std::min(100.0, percentile));
+  double targetCount = stats.VoxelCount * percentile / 100.0;
+  double cumulativeCount = 0.0;
+  int numberOfBins = static_cast<int>(stats.Histogram.size());
+  bool exactBins = this->Internal->ExactHistogramBins;
+  for (int bin = 0; bin < numberOfBins; bin++)
+    {
+    double binCount = stats.Histogram[bin];
+    if (binCount > 0 && cumulativeCount + binCount >= targetCount)
+      {
+      double binStart = this->Internal->HistogramMinimum + bin * this->Internal->HistogramBinWidth;
+      if (exactBins)
+        {
+        return binStart;
+        }
+      // linear interpolation within the bin
+      double value = binStart + this->Internal->HistogramBinWidth * (targetCount - cumulativeCount) / binCount;
+      return std::max(stats.Minimum, std::min(stats.Maximum, value));
+      }
+    cumulativeCount += binCount;
+    }
+  return stats.Maximum;
+}
@@ -0,0 +1,112 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkSegmentStatisticsCalculator_h
+#define __vtkSegmentStatisticsCalculator_h
+
+#include "vtkSlicerSegmentationsModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+class vtkOrientedImageData;
+
+/// \ingroup Segmentations
+/// \brief Compute statistics of multiple segments in a single pass
+///
+/// Segment labelmaps are processed together, in parallel blocks of slices. Each row of the
+/// reference (intensity) volume is fetched from memory once and all the segments that overlap
+/// the row are accumulated from it while it is in cache.
+/// Computed values: voxel count, volume, centroid, and if reference image is specified then
+/// minimum, maximum, mean, standard deviation, sum, sum of squares, and percentiles of the
+/// reference image intensities inside each segment.
+///
+/// If the labelmap contains "ScalarRange" field data (fractional labelmap) then voxels are weighted
+/// by their normalized labelmap value, otherwise voxels with positive value are included with weight 1.
+///
+/// If reference image is set then geometry (origin, spacing, directions) of all segment labelmaps
+/// must match the reference image geometry (see vtkOrientedImageDataResample::DoGeometriesMatch).
+/// Extents may be different.
+class VTK_SLICER_SEGMENTATIONS_LOGIC_EXPORT vtkSegmentStatisticsCalculator : public vtkObject
+{
+public:
+  static vtkSegmentStatisticsCalculator* New();
+  vtkTypeMacro(vtkSegmentStatisticsCalculator, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Reference image that intensity statistics are computed from. Optional.
+  void SetReferenceImage(vtkOrientedImageData* referenceImage);
+  vtkOrientedImageData* GetReferenceImage();
+
+  /// Remove all segment labelmaps and computed statistics
+  void RemoveAllSegmentLabelmaps();
+  /// Add a segment labelmap for statistics computation.
+  /// \return Index of the segment that can be used for getting computed values
+  int AddSegmentLabelmap(vtkOrientedImageData* labelmap);
+  /// Number of segment labelmaps added
+  int GetNumberOfSegments();
+
+  /// Number of histogram bins used for computing percentiles.
+  /// If reference image has integer type and its range is smaller than
+  /// the number of bins then each intensity value gets its own bin (percentiles are exact).
+  vtkSetClampMacro(NumberOfHistogramBins, int, 1, VTK_INT_MAX);
+  vtkGetMacro(NumberOfHistogramBins, int);
+
+  /// Compute statistics of all the added segments
+  /// \return Success flag
+  bool Compute();
+
+  /// True if intensity statistics are available (reference image was set when Compute() was called)
+  vtkGetMacro(IntensityStatisticsComputed, bool);
+
+  /// Number of voxels in the segment (weighted sum if the labelmap is fractional)
+  double GetVoxelCount(int segmentIndex);
+  /// Volume of the segment in cubic millimeters
+  double GetVolumeMm3(int segmentIndex);
+  /// Centroid of the segment in the world coordinate system of the labelmap
+  void GetCentroid(int segmentIndex, double centroid[3]);
+
+  /// Intensity statistics. Return 0 if not available.
+  double GetMinimum(int segmentIndex);
+  double GetMaximum(int segmentIndex);
+  double GetMean(int segmentIndex);
+  double GetStandardDeviation(int segmentIndex);
+  double GetSum(int segmentIndex);
+  double GetSumOfSquares(int segmentIndex);
+  /// Get intensity value below which the given percentage of segment voxels fall.
+  /// \param percentile Value between 0 and 100. The median is percentile 50.
+  double GetPercentile(int segmentIndex, double percentile);
+
+protected:
+  vtkSegmentStatisticsCalculator();
+  virtual ~vtkSegmentStatisticsCalculator();
+
+  bool IsValidSegmentIndex(int segmentIndex);
+
+  vtkSmartPointer<vtkOrientedImageData> ReferenceImage;
+  int NumberOfHistogramBins;
+  bool IntensityStatisticsComputed;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkSegmentStatisticsCalculator(const vtkSegmentStatisticsCalculator&); // Not implemented
+  void operator=(const vtkSegmentStatisticsCalculator&);               // Not implemented
+};
+
+#endif
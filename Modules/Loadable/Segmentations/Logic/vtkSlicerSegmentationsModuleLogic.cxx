@@ -25,6 +25,8 @@
 #include "vtkMRMLSegmentationDisplayNode.h"
 #include "vtkMRMLSegmentationStorageNode.h"
 #include "vtkMRMLSegmentEditorNode.h"
+#include "vtkSegmentStatisticsCalculator.h"
+#include "vtkBinaryLabelmapMorphology.h"
 
 // SegmentationCore includes
 #include "vtkOrientedImageData.h"
@@ -49,6 +51,7 @@
 #include <vtkImageAccumulate.h>
 #include <vtkImageThreshold.h>
 #include <vtkDataObject.h>
+#include <vtkFieldData.h>
 #include <vtkTransform.h>
 #include <vtksys/SystemTools.hxx>
 #include <vtkGeneralTransform.h>
@@ -56,6 +59,8 @@
 #include <vtkImageMathematics.h>
 #include <vtkImageConstantPad.h>
 #include <vtkLookupTable.h>
+#include <vtkStringArray.h>
+#include <vtkSMPTools.h>
 
 // MRML includes
 #include <vtkMRMLScene.h>
@@ -68,11 +73,113 @@
 #include <vtkMRMLTransformNode.h>
 
 // STD includes
+#include <algorithm>
+#include <map>
 #include <sstream>
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerSegmentationsModuleLogic);
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Get bounding box of each non-zero label value in a single pass
+template <class T>
+void GetLabelExtentsGeneric(vtkImageData* labelmap, std::map<int, std::vector<int> >& labelExtents)
+{
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  labelmap->GetExtent(extent);
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      T* labelmapPtr = static_cast<T*>(labelmap->GetScalarPointer(extent[0], j, k));
+      // Neighbor voxels usually have the same label, only look up the label extent if the label changes
+      int currentLabel = 0;
+      std::vector<int>* currentLabelExtent = NULL;
+      for (int i = extent[0]; i <= extent[1]; i++, labelmapPtr++)
+        {
+        int label = static_cast<int>(*labelmapPtr);
+        if (label == 0)
+          {
+          continue;
+          }
+        if (!currentLabelExtent || label != currentLabel)
+          {
+          currentLabel = label;
+          currentLabelExtent = &labelExtents[label];
+          if (currentLabelExtent->empty())
+            {
+            int newExtent[6] = { i, i, j, j, k, k };
+            currentLabelExtent->assign(newExtent, newExtent + 6);
+            }
+          }
+        std::vector<int>& labelExtent = *currentLabelExtent;
+        labelExtent[0] = std::min(labelExtent[0], i);
+        labelExtent[1] = std::max(labelExtent[1], i);
+        labelExtent[2] = std::min(labelExtent[2], j);
+        labelExtent[3] = std::max(labelExtent[3], j);
+        labelExtent[4] = std::min(labelExtent[4], k);
+        labelExtent[5] = std::max(labelExtent[5], k);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Set 1 in the binary labelmap (unsigned char) where the labelmap has the specified label and 0 elsewhere.
+/// Only the extent of the binary labelmap is processed.
+template <class T>
+void ExtractLabelGeneric(vtkImageData* labelmap, int label, vtkImageData* binaryLabelmap)
+{
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  binaryLabelmap->GetExtent(extent);
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      T* labelmapPtr = static_cast<T*>(labelmap->GetScalarPointer(extent[0], j, k));
+      unsigned char* binaryLabelmapPtr = static_cast<unsigned char*>(binaryLabelmap->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        *(binaryLabelmapPtr++) = (static_cast<int>(*(labelmapPtr++)) == label ? 1 : 0);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Extract binary labelmaps of multiple labels in parallel
+class ExtractLabelsFunctor
+{
+public:
+  ExtractLabelsFunctor(vtkImageData* labelmap, const std::vector<int>& labels, std::vector<vtkSmartPointer<vtkOrientedImageData> >& binaryLabelmaps)
+  : Labelmap(labelmap)
+  , Labels(labels)
+  , BinaryLabelmaps(binaryLabelmaps)
+  {
+  }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType labelIndex = begin; labelIndex < end; labelIndex++)
+      {
+      switch (this->Labelmap->GetScalarType())
+        {
+        vtkTemplateMacro(ExtractLabelGeneric<VTK_TT>(this->Labelmap, this->Labels[labelIndex], this->BinaryLabelmaps[labelIndex]));
+        }
+      }
+  }
+
+protected:
+  vtkImageData* Labelmap;
+  const std::vector<int>& Labels;
+  std::vector<vtkSmartPointer<vtkOrientedImageData> >& BinaryLabelmaps;
+};
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 vtkSlicerSegmentationsModuleLogic::vtkSlicerSegmentationsModuleLogic()
 {
@@ -686,8 +793,14 @@ bool vtkSlicerSegmentationsModuleLogic::ExportSegmentToRepresentationNode(vtkSeg
       }
 
     // Export binary labelmap representation into labelmap volume node
-    vtkOrientedImageData* orientedImageData = vtkOrientedImageData::SafeDownCast(
+    vtkSmartPointer<vtkOrientedImageData> orientedImageData = vtkOrientedImageData::SafeDownCast(
       segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) );
+    if (segmentationNode->GetSegmentation()->IsLayerBinaryLabelmap(segment))
+      {
+      // Only export the voxels of this segment from the shared layer
+      orientedImageData = vtkSmartPointer<vtkOrientedImageData>::New();
+      segmentationNode->GetSegmentation()->GetBinaryLabelmapRepresentation(segmentId, orientedImageData);
+      }
     bool success = vtkSlicerSegmentationsModuleLogic::CreateLabelmapVolumeFromOrientedImageData(orientedImageData, labelmapNode);
     if (!success)
       {
@@ -1075,49 +1188,48 @@ bool vtkSlicerSegmentationsModuleLogic::ImportLabelmapToSegmentationNode(vtkOrie
     return false;
     }
 
-  // Note: Splitting code ported from EditorLib/HelperBox.py:split
-
-  // Split labelmap node into per-label image data
+  // Split labelmap into per-label image data. Bounding box of all labels is computed in one pass,
+  // then each label is extracted within its bounding box, so the cost does not grow with the number
+  // of labels times the full labelmap size (important for labelmaps with many small islands).
+  if (!labelmapImage->GetPointData() || !labelmapImage->GetPointData()->GetScalars())
+    {
+    vtkErrorWithObjectMacro(segmentationNode, "ImportLabelmapToSegmentationNode: Labelmap image is empty!");
+    return false;
+    }
+  std::map<int, std::vector<int> > labelExtents;
+  switch (labelmapImage->GetScalarType())
+    {
+    vtkTemplateMacro(GetLabelExtentsGeneric<VTK_TT>(labelmapImage, labelExtents));
+    default:
+      vtkErrorWithObjectMacro(segmentationNode, "ImportLabelmapToSegmentationNode: Unknown labelmap scalar type");
+      return false;
+    }
 
-  vtkNew<vtkIntArray> labelValues;
-  vtkSlicerSegmentationsModuleLogic::GetAllLabelValues(labelValues.GetPointer(), labelmapImage);
+  vtkSmartPointer<vtkMatrix4x4> labelmapImageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  labelmapImage->GetImageToWorldMatrix(labelmapImageToWorldMatrix);
+  std::vector<int> labels;
+  std::vector<vtkSmartPointer<vtkOrientedImageData> > labelOrientedImageDatas;
+  for (std::map<int, std::vector<int> >::iterator labelIt = labelExtents.begin(); labelIt != labelExtents.end(); ++labelIt)
+    {
+    vtkSmartPointer<vtkOrientedImageData> labelOrientedImageData = vtkSmartPointer<vtkOrientedImageData>::New();
+    labelOrientedImageData->SetExtent(&(labelIt->second[0]));
+    labelOrientedImageData->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    labelOrientedImageData->SetGeometryFromImageToWorldMatrix(labelmapImageToWorldMatrix);
+    labels.push_back(labelIt->first);
+    labelOrientedImageDatas.push_back(labelOrientedImageData);
+    }
+  ExtractLabelsFunctor extractLabelsFunctor(labelmapImage, labels, labelOrientedImageDatas);
+  vtkSMPTools::For(0, static_cast<vtkIdType>(labels.size()), extractLabelsFunctor);
 
   int segmentationNodeWasModified = segmentationNode->StartModify();
 
   // Set master representation to binary labelmap
   segmentationNode->GetSegmentation()->SetMasterRepresentationName(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName());
 
-  vtkSmartPointer<vtkImageThreshold> threshold = vtkSmartPointer<vtkImageThreshold>::New();
-  threshold->SetInputData(labelmapImage);
-  threshold->SetInValue(1);
-  threshold->SetOutValue(0);
-  threshold->ReplaceInOn();
-  threshold->ReplaceOutOn();
-  threshold->SetOutputScalarType(labelmapImage->GetScalarType());
-
-  for (int labelIndex = 0; labelIndex < labelValues->GetNumberOfValues(); ++labelIndex)
-  {
-    int label = labelValues->GetValue(labelIndex);
-
-    threshold->ThresholdBetween(label, label);
-    threshold->Update();
-
-    // Create oriented image data for label
-    vtkSmartPointer<vtkOrientedImageData> labelOrientedImageData = vtkSmartPointer<vtkOrientedImageData>::New();
-    labelOrientedImageData->ShallowCopy(threshold->GetOutput());
-
-    // Clip to effective extent
-    int labelOrientedImageDataEffectiveExtent[6] = { 0, -1, 0, -1, 0, -1 };
-    vtkOrientedImageDataResample::CalculateEffectiveExtent(labelOrientedImageData, labelOrientedImageDataEffectiveExtent);
-    vtkSmartPointer<vtkImageConstantPad> padder = vtkSmartPointer<vtkImageConstantPad>::New();
-    padder->SetInputData(labelOrientedImageData);
-    padder->SetOutputWholeExtent(labelOrientedImageDataEffectiveExtent);
-    padder->Update();
-
-    labelOrientedImageData->ShallowCopy(padder->GetOutput());
-    vtkSmartPointer<vtkMatrix4x4> labelmapImageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-    labelmapImage->GetImageToWorldMatrix(labelmapImageToWorldMatrix);
-    labelOrientedImageData->SetGeometryFromImageToWorldMatrix(labelmapImageToWorldMatrix);
+  for (size_t labelIndex = 0; labelIndex < labels.size(); ++labelIndex)
+    {
+    int label = labels[labelIndex];
+    vtkOrientedImageData* labelOrientedImageData = labelOrientedImageDatas[labelIndex];
 
     vtkSmartPointer<vtkSegment> segment = vtkSmartPointer<vtkSegment>::New();
 
@@ -1261,7 +1373,18 @@ bool vtkSlicerSegmentationsModuleLogic::GetSegmentRepresentation(vtkMRMLSegmenta
     return false;
     }
 
-  if (segmentationNode->GetSegmentation()->ContainsRepresentation(representationName))
+  if (segmentationNode->GetSegmentation()->ContainsRepresentation(representationName)
+    && !representationName.compare(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName())
+    && vtkOrientedImageData::SafeDownCast(segmentRepresentation))
+    {
+    // Binary labelmap may be a layer shared with other segments, so only get the voxels of this segment
+    if (!segmentationNode->GetSegmentation()->GetBinaryLabelmapRepresentation(segmentID, vtkOrientedImageData::SafeDownCast(segmentRepresentation)))
+      {
+      vtkErrorWithObjectMacro(segmentationNode, "vtkSlicerSegmentationsModuleLogic::GetSegmentRepresentation: Unable to get binary labelmap representation from segment with ID " << segmentID << " in segmentation " << segmentationNode->GetName());
+      return false;
+      }
+    }
+  else if (segmentationNode->GetSegmentation()->ContainsRepresentation(representationName))
     {
     // Get and copy representation into output data object
     vtkDataObject* representationObject = segment->GetRepresentation(representationName);
@@ -1344,19 +1467,28 @@ bool vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment(vtkOrientedIm
     }
 
   // Get binary labelmap representation of selected segment
-  vtkSegment* selectedSegment = segmentationNode->GetSegmentation()->GetSegment(segmentID);
+  vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
+  vtkSegment* selectedSegment = segmentation->GetSegment(segmentID);
   if (!selectedSegment)
     {
     vtkGenericWarningMacro("vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment: Invalid selected segment");
     return false;
     }
-  vtkOrientedImageData* segmentLabelmap = vtkOrientedImageData::SafeDownCast(
+  vtkSmartPointer<vtkOrientedImageData> segmentLabelmap = vtkOrientedImageData::SafeDownCast(
     selectedSegment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) );
-  if (!segmentLabelmap)
+  if (!segmentLabelmap.GetPointer())
     {
     vtkErrorWithObjectMacro(segmentationNode, "vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment: Failed to get binary labelmap representation in segmentation " << segmentationNode->GetName());
     return false;
     }
+  // If the labelmap is a layer shared with other segments, then work on the voxels of this segment only
+  // and write the result back into the layer at the end
+  bool layerLabelmap = segmentation->IsLayerBinaryLabelmap(selectedSegment);
+  if (layerLabelmap)
+    {
+    segmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    segmentation->GetBinaryLabelmapRepresentation(segmentID, segmentLabelmap);
+    }
 
   // 1. Append input labelmap to the segment labelmap if requested
   vtkSmartPointer<vtkOrientedImageData> newSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
@@ -1423,22 +1555,34 @@ bool vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment(vtkOrientedIm
   //    removal of all other representations in all segments does not get activated. Instead, explicitly create
   //    representations for the edited segment that the other segments have.
   bool wasMasterRepresentationModifiedEnabled = segmentationNode->GetSegmentation()->SetMasterRepresentationModifiedEnabled(false);
-  segmentLabelmap->ShallowCopy(newSegmentLabelmap);
-
-  // 3. Shrink the image data extent to only contain the effective data (extent of non-zero voxels)
-  int effectiveExtent[6] = {0,-1,0,-1,0,-1};
-  vtkOrientedImageDataResample::CalculateEffectiveExtent(segmentLabelmap, effectiveExtent); // TODO: use the update extent? maybe crop when changing segment?
-  if (effectiveExtent[0] > effectiveExtent[1] || effectiveExtent[2] > effectiveExtent[3] || effectiveExtent[4] > effectiveExtent[5])
+  if (layerLabelmap)
     {
-    vtkErrorWithObjectMacro(segmentationNode, "vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment: Effective extent of the labelmap to set is invalid!");
+    // Voxels of the segment are replaced in the layer. If the new voxels overlap other segments of the layer
+    // then the segment is moved into a separate labelmap.
+    if (!segmentation->SetBinaryLabelmapRepresentation(segmentID, newSegmentLabelmap))
+      {
+      vtkErrorWithObjectMacro(segmentationNode, "vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment: Failed to set labelmap in shared layer");
+      }
     }
   else
     {
-    vtkSmartPointer<vtkImageConstantPad> padder = vtkSmartPointer<vtkImageConstantPad>::New();
-    padder->SetInputData(segmentLabelmap);
-    padder->SetOutputWholeExtent(effectiveExtent);
-    padder->Update();
-    segmentLabelmap->DeepCopy(padder->GetOutput());
+    segmentLabelmap->ShallowCopy(newSegmentLabelmap);
+
+    // 3. Shrink the image data extent to only contain the effective data (extent of non-zero voxels)
+    int effectiveExtent[6] = {0,-1,0,-1,0,-1};
+    vtkOrientedImageDataResample::CalculateEffectiveExtent(segmentLabelmap, effectiveExtent); // TODO: use the update extent? maybe crop when changing segment?
+    if (effectiveExtent[0] > effectiveExtent[1] || effectiveExtent[2] > effectiveExtent[3] || effectiveExtent[4] > effectiveExtent[5])
+      {
+      vtkErrorWithObjectMacro(segmentationNode, "vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment: Effective extent of the labelmap to set is invalid!");
+      }
+    else
+      {
+      vtkSmartPointer<vtkImageConstantPad> padder = vtkSmartPointer<vtkImageConstantPad>::New();
+      padder->SetInputData(segmentLabelmap);
+      padder->SetOutputWholeExtent(effectiveExtent);
+      padder->Update();
+      segmentLabelmap->DeepCopy(padder->GetOutput());
+      }
     }
   // 4. Re-convert all other representations
   std::vector<std::string> representationNames;
@@ -1463,3 +1607,161 @@ bool vtkSlicerSegmentationsModuleLogic::SetBinaryLabelmapToSegment(vtkOrientedIm
 
   return true;
 }
+
+//-----------------------------------------------------------------------------
+bool vtkSlicerSegmentationsModuleLogic::NotifyBinaryLabelmapsModified(vtkMRMLSegmentationNode* segmentationNode, std::vector<std::string>& segmentIDs)
+{
+  if (!segmentationNode || !segmentationNode->GetSegmentation())
+    {
+    vtkGenericWarningMacro("vtkSlicerSegmentationsModuleLogic::NotifyBinaryLabelmapsModified: Invalid inputs");
+    return false;
+    }
+  vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
+
+  // Disable master representation modified event so that other representations of all segments are not removed,
+  // only the representations of the modified segments are re-converted.
+  bool wasMasterRepresentationModifiedEnabled = segmentation->SetMasterRepresentationModifiedEnabled(false);
+  bool success = true;
+  for (std::vector<std::string>::iterator segmentIDIt = segmentIDs.begin(); segmentIDIt != segmentIDs.end(); ++segmentIDIt)
+    {
+    vtkSegment* segment = segmentation->GetSegment(*segmentIDIt);
+    vtkDataObject* segmentLabelmap = (segment ? segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) : NULL);
+    if (!segmentLabelmap)
+      {
+      vtkErrorWithObjectMacro(segmentationNode, "vtkSlicerSegmentationsModuleLogic::NotifyBinaryLabelmapsModified: Failed to get binary labelmap representation of segment " << *segmentIDIt);
+      success = false;
+      continue;
+      }
+    segmentLabelmap->Modified();
+
+    std::vector<std::string> representationNames;
+    segment->GetContainedRepresentationNames(representationNames);
+    for (std::vector<std::string>::iterator reprIt = representationNames.begin(); reprIt != representationNames.end(); ++reprIt)
+      {
+      if (reprIt->compare(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()))
+        {
+        segmentation->ConvertSingleSegment(*segmentIDIt, *reprIt);
+        }
+      }
+    }
+  segmentation->SetMasterRepresentationModifiedEnabled(wasMasterRepresentationModifiedEnabled);
+
+  for (std::vector<std::string>::iterator segmentIDIt = segmentIDs.begin(); segmentIDIt != segmentIDs.end(); ++segmentIDIt)
+    {
+    const char* segmentIdChar = segmentIDIt->c_str();
+    segmentation->InvokeEvent(vtkSegmentation::MasterRepresentationModified, (void*)segmentIdChar);
+    segmentation->InvokeEvent(vtkSegmentation::RepresentationModified, (void*)segmentIdChar);
+    }
+  return success;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkSlicerSegmentationsModuleLogic::ApplyMarginToBinaryLabelmap(vtkOrientedImageData* labelmap, vtkOrientedImageData* outputLabelmap, double marginMm)
+{
+  if (!labelmap || !outputLabelmap)
+    {
+    vtkGenericWarningMacro("vtkSlicerSegmentationsModuleLogic::ApplyMarginToBinaryLabelmap: Invalid inputs");
+    return false;
+    }
+  return vtkBinaryLabelmapMorphology::ApplyMargin(labelmap, outputLabelmap, marginMm);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkSlicerSegmentationsModuleLogic::ComputeSegmentStatistics(vtkMRMLSegmentationNode* segmentationNode, vtkStringArray* segmentIDs,
+  vtkMRMLScalarVolumeNode* referenceVolumeNode, vtkSegmentStatisticsCalculator* calculator)
+{
+  if (!segmentationNode || !segmentationNode->GetSegmentation() || !calculator)
+    {
+    vtkGenericWarningMacro("vtkSlicerSegmentationsModuleLogic::ComputeSegmentStatistics: Invalid inputs");
+    return false;
+    }
+  vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
+
+  std::string representationName = vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName();
+  if (!segmentation->ContainsRepresentation(representationName))
+    {
+    representationName = vtkSegmentationConverter::GetSegmentationFractionalLabelmapRepresentationName();
+    if (!segmentation->ContainsRepresentation(representationName))
+      {
+      vtkErrorWithObjectMacro(segmentationNode, "vtkSlicerSegmentationsModuleLogic::ComputeSegmentStatistics: Segmentation "
+        << segmentationNode->GetName() << " does not contain labelmap representation");
+      return false;
+      }
+    }
+
+  std::vector<std::string> segmentIDList;
+  if (segmentIDs)
+    {
+    for (vtkIdType index = 0; index < segmentIDs->GetNumberOfValues(); index++)
+      {
+      segmentIDList.push_back(segmentIDs->GetValue(index));
+      }
+    }
+  else
+    {
+    segmentation->GetSegmentIDs(segmentIDList);
+    }
+
+  // Reference geometry and transform from segmentation to reference volume.
+  // Image data of the reference volume is shared, not copied.
+  vtkSmartPointer<vtkOrientedImageData> referenceImage;
+  vtkSmartPointer<vtkGeneralTransform> segmentationToReferenceTransform;
+  bool segmentationToReferenceIsIdentity = true;
+  if (referenceVolumeNode && referenceVolumeNode->GetImageData())
+    {
+    referenceImage = vtkSmartPointer<vtkOrientedImageData>::New();
+    referenceImage->vtkImageData::ShallowCopy(referenceVolumeNode->GetImageData());
+    vtkSmartPointer<vtkMatrix4x4> ijkToRasMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    referenceVolumeNode->GetIJKToRASMatrix(ijkToRasMatrix);
+    referenceImage->SetGeometryFromImageToWorldMatrix(ijkToRasMatrix);
+    segmentationToReferenceTransform = vtkSmartPointer<vtkGeneralTransform>::New();
+    vtkMRMLTransformNode::GetTransformBetweenNodes(segmentationNode->GetParentTransformNode(),
+      referenceVolumeNode->GetParentTransformNode(), segmentationToReferenceTransform);
+    vtkNew<vtkTransform> segmentationToReferenceLinearTransform;
+    vtkNew<vtkMatrix4x4> identityMatrix;
+    segmentationToReferenceIsIdentity =
+      vtkOrientedImageDataResample::IsTransformLinear(segmentationToReferenceTransform, segmentationToReferenceLinearTransform.GetPointer())
+      && vtkOrientedImageDataResample::IsEqual(segmentationToReferenceLinearTransform->GetMatrix(), identityMatrix.GetPointer());
+    }
+
+  calculator->RemoveAllSegmentLabelmaps();
+  calculator->SetReferenceImage(referenceImage);
+  bool linearInterpolation = (representationName == vtkSegmentationConverter::GetSegmentationFractionalLabelmapRepresentationName());
+  for (std::vector<std::string>::iterator segmentIdIt = segmentIDList.begin(); segmentIdIt != segmentIDList.end(); ++segmentIdIt)
+    {
+    vtkSegment* segment = segmentation->GetSegment(*segmentIdIt);
+    vtkSmartPointer<vtkOrientedImageData> segmentLabelmap = (segment ? vtkOrientedImageData::SafeDownCast(segment->GetRepresentation(representationName)) : NULL);
+    if (segmentLabelmap.GetPointer() && representationName == vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()
+      && segmentation->IsLayerBinaryLabelmap(segment))
+      {
+      // Shared labelmap layer, only use the voxels of this segment
+      segmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      segmentation->GetBinaryLabelmapRepresentation(*segmentIdIt, segmentLabelmap);
+      }
+    if (!segmentLabelmap.GetPointer())
+      {
+      vtkErrorWithObjectMacro(segmentationNode, "vtkSlicerSegmentationsModuleLogic::ComputeSegmentStatistics: Failed to get "
+        << representationName << " representation of segment " << *segmentIdIt);
+      return false;
+      }
+    if (!referenceImage
+      || (segmentationToReferenceIsIdentity && vtkOrientedImageDataResample::DoGeometriesMatch(segmentLabelmap, referenceImage)))
+      {
+      // No resampling is needed
+      calculator->AddSegmentLabelmap(segmentLabelmap);
+      continue;
+      }
+    vtkSmartPointer<vtkOrientedImageData> segmentLabelmapResampled = vtkSmartPointer<vtkOrientedImageData>::New();
+    if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(segmentLabelmap, referenceImage,
+      segmentLabelmapResampled, linearInterpolation, false /* no padding */, segmentationToReferenceTransform))
+      {
+      vtkErrorWithObjectMacro(segmentationNode, "vtkSlicerSegmentationsModuleLogic::ComputeSegmentStatistics: Failed to resample segment "
+        << *segmentIdIt << " to reference volume geometry");
+      return false;
+      }
+    segmentLabelmapResampled->GetFieldData()->ShallowCopy(segmentLabelmap->GetFieldData());
+    calculator->AddSegmentLabelmap(segmentLabelmapResampled);
+    }
+
+  return calculator->Compute();
+}
@@ -38,6 +38,8 @@ class vtkOrientedImageData;
 class vtkPolyData;
 class vtkDataObject;
 class vtkGeneralTransform;
+class vtkSegmentStatisticsCalculator;
+class vtkStringArray;
 
 class vtkMRMLScalarVolumeNode;
 class vtkMRMLSegmentationStorageNode;
@@ -147,6 +149,7 @@ public:
   /// The colors of the new segments are randomly generated.
   /// LabelmapImage is defined in the segmentation node's coordinate system
   /// (parent transform of the segmentation node is not used during import).
+  /// Each segment is stored as an unsigned char labelmap, cropped to the bounding box of the label.
   /// \param baseSegmentName Prefix for the names of the new segments. Empty by default, in which case the prefix will be "Label"
   static bool ImportLabelmapToSegmentationNode(vtkOrientedImageData* labelmapImage, vtkMRMLSegmentationNode* segmentationNode, std::string baseSegmentName="");
 
@@ -219,6 +222,32 @@ public:
     };
   static bool SetBinaryLabelmapToSegment(vtkOrientedImageData* labelmap, vtkMRMLSegmentationNode* segmentationNode, std::string segmentID, int mergeMode=MODE_REPLACE, const int extent[6]=0);
 
+  /// Update segments after their binary labelmap representation was modified in place (for example voxels of
+  /// overwritten segments were cleared directly). Master representation changed event is disabled while the other
+  /// representations of the given segments are re-converted, then display update is triggered for each segment.
+  /// The labelmaps are marked as modified.
+  static bool NotifyBinaryLabelmapsModified(vtkMRMLSegmentationNode* segmentationNode, std::vector<std::string>& segmentIDs);
+
+  /// Grow (positive marginMm) or shrink (negative marginMm) a binary labelmap by an isotropic margin in millimeters.
+  /// The margin is computed by thresholding the exact Euclidean distance transform, see \sa vtkBinaryLabelmapMorphology::ApplyMargin.
+  /// \param labelmap Input binary labelmap, voxels with positive value are foreground
+  /// \param outputLabelmap Output labelmap with the same geometry and extent as the input. May be the same as the input.
+  /// \return Success flag
+  static bool ApplyMarginToBinaryLabelmap(vtkOrientedImageData* labelmap, vtkOrientedImageData* outputLabelmap, double marginMm);
+
+  /// Compute statistics of multiple segments in a single pass over the reference volume.
+  /// Binary labelmap representation of the segments is used, or fractional labelmap if binary labelmap is not available.
+  /// \param segmentationNode Segmentation node containing the segments
+  /// \param segmentIDs IDs of the segments to compute statistics for. Segment index i in the calculator
+  ///   corresponds to the i-th segment ID. If NULL then all segments are used, in the order of the segmentation.
+  /// \param referenceVolumeNode If specified, then segments are resampled to the geometry of this volume
+  ///   (considering parent transforms) and intensity statistics are computed from it. Otherwise only labelmap
+  ///   statistics (voxel count, volume, centroid) are computed in the geometry of each segment labelmap.
+  /// \param calculator Statistics calculator that will contain the computed values
+  /// \return Success flag
+  static bool ComputeSegmentStatistics(vtkMRMLSegmentationNode* segmentationNode, vtkStringArray* segmentIDs,
+    vtkMRMLScalarVolumeNode* referenceVolumeNode, vtkSegmentStatisticsCalculator* calculator);
+
 protected:
   virtual void SetMRMLSceneInternal(vtkMRMLScene * newScene);
 
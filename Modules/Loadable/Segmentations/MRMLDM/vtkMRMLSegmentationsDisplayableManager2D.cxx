@@ -915,14 +915,29 @@ void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::UpdateDisplayNodePip
       // If ThresholdValue is not specified, then do not perform thresholding
       vtkDoubleArray* thresholdValue = vtkDoubleArray::SafeDownCast(
         imageData->GetFieldData()->GetAbstractArray(vtkSegmentationConverter::GetThresholdValueFieldName()));
-      if (thresholdValue && thresholdValue->GetNumberOfValues() == 1)
+      // If the binary labelmap is a layer shared with other segments, then only voxels of the label value of the segment are shown
+      vtkSegment* segment = segmentation->GetSegment(pipelineIt->first);
+      bool layerLabelmap = (shownRepresenatationName == vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()
+        && segmentation->IsLayerBinaryLabelmap(segment));
+      if (layerLabelmap)
         {
-        pipeline->ImageThreshold->ThresholdByLower(thresholdValue->GetValue(0));
+        pipeline->ImageThreshold->ThresholdBetween(segment->GetLabelValue(), segment->GetLabelValue());
+        pipeline->ImageThreshold->SetInValue(1);
+        pipeline->ImageThreshold->SetOutValue(0);
+        }
+      else
+        {
+        pipeline->ImageThreshold->SetInValue(0);
+        pipeline->ImageThreshold->SetOutValue(1);
+        if (thresholdValue && thresholdValue->GetNumberOfValues() == 1)
+          {
+          pipeline->ImageThreshold->ThresholdByLower(thresholdValue->GetValue(0));
+          }
         }
 
       // Smooth the border of fractional labelmaps
       pipeline->ImageFillActor->GetMapper()->GetInputAlgorithm()->SetInputConnection(pipeline->Reslice->GetOutputPort());
-      if (this->SmoothFractionalLabelMapBorder && thresholdValue && thresholdValue->GetNumberOfValues() == 1)
+      if (layerLabelmap || (this->SmoothFractionalLabelMapBorder && thresholdValue && thresholdValue->GetNumberOfValues() == 1))
         {
           pipeline->ImageFillActor->GetMapper()->GetInputAlgorithm()->SetInputConnection(pipeline->ImageThreshold->GetOutputPort());
         }
@@ -933,7 +948,7 @@ void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::UpdateDisplayNodePip
         pipeline->LabelOutline->SetInputConnection(pipeline->Reslice->GetOutputPort());
 
         // Set the outline threshold from the ThresholdValue field if it exists
-        if (thresholdValue && thresholdValue->GetNumberOfValues() == 1)
+        if (layerLabelmap || (thresholdValue && thresholdValue->GetNumberOfValues() == 1))
           {
           pipeline->LabelOutline->SetInputConnection(pipeline->ImageThreshold->GetOutputPort());
           }
@@ -1382,6 +1397,13 @@ std::string vtkMRMLSegmentationsDisplayableManager2D::GetDataProbeInfoStringForP
           }
         double voxelValue = imageData->GetScalarComponentAsDouble(
           ijk[0], ijk[1], ijk[2], 0);
+        vtkSegment* segment = segmentation->GetSegment(pipelineIt->first);
+        if (shownRepresenatationName == vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()
+          && segmentation->IsLayerBinaryLabelmap(segment))
+          {
+          // Shared labelmap layer, the point is in the segment if the voxel has the label value of the segment
+          voxelValue = (voxelValue == segment->GetLabelValue() ? 1.0 : 0.0);
+          }
 
         vtkDoubleArray* scalarRange = vtkDoubleArray::SafeDownCast(
           imageData->GetFieldData()->GetAbstractArray(vtkSegmentationConverter::GetScalarRangeFieldName()));
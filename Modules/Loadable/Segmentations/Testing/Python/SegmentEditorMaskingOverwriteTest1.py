@@ -0,0 +1,158 @@
+import unittest
+import vtk, qt, ctk, slicer
+import logging
+
+import vtkSegmentationCorePython as vtkSegmentationCore
+
+class SegmentEditorMaskingOverwriteTest1(unittest.TestCase):
+  def setUp(self):
+    """ Do whatever is needed to reset the state - typically a scene clear will be enough.
+    """
+    slicer.mrmlScene.Clear(0)
+
+  def runTest(self):
+    """Run as few or as many tests as needed here.
+    """
+    self.setUp()
+    self.test_SegmentEditorMaskingOverwriteTest1()
+
+  #------------------------------------------------------------------------------
+  def test_SegmentEditorMaskingOverwriteTest1(self):
+    # Check for modules
+    self.assertIsNotNone( slicer.modules.segmentations )
+
+    self.TestSection_1_OverwriteEverywhere()
+    self.TestSection_2_PaintOutsideSegments()
+    self.TestSection_3_PaintInsideSingleSegment()
+    self.TestSection_4_ModifierLargerThanMask()
+
+    logging.info('Test finished')
+
+  #------------------------------------------------------------------------------
+  def setupEditor(self, maskMode, overwriteMode):
+    """Create a 12x12x12 master volume and a segmentation with segments A (selected, empty),
+    B (3x3x3 box) and C (2x2x2 box). Returns the Paint effect.
+    """
+    slicer.mrmlScene.Clear(0)
+    self.binaryLabelmapReprName = vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName()
+    self.referenceExtent = [0, 11, 0, 11, 0, 11]
+
+    masterImage = vtk.vtkImageData()
+    masterImage.SetExtent(self.referenceExtent)
+    masterImage.AllocateScalars(vtk.VTK_SHORT, 1)
+    masterImage.GetPointData().GetScalars().FillComponent(0, 0)
+    self.masterVolumeNode = slicer.vtkMRMLScalarVolumeNode()
+    self.masterVolumeNode.SetAndObserveImageData(masterImage)
+    slicer.mrmlScene.AddNode(self.masterVolumeNode)
+    self.masterVolumeNode.CreateDefaultDisplayNodes()
+
+    self.segmentationNode = slicer.vtkMRMLSegmentationNode()
+    slicer.mrmlScene.AddNode(self.segmentationNode)
+    self.segmentationNode.CreateDefaultDisplayNodes()
+    self.segmentationNode.SetReferenceImageGeometryParameterFromVolumeNode(self.masterVolumeNode)
+    segmentation = self.segmentationNode.GetSegmentation()
+    segmentation.SetMasterRepresentationName(self.binaryLabelmapReprName)
+    for segmentId in ['A', 'B', 'C']:
+      segmentation.AddEmptySegment(segmentId, segmentId)
+    self.setSegmentBox('B', [3, 5, 3, 5, 3, 5])
+    self.setSegmentBox('C', [8, 9, 8, 9, 8, 9])
+
+    self.segmentEditorNode = slicer.vtkMRMLSegmentEditorNode()
+    slicer.mrmlScene.AddNode(self.segmentEditorNode)
+    self.segmentEditorNode.SetMaskMode(maskMode)
+    self.segmentEditorNode.SetMaskSegmentID('B')
+    self.segmentEditorNode.SetOverwriteMode(overwriteMode)
+
+    self.segmentEditorWidget = slicer.qMRMLSegmentEditorWidget()
+    self.segmentEditorWidget.setMRMLScene(slicer.mrmlScene)
+    self.segmentEditorWidget.setMRMLSegmentEditorNode(self.segmentEditorNode)
+    self.segmentEditorWidget.setSegmentationNode(self.segmentationNode)
+    self.segmentEditorWidget.setMasterVolumeNode(self.masterVolumeNode)
+    self.segmentEditorWidget.setCurrentSegmentID('A')
+    self.segmentEditorWidget.setActiveEffectByName('Paint')
+    effect = self.segmentEditorWidget.activeEffect()
+    self.assertIsNotNone(effect)
+    return effect
+
+  #------------------------------------------------------------------------------
+  def createLabelmap(self, extent):
+    """Labelmap in the master volume geometry, filled with 1 within the extent"""
+    labelmap = vtkSegmentationCore.vtkOrientedImageData()
+    ijkToRas = vtk.vtkMatrix4x4()
+    self.masterVolumeNode.GetIJKToRASMatrix(ijkToRas)
+    labelmap.SetGeometryFromImageToWorldMatrix(ijkToRas)
+    labelmap.SetExtent(extent)
+    labelmap.AllocateScalars(vtk.VTK_UNSIGNED_CHAR, 1)
+    labelmap.GetPointData().GetScalars().FillComponent(0, 1)
+    return labelmap
+
+  #------------------------------------------------------------------------------
+  def setSegmentBox(self, segmentId, extent):
+    labelmap = self.createLabelmap(extent)
+    self.assertTrue(slicer.vtkSlicerSegmentationsModuleLogic.SetBinaryLabelmapToSegment(labelmap,
+      self.segmentationNode, segmentId, slicer.vtkSlicerSegmentationsModuleLogic.MODE_REPLACE))
+
+  #------------------------------------------------------------------------------
+  def getVoxelCount(self, segmentId):
+    """Number of voxels of the segment within the reference geometry"""
+    segment = self.segmentationNode.GetSegmentation().GetSegment(segmentId)
+    labelmap = segment.GetRepresentation(self.binaryLabelmapReprName)
+    extent = labelmap.GetExtent()
+    count = 0
+    for k in range(max(extent[4], self.referenceExtent[4]), min(extent[5], self.referenceExtent[5]) + 1):
+      for j in range(max(extent[2], self.referenceExtent[2]), min(extent[3], self.referenceExtent[3]) + 1):
+        for i in range(max(extent[0], self.referenceExtent[0]), min(extent[1], self.referenceExtent[1]) + 1):
+          if labelmap.GetScalarComponentAsDouble(i, j, k, 0) != 0:
+            count += 1
+    return count
+
+  #------------------------------------------------------------------------------
+  def checkVoxelCounts(self, expectedA, expectedB, expectedC):
+    self.assertEqual(self.getVoxelCount('A'), expectedA)
+    self.assertEqual(self.getVoxelCount('B'), expectedB)
+    self.assertEqual(self.getVoxelCount('C'), expectedC)
+
+  #------------------------------------------------------------------------------
+  def TestSection_1_OverwriteEverywhere(self):
+    # No mask, the painted region is removed from B that is fully covered, C is outside of it
+    logging.info('Test section 1: Overwrite everywhere')
+    effect = self.setupEditor(slicer.vtkMRMLSegmentEditorNode.PaintAllowedEverywhere,
+      slicer.vtkMRMLSegmentEditorNode.OverwriteAllSegments)
+    effect.modifySelectedSegmentByLabelmap(self.createLabelmap([0, 7, 0, 7, 0, 7]),
+      slicer.qSlicerSegmentEditorAbstractEffect.ModificationModeSet)
+    self.checkVoxelCounts(8*8*8, 0, 8)
+
+  #------------------------------------------------------------------------------
+  def TestSection_2_PaintOutsideSegments(self):
+    # Voxels of B and C are masked out, so nothing is overwritten
+    logging.info('Test section 2: Paint outside segments')
+    effect = self.setupEditor(slicer.vtkMRMLSegmentEditorNode.PaintAllowedOutsideAllSegments,
+      slicer.vtkMRMLSegmentEditorNode.OverwriteAllSegments)
+    effect.modifySelectedSegmentByLabelmap(self.createLabelmap(self.referenceExtent),
+      slicer.qSlicerSegmentEditorAbstractEffect.ModificationModeSet)
+    self.checkVoxelCounts(12*12*12 - 27 - 8, 27, 8)
+
+  #------------------------------------------------------------------------------
+  def TestSection_3_PaintInsideSingleSegment(self):
+    # Only voxels of B are editable, B is not overwritten
+    logging.info('Test section 3: Paint inside single segment')
+    effect = self.setupEditor(slicer.vtkMRMLSegmentEditorNode.PaintAllowedInsideSingleSegment,
+      slicer.vtkMRMLSegmentEditorNode.OverwriteNone)
+    effect.modifySelectedSegmentByLabelmap(self.createLabelmap(self.referenceExtent),
+      slicer.qSlicerSegmentEditorAbstractEffect.ModificationModeSet)
+    self.checkVoxelCounts(27, 27, 8)
+
+  #------------------------------------------------------------------------------
+  def TestSection_4_ModifierLargerThanMask(self):
+    # The mask labelmap is computed in the extent of the default modifier labelmap.
+    # Voxels of the applied labelmap that are outside of the mask extent are editable,
+    # therefore C (outside of the mask extent) is overwritten and B (inside) is not.
+    logging.info('Test section 4: Modifier labelmap larger than mask labelmap')
+    effect = self.setupEditor(slicer.vtkMRMLSegmentEditorNode.PaintAllowedOutsideAllSegments,
+      slicer.vtkMRMLSegmentEditorNode.OverwriteAllSegments)
+    defaultModifierLabelmap = effect.modifierLabelmap()
+    defaultModifierLabelmap.SetExtent(0, 5, 0, 11, 0, 11)
+    defaultModifierLabelmap.AllocateScalars(vtk.VTK_UNSIGNED_CHAR, 1)
+    effect.modifySelectedSegmentByLabelmap(self.createLabelmap(self.referenceExtent),
+      slicer.qSlicerSegmentEditorAbstractEffect.ModificationModeSet)
+    self.checkVoxelCounts(12*12*12 - 27, 27, 0)
@@ -534,13 +534,19 @@ bool qMRMLSegmentEditorWidgetPrivate::updateSelectedSegmentLabelmap()
     qWarning() << Q_FUNC_INFO << " failed: Segment " << selectedSegmentID << " not found in segmentation";
     return false;
     }
-  vtkOrientedImageData* segmentLabelmap = vtkOrientedImageData::SafeDownCast(
+  vtkSmartPointer<vtkOrientedImageData> segmentLabelmap = vtkOrientedImageData::SafeDownCast(
     selectedSegment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()));
   if (!segmentLabelmap)
     {
     qCritical() << Q_FUNC_INFO << ": Failed to get binary labelmap representation in segmentation " << segmentationNode->GetName();
     return false;
     }
+  if (segmentationNode->GetSegmentation()->IsLayerBinaryLabelmap(selectedSegment))
+    {
+    // Labelmap is shared with other segments, only get the voxels of the selected segment
+    segmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    segmentationNode->GetSegmentation()->GetBinaryLabelmapRepresentation(selectedSegmentID, segmentLabelmap);
+    }
   int* extent = segmentLabelmap->GetExtent();
   if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
     {
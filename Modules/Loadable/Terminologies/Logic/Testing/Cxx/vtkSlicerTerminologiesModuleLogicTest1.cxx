@@ -0,0 +1,135 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Terminologies includes
+#include "vtkSlicerTerminologiesModuleLogic.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtksys/Directory.hxx>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <fstream>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Write a terminology file that contains a single category
+bool WriteTerminologyFile(const std::string& filePath, const std::string& contextName, const std::string& categoryName)
+{
+  std::ofstream stream(filePath.c_str());
+  stream << "{\n"
+    << "  \"SegmentationCategoryTypeContextName\": \"" << contextName << "\",\n"
+    << "  \"SegmentationCodes\": {\n"
+    << "    \"Category\": [\n"
+    << "      {\n"
+    << "        \"CodeMeaning\": \"" << categoryName << "\",\n"
+    << "        \"CodingSchemeDesignator\": \"SRT\",\n"
+    << "        \"CodeValue\": \"T-D0050\",\n"
+    << "        \"Type\": [\n"
+    << "          { \"CodeMeaning\": \"Tissue\", \"CodingSchemeDesignator\": \"SRT\", \"CodeValue\": \"T-D0050\" }\n"
+    << "          ]\n"
+    << "      }\n"
+    << "      ]\n"
+    << "    }\n"
+    << "}\n";
+  return stream.good();
+}
+
+//----------------------------------------------------------------------------
+int GetNumberOfCacheFiles(const std::string& cacheDirectory)
+{
+  vtksys::Directory directory;
+  directory.Load(cacheDirectory.c_str());
+  int numberOfCacheFiles = 0;
+  for (unsigned long fileIndex = 0; fileIndex < directory.GetNumberOfFiles(); fileIndex++)
+    {
+    std::string fileName = directory.GetFile(fileIndex);
+    if (vtksys::SystemTools::GetFilenameLastExtension(fileName) == ".terminologycache")
+      {
+      numberOfCacheFiles++;
+      }
+    }
+  return numberOfCacheFiles;
+}
+
+//----------------------------------------------------------------------------
+int CheckTerminology(vtkSlicerTerminologiesModuleLogic* logic, const std::string& filePath,
+  const std::string& expectedContextName, const std::string& expectedCategoryName)
+{
+  std::string contextName = logic->LoadTerminologyFromFile(filePath);
+  CHECK_STD_STRING(contextName, expectedContextName);
+  std::vector<vtkSlicerTerminologiesModuleLogic::CodeIdentifier> categories;
+  CHECK_BOOL(logic->GetCategoriesInTerminology(contextName, categories), true);
+  CHECK_INT(static_cast<int>(categories.size()), 1);
+  CHECK_STD_STRING(categories[0].CodeMeaning, expectedCategoryName);
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+/// Files of the same name in different folders must have separate cache files
+int TestCacheFilesOfSameName(const std::string& temporaryDirectory)
+{
+  std::string testDirectory = temporaryDirectory + "/vtkSlicerTerminologiesModuleLogicTest1";
+  vtksys::SystemTools::RemoveADirectory(testDirectory.c_str());
+  std::string cacheDirectory = testDirectory + "/Cache";
+  std::string filePathA = testDirectory + "/A/Terminology.json";
+  std::string filePathB = testDirectory + "/B/Terminology.json";
+  CHECK_BOOL(vtksys::SystemTools::MakeDirectory((testDirectory + "/A").c_str()), true);
+  CHECK_BOOL(vtksys::SystemTools::MakeDirectory((testDirectory + "/B").c_str()), true);
+  CHECK_BOOL(WriteTerminologyFile(filePathA, "Context A", "Category A"), true);
+  CHECK_BOOL(WriteTerminologyFile(filePathB, "Context B", "Category B"), true);
+
+  // Compile both files
+  vtkNew<vtkSlicerTerminologiesModuleLogic> logic;
+  logic->SetCacheDirectory(cacheDirectory);
+  CHECK_EXIT_SUCCESS(CheckTerminology(logic.GetPointer(), filePathA, "Context A", "Category A"));
+  CHECK_EXIT_SUCCESS(CheckTerminology(logic.GetPointer(), filePathB, "Context B", "Category B"));
+  CHECK_INT(GetNumberOfCacheFiles(cacheDirectory), 2);
+
+  // Load both files again, in a different order, using the cache
+  vtkNew<vtkSlicerTerminologiesModuleLogic> cachedLogic;
+  cachedLogic->SetCacheDirectory(cacheDirectory);
+  CHECK_EXIT_SUCCESS(CheckTerminology(cachedLogic.GetPointer(), filePathB, "Context B", "Category B"));
+  CHECK_EXIT_SUCCESS(CheckTerminology(cachedLogic.GetPointer(), filePathA, "Context A", "Category A"));
+  CHECK_INT(GetNumberOfCacheFiles(cacheDirectory), 2);
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSlicerTerminologiesModuleLogicTest1(int argc, char * argv[])
+{
+  if (argc != 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string temporaryDirectory(argv[1]);
+
+  CHECK_EXIT_SUCCESS(TestCacheFilesOfSameName(temporaryDirectory));
+  return EXIT_SUCCESS;
+}
@@ -27,6 +27,7 @@
 #include "vtkSlicerTerminologyType.h"
 
 // MRMLLogic includes
+#include <vtkMRMLApplicationLogic.h>
 #include <vtkMRMLScene.h>
 
 // Slicer includes
@@ -38,9 +39,12 @@
 #include <vtkObjectFactory.h>
 #include <vtkStringArray.h>
 #include <vtkVariant.h>
+#include <vtksys/SystemTools.hxx>
 
 // STD includes
 #include <algorithm>
+#include <fstream>
+#include <sstream>
 
 // JSON includes (requires Slicer_BUILD_PARAMETERSERIALIZER_SUPPORT)
 #include <json/json.h>
@@ -48,65 +52,120 @@
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerTerminologiesModuleLogic);
 
+//----------------------------------------------------------------------------
+// Compiled terminology cache file identification. Increase the version whenever
+// the layout of the compiled form changes so that outdated caches are ignored.
+static const char* TERMINOLOGY_CACHE_MAGIC = "SlicerCompiledTerminology";
+static const int TERMINOLOGY_CACHE_VERSION = 1;
+static const char* TERMINOLOGY_CACHE_FILE_EXTENSION = ".terminologycache";
+
 //---------------------------------------------------------------------------
 class vtkSlicerTerminologiesModuleLogic::vtkInternal
 {
 public:
   typedef std::map<std::string, Json::Value> TerminologyMap;
+
+  /// Key of a code in the compiled index (coding scheme designator, code value).
+  /// Code meaning is not part of the key, same as in \sa GetCodeInArray
+  typedef std::pair<std::string, std::string> CodeKey;
+  typedef std::map<CodeKey, int> CodeIndexMap;
+
+  enum ContextType
+    {
+    TerminologyContext = 0,
+    AnatomicContext
+    };
+
+  /// Compiled code (category, type, modifier, or anatomic region).
+  /// Contains all the information needed to populate the terminology container objects,
+  /// and the child codes (types in a category, modifiers in a type, etc.) indexed by
+  /// coding scheme designator and code value, so that lookups need neither traversing
+  /// nor copying Json documents.
+  class CompiledCode
+    {
+    public:
+      enum OptionalMemberFlags
+        {
+        HasSNOMEDCTConceptID = 1,
+        HasUMLSConceptUID = 2,
+        HasCid = 4,
+        HasContextGroupName = 8,
+        HasSlicerLabel = 16
+        };
+      enum RecommendedDisplayRGBValueStates
+        {
+        RGBMissing = 0,
+        RGBValid,
+        RGBUnsupported
+        };
+
+      CompiledCode();
+
+      /// Find child code with given identifier. Returns NULL if not found
+      const CompiledCode* FindChild(const CodeIdentifier& codeId) const;
+      /// Build \sa ChildIndex from \sa Children. First occurrence is kept for duplicate codes.
+      void BuildChildIndex();
+
+      std::string CodingSchemeDesignator;
+      std::string CodeValue;
+      std::string CodeMeaning;
+      /// Lowercase code meaning for case-insensitive search
+      std::string CodeMeaningLowerCase;
+      std::string SNOMEDCTConceptID;
+      std::string UMLSConceptUID;
+      std::string Cid;
+      std::string ContextGroupName;
+      std::string SlicerLabel;
+      /// Combination of \sa OptionalMemberFlags, to distinguish missing members from empty ones
+      int OptionalMembers;
+      int RecommendedDisplayRGBValueState;
+      unsigned char RecommendedDisplayRGBValue[3];
+      bool ShowAnatomy;
+      /// True if the mandatory members (coding scheme designator, code value, code meaning) are strings
+      bool Valid;
+      /// True if the Json object contained the array of child codes (e.g. Type array for categories)
+      bool HasChildArray;
+      std::vector<CompiledCode> Children;
+      CodeIndexMap ChildIndex;
+    };
+
+  /// Compiled terminology or anatomic context.
+  /// The root code holds the categories (terminology) or the anatomic regions (anatomic context).
+  class CompiledContext
+    {
+    public:
+      CompiledContext() : CodesMemberFound(false) { };
+      /// JSON file the context was loaded from. Empty if the context was created from a segment descriptor
+      std::string SourceFilePath;
+      /// True if the SegmentationCodes or AnatomicCodes member was found in the context
+      bool CodesMemberFound;
+      CompiledCode Root;
+    };
+  typedef std::map<std::string, CompiledContext> CompiledContextMap;
+
   vtkInternal(vtkSlicerTerminologiesModuleLogic* external);
   ~vtkInternal();
 
   /// Utility function to get code in Json array
   /// \param foundIndex Output parameter for index of found object in input array. -1 if not found
   /// \return Json object if found, otherwise null Json object
-  Json::Value GetCodeInArray(CodeIdentifier codeId, Json::Value jsonArray, int &foundIndex);
-  
-  /// Get root Json value for the terminology with given name
+  Json::Value GetCodeInArray(const CodeIdentifier& codeId, const Json::Value& jsonArray, int &foundIndex);
+
+  /// Get root Json value for the terminology with given name.
+  /// If the terminology was loaded from the compiled cache, then the Json file is parsed now.
   Json::Value GetTerminologyRootByName(std::string terminologyName);
 
   /// Get category array Json value for a given terminology
   /// \return Null Json value on failure, the array object otherwise
   Json::Value GetCategoryArrayInTerminology(std::string terminologyName);
-  /// Get category Json object from terminology with given category name
-  /// \return Null Json value on failure, the category Json object otherwise
-  Json::Value GetCategoryInTerminology(std::string terminologyName, CodeIdentifier categoryId);
-  /// Populate \sa vtkSlicerTerminologyCategory from Json terminology
-  bool PopulateTerminologyCategoryFromJson(Json::Value categoryObject, vtkSlicerTerminologyCategory* category);
-
-  /// Get type array Json value for a given terminology and category
-  /// \return Null Json value on failure, the array object otherwise
-  Json::Value GetTypeArrayInTerminologyCategory(std::string terminologyName, CodeIdentifier categoryId);
-  /// Get type Json object from a terminology category with given type name
-  /// \return Null Json value on failure, the type Json object otherwise
-  Json::Value GetTypeInTerminologyCategory(std::string terminologyName, CodeIdentifier categoryId, CodeIdentifier typeId);
-  /// Populate \sa vtkSlicerTerminologyType from Json terminology
-  bool PopulateTerminologyTypeFromJson(Json::Value typeObject, vtkSlicerTerminologyType* type);
-
-  /// Get type modifier array Json value for a given terminology, category, and type
-  /// \return Null Json value on failure, the array object otherwise
-  Json::Value GetTypeModifierArrayInTerminologyType(std::string terminologyName, CodeIdentifier categoryId, CodeIdentifier typeId);
-  /// Get type modifier Json object from a terminology, category, and type with given modifier name
-  /// \return Null Json value on failure, the type Json object otherwise
-  Json::Value GetTypeModifierInTerminologyType(std::string terminologyName, CodeIdentifier categoryId, CodeIdentifier typeId, CodeIdentifier modifierId);
 
   /// Get root Json value for the anatomic context with given name
+  /// If the anatomic context was loaded from the compiled cache, then the Json file is parsed now.
   Json::Value GetAnatomicContextRootByName(std::string anatomicContextName);
 
   /// Get region array Json value for a given anatomic context
   /// \return Null Json value on failure, the array object otherwise
   Json::Value GetRegionArrayInAnatomicContext(std::string anatomicContextName);
-  /// Get type Json object from an anatomic context with given region name
-  /// \return Null Json value on failure, the type Json object otherwise
-  Json::Value GetRegionInAnatomicContext(std::string anatomicContextName, CodeIdentifier regionId);
-  /// Populate \sa vtkSlicerTerminologyType from Json anatomic region
-  bool PopulateRegionFromJson(Json::Value anatomicRegionObject, vtkSlicerTerminologyType* region);
-
-  /// Get region modifier array Json value for a given anatomic context and region
-  /// \return Null Json value on failure, the array object otherwise
-  Json::Value GetRegionModifierArrayInRegion(std::string anatomicContextName, CodeIdentifier regionId);
-  /// Get type modifier Json object from an anatomic context and region with given modifier name
-  /// \return Null Json value on failure, the type Json object otherwise
-  Json::Value GetRegionModifierInRegion(std::string anatomicContextName, CodeIdentifier regionId, CodeIdentifier modifierId);
 
   /// Convert a segmentation descriptor Json structure to a terminology context one
   /// \return Terminology context Json structure, Null Json value on failure
@@ -118,17 +177,109 @@ public:
   /// \return The code object with the identifiers set
   Json::Value GetJsonCodeFromIdentifier(Json::Value code, CodeIdentifier idenfifier);
 
+  /// Compile Json code object and its descendants
+  /// \param childArrayNames Null-terminated list of the member names of the child arrays on each level,
+  ///   e.g. {"Type", "Modifier", NULL} for categories
+  void CompileCode(const Json::Value& codeObject, const char* const* childArrayNames, CompiledCode& code);
+  /// Compile the loaded Json terminology or anatomic context with the given name
+  /// \param sourceFilePath JSON file the context was loaded from, empty if not loaded from file
+  void CompileContext(ContextType contextType, std::string contextName, std::string sourceFilePath);
+
+  /// Get compiled context with given name. Returns NULL if not loaded
+  const CompiledContext* GetCompiledContext(ContextType contextType, std::string contextName);
+  /// Get compiled category from a terminology. Returns NULL if not found
+  const CompiledCode* GetCompiledCategory(std::string terminologyName, const CodeIdentifier& categoryId);
+  /// Get compiled type from a terminology category. Returns NULL if not found
+  const CompiledCode* GetCompiledType(std::string terminologyName, const CodeIdentifier& categoryId, const CodeIdentifier& typeId);
+  /// Get compiled anatomic region from an anatomic context. Returns NULL if not found
+  const CompiledCode* GetCompiledRegion(std::string anatomicContextName, const CodeIdentifier& regionId);
+
+  /// Populate \sa vtkSlicerTerminologyCategory from compiled terminology
+  bool PopulateTerminologyCategory(const CompiledCode& categoryCode, vtkSlicerTerminologyCategory* category);
+  /// Populate \sa vtkSlicerTerminologyType from compiled terminology or anatomic context
+  bool PopulateTerminologyType(const CompiledCode& typeCode, vtkSlicerTerminologyType* type);
+
+  /// Get child codes of a compiled code that contain the search string in their name (codeMeaning)
+  /// \param search Lowercase search string. All valid children are returned if empty
+  void FindChildren(const CompiledCode& parentCode, const std::string& search, std::vector<CodeIdentifier>& children);
+
+  /// Get path of the compiled cache file of a JSON file. Empty if caching is disabled
+  std::string GetCacheFilePath(std::string sourceFilePath);
+  /// Read compiled context from the cache if it is up to date with the source JSON file
+  /// \param contextName Output argument, name of the loaded context
+  /// \return Success flag
+  bool ReadCompiledContextFromCache(ContextType contextType, std::string sourceFilePath, std::string& contextName);
+  /// Write compiled context into the cache
+  bool WriteCompiledContextToCache(ContextType contextType, std::string contextName);
+
+  static void WriteCacheString(std::ostream& stream, const std::string& value);
+  static bool ReadCacheString(std::istream& stream, std::string& value);
+  static void WriteCompiledCode(std::ostream& stream, const CompiledCode& code);
+  static bool ReadCompiledCode(std::istream& stream, CompiledCode& code);
+
 public:
   /// Loaded terminologies. Key is the context name, value is the root item.
+  /// Only contains the terminologies that have been parsed from Json, use \sa GetTerminologyRootByName to access.
   TerminologyMap LoadedTerminologies;
 
   /// Loaded anatomical region contexts. Key is the context name, value is the root item.
+  /// Only contains the contexts that have been parsed from Json, use \sa GetAnatomicContextRootByName to access.
   TerminologyMap LoadedAnatomicContexts;
 
+  /// Compiled terminologies. Key is the context name. Used for all lookups.
+  CompiledContextMap CompiledTerminologies;
+
+  /// Compiled anatomic contexts. Key is the context name. Used for all lookups.
+  CompiledContextMap CompiledAnatomicContexts;
+
+  /// Directory of the compiled cache files. Caching is disabled if empty.
+  std::string CacheDirectory;
+
 private:
   vtkSlicerTerminologiesModuleLogic* External;
 };
 
+//---------------------------------------------------------------------------
+// CompiledCode methods
+
+//---------------------------------------------------------------------------
+vtkSlicerTerminologiesModuleLogic::vtkInternal::CompiledCode::CompiledCode()
+  : OptionalMembers(0)
+  , RecommendedDisplayRGBValueState(RGBMissing)
+  , ShowAnatomy(true)
+  , Valid(false)
+  , HasChildArray(false)
+{
+  this->RecommendedDisplayRGBValue[0] = 127;
+  this->RecommendedDisplayRGBValue[1] = 127;
+  this->RecommendedDisplayRGBValue[2] = 127;
+}
+
+//---------------------------------------------------------------------------
+const vtkSlicerTerminologiesModuleLogic::vtkInternal::CompiledCode*
+vtkSlicerTerminologiesModuleLogic::vtkInternal::CompiledCode::FindChild(const CodeIdentifier& codeId) const
+{
+  CodeIndexMap::const_iterator childIt = this->ChildIndex.find(CodeKey(codeId.CodingSchemeDesignator, codeId.CodeValue));
+  if (childIt == this->ChildIndex.end())
+    {
+    return NULL;
+    }
+  return &(this->Children[childIt->second]);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerTerminologiesModuleLogic::vtkInternal::CompiledCode::BuildChildIndex()
+{
+  this->ChildIndex.clear();
+  int numberOfChildren = static_cast<int>(this->Children.size());
+  for (int index = 0; index < numberOfChildren; ++index)
+    {
+    const CompiledCode& child = this->Children[index];
+    // Insert does not overwrite, so the first occurrence is found, same as with linear search
+    this->ChildIndex.insert(std::make_pair(CodeKey(child.CodingSchemeDesignator, child.CodeValue), index));
+    }
+}
+
 //---------------------------------------------------------------------------
 // vtkInternal methods
 
@@ -144,8 +295,9 @@ vtkSlicerTerminologiesModuleLogic::vtkInternal::~vtkInternal()
 }
 
 //---------------------------------------------------------------------------
-Json::Value vtkSlicerTerminologiesModuleLogic::vtkInternal::GetCodeInArray(CodeIdentifier codeId, Json::Value jsonArray, int &foundIndex)
+Json::Value vtkSlicerTerminologiesModuleLogic::vtkInternal::GetCodeInArray(const CodeIdentifier& codeId, const Json::Value& jsonArray, int &foundIndex)
 {
+  foundIndex = -1;
   if (!jsonArray.isArray())
     {
     return Json::Value();
@@ -155,11 +307,11 @@ Json::Value vtkSlicerTerminologiesModuleLogic::vtkInternal::GetCodeInArray(CodeI
   Json::ArrayIndex index = 0;
   while (jsonArray.isValidIndex(index))
     {
-    Json::Value currentObject = jsonArray[index];
+    const Json::Value& currentObject = jsonArray[index];
     if (currentObject.isObject())
       {
-      Json::Value codingSchemeDesignator = currentObject["CodingSchemeDesignator"];
-      Json::Value codeValue = currentObject["CodeValue"];
+      const Json::Value& codingSchemeDesignator = currentObject["CodingSchemeDesignator"];
+      const Json::Value& codeValue = currentObject["CodeValue"];
       if ( codingSchemeDesignator.isString() && !codeId.CodingSchemeDesignator.compare(codingSchemeDesignator.asString())
         && codeValue.isString() && !codeId.CodeValue.compare(codeValue.asString()) )
         {
@@ -171,7 +323,6 @@ Json::Value vtkSlicerTerminologiesModuleLogic::vtkInternal::GetCodeInArray(CodeI
     }
 
   // Not found
-  foundIndex = -1;
   return Json::Value();
 }
 
@@ -184,7 +335,26 @@ Json::Value vtkSlicerTerminologiesModuleLogic::vtkInternal::GetTerminologyRootBy
     return termIt->second;
     }
 
-  return Json::Value();
+  // Terminology may have been loaded from the compiled cache, parse the Json file now
+  CompiledContextMap::iterator compiledIt = this->CompiledTerminologies.find(terminologyName);
+  if (compiledIt == this->CompiledTerminologies.end() || compiledIt->second.SourceFilePath.empty())
+    {
+    return Json::Value();
+    }
+  std::ifstream terminologyStream(compiledIt->second.SourceFilePath.c_str(), std::ios_base::binary);
+  Json::Value terminologyRoot;
+  try
+    {
+    terminologyStream >> terminologyRoot;
+    }
+  catch (std::exception &e)
+    {
+    vtkGenericWarningMacro("GetTerminologyRootByName: Failed to load terminology from file '"
+      << compiledIt->second.SourceFilePath << "' - exception: " << e.what());
+    return Json::Value();
+    }
+  this->LoadedTerminologies[terminologyName] = terminologyRoot;
+  return terminologyRoot;
 }
 
 //---------------------------------------------------------------------------
@@ -218,342 +388,612 @@ Json::Value vtkSlicerTerminologiesModuleLogic::vtkInternal::GetCategoryArrayInTe
 }
 
 //---------------------------------------------------------------------------
-Json::Value vtkSlicerTerminologiesModuleLogic::vtkInternal::GetCategoryInTerminology(std::string terminologyName, CodeIdentifier categoryId)
+Json::Value vtkSlicerTerminologiesModuleLogic::vtkInternal::GetAnatomicContextRootByName(std::string anatomicContextName)
 {
-  if (categoryId.CodingSchemeDesignator.empty() || categoryId.CodeValue.empty())
+  TerminologyMap::iterator anIt = this->LoadedAnatomicContexts.find(anatomicContextName);
+  if (anIt != this->LoadedAnatomicContexts.end())
+    {
+    return anIt->second;
+    }
+
+  // Anatomic context may have been loaded from the compiled cache, parse the Json file now
+  CompiledContextMap::iterator compiledIt = this->CompiledAnatomicContexts.find(anatomicContextName);
+  if (compiledIt == this->CompiledAnatomicContexts.end() || compiledIt->second.SourceFilePath.empty())
     {
     return Json::Value();
     }
-  Json::Value categoryArray = this->GetCategoryArrayInTerminology(terminologyName);
-  if (categoryArray.isNull())
+  std::ifstream anatomicContextStream(compiledIt->second.SourceFilePath.c_str(), std::ios_base::binary);
+  Json::Value anatomicContextRoot;
+  try
+    {
+    anatomicContextStream >> anatomicContextRoot;
+    }
+  catch (std::exception &e)
     {
-    vtkGenericWarningMacro("GetCategoryInTerminology: Failed to find category array in terminology '" << terminologyName << "'");
+    vtkGenericWarningMacro("GetAnatomicContextRootByName: Failed to load anatomic context from file '"
+      << compiledIt->second.SourceFilePath << "' - exception: " << e.what());
     return Json::Value();
     }
-
-  int index = -1;
-  return this->GetCodeInArray(categoryId, categoryArray, index);
+  this->LoadedAnatomicContexts[anatomicContextName] = anatomicContextRoot;
+  return anatomicContextRoot;
 }
 
 //---------------------------------------------------------------------------
-bool vtkSlicerTerminologiesModuleLogic::vtkInternal::PopulateTerminologyCategoryFromJson(Json::Value categoryObject, vtkSlicerTerminologyCategory* category)
+Json::Value vtkSlicerTerminologiesModuleLogic::vtkInternal::GetRegionArrayInAnatomicContext(std::string anatomicContextName)
 {
-  if (!categoryObject.isObject() || !category)
+  if (anatomicContextName.empty())
     {
-    return false;
+    return Json::Value();
+    }
+  Json::Value root = this->GetAnatomicContextRootByName(anatomicContextName);
+  if (root.isNull())
+    {
+    vtkGenericWarningMacro("GetRegionArrayInAnatomicContext: Failed to find anatomic context root for context name '" << anatomicContextName << "'");
+    return Json::Value();
     }
 
-  Json::Value codeMeaning = categoryObject["CodeMeaning"];             // e.g. "Tissue" (mandatory)
-  Json::Value codingScheme = categoryObject["CodingSchemeDesignator"]; // e.g. "SRT" (mandatory)
-  Json::Value SNOMEDCTConceptID = categoryObject["SNOMEDCTConceptID"]; // e.g. "85756007"
-  Json::Value UMLSConceptUID = categoryObject["UMLSConceptUID"];       // e.g. "C0040300"
-  Json::Value cid = categoryObject["cid"];                             // e.g. "7051"
-  Json::Value codeValue = categoryObject["CodeValue"];                 // e.g. "T-D0050" (mandatory)
-  Json::Value contextGroupName = categoryObject["contextGroupName"];   // e.g. "Segmentation Property Categories"
-  Json::Value showAnatomy = categoryObject["showAnatomy"];
-  if (!codingScheme.isString() || !codeValue.isString() || !codeMeaning.isString())
+  Json::Value anatomicCodes = root["AnatomicCodes"];
+  if (anatomicCodes.isNull())
     {
-    vtkGenericWarningMacro("PopulateTerminologyCategoryFromJson: Unable to access mandatory category member");
-    return false;
+    vtkGenericWarningMacro("GetRegionArrayInAnatomicContext: Failed to find AnatomicCodes member in anatomic context '" << anatomicContextName << "'");
+    return Json::Value();
+    }
+  Json::Value anatomicRegionArray = anatomicCodes["AnatomicRegion"];
+  if (!anatomicRegionArray.isArray())
+    {
+    vtkGenericWarningMacro("GetRegionArrayInAnatomicContext: Failed to find AnatomicRegion array member in anatomic context '" << anatomicContextName << "'");
+    return Json::Value();
+    }
+
+  return anatomicRegionArray;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerTerminologiesModuleLogic::vtkInternal::CompileCode(
+  const Json::Value& codeObject, const char* const* childArrayNames, CompiledCode& code)
+{
+  const Json::Value& codeMeaning = codeObject["CodeMeaning"];             // e.g. "Tissue" (mandatory)
+  const Json::Value& codingScheme = codeObject["CodingSchemeDesignator"]; // e.g. "SRT" (mandatory)
+  const Json::Value& codeValue = codeObject["CodeValue"];                 // e.g. "T-D0050" (mandatory)
+  const Json::Value& slicerLabel = codeObject["3dSlicerLabel"];           // e.g. "artery"
+  const Json::Value& SNOMEDCTConceptID = codeObject["SNOMEDCTConceptID"]; // e.g. "85756007"
+  const Json::Value& UMLSConceptUID = codeObject["UMLSConceptUID"];       // e.g. "C0040300"
+  const Json::Value& cid = codeObject["cid"];                             // e.g. "7051"
+  const Json::Value& contextGroupName = codeObject["contextGroupName"];   // e.g. "Segmentation Property Categories"
+  const Json::Value& showAnatomy = codeObject["showAnatomy"];
+  const Json::Value& recommendedDisplayRGBValue = codeObject["recommendedDisplayRGBValue"];
+
+  code.Valid = codingScheme.isString() && codeValue.isString() && codeMeaning.isString();
+  code.CodingSchemeDesignator = codingScheme.isString() ? codingScheme.asString() : "";
+  code.CodeValue = codeValue.isString() ? codeValue.asString() : "";
+  code.CodeMeaning = codeMeaning.isString() ? codeMeaning.asString() : "";
+  code.CodeMeaningLowerCase = code.CodeMeaning;
+  std::transform(code.CodeMeaningLowerCase.begin(), code.CodeMeaningLowerCase.end(), code.CodeMeaningLowerCase.begin(), ::tolower);
+
+  code.OptionalMembers = 0;
+  if (SNOMEDCTConceptID.isString())
+    {
+    code.SNOMEDCTConceptID = SNOMEDCTConceptID.asString();
+    code.OptionalMembers |= CompiledCode::HasSNOMEDCTConceptID;
+    }
+  if (UMLSConceptUID.isString())
+    {
+    code.UMLSConceptUID = UMLSConceptUID.asString();
+    code.OptionalMembers |= CompiledCode::HasUMLSConceptUID;
+    }
+  if (cid.isString())
+    {
+    code.Cid = cid.asString();
+    code.OptionalMembers |= CompiledCode::HasCid;
+    }
+  if (contextGroupName.isString())
+    {
+    code.ContextGroupName = contextGroupName.asString();
+    code.OptionalMembers |= CompiledCode::HasContextGroupName;
+    }
+  if (slicerLabel.isString())
+    {
+    code.SlicerLabel = slicerLabel.asString();
+    code.OptionalMembers |= CompiledCode::HasSlicerLabel;
     }
 
-  category->SetCodeMeaning(codeMeaning.asCString());
-  category->SetCodingScheme(codingScheme.asCString());
-  category->SetSNOMEDCTConceptID(SNOMEDCTConceptID.isString() ? SNOMEDCTConceptID.asCString() : NULL);
-  category->SetUMLSConceptUID(UMLSConceptUID.isString()? UMLSConceptUID.asCString() : NULL);
-  category->SetCid(cid.isString() ? cid.asCString() : NULL);
-  category->SetCodeValue(codeValue.asCString());
-  category->SetContextGroupName(contextGroupName.isString() ? contextGroupName.asCString() : NULL);
   if (showAnatomy.isString())
     {
     std::string showAnatomyStr = showAnatomy.asString();
     std::transform(showAnatomyStr.begin(), showAnatomyStr.end(), showAnatomyStr.begin(), ::tolower); // Make it lowercase for case-insensitive comparison
-    category->SetShowAnatomy( showAnatomyStr.compare("true") ? false : true );
+    code.ShowAnatomy = ( showAnatomyStr.compare("true") ? false : true );
     }
   else if (showAnatomy.isBool())
     {
-    category->SetShowAnatomy(showAnatomy.asBool());
+    code.ShowAnatomy = showAnatomy.asBool();
     }
   else
     {
-    category->SetShowAnatomy(true); // Default
+    code.ShowAnatomy = true; // Default
     }
 
-  return true;
+  if (recommendedDisplayRGBValue.isArray() && recommendedDisplayRGBValue.size() == 3)
+    {
+    if (recommendedDisplayRGBValue[0].isString())
+      {
+      code.RecommendedDisplayRGBValueState = CompiledCode::RGBValid;
+      for (Json::ArrayIndex component = 0; component < 3; ++component)
+        {
+        // Note: Casting directly to unsigned char fails
+        code.RecommendedDisplayRGBValue[component] = (unsigned char)vtkVariant(recommendedDisplayRGBValue[component].asString()).ToInt();
+        }
+      }
+    else if (recommendedDisplayRGBValue[0].isInt())
+      {
+      code.RecommendedDisplayRGBValueState = CompiledCode::RGBValid;
+      for (Json::ArrayIndex component = 0; component < 3; ++component)
+        {
+        code.RecommendedDisplayRGBValue[component] = (unsigned char)recommendedDisplayRGBValue[component].asInt();
+        }
+      }
+    else
+      {
+      code.RecommendedDisplayRGBValueState = CompiledCode::RGBUnsupported;
+      }
+    }
+  else
+    {
+    code.RecommendedDisplayRGBValueState = CompiledCode::RGBMissing;
+    }
+
+  // Compile child codes
+  code.Children.clear();
+  code.HasChildArray = false;
+  if (childArrayNames && childArrayNames[0])
+    {
+    const Json::Value& childArray = codeObject[childArrayNames[0]];
+    code.HasChildArray = childArray.isArray();
+    if (code.HasChildArray)
+      {
+      code.Children.reserve(childArray.size());
+      for (Json::ArrayIndex index = 0; index < childArray.size(); ++index)
+        {
+        const Json::Value& childObject = childArray[index];
+        if (!childObject.isObject())
+          {
+          continue;
+          }
+        code.Children.push_back(CompiledCode());
+        this->CompileCode(childObject, childArrayNames + 1, code.Children.back());
+        }
+      }
+    }
+  code.BuildChildIndex();
 }
 
 //---------------------------------------------------------------------------
-Json::Value vtkSlicerTerminologiesModuleLogic::vtkInternal::GetTypeArrayInTerminologyCategory(std::string terminologyName, CodeIdentifier categoryId)
+void vtkSlicerTerminologiesModuleLogic::vtkInternal::CompileContext(
+  ContextType contextType, std::string contextName, std::string sourceFilePath)
 {
-  if (categoryId.CodingSchemeDesignator.empty() || categoryId.CodeValue.empty())
+  static const char* const terminologyArrayNames[] = { "Category", "Type", "Modifier", NULL };
+  static const char* const anatomicContextArrayNames[] = { "AnatomicRegion", "Modifier", NULL };
+
+  const Json::Value* root = NULL;
+  CompiledContext* compiledContext = NULL;
+  std::string codesMemberName;
+  const char* const* childArrayNames = NULL;
+  if (contextType == TerminologyContext)
     {
-    return Json::Value();
+    root = &(this->LoadedTerminologies[contextName]);
+    compiledContext = &(this->CompiledTerminologies[contextName]);
+    codesMemberName = "SegmentationCodes";
+    childArrayNames = terminologyArrayNames;
     }
-  Json::Value categoryObject = this->GetCategoryInTerminology(terminologyName, categoryId);
-  if (categoryObject.isNull())
+  else
     {
-    vtkGenericWarningMacro("GetTypeArrayInTerminologyCategory: Failed to find category '" << categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
-    return Json::Value();
+    root = &(this->LoadedAnatomicContexts[contextName]);
+    compiledContext = &(this->CompiledAnatomicContexts[contextName]);
+    codesMemberName = "AnatomicCodes";
+    childArrayNames = anatomicContextArrayNames;
     }
 
-  Json::Value typeArray = categoryObject["Type"];
-  if (!typeArray.isArray())
+  compiledContext->SourceFilePath = sourceFilePath;
+  compiledContext->Root = CompiledCode();
+  const Json::Value& codes = (*root)[codesMemberName];
+  compiledContext->CodesMemberFound = !codes.isNull();
+  if (codes.isObject())
     {
-    vtkGenericWarningMacro("GetTypeArrayInTerminologyCategory: Failed to find Type array member in category '"
-      << categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
-    return Json::Value();
+    this->CompileCode(codes, childArrayNames, compiledContext->Root);
     }
+}
+
+//---------------------------------------------------------------------------
+const vtkSlicerTerminologiesModuleLogic::vtkInternal::CompiledContext*
+vtkSlicerTerminologiesModuleLogic::vtkInternal::GetCompiledContext(ContextType contextType, std::string contextName)
+{
+  CompiledContextMap& contexts = (contextType == TerminologyContext ? this->CompiledTerminologies : this->CompiledAnatomicContexts);
+  CompiledContextMap::iterator contextIt = contexts.find(contextName);
+  if (contextIt == contexts.end())
+    {
+    return NULL;
+    }
+  return &(contextIt->second);
+}
 
-  return typeArray;
+//---------------------------------------------------------------------------
+const vtkSlicerTerminologiesModuleLogic::vtkInternal::CompiledCode*
+vtkSlicerTerminologiesModuleLogic::vtkInternal::GetCompiledCategory(std::string terminologyName, const CodeIdentifier& categoryId)
+{
+  if (categoryId.CodingSchemeDesignator.empty() || categoryId.CodeValue.empty())
+    {
+    return NULL;
+    }
+  const CompiledContext* terminology = this->GetCompiledContext(TerminologyContext, terminologyName);
+  if (!terminology || !terminology->Root.HasChildArray)
+    {
+    vtkGenericWarningMacro("GetCompiledCategory: Failed to find category array in terminology '" << terminologyName << "'");
+    return NULL;
+    }
+  return terminology->Root.FindChild(categoryId);
 }
 
 //---------------------------------------------------------------------------
-Json::Value vtkSlicerTerminologiesModuleLogic::vtkInternal::GetTypeInTerminologyCategory(
-  std::string terminologyName, CodeIdentifier categoryId, CodeIdentifier typeId)
+const vtkSlicerTerminologiesModuleLogic::vtkInternal::CompiledCode*
+vtkSlicerTerminologiesModuleLogic::vtkInternal::GetCompiledType(
+  std::string terminologyName, const CodeIdentifier& categoryId, const CodeIdentifier& typeId)
 {
   if (typeId.CodingSchemeDesignator.empty() || typeId.CodeValue.empty())
     {
-    return Json::Value();
+    return NULL;
+    }
+  const CompiledCode* category = this->GetCompiledCategory(terminologyName, categoryId);
+  if (!category)
+    {
+    vtkGenericWarningMacro("GetCompiledType: Failed to find category '" << categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
+    return NULL;
     }
-  Json::Value typeArray = this->GetTypeArrayInTerminologyCategory(terminologyName, categoryId);
-  if (typeArray.isNull())
+  if (!category->HasChildArray)
     {
-    vtkGenericWarningMacro("GetTypeInTerminologyCategory: Failed to find type array for category '"
+    vtkGenericWarningMacro("GetCompiledType: Failed to find Type array member in category '"
       << categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
-    return Json::Value();
+    return NULL;
     }
-
-  int index = -1;
-  return this->GetCodeInArray(typeId, typeArray, index);
+  return category->FindChild(typeId);
 }
 
 //---------------------------------------------------------------------------
-bool vtkSlicerTerminologiesModuleLogic::vtkInternal::PopulateTerminologyTypeFromJson(Json::Value typeObject, vtkSlicerTerminologyType* type)
+const vtkSlicerTerminologiesModuleLogic::vtkInternal::CompiledCode*
+vtkSlicerTerminologiesModuleLogic::vtkInternal::GetCompiledRegion(std::string anatomicContextName, const CodeIdentifier& regionId)
 {
-  if (!typeObject.isObject() || !type)
+  if (regionId.CodingSchemeDesignator.empty() || regionId.CodeValue.empty())
     {
-    return false;
+    return NULL;
     }
-
-  Json::Value recommendedDisplayRGBValue = typeObject["recommendedDisplayRGBValue"];
-  Json::Value codeMeaning = typeObject["CodeMeaning"];             // e.g. "Artery" (mandatory)
-  Json::Value codingScheme = typeObject["CodingSchemeDesignator"]; // e.g. "SRT" (mandatory)
-  Json::Value slicerLabel = typeObject["3dSlicerLabel"];           // e.g. "artery"
-  Json::Value SNOMEDCTConceptID = typeObject["SNOMEDCTConceptID"]; // e.g. "85756007"
-  Json::Value UMLSConceptUID = typeObject["UMLSConceptUID"];       // e.g. "C0040300"
-  Json::Value cid = typeObject["cid"];                             // e.g. "7051"
-  Json::Value codeValue = typeObject["CodeValue"];                 // e.g. "T-D0050" (mandatory)
-  Json::Value contextGroupName = typeObject["contextGroupName"];   // e.g. "Segmentation Property Categories"
-  Json::Value modifier = typeObject["Modifier"];                   // Modifier array, containing modifiers of this type, e.g. "Left"
-  if (!codingScheme.isString() || !codeValue.isString() || !codeMeaning.isString())
+  const CompiledContext* anatomicContext = this->GetCompiledContext(AnatomicContext, anatomicContextName);
+  if (!anatomicContext || !anatomicContext->Root.HasChildArray)
     {
-    vtkGenericWarningMacro("PopulateTerminologyTypeFromJson: Unable to access mandatory type member");
-    return false;
+    vtkGenericWarningMacro("GetCompiledRegion: Failed to find region array for anatomic context '" << anatomicContextName << "'");
+    return NULL;
     }
+  return anatomicContext->Root.FindChild(regionId);
+}
 
-  type->SetCodeMeaning(codeMeaning.asCString());
-  type->SetCodingScheme(codingScheme.asCString());
-  type->SetSlicerLabel(slicerLabel.isString() ? slicerLabel.asCString() : NULL);
-  type->SetSNOMEDCTConceptID(SNOMEDCTConceptID.isString() ? SNOMEDCTConceptID.asCString() : NULL);
-  type->SetUMLSConceptUID(UMLSConceptUID.isString()? UMLSConceptUID.asCString() : NULL);
-  type->SetCid(cid.isString() ? cid.asCString() : NULL);
-  type->SetCodeValue(codeValue.asCString());
-  type->SetContextGroupName(contextGroupName.isString() ? contextGroupName.asCString() : NULL);
-
-  if (recommendedDisplayRGBValue.isArray() && recommendedDisplayRGBValue.size() == 3)
+//---------------------------------------------------------------------------
+bool vtkSlicerTerminologiesModuleLogic::vtkInternal::PopulateTerminologyCategory(const CompiledCode& categoryCode, vtkSlicerTerminologyCategory* category)
+{
+  if (!category)
     {
-    if (recommendedDisplayRGBValue[0].isString())
-      {
-      type->SetRecommendedDisplayRGBValue( // Note: Casting directly to unsigned char fails
-        (unsigned char)vtkVariant(recommendedDisplayRGBValue[0].asString()).ToInt(),
-        (unsigned char)vtkVariant(recommendedDisplayRGBValue[1].asString()).ToInt(),
-        (unsigned char)vtkVariant(recommendedDisplayRGBValue[2].asString()).ToInt() );
-      }
-    else if (recommendedDisplayRGBValue[0].isInt())
-      {
-      type->SetRecommendedDisplayRGBValue(
-        (unsigned char)recommendedDisplayRGBValue[0].asInt(),
-        (unsigned char)recommendedDisplayRGBValue[1].asInt(),
-        (unsigned char)recommendedDisplayRGBValue[2].asInt() );
-      }
-    else
-      {
-      vtkGenericWarningMacro("PopulateTerminologyTypeFromJson: Unsupported data type for recommendedDisplayRGBValue");
-      }
+    return false;
     }
-  else
+  if (!categoryCode.Valid)
     {
-    type->SetRecommendedDisplayRGBValue(127,127,127); // 'Invalid' gray
+    vtkGenericWarningMacro("PopulateTerminologyCategory: Unable to access mandatory category member");
+    return false;
     }
 
-  type->SetHasModifiers(modifier.isArray());
+  category->SetCodeMeaning(categoryCode.CodeMeaning.c_str());
+  category->SetCodingScheme(categoryCode.CodingSchemeDesignator.c_str());
+  category->SetSNOMEDCTConceptID((categoryCode.OptionalMembers & CompiledCode::HasSNOMEDCTConceptID) ? categoryCode.SNOMEDCTConceptID.c_str() : NULL);
+  category->SetUMLSConceptUID((categoryCode.OptionalMembers & CompiledCode::HasUMLSConceptUID) ? categoryCode.UMLSConceptUID.c_str() : NULL);
+  category->SetCid((categoryCode.OptionalMembers & CompiledCode::HasCid) ? categoryCode.Cid.c_str() : NULL);
+  category->SetCodeValue(categoryCode.CodeValue.c_str());
+  category->SetContextGroupName((categoryCode.OptionalMembers & CompiledCode::HasContextGroupName) ? categoryCode.ContextGroupName.c_str() : NULL);
+  category->SetShowAnatomy(categoryCode.ShowAnatomy);
 
   return true;
 }
 
 //---------------------------------------------------------------------------
-Json::Value vtkSlicerTerminologiesModuleLogic::vtkInternal::GetTypeModifierArrayInTerminologyType(
-  std::string terminologyName, CodeIdentifier categoryId, CodeIdentifier typeId)
+bool vtkSlicerTerminologiesModuleLogic::vtkInternal::PopulateTerminologyType(const CompiledCode& typeCode, vtkSlicerTerminologyType* type)
 {
-  if (typeId.CodingSchemeDesignator.empty() || typeId.CodeValue.empty())
+  if (!type)
     {
-    return Json::Value();
+    return false;
     }
-  Json::Value categoryObject = this->GetCategoryInTerminology(terminologyName, categoryId);
-  if (categoryObject.isNull())
+  if (!typeCode.Valid)
     {
-    vtkGenericWarningMacro("GetTypeModifierArrayInTerminologyType: Failed to find category '" <<
-      categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
-    return Json::Value();
+    vtkGenericWarningMacro("PopulateTerminologyType: Unable to access mandatory type member");
+    return false;
     }
 
-  Json::Value typeObject = this->GetTypeInTerminologyCategory(terminologyName, categoryId, typeId);
-  if (typeObject.isNull())
+  type->SetCodeMeaning(typeCode.CodeMeaning.c_str());
+  type->SetCodingScheme(typeCode.CodingSchemeDesignator.c_str());
+  type->SetSlicerLabel((typeCode.OptionalMembers & CompiledCode::HasSlicerLabel) ? typeCode.SlicerLabel.c_str() : NULL);
+  type->SetSNOMEDCTConceptID((typeCode.OptionalMembers & CompiledCode::HasSNOMEDCTConceptID) ? typeCode.SNOMEDCTConceptID.c_str() : NULL);
+  type->SetUMLSConceptUID((typeCode.OptionalMembers & CompiledCode::HasUMLSConceptUID) ? typeCode.UMLSConceptUID.c_str() : NULL);
+  type->SetCid((typeCode.OptionalMembers & CompiledCode::HasCid) ? typeCode.Cid.c_str() : NULL);
+  type->SetCodeValue(typeCode.CodeValue.c_str());
+  type->SetContextGroupName((typeCode.OptionalMembers & CompiledCode::HasContextGroupName) ? typeCode.ContextGroupName.c_str() : NULL);
+
+  if (typeCode.RecommendedDisplayRGBValueState == CompiledCode::RGBValid)
     {
-    vtkGenericWarningMacro("GetTypeModifierArrayInTerminologyType: Failed to find type '" << typeId.CodeMeaning << "' in category '"
-      << categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
-    return Json::Value();
+    type->SetRecommendedDisplayRGBValue(
+      typeCode.RecommendedDisplayRGBValue[0], typeCode.RecommendedDisplayRGBValue[1], typeCode.RecommendedDisplayRGBValue[2] );
     }
-
-  Json::Value typeModifierArray = typeObject["Modifier"];
-  if (!typeModifierArray.isArray())
+  else if (typeCode.RecommendedDisplayRGBValueState == CompiledCode::RGBUnsupported)
     {
-    return Json::Value();
+    vtkGenericWarningMacro("PopulateTerminologyType: Unsupported data type for recommendedDisplayRGBValue");
+    }
+  else
+    {
+    type->SetRecommendedDisplayRGBValue(127,127,127); // 'Invalid' gray
     }
 
-  return typeModifierArray;
+  type->SetHasModifiers(typeCode.HasChildArray);
+
+  return true;
 }
 
 //---------------------------------------------------------------------------
-Json::Value vtkSlicerTerminologiesModuleLogic::vtkInternal::GetTypeModifierInTerminologyType(
-  std::string terminologyName, CodeIdentifier categoryId, CodeIdentifier typeId, CodeIdentifier modifierId)
+void vtkSlicerTerminologiesModuleLogic::vtkInternal::FindChildren(
+  const CompiledCode& parentCode, const std::string& search, std::vector<CodeIdentifier>& children)
 {
-  if (modifierId.CodingSchemeDesignator.empty() || modifierId.CodeValue.empty())
-    {
-    return Json::Value();
-    }
-  Json::Value typeModifierArray = this->GetTypeModifierArrayInTerminologyType(terminologyName, categoryId, typeId);
-  if (typeModifierArray.isNull())
+  for (std::vector<CompiledCode>::const_iterator childIt = parentCode.Children.begin(); childIt != parentCode.Children.end(); ++childIt)
     {
-    vtkGenericWarningMacro("GetTypeModifierInTerminologyType: Failed to find type modifier array for type '" << typeId.CodeMeaning << "' in category '"
-      << categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
-    return Json::Value();
+    if (!childIt->Valid)
+      {
+      vtkGenericWarningMacro("FindChildren: Invalid code '" << childIt->CodeMeaning << "' in '" << parentCode.CodeMeaning << "'");
+      continue;
+      }
+    // Add code to list if search string is empty or is contained by the current code name
+    if (search.empty() || childIt->CodeMeaningLowerCase.find(search) != std::string::npos)
+      {
+      children.push_back(CodeIdentifier(childIt->CodingSchemeDesignator, childIt->CodeValue, childIt->CodeMeaning));
+      }
     }
-
-  int index = -1;
-  return this->GetCodeInArray(modifierId, typeModifierArray, index);
 }
 
 //---------------------------------------------------------------------------
-Json::Value vtkSlicerTerminologiesModuleLogic::vtkInternal::GetAnatomicContextRootByName(std::string anatomicContextName)
+std::string vtkSlicerTerminologiesModuleLogic::vtkInternal::GetCacheFilePath(std::string sourceFilePath)
 {
-  TerminologyMap::iterator anIt = this->LoadedAnatomicContexts.find(anatomicContextName);
-  if (anIt != this->LoadedAnatomicContexts.end())
+  if (this->CacheDirectory.empty() || sourceFilePath.empty())
     {
-    return anIt->second;
+    return "";
     }
-
-  return Json::Value();
+  // Files with the same name may be loaded from different folders, so the cache file name
+  // also contains a hash (32-bit FNV-1a) of the full path of the source file
+  std::string fullPath = vtksys::SystemTools::CollapseFullPath(sourceFilePath);
+  unsigned int pathHash = 2166136261u;
+  for (std::string::const_iterator charIt = fullPath.begin(); charIt != fullPath.end(); ++charIt)
+    {
+    pathHash ^= static_cast<unsigned char>(*charIt);
+    pathHash *= 16777619u;
+    }
+  std::stringstream cacheFileNameStream;
+  cacheFileNameStream << vtksys::SystemTools::GetFilenameWithoutLastExtension(sourceFilePath)
+    << "_" << std::hex << pathHash << TERMINOLOGY_CACHE_FILE_EXTENSION;
+  return this->CacheDirectory + "/" + cacheFileNameStream.str();
 }
 
 //---------------------------------------------------------------------------
-Json::Value vtkSlicerTerminologiesModuleLogic::vtkInternal::GetRegionArrayInAnatomicContext(std::string anatomicContextName)
+bool vtkSlicerTerminologiesModuleLogic::vtkInternal::ReadCompiledContextFromCache(
+  ContextType contextType, std::string sourceFilePath, std::string& contextName)
 {
-  if (anatomicContextName.empty())
+  std::string cacheFilePath = this->GetCacheFilePath(sourceFilePath);
+  if (cacheFilePath.empty() || !vtksys::SystemTools::FileExists(cacheFilePath.c_str(), true)
+    || !vtksys::SystemTools::FileExists(sourceFilePath.c_str(), true))
     {
-    return Json::Value();
+    return false;
     }
-  Json::Value root = this->GetAnatomicContextRootByName(anatomicContextName);
-  if (root.isNull())
+  std::ifstream cacheStream(cacheFilePath.c_str(), std::ios_base::binary);
+  if (!cacheStream.good())
     {
-    vtkGenericWarningMacro("GetRegionArrayInAnatomicContext: Failed to find anatomic context root for context name '" << anatomicContextName << "'");
-    return Json::Value();
+    return false;
     }
 
-  Json::Value anatomicCodes = root["AnatomicCodes"];
-  if (anatomicCodes.isNull())
+  // The cache is only valid for the same source file, unchanged since it was compiled
+  std::string magic;
+  std::string cachedSourceFilePath;
+  int version = 0;
+  int cachedContextType = -1;
+  unsigned long cachedFileLength = 0;
+  long cachedModifiedTime = 0;
+  if (!ReadCacheString(cacheStream, magic) || magic.compare(TERMINOLOGY_CACHE_MAGIC))
     {
-    vtkGenericWarningMacro("GetRegionArrayInAnatomicContext: Failed to find AnatomicCodes member in anatomic context '" << anatomicContextName << "'");
-    return Json::Value();
+    return false;
     }
-  Json::Value anatomicRegionArray = anatomicCodes["AnatomicRegion"];
-  if (!anatomicRegionArray.isArray())
+  cacheStream.read(reinterpret_cast<char*>(&version), sizeof(version));
+  cacheStream.read(reinterpret_cast<char*>(&cachedContextType), sizeof(cachedContextType));
+  if (!cacheStream.good() || version != TERMINOLOGY_CACHE_VERSION || cachedContextType != contextType)
     {
-    vtkGenericWarningMacro("GetRegionArrayInAnatomicContext: Failed to find AnatomicRegion array member in anatomic context '" << anatomicContextName << "'");
-    return Json::Value();
+    return false;
+    }
+  if (!ReadCacheString(cacheStream, cachedSourceFilePath)
+    || cachedSourceFilePath.compare(vtksys::SystemTools::CollapseFullPath(sourceFilePath)))
+    {
+    return false;
+    }
+  cacheStream.read(reinterpret_cast<char*>(&cachedFileLength), sizeof(cachedFileLength));
+  cacheStream.read(reinterpret_cast<char*>(&cachedModifiedTime), sizeof(cachedModifiedTime));
+  if (!cacheStream.good()
+    || cachedFileLength != vtksys::SystemTools::FileLength(sourceFilePath.c_str())
+    || cachedModifiedTime != vtksys::SystemTools::ModifiedTime(sourceFilePath.c_str()))
+    {
+    return false;
     }
 
-  return anatomicRegionArray;
+  CompiledContext compiledContext;
+  char codesMemberFound = 0;
+  if (!ReadCacheString(cacheStream, contextName))
+    {
+    return false;
+    }
+  cacheStream.read(&codesMemberFound, 1);
+  if (!cacheStream.good() || !ReadCompiledCode(cacheStream, compiledContext.Root))
+    {
+    vtkGenericWarningMacro("ReadCompiledContextFromCache: Corrupt terminology cache file '" << cacheFilePath << "', ignoring it");
+    return false;
+    }
+  compiledContext.CodesMemberFound = (codesMemberFound != 0);
+  compiledContext.SourceFilePath = sourceFilePath;
+
+  // Store compiled context. Json will be parsed on demand.
+  if (contextType == TerminologyContext)
+    {
+    this->CompiledTerminologies[contextName] = compiledContext;
+    this->LoadedTerminologies.erase(contextName);
+    }
+  else
+    {
+    this->CompiledAnatomicContexts[contextName] = compiledContext;
+    this->LoadedAnatomicContexts.erase(contextName);
+    }
+  return true;
 }
 
 //---------------------------------------------------------------------------
-Json::Value vtkSlicerTerminologiesModuleLogic::vtkInternal::GetRegionInAnatomicContext(std::string anatomicContextName, CodeIdentifier regionId)
+bool vtkSlicerTerminologiesModuleLogic::vtkInternal::WriteCompiledContextToCache(ContextType contextType, std::string contextName)
 {
-  if (regionId.CodingSchemeDesignator.empty() || regionId.CodeValue.empty())
+  const CompiledContext* compiledContext = this->GetCompiledContext(contextType, contextName);
+  if (!compiledContext)
     {
-    return Json::Value();
+    return false;
     }
-  Json::Value regionArray = this->GetRegionArrayInAnatomicContext(anatomicContextName);
-  if (regionArray.isNull())
+  std::string cacheFilePath = this->GetCacheFilePath(compiledContext->SourceFilePath);
+  if (cacheFilePath.empty())
     {
-    vtkGenericWarningMacro("GetRegionInAnatomicContext: Failed to find region array for anatomic context '" << anatomicContextName << "'");
-    return Json::Value();
+    return false;
+    }
+  if (!vtksys::SystemTools::MakeDirectory(this->CacheDirectory.c_str()))
+    {
+    vtkGenericWarningMacro("WriteCompiledContextToCache: Failed to create terminology cache directory '" << this->CacheDirectory << "'");
+    return false;
+    }
+  std::ofstream cacheStream(cacheFilePath.c_str(), std::ios_base::binary);
+  if (!cacheStream.good())
+    {
+    vtkGenericWarningMacro("WriteCompiledContextToCache: Failed to write terminology cache file '" << cacheFilePath << "'");
+    return false;
     }
 
-  int index = -1;
-  return this->GetCodeInArray(regionId, regionArray, index);
+  int version = TERMINOLOGY_CACHE_VERSION;
+  int contextTypeValue = contextType;
+  unsigned long fileLength = vtksys::SystemTools::FileLength(compiledContext->SourceFilePath.c_str());
+  long modifiedTime = vtksys::SystemTools::ModifiedTime(compiledContext->SourceFilePath.c_str());
+  char codesMemberFound = (compiledContext->CodesMemberFound ? 1 : 0);
+  WriteCacheString(cacheStream, TERMINOLOGY_CACHE_MAGIC);
+  cacheStream.write(reinterpret_cast<const char*>(&version), sizeof(version));
+  cacheStream.write(reinterpret_cast<const char*>(&contextTypeValue), sizeof(contextTypeValue));
+  WriteCacheString(cacheStream, vtksys::SystemTools::CollapseFullPath(compiledContext->SourceFilePath));
+  cacheStream.write(reinterpret_cast<const char*>(&fileLength), sizeof(fileLength));
+  cacheStream.write(reinterpret_cast<const char*>(&modifiedTime), sizeof(modifiedTime));
+  WriteCacheString(cacheStream, contextName);
+  cacheStream.write(&codesMemberFound, 1);
+  WriteCompiledCode(cacheStream, compiledContext->Root);
+
+  return cacheStream.good();
 }
 
 //---------------------------------------------------------------------------
-bool vtkSlicerTerminologiesModuleLogic::vtkInternal::PopulateRegionFromJson(Json::Value anatomicRegionObject, vtkSlicerTerminologyType* region)
+void vtkSlicerTerminologiesModuleLogic::vtkInternal::WriteCacheString(std::ostream& stream, const std::string& value)
 {
-  return this->PopulateTerminologyTypeFromJson(anatomicRegionObject, region);
+  unsigned int length = static_cast<unsigned int>(value.size());
+  stream.write(reinterpret_cast<const char*>(&length), sizeof(length));
+  stream.write(value.c_str(), length);
 }
 
 //---------------------------------------------------------------------------
-Json::Value vtkSlicerTerminologiesModuleLogic::vtkInternal::GetRegionModifierArrayInRegion(std::string anatomicContextName, CodeIdentifier regionId)
+bool vtkSlicerTerminologiesModuleLogic::vtkInternal::ReadCacheString(std::istream& stream, std::string& value)
 {
-  if (regionId.CodingSchemeDesignator.empty() || regionId.CodeValue.empty())
+  unsigned int length = 0;
+  stream.read(reinterpret_cast<char*>(&length), sizeof(length));
+  if (!stream.good() || length > (1u << 24))
     {
-    return Json::Value();
+    return false;
     }
-  Json::Value regionObject = this->GetRegionInAnatomicContext(anatomicContextName, regionId);
-  if (regionObject.isNull())
+  value.resize(length);
+  if (length > 0)
     {
-    vtkGenericWarningMacro("GetRegionModifierArrayInAnatomicRegion: Failed to find region '" <<
-      regionId.CodeMeaning << "' in anatomic context '" << anatomicContextName << "'");
-    return Json::Value();
+    stream.read(&value[0], length);
     }
+  return stream.good();
+}
 
-  Json::Value regionModifierArray = regionObject["Modifier"];
-  if (!regionModifierArray.isArray())
-    {
-    vtkGenericWarningMacro("GetRegionModifierArrayInAnatomicRegion: Failed to find Modifier array member in region '" <<
-      regionId.CodeMeaning << "' in anatomic context '" << anatomicContextName << "'");
-    return Json::Value();
+//---------------------------------------------------------------------------
+void vtkSlicerTerminologiesModuleLogic::vtkInternal::WriteCompiledCode(std::ostream& stream, const CompiledCode& code)
+{
+  WriteCacheString(stream, code.CodingSchemeDesignator);
+  WriteCacheString(stream, code.CodeValue);
+  WriteCacheString(stream, code.CodeMeaning);
+  WriteCacheString(stream, code.SNOMEDCTConceptID);
+  WriteCacheString(stream, code.UMLSConceptUID);
+  WriteCacheString(stream, code.Cid);
+  WriteCacheString(stream, code.ContextGroupName);
+  WriteCacheString(stream, code.SlicerLabel);
+  stream.write(reinterpret_cast<const char*>(&code.OptionalMembers), sizeof(code.OptionalMembers));
+  stream.write(reinterpret_cast<const char*>(&code.RecommendedDisplayRGBValueState), sizeof(code.RecommendedDisplayRGBValueState));
+  stream.write(reinterpret_cast<const char*>(code.RecommendedDisplayRGBValue), 3);
+  char flags[3] = { 0, 0, 0 };
+  flags[0] = static_cast<char>(code.ShowAnatomy);
+  flags[1] = static_cast<char>(code.Valid);
+  flags[2] = static_cast<char>(code.HasChildArray);
+  stream.write(flags, 3);
+  unsigned int numberOfChildren = static_cast<unsigned int>(code.Children.size());
+  stream.write(reinterpret_cast<const char*>(&numberOfChildren), sizeof(numberOfChildren));
+  for (std::vector<CompiledCode>::const_iterator childIt = code.Children.begin(); childIt != code.Children.end(); ++childIt)
+    {
+    WriteCompiledCode(stream, *childIt);
     }
-
-  return regionModifierArray;
 }
 
 //---------------------------------------------------------------------------
-Json::Value vtkSlicerTerminologiesModuleLogic::vtkInternal::GetRegionModifierInRegion(
-  std::string anatomicContextName, CodeIdentifier regionId, CodeIdentifier modifierId )
+bool vtkSlicerTerminologiesModuleLogic::vtkInternal::ReadCompiledCode(std::istream& stream, CompiledCode& code)
 {
-  if (modifierId.CodingSchemeDesignator.empty() || modifierId.CodeValue.empty())
+  if ( !ReadCacheString(stream, code.CodingSchemeDesignator)
+    || !ReadCacheString(stream, code.CodeValue)
+    || !ReadCacheString(stream, code.CodeMeaning)
+    || !ReadCacheString(stream, code.SNOMEDCTConceptID)
+    || !ReadCacheString(stream, code.UMLSConceptUID)
+    || !ReadCacheString(stream, code.Cid)
+    || !ReadCacheString(stream, code.ContextGroupName)
+    || !ReadCacheString(stream, code.SlicerLabel) )
     {
-    return Json::Value();
+    return false;
     }
-  Json::Value regionModifierArray = this->GetRegionModifierArrayInRegion(anatomicContextName, regionId);
-  if (regionModifierArray.isNull())
+  code.CodeMeaningLowerCase = code.CodeMeaning;
+  std::transform(code.CodeMeaningLowerCase.begin(), code.CodeMeaningLowerCase.end(), code.CodeMeaningLowerCase.begin(), ::tolower);
+  stream.read(reinterpret_cast<char*>(&code.OptionalMembers), sizeof(code.OptionalMembers));
+  stream.read(reinterpret_cast<char*>(&code.RecommendedDisplayRGBValueState), sizeof(code.RecommendedDisplayRGBValueState));
+  stream.read(reinterpret_cast<char*>(code.RecommendedDisplayRGBValue), 3);
+  char flags[3] = { 0, 0, 0 };
+  stream.read(flags, 3);
+  unsigned int numberOfChildren = 0;
+  stream.read(reinterpret_cast<char*>(&numberOfChildren), sizeof(numberOfChildren));
+  if (!stream.good() || numberOfChildren > (1u << 24))
     {
-    vtkGenericWarningMacro("GetRegionModifierInRegion: Failed to find region modifier array for region '" <<
-      regionId.CodeMeaning << "' in anatomic context '" << anatomicContextName << "'");
-    return Json::Value();
+    return false;
     }
+  code.ShowAnatomy = (flags[0] != 0);
+  code.Valid = (flags[1] != 0);
+  code.HasChildArray = (flags[2] != 0);
 
-  int index = -1;
-  return this->GetCodeInArray(modifierId, regionModifierArray, index);
+  code.Children.clear();
+  code.Children.reserve(numberOfChildren);
+  for (unsigned int index = 0; index < numberOfChildren; ++index)
+    {
+    code.Children.push_back(CompiledCode());
+    if (!ReadCompiledCode(stream, code.Children.back()))
+      {
+      return false;
+      }
+    }
+  code.BuildChildIndex();
+  return true;
 }
 
 //---------------------------------------------------------------------------
@@ -851,6 +1291,24 @@ vtkSlicerTerminologiesModuleLogic::~vtkSlicerTerminologiesModuleLogic()
 void vtkSlicerTerminologiesModuleLogic::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "CacheDirectory: " << this->Internal->CacheDirectory << "\n";
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerTerminologiesModuleLogic::SetCacheDirectory(std::string cacheDirectory)
+{
+  if (this->Internal->CacheDirectory == cacheDirectory)
+    {
+    return;
+    }
+  this->Internal->CacheDirectory = cacheDirectory;
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerTerminologiesModuleLogic::GetCacheDirectory()
+{
+  return this->Internal->CacheDirectory;
 }
 
 //---------------------------------------------------------------------------
@@ -858,6 +1316,14 @@ void vtkSlicerTerminologiesModuleLogic::SetMRMLSceneInternal(vtkMRMLScene* newSc
 {
   Superclass::SetMRMLSceneInternal(newScene);
 
+  // Cache compiled terminologies in the application temporary folder unless specified otherwise
+  vtkMRMLApplicationLogic* appLogic = this->GetMRMLApplicationLogic();
+  std::string temporaryPath = ((appLogic && appLogic->GetTemporaryPath()) ? appLogic->GetTemporaryPath() : "");
+  if (this->Internal->CacheDirectory.empty() && !temporaryPath.empty())
+    {
+    this->Internal->CacheDirectory = temporaryPath + "/TerminologyCache";
+    }
+
   // Load default terminologies and anatomical contexts
   // Note: Do it here not in the constructor so that the module shared directory is properly initialized
   bool wasModifying = this->GetDisableModifiedEvent();
@@ -870,6 +1336,15 @@ void vtkSlicerTerminologiesModuleLogic::SetMRMLSceneInternal(vtkMRMLScene* newSc
 //---------------------------------------------------------------------------
 std::string vtkSlicerTerminologiesModuleLogic::LoadTerminologyFromFile(std::string filePath)
 {
+  // Use compiled terminology from cache if the file has not changed since it was compiled
+  std::string cachedContextName("");
+  if (this->Internal->ReadCompiledContextFromCache(vtkInternal::TerminologyContext, filePath, cachedContextName))
+    {
+    vtkInfoMacro("Terminology named '" << cachedContextName << "' successfully loaded from cache of file " << filePath);
+    this->Modified();
+    return cachedContextName;
+    }
+
   std::ifstream terminologyStream(filePath.c_str(), std::ios_base::binary);
 
   std::string contextName("");
@@ -887,8 +1362,10 @@ std::string vtkSlicerTerminologiesModuleLogic::LoadTerminologyFromFile(std::stri
     return "";
     }
 
-  // Store terminology
+  // Store and compile terminology
   this->Internal->LoadedTerminologies[contextName] = terminologyRoot;
+  this->Internal->CompileContext(vtkInternal::TerminologyContext, contextName, filePath);
+  this->Internal->WriteCompiledContextToCache(vtkInternal::TerminologyContext, contextName);
 
   vtkInfoMacro("Terminology named '" << contextName << "' successfully loaded from file " << filePath);
   this->Modified();
@@ -919,8 +1396,9 @@ bool vtkSlicerTerminologiesModuleLogic::LoadTerminologyFromSegmentDescriptorFile
     return false;
     }
 
-  // Store terminology
+  // Store and compile terminology
   this->Internal->LoadedTerminologies[contextName] = terminologyRoot;
+  this->Internal->CompileContext(vtkInternal::TerminologyContext, contextName, "");
 
   vtkInfoMacro("Terminology named '" << contextName << "' successfully loaded from file " << filePath);
   this->Modified();
@@ -946,6 +1424,14 @@ void vtkSlicerTerminologiesModuleLogic::LoadDefaultTerminologies()
 //---------------------------------------------------------------------------
 std::string vtkSlicerTerminologiesModuleLogic::LoadAnatomicContextFromFile(std::string filePath)
 {
+  // Use compiled anatomic context from cache if the file has not changed since it was compiled
+  std::string cachedContextName("");
+  if (this->Internal->ReadCompiledContextFromCache(vtkInternal::AnatomicContext, filePath, cachedContextName))
+    {
+    vtkInfoMacro("Anatomic context named '" << cachedContextName << "' successfully loaded from cache of file " << filePath);
+    return cachedContextName;
+    }
+
   std::ifstream anatomicContextStream(filePath.c_str(), std::ios_base::binary);
 
   std::string contextName("");
@@ -962,8 +1448,10 @@ std::string vtkSlicerTerminologiesModuleLogic::LoadAnatomicContextFromFile(std::
     return "";
     }
 
-  // Store anatomic context
+  // Store and compile anatomic context
   this->Internal->LoadedAnatomicContexts[contextName] = anatomicContextRoot;
+  this->Internal->CompileContext(vtkInternal::AnatomicContext, contextName, filePath);
+  this->Internal->WriteCompiledContextToCache(vtkInternal::AnatomicContext, contextName);
 
   vtkInfoMacro("Anatomic context named '" << contextName << "' successfully loaded from file " << filePath);
   return contextName;
@@ -993,8 +1481,9 @@ bool vtkSlicerTerminologiesModuleLogic::LoadAnatomicContextFromSegmentDescriptor
     return false;
     }
 
-  // Store anatomic context
+  // Store and compile anatomic context
   this->Internal->LoadedAnatomicContexts[contextName] = anatomicContextRoot;
+  this->Internal->CompileContext(vtkInternal::AnatomicContext, contextName, "");
 
   vtkInfoMacro("Anatomic context named '" << contextName << "' successfully loaded from file " << filePath);
   this->Modified();
@@ -1018,8 +1507,8 @@ void vtkSlicerTerminologiesModuleLogic::GetLoadedTerminologyNames(std::vector<st
 {
   terminologyNames.clear();
 
-  vtkSlicerTerminologiesModuleLogic::vtkInternal::TerminologyMap::iterator termIt;
-  for (termIt=this->Internal->LoadedTerminologies.begin(); termIt!=this->Internal->LoadedTerminologies.end(); ++termIt)
+  vtkSlicerTerminologiesModuleLogic::vtkInternal::CompiledContextMap::iterator termIt;
+  for (termIt=this->Internal->CompiledTerminologies.begin(); termIt!=this->Internal->CompiledTerminologies.end(); ++termIt)
     {
     terminologyNames.push_back(termIt->first);
     }
@@ -1047,8 +1536,8 @@ void vtkSlicerTerminologiesModuleLogic::GetLoadedAnatomicContextNames(std::vecto
 {
   anatomicContextNames.clear();
 
-  vtkSlicerTerminologiesModuleLogic::vtkInternal::TerminologyMap::iterator anIt;
-  for (anIt=this->Internal->LoadedAnatomicContexts.begin(); anIt!=this->Internal->LoadedAnatomicContexts.end(); ++anIt)
+  vtkSlicerTerminologiesModuleLogic::vtkInternal::CompiledContextMap::iterator anIt;
+  for (anIt=this->Internal->CompiledAnatomicContexts.begin(); anIt!=this->Internal->CompiledAnatomicContexts.end(); ++anIt)
     {
     anatomicContextNames.push_back(anIt->first);
     }
@@ -1071,6 +1560,7 @@ void vtkSlicerTerminologiesModuleLogic::GetLoadedAnatomicContextNames(vtkStringA
     }
 }
 
+
 //---------------------------------------------------------------------------
 bool vtkSlicerTerminologiesModuleLogic::GetCategoriesInTerminology(std::string terminologyName, std::vector<CodeIdentifier>& categories)
 {
@@ -1082,8 +1572,8 @@ bool vtkSlicerTerminologiesModuleLogic::FindCategoriesInTerminology(std::string
 {
   categories.clear();
 
-  Json::Value categoryArray = this->Internal->GetCategoryArrayInTerminology(terminologyName);
-  if (categoryArray.isNull())
+  const vtkInternal::CompiledContext* terminology = this->Internal->GetCompiledContext(vtkInternal::TerminologyContext, terminologyName);
+  if (!terminology || !terminology->Root.HasChildArray)
     {
     vtkErrorMacro("FindCategoriesInTerminology: Failed to find category array in terminology '" << terminologyName << "'");
     return false;
@@ -1092,36 +1582,7 @@ bool vtkSlicerTerminologiesModuleLogic::FindCategoriesInTerminology(std::string
   // Make lowercase for case-insensitive comparison
   std::transform(search.begin(), search.end(), search.begin(), ::tolower);
 
-  // Traverse categories
-  Json::ArrayIndex index = 0;
-  while (categoryArray.isValidIndex(index))
-    {
-    Json::Value category = categoryArray[index];
-    if (category.isObject())
-      {
-      Json::Value categoryName = category["CodeMeaning"];
-      Json::Value categoryCodingSchemeDesignator = category["CodingSchemeDesignator"];
-      Json::Value categoryCodeValue = category["CodeValue"];
-      if (categoryName.isString() && categoryCodingSchemeDesignator.isString() && categoryCodeValue.isString())
-        {
-        // Add category to list if search string is empty or is contained by the current category name
-        std::string categoryNameStr = categoryName.asString();
-        std::string categoryNameLowerCase(categoryNameStr);
-        std::transform(categoryNameLowerCase.begin(), categoryNameLowerCase.end(), categoryNameLowerCase.begin(), ::tolower);
-        if (search.empty() || categoryNameLowerCase.find(search) != std::string::npos)
-          {
-          CodeIdentifier categoryId(categoryCodingSchemeDesignator.asString(), categoryCodeValue.asString(), categoryNameStr);
-          categories.push_back(categoryId);
-          }
-        }
-      else
-        {
-        vtkErrorMacro("FindCategoriesInTerminology: Invalid category '" << categoryName.asString() << "' in terminology '" << terminologyName << "'");
-        }
-      }
-    ++index;
-    }
-
+  this->Internal->FindChildren(terminology->Root, search, categories);
   return true;
 }
 
@@ -1133,15 +1594,15 @@ bool vtkSlicerTerminologiesModuleLogic::GetCategoryInTerminology(std::string ter
     return false;
     }
 
-  Json::Value categoryObject = this->Internal->GetCategoryInTerminology(terminologyName, categoryId);
-  if (categoryObject.isNull())
+  const vtkInternal::CompiledCode* categoryCode = this->Internal->GetCompiledCategory(terminologyName, categoryId);
+  if (!categoryCode)
     {
     vtkErrorMacro("GetCategoryInTerminology: Failed to find category '" << categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
     return false;
     }
 
   // Category found
-  return this->Internal->PopulateTerminologyCategoryFromJson(categoryObject, category);
+  return this->Internal->PopulateTerminologyCategory(*categoryCode, category);
 }
 
 //---------------------------------------------------------------------------
@@ -1156,8 +1617,8 @@ bool vtkSlicerTerminologiesModuleLogic::FindTypesInTerminologyCategory(
 {
   types.clear();
 
-  Json::Value typeArray = this->Internal->GetTypeArrayInTerminologyCategory(terminologyName, categoryId);
-  if (typeArray.isNull())
+  const vtkInternal::CompiledCode* categoryCode = this->Internal->GetCompiledCategory(terminologyName, categoryId);
+  if (!categoryCode || !categoryCode->HasChildArray)
     {
     vtkErrorMacro("FindTypesInTerminologyCategory: Failed to find Type array member in category '"
       << categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
@@ -1167,35 +1628,41 @@ bool vtkSlicerTerminologiesModuleLogic::FindTypesInTerminologyCategory(
   // Make lowercase for case-insensitive comparison
   std::transform(search.begin(), search.end(), search.begin(), ::tolower);
 
-  // Traverse types
-  Json::ArrayIndex index = 0;
-  while (typeArray.isValidIndex(index))
+  this->Internal->FindChildren(*categoryCode, search, types);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerTerminologiesModuleLogic::FindTypesInTerminology(std::string terminologyName,
+  std::vector<CodeIdentifier>& categories, std::vector<CodeIdentifier>& types, std::string search)
+{
+  categories.clear();
+  types.clear();
+
+  const vtkInternal::CompiledContext* terminology = this->Internal->GetCompiledContext(vtkInternal::TerminologyContext, terminologyName);
+  if (!terminology || !terminology->Root.HasChildArray)
+    {
+    vtkErrorMacro("FindTypesInTerminology: Failed to find category array in terminology '" << terminologyName << "'");
+    return false;
+    }
+
+  // Make lowercase for case-insensitive comparison
+  std::transform(search.begin(), search.end(), search.begin(), ::tolower);
+
+  // Search types of all categories
+  std::vector<CodeIdentifier> typesInCategory;
+  std::vector<vtkInternal::CompiledCode>::const_iterator categoryIt;
+  for (categoryIt = terminology->Root.Children.begin(); categoryIt != terminology->Root.Children.end(); ++categoryIt)
     {
-    Json::Value type = typeArray[index];
-    if (type.isObject())
+    if (!categoryIt->Valid)
       {
-      Json::Value typeName = type["CodeMeaning"];
-      Json::Value typeCodingSchemeDesignator = type["CodingSchemeDesignator"];
-      Json::Value typeCodeValue = type["CodeValue"];
-      if (typeName.isString() && typeCodingSchemeDesignator.isString() && typeCodeValue.isString())
-        {
-        // Add type to list if search string is empty or is contained by the current type name
-        std::string typeNameStr = typeName.asString();
-        std::string typeNameLowerCase(typeNameStr);
-        std::transform(typeNameLowerCase.begin(), typeNameLowerCase.end(), typeNameLowerCase.begin(), ::tolower);
-        if (search.empty() || typeNameLowerCase.find(search) != std::string::npos)
-          {
-          CodeIdentifier typeId(typeCodingSchemeDesignator.asString(), typeCodeValue.asString(), typeNameStr);
-          types.push_back(typeId);
-          }
-        }
-      else
-        {
-        vtkErrorMacro("FindTypesInTerminologyCategory: Invalid type '" << typeName.asString() << "in category '"
-          << categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
-        }
+      continue;
       }
-    ++index;
+    typesInCategory.clear();
+    this->Internal->FindChildren(*categoryIt, search, typesInCategory);
+    CodeIdentifier categoryId(categoryIt->CodingSchemeDesignator, categoryIt->CodeValue, categoryIt->CodeMeaning);
+    categories.insert(categories.end(), typesInCategory.size(), categoryId);
+    types.insert(types.end(), typesInCategory.begin(), typesInCategory.end());
     }
 
   return true;
@@ -1210,8 +1677,8 @@ bool vtkSlicerTerminologiesModuleLogic::GetTypeInTerminologyCategory(
     return false;
     }
 
-  Json::Value typeObject = this->Internal->GetTypeInTerminologyCategory(terminologyName, categoryId, typeId);
-  if (typeObject.isNull())
+  const vtkInternal::CompiledCode* typeCode = this->Internal->GetCompiledType(terminologyName, categoryId, typeId);
+  if (!typeCode)
     {
     vtkErrorMacro("GetTypeInTerminologyCategory: Failed to find type '" << typeId.CodeMeaning << "' in category '"
       << categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
@@ -1219,7 +1686,7 @@ bool vtkSlicerTerminologiesModuleLogic::GetTypeInTerminologyCategory(
     }
 
   // Type found
-  return this->Internal->PopulateTerminologyTypeFromJson(typeObject, type);
+  return this->Internal->PopulateTerminologyType(*typeCode, type);
 }
 
 //---------------------------------------------------------------------------
@@ -1228,8 +1695,8 @@ bool vtkSlicerTerminologiesModuleLogic::GetTypeModifiersInTerminologyType(
 {
   typeModifiers.clear();
 
-  Json::Value typeModifierArray = this->Internal->GetTypeModifierArrayInTerminologyType(terminologyName, categoryId, typeId);
-  if (typeModifierArray.isNull())
+  const vtkInternal::CompiledCode* typeCode = this->Internal->GetCompiledType(terminologyName, categoryId, typeId);
+  if (!typeCode || !typeCode->HasChildArray)
     {
     vtkErrorMacro("GetTypeModifiersInTerminologyType: Failed to find Type Modifier array member in type '" << typeId.CodeMeaning << "' in category "
       << categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
@@ -1237,24 +1704,7 @@ bool vtkSlicerTerminologiesModuleLogic::GetTypeModifiersInTerminologyType(
     }
 
   // Collect type modifiers
-  Json::ArrayIndex index = 0;
-  while (typeModifierArray.isValidIndex(index))
-    {
-    Json::Value typeModifier = typeModifierArray[index];
-    if (typeModifier.isObject())
-      {
-      Json::Value typeModifierName = typeModifier["CodeMeaning"];
-      Json::Value typeModifierCodingSchemeDesignator = typeModifier["CodingSchemeDesignator"];
-      Json::Value typeModifierCodeValue = typeModifier["CodeValue"];
-      if (typeModifierName.isString() && typeModifierCodingSchemeDesignator.isString() && typeModifierCodeValue.isString())
-        {
-          CodeIdentifier typeModifierId(typeModifierCodingSchemeDesignator.asString(), typeModifierCodeValue.asString(), typeModifierName.asString());
-          typeModifiers.push_back(typeModifierId);
-        }
-      }
-    ++index;
-    } // For each type index
-
+  this->Internal->FindChildren(*typeCode, "", typeModifiers);
   return true;
 }
 
@@ -1267,8 +1717,9 @@ bool vtkSlicerTerminologiesModuleLogic::GetTypeModifierInTerminologyType(
     return false;
     }
 
-  Json::Value typeModifierObject = this->Internal->GetTypeModifierInTerminologyType(terminologyName, categoryId, typeId, modifierId);
-  if (typeModifierObject.isNull())
+  const vtkInternal::CompiledCode* typeCode = this->Internal->GetCompiledType(terminologyName, categoryId, typeId);
+  const vtkInternal::CompiledCode* typeModifierCode = (typeCode ? typeCode->FindChild(modifierId) : NULL);
+  if (!typeModifierCode)
     {
     vtkErrorMacro("GetTypeModifierInTerminologyType: Failed to find type modifier '" << modifierId.CodeMeaning << "' in type '"
       << typeId.CodeMeaning << "' in category '" << categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
@@ -1276,7 +1727,7 @@ bool vtkSlicerTerminologiesModuleLogic::GetTypeModifierInTerminologyType(
     }
 
   // Type modifier with specified name found
-  return this->Internal->PopulateTerminologyTypeFromJson(typeModifierObject, typeModifier);
+  return this->Internal->PopulateTerminologyType(*typeModifierCode, typeModifier);
 }
 
 //---------------------------------------------------------------------------
@@ -1290,8 +1741,8 @@ bool vtkSlicerTerminologiesModuleLogic::FindRegionsInAnatomicContext(std::string
 {
   regions.clear();
 
-  Json::Value regionArray = this->Internal->GetRegionArrayInAnatomicContext(anatomicContextName);
-  if (regionArray.isNull())
+  const vtkInternal::CompiledContext* anatomicContext = this->Internal->GetCompiledContext(vtkInternal::AnatomicContext, anatomicContextName);
+  if (!anatomicContext || !anatomicContext->Root.HasChildArray)
     {
     vtkErrorMacro("FindRegionsInAnatomicContext: Failed to find region array member in anatomic context '" << anatomicContextName << "'");
     return false;
@@ -1300,36 +1751,7 @@ bool vtkSlicerTerminologiesModuleLogic::FindRegionsInAnatomicContext(std::string
   // Make lowercase for case-insensitive comparison
   std::transform(search.begin(), search.end(), search.begin(), ::tolower);
 
-  // Traverse regions
-  Json::ArrayIndex index = 0;
-  while (regionArray.isValidIndex(index))
-    {
-    Json::Value region = regionArray[index];
-    if (region.isObject())
-      {
-      Json::Value regionName = region["CodeMeaning"];
-      Json::Value regionCodingSchemeDesignator = region["CodingSchemeDesignator"];
-      Json::Value regionCodeValue = region["CodeValue"];
-      if (regionName.isString() && regionCodingSchemeDesignator.isString() && regionCodeValue.isString())
-        {
-        // Add region name to list if search string is empty or is contained by the current region name
-        std::string regionNameStr = regionName.asString();
-        std::string regionNameLowerCase(regionNameStr);
-        std::transform(regionNameLowerCase.begin(), regionNameLowerCase.end(), regionNameLowerCase.begin(), ::tolower);
-        if (search.empty() || regionNameLowerCase.find(search) != std::string::npos)
-          {
-          CodeIdentifier regionId(regionCodingSchemeDesignator.asString(), regionCodeValue.asString(), regionNameStr);
-          regions.push_back(regionId);
-          }
-        }
-      else
-        {
-        vtkErrorMacro("FindRegionsInAnatomicContext: Invalid region '" << regionName.asString() << "' in anatomic context '" << anatomicContextName << "'");
-        }
-      }
-    ++index;
-    }
-
+  this->Internal->FindChildren(anatomicContext->Root, search, regions);
   return true;
 }
 
@@ -1341,15 +1763,15 @@ bool vtkSlicerTerminologiesModuleLogic::GetRegionInAnatomicContext(std::string a
     return false;
     }
 
-  Json::Value regionObject = this->Internal->GetRegionInAnatomicContext(anatomicContextName, regionId);
-  if (regionObject.isNull())
+  const vtkInternal::CompiledCode* regionCode = this->Internal->GetCompiledRegion(anatomicContextName, regionId);
+  if (!regionCode)
     {
     vtkErrorMacro("GetRegionInAnatomicContext: Failed to find region '" << regionId.CodeMeaning << "' in anatomic context '" << anatomicContextName << "'");
     return false;
     }
 
   // Region with specified name found
-  return this->Internal->PopulateRegionFromJson(regionObject, region);
+  return this->Internal->PopulateTerminologyType(*regionCode, region);
 }
 
 //---------------------------------------------------------------------------
@@ -1358,8 +1780,8 @@ bool vtkSlicerTerminologiesModuleLogic::GetRegionModifiersInAnatomicRegion(
 {
   regionModifiers.clear();
 
-  Json::Value regionModifierArray = this->Internal->GetRegionModifierArrayInRegion(anatomicContextName, regionId);
-  if (regionModifierArray.isNull())
+  const vtkInternal::CompiledCode* regionCode = this->Internal->GetCompiledRegion(anatomicContextName, regionId);
+  if (!regionCode || !regionCode->HasChildArray)
     {
     vtkErrorMacro("GetRegionModifiersInRegion: Failed to find Region Modifier array member in region '"
       << regionId.CodeMeaning << "' in anatomic context '" << anatomicContextName << "'");
@@ -1367,24 +1789,7 @@ bool vtkSlicerTerminologiesModuleLogic::GetRegionModifiersInAnatomicRegion(
     }
 
   // Collect region modifiers
-  Json::ArrayIndex index = 0;
-  while (regionModifierArray.isValidIndex(index))
-    {
-    Json::Value regionModifier = regionModifierArray[index];
-    if (regionModifier.isObject())
-      {
-      Json::Value regionModifierName = regionModifier["CodeMeaning"];
-      Json::Value regionModifierCodingSchemeDesignator = regionModifier["CodingSchemeDesignator"];
-      Json::Value regionModifierCodeValue = regionModifier["CodeValue"];
-      if (regionModifierName.isString() && regionModifierCodingSchemeDesignator.isString() && regionModifierCodeValue.isString())
-        {
-          CodeIdentifier regionModifierId(regionModifierCodingSchemeDesignator.asString(), regionModifierCodeValue.asString(), regionModifierName.asString());
-          regionModifiers.push_back(regionModifierId);
-        }
-      }
-    ++index;
-    } // For each region index
-
+  this->Internal->FindChildren(*regionCode, "", regionModifiers);
   return true;
 }
 
@@ -1397,8 +1802,9 @@ bool vtkSlicerTerminologiesModuleLogic::GetRegionModifierInAnatomicRegion(std::s
     return false;
     }
 
-  Json::Value regionModifierObject = this->Internal->GetRegionModifierInRegion(anatomicContextName, regionId, modifierId);
-  if (regionModifierObject.isNull())
+  const vtkInternal::CompiledCode* regionCode = this->Internal->GetCompiledRegion(anatomicContextName, regionId);
+  const vtkInternal::CompiledCode* regionModifierCode = (regionCode ? regionCode->FindChild(modifierId) : NULL);
+  if (!regionModifierCode)
     {
     vtkErrorMacro("GetRegionModifierInAnatomicRegion: Failed to find region modifier '" << modifierId.CodeMeaning
       << "' in region '" << regionId.CodeMeaning << "' in anatomic context '" << anatomicContextName << "'");
@@ -1406,7 +1812,7 @@ bool vtkSlicerTerminologiesModuleLogic::GetRegionModifierInAnatomicRegion(std::s
     }
 
   // Region modifier with specified name found
-  return this->Internal->PopulateTerminologyTypeFromJson(regionModifierObject, regionModifier);
+  return this->Internal->PopulateTerminologyType(*regionModifierCode, regionModifier);
 }
 
 //---------------------------------------------------------------------------
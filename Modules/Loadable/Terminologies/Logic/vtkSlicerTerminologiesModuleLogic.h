@@ -58,6 +58,15 @@ public:
       std::string CodeMeaning; // Human readable name (not required for ID)
     };
 
+  /// Directory where the compiled form of the terminology and anatomic context files is cached.
+  /// Loaded JSON files are compiled into an indexed structure that is used for all lookups.
+  /// If a cache directory is set, then the compiled form is saved there, and loading a file
+  /// that has not changed since it was compiled reads the compiled form instead of parsing the JSON.
+  /// If not set, then the TerminologyCache folder in the application temporary folder is used
+  /// when the scene is set. Caching is disabled if empty.
+  void SetCacheDirectory(std::string cacheDirectory);
+  std::string GetCacheDirectory();
+
   /// Load terminology dictionary from JSON terminology context file into \sa LoadedTerminologies.
   /// \param filePath File containing the terminology to load
   /// \return Context name (SegmentationCategoryTypeContextName) of the loaded terminology. Empty string on failure.
@@ -111,6 +120,12 @@ public:
   ///   from the types found in the given terminology category
   /// \return Success flag
   bool FindTypesInTerminologyCategory(std::string terminologyName, CodeIdentifier categoryId, std::vector<CodeIdentifier>& types, std::string search);
+  /// Find types in all categories of a terminology whose name (codeMeaning) contains a given string
+  /// \param categories Output argument containing the category of each found type (same size as types)
+  /// \param types Output argument containing the found types
+  /// \return Success flag
+  bool FindTypesInTerminology(std::string terminologyName,
+    std::vector<CodeIdentifier>& categories, std::vector<CodeIdentifier>& types, std::string search);
   /// Get a type with given name from a terminology category
   /// \param type Output argument containing the details of the found type if any (if return value is true)
   /// \return Success flag
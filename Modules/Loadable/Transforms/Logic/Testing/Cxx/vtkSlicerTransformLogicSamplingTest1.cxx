@@ -0,0 +1,234 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// Logic includes
+#include "vtkSlicerTransformLogic.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLLinearTransformNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkGeneralTransform.h>
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <cmath>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Records the progress values reported by the logic and optionally requests abort
+struct ProgressRecorder
+{
+  ProgressRecorder() : RequestAbort(false) {}
+  std::vector<double> ProgressValues;
+  bool RequestAbort;
+};
+
+//----------------------------------------------------------------------------
+void ProgressCallback(vtkObject* caller, unsigned long vtkNotUsed(eid), void* clientData, void* callData)
+{
+  ProgressRecorder* recorder = static_cast<ProgressRecorder*>(clientData);
+  recorder->ProgressValues.push_back(*static_cast<double*>(callData));
+  if (recorder->RequestAbort)
+    {
+    vtkSlicerTransformLogic::SafeDownCast(caller)->SetAbortSampling(true);
+    }
+}
+
+//----------------------------------------------------------------------------
+int CheckCompleteProgress(const ProgressRecorder& recorder)
+{
+  CHECK_BOOL(recorder.ProgressValues.size() >= 2, true);
+  CHECK_DOUBLE(recorder.ProgressValues.front(), 0.0);
+  CHECK_DOUBLE(recorder.ProgressValues.back(), 1.0);
+  for (size_t i = 1; i < recorder.ProgressValues.size(); i++)
+    {
+    CHECK_BOOL(recorder.ProgressValues[i] >= recorder.ProgressValues[i - 1], true);
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+/// Scaling and translation, so that the displacement is different at each position
+void CreateTransformNode(vtkMRMLScene* scene, vtkMRMLLinearTransformNode* transformNode)
+{
+  vtkNew<vtkMatrix4x4> matrix;
+  for (int i = 0; i < 3; i++)
+    {
+    matrix->SetElement(i, i, 1.1);
+    matrix->SetElement(i, 3, i + 1.0);
+    }
+  transformNode->SetMatrixTransformToParent(matrix.GetPointer());
+  transformNode->SetName("Transform");
+  scene->AddNode(transformNode);
+}
+
+//----------------------------------------------------------------------------
+void CreateReferenceVolumeNode(vtkMRMLScene* scene, vtkMRMLScalarVolumeNode* volumeNode)
+{
+  vtkNew<vtkImageData> image;
+  image->SetExtent(0, 19, 0, 14, 0, 9);
+  image->AllocateScalars(VTK_SHORT, 1);
+  volumeNode->SetAndObserveImageData(image.GetPointer());
+  volumeNode->SetOrigin(-10.0, 5.0, 2.0);
+  volumeNode->SetSpacing(1.5, 2.0, 2.5);
+  scene->AddNode(volumeNode);
+}
+
+//----------------------------------------------------------------------------
+void GetVoxelPosition(vtkMRMLScalarVolumeNode* volumeNode, int i, int j, int k, double position_RAS[3])
+{
+  vtkNew<vtkMatrix4x4> ijkToRAS;
+  volumeNode->GetIJKToRASMatrix(ijkToRAS.GetPointer());
+  double position_IJK[4] = { static_cast<double>(i), static_cast<double>(j), static_cast<double>(k), 1.0 };
+  double position[4] = { 0.0, 0.0, 0.0, 1.0 };
+  ijkToRAS->MultiplyPoint(position_IJK, position);
+  for (int c = 0; c < 3; c++)
+    {
+    position_RAS[c] = position[c];
+    }
+}
+
+//----------------------------------------------------------------------------
+int TestDisplacementVolume()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerTransformLogic> logic;
+  logic->SetMRMLScene(scene.GetPointer());
+  vtkNew<vtkMRMLLinearTransformNode> transformNode;
+  CreateTransformNode(scene.GetPointer(), transformNode.GetPointer());
+  vtkNew<vtkMRMLScalarVolumeNode> referenceVolumeNode;
+  CreateReferenceVolumeNode(scene.GetPointer(), referenceVolumeNode.GetPointer());
+
+  ProgressRecorder recorder;
+  vtkNew<vtkCallbackCommand> progressCommand;
+  progressCommand->SetCallback(ProgressCallback);
+  progressCommand->SetClientData(&recorder);
+  logic->AddObserver(vtkCommand::ProgressEvent, progressCommand.GetPointer());
+
+  // Aborted computation does not leave a volume in the scene
+  int numberOfVolumeNodes = scene->GetNumberOfNodesByClass("vtkMRMLScalarVolumeNode");
+  recorder.RequestAbort = true;
+  TESTING_OUTPUT_ASSERT_WARNINGS_BEGIN();
+  vtkMRMLVolumeNode* displacementVolumeNode = logic->CreateDisplacementVolumeFromTransform(
+    transformNode.GetPointer(), referenceVolumeNode.GetPointer(), false);
+  TESTING_OUTPUT_ASSERT_WARNINGS_END();
+  CHECK_NULL(displacementVolumeNode);
+  CHECK_BOOL(recorder.ProgressValues.back() < 1.0, true);
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLScalarVolumeNode"), numberOfVolumeNodes);
+
+  // The abort flag is reset when a new computation is started
+  recorder.RequestAbort = false;
+  recorder.ProgressValues.clear();
+  displacementVolumeNode = logic->CreateDisplacementVolumeFromTransform(
+    transformNode.GetPointer(), referenceVolumeNode.GetPointer(), false);
+  CHECK_NOT_NULL(displacementVolumeNode);
+  CHECK_EXIT_SUCCESS(CheckCompleteProgress(recorder));
+
+  // Voxels contain the displacement vectors
+  vtkImageData* displacementImage = displacementVolumeNode->GetImageData();
+  CHECK_INT(displacementImage->GetNumberOfScalarComponents(), 3);
+  vtkNew<vtkMatrix4x4> transformToWorld;
+  transformNode->GetMatrixTransformToWorld(transformToWorld.GetPointer());
+  int voxels[3][3] = { { 0, 0, 0 }, { 19, 14, 9 }, { 7, 3, 5 } };
+  for (int voxelIndex = 0; voxelIndex < 3; voxelIndex++)
+    {
+    int* ijk = voxels[voxelIndex];
+    double position_RAS[4] = { 0.0, 0.0, 0.0, 1.0 };
+    GetVoxelPosition(referenceVolumeNode.GetPointer(), ijk[0], ijk[1], ijk[2], position_RAS);
+    double transformedPosition_RAS[4] = { 0.0, 0.0, 0.0, 1.0 };
+    transformToWorld->MultiplyPoint(position_RAS, transformedPosition_RAS);
+    for (int c = 0; c < 3; c++)
+      {
+      double displacement = displacementImage->GetScalarComponentAsDouble(ijk[0], ijk[1], ijk[2], c);
+      CHECK_BOOL(fabs(displacement - (transformedPosition_RAS[c] - position_RAS[c])) < 1e-3, true);
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestGridTransform()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerTransformLogic> logic;
+  logic->SetMRMLScene(scene.GetPointer());
+  vtkNew<vtkMRMLLinearTransformNode> transformNode;
+  CreateTransformNode(scene.GetPointer(), transformNode.GetPointer());
+  vtkNew<vtkMRMLScalarVolumeNode> referenceVolumeNode;
+  CreateReferenceVolumeNode(scene.GetPointer(), referenceVolumeNode.GetPointer());
+
+  ProgressRecorder recorder;
+  vtkNew<vtkCallbackCommand> progressCommand;
+  progressCommand->SetCallback(ProgressCallback);
+  progressCommand->SetClientData(&recorder);
+  logic->AddObserver(vtkCommand::ProgressEvent, progressCommand.GetPointer());
+
+  // Aborted conversion does not leave a transform in the scene
+  int numberOfTransformNodes = scene->GetNumberOfNodesByClass("vtkMRMLTransformNode");
+  recorder.RequestAbort = true;
+  TESTING_OUTPUT_ASSERT_WARNINGS_BEGIN();
+  vtkMRMLTransformNode* gridTransformNode = logic->ConvertToGridTransform(
+    transformNode.GetPointer(), referenceVolumeNode.GetPointer());
+  TESTING_OUTPUT_ASSERT_WARNINGS_END();
+  CHECK_NULL(gridTransformNode);
+  CHECK_BOOL(recorder.ProgressValues.back() < 1.0, true);
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLTransformNode"), numberOfTransformNodes);
+
+  recorder.RequestAbort = false;
+  recorder.ProgressValues.clear();
+  gridTransformNode = logic->ConvertToGridTransform(transformNode.GetPointer(), referenceVolumeNode.GetPointer());
+  CHECK_NOT_NULL(gridTransformNode);
+  CHECK_EXIT_SUCCESS(CheckCompleteProgress(recorder));
+
+  // The grid transform matches the original transform at the grid points
+  vtkNew<vtkGeneralTransform> transformFromWorld;
+  transformNode->GetTransformFromWorld(transformFromWorld.GetPointer());
+  vtkNew<vtkGeneralTransform> gridTransformFromWorld;
+  gridTransformNode->GetTransformFromWorld(gridTransformFromWorld.GetPointer());
+  int voxels[3][3] = { { 0, 0, 0 }, { 19, 14, 9 }, { 7, 3, 5 } };
+  for (int voxelIndex = 0; voxelIndex < 3; voxelIndex++)
+    {
+    int* ijk = voxels[voxelIndex];
+    double position_RAS[3] = { 0.0, 0.0, 0.0 };
+    GetVoxelPosition(referenceVolumeNode.GetPointer(), ijk[0], ijk[1], ijk[2], position_RAS);
+    double expectedPosition[3] = { 0.0, 0.0, 0.0 };
+    transformFromWorld->TransformPoint(position_RAS, expectedPosition);
+    double gridPosition[3] = { 0.0, 0.0, 0.0 };
+    gridTransformFromWorld->TransformPoint(position_RAS, gridPosition);
+    for (int c = 0; c < 3; c++)
+      {
+      CHECK_BOOL(fabs(gridPosition[c] - expectedPosition[c]) < 1e-3, true);
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerTransformLogicSamplingTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestDisplacementVolume());
+  CHECK_EXIT_SUCCESS(TestGridTransform());
+  return EXIT_SUCCESS;
+}
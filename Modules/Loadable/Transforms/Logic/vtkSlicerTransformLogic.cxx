@@ -32,6 +32,7 @@ or http://www.slicer.org/copyright/copyright.txt for details.
 // VTK includes
 #include <vtkAppendPolyData.h>
 #include <vtkCollection.h>
+#include <vtkCommand.h>
 #include <vtkArrowSource.h>
 #include <vtkConeSource.h>
 #include <vtkContourFilter.h>
@@ -43,6 +44,7 @@ or http://www.slicer.org/copyright/copyright.txt for details.
 #include <vtkLine.h>
 #include <vtkLookupTable.h>
 #include <vtkMath.h>
+#include <vtkMultiThreader.h>
 #include <vtkTransform.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
@@ -76,10 +78,237 @@ or http://www.slicer.org/copyright/copyright.txt for details.
 #include "itkTranslationTransform.h"
 #include "itkTransformFactory.h"
 
+// STD includes
+#include <vector>
+
 vtkStandardNewMacro(vtkSlicerTransformLogic);
 
+//----------------------------------------------------------------------------
+// Evaluates a transform at many sample positions on multiple threads.
+// The samples are split into contiguous ranges (image rows or point ranges),
+// each processed by a separate thread using its own copy of the transform.
+// Progress is reported and abort is checked in the first thread, which is
+// the calling thread.
+class vtkSlicerTransformSampler
+{
+public:
+  vtkSlicerTransformSampler(vtkAbstractTransform* transform, vtkSlicerTransformLogic* progressLogic)
+    : Transform(transform)
+    , ProgressLogic(progressLogic)
+    , NumberOfWorkItems(0)
+    , Aborted(false)
+    , OutputImage(NULL)
+    , Magnitude(false)
+    , SamplePositions(NULL)
+    , OutputVectors(NULL)
+  {
+  }
+
+  // Fill an image (float scalars, 1 component for magnitude, 3 components for vectors)
+  // with displacements sampled at the voxel positions defined by ijkToRAS.
+  bool SampleImage(vtkImageData* outputImage, vtkMatrix4x4* ijkToRAS, bool magnitude)
+  {
+    this->OutputImage = outputImage;
+    this->Magnitude = magnitude;
+    for (int row = 0; row < 4; row++)
+      {
+      for (int col = 0; col < 4; col++)
+        {
+        this->IJKToRAS[row][col] = ijkToRAS->GetElement(row, col);
+        }
+      }
+    outputImage->AllocateScalars(VTK_FLOAT, magnitude ? 1 : 3);
+    int* extent = outputImage->GetExtent();
+    vtkIdType numberOfRows = 0;
+    if (extent[0] <= extent[1] && extent[2] <= extent[3] && extent[4] <= extent[5])
+      {
+      numberOfRows = static_cast<vtkIdType>(extent[3] - extent[2] + 1) * (extent[5] - extent[4] + 1);
+      }
+    return this->Execute(numberOfRows);
+  }
+
+  // Compute displacement vectors at sample points.
+  bool SamplePointSet(vtkPoints* samplePoints, vtkDoubleArray* outputVectors)
+  {
+    this->SamplePositions = samplePoints;
+    this->OutputVectors = outputVectors;
+    return this->Execute(samplePoints->GetNumberOfPoints());
+  }
+
+protected:
+  bool Execute(vtkIdType numberOfWorkItems)
+  {
+    this->Aborted = false;
+    this->NumberOfWorkItems = numberOfWorkItems;
+    if (numberOfWorkItems == 0)
+      {
+      return true;
+      }
+    this->Transform->Update();
+
+    vtkNew<vtkMultiThreader> threader;
+    int numberOfThreads = threader->GetNumberOfThreads();
+    // Avoid the overhead of copying the transform for small inputs
+    const vtkIdType minimumNumberOfWorkItemsPerThread = 16;
+    if (numberOfWorkItems / minimumNumberOfWorkItemsPerThread < numberOfThreads)
+      {
+      numberOfThreads = static_cast<int>(numberOfWorkItems / minimumNumberOfWorkItemsPerThread);
+      }
+    if (numberOfThreads < 1)
+      {
+      numberOfThreads = 1;
+      }
+
+    // Evaluating a transform is thread-safe, but it locks the transform at each call,
+    // therefore each thread gets its own copy (the first thread uses the original).
+    this->ThreadTransforms.clear();
+    this->ThreadTransforms.push_back(this->Transform);
+    for (int threadIndex = 1; threadIndex < numberOfThreads; threadIndex++)
+      {
+      vtkSmartPointer<vtkAbstractTransform> transformCopy = vtkSmartPointer<vtkAbstractTransform>::Take(this->Transform->MakeTransform());
+      transformCopy->DeepCopy(this->Transform);
+      transformCopy->Update();
+      this->ThreadTransforms.push_back(transformCopy);
+      }
+
+    this->ReportProgress(0.0);
+    threader->SetNumberOfThreads(numberOfThreads);
+    threader->SetSingleMethod(vtkSlicerTransformSampler::ThreadFunction, this);
+    threader->SingleMethodExecute();
+    this->ThreadTransforms.clear();
+    if (!this->Aborted)
+      {
+      this->ReportProgress(1.0);
+      }
+    return !this->Aborted;
+  }
+
+  static VTK_THREAD_RETURN_TYPE ThreadFunction(void *arg)
+  {
+    vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+    vtkSlicerTransformSampler* self = static_cast<vtkSlicerTransformSampler*>(info->UserData);
+    int threadIndex = info->ThreadID;
+    int numberOfThreads = info->NumberOfThreads;
+    vtkIdType begin = self->NumberOfWorkItems * threadIndex / numberOfThreads;
+    vtkIdType end = self->NumberOfWorkItems * (threadIndex + 1) / numberOfThreads;
+    vtkAbstractTransform* transform = self->ThreadTransforms[threadIndex];
+
+    // Only the first thread reports progress, in about 100 steps
+    bool reportProgress = (threadIndex == 0 && self->ProgressLogic != NULL);
+    vtkIdType progressStep = (end - begin) / 100 + 1;
+
+    // Process work items in blocks so that abort can be checked and progress can be reported
+    for (vtkIdType blockBegin = begin; blockBegin < end; blockBegin += progressStep)
+      {
+      if (self->Aborted)
+        {
+        break;
+        }
+      vtkIdType blockEnd = (blockBegin + progressStep < end ? blockBegin + progressStep : end);
+      if (self->OutputImage)
+        {
+        self->SampleImageRowRange(transform, blockBegin, blockEnd);
+        }
+      else
+        {
+        self->SamplePointRange(transform, blockBegin, blockEnd);
+        }
+      if (reportProgress)
+        {
+        self->ReportProgress(static_cast<double>(blockEnd - begin) / (end - begin));
+        if (self->ProgressLogic->GetAbortSampling())
+          {
+          self->Aborted = true;
+          }
+        }
+      }
+    return VTK_THREAD_RETURN_VALUE;
+  }
+
+  void SampleImageRowRange(vtkAbstractTransform* transform, vtkIdType beginRow, vtkIdType endRow)
+  {
+    int* extent = this->OutputImage->GetExtent();
+    int numberOfRowsPerSlice = extent[3] - extent[2] + 1;
+    int numberOfComponents = (this->Magnitude ? 1 : 3);
+    vtkIdType rowSize = static_cast<vtkIdType>(extent[1] - extent[0] + 1) * numberOfComponents;
+    float* voxelPtr = static_cast<float*>(this->OutputImage->GetScalarPointer()) + beginRow * rowSize;
+    double point_IJK[3] = { 0, 0, 0 };
+    double point_RAS[3] = { 0, 0, 0 };
+    double transformedPoint_RAS[3] = { 0, 0, 0 };
+    for (vtkIdType row = beginRow; row < endRow; row++)
+      {
+      point_IJK[1] = extent[2] + static_cast<int>(row % numberOfRowsPerSlice);
+      point_IJK[2] = extent[4] + static_cast<int>(row / numberOfRowsPerSlice);
+      for (int i = extent[0]; i <= extent[1]; i++)
+        {
+        point_IJK[0] = i;
+        for (int r = 0; r < 3; r++)
+          {
+          point_RAS[r] = this->IJKToRAS[r][0] * point_IJK[0] + this->IJKToRAS[r][1] * point_IJK[1]
+            + this->IJKToRAS[r][2] * point_IJK[2] + this->IJKToRAS[r][3];
+          }
+
+        transform->InternalTransformPoint(point_RAS, transformedPoint_RAS);
+
+        double dx = transformedPoint_RAS[0] - point_RAS[0];
+        double dy = transformedPoint_RAS[1] - point_RAS[1];
+        double dz = transformedPoint_RAS[2] - point_RAS[2];
+        if (this->Magnitude)
+          {
+          *(voxelPtr++) = static_cast<float>(sqrt(dx * dx + dy * dy + dz * dz));
+          }
+        else
+          {
+          *(voxelPtr++) = static_cast<float>(dx);
+          *(voxelPtr++) = static_cast<float>(dy);
+          *(voxelPtr++) = static_cast<float>(dz);
+          }
+        }
+      }
+  }
+
+  void SamplePointRange(vtkAbstractTransform* transform, vtkIdType beginPoint, vtkIdType endPoint)
+  {
+    double point_RAS[3] = { 0, 0, 0 };
+    double transformedPoint_RAS[3] = { 0, 0, 0 };
+    for (vtkIdType pointIndex = beginPoint; pointIndex < endPoint; pointIndex++)
+      {
+      this->SamplePositions->GetPoint(pointIndex, point_RAS);
+      transform->InternalTransformPoint(point_RAS, transformedPoint_RAS);
+      this->OutputVectors->SetTuple3(pointIndex,
+        transformedPoint_RAS[0] - point_RAS[0],
+        transformedPoint_RAS[1] - point_RAS[1],
+        transformedPoint_RAS[2] - point_RAS[2]);
+      }
+  }
+
+  void ReportProgress(double progress)
+  {
+    if (this->ProgressLogic)
+      {
+      this->ProgressLogic->InvokeEvent(vtkCommand::ProgressEvent, &progress);
+      }
+  }
+
+  vtkAbstractTransform* Transform;
+  vtkSlicerTransformLogic* ProgressLogic;
+  std::vector< vtkSmartPointer<vtkAbstractTransform> > ThreadTransforms;
+  vtkIdType NumberOfWorkItems;
+  volatile bool Aborted;
+
+  // Image sampling
+  vtkImageData* OutputImage;
+  double IJKToRAS[4][4];
+  bool Magnitude;
+
+  // Point sampling
+  vtkPoints* SamplePositions;
+  vtkDoubleArray* OutputVectors;
+};
+
 //----------------------------------------------------------------------------
 vtkSlicerTransformLogic::vtkSlicerTransformLogic()
+  : AbortSampling(false)
 {
 }
 
@@ -209,21 +438,11 @@ void vtkSlicerTransformLogic::GetTransformedPointSamples(vtkPointSet* outputPoin
   vtkMRMLTransformNode* inputTransformNode, vtkMatrix4x4* gridToRAS, int* gridSize,
   bool transformToWorld /* = true */)
 {
-  vtkNew<vtkGeneralTransform> inputTransform;
-  if (transformToWorld)
-  {
-    inputTransformNode->GetTransformToWorld(inputTransform.GetPointer());
-  }
-  else
-  {
-    inputTransformNode->GetTransformFromWorld(inputTransform.GetPointer());
-  }
   // Generate sample point set on a grid
   vtkNew<vtkPoints> samplePositions_RAS;
   int numOfSamples = gridSize[0] * gridSize[1] * gridSize[2];
   samplePositions_RAS->SetNumberOfPoints(numOfSamples);
   double point_RAS[4] = { 0, 0, 0, 1 };
-  double transformedPoint_RAS[4] = { 0, 0, 0, 1 };
   double point_Grid[4] = { 0, 0, 0, 1 };
   int sampleIndex = 0;
   for (point_Grid[2] = 0; point_Grid[2]<gridSize[2]; point_Grid[2]++)
@@ -233,13 +452,13 @@ void vtkSlicerTransformLogic::GetTransformedPointSamples(vtkPointSet* outputPoin
       for (point_Grid[0] = 0; point_Grid[0]<gridSize[0]; point_Grid[0]++)
         {
         gridToRAS->MultiplyPoint(point_Grid, point_RAS);
-        inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
         samplePositions_RAS->SetPoint(sampleIndex, point_RAS[0], point_RAS[1], point_RAS[2]);
         sampleIndex++;
         }
       }
    }
 
+  // Displacements are computed for all the points at once
   vtkSlicerTransformLogic::GetTransformedPointSamples(outputPointSet, inputTransformNode, samplePositions_RAS.GetPointer(), transformToWorld);
 }
 
@@ -271,20 +490,8 @@ void vtkSlicerTransformLogic::GetTransformedPointSamples(vtkPointSet* outputPoin
     inputTransformNode->GetTransformFromWorld(inputTransform.GetPointer());
     }
 
-  double transformedPoint_RAS[4] = { 0, 0, 0, 1 };
-  double pointDislocationVector_RAS[4] = { 0, 0, 0, 1 };
-  for (int sampleIndex = 0; sampleIndex < numOfSamples; sampleIndex++)
-    {
-    double* point_RAS = samplePositions_RAS->GetPoint(sampleIndex);
-
-    inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
-
-    pointDislocationVector_RAS[0] = transformedPoint_RAS[0] - point_RAS[0];
-    pointDislocationVector_RAS[1] = transformedPoint_RAS[1] - point_RAS[1];
-    pointDislocationVector_RAS[2] = transformedPoint_RAS[2] - point_RAS[2];
-
-    sampleVectors_RAS->SetTuple3(sampleIndex, pointDislocationVector_RAS[0], pointDislocationVector_RAS[1], pointDislocationVector_RAS[2]);
-    }
+  vtkSlicerTransformSampler sampler(inputTransform.GetPointer(), NULL);
+  sampler.SamplePointSet(samplePositions_RAS, sampleVectors_RAS.GetPointer());
 
   outputPointSet->SetPoints(samplePositions_RAS);
   vtkPointData* pointData = outputPointSet->GetPointData();
@@ -392,53 +599,8 @@ bool vtkSlicerTransformLogic::GetTransformedPointSamplesAsMagnitudeImage(vtkImag
     vtkGenericWarningMacro("vtkSlicerTransformLogic::GetTransformedPointSamplesAsMagnitudeImage failed: invalid input");
     return false;
   }
-
-  vtkNew<vtkGeneralTransform> inputTransform;
-  if (transformToWorld)
-  {
-    inputTransformNode->GetTransformToWorld(inputTransform.GetPointer());
-  }
-  else
-  {
-    inputTransformNode->GetTransformFromWorld(inputTransform.GetPointer());
-  }
-
-  // The orientation of the volume cannot be set in the image
-  // therefore the volume will not appear in the correct position
-  // if the direction matrix is not identity.
-  magnitudeImage->AllocateScalars(VTK_FLOAT, 1);
-
-  double point_RAS[4] = { 0, 0, 0, 1 };
-  double transformedPoint_RAS[4] = { 0, 0, 0, 1 };
-  double pointDislocationVector_RAS[4] = { 0, 0, 0, 1 };
-  double point_IJK[4] = { 0, 0, 0, 1 };
-  float* voxelPtr = static_cast<float*>(magnitudeImage->GetScalarPointer());
-  int* extent = magnitudeImage->GetExtent();
-  for (point_IJK[2] = extent[4]; point_IJK[2] <= extent[5]; point_IJK[2]++)
-  {
-    for (point_IJK[1] = extent[2]; point_IJK[1] <= extent[3]; point_IJK[1]++)
-    {
-      for (point_IJK[0] = extent[0]; point_IJK[0] <= extent[1]; point_IJK[0]++)
-      {
-        ijkToRAS->MultiplyPoint(point_IJK, point_RAS);
-
-        inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
-
-        pointDislocationVector_RAS[0] = transformedPoint_RAS[0] - point_RAS[0];
-        pointDislocationVector_RAS[1] = transformedPoint_RAS[1] - point_RAS[1];
-        pointDislocationVector_RAS[2] = transformedPoint_RAS[2] - point_RAS[2];
-
-        float mag = sqrt(
-          pointDislocationVector_RAS[0] * pointDislocationVector_RAS[0] +
-          pointDislocationVector_RAS[1] * pointDislocationVector_RAS[1] +
-          pointDislocationVector_RAS[2] * pointDislocationVector_RAS[2]);
-
-        *(voxelPtr++) = mag;
-      }
-    }
-  }
-
-  return true;
+  return vtkSlicerTransformLogic::GetTransformedPointSamplesAsImage(magnitudeImage, inputTransformNode, ijkToRAS,
+    transformToWorld, true /* magnitude */, NULL);
 }
 
 //----------------------------------------------------------------------------
@@ -521,14 +683,18 @@ vtkMRMLVolumeNode* vtkSlicerTransformLogic::CreateDisplacementVolumeFromTransfor
   }
 
   // Fill the volume
-  if (magnitude)
+  this->AbortSampling = false;
+  if (!vtkSlicerTransformLogic::GetTransformedPointSamplesAsImage(outputVolume, inputTransformNode, ijkToRas.GetPointer(),
+    true /* transform to world */, magnitude, this))
   {
-    vtkSlicerTransformLogic::GetTransformedPointSamplesAsMagnitudeImage(outputVolume, inputTransformNode, ijkToRas.GetPointer());
-  }
-  else
-  {
-    vtkSlicerTransformLogic::GetTransformedPointSamplesAsVectorImage(outputVolume, inputTransformNode, ijkToRas.GetPointer());
+    vtkWarningMacro("vtkSlicerTransformLogic::CreateDisplacementVolumeFromTransform: computation aborted");
+    if (existingOutputVolumeNode == NULL)
+    {
+      scene->RemoveNode(outputVolumeNode);
+    }
+    return NULL;
   }
+  outputVolume->Modified();
 
   if (outputVolumeNode->GetDisplayNode() == NULL)
   {
@@ -673,7 +839,19 @@ vtkMRMLTransformNode* vtkSlicerTransformLogic::ConvertToGridTransform(vtkMRMLTra
 
   // Fill the volume with displacement values
   bool transformToWorld = false; // usually grid transform is defined as transform from parent
-  vtkSlicerTransformLogic::GetTransformedPointSamplesAsVectorImage(outputVolume, inputTransformNode, ijkToRas.GetPointer(), transformToWorld);
+  this->AbortSampling = false;
+  if (!vtkSlicerTransformLogic::GetTransformedPointSamplesAsImage(outputVolume, inputTransformNode, ijkToRas.GetPointer(),
+    transformToWorld, false /* vectors */, this))
+  {
+    vtkWarningMacro("vtkSlicerTransformLogic::ConvertToGridTransform: conversion aborted");
+    if (existingOutputTransformNode == NULL)
+    {
+      scene->RemoveNode(outputGridTransformNode);
+    }
+    return NULL;
+  }
+  // Notify observers about the new displacement values
+  outputVolume->Modified();
 
   return outputGridTransformNode.GetPointer();
 }
@@ -687,6 +865,20 @@ bool vtkSlicerTransformLogic::GetTransformedPointSamplesAsVectorImage(vtkImageDa
     vtkGenericWarningMacro("vtkSlicerTransformLogic::GetTransformedPointSamplesAsVectorImage failed: invalid input");
     return false;
   }
+  return vtkSlicerTransformLogic::GetTransformedPointSamplesAsImage(vectorImage, inputTransformNode, ijkToRAS,
+    transformToWorld, false /* vectors */, NULL);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformLogic::GetTransformedPointSamplesAsImage(vtkImageData* outputImage,
+  vtkMRMLTransformNode* inputTransformNode, vtkMatrix4x4* ijkToRAS, bool transformToWorld, bool magnitude,
+  vtkSlicerTransformLogic* progressLogic)
+{
+  if (!outputImage || !inputTransformNode || !ijkToRAS)
+  {
+    vtkGenericWarningMacro("vtkSlicerTransformLogic::GetTransformedPointSamplesAsImage failed: invalid input");
+    return false;
+  }
   vtkNew<vtkGeneralTransform> inputTransform;
   if (transformToWorld)
   {
@@ -700,32 +892,8 @@ bool vtkSlicerTransformLogic::GetTransformedPointSamplesAsVectorImage(vtkImageDa
   // The orientation of the volume cannot be set in the image
   // therefore the volume will not appear in the correct position
   // if the direction matrix is not identity.
-  vectorImage->AllocateScalars(VTK_FLOAT, 3);
-
-  double point_RAS[4] = { 0, 0, 0, 1 };
-  double transformedPoint_RAS[4] = { 0, 0, 0, 1 };
-  double point_IJK[4] = { 0, 0, 0, 1 };
-  float* voxelPtr = static_cast<float*>(vectorImage->GetScalarPointer());
-  int* extent = vectorImage->GetExtent();
-  for (point_IJK[2] = extent[4]; point_IJK[2] <= extent[5]; point_IJK[2]++)
-  {
-    for (point_IJK[1] = extent[2]; point_IJK[1] <= extent[3]; point_IJK[1]++)
-    {
-      for (point_IJK[0] = extent[0]; point_IJK[0] <= extent[1]; point_IJK[0]++)
-      {
-        ijkToRAS->MultiplyPoint(point_IJK, point_RAS);
-
-        inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
-
-        // store the pointDislocationVector_RAS components in the image
-        *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[0] - point_RAS[0]);
-        *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[1] - point_RAS[1]);
-        *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[2] - point_RAS[2]);
-      }
-    }
-  }
-
-  return true;
+  vtkSlicerTransformSampler sampler(inputTransform.GetPointer(), progressLogic);
+  return sampler.SampleImage(outputImage, ijkToRAS, magnitude);
 }
 
 //----------------------------------------------------------------------------
@@ -38,6 +38,7 @@ class vtkMRMLTransformNode;
 class vtkMRMLVolumeNode;
 
 // VTK includes
+class vtkAbstractTransform;
 class vtkImageData;
 class vtkMatrix4x4;
 class vtkPoints;
@@ -58,6 +59,7 @@ class VTK_SLICER_TRANSFORMS_MODULE_LOGIC_EXPORT vtkSlicerTransformLogic : public
   /// on success, false otherwise.
   /// This method is kept for backward compatibility only, it is recommended to use
   /// vtkMRMLTransformableNode::HardenTransform() method instead.
+  /// Hardening does not report progress and it cannot be aborted.
   static bool hardenTransform(vtkMRMLTransformableNode* node);
 
   ///
@@ -108,6 +110,18 @@ class VTK_SLICER_TRANSFORMS_MODULE_LOGIC_EXPORT vtkSlicerTransformLogic : public
   vtkMRMLTransformNode* ConvertToGridTransform(vtkMRMLTransformNode* inputTransformNode, vtkMRMLVolumeNode* referenceVolumeNode = NULL,
     vtkMRMLTransformNode* existingOutputTransformNode = NULL);
 
+  /// Request abort of the transform sampling in ConvertToGridTransform or CreateDisplacementVolumeFromTransform.
+  /// Sampling progress is reported by vtkCommand::ProgressEvent (call data is a pointer to a double
+  /// value between 0 and 1), invoked from the calling thread, therefore it can be set
+  /// from a progress event observer. The flag is reset when a new conversion is started.
+  /// If sampling is aborted then the conversion methods return NULL.
+  /// Only these two methods report progress and can be aborted. Hardening a transform (\sa hardenTransform)
+  /// is performed by the transformable node, and the static sampling and visualization methods
+  /// have no logic instance to report to, therefore these always run to completion.
+  vtkSetMacro(AbortSampling, bool);
+  vtkGetMacro(AbortSampling, bool);
+  vtkBooleanMacro(AbortSampling, bool);
+
   /// Take samples from the displacement field and store the magnitude in an image volume
   /// The extents of the output image must be set before calling this method.
   /// The origin and spacing attributes of the output image are ignored (origin, spacing, and axis directions
@@ -213,6 +227,16 @@ protected:
   /// Get markup points as vtkPoints in RAS coordinate system.
   static void  GetMarkupsAsPoints(vtkMRMLMarkupsFiducialNode* markupsNode, vtkPoints* samplePoints_RAS);
 
+  /// Take samples from the displacement field on an image grid, on multiple threads.
+  /// If magnitude is true then a single-component float image is filled with the displacement magnitude,
+  /// otherwise a 3-component float image is filled with the displacement vectors.
+  /// If progressLogic is specified then progress events are invoked on that logic and its AbortSampling flag is respected.
+  /// Returns false if the input is invalid or sampling is aborted.
+  static bool GetTransformedPointSamplesAsImage(vtkImageData* outputImage, vtkMRMLTransformNode* inputTransformNode,
+    vtkMatrix4x4* ijkToRAS, bool transformToWorld, bool magnitude, vtkSlicerTransformLogic* progressLogic);
+
+  bool AbortSampling;
+
 };
 
 #endif
@@ -0,0 +1,268 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+// EditorLib includes
+#include "vtkImageConnectedComponents.h"
+#include "vtkImageConnectivity.h"
+
+// vtkAddon includes
+#include <vtkAddonTestingMacros.h>
+
+// VTK includes
+#include <vtkIdTypeArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkTestingOutputWindow.h>
+
+// STD includes
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Short image with random values: about half of the voxels are 0, the rest are 1 or 2
+void CreateRandomImage(vtkImageData* image)
+{
+  image->SetExtent(0, 11, 0, 9, 0, 7);
+  image->AllocateScalars(VTK_SHORT, 1);
+  short* ptr = static_cast<short*>(image->GetScalarPointer());
+  unsigned int seed = 4321;
+  for (vtkIdType i = 0; i < image->GetNumberOfPoints(); i++)
+    {
+    // linear congruential generator, so that the test does not depend on the platform
+    seed = seed * 1103515245 + 12345;
+    int r = (seed >> 16) % 100;
+    ptr[i] = (r < 50 ? 0 : (r < 80 ? 1 : 2));
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Reference labeling by flood fill from each unlabeled foreground voxel in raster order,
+/// which numbers the components the same way as the recursive labeling that was used earlier.
+void ComputeReferenceLabels(vtkImageData* image, double background, double minForeground, double maxForeground,
+  int connectivity, bool sliceBySlice, std::vector<int>& labels, std::vector<vtkIdType>& sizes, std::vector<int>& extents)
+{
+  int dims[3] = { 0, 0, 0 };
+  image->GetDimensions(dims);
+  short* ptr = static_cast<short*>(image->GetScalarPointer());
+  vtkIdType numberOfVoxels = image->GetNumberOfPoints();
+  int maxNonZeroCoordinates = (connectivity >= 26 ? 3 : (connectivity >= 18 ? 2 : 1));
+
+  labels.assign(numberOfVoxels, 0);
+  sizes.assign(1, 0);
+  extents.assign(6, 0);
+  for (vtkIdType start = 0; start < numberOfVoxels; start++)
+    {
+    double value = ptr[start];
+    bool foreground = (value != background && value >= minForeground && value <= maxForeground);
+    if (!foreground)
+      {
+      sizes[0]++;
+      continue;
+      }
+    if (labels[start] != 0)
+      {
+      continue;
+      }
+    int label = static_cast<int>(sizes.size());
+    sizes.push_back(0);
+    int startI = static_cast<int>(start % dims[0]);
+    int startJ = static_cast<int>((start / dims[0]) % dims[1]);
+    int startK = static_cast<int>(start / (static_cast<vtkIdType>(dims[0]) * dims[1]));
+    int extent[6] = { startI, startI, startJ, startJ, startK, startK };
+    std::deque<vtkIdType> queue;
+    labels[start] = label;
+    queue.push_back(start);
+    while (!queue.empty())
+      {
+      vtkIdType current = queue.front();
+      queue.pop_front();
+      sizes[label]++;
+      int i = static_cast<int>(current % dims[0]);
+      int j = static_cast<int>((current / dims[0]) % dims[1]);
+      int k = static_cast<int>(current / (static_cast<vtkIdType>(dims[0]) * dims[1]));
+      extent[0] = std::min(extent[0], i);
+      extent[1] = std::max(extent[1], i);
+      extent[2] = std::min(extent[2], j);
+      extent[3] = std::max(extent[3], j);
+      extent[4] = std::min(extent[4], k);
+      extent[5] = std::max(extent[5], k);
+      for (int dz = (sliceBySlice ? 0 : -1); dz <= (sliceBySlice ? 0 : 1); dz++)
+        {
+        for (int dy = -1; dy <= 1; dy++)
+          {
+          for (int dx = -1; dx <= 1; dx++)
+            {
+            int nonZeroCoordinates = (dx != 0 ? 1 : 0) + (dy != 0 ? 1 : 0) + (dz != 0 ? 1 : 0);
+            if (nonZeroCoordinates == 0 || nonZeroCoordinates > maxNonZeroCoordinates)
+              {
+              continue;
+              }
+            int ni = i + dx;
+            int nj = j + dy;
+            int nk = k + dz;
+            if (ni < 0 || ni >= dims[0] || nj < 0 || nj >= dims[1] || nk < 0 || nk >= dims[2])
+              {
+              continue;
+              }
+            vtkIdType neighbor = ni + (static_cast<vtkIdType>(nk) * dims[1] + nj) * dims[0];
+            double neighborValue = ptr[neighbor];
+            if (labels[neighbor] == 0 && neighborValue != background
+              && neighborValue >= minForeground && neighborValue <= maxForeground)
+              {
+              labels[neighbor] = label;
+              queue.push_back(neighbor);
+              }
+            }
+          }
+        }
+      }
+    extents.insert(extents.end(), extent, extent + 6);
+    }
+}
+
+//----------------------------------------------------------------------------
+int TestLabeling(int connectivity, bool sliceBySlice, double minForeground, double maxForeground)
+{
+  vtkNew<vtkImageData> image;
+  CreateRandomImage(image.GetPointer());
+
+  vtkNew<vtkImageConnectedComponents> connectedComponents;
+  connectedComponents->SetInputData(image.GetPointer());
+  connectedComponents->SetConnectivity(connectivity);
+  connectedComponents->SetSliceBySlice(sliceBySlice ? 1 : 0);
+  connectedComponents->SetBackground(0);
+  connectedComponents->SetMinForeground(minForeground);
+  connectedComponents->SetMaxForeground(maxForeground);
+  connectedComponents->Update();
+
+  std::vector<int> expectedLabels;
+  std::vector<vtkIdType> expectedSizes;
+  std::vector<int> expectedExtents;
+  ComputeReferenceLabels(image.GetPointer(), 0, minForeground, maxForeground, connectivity, sliceBySlice,
+    expectedLabels, expectedSizes, expectedExtents);
+
+  int numberOfComponents = connectedComponents->GetNumberOfComponents();
+  CHECK_INT(numberOfComponents, static_cast<int>(expectedSizes.size()) - 1);
+  // Test is only meaningful if there are several components
+  CHECK_BOOL(numberOfComponents > 1, true);
+
+  vtkImageData* output = connectedComponents->GetOutput();
+  CHECK_INT(output->GetScalarType(), VTK_INT);
+  int* outputLabels = static_cast<int*>(output->GetScalarPointer());
+  for (vtkIdType i = 0; i < image->GetNumberOfPoints(); i++)
+    {
+    if (outputLabels[i] != expectedLabels[i])
+      {
+      std::cerr << "Connectivity " << connectivity << (sliceBySlice ? " slice by slice" : "")
+        << ": label of voxel " << i << " is " << outputLabels[i] << ", expected " << expectedLabels[i] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  vtkIdTypeArray* sizes = connectedComponents->GetComponentSizes();
+  for (int label = 0; label <= numberOfComponents; label++)
+    {
+    CHECK_INT(static_cast<int>(sizes->GetValue(label)), static_cast<int>(expectedSizes[label]));
+    }
+  for (int label = 1; label <= numberOfComponents; label++)
+    {
+    int extent[6] = { 0, -1, 0, -1, 0, -1 };
+    connectedComponents->GetComponentExtent(label, extent);
+    for (int i = 0; i < 6; i++)
+      {
+      CHECK_INT(extent[i], expectedExtents[label * 6 + i]);
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestRemoveIslands()
+{
+  vtkNew<vtkImageData> image;
+  image->SetExtent(0, 9, 0, 9, 0, 4);
+  image->AllocateScalars(VTK_SHORT, 1);
+  short* ptr = static_cast<short*>(image->GetScalarPointer());
+  for (vtkIdType i = 0; i < image->GetNumberOfPoints(); i++)
+    {
+    ptr[i] = 0;
+    }
+  // Large island of label 1
+  for (int k = 1; k <= 3; k++)
+    {
+    for (int j = 1; j <= 3; j++)
+      {
+      for (int i = 1; i <= 3; i++)
+        {
+        image->SetScalarComponentFromDouble(i, j, k, 0, 1);
+        }
+      }
+    }
+  // Small island of label 1
+  image->SetScalarComponentFromDouble(7, 7, 2, 0, 1);
+  // Small island of label 5, it is not foreground
+  image->SetScalarComponentFromDouble(7, 2, 2, 0, 5);
+
+  vtkNew<vtkImageConnectivity> connectivity;
+  connectivity->SetInputData(image.GetPointer());
+  connectivity->SetFunctionToRemoveIslands();
+  connectivity->SetBackground(0);
+  connectivity->SetMinForeground(1);
+  connectivity->SetMaxForeground(1);
+  connectivity->SetMinSize(2);
+  connectivity->Update();
+  vtkImageData* output = connectivity->GetOutput();
+
+  CHECK_INT(static_cast<int>(output->GetScalarComponentAsDouble(2, 2, 2, 0)), 1);
+  CHECK_INT(static_cast<int>(output->GetScalarComponentAsDouble(7, 7, 2, 0)), 0);
+  CHECK_INT(static_cast<int>(output->GetScalarComponentAsDouble(7, 2, 2, 0)), 5);
+  CHECK_INT(static_cast<int>(output->GetScalarComponentAsDouble(0, 0, 0, 0)), 0);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestInvalidConnectivity()
+{
+  vtkNew<vtkImageConnectedComponents> connectedComponents;
+  connectedComponents->SetConnectivity(18);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  connectedComponents->SetConnectivity(7);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  CHECK_INT(connectedComponents->GetConnectivity(), 18);
+
+  vtkNew<vtkImageConnectivity> connectivity;
+  connectivity->SetConnectivity(26);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  connectivity->SetConnectivity(25);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  CHECK_INT(connectivity->GetConnectivity(), 26);
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageConnectedComponentsTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestLabeling(6, false, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX));
+  CHECK_EXIT_SUCCESS(TestLabeling(18, false, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX));
+  CHECK_EXIT_SUCCESS(TestLabeling(26, false, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX));
+  CHECK_EXIT_SUCCESS(TestLabeling(6, true, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX));
+  CHECK_EXIT_SUCCESS(TestLabeling(26, false, 1, 1));
+  CHECK_EXIT_SUCCESS(TestRemoveIslands());
+  CHECK_EXIT_SUCCESS(TestInvalidConnectivity());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,567 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+#include "vtkImageConnectedComponents.h"
+
+#include <vtkDataSetAttributes.h>
+#include <vtkIdTypeArray.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkIntArray.h>
+#include <vtkObjectFactory.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+
+#include <algorithm>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageConnectedComponents);
+
+namespace
+{
+
+// Maximum number of blocks the volume is split into for parallel labeling.
+const int MAXIMUM_NUMBER_OF_BLOCKS = 64;
+
+//----------------------------------------------------------------------------
+// Union-find over provisional labels. The root of each set is its smallest label.
+int FindRoot(std::vector<int>& parent, int label)
+{
+  while (parent[label] != label)
+    {
+    parent[label] = parent[parent[label]]; // path halving
+    label = parent[label];
+    }
+  return label;
+}
+
+//----------------------------------------------------------------------------
+void Union(std::vector<int>& parent, int label1, int label2)
+{
+  label1 = FindRoot(parent, label1);
+  label2 = FindRoot(parent, label2);
+  if (label1 < label2)
+    {
+    parent[label2] = label1;
+    }
+  else if (label2 < label1)
+    {
+    parent[label1] = label2;
+    }
+}
+
+//----------------------------------------------------------------------------
+struct NeighborOffset
+{
+  int Dx;
+  int Dy;
+  int Dz;
+  vtkIdType Offset;
+};
+
+//----------------------------------------------------------------------------
+// Get neighbors that precede the current voxel in raster order
+// (these are already labeled when the current voxel is visited).
+void GetPrecedingNeighbors(int connectivity, vtkIdType incY, vtkIdType incZ, std::vector<NeighborOffset>& neighbors)
+{
+  neighbors.clear();
+  int maxNonZeroCoordinates = (connectivity >= 26 ? 3 : (connectivity >= 18 ? 2 : 1));
+  for (int dz = -1; dz <= 0; dz++)
+    {
+    for (int dy = -1; dy <= 1; dy++)
+      {
+      for (int dx = -1; dx <= 1; dx++)
+        {
+        if (dz == 0 && (dy > 0 || (dy == 0 && dx >= 0)))
+          {
+          // current voxel or a voxel that follows it
+          continue;
+          }
+        int nonZeroCoordinates = (dx != 0 ? 1 : 0) + (dy != 0 ? 1 : 0) + (dz != 0 ? 1 : 0);
+        if (nonZeroCoordinates > maxNonZeroCoordinates)
+          {
+          continue;
+          }
+        NeighborOffset neighbor;
+        neighbor.Dx = dx;
+        neighbor.Dy = dy;
+        neighbor.Dz = dz;
+        neighbor.Offset = dx + dy * incY + dz * incZ;
+        neighbors.push_back(neighbor);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Provisional labels of a block of slices
+struct BlockLabels
+{
+  int FirstSlice;
+  int LastSlice; // exclusive
+  int Offset; // provisional labels of this block are shifted by this value in the global label table
+  std::vector<int> Parent; // union-find table of local provisional labels, Parent[0] is unused
+};
+
+//----------------------------------------------------------------------------
+// First pass: label each block of slices independently
+template <class T>
+class LabelBlocksFunctor
+{
+public:
+  LabelBlocksFunctor(vtkImageConnectedComponents* self, T* inPtr, vtkIdType inIncrements[3], int* outPtr, int dims[3],
+    std::vector<BlockLabels>& blocks, std::vector<NeighborOffset>& neighbors)
+  : InPtr(inPtr)
+  , OutPtr(outPtr)
+  , Blocks(blocks)
+  , Neighbors(neighbors)
+  {
+    this->Background = self->GetBackground();
+    this->MinForeground = self->GetMinForeground();
+    this->MaxForeground = self->GetMaxForeground();
+    this->SliceBySlice = (self->GetSliceBySlice() != 0);
+    for (int i = 0; i < 3; i++)
+      {
+      this->InIncrements[i] = inIncrements[i];
+      this->Dims[i] = dims[i];
+      }
+  }
+
+  bool IsForeground(T value)
+  {
+    double v = static_cast<double>(value);
+    return (v != this->Background && v >= this->MinForeground && v <= this->MaxForeground);
+  }
+
+  void operator()(vtkIdType beginBlock, vtkIdType endBlock)
+  {
+    vtkIdType outIncY = this->Dims[0];
+    vtkIdType outIncZ = this->Dims[0] * this->Dims[1];
+    for (vtkIdType blockIndex = beginBlock; blockIndex < endBlock; blockIndex++)
+      {
+      BlockLabels& block = this->Blocks[blockIndex];
+      std::vector<int>& parent = block.Parent;
+      parent.assign(1, 0);
+      for (int z = block.FirstSlice; z < block.LastSlice; z++)
+        {
+        bool previousSliceAvailable = (!this->SliceBySlice && z > block.FirstSlice);
+        for (int y = 0; y < this->Dims[1]; y++)
+          {
+          T* inPtr = this->InPtr + z * this->InIncrements[2] + y * this->InIncrements[1];
+          int* outPtr = this->OutPtr + z * outIncZ + y * outIncY;
+          for (int x = 0; x < this->Dims[0]; x++, inPtr += this->InIncrements[0], outPtr++)
+            {
+            if (!this->IsForeground(*inPtr))
+              {
+              *outPtr = 0;
+              continue;
+              }
+            int label = 0;
+            for (std::vector<NeighborOffset>::iterator neighborIt = this->Neighbors.begin();
+              neighborIt != this->Neighbors.end(); ++neighborIt)
+              {
+              if ((neighborIt->Dz != 0 && !previousSliceAvailable)
+                || y + neighborIt->Dy < 0 || y + neighborIt->Dy >= this->Dims[1]
+                || x + neighborIt->Dx < 0 || x + neighborIt->Dx >= this->Dims[0])
+                {
+                continue;
+                }
+              int neighborLabel = outPtr[neighborIt->Offset];
+              if (neighborLabel == 0)
+                {
+                continue;
+                }
+              if (label == 0)
+                {
+                label = neighborLabel;
+                }
+              else if (neighborLabel != label)
+                {
+                Union(parent, label, neighborLabel);
+                }
+              }
+            if (label == 0)
+              {
+              // new provisional label
+              label = static_cast<int>(parent.size());
+              parent.push_back(label);
+              }
+            *outPtr = label;
+            }
+          }
+        }
+      }
+  }
+
+protected:
+  T* InPtr;
+  vtkIdType InIncrements[3];
+  int* OutPtr;
+  int Dims[3];
+  double Background;
+  double MinForeground;
+  double MaxForeground;
+  bool SliceBySlice;
+  std::vector<BlockLabels>& Blocks;
+  std::vector<NeighborOffset>& Neighbors;
+};
+
+//----------------------------------------------------------------------------
+// Second pass: write final labels and compute size and extent of each component
+class RelabelBlocksFunctor
+{
+public:
+  RelabelBlocksFunctor(int* outPtr, int dims[3], int extent[6], std::vector<BlockLabels>& blocks,
+    std::vector<int>& finalLabels, int numberOfComponents)
+  : OutPtr(outPtr)
+  , Blocks(blocks)
+  , FinalLabels(finalLabels)
+  , NumberOfComponents(numberOfComponents)
+  {
+    for (int i = 0; i < 3; i++)
+      {
+      this->Dims[i] = dims[i];
+      }
+    for (int i = 0; i < 6; i++)
+      {
+      this->Extent[i] = extent[i];
+      }
+  }
+
+  void Initialize()
+  {
+    std::vector<vtkIdType>& sizes = this->Sizes.Local();
+    sizes.assign(this->NumberOfComponents + 1, 0);
+    std::vector<int>& extents = this->Extents.Local();
+    extents.resize(6 * (this->NumberOfComponents + 1));
+    for (int label = 0; label <= this->NumberOfComponents; label++)
+      {
+      extents[label * 6 + 0] = extents[label * 6 + 2] = extents[label * 6 + 4] = VTK_INT_MAX;
+      extents[label * 6 + 1] = extents[label * 6 + 3] = extents[label * 6 + 5] = VTK_INT_MIN;
+      }
+  }
+
+  void operator()(vtkIdType beginBlock, vtkIdType endBlock)
+  {
+    std::vector<vtkIdType>& sizes = this->Sizes.Local();
+    std::vector<int>& extents = this->Extents.Local();
+    vtkIdType outIncZ = this->Dims[0] * this->Dims[1];
+    for (vtkIdType blockIndex = beginBlock; blockIndex < endBlock; blockIndex++)
+      {
+      BlockLabels& block = this->Blocks[blockIndex];
+      int* outPtr = this->OutPtr + block.FirstSlice * outIncZ;
+      for (int z = block.FirstSlice; z < block.LastSlice; z++)
+        {
+        for (int y = 0; y < this->Dims[1]; y++)
+          {
+          for (int x = 0; x < this->Dims[0]; x++, outPtr++)
+            {
+            if (*outPtr == 0)
+              {
+              sizes[0]++;
+              continue;
+              }
+            int label = this->FinalLabels[block.Offset + *outPtr];
+            *outPtr = label;
+            sizes[label]++;
+            int* extent = &(extents[label * 6]);
+            int i = x + this->Extent[0];
+            int j = y + this->Extent[2];
+            int k = z + this->Extent[4];
+            if (i < extent[0]) { extent[0] = i; }
+            if (i > extent[1]) { extent[1] = i; }
+            if (j < extent[2]) { extent[2] = j; }
+            if (j > extent[3]) { extent[3] = j; }
+            if (k < extent[4]) { extent[4] = k; }
+            if (k > extent[5]) { extent[5] = k; }
+            }
+          }
+        }
+      }
+  }
+
+  void Reduce()
+  {
+  }
+
+  vtkSMPThreadLocal< std::vector<vtkIdType> > Sizes;
+  vtkSMPThreadLocal< std::vector<int> > Extents;
+
+protected:
+  int* OutPtr;
+  int Dims[3];
+  int Extent[6];
+  std::vector<BlockLabels>& Blocks;
+  std::vector<int>& FinalLabels;
+  int NumberOfComponents;
+};
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkImageConnectedComponentsExecute(vtkImageConnectedComponents *self,
+  vtkImageData *inData, T *inPtr, vtkImageData *vtkNotUsed(outData), int *outPtr, int outExt[6],
+  vtkIdTypeArray* componentSizes, vtkIntArray* componentExtents)
+{
+  int dims[3] = { outExt[1] - outExt[0] + 1, outExt[3] - outExt[2] + 1, outExt[5] - outExt[4] + 1 };
+  vtkIdType* increments = inData->GetIncrements();
+  vtkIdType inIncrements[3] = { increments[0], increments[1], increments[2] };
+
+  std::vector<NeighborOffset> neighbors;
+  GetPrecedingNeighbors(self->GetConnectivity(), dims[0], dims[0] * dims[1], neighbors);
+
+  // Split the volume into blocks of slices
+  int numberOfBlocks = std::min(dims[2], MAXIMUM_NUMBER_OF_BLOCKS);
+  std::vector<BlockLabels> blocks(numberOfBlocks);
+  for (int blockIndex = 0; blockIndex < numberOfBlocks; blockIndex++)
+    {
+    blocks[blockIndex].FirstSlice = static_cast<int>(static_cast<vtkIdType>(dims[2]) * blockIndex / numberOfBlocks);
+    blocks[blockIndex].LastSlice = static_cast<int>(static_cast<vtkIdType>(dims[2]) * (blockIndex + 1) / numberOfBlocks);
+    }
+
+  // First pass: provisional labels in each block
+  LabelBlocksFunctor<T> labelBlocksFunctor(self, inPtr, inIncrements, outPtr, dims, blocks, neighbors);
+  vtkSMPTools::For(0, numberOfBlocks, 1, labelBlocksFunctor);
+
+  // Merge local label tables into a global table
+  int numberOfProvisionalLabels = 0;
+  for (std::vector<BlockLabels>::iterator blockIt = blocks.begin(); blockIt != blocks.end(); ++blockIt)
+    {
+    blockIt->Offset = numberOfProvisionalLabels;
+    numberOfProvisionalLabels += static_cast<int>(blockIt->Parent.size()) - 1;
+    }
+  std::vector<int> parent(numberOfProvisionalLabels + 1, 0);
+  for (std::vector<BlockLabels>::iterator blockIt = blocks.begin(); blockIt != blocks.end(); ++blockIt)
+    {
+    int numberOfLocalLabels = static_cast<int>(blockIt->Parent.size());
+    for (int localLabel = 1; localLabel < numberOfLocalLabels; localLabel++)
+      {
+      parent[blockIt->Offset + localLabel] = blockIt->Offset + FindRoot(blockIt->Parent, localLabel);
+      }
+    std::vector<int> emptyParent;
+    blockIt->Parent.swap(emptyParent);
+    }
+
+  // Merge labels across block boundaries
+  if (!self->GetSliceBySlice())
+    {
+    vtkIdType outIncY = dims[0];
+    vtkIdType outIncZ = dims[0] * dims[1];
+    for (int blockIndex = 1; blockIndex < numberOfBlocks; blockIndex++)
+      {
+      int z = blocks[blockIndex].FirstSlice;
+      int offset = blocks[blockIndex].Offset;
+      int previousOffset = blocks[blockIndex - 1].Offset;
+      for (int y = 0; y < dims[1]; y++)
+        {
+        int* labelPtr = outPtr + z * outIncZ + y * outIncY;
+        for (int x = 0; x < dims[0]; x++, labelPtr++)
+          {
+          if (*labelPtr == 0)
+            {
+            continue;
+            }
+          for (std::vector<NeighborOffset>::iterator neighborIt = neighbors.begin(); neighborIt != neighbors.end(); ++neighborIt)
+            {
+            if (neighborIt->Dz == 0
+              || y + neighborIt->Dy < 0 || y + neighborIt->Dy >= dims[1]
+              || x + neighborIt->Dx < 0 || x + neighborIt->Dx >= dims[0])
+              {
+              continue;
+              }
+            int neighborLabel = labelPtr[neighborIt->Offset];
+            if (neighborLabel != 0)
+              {
+              Union(parent, offset + *labelPtr, previousOffset + neighborLabel);
+              }
+            }
+          }
+        }
+      }
+    }
+
+  // Assign final labels. Roots are the smallest provisional labels, which belong to the
+  // first voxel of each component in raster order, so components are numbered in raster order.
+  std::vector<int> finalLabels(numberOfProvisionalLabels + 1, 0);
+  int numberOfComponents = 0;
+  for (int label = 1; label <= numberOfProvisionalLabels; label++)
+    {
+    int root = FindRoot(parent, label);
+    finalLabels[label] = (root == label ? ++numberOfComponents : finalLabels[root]);
+    }
+
+  // Second pass: final labels and component statistics
+  RelabelBlocksFunctor relabelBlocksFunctor(outPtr, dims, outExt, blocks, finalLabels, numberOfComponents);
+  vtkSMPTools::For(0, numberOfBlocks, 1, relabelBlocksFunctor);
+
+  componentSizes->SetNumberOfTuples(numberOfComponents + 1);
+  componentSizes->FillComponent(0, 0);
+  componentExtents->SetNumberOfTuples(numberOfComponents + 1);
+  for (int i = 0; i < 6; i++)
+    {
+    componentExtents->FillComponent(i, (i % 2 == 0) ? VTK_INT_MAX : VTK_INT_MIN);
+    }
+  vtkIdType* sizesPtr = componentSizes->GetPointer(0);
+  int* extentsPtr = componentExtents->GetPointer(0);
+  vtkSMPThreadLocal< std::vector<vtkIdType> >::iterator sizesIt = relabelBlocksFunctor.Sizes.begin();
+  vtkSMPThreadLocal< std::vector<int> >::iterator extentsIt = relabelBlocksFunctor.Extents.begin();
+  for (; sizesIt != relabelBlocksFunctor.Sizes.end(); ++sizesIt, ++extentsIt)
+    {
+    for (int label = 0; label <= numberOfComponents; label++)
+      {
+      sizesPtr[label] += (*sizesIt)[label];
+      int* extent = extentsPtr + label * 6;
+      const int* threadExtent = &((*extentsIt)[label * 6]);
+      for (int i = 0; i < 6; i += 2)
+        {
+        extent[i] = std::min(extent[i], threadExtent[i]);
+        extent[i + 1] = std::max(extent[i + 1], threadExtent[i + 1]);
+        }
+      }
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkImageConnectedComponents::vtkImageConnectedComponents()
+{
+  this->Connectivity = 6;
+  this->SliceBySlice = 0;
+  this->Background = 0;
+  this->MinForeground = VTK_DOUBLE_MIN;
+  this->MaxForeground = VTK_DOUBLE_MAX;
+  this->ComponentSizes = vtkSmartPointer<vtkIdTypeArray>::New();
+  this->ComponentExtents = vtkSmartPointer<vtkIntArray>::New();
+  this->ComponentExtents->SetNumberOfComponents(6);
+}
+
+//----------------------------------------------------------------------------
+vtkImageConnectedComponents::~vtkImageConnectedComponents()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkImageConnectedComponents::SetConnectivity(int connectivity)
+{
+  if (connectivity != 6 && connectivity != 18 && connectivity != 26)
+    {
+    vtkErrorMacro("SetConnectivity: invalid connectivity " << connectivity << ", it must be 6, 18, or 26");
+    return;
+    }
+  if (this->Connectivity == connectivity)
+    {
+    return;
+    }
+  this->Connectivity = connectivity;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkImageConnectedComponents::GetNumberOfComponents()
+{
+  vtkIdType numberOfTuples = this->ComponentSizes->GetNumberOfTuples();
+  return (numberOfTuples > 0 ? static_cast<int>(numberOfTuples - 1) : 0);
+}
+
+//----------------------------------------------------------------------------
+vtkIdTypeArray* vtkImageConnectedComponents::GetComponentSizes()
+{
+  return this->ComponentSizes;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkImageConnectedComponents::GetComponentSize(int label)
+{
+  if (label < 1 || label > this->GetNumberOfComponents())
+    {
+    vtkErrorMacro("GetComponentSize: invalid label " << label);
+    return 0;
+    }
+  return this->ComponentSizes->GetValue(label);
+}
+
+//----------------------------------------------------------------------------
+vtkIntArray* vtkImageConnectedComponents::GetComponentExtents()
+{
+  return this->ComponentExtents;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageConnectedComponents::GetComponentExtent(int label, int extent[6])
+{
+  if (label < 1 || label > this->GetNumberOfComponents())
+    {
+    vtkErrorMacro("GetComponentExtent: invalid label " << label);
+    extent[0] = extent[2] = extent[4] = 0;
+    extent[1] = extent[3] = extent[5] = -1;
+    return;
+    }
+  this->ComponentExtents->GetTypedTuple(label, extent);
+}
+
+//----------------------------------------------------------------------------
+int vtkImageConnectedComponents::RequestInformation(
+  vtkInformation * vtkNotUsed(request),
+  vtkInformationVector ** vtkNotUsed(inputVector),
+  vtkInformationVector *outputVector)
+{
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+  vtkDataObject::SetPointDataActiveScalarInfo(outInfo, VTK_INT, 1);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageConnectedComponents::ExecuteDataWithInformation(vtkDataObject *output, vtkInformation* outInfo)
+{
+  vtkImageData *inData = vtkImageData::SafeDownCast(this->GetInput());
+  vtkImageData *outData = this->AllocateOutputData(output, outInfo);
+
+  this->ComponentSizes->SetNumberOfTuples(0);
+  this->ComponentExtents->SetNumberOfTuples(0);
+
+  if (inData->GetNumberOfScalarComponents() != 1)
+    {
+    vtkErrorMacro(<<"Input has "<<inData->GetNumberOfScalarComponents()<<" instead of 1 scalar component.");
+    return;
+    }
+
+  int outExt[6];
+  outInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), outExt);
+  if (outExt[0] > outExt[1] || outExt[2] > outExt[3] || outExt[4] > outExt[5])
+    {
+    // empty image
+    return;
+    }
+  void *inPtr = inData->GetScalarPointerForExtent(outExt);
+  int *outPtr = static_cast<int*>(outData->GetScalarPointerForExtent(outExt));
+
+  switch (inData->GetScalarType())
+    {
+    vtkTemplateMacro(vtkImageConnectedComponentsExecute(this, inData, static_cast<VTK_TT*>(inPtr),
+      outData, outPtr, outExt, this->ComponentSizes, this->ComponentExtents));
+    default:
+      vtkErrorMacro(<< "Execute: Unknown ScalarType");
+      return;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkImageConnectedComponents::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "Connectivity:        " << this->Connectivity << "\n";
+  os << indent << "SliceBySlice:        " << this->SliceBySlice << "\n";
+  os << indent << "Background:          " << this->Background << "\n";
+  os << indent << "MinForeground:       " << this->MinForeground << "\n";
+  os << indent << "MaxForeground:       " << this->MaxForeground << "\n";
+  os << indent << "NumberOfComponents:  " << this->GetNumberOfComponents() << "\n";
+}
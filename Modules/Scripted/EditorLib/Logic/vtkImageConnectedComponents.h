@@ -0,0 +1,101 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+///  vtkImageConnectedComponents - Label connected components (islands) of an image
+///
+/// Foreground voxels are voxels that are not equal to Background and are
+/// within [MinForeground, MaxForeground]. Each connected foreground region
+/// gets a unique label in the output (VTK_INT) image, background voxels are 0.
+/// Labels are numbered from 1 in the order of the first voxel of each
+/// component in memory (raster) order.
+///
+/// Labeling is computed by a two-pass union-find algorithm: the image is split
+/// into blocks of slices that are labeled in parallel, equivalences across block
+/// boundaries are merged, then the final labels are written in a second parallel pass.
+/// Size and extent of each component are computed in the second pass.
+
+#ifndef __vtkImageConnectedComponents_h
+#define __vtkImageConnectedComponents_h
+
+#include "vtkSlicerEditorLibModuleLogicExport.h"
+
+// VTK includes
+#include <vtkImageAlgorithm.h>
+#include <vtkSmartPointer.h>
+
+class vtkIdTypeArray;
+class vtkIntArray;
+
+class VTK_SLICER_EDITORLIB_MODULE_LOGIC_EXPORT vtkImageConnectedComponents : public vtkImageAlgorithm
+{
+public:
+  static vtkImageConnectedComponents *New();
+  vtkTypeMacro(vtkImageConnectedComponents,vtkImageAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Neighborhood used for determining connectivity: 6 (faces), 18 (faces and edges),
+  /// or 26 (faces, edges, and corners). Default is 6.
+  /// Other values are rejected with an error and the connectivity is not changed.
+  void SetConnectivity(int connectivity);
+  vtkGetMacro(Connectivity, int);
+  void SetConnectivityTo6() { this->SetConnectivity(6); };
+  void SetConnectivityTo18() { this->SetConnectivity(18); };
+  void SetConnectivityTo26() { this->SetConnectivity(26); };
+
+  /// If enabled then each slice (XY plane) is labeled independently.
+  /// Labels are still unique in the whole output volume.
+  vtkGetMacro(SliceBySlice, int);
+  vtkSetMacro(SliceBySlice, int);
+  vtkBooleanMacro(SliceBySlice, int);
+
+  /// Voxels having this value are not considered foreground.
+  vtkSetMacro(Background, double);
+  vtkGetMacro(Background, double);
+  /// Only voxels within [MinForeground, MaxForeground] are considered foreground.
+  vtkSetMacro(MinForeground, double);
+  vtkGetMacro(MinForeground, double);
+  vtkSetMacro(MaxForeground, double);
+  vtkGetMacro(MaxForeground, double);
+
+  /// Number of connected components found in the last update
+  int GetNumberOfComponents();
+
+  /// Number of voxels of each component. Value at index 0 is the number of background voxels,
+  /// value at index i is the size of component with label i.
+  vtkIdTypeArray* GetComponentSizes();
+  /// Number of voxels in component with the given label (1 <= label <= number of components).
+  vtkIdType GetComponentSize(int label);
+
+  /// Extent of each component as 6-component tuples (iMin, iMax, jMin, jMax, kMin, kMax).
+  /// Tuple at index i corresponds to component with label i, tuple at index 0 is unused.
+  vtkIntArray* GetComponentExtents();
+  /// Extent of component with the given label (1 <= label <= number of components).
+  void GetComponentExtent(int label, int extent[6]);
+
+protected:
+  vtkImageConnectedComponents();
+  ~vtkImageConnectedComponents();
+
+  virtual int RequestInformation(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
+  virtual void ExecuteDataWithInformation(vtkDataObject *, vtkInformation *);
+
+  int Connectivity;
+  int SliceBySlice;
+  double Background;
+  double MinForeground;
+  double MaxForeground;
+
+  vtkSmartPointer<vtkIdTypeArray> ComponentSizes;
+  vtkSmartPointer<vtkIntArray> ComponentExtents;
+
+private:
+  vtkImageConnectedComponents(const vtkImageConnectedComponents&);
+  void operator=(const vtkImageConnectedComponents&);
+};
+
+#endif
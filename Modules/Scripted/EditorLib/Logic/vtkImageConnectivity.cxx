@@ -7,9 +7,12 @@
 
 =========================================================================auto=*/
 #include "vtkImageConnectivity.h"
+#include "vtkImageConnectedComponents.h"
 
 #include "vtkObjectFactory.h"
 #include "vtkImageData.h"
+#include <vtkIdTypeArray.h>
+#include <vtkNew.h>
 #include <vtkInformation.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 
@@ -32,6 +35,7 @@ vtkImageConnectivity::vtkImageConnectivity()
   this->Function = CONNECTIVITY_MEASURE;
   this->OutputLabel = 1;
   this->SliceBySlice = 0;
+  this->Connectivity = 6;
   this->LargestIslandSize = this->IslandSize = 0;
   this->Seed[0] = this->Seed[1] = this->Seed[2] = 0;
 }
@@ -56,131 +60,6 @@ const char* vtkImageConnectivity::GetFunctionString()
     }
 }
 
-//************************************************************************
-// The following procedures were written by Andre Robatino
-// in November, 1999
-//
-// connect
-// recursive_copy
-//************************************************************************
-
-int connect(unsigned int, size_t *, char *, char, size_t *, size_t *);
-static void recursive_copy(int, size_t);
-
-static size_t *g_axis_len, *g_outimagep, num_stride_index_bits;
-static char *g_inimagep, g_inbackground;
-
-int connect(
-     unsigned int rank,
-     size_t *axis_len,
-     char *inimage,
-     char inbackground,
-     size_t *outimage,
-     size_t *num_components) /* set to NULL if not interested */
-{
-  unsigned int i;
-  register unsigned int axisv;
-  size_t data_len;
-  register size_t label, *outimagep, *outimage_end, *imagep, *new_imagep, boundary_mask_start, component_mask, axis_mask;
-  register ptrdiff_t *stride, stridev;
-
-  //assert(rank >= 0); // Note: Always true !
-  if (rank == 0) {
-    *outimage = (*inimage != inbackground);
-    if (num_components) *num_components = *outimage;
-    return 0;
-  }
-  label = 2*rank;
-  num_stride_index_bits = 1;
-  while (label >>= 1) num_stride_index_bits++;
-  assert(num_stride_index_bits + 2*rank + 1 <= CHAR_BIT*sizeof(size_t));
-  boundary_mask_start = 1<<num_stride_index_bits;
-  axis_mask = boundary_mask_start - 1;
-  stride = (ptrdiff_t *)malloc((2*rank + 1)*sizeof(ptrdiff_t));
-  assert(stride);
-  data_len = 1;
-  for (i=0; i<rank; i++) {
-    assert(axis_len[i] > 1);
-    stride[2*i + 1] = -(stride[2*i] = data_len);
-    data_len *= axis_len[i];
-  }
-  stride[2*rank] = 0;
-  g_axis_len = axis_len;
-  g_inimagep = inimage;
-  g_inbackground = inbackground;
-  g_outimagep = outimage;
-  component_mask = 0;
-  component_mask = ~(~component_mask>>1);
-  recursive_copy(rank-1, component_mask);
-  outimagep = outimage;
-  outimage_end = outimage + data_len;
-  label = 0;
-  do {
-    if (!(*outimagep & component_mask)) continue;
-    imagep = outimagep;
-    *imagep ^= component_mask;
-    axisv = 0;
-    label++;
-    while (1) {
-      while ( (stridev = stride[axisv]) ) {
-        if ((*imagep & boundary_mask_start<<axisv) && (*(new_imagep = imagep + stridev) & component_mask)) {
-          imagep = new_imagep;
-          *imagep ^= component_mask;
-          *imagep |= axisv;
-          axisv = 0;
-          continue;
-        }
-        axisv++;
-      }
-      if (imagep == outimagep) break;
-      axisv = *imagep & axis_mask;
-      *imagep = label;
-      imagep -= stride[axisv++];
-    }
-    *outimagep = label;
-  } while (++outimagep < outimage_end);
-  if (num_components) *num_components = label;
-  free(stride);
-  return 0;
-}
-
-static void recursive_copy(
-     int axis,
-     register size_t mask)
-{
-  register size_t len = g_axis_len[axis] - 2;
-
-  if (axis == 0) {
-    register size_t *outimagep;
-    register char *inimagep, inbackground;
-
-    inimagep = g_inimagep;
-    inbackground = g_inbackground;
-    outimagep = g_outimagep;
-    mask |= 1<<num_stride_index_bits;
-    *outimagep++ = (*inimagep++ == inbackground)? 0 : mask;
-    mask |= 2<<num_stride_index_bits;
-    while (len--) *outimagep++ = (*inimagep++ == inbackground)? 0 : mask;
-    mask ^= 1<<num_stride_index_bits;
-    *outimagep++ = (*inimagep++ == inbackground)? 0 : mask;
-    g_outimagep = outimagep;
-    g_inimagep = inimagep;
-  } else {
-    mask |= 1<<(num_stride_index_bits + 2*axis);
-    recursive_copy(axis-1, mask);
-    mask |= 2<<(num_stride_index_bits + 2*axis);
-    while (len--) recursive_copy(axis-1, mask);
-    mask ^= 1<<(num_stride_index_bits + 2*axis);
-    recursive_copy(axis-1, mask);
-  }
-  return;
-}
-
-//***********************************************************************
-// End Andre's cool routines.
-//************************************************************************
-
-
 static void vtkImageConnectivityExecute(vtkImageConnectivity *self,
                      vtkImageData *inData, short *inPtr,
                      vtkImageData *outData, short *outPtr,
@@ -196,8 +75,8 @@ static void vtkImageConnectivityExecute(vtkImageConnectivity *self,
   short maxForegnd = (short)self->GetMaxForeground();
   short newLabel = (short)self->GetOutputLabel();
   short seedLabel = 0;
-  int largest, len=1, nxy, z, nz = 0, j;
-  int *census = NULL;
+  vtkIdType largest;
+  vtkIdType *census = NULL;
   int seed[3];
   int minSize = self->GetMinSize();
   short pix;
@@ -208,36 +87,31 @@ static void vtkImageConnectivityExecute(vtkImageConnectivity *self,
   int measureIsland   = self->GetFunction() == CONNECTIVITY_MEASURE;
   int sliceBySlice    = self->GetSliceBySlice();
 
-  // connect
-  size_t conSeedLabel = 0, i, idx, dz;
-  int rank;
-  size_t *axis_len=NULL;
+  // connected components
+  int conSeedLabel = 0;
+  vtkIdType i;
+  int numIslands = 0;
+  int axis_len[3];
   unsigned short bg = self->GetBackground();
-  short bgMask = 0;
-  short fgMask = 1;
-  char inbackground = (char)bgMask;
-  char *conInput=NULL;
-  size_t *conOutput=NULL;
-  size_t *numIslands=NULL;
+  unsigned char bgMask = 0;
+  unsigned char fgMask = 1;
+  unsigned char *conInput=NULL;
+  int *conOutput=NULL;
+  vtkNew<vtkImageData> conInputImage;
+  vtkNew<vtkImageConnectedComponents> connectedComponents;
 
   // Image bounds
   outMin0 = outExt[0];   outMax0 = outExt[1];
   outMin1 = outExt[2];   outMax1 = outExt[3];
   outMin2 = outExt[4];   outMax2 = outExt[5];
 
-  // Computer Parameters for connect().
-  rank = (outExt[5]==outExt[4]) ? 2 : 3;
-  axis_len = new size_t[rank+1];
+  // Compute parameters for connected component labeling.
   axis_len[0] = outExt[1]-outExt[0]+1;
   axis_len[1] = outExt[3]-outExt[2]+1;
   axis_len[2] = outExt[5]-outExt[4]+1;
-  for (j=0; j<rank; j++)
-  {
-    len *= axis_len[j];
-  }
-  conInput = new char[len];
-  conOutput = new size_t[len];
-  numIslands = new size_t[axis_len[2]];
+  conInputImage->SetExtent(0, axis_len[0]-1, 0, axis_len[1]-1, 0, axis_len[2]-1);
+  conInputImage->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  conInput = static_cast<unsigned char*>(conInputImage->GetScalarPointer());
 
   // Get increments to march through data continuously
   outData->GetContinuousIncrements(outExt, outInc0, outInc1, outInc2);
@@ -414,27 +288,15 @@ static void vtkImageConnectivityExecute(vtkImageConnectivity *self,
 
   if (saveIsland || changeIsland || measureIsland || removeIslands || identifyIslands)
     {
-    nz = 1;
-    if (sliceBySlice && removeIslands)
-      {
-      // If SliceBySlice, then call connect() for each slice
-      nxy = axis_len[0] * axis_len[1];
-      nz = axis_len[2];
-      rank = 2;
-      int axis_len2 = axis_len[2];
-      axis_len[2] = 1;
-
-      for (z=0; z < nz; z++)
-        {
-        connect(rank, axis_len, &conInput[nxy*z], inbackground,
-          &conOutput[nxy*z], &numIslands[z]);
-        }
-      axis_len[2] = axis_len2;
-      }
-    else
-      {
-      connect(rank, axis_len, conInput, inbackground, conOutput, &numIslands[0]);
-      }
+    // If SliceBySlice, then label each slice independently.
+    // Labels are unique in the whole volume in both cases.
+    connectedComponents->SetInputData(conInputImage.GetPointer());
+    connectedComponents->SetBackground(bgMask);
+    connectedComponents->SetConnectivity(self->GetConnectivity());
+    connectedComponents->SetSliceBySlice(sliceBySlice && removeIslands);
+    connectedComponents->Update();
+    conOutput = static_cast<int*>(connectedComponents->GetOutput()->GetScalarPointer());
+    numIslands = connectedComponents->GetNumberOfComponents();
     }
 
 
@@ -449,7 +311,7 @@ static void vtkImageConnectivityExecute(vtkImageConnectivity *self,
 
   if (saveIsland || changeIsland || measureIsland)
     {
-    i = seed[2]*axis_len[1]*axis_len[0] + seed[1]*axis_len[0] + seed[0];
+    i = (vtkIdType)seed[2]*axis_len[1]*axis_len[0] + seed[1]*axis_len[0] + seed[0];
     conSeedLabel = conOutput[i];
     }
 
@@ -457,69 +319,16 @@ static void vtkImageConnectivityExecute(vtkImageConnectivity *self,
   ///////////////////////////////////////////////////////////////
   // Measure, Remove
   // -----------------------------
-  // Count size of each island in conOutput
+  // Get size of each island in conOutput
   //
   //   census[c] = COUNT(conOutput[c]),  forall c on [0,numIslands]
   //
+  // Sizes are computed by the connected component labeling.
   ///////////////////////////////////////////////////////////////
 
   if (removeIslands || measureIsland)
     {
-    // For each label value, count the number of pixels with that label
-    // If SliceBySlice, then work on each slice one at a time
-    len = 0;
-    for (z=0; z<nz; z++)
-      {
-      len += numIslands[z] + 1;
-      }
-    census = new int[len];
-    memset(census, 0, len*sizeof(int));
-
-    if (nz == 1)
-      {
-      i = 0;
-      for (outIdx2 = outMin2; outIdx2 <= outMax2; outIdx2++)
-        {
-        for (outIdx1 = outMin1; outIdx1 <= outMax1; outIdx1++)
-          {
-          for (outIdx0 = outMin0; outIdx0 <= outMax0; outIdx0++)
-            {
-            idx = conOutput[i];
-            // Note: Since 'idx' is defined as 'size_t' it's of type 'unsigned'
-            // It means 'idx >= 0' is always true.
-            if (/*idx >= 0 && */idx <= numIslands[0])
-              {
-              census[idx] = census[idx] + 1;
-              }
-            i++;
-            }//for0
-          }//for1
-        }//for2
-      }
-    else
-      {
-      dz = 0;
-      i = 0;
-      for (z=0; z < nz; z++)
-        {
-        for (outIdx1 = outMin1; outIdx1 <= outMax1; outIdx1++)
-          {
-          for (outIdx0 = outMin0; outIdx0 <= outMax0; outIdx0++)
-            {
-            idx = conOutput[i];
-            // Note: Since 'idx' is defined as 'size_t' it's of type 'unsigned'
-            // It means 'idx >= 0' is always true.
-            if (/*idx >= 0 && */idx <= numIslands[z])
-              {
-              census[dz+idx] = census[dz+idx] + 1;
-              }
-            i++;
-            }//for0
-          }//for1
-
-        dz += numIslands[z]+1;
-        }//forz
-      }
+    census = connectedComponents->GetComponentSizes()->GetPointer(0);
     }
 
 
@@ -528,76 +337,41 @@ static void vtkImageConnectivityExecute(vtkImageConnectivity *self,
   // -----------------------------
   // Output gets input except where islands too small
   //
-  //   outData[i] = inData[i],  census[conOutput[i]] >= minIslandSize
+  //   outData[i] = inData[i],  conOutput[i] == 0 (not foreground)
+  //              = inData[i],  census[conOutput[i]] >= minIslandSize
   //              = bg,    else
   //
   ///////////////////////////////////////////////////////////////
 
   if (removeIslands)
     {
-    if (nz == 1)
+    inPtr0 = inPtr;
+    outPtr0 = outPtr;
+    i = 0;
+    for (outIdx2 = outMin2; outIdx2 <= outMax2; outIdx2++)
       {
-      inPtr0 = inPtr;
-      outPtr0 = outPtr;
-      i = 0;
-      for (outIdx2 = outMin2; outIdx2 <= outMax2; outIdx2++)
+      for (outIdx1 = outMin1; outIdx1 <= outMax1; outIdx1++)
         {
-        for (outIdx1 = outMin1; outIdx1 <= outMax1; outIdx1++)
+        for (outIdx0 = outMin0; outIdx0 <= outMax0; outIdx0++)
           {
-          for (outIdx0 = outMin0; outIdx0 <= outMax0; outIdx0++)
+          if (conOutput[i] == 0 || census[conOutput[i]] >= minSize)
             {
-            if (census[conOutput[i]] >= minSize)
-              {
-              *outPtr0 = *inPtr0;
-              }
-            else
-              {
-              *outPtr0 = bg;
-              }
-            i++;
-            outPtr0++;
-            inPtr0++;
-            }//for0
-          outPtr0 += outInc1;
-          inPtr0 += inInc1;
-          }//for1
-        outPtr0 += outInc2;
-        inPtr0 += inInc2;
-        }//for2
-      }
-    else
-      {
-      dz = 0;
-      i = 0;
-      inPtr0 = inPtr;
-      outPtr0 = outPtr;
-      for (z=0; z < nz; z++)
-        {
-        for (outIdx1 = outMin1; outIdx1 <= outMax1; outIdx1++)
-          {
-          for (outIdx0 = outMin0; outIdx0 <= outMax0; outIdx0++)
+            *outPtr0 = *inPtr0;
+            }
+          else
             {
-            if (census[dz+conOutput[i]] >= minSize)
-              {
-              *outPtr0 = *inPtr0;
-              }
-            else
-              {
-              *outPtr0 = bg;
-              }
-            i++;
-            outPtr0++;
-            inPtr0++;
-            }//for0
-          outPtr0 += outInc1;
-          inPtr0 += inInc1;
-          }//for1
-        outPtr0 += outInc2;
-        inPtr0 += inInc2;
-
-        dz += numIslands[z] + 1;
-        }//z
-      }//else
+            *outPtr0 = bg;
+            }
+          i++;
+          outPtr0++;
+          inPtr0++;
+          }//for0
+        outPtr0 += outInc1;
+        inPtr0 += inInc1;
+        }//for1
+      outPtr0 += outInc2;
+      inPtr0 += inInc2;
+      }//for2
     }
 
 
@@ -616,20 +390,17 @@ static void vtkImageConnectivityExecute(vtkImageConnectivity *self,
     {
     // Find largest island
     largest = 0;
-    for (i=0; i<=numIslands[0]; i++)
+    for (i=1; i<=numIslands; i++)
       {
-      if (i != bg)
+      if (census[i] > largest)
         {
-        if (census[i] > largest)
-          {
-          largest = census[i];
-          }
+        largest = census[i];
         }
       }
-    self->SetLargestIslandSize(largest);
+    self->SetLargestIslandSize(static_cast<int>(largest));
 
     // Measure island at seed
-    self->SetIslandSize(census[conSeedLabel]);
+    self->SetIslandSize(static_cast<int>(census[conSeedLabel]));
 
     // Return output values to be the inputs
     inPtr0 = inPtr;
@@ -721,12 +492,6 @@ static void vtkImageConnectivityExecute(vtkImageConnectivity *self,
       }
     }
 
-  if (removeIslands || measureIsland)
-    {
-    delete [] census;
-    }
-
-
   ///////////////////////////////////////////////////////////////
   // Save
   // -----------------------------
@@ -814,10 +579,7 @@ static void vtkImageConnectivityExecute(vtkImageConnectivity *self,
   // Cleanup
   ///////////////////////////////////////////////////////////////
 
-  delete [] axis_len;
-  delete [] numIslands;
-  delete [] conInput;
-  delete [] conOutput;
+  // Image buffers are released by conInputImage and connectedComponents
 }
 
 
@@ -859,6 +621,22 @@ void vtkImageConnectivity::ExecuteDataWithInformation(vtkDataObject *output, vtk
     outData, (short *)(outPtr), outExt);
 }
 
+//----------------------------------------------------------------------------
+void vtkImageConnectivity::SetConnectivity(int connectivity)
+{
+  if (connectivity != 6 && connectivity != 18 && connectivity != 26)
+    {
+    vtkErrorMacro("SetConnectivity: invalid connectivity " << connectivity << ", it must be 6, 18, or 26");
+    return;
+    }
+  if (this->Connectivity == connectivity)
+    {
+    return;
+    }
+  this->Connectivity = connectivity;
+  this->Modified();
+}
+
 //----------------------------------------------------------------------------
 void vtkImageConnectivity::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -875,4 +653,5 @@ void vtkImageConnectivity::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Seed[1]:           " << this->Seed[1] << "\n";
   os << indent << "Seed[2]:           " << this->Seed[2] << "\n";
   os << indent << "Function:          " << this->Function << "\n";
+  os << indent << "Connectivity:      " << this->Connectivity << "\n";
 }
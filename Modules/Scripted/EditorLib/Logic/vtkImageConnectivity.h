@@ -9,6 +9,11 @@
 ///  vtkImageConnectivity - Identify and process islands of similar pixels
 ///
 ///  The input data type must be shorts.
+///
+///  RemoveIslands sets voxels of islands smaller than MinSize to Background.
+///  Voxels that are not foreground (equal to Background or outside of
+///  [MinForeground, MaxForeground]) are never part of an island and they are
+///  copied from the input unchanged.
 /// .SECTION Warning
 /// You need to explicitely call Update
 
@@ -61,6 +66,12 @@ public:
   vtkSetMacro(SliceBySlice, int);
   vtkBooleanMacro(SliceBySlice, int);
 
+  /// Neighborhood used for determining connectivity: 6, 18, or 26.
+  /// Default is 6 (face-connected voxels).
+  /// Other values are rejected with an error and the connectivity is not changed.
+  vtkGetMacro(Connectivity, int);
+  void SetConnectivity(int connectivity);
+
   vtkSetVector3Macro(Seed, int);
   vtkGetVector3Macro(Seed, int);
 
@@ -89,6 +100,7 @@ protected:
   int Seed[3];
   int Function;
   int SliceBySlice;
+  int Connectivity;
 
   void ExecuteDataWithInformation(vtkDataObject *, vtkInformation *);
 
@@ -156,7 +156,10 @@ class SegmentStatisticsLogic(ScriptedLoadableModuleLogic):
     self.keys = ("Segment",
       "LM voxel count", "LM volume mm3", "LM volume cc",
       "GS voxel count", "GS volume mm3", "GS volume cc", "GS min", "GS max", "GS mean", "GS stdev",
+      "GS 5th percentile", "GS median", "GS 95th percentile",
       "CS surface mm2", "CS volume mm3", "CS volume cc")
+    # Percentiles of grayscale intensities, as (key, percentile) pairs
+    self.grayscalePercentiles = (("GS 5th percentile", 5.0), ("GS median", 50.0), ("GS 95th percentile", 95.0))
     self.notAvailableValueString = ""
     self.reset()
 
@@ -200,38 +203,18 @@ class SegmentStatisticsLogic(ScriptedLoadableModuleLogic):
     if not containsLabelmapRepresentation:
       return
 
-    for segmentID in self.statistics["SegmentIDs"]:
-      segment = self.segmentationNode.GetSegmentation().GetSegment(segmentID)
-      segmentLabelmap = segment.GetRepresentation(vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName())
-
-      # We need to know exactly the value of the segment voxels, apply threshold to make force the selected label value
-      labelValue = 1
-      backgroundValue = 0
-      thresh = vtk.vtkImageThreshold()
-      thresh.SetInputData(segmentLabelmap)
-      thresh.ThresholdByLower(0)
-      thresh.SetInValue(backgroundValue)
-      thresh.SetOutValue(labelValue)
-      thresh.SetOutputScalarType(vtk.VTK_UNSIGNED_CHAR)
-      thresh.Update()
-
-      #  Use binary labelmap as a stencil
-      stencil = vtk.vtkImageToImageStencil()
-      stencil.SetInputData(thresh.GetOutput())
-      stencil.ThresholdByUpper(labelValue)
-      stencil.Update()
-
-      stat = vtk.vtkImageAccumulate()
-      stat.SetInputData(thresh.GetOutput())
-      stat.SetStencilData(stencil.GetOutput())
-      stat.Update()
+    # Compute statistics of all segments in one pass, in the geometry of the segment labelmaps
+    calculator = self.computeSegmentStatistics(None)
+    if calculator is None:
+      return
 
-      # Add data to statistics list
-      cubicMMPerVoxel = reduce(lambda x,y: x*y, segmentLabelmap.GetSpacing())
-      ccPerCubicMM = 0.001
-      self.statistics[segmentID,"LM voxel count"] = stat.GetVoxelCount()
-      self.statistics[segmentID,"LM volume mm3"] = stat.GetVoxelCount() * cubicMMPerVoxel
-      self.statistics[segmentID,"LM volume cc"] = stat.GetVoxelCount() * cubicMMPerVoxel * ccPerCubicMM
+    # Add data to statistics list
+    ccPerCubicMM = 0.001
+    for segmentIndex, segmentID in enumerate(self.statistics["SegmentIDs"]):
+      voxelCount = self.getVoxelCount(calculator, segmentIndex)
+      self.statistics[segmentID,"LM voxel count"] = voxelCount
+      self.statistics[segmentID,"LM volume mm3"] = calculator.GetVolumeMm3(segmentIndex)
+      self.statistics[segmentID,"LM volume cc"] = calculator.GetVolumeMm3(segmentIndex) * ccPerCubicMM
 
   def addSegmentClosedSurfaceStatistics(self):
     import vtkSegmentationCorePython as vtkSegmentationCore
@@ -266,63 +249,45 @@ class SegmentStatisticsLogic(ScriptedLoadableModuleLogic):
     if self.grayscaleNode is None or self.grayscaleNode.GetImageData() is None:
       return
 
-    # Get geometry of grayscale volume node as oriented image data
-    referenceGeometry_Reference = vtkSegmentationCore.vtkOrientedImageData() # reference geometry in reference node coordinate system
-    referenceGeometry_Reference.SetExtent(self.grayscaleNode.GetImageData().GetExtent())
-    ijkToRasMatrix = vtk.vtkMatrix4x4()
-    self.grayscaleNode.GetIJKToRASMatrix(ijkToRasMatrix)
-    referenceGeometry_Reference.SetGeometryFromImageToWorldMatrix(ijkToRasMatrix)
-
-    # Get transform between grayscale volume and segmentation
-    segmentationToReferenceGeometryTransform = vtk.vtkGeneralTransform()
-    slicer.vtkMRMLTransformNode.GetTransformBetweenNodes(self.segmentationNode.GetParentTransformNode(),
-      self.grayscaleNode.GetParentTransformNode(), segmentationToReferenceGeometryTransform)
+    # Compute statistics of all segments in one pass over the grayscale volume.
+    # Segments are resampled to the grayscale volume geometry if needed.
+    calculator = self.computeSegmentStatistics(self.grayscaleNode)
+    if calculator is None:
+      return
 
-    cubicMMPerVoxel = reduce(lambda x,y: x*y, referenceGeometry_Reference.GetSpacing())
+    # Add data to statistics list
     ccPerCubicMM = 0.001
-
+    for segmentIndex, segmentID in enumerate(self.statistics["SegmentIDs"]):
+      voxelCount = self.getVoxelCount(calculator, segmentIndex)
+      self.statistics[segmentID,"GS voxel count"] = voxelCount
+      self.statistics[segmentID,"GS volume mm3"] = calculator.GetVolumeMm3(segmentIndex)
+      self.statistics[segmentID,"GS volume cc"] = calculator.GetVolumeMm3(segmentIndex) * ccPerCubicMM
+      if voxelCount>0:
+        self.statistics[segmentID,"GS min"] = calculator.GetMinimum(segmentIndex)
+        self.statistics[segmentID,"GS max"] = calculator.GetMaximum(segmentIndex)
+        self.statistics[segmentID,"GS mean"] = calculator.GetMean(segmentIndex)
+        self.statistics[segmentID,"GS stdev"] = calculator.GetStandardDeviation(segmentIndex)
+        for key, percentile in self.grayscalePercentiles:
+          self.statistics[segmentID,key] = calculator.GetPercentile(segmentIndex, percentile)
+
+  def computeSegmentStatistics(self, referenceVolumeNode):
+    """Compute statistics of all segments in self.statistics["SegmentIDs"].
+    Returns the calculator containing the results, or None if the computation failed.
+    """
+    segmentIds = vtk.vtkStringArray()
     for segmentID in self.statistics["SegmentIDs"]:
-      segment = self.segmentationNode.GetSegmentation().GetSegment(segmentID)
-      segmentLabelmap = segment.GetRepresentation(vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName())
-
-      segmentLabelmap_Reference = vtkSegmentationCore.vtkOrientedImageData()
-      vtkSegmentationCore.vtkOrientedImageDataResample.ResampleOrientedImageToReferenceOrientedImage(
-        segmentLabelmap, referenceGeometry_Reference, segmentLabelmap_Reference,
-        False, # nearest neighbor interpolation
-        False, # no padding
-        segmentationToReferenceGeometryTransform)
-
-      # We need to know exactly the value of the segment voxels, apply threshold to make force the selected label value
-      labelValue = 1
-      backgroundValue = 0
-      thresh = vtk.vtkImageThreshold()
-      thresh.SetInputData(segmentLabelmap_Reference)
-      thresh.ThresholdByLower(0)
-      thresh.SetInValue(backgroundValue)
-      thresh.SetOutValue(labelValue)
-      thresh.SetOutputScalarType(vtk.VTK_UNSIGNED_CHAR)
-      thresh.Update()
-
-      #  Use binary labelmap as a stencil
-      stencil = vtk.vtkImageToImageStencil()
-      stencil.SetInputData(thresh.GetOutput())
-      stencil.ThresholdByUpper(labelValue)
-      stencil.Update()
-
-      stat = vtk.vtkImageAccumulate()
-      stat.SetInputData(self.grayscaleNode.GetImageData())
-      stat.SetStencilData(stencil.GetOutput())
-      stat.Update()
-
-      # Add data to statistics list
-      self.statistics[segmentID,"GS voxel count"] = stat.GetVoxelCount()
-      self.statistics[segmentID,"GS volume mm3"] = stat.GetVoxelCount() * cubicMMPerVoxel
-      self.statistics[segmentID,"GS volume cc"] = stat.GetVoxelCount() * cubicMMPerVoxel * ccPerCubicMM
-      if stat.GetVoxelCount()>0:
-        self.statistics[segmentID,"GS min"] = stat.GetMin()[0]
-        self.statistics[segmentID,"GS max"] = stat.GetMax()[0]
-        self.statistics[segmentID,"GS mean"] = stat.GetMean()[0]
-        self.statistics[segmentID,"GS stdev"] = stat.GetStandardDeviation()[0]
+      segmentIds.InsertNextValue(segmentID)
+    calculator = slicer.vtkSegmentStatisticsCalculator()
+    if not slicer.vtkSlicerSegmentationsModuleLogic.ComputeSegmentStatistics(
+      self.segmentationNode, segmentIds, referenceVolumeNode, calculator):
+      logging.error("Failed to compute segment statistics")
+      return None
+    return calculator
+
+  def getVoxelCount(self, calculator, segmentIndex):
+    """Voxel count is a weighted sum for fractional labelmaps, show it as integer if possible"""
+    voxelCount = calculator.GetVoxelCount(segmentIndex)
+    return int(voxelCount) if voxelCount.is_integer() else voxelCount
 
   def getStatisticsValueAsString(self, segmentID, key):
     if self.statistics.has_key((segmentID, key)):